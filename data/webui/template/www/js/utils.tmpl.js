@@ -51,3 +51,51 @@ function mountAllButton() {
 }
 {% endif %}
 
+
+{% if components.host_copy %}
+function copyShow(s) {
+	var state = document.getElementById("copy-state");
+	var detail = document.getElementById("copy-detail");
+	if (state === null || detail === null)
+		return;
+
+	state.innerText = s.state.charAt(0).toUpperCase() + s.state.slice(1);
+	if (s.state == "idle") {
+		detail.innerText = "";
+		return;
+	}
+
+	var text = s.source + " → " + s.destination + " :: " + s.copied.toLocaleString();
+	if (s.total)
+		text += " of " + s.total.toLocaleString();
+	text += " bytes";
+	if (s.percent >= 0)
+		text += " (" + s.percent + "%)";
+	if (s.rate)
+		text += ", " + s.rate + " KB/s";
+	detail.innerText = text;
+}
+
+function copyPoll() {
+	var xobj = new XMLHttpRequest();
+	xobj.onload = function() {
+		var s = JSON.parse(xobj.responseText);
+		copyShow(s);
+		setTimeout(copyPoll, s.state == "copying" ? 1000 : 5000);
+	};
+	xobj.open("GET", "/copy", true);
+	xobj.send();
+}
+
+function copyAction(action) {
+	var xobj = new XMLHttpRequest();
+	xobj.onload = function() {
+		copyShow(JSON.parse(xobj.responseText));
+	};
+	xobj.open("GET", "/copy?action=" + action, true);
+	xobj.send();
+	return false;
+}
+
+window.addEventListener("load", copyPoll);
+{% endif %}
@@ -165,6 +165,7 @@ set(SOURCES src/main.cpp
     lib/hardware/fnUARTUnix.cpp lib/hardware/fnUARTWindows.cpp
     lib/hardware/fnSystem.h lib/hardware/fnSystem.cpp lib/hardware/fnSystemNet.cpp
     lib/FileSystem/fnDirCache.h lib/FileSystem/fnDirCache.cpp
+    lib/FileSystem/fnDirStream.h lib/FileSystem/fnDirStream.cpp
     lib/FileSystem/fnFS.h lib/FileSystem/fnFS.cpp
     lib/FileSystem/fnFsSPIFFS.h lib/FileSystem/fnFsSPIFFS.cpp
     lib/FileSystem/fnFsSD.h lib/FileSystem/fnFsSD.cpp
@@ -175,6 +176,7 @@ set(SOURCES src/main.cpp
     lib/FileSystem/fnFileLocal.h lib/FileSystem/fnFileLocal.cpp
     lib/FileSystem/fnFileTNFS.h lib/FileSystem/fnFileTNFS.cpp
     lib/FileSystem/fnFileSMB.h lib/FileSystem/fnFileSMB.cpp
+    lib/FileSystem/fnFileFTP.h lib/FileSystem/fnFileFTP.cpp
     lib/FileSystem/fnFileMem.h lib/FileSystem/fnFileMem.cpp
     lib/FileSystem/fnio.h lib/FileSystem/fnio.cpp
     lib/tcpip/fnDNS.h lib/tcpip/fnDNS.cpp
@@ -213,6 +215,7 @@ set(SOURCES src/main.cpp
     lib/printer-emulator/pdf_printer.h lib/printer-emulator/pdf_printer.cpp
     lib/printer-emulator/png_printer.h lib/printer-emulator/png_printer.cpp
     lib/printer-emulator/printer_emulator.h lib/printer-emulator/printer_emulator.cpp
+    lib/printer-emulator/printer_spool.h lib/printer-emulator/printer_spool.cpp
     lib/printer-emulator/svg_plotter.h lib/printer-emulator/svg_plotter.cpp
     lib/network-protocol/NetworkProtocolFactory.h
     lib/network-protocol/network_data.h
@@ -233,6 +236,10 @@ set(SOURCES src/main.cpp
     lib/fuji/fujiCmd.h
     lib/fuji/fujiHost.h lib/fuji/fujiHost.cpp
     lib/fuji/fujiDisk.h lib/fuji/fujiDisk.cpp
+    lib/fuji/fujiHostCopy.h lib/fuji/fujiHostCopy.cpp
+    lib/fuji/fujiHostHash.h lib/fuji/fujiHostHash.cpp
+    lib/fuji/fujiDirBlock.h lib/fuji/fujiDirBlock.cpp
+    lib/fuji/fujiMountAll.h lib/fuji/fujiMountAll.cpp
     lib/bus/bus.h
     lib/device/device.h
     lib/device/disk.h
@@ -245,6 +252,8 @@ set(SOURCES src/main.cpp
     lib/device/siocpm.h
     lib/modem-sniffer/modem-sniffer.h lib/modem-sniffer/modem-sniffer.cpp
     lib/media/media.h
+    lib/media/mediaCache.h lib/media/mediaCache.cpp
+    lib/media/mediaPrefetch.h lib/media/mediaPrefetch.cpp
     lib/encoding/base64.h lib/encoding/base64.cpp
     lib/encoding/hash.h lib/encoding/hash.cpp
     lib/encrypt/crypt.h lib/encrypt/crypt.cpp
@@ -269,6 +278,7 @@ if(FUJINET_TARGET STREQUAL "ATARI")
     lib/device/sio/printer.h lib/device/sio/printer.cpp
     lib/device/sio/printerlist.h lib/device/sio/printerlist.cpp
     lib/device/sio/cassette.h lib/device/sio/cassette.cpp
+    lib/device/sio/cassetteDecode.h lib/device/sio/cassetteDecode.cpp
     lib/device/sio/fuji.h lib/device/sio/fuji.cpp
     lib/device/sio/network.h lib/device/sio/network.cpp
     lib/device/sio/udpstream.h lib/device/sio/udpstream.cpp
@@ -276,6 +286,7 @@ if(FUJINET_TARGET STREQUAL "ATARI")
     lib/device/sio/apetime.h lib/device/sio/apetime.cpp
     lib/device/sio/siocpm.h lib/device/sio/siocpm.cpp
     lib/device/sio/pclink.h lib/device/sio/pclink.cpp
+    lib/device/sio/pclink_dir.h lib/device/sio/pclink_dir.cpp
     lib/device/sio/modem.h lib/device/sio/modem.cpp
 
     )
@@ -289,16 +300,20 @@ if(FUJINET_TARGET STREQUAL "APPLE")
     lib/bus/iwm/iwm.h lib/bus/iwm/iwm.cpp
 
     lib/devrelay/util.h lib/devrelay/util.cpp
+    lib/devrelay/types/Command.h lib/devrelay/types/Command.cpp
     lib/devrelay/types/Request.h lib/devrelay/types/Request.cpp
     lib/devrelay/types/Response.h lib/devrelay/types/Response.cpp
     lib/devrelay/service/Listener.h lib/devrelay/service/Listener.cpp
     lib/devrelay/service/Connection.h lib/devrelay/service/Connection.cpp
+    lib/devrelay/service/FrameRing.h
     lib/devrelay/service/Requestor.h lib/devrelay/service/Requestor.cpp
     lib/devrelay/slip/SLIP.h lib/devrelay/slip/SLIP.cpp
     lib/devrelay/commands/Control.h lib/devrelay/commands/Control.cpp
     lib/devrelay/commands/WriteBlock.h lib/devrelay/commands/WriteBlock.cpp
+    lib/devrelay/commands/WriteBlocks.h lib/devrelay/commands/WriteBlocks.cpp
     lib/devrelay/commands/Close.h lib/devrelay/commands/Close.cpp
     lib/devrelay/commands/ReadBlock.h lib/devrelay/commands/ReadBlock.cpp
+    lib/devrelay/commands/ReadBlocks.h lib/devrelay/commands/ReadBlocks.cpp
     lib/devrelay/commands/Read.h lib/devrelay/commands/Read.cpp
     lib/devrelay/commands/Reset.h lib/devrelay/commands/Reset.cpp
     lib/devrelay/commands/Open.h lib/devrelay/commands/Open.cpp
@@ -310,6 +325,7 @@ if(FUJINET_TARGET STREQUAL "APPLE")
     lib/media/apple/mediaType.h lib/media/apple/mediaType.cpp
     lib/media/apple/mediaTypeDO.h lib/media/apple/mediaTypeDO.cpp
     lib/media/apple/mediaTypeDSK.h lib/media/apple/mediaTypeDSK.cpp
+    lib/media/apple/dskNibble.h lib/media/apple/dskNibble.cpp
     lib/media/apple/mediaTypePO.h lib/media/apple/mediaTypePO.cpp
     lib/media/apple/mediaTypeWOZ.h lib/media/apple/mediaTypeWOZ.cpp
 
@@ -473,6 +489,130 @@ add_custom_target(build_version DEPENDS "${CMAKE_BINARY_DIR}/include/build_versi
 add_dependencies(fujinet build_version)
 target_include_directories(fujinet PRIVATE "${CMAKE_BINARY_DIR}/include")
 
+# RunCPM Z80 benchmark, not built by default
+# "runcpm-bench" uses computed goto dispatch, "runcpm-bench-switch" the switch
+find_package(Curses)
+if(CURSES_FOUND AND NOT CMAKE_SYSTEM_NAME STREQUAL "Windows")
+    foreach(BENCH runcpm-bench runcpm-bench-switch)
+        add_executable(${BENCH} EXCLUDE_FROM_ALL tools/runcpm_bench/runcpm_bench.cpp)
+        target_include_directories(${BENCH} PRIVATE tools/runcpm_bench lib/runcpm ${CURSES_INCLUDE_DIRS})
+        target_compile_definitions(${BENCH} PRIVATE Z80_COUNT)
+        # no platform, so cpm.h doesn't reach for the bus
+        target_compile_options(${BENCH} PRIVATE -O2 -w -U${FUJINET_BUILD_PLATFORM})
+        target_link_libraries(${BENCH} ${CURSES_LIBRARIES})
+    endforeach()
+    target_compile_definitions(runcpm-bench-switch PRIVATE Z80_SWITCH)
+endif()
+# Console output throughput and idle CPU of lib/runcpm/console_buffer.h
+if(NOT CMAKE_SYSTEM_NAME STREQUAL "Windows")
+    add_executable(runcpm-console-bench EXCLUDE_FROM_ALL tools/runcpm_bench/console_bench.cpp)
+    target_include_directories(runcpm-console-bench PRIVATE lib/runcpm)
+    target_compile_options(runcpm-console-bench PRIVATE -O2 -w)
+    target_link_libraries(runcpm-console-bench pthread)
+endif()
+# SmartPort over SLIP block throughput, both ends of the link over loopback
+if(FUJINET_TARGET STREQUAL "APPLE" AND SLIP_PROTOCOL STREQUAL "NET" AND NOT CMAKE_SYSTEM_NAME STREQUAL "Windows")
+    add_executable(smartport-slip-bench EXCLUDE_FROM_ALL
+        tools/smartport_bench/slip_bench.cpp
+        lib/media/mediaCache.cpp lib/media/mediaPrefetch.cpp
+        lib/task/fnTask.cpp lib/task/fnTaskManager.cpp
+        lib/devrelay/slip/SLIP.cpp
+        lib/devrelay/service/Connection.cpp lib/devrelay/service/TCPConnection.cpp
+        lib/devrelay/service/Listener.cpp lib/devrelay/service/Requestor.cpp
+        lib/devrelay/types/Command.cpp lib/devrelay/types/Request.cpp lib/devrelay/types/Response.cpp
+        lib/devrelay/commands/Close.cpp lib/devrelay/commands/Control.cpp
+        lib/devrelay/commands/Format.cpp lib/devrelay/commands/Init.cpp
+        lib/devrelay/commands/Open.cpp lib/devrelay/commands/Read.cpp
+        lib/devrelay/commands/ReadBlock.cpp lib/devrelay/commands/ReadBlocks.cpp
+        lib/devrelay/commands/Reset.cpp lib/devrelay/commands/Status.cpp
+        lib/devrelay/commands/Write.cpp lib/devrelay/commands/WriteBlock.cpp
+        lib/devrelay/commands/WriteBlocks.cpp
+    )
+    # its own fnSystem.h, and no platform so fnio is stdio
+    target_include_directories(smartport-slip-bench PRIVATE tools/smartport_bench include lib/FileSystem lib/media lib/task
+        lib/devrelay/commands lib/devrelay/service lib/devrelay/slip lib/devrelay/types)
+    target_compile_options(smartport-slip-bench PRIVATE -O2 -U${FUJINET_BUILD_PLATFORM} -UDBUG2)
+    target_link_libraries(smartport-slip-bench pthread)
+endif()
+# DriveWire sectors a second through BeckerPort, a CoCo emulator stand-in over loopback
+if(FUJINET_TARGET STREQUAL "COCO" AND NOT CMAKE_SYSTEM_NAME STREQUAL "Windows")
+    add_executable(drivewire-becker-bench EXCLUDE_FROM_ALL
+        tools/drivewire_bench/becker_bench.cpp
+        lib/bus/drivewire/dwcom/dwbecker.cpp
+        lib/media/mediaCache.cpp lib/media/mediaPrefetch.cpp
+        lib/task/fnTask.cpp lib/task/fnTaskManager.cpp
+        lib/compat/compat_inet.c
+    )
+    if(NOT CMAKE_SYSTEM_NAME STREQUAL "Darwin")
+        target_sources(drivewire-becker-bench PRIVATE lib/compat/strlcpy.c)
+    endif()
+    # its own fnSystem.h and fnWiFi.h, and fnio is stdio
+    target_include_directories(drivewire-becker-bench PRIVATE tools/drivewire_bench include lib/compat lib/tcpip
+        lib/FileSystem lib/media lib/task lib/bus/drivewire/dwcom)
+    target_compile_definitions(drivewire-becker-bench PRIVATE FNIO_IS_STDIO)
+    target_compile_options(drivewire-becker-bench PRIVATE -O2 -UDBUG2)
+    target_link_libraries(drivewire-becker-bench pthread)
+endif()
+
+# Unit tests that don't need the ESP32, not built by default
+# cmake --build . --target fujinet-tests && ctest
+enable_testing()
+add_executable(fujinet-tests EXCLUDE_FROM_ALL
+    test/main_host.cpp
+    components_pc/cJSON/tests/unity/src/unity.c
+    test/fnsystem_host.cpp
+    test/test_hash.cpp
+    lib/encoding/hash.cpp
+    test/test_dsknibble.cpp
+    lib/media/apple/dskNibble.cpp
+    test/test_macgcr.cpp
+    lib/media/mac/macGCR.cpp
+    test/test_spcodec.cpp
+    lib/bus/iwm/iwm_sp_codec.cpp
+    test/test_sam.cpp
+    lib/sam/sam.c
+    lib/sam/reciter.c
+    lib/sam/render.c
+    lib/sam/samdebug.c
+    test/test_base64.cpp
+    lib/encoding/base64.cpp
+    lib/FileSystem/fnFile.cpp
+    lib/FileSystem/fnio.cpp
+    lib/FileSystem/fnFileMem.cpp
+    test/test_filemem.cpp
+    test/test_ftp_file.cpp
+    lib/FileSystem/fnFileFTP.cpp
+    lib/ftp/fnFTP.cpp
+    lib/tcpip/fnTcpClient.cpp
+    lib/tcpip/fnTcpServer.cpp
+    lib/tcpip/fnDNS.cpp
+    lib/compat/compat_inet.c
+    test/test_mediacache.cpp
+    lib/media/mediaCache.cpp
+    test/test_smb_file.cpp
+    lib/FileSystem/fnFileSMB.cpp
+    test/test_dirstream.cpp
+    lib/FileSystem/fnDirStream.cpp
+    lib/task/fnTask.cpp
+    lib/task/fnTaskManager.cpp
+    lib/compat/strlcpy.c
+)
+# the tape decoder is the Atari's, main_host.cpp runs its tests in an Atari build
+if(FUJINET_TARGET STREQUAL "ATARI")
+    target_sources(fujinet-tests PRIVATE
+        test/test_cassette_wav.cpp
+        lib/device/sio/cassetteDecode.cpp
+    )
+endif()
+# the renderer is Atari only, the prompts it is checked against are in the source tree
+set_source_files_properties(lib/sam/render.c PROPERTIES COMPILE_DEFINITIONS BUILD_ATARI)
+target_include_directories(fujinet-tests PRIVATE components_pc/cJSON/tests/unity/src include lib/compat lib/hardware lib/FileSystem lib/task lib/ftp lib/tcpip components_pc/libsmb2/include ${MBEDTLS_INCLUDE_DIR})
+# UNIT_TESTS keeps debug.h quiet, so the code under test doesn't need utils.cpp for its messages
+target_compile_definitions(fujinet-tests PRIVATE UNIT_TESTS
+    SAM_PROMPT_DIR="${CMAKE_CURRENT_SOURCE_DIR}/data/webui/device_specific/BUILD_ATARI")
+target_link_libraries(fujinet-tests smb2 ${CRYPTO_LIBS})
+add_test(NAME fujinet-tests COMMAND fujinet-tests)
+
 # WebUI
 # "build_webui" target
 add_custom_command(
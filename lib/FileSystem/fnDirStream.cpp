@@ -0,0 +1,257 @@
+
+#include "fnDirStream.h"
+
+#include <cstring>
+#include "compat_string.h"
+
+#include "fnSystem.h"
+#include "fnTaskManager.h"
+
+#include "../../include/debug.h"
+
+
+DirListing::DirListing(const char *path, const char *pattern, uint16_t diropts, time_t mtime)
+    : _path(path == nullptr ? "" : path), _pattern(pattern == nullptr ? "" : pattern),
+      _diropts(diropts), _mtime(mtime)
+{
+}
+
+bool DirListing::matches(const char *path, const char *pattern, uint16_t diropts, time_t mtime)
+{
+    return cacheable() && mtime == _mtime && diropts == _diropts &&
+           _path == (path == nullptr ? "" : path) &&
+           _pattern == (pattern == nullptr ? "" : pattern);
+}
+
+void DirListing::add(const char *filename, bool isDir, uint32_t size, time_t modified_time)
+{
+    item i;
+    i.name = _names.size();
+    i.size = size;
+    i.modified_time = modified_time;
+    i.isDir = isDir;
+    _items.push_back(i);
+    _names.insert(_names.end(), filename, filename + strlen(filename) + 1);
+}
+
+// Returns TRUE if an error condition occurred
+bool DirListing::get(uint16_t index, fsdir_entry *entry)
+{
+    if (index >= _items.size())
+        return true;
+
+    item &i = _items[index];
+    strlcpy(entry->filename, &_names[i.name], sizeof(entry->filename));
+    entry->isDir = i.isDir;
+    entry->size = i.size;
+    entry->modified_time = i.modified_time;
+    return false;
+}
+
+
+std::shared_ptr<DirListing> DirListingCache::find(const char *path, const char *pattern, uint16_t diropts, time_t mtime)
+{
+    for (auto it = _listings.begin(); it != _listings.end(); ++it)
+    {
+        if ((*it)->matches(path, pattern, diropts, mtime))
+        {
+            std::shared_ptr<DirListing> found = *it;
+            _listings.erase(it);
+            _listings.insert(_listings.begin(), found);
+            Debug_printf("DirListingCache::find - \"%s\" cached, %u entries\n", path, found->count());
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+void DirListingCache::store(std::shared_ptr<DirListing> listing)
+{
+    if (_max_entries == 0)
+        _max_entries = fnSystem.get_psram_size() > 0 ? DIRLISTING_CACHE_ENTRIES : DIRLISTING_CACHE_ENTRIES_NO_PSRAM;
+
+    if (!listing->complete || !listing->cacheable() || listing->count() > _max_entries)
+        return;
+
+    _listings.insert(_listings.begin(), listing);
+
+    size_t entries = 0;
+    for (size_t i = 0; i < _listings.size(); i++)
+    {
+        entries += _listings[i]->count();
+        if (i >= DIRLISTING_CACHE_LISTINGS || entries > _max_entries)
+        {
+            _listings.resize(i);
+            break;
+        }
+    }
+}
+
+
+/*
+ * Fetches the rest of a listing under taskMgr, a page each time it is serviced
+ */
+class DirStreamTask : public fnTask
+{
+public:
+    DirStreamTask(DirStream *stream) : _stream(stream) {};
+    virtual ~DirStreamTask() override
+    {
+        _stream->_task = nullptr;
+        // nobody reading, it is in the cache if it is going to be kept
+        if (!_stream->_open)
+            _stream->_listing.reset();
+    };
+
+protected:
+    DirStream *_stream;
+
+    virtual int start() override { return 0; };
+    virtual int step() override
+    {
+        if (_stream->fetch_next())
+            return -1;
+        return _stream->_listing->complete ? 1 : 0;
+    };
+};
+
+
+DirStream::~DirStream()
+{
+    stop();
+}
+
+// Returns TRUE if an error condition occurred
+bool DirStream::start(std::shared_ptr<DirListing> listing)
+{
+    stop();
+
+    _listing = listing;
+    _current = 0;
+    _failed = false;
+
+    // the first page now, so there is something to show
+    if (fetch_next())
+    {
+        _listing.reset();
+        return true;
+    }
+    _open = true;
+    return false;
+}
+
+bool DirStream::resume(const char *path, const char *pattern, uint16_t diropts, time_t mtime)
+{
+    if (_listing == nullptr || _failed || !_listing->matches(path, pattern, diropts, mtime))
+        return false;
+
+    Debug_printf("DirStream::resume - \"%s\", %u entries so far\n", path, _listing->count());
+    _current = 0;
+    _open = true;
+    return true;
+}
+
+void DirStream::prefetch()
+{
+    if (_listing == nullptr || _listing->complete || _failed || _task != nullptr)
+        return;
+
+    _task = new DirStreamTask(this);
+    _task_id = taskMgr.submit_task(_task);
+    if (_task_id == 0)
+    {
+        delete _task;
+        _task = nullptr;
+    }
+}
+
+void DirStream::close()
+{
+    _open = false;
+    _current = 0;
+
+    if (_task == nullptr)
+        stop();
+}
+
+void DirStream::stop()
+{
+    // before the task goes, a closed stream's task takes the listing with it
+    if (_listing != nullptr && !_listing->complete && !_failed)
+        finish();
+
+    if (_task != nullptr)
+        taskMgr.abort_task(_task_id);
+
+    _listing.reset();
+    _open = false;
+    _current = 0;
+}
+
+// fetch one more page, and let the host go once there are no more
+// Returns TRUE if an error condition occurred
+bool DirStream::fetch_next()
+{
+    if (_failed)
+        return true;
+    if (_listing->complete)
+        return false;
+
+    if (fetch_page())
+    {
+        Debug_printf("DirStream::fetch_next - failed after %u entries\n", _listing->count());
+        _failed = true;
+        finish();
+        return true;
+    }
+
+    if (_listing->complete)
+    {
+        finish();
+        if (_cache != nullptr)
+            _cache->store(_listing);
+    }
+    return false;
+}
+
+fsdir_entry *DirStream::read()
+{
+    if (!_open)
+        return nullptr;
+
+    // caught up with what has been fetched
+    while (_current >= _listing->count())
+    {
+        if (_listing->complete || fetch_next())
+            return nullptr;
+    }
+
+    if (_listing->get(_current, &_entry))
+        return nullptr;
+    _current++;
+    return &_entry;
+}
+
+uint16_t DirStream::tell()
+{
+    if (!_open || (_listing->complete && _listing->count() == 0))
+        return FNFS_INVALID_DIRPOS;
+    return _current;
+}
+
+bool DirStream::seek(uint16_t pos)
+{
+    if (!_open)
+        return false;
+
+    while (pos > _listing->count() && !_listing->complete)
+    {
+        if (fetch_next())
+            return false;
+    }
+
+    if (pos > _listing->count())
+        return false;
+    _current = pos;
+    return true;
+}
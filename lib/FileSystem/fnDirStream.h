@@ -0,0 +1,137 @@
+#ifndef FN_DIRSTREAM_H
+#define FN_DIRSTREAM_H
+
+#include <stdint.h>
+#include <time.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fnFS.h"
+
+// Entries fetched from the host at a time
+#define DIRSTREAM_PAGE 32
+// Finished listings kept per host, and the entries kept across all of them,
+// fewer when there is no PSRAM
+#define DIRLISTING_CACHE_LISTINGS 8
+#define DIRLISTING_CACHE_ENTRIES 4096
+#define DIRLISTING_CACHE_ENTRIES_NO_PSRAM 512
+
+class DirStreamTask;
+
+/*
+ * One directory as the host listed it, already filtered and sorted, with
+ * the names packed into a single buffer. Keyed by the path, pattern and
+ * options it was opened with and the directory's modification time, so a
+ * cached copy is only used while the directory is unchanged.
+ */
+class DirListing
+{
+private:
+    struct item
+    {
+        uint32_t name;      // offset into _names
+        uint32_t size;
+        time_t modified_time;
+        bool isDir;
+    };
+
+    std::string _path;
+    std::string _pattern;
+    uint16_t _diropts;
+    time_t _mtime;
+
+    std::vector<item> _items;
+    std::vector<char> _names;
+
+public:
+    DirListing(const char *path, const char *pattern, uint16_t diropts, time_t mtime);
+
+    bool matches(const char *path, const char *pattern, uint16_t diropts, time_t mtime);
+    // A directory whose modification time is unknown is never kept
+    bool cacheable() { return _mtime != 0; };
+
+    void add(const char *filename, bool isDir, uint32_t size, time_t modified_time);
+    // Returns TRUE if an error condition occurred
+    bool get(uint16_t index, fsdir_entry *entry);
+    uint16_t count() { return (uint16_t)_items.size(); };
+
+    // The host has nothing more to add
+    bool complete = false;
+};
+
+/*
+ * The last few finished listings from one host, dropped least recently used
+ * first once there are too many of them or too many entries between them.
+ */
+class DirListingCache
+{
+private:
+    std::vector<std::shared_ptr<DirListing>> _listings; // most recently used first
+    size_t _max_entries = 0;
+
+public:
+    std::shared_ptr<DirListing> find(const char *path, const char *pattern, uint16_t diropts, time_t mtime);
+    void store(std::shared_ptr<DirListing> listing);
+    void clear() { _listings.clear(); };
+};
+
+/*
+ * Reads a directory a page at a time. dir_open() has the first page fetched
+ * before it returns, and prefetch() has a task under taskMgr fetch the rest
+ * between bus commands. A reader who gets ahead of the task fetches the next
+ * page itself. Positions are indexes into the listing, so tell and seek never
+ * go to the host. A finished listing goes into the host's DirListingCache and
+ * the next open of the same directory reads from there instead.
+ *
+ * Closing leaves the task running, hosts that close the directory between
+ * pages pick the same listing up again with resume().
+ *
+ * The base class serves listings which are complete from the start, hosts
+ * that can list a page at a time override fetch_page() and finish().
+ */
+class DirStream
+{
+protected:
+    std::shared_ptr<DirListing> _listing;
+    DirListingCache *_cache = nullptr;
+    uint16_t _current = 0;
+    bool _open = false;
+    bool _failed = false;
+    fsdir_entry _entry;
+
+    friend class DirStreamTask;
+    DirStreamTask *_task = nullptr;
+    uint8_t _task_id = 0;
+
+    // Add up to DIRSTREAM_PAGE entries to _listing, setting complete at the end
+    // Returns TRUE if an error condition occurred
+    virtual bool fetch_page() { _listing->complete = true; return false; };
+    // Let go of whatever the host has open for the listing
+    virtual void finish() {};
+
+    bool fetch_next();
+
+public:
+    DirStream(DirListingCache *cache) : _cache(cache) {};
+    virtual ~DirStream();
+
+    // Start reading listing from the top, fetching its first page if it is new
+    // Returns TRUE if an error condition occurred
+    bool start(std::shared_ptr<DirListing> listing);
+    // Read the last listing from the top again if it is the one asked for
+    bool resume(const char *path, const char *pattern, uint16_t diropts, time_t mtime);
+    // Fetch the rest of the listing in the background
+    void prefetch();
+    // Done reading, a listing still being fetched in the background carries on
+    void close();
+    // Drop the listing, whether or not it is complete
+    void stop();
+    bool active() { return _open; };
+
+    fsdir_entry *read();
+    uint16_t tell();
+    bool seek(uint16_t pos);
+};
+
+#endif // FN_DIRSTREAM_H
@@ -0,0 +1,470 @@
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+#include "fnFileFTP.h"
+#include "fnSystem.h"
+#include "../../include/debug.h"
+
+
+FileHandlerFTP::FileHandlerFTP(fnFTP *ftp, const char *path, long size, bool writable)
+    : _ftp(ftp), _path(path), _writable(writable), _size(size), _remote_size(size), _position(0),
+      _blocks(nullptr), _block_count(0), _clock(0),
+      _streaming(false), _stream_id(0), _stream_pos(0), _last_miss(-2), _readahead(0)
+{
+    Debug_println("new FileHandlerFTP");
+#ifdef ESP_PLATFORM
+    int count = fnSystem.get_psram_size() > 0 ? FTPFILE_CACHE_BLOCKS : FTPFILE_CACHE_BLOCKS_NO_PSRAM;
+#else
+    int count = FTPFILE_CACHE_BLOCKS;
+#endif
+    // block data is allocated as blocks are first used
+    _blocks = (cache_block *)calloc(count, sizeof(cache_block));
+    if (_blocks == nullptr)
+    {
+        Debug_println("FileHandlerFTP - failed to allocate block cache");
+        return;
+    }
+    _block_count = count;
+    for (int i = 0; i < _block_count; i++)
+        _blocks[i].index = -1;
+};
+
+
+FileHandlerFTP::~FileHandlerFTP()
+{
+    Debug_println("delete FileHandlerFTP");
+    if (_blocks != nullptr) close(false);
+}
+
+
+int FileHandlerFTP::close(bool destroy)
+{
+    Debug_println("FileHandlerFTP::close");
+    int result = 0;
+    if (_blocks != nullptr)
+    {
+        result = write_back_all();
+        stream_stop();
+        for (int i = 0; i < _block_count; i++)
+            free(_blocks[i].data);
+        free(_blocks);
+        _blocks = nullptr;
+        _block_count = 0;
+    }
+    if (destroy) delete this;
+    return result;
+}
+
+
+int FileHandlerFTP::seek(long int off, int whence)
+{
+    Debug_println("FileHandlerFTP::seek");
+    long int new_pos;
+    switch (whence)
+    {
+        case SEEK_SET:
+            new_pos = off;
+            break;
+        case SEEK_END:
+            new_pos = _size + off;
+            break;
+        case SEEK_CUR:
+            new_pos = _position + off;
+            break;
+        default:
+            Debug_printf("FileHandlerFTP::seek - called with invalid whence value: %d\n", whence);
+            errno = EINVAL;
+            return -1;
+    }
+
+    if (new_pos < 0)
+    {
+        Debug_printf("FileHandlerFTP::seek - invalid new position: %ld\n", new_pos);
+        errno = EINVAL;
+        return -1;
+    }
+
+    _position = new_pos;
+    Debug_printf("new pos is %lu\n", new_pos);
+    return 0;
+}
+
+
+long int FileHandlerFTP::tell()
+{
+    Debug_println("FileHandlerFTP::tell");
+    return _position;
+}
+
+
+size_t FileHandlerFTP::read(void *ptr, size_t size, size_t count)
+{
+    Debug_println("FileHandlerFTP::read");
+
+    size_t requested = size * count;
+    size_t bytes_read = 0;
+
+    while (bytes_read < requested && _position < _size)
+    {
+        long index = _position / FTPFILE_BLOCK_SIZE;
+        size_t offset = _position % FTPFILE_BLOCK_SIZE;
+        size_t n = FTPFILE_BLOCK_SIZE - offset;
+        if (n > (size_t)(_size - _position))
+            n = _size - _position;
+        if (n > requested - bytes_read)
+            n = requested - bytes_read;
+
+        cache_block *b = get_block(index, true);
+        if (b == nullptr)
+            break;
+
+        memcpy((uint8_t *)ptr + bytes_read, b->data + offset, n);
+        bytes_read += n;
+        _position += n;
+    }
+
+    return (size_t)(size * count == bytes_read ? count : bytes_read / size);
+}
+
+
+size_t FileHandlerFTP::write(const void *ptr, size_t size, size_t count)
+{
+    Debug_println("FileHandlerFTP::write");
+
+    if (!_writable)
+    {
+        Debug_println("FileHandlerFTP::write - file is open for reading only");
+        errno = EBADF;
+        return 0;
+    }
+
+    size_t requested = size * count;
+    size_t bytes_written = 0;
+
+    while (bytes_written < requested)
+    {
+        long index = _position / FTPFILE_BLOCK_SIZE;
+        size_t offset = _position % FTPFILE_BLOCK_SIZE;
+        size_t n = FTPFILE_BLOCK_SIZE - offset;
+        if (n > requested - bytes_written)
+            n = requested - bytes_written;
+
+        // a whole block replaced needs nothing from the server
+        cache_block *b = get_block(index, n != FTPFILE_BLOCK_SIZE);
+        if (b == nullptr)
+            break;
+
+        memcpy(b->data + offset, (const uint8_t *)ptr + bytes_written, n);
+        b->dirty = true;
+        bytes_written += n;
+        _position += n;
+        if (_size < _position)
+            _size = _position;
+    }
+
+    return (size_t)(size * count == bytes_written ? count : bytes_written / size);
+}
+
+
+int FileHandlerFTP::flush()
+{
+    Debug_println("FileHandlerFTP::flush");
+    return write_back_all();
+}
+
+
+FileHandlerFTP::cache_block *FileHandlerFTP::find_block(long index)
+{
+    for (int i = 0; i < _block_count; i++)
+        if (_blocks[i].index == index)
+            return &_blocks[i];
+    return nullptr;
+}
+
+// block for index, fetched from the server on a miss if fill is set,
+// reading further ahead each time misses come in order
+FileHandlerFTP::cache_block *FileHandlerFTP::get_block(long index, bool fill)
+{
+    cache_block *b = find_block(index);
+    if (b != nullptr)
+    {
+        b->used = ++_clock;
+        return b;
+    }
+
+    b = take_block(true);
+    if (b == nullptr)
+        return nullptr;
+
+    if (!fill || index * FTPFILE_BLOCK_SIZE >= _remote_size)
+    {
+        // nothing on the server for it yet
+        memset(b->data, 0, FTPFILE_BLOCK_SIZE);
+        b->index = index;
+        b->dirty = false;
+        b->used = ++_clock;
+        return b;
+    }
+
+    if (index == _last_miss + 1)
+    {
+        _readahead = _readahead ? _readahead * 2 : 1;
+        if (_readahead > FTPFILE_READAHEAD_MAX)
+            _readahead = FTPFILE_READAHEAD_MAX;
+        // leave most of the cache to what was asked for
+        if (_readahead > _block_count / 2)
+            _readahead = _block_count / 2;
+    }
+    else
+        _readahead = 0;
+
+    if (!fetch(b, index))
+        return nullptr;
+    _last_miss = index;
+
+    // carry on down the running stream, but never write back to make room
+    for (int i = 1; i <= _readahead; i++)
+    {
+        long next = index + i;
+        if (next * FTPFILE_BLOCK_SIZE >= _remote_size || find_block(next) != nullptr)
+            break;
+
+        cache_block *ahead = take_block(false);
+        if (ahead == nullptr || !fetch(ahead, next))
+            break;
+        _last_miss = next;
+    }
+
+    b->used = ++_clock;
+    return b;
+}
+
+// least recently used block, written back first if dirty and allowed,
+// with its data allocated and its index cleared
+FileHandlerFTP::cache_block *FileHandlerFTP::take_block(bool write_back_dirty)
+{
+    cache_block *b = nullptr;
+
+    for (int i = 0; i < _block_count; i++)
+    {
+        if (_blocks[i].index < 0)
+        {
+            b = &_blocks[i];
+            break;
+        }
+        if (b == nullptr || _blocks[i].used < b->used)
+            b = &_blocks[i];
+    }
+    if (b == nullptr)
+        return nullptr;
+
+    if (b->dirty)
+    {
+        if (!write_back_dirty || write_back(b) != 0)
+            return nullptr;
+    }
+
+    if (b->data == nullptr)
+    {
+#ifdef ESP_PLATFORM
+        b->data = (uint8_t *)heap_caps_malloc(FTPFILE_BLOCK_SIZE, MALLOC_CAP_SPIRAM);
+        if (b->data == nullptr)
+            b->data = (uint8_t *)malloc(FTPFILE_BLOCK_SIZE);
+#else
+        b->data = (uint8_t *)malloc(FTPFILE_BLOCK_SIZE);
+#endif
+        if (b->data == nullptr)
+        {
+            Debug_println("FileHandlerFTP::take_block - failed to allocate block");
+            errno = ENOMEM;
+            return nullptr;
+        }
+    }
+
+    b->index = -1;
+    b->dirty = false;
+    return b;
+}
+
+// fill b with block index from the server
+bool FileHandlerFTP::fetch(cache_block *b, long index)
+{
+    long offset = index * FTPFILE_BLOCK_SIZE;
+    size_t len = FTPFILE_BLOCK_SIZE;
+    if (len > (size_t)(_remote_size - offset))
+        len = _remote_size - offset;
+
+    Debug_printf("FileHandlerFTP::fetch - block %ld\n", index);
+
+    // a stream left idle may have been dropped by the server, try a new one once
+    bool ok = false;
+    for (int attempt = 0; attempt < 2 && !ok; attempt++)
+    {
+        if (!stream_to(offset))
+            return false;
+        ok = stream_read(b->data, len);
+        if (!ok)
+            stream_stop();
+    }
+    if (!ok)
+    {
+        Debug_printf("FileHandlerFTP::fetch - failed to read block %ld\n", index);
+        return false;
+    }
+
+    memset(b->data + len, 0, FTPFILE_BLOCK_SIZE - len);
+    b->index = index;
+    b->dirty = false;
+    b->used = ++_clock;
+
+    _stream_pos += len;
+    if (_stream_pos >= _remote_size)
+        stream_stop();
+
+    return true;
+}
+
+// make sure our RETR delivers from offset next
+bool FileHandlerFTP::stream_to(long offset)
+{
+    if (_streaming && _ftp->transfer_id() == _stream_id && _stream_pos == offset)
+        return true;
+
+    stream_stop();
+
+    if (_ftp->open_file_at(_path, offset))
+    {
+        Debug_printf("FileHandlerFTP::stream_to - failed to start transfer at %ld\n", offset);
+        return false;
+    }
+
+    _streaming = true;
+    _stream_id = _ftp->transfer_id();
+    _stream_pos = offset;
+    return true;
+}
+
+// take exactly len bytes from the stream
+bool FileHandlerFTP::stream_read(uint8_t *buf, size_t len)
+{
+    uint64_t deadline = fnSystem.millis() + FTP_TIMEOUT;
+
+    while (len > 0)
+    {
+        int available = _ftp->data_available();
+        if (available <= 0)
+        {
+            if (!_ftp->data_connected() || fnSystem.millis() > deadline)
+                return false;
+            fnSystem.delay(FTP_POLL_MS); // wait for more data
+            continue;
+        }
+
+        unsigned short n = (size_t)available > len ? len : available;
+        if (_ftp->read_file(buf, n))
+            return false;
+        buf += n;
+        len -= n;
+        deadline = fnSystem.millis() + FTP_TIMEOUT;
+    }
+    return true;
+}
+
+void FileHandlerFTP::stream_stop()
+{
+    if (!_streaming)
+        return;
+    _streaming = false;
+
+    // someone else started a transfer since, ours is gone already
+    if (_ftp->transfer_id() != _stream_id)
+        return;
+
+    if (_stream_pos >= _remote_size)
+    {
+        // ran to the end, let the server finish it properly
+        uint64_t deadline = fnSystem.millis() + FTP_TIMEOUT;
+        while (_ftp->data_connected() && fnSystem.millis() < deadline)
+            fnSystem.delay(FTP_POLL_MS);
+        if (!_ftp->data_connected())
+        {
+            _ftp->close();
+            return;
+        }
+    }
+
+    _ftp->abort_transfer();
+}
+
+// write b and the dirty blocks straight after it in one transfer
+int FileHandlerFTP::write_back(cache_block *b)
+{
+    long first = b->index;
+    long offset = first * FTPFILE_BLOCK_SIZE;
+    long last = first;
+    bool ok = true;
+
+    // the data connection is needed for this
+    stream_stop();
+
+    Debug_printf("FileHandlerFTP::write_back - from block %ld\n", first);
+
+    if (_ftp->store_file_at(_path, offset, offset == _remote_size))
+    {
+        Debug_println("FileHandlerFTP::write_back - failed to start transfer");
+        return -1;
+    }
+
+    for (cache_block *c = b; c != nullptr && c->dirty; c = find_block(++last))
+    {
+        long coff = last * FTPFILE_BLOCK_SIZE;
+        size_t len = FTPFILE_BLOCK_SIZE;
+        if (len > (size_t)(_size - coff))
+            len = _size - coff;
+        if (_ftp->write_file(c->data, len))
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    // the server has it once it confirms the transfer
+    if (_ftp->close() || !ok)
+    {
+        Debug_println("FileHandlerFTP::write_back - transfer failed");
+        return -1;
+    }
+
+    for (long i = first; i < last; i++)
+        find_block(i)->dirty = false;
+
+    long end = last * FTPFILE_BLOCK_SIZE;
+    if (end > _size)
+        end = _size;
+    if (_remote_size < end)
+        _remote_size = end;
+
+    return 0;
+}
+
+// write back every dirty block, in file order
+int FileHandlerFTP::write_back_all()
+{
+    while (true)
+    {
+        cache_block *b = nullptr;
+        for (int i = 0; i < _block_count; i++)
+            if (_blocks[i].dirty && (b == nullptr || _blocks[i].index < b->index))
+                b = &_blocks[i];
+        if (b == nullptr)
+            return 0;
+        if (write_back(b) != 0)
+            return -1;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef FN_FILEFTP_H
+#define FN_FILEFTP_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+#include "fnFTP.h"
+#include "fnFile.h"
+
+// Unit of fetching, caching and writing back
+#define FTPFILE_BLOCK_SIZE 4096
+// Cached blocks, fewer when there is no PSRAM to put them in
+#define FTPFILE_CACHE_BLOCKS 32
+#define FTPFILE_CACHE_BLOCKS_NO_PSRAM 8
+// Most blocks read ahead of a sequential miss, the window doubles up to this
+#define FTPFILE_READAHEAD_MAX 16
+
+/*
+ * File on an FTP server, read on demand. Blocks are fetched with REST + RETR
+ * as they are needed. The RETR is left running after a miss, so sequential
+ * reads carry on down the same stream with a growing read-ahead window
+ * rather than paying for a new transfer each time. Writes stay in the cache
+ * until flush, close or eviction, then go back as runs of blocks with APPE
+ * at the end of the file or REST + STOR elsewhere.
+ */
+class FileHandlerFTP : public FileHandler
+{
+protected:
+    struct cache_block
+    {
+        long index;         // block number in the file, -1 if unused
+        uint8_t *data;      // FTPFILE_BLOCK_SIZE bytes, zeros past the end of file
+        bool dirty;
+        uint32_t used;      // LRU stamp
+    };
+
+    fnFTP *_ftp;
+    std::string _path;
+    bool _writable;
+    long _size;             // file size, including writes not yet on the server
+    long _remote_size;      // file size on the server
+    long _position;
+
+    cache_block *_blocks;
+    int _block_count;
+    uint32_t _clock;
+
+    bool _streaming;        // a RETR of ours was left running
+    uint32_t _stream_id;    // _ftp->transfer_id() while it is still ours
+    long _stream_pos;       // offset of the next byte it delivers
+    long _last_miss;        // last block fetched on a miss
+    int _readahead;         // blocks to fetch after the next sequential miss
+
+    cache_block *find_block(long index);
+    cache_block *get_block(long index, bool fill);
+    cache_block *take_block(bool write_back_dirty);
+    bool fetch(cache_block *b, long index);
+    bool stream_to(long offset);
+    bool stream_read(uint8_t *buf, size_t len);
+    void stream_stop();
+    int write_back(cache_block *b);
+    int write_back_all();
+
+public:
+    FileHandlerFTP(fnFTP *ftp, const char *path, long size, bool writable);
+    virtual ~FileHandlerFTP() override;
+
+    virtual int close(bool destroy=true) override;
+    virtual int seek(long int off, int whence) override;
+    virtual long int tell() override;
+    virtual size_t read(void *ptr, size_t size, size_t count) override;
+    virtual size_t write(const void *ptr, size_t size, size_t count) override;
+    virtual int flush() override;
+};
+
+#endif // FN_FILEFTP_H
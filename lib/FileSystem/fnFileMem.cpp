@@ -1,12 +1,20 @@
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
 #include "fnFileMem.h"
 #include "../../include/debug.h"
 
+// what unwritten pages read as
+static const uint8_t zero_page[FILEMEM_PAGE_SIZE] = { 0 };
+
 
-FileHandlerMem::FileHandlerMem() : _buffer(nullptr), _size(0), _filesize(0), _position(0)
+FileHandlerMem::FileHandlerMem() : _pages(nullptr), _page_count(0), _page_alloc(0), _filesize(0), _position(0)
 {
     Debug_println("new FileHandlerMem");
 };
@@ -15,7 +23,9 @@ FileHandlerMem::FileHandlerMem() : _buffer(nullptr), _size(0), _filesize(0), _po
 FileHandlerMem::~FileHandlerMem()
 {
     Debug_println("delete FileHandlerMem");
-    free(_buffer);
+    for (long int i = 0; i < _page_count; i++)
+        free(_pages[i]);
+    free(_pages);
 }
 
 
@@ -38,7 +48,7 @@ int FileHandlerMem::seek(long int off, int whence)
             new_pos = off;
             break;
         case SEEK_END:
-            new_pos = _filesize - off;
+            new_pos = _filesize + off;
             break;
         case SEEK_CUR:
             new_pos = _position + off;
@@ -73,18 +83,39 @@ long int FileHandlerMem::tell()
 }
 
 
+size_t FileHandlerMem::view(const uint8_t **ptr, size_t max)
+{
+    if (_position >= _filesize || max == 0)
+        return 0;
+
+    long int index = _position / FILEMEM_PAGE_SIZE;
+    size_t offset = _position % FILEMEM_PAGE_SIZE;
+    size_t len = FILEMEM_PAGE_SIZE - offset;
+
+    if (len > (size_t)(_filesize - _position))
+        len = _filesize - _position;
+    if (len > max)
+        len = max;
+
+    *ptr = (_pages[index] != nullptr ? _pages[index] : zero_page) + offset;
+    _position += len;
+    return len;
+}
+
+
 size_t FileHandlerMem::read(void *ptr, size_t size, size_t count)
 {
     Debug_println("FileHandlerMem::read");
 
     size_t requested = size * count;
-    size_t available = _filesize - _position;
-    size_t to_read = available > requested ? requested : available;
+    size_t to_read = 0;
+    const uint8_t *src;
+    size_t n;
 
-    if (to_read)
+    while (to_read < requested && (n = view(&src, requested - to_read)) > 0)
     {
-        memcpy(ptr, (void *)(_buffer + _position), to_read);
-        _position += to_read;
+        memcpy((uint8_t *)ptr + to_read, src, n);
+        to_read += n;
     }
 
     return (size_t)(size * count == to_read ? count : to_read / size);
@@ -96,24 +127,33 @@ size_t FileHandlerMem::write(const void *ptr, size_t size, size_t count)
     Debug_println("FileHandlerMem::write");
 
     size_t requested = size * count;
-    size_t available = _size - _position;
+    long int old_size = _filesize;
 
-    if (available < requested)
-    {
-        if (grow(_position + requested) < 0)
-            return 0;
-        available = _size - _position;
-    }
+    if (_position + (long int)requested > _filesize && grow(_position + requested) < 0)
+        return 0;
 
-    size_t to_write = available > requested ? requested : available;
-    if (to_write)
+    size_t to_write = 0;
+    while (to_write < requested)
     {
-        memcpy((void *)(_buffer + _position), ptr, to_write);
-        _position += to_write;
-        if (_filesize < _position)
-            _filesize = _position;
+        long int index = _position / FILEMEM_PAGE_SIZE;
+        size_t offset = _position % FILEMEM_PAGE_SIZE;
+        size_t n = FILEMEM_PAGE_SIZE - offset;
+        if (n > requested - to_write)
+            n = requested - to_write;
+
+        uint8_t *page = page_for_write(index);
+        if (page == nullptr)
+            break;
+
+        memcpy(page + offset, (const uint8_t *)ptr + to_write, n);
+        to_write += n;
+        _position += n;
     }
 
+    // out of memory part way, only keep what was written
+    if (to_write < requested && _filesize > old_size)
+        _filesize = _position > old_size ? _position : old_size;
+
     return (size_t)(size * count == to_write ? count : to_write / size);
 }
 
@@ -124,31 +164,82 @@ int FileHandlerMem::flush()
     return 0;
 }
 
-// set new file size, allocate additional buffer space, if needed
-// (smaller than current file size can be set but it does not shrink allocated buffer)
+// allocate a page on its first write, pages come from PSRAM when there is some
+uint8_t *FileHandlerMem::page_for_write(long int index)
+{
+    if (_pages[index] != nullptr)
+        return _pages[index];
+
+#ifdef ESP_PLATFORM
+    uint8_t *page = (uint8_t *)heap_caps_calloc(1, FILEMEM_PAGE_SIZE, MALLOC_CAP_SPIRAM);
+    if (page == nullptr)
+        page = (uint8_t *)calloc(1, FILEMEM_PAGE_SIZE);
+#else
+    uint8_t *page = (uint8_t *)calloc(1, FILEMEM_PAGE_SIZE);
+#endif
+    if (page == nullptr)
+    {
+        Debug_printf("FileHandlerMem::page_for_write - failed to allocate page %ld\n", index);
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    _pages[index] = page;
+    return page;
+}
+
+// set new file size, extend the page table if needed
+// pages themselves are allocated on first write, until then they read as zeros
+// a smaller size releases the pages past the new end
 // return 0 on success, -1 on failure
 int FileHandlerMem::grow(long filesize)
 {
-    long bufsize = 1024 * ((filesize + 1023) / 1024);
-    Debug_printf("FileHandlerMem::grow - file size / buffer size: %ld / %ld\n", filesize, bufsize > _size ? bufsize : _size);
-    // grow buffer, if needed
-    if (bufsize > _size)
+    long int pages = (filesize + FILEMEM_PAGE_SIZE - 1) / FILEMEM_PAGE_SIZE;
+    Debug_printf("FileHandlerMem::grow - file size / pages: %ld / %ld\n", filesize, pages);
+
+    if (filesize > FILEMEM_MAXSIZE)
     {
-        if (_size >= FILEMEM_MAXSIZE)
+        Debug_println("FileHandlerMem::grow - failed, max file size reached");
+        errno = EFBIG;
+        return -1;
+    }
+
+    if (pages > _page_alloc)
+    {
+        // double the table, so the total spent on growing stays linear
+        long int alloc = _page_alloc ? _page_alloc : FILEMEM_MIN_PAGES;
+        while (alloc < pages)
+            alloc *= 2;
+
+        uint8_t **new_table = (uint8_t **)realloc(_pages, alloc * sizeof(uint8_t *));
+        if (new_table == nullptr)
         {
-            Debug_println("FileHandlerMem::grow - failed, max buffer size reached");
-            errno = EFBIG;
+            Debug_println("FileHandlerMem::grow - failed to reallocate page table");
+            errno = ENOMEM;
             return -1;
         }
-        void *new_buf = realloc(_buffer, bufsize);
-        if (new_buf == nullptr) 
+        memset(new_table + _page_alloc, 0, (alloc - _page_alloc) * sizeof(uint8_t *));
+        _pages = new_table;
+        _page_alloc = alloc;
+    }
+
+    if (pages < _page_count)
+    {
+        for (long int i = pages; i < _page_count; i++)
         {
-            Debug_println("FileHandlerMem::grow - failed to reallocate buffer");
-            return -1;
-        } 
-        _buffer = (uint8_t *)new_buf;
-        _size = bufsize;
+            free(_pages[i]);
+            _pages[i] = nullptr;
+        }
     }
+    _page_count = pages;
+
+    // what was cut off must not come back if the file grows again
+    if (filesize < _filesize && filesize % FILEMEM_PAGE_SIZE && _pages[pages - 1] != nullptr)
+    {
+        size_t offset = filesize % FILEMEM_PAGE_SIZE;
+        memset(_pages[pages - 1] + offset, 0, FILEMEM_PAGE_SIZE - offset);
+    }
+
     // set new file size
     _filesize = filesize;
     return 0;
@@ -8,13 +8,22 @@
 
 #define FILEMEM_MAXSIZE   1048576
 
+// File data lives in fixed size pages which never move once allocated,
+// so growing the file costs one page allocation and no copying
+#define FILEMEM_PAGE_SIZE 4096
+// Initial page table entries, the table doubles when full
+#define FILEMEM_MIN_PAGES 8
+
 class FileHandlerMem : public FileHandler
 {
 protected:
-    uint8_t *_buffer;
-    long int _size;
+    uint8_t **_pages;       // page table, nullptr entries are unwritten (zero) pages
+    long int _page_count;   // page table entries in use
+    long int _page_alloc;   // page table entries allocated
     long int _filesize;
     long int _position;
+
+    uint8_t *page_for_write(long int index);
 public:
     FileHandlerMem();
     virtual ~FileHandlerMem() override;
@@ -27,6 +36,12 @@ public:
     virtual int flush() override;
 
     int grow(long filesize);
+    long int size() { return _filesize; };
+
+    // Zero-copy read: point *ptr at up to max bytes from the current position,
+    // never crossing a page, and advance past them. Returns the byte count,
+    // 0 at end of file. The data stays valid until the file is closed.
+    size_t view(const uint8_t **ptr, size_t max);
 };
 
 #endif // FN_FILEMEM_H
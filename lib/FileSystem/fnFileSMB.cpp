@@ -1,15 +1,50 @@
 
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#include <sys/poll.h>
+#elif defined(_WIN32)
+#include <winsock2.h>
+#define poll WSAPoll
+#else
+#include <poll.h>
+#endif
 
 #include "fnFileSMB.h"
+#include "fnSystem.h"
 #include "../../include/debug.h"
 
+// longest single wait on the socket, so the overall timeout is kept to
+#define SMBFILE_POLL_MS 100
+
 
-FileHandlerSMB::FileHandlerSMB(struct smb2_context *smb, struct smb2fh *handle)
+FileHandlerSMB::FileHandlerSMB(struct smb2_context *smb, struct smb2fh *handle, long size)
+    : _smb(smb), _handle(handle), _size(size), _position(0),
+      _blocks(nullptr), _block_count(0), _clock(0), _in_flight(0),
+      _last_miss(-2), _readahead(0)
 {
     Debug_println("new FileHandlerSMB");
-    _smb = smb;
-    _handle = handle;
+#ifdef ESP_PLATFORM
+    int count = fnSystem.get_psram_size() > 0 ? SMBFILE_CACHE_BLOCKS : SMBFILE_CACHE_BLOCKS_NO_PSRAM;
+#else
+    int count = SMBFILE_CACHE_BLOCKS;
+#endif
+    // block data is allocated as blocks are first used
+    _blocks = (cache_block *)calloc(count, sizeof(cache_block));
+    if (_blocks == nullptr)
+    {
+        Debug_println("FileHandlerSMB - failed to allocate block cache");
+        return;
+    }
+    _block_count = count;
+    for (int i = 0; i < _block_count; i++)
+    {
+        _blocks[i].index = -1;
+        _blocks[i].owner = this;
+    }
 };
 
 
@@ -24,8 +59,25 @@ int FileHandlerSMB::close(bool destroy)
 {
     Debug_println("FileHandlerSMB::close");
     int result = 0;
-    if (_handle != nullptr) 
+    if (_handle != nullptr)
     {
+        if (drain())
+        {
+            for (int i = 0; i < _block_count; i++)
+                free(_blocks[i].data);
+            free(_blocks);
+        }
+        else
+        {
+            // libsmb2 may still write into these, better lost than reused,
+            // and their completions must not reach back to this handler
+            Debug_printf("FileHandlerSMB::close - %d reads still in flight, cache abandoned\n", _in_flight);
+            for (int i = 0; i < _block_count; i++)
+                _blocks[i].owner = nullptr;
+        }
+        _blocks = nullptr;
+        _block_count = 0;
+
         result = smb2_close(_smb, _handle);
         _handle = nullptr;
         _smb = nullptr;
@@ -38,12 +90,32 @@ int FileHandlerSMB::close(bool destroy)
 int FileHandlerSMB::seek(long int off, int whence)
 {
     Debug_println("FileHandlerSMB::seek");
-    uint64_t new_pos;
-    if (smb2_lseek(_smb, _handle, off, whence, &new_pos) < 0)
+    long int new_pos;
+    switch (whence)
     {
-        Debug_printf("%s\n", smb2_get_error(_smb));
+        case SEEK_SET:
+            new_pos = off;
+            break;
+        case SEEK_END:
+            new_pos = _size + off;
+            break;
+        case SEEK_CUR:
+            new_pos = _position + off;
+            break;
+        default:
+            Debug_printf("FileHandlerSMB::seek - called with invalid whence value: %d\n", whence);
+            errno = EINVAL;
+            return -1;
+    }
+
+    if (new_pos < 0)
+    {
+        Debug_printf("FileHandlerSMB::seek - invalid new position: %ld\n", new_pos);
+        errno = EINVAL;
         return -1;
     }
+
+    _position = new_pos;
     Debug_printf("new pos is %lu\n", new_pos);
     return 0;
 }
@@ -52,13 +124,7 @@ int FileHandlerSMB::seek(long int off, int whence)
 long int FileHandlerSMB::tell()
 {
     Debug_println("FileHandlerSMB::tell");
-    uint64_t pos;
-    if (smb2_lseek(_smb, _handle, 0, SEEK_CUR, &pos) < 0)
-    {
-        Debug_printf("%s\n", smb2_get_error(_smb));
-        return -1;
-    }
-    return (long)pos;
+    return _position;
 }
 
 
@@ -66,31 +132,30 @@ size_t FileHandlerSMB::read(void *ptr, size_t size, size_t count)
 {
     Debug_println("FileHandlerSMB::read");
 
-    size_t bytes_remaining = size * count;
+    size_t requested = size * count;
     size_t bytes_read = 0;
-    int result;
-    while (bytes_remaining > 0)
+
+    while (bytes_read < requested && _position < _size)
     {
-        result = smb2_read(_smb, _handle, (uint8_t *)ptr, (uint32_t)bytes_remaining);
-        if (result < 0)
-        {
-            if (errno == EAGAIN)
-                continue;
-            else
-            {
-                Debug_printf("%s\n", smb2_get_error(_smb));
-                break;
-            }
-        }
-        else if (result == 0)
-        {
-            break; // EOF
-        }
-        else
-        {
-            bytes_read += result;
-            bytes_remaining -= result;
-        }
+        long index = _position / SMBFILE_BLOCK_SIZE;
+        size_t offset = _position % SMBFILE_BLOCK_SIZE;
+        size_t n = SMBFILE_BLOCK_SIZE - offset;
+        if (n > requested - bytes_read)
+            n = requested - bytes_read;
+
+        cache_block *b = get_block(index);
+        if (b == nullptr)
+            break;
+
+        // the file may have been shorter than we thought
+        if (offset >= b->length)
+            break;
+        if (n > b->length - offset)
+            n = b->length - offset;
+
+        memcpy((uint8_t *)ptr + bytes_read, b->data + offset, n);
+        bytes_read += n;
+        _position += n;
     }
 
     return (size_t)(size * count == bytes_read ? count : bytes_read / size);
@@ -101,29 +166,48 @@ size_t FileHandlerSMB::write(const void *ptr, size_t size, size_t count)
 {
     Debug_println("FileHandlerSMB::write");
 
+    // reads in flight could land on top of what is written
+    if (!drain())
+        return 0;
+
     size_t bytes_remaining = size * count;
     size_t bytes_written = 0;
     int result;
     while (bytes_remaining > 0)
     {
-        result = smb2_write(_smb, _handle, (uint8_t *)ptr, (uint32_t)bytes_remaining);
+        result = smb2_pwrite(_smb, _handle, (const uint8_t *)ptr + bytes_written,
+                             (uint32_t)bytes_remaining, _position + bytes_written);
         if (result < 0)
         {
-            if (errno == EAGAIN)
+            if (result == -EAGAIN)
                 continue;
-            else
-            {
-                Debug_printf("%s\n", smb2_get_error(_smb));
-                break;
-            }
-        }
-        else
-        {
-            bytes_written += result;
-            bytes_remaining -= result;
+            Debug_printf("%s\n", smb2_get_error(_smb));
+            break;
         }
+        bytes_written += result;
+        bytes_remaining -= result;
+    }
+
+    // keep any cached blocks it lands in up to date
+    long start = _position;
+    long end = _position + bytes_written;
+    for (long index = start / SMBFILE_BLOCK_SIZE; index * SMBFILE_BLOCK_SIZE < end; index++)
+    {
+        cache_block *b = find_block(index);
+        if (b == nullptr || b->status < 0)
+            continue;
+        long block_start = index * SMBFILE_BLOCK_SIZE;
+        long from = start > block_start ? start : block_start;
+        long to = end < block_start + SMBFILE_BLOCK_SIZE ? end : block_start + SMBFILE_BLOCK_SIZE;
+        memcpy(b->data + (from - block_start), (const uint8_t *)ptr + (from - start), to - from);
+        if (b->length < (size_t)(to - block_start))
+            b->length = to - block_start;
     }
 
+    _position = end;
+    if (_size < _position)
+        _size = _position;
+
     return (size_t)(size * count == bytes_written ? count : bytes_written / size);
 }
 
@@ -139,3 +223,226 @@ int FileHandlerSMB::flush()
     }
     return 0;
 }
+
+
+// completion of smb2_pread_async, cb_data is the block it was reading into
+void FileHandlerSMB::read_cb(struct smb2_context *smb, int status, void *command_data, void *cb_data)
+{
+    cache_block *b = (cache_block *)cb_data;
+
+    b->pending = false;
+    b->status = status;
+    // nullptr once its handler has closed and abandoned the cache
+    if (b->owner != nullptr)
+        b->owner->_in_flight--;
+    if (status < 0)
+    {
+        Debug_printf("FileHandlerSMB::read_cb - block %ld failed: %s\n", b->index, smb2_get_error(smb));
+        return;
+    }
+    b->length = status;
+    memset(b->data + status, 0, SMBFILE_BLOCK_SIZE - status);
+}
+
+FileHandlerSMB::cache_block *FileHandlerSMB::find_block(long index)
+{
+    for (int i = 0; i < _block_count; i++)
+        if (_blocks[i].index == index)
+            return &_blocks[i];
+    return nullptr;
+}
+
+// block for index, waiting for it if it is still on its way, reading it on
+// a miss, and keeping the read-ahead window full while reads come in order
+FileHandlerSMB::cache_block *FileHandlerSMB::get_block(long index)
+{
+    cache_block *b = find_block(index);
+    if (b != nullptr)
+    {
+        b->used = ++_clock;
+        if (b->ahead)
+        {
+            // the reader caught up with the window, slide it along
+            b->ahead = false;
+            _last_miss = index;
+            read_ahead(index);
+        }
+    }
+    else
+    {
+        if (index == _last_miss + 1)
+        {
+            _readahead = _readahead ? _readahead * 2 : 1;
+            if (_readahead > SMBFILE_READAHEAD_MAX)
+                _readahead = SMBFILE_READAHEAD_MAX;
+            // leave most of the cache to what was asked for
+            if (_readahead > _block_count / 2)
+                _readahead = _block_count / 2;
+        }
+        else
+            _readahead = 0;
+
+        b = take_block();
+        if (b == nullptr || !start_read(b, index))
+            return nullptr;
+        _last_miss = index;
+
+        // on the wire behind it, before waiting for it
+        read_ahead(index);
+    }
+
+    if (b->pending && !wait_for(b))
+        return nullptr;
+
+    if (b->status < 0)
+    {
+        // asked for again next time rather than kept
+        b->index = -1;
+        return nullptr;
+    }
+
+    return b;
+}
+
+// least recently used block with no read in flight,
+// with its data allocated and its index cleared
+FileHandlerSMB::cache_block *FileHandlerSMB::take_block()
+{
+    cache_block *b = nullptr;
+
+    for (int i = 0; i < _block_count; i++)
+    {
+        if (_blocks[i].pending)
+            continue;
+        if (_blocks[i].index < 0)
+        {
+            b = &_blocks[i];
+            break;
+        }
+        if (b == nullptr || _blocks[i].used < b->used)
+            b = &_blocks[i];
+    }
+    if (b == nullptr)
+        return nullptr;
+
+    if (b->data == nullptr)
+    {
+#ifdef ESP_PLATFORM
+        b->data = (uint8_t *)heap_caps_malloc(SMBFILE_BLOCK_SIZE, MALLOC_CAP_SPIRAM);
+        if (b->data == nullptr)
+            b->data = (uint8_t *)malloc(SMBFILE_BLOCK_SIZE);
+#else
+        b->data = (uint8_t *)malloc(SMBFILE_BLOCK_SIZE);
+#endif
+        if (b->data == nullptr)
+        {
+            Debug_println("FileHandlerSMB::take_block - failed to allocate block");
+            errno = ENOMEM;
+            return nullptr;
+        }
+    }
+
+    b->index = -1;
+    b->ahead = false;
+    b->length = 0;
+    b->status = 0;
+    return b;
+}
+
+// queue a read of block index into b, it goes out the next time we service
+bool FileHandlerSMB::start_read(cache_block *b, long index)
+{
+    long offset = index * SMBFILE_BLOCK_SIZE;
+    size_t len = SMBFILE_BLOCK_SIZE;
+    if (len > (size_t)(_size - offset))
+        len = _size - offset;
+
+    b->index = index;
+    b->pending = true;
+    b->used = ++_clock;
+
+    int result = smb2_pread_async(_smb, _handle, b->data, (uint32_t)len, (uint64_t)offset, read_cb, b);
+    if (result < 0)
+    {
+        Debug_printf("FileHandlerSMB::start_read - block %ld: %s\n", index, smb2_get_error(_smb));
+        b->pending = false;
+        b->index = -1;
+        return false;
+    }
+    _in_flight++;
+    return true;
+}
+
+// put reads for the window after index on the wire, those not already there
+void FileHandlerSMB::read_ahead(long index)
+{
+    for (int i = 1; i <= _readahead; i++)
+    {
+        long next = index + i;
+        if (next * SMBFILE_BLOCK_SIZE >= _size)
+            break;
+        if (find_block(next) != nullptr)
+            continue;
+
+        cache_block *ahead = take_block();
+        if (ahead == nullptr || !start_read(ahead, next))
+            break;
+        ahead->ahead = true;
+    }
+}
+
+bool FileHandlerSMB::wait_for(cache_block *b)
+{
+    uint64_t deadline = fnSystem.millis() + SMBFILE_TIMEOUT;
+
+    while (b->pending)
+    {
+        if (fnSystem.millis() > deadline)
+        {
+            Debug_printf("FileHandlerSMB::wait_for - block %ld timed out\n", b->index);
+            return false;
+        }
+        if (!service(SMBFILE_POLL_MS))
+            return false;
+    }
+    return true;
+}
+
+// send what is queued and take in what has arrived, waiting up to timeout_ms
+bool FileHandlerSMB::service(int timeout_ms)
+{
+    struct pollfd pfd;
+    pfd.fd = smb2_get_fd(_smb);
+    pfd.events = smb2_which_events(_smb);
+    pfd.revents = 0;
+
+    if (poll(&pfd, 1, timeout_ms) < 0)
+    {
+        if (errno == EINTR)
+            return true;
+        Debug_printf("FileHandlerSMB::service - poll failed, errno %d\n", errno);
+        return false;
+    }
+    if (pfd.revents == 0)
+        return true;
+
+    if (smb2_service(_smb, pfd.revents) < 0)
+    {
+        Debug_printf("FileHandlerSMB::service - %s\n", smb2_get_error(_smb));
+        return false;
+    }
+    return true;
+}
+
+// wait out every read still in flight
+bool FileHandlerSMB::drain()
+{
+    uint64_t deadline = fnSystem.millis() + SMBFILE_TIMEOUT;
+
+    while (_in_flight > 0)
+    {
+        if (fnSystem.millis() > deadline || !service(SMBFILE_POLL_MS))
+            return false;
+    }
+    return true;
+}
@@ -7,14 +7,66 @@
 
 #include "fnFile.h"
 
+// Unit of reading and caching
+#define SMBFILE_BLOCK_SIZE 4096
+// Cached blocks, fewer when there is no PSRAM to put them in
+#define SMBFILE_CACHE_BLOCKS 32
+#define SMBFILE_CACHE_BLOCKS_NO_PSRAM 8
+// Most reads kept in flight ahead of a sequential reader, the window doubles up to this
+#define SMBFILE_READAHEAD_MAX 16
+// How long to wait on the server for a read, milliseconds
+#define SMBFILE_TIMEOUT 10000
 
+/*
+ * File on an SMB share. The position is kept here rather than asked of
+ * libsmb2, and reads go through an LRU cache of blocks filled with
+ * smb2_pread_async. Misses in order open a read-ahead window which doubles
+ * each time, and hits on blocks read ahead slide the window along, so a
+ * sequential reader finds several reads already on the wire instead of
+ * paying a round trip per sector. Writes go straight to the server and
+ * update the blocks they cover.
+ */
 class FileHandlerSMB : public FileHandler
 {
 protected:
+    struct cache_block
+    {
+        long index;             // block number in the file, -1 if unused
+        uint8_t *data;
+        size_t length;          // bytes of the file in it, short at the end
+        bool pending;           // a read into data is still in flight
+        bool ahead;             // read ahead and not asked for yet
+        int status;             // result of the last read, -errno on failure
+        uint32_t used;          // LRU stamp
+        FileHandlerSMB *owner;  // nullptr once abandoned by close()
+    };
+
     struct smb2_context *_smb;
     struct smb2fh *_handle;
+    long _size;
+    long _position;
+
+    cache_block *_blocks;
+    int _block_count;
+    uint32_t _clock;
+    int _in_flight;
+
+    long _last_miss;            // last block asked for on a miss
+    int _readahead;             // blocks kept in flight past the reader
+
+    static void read_cb(struct smb2_context *smb, int status, void *command_data, void *cb_data);
+
+    cache_block *find_block(long index);
+    cache_block *get_block(long index);
+    cache_block *take_block();
+    bool start_read(cache_block *b, long index);
+    void read_ahead(long index);
+    bool wait_for(cache_block *b);
+    bool service(int timeout_ms);
+    bool drain();
+
 public:
-    FileHandlerSMB(struct smb2_context *smb, struct smb2fh *handle);
+    FileHandlerSMB(struct smb2_context *smb, struct smb2fh *handle, long size);
     virtual ~FileHandlerSMB() override;
 
     virtual int close(bool destroy=true) override;
@@ -7,9 +7,12 @@
 
 #include "fnSystem.h"
 #include "fnFileMem.h"
+#include "fnFileFTP.h"
 #include "fnFsSD.h"
 
 #define MAX_CACHE_MEMFILE_SIZE  204800
+// with PSRAM whole images up to FILEMEM_MAXSIZE stay in memory
+#define MAX_CACHE_MEMFILE_SIZE_PSRAM  FILEMEM_MAXSIZE
 
 #include "mbedtls/md5.h"
 void get_md5_string(const unsigned char *buf, size_t size, char *result)
@@ -115,7 +118,30 @@ FILE  *FileSystemFTP::file_open(const char *path, const char *mode)
 #ifndef FNIO_IS_STDIO
 FileHandler *FileSystemFTP::filehandler_open(const char *path, const char *mode)
 {
-    FileHandler *fh = cache_file(path);
+    bool create = strchr(mode, 'w') != nullptr;
+    bool writable = create || strchr(mode, '+') != nullptr || strchr(mode, 'a') != nullptr;
+    long size = 0;
+
+    if (create)
+    {
+        // create or truncate it now, everything after is written in place
+        if (_ftp->open_file(path, true) || _ftp->close())
+        {
+            Debug_printf("FileSystemFTP::filehandler_open - failed to create \"%s\"\n", path);
+            return nullptr;
+        }
+    }
+    else if (_ftp->get_size(path, size))
+    {
+        // without SIZE there is no knowing where the file ends, take all of it
+        Debug_println("FileSystemFTP::filehandler_open - no file size, caching whole file");
+        return cache_file(path);
+    }
+
+    // blocks are fetched as they are read
+    FileHandler *fh = new FileHandlerFTP(_ftp, path, size, writable);
+    if (strchr(mode, 'a') != nullptr)
+        fh->seek(0, SEEK_END);
     return fh;
 }
 
@@ -131,7 +157,8 @@ FileHandler *FileSystemFTP::cache_file(const char *path)
     }
 
     // open cache memory file
-    FileHandler *fh = new FileHandlerMem;
+    FileHandlerMem *fh_mem = new FileHandlerMem;
+    FileHandler *fh = fh_mem;
     if (fh == nullptr)
     {
         Debug_println("FileSystemFTP::cache_file - failed to open memory file");
@@ -145,6 +172,7 @@ FileHandler *FileSystemFTP::cache_file(const char *path)
     size_t bytes_read = 0;
     bool use_memfile = true;
     bool cancel = false;
+    size_t memfile_limit = fnSystem.get_psram_size() > 0 ? MAX_CACHE_MEMFILE_SIZE_PSRAM : MAX_CACHE_MEMFILE_SIZE;
 
     do
     {
@@ -175,17 +203,8 @@ FileHandler *FileSystemFTP::cache_file(const char *path)
                     cancel = true;
                     break;
                 }
-                // write cache file
-                if (fh->write(buf, 1, to_read) < to_read)
-                {
-                    Debug_printf("FileSystemFTP::cache_file - write failed\n");
-                    cancel = true;
-                    break;
-                }
-                bytes_read += to_read;
-
-                // check if memory file is over limit
-                if (use_memfile && bytes_read > MAX_CACHE_MEMFILE_SIZE)
+                // check if memory file would go over limit
+                if (use_memfile && bytes_read + to_read > memfile_limit)
                 {
                     // for large files switch from memory to SD card
                     if (!fnSDFAT.running())
@@ -214,19 +233,25 @@ FileHandler *FileSystemFTP::cache_file(const char *path)
                         break;
                     }
 
-                    // copy from memory to SD file
+                    // copy from memory to SD file, straight out of the memory pages
+                    const uint8_t *page;
                     size_t count = 0;
-                    fh->seek(0, SEEK_SET);
-                    do
-                    {
-                        count = fh->read(buf, 1, sizeof(buf));
-                        fh_sd->write(buf, 1, count);
-                    } while (count > 0);
-                    fh->close();
+                    fh_mem->seek(0, SEEK_SET);
+                    while ((count = fh_mem->view(&page, FILEMEM_PAGE_SIZE)) > 0)
+                        fh_sd->write(page, 1, count);
+                    fh_mem->close();
                     // switch to file on SD
                     fh = fh_sd;
                     use_memfile = false;
                 }
+                // write cache file
+                if (fh->write(buf, 1, to_read) < to_read)
+                {
+                    Debug_printf("FileSystemFTP::cache_file - write failed\n");
+                    cancel = true;
+                    break;
+                }
+                bytes_read += to_read;
                 // next batch
                 available = _ftp->data_available();
             }
@@ -10,14 +10,11 @@
 #include "smb2/smb2.h"
 #include "fnFileSMB.h"
 
-FileSystemSMB::FileSystemSMB()
+FileSystemSMB::FileSystemSMB() : _dirstream(&_dirlistings)
 {
     Debug_printf("FileSystemSMB::ctor\n");
     _smb = nullptr;
     _url = nullptr;
-    // invalidate _last_dir
-    _last_dir[0] = '/';
-    _last_dir[1] = '\0';
 }
 
 FileSystemSMB::~FileSystemSMB()
@@ -25,7 +22,8 @@ FileSystemSMB::~FileSystemSMB()
     Debug_printf("FileSystemSMB::dtor\n");
     if (_started)
     {
-        _dircache.clear();
+        _dirstream.stop();
+        _dirlistings.clear();
         smb2_disconnect_share(_smb);
         smb2_destroy_url(_url);
         smb2_destroy_context(_smb);
@@ -169,7 +167,16 @@ FileHandler *FileSystemSMB::filehandler_open(const char *path, const char *mode)
         return nullptr;
     }
 
-    return new FileHandlerSMB(_smb, fh);
+    // the handler keeps its own position, it only needs the size once
+    smb2_stat_64 st;
+    if (smb2_fstat(_smb, fh, &st) != 0)
+    {
+        Debug_printf("FileSystemSMB::filehandler_open(\"%s\") - failed to get size, SMB2 error: %s\n", path, smb2_get_error(_smb));
+        smb2_close(_smb, fh);
+        return nullptr;
+    }
+
+    return new FileHandlerSMB(_smb, fh, (long)st.smb2_size);
 }
 #endif
 
@@ -193,19 +200,17 @@ bool FileSystemSMB::dir_open(const char  *path, const char *pattern, uint16_t di
     if (smb_path != nullptr && smb_path[0] == '/')
         smb_path += 1;
 
-    if (strcmp(_last_dir, smb_path) == 0)
-    {
-        Debug_printf("Use directory cache\n");
-    }
-    else
+    // a listing is only reused while the directory's modification time is unchanged
+    time_t mtime = 0;
+    smb2_stat_64 st;
+    if (smb2_stat(_smb, smb_path, &st) == 0)
+        mtime = (time_t)st.smb2_mtime;
+
+    std::shared_ptr<DirListing> listing = _dirlistings.find(smb_path, pattern, diropts, mtime);
+    if (listing == nullptr)
     {
         Debug_printf("Fill directory cache\n");
 
-        _dircache.clear();
-        // invalidate _last_dir
-        _last_dir[0] = '/';
-        _last_dir[1] = '\0';
-
         // Open SMB directory
         struct smb2dir *smb_dir;
 
@@ -216,9 +221,6 @@ bool FileSystemSMB::dir_open(const char  *path, const char *pattern, uint16_t di
             return false;
         }
 
-        // Remember last visited directory
-        strlcpy(_last_dir, smb_path, MAX_PATHLEN);
-
         // Populate directory cache with entries
         smb2dirent *smb_de;
         fsdir_entry *fs_de;
@@ -248,30 +250,36 @@ bool FileSystemSMB::dir_open(const char  *path, const char *pattern, uint16_t di
                 Debug_printf(" add entry: \"%s\"\t%lu\n", fs_de->filename, fs_de->size);
         }
         smb2_closedir(_smb, smb_dir);
-    }
 
-    // Apply pattern matching filter and sort entries
-    _dircache.apply_filter(pattern, diropts);
+        // Apply pattern matching filter and sort entries
+        _dircache.apply_filter(pattern, diropts);
 
-    return true;
+        // libsmb2 lists the whole directory at once, so the listing is complete from the start
+        listing = std::make_shared<DirListing>(smb_path, pattern, diropts, mtime);
+        while ((fs_de = _dircache.read()) != nullptr)
+            listing->add(fs_de->filename, fs_de->isDir, fs_de->size, fs_de->modified_time);
+        _dircache.clear();
+    }
+
+    return !_dirstream.start(listing);
 }
 
 fsdir_entry *FileSystemSMB::dir_read()
 {
-    return _dircache.read();
+    return _dirstream.read();
 }
 
 void FileSystemSMB::dir_close()
 {
-    // _dircache.clear();
+    _dirstream.close();
 }
 
 uint16_t FileSystemSMB::dir_tell()
 {
-    return _dircache.tell();
+    return _dirstream.tell();
 }
 
 bool FileSystemSMB::dir_seek(uint16_t pos)
 {
-    return _dircache.seek(pos);
+    return _dirstream.seek(pos);
 }
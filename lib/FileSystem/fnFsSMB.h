@@ -7,6 +7,7 @@
 
 #include "fnFS.h"
 #include "fnDirCache.h"
+#include "fnDirStream.h"
 
 
 class FileSystemSMB : public FileSystem
@@ -16,8 +17,9 @@ private:
     struct smb2_url *_url;
 
     // directory cache
-    char _last_dir[MAX_PATHLEN];
     DirCache _dircache;
+    DirListingCache _dirlistings;
+    DirStream _dirstream;
 
 public:
     FileSystemSMB();
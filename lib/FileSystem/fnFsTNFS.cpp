@@ -18,13 +18,14 @@
 
 FileSystemTNFS fnTNFS;
 
-FileSystemTNFS::FileSystemTNFS()
+FileSystemTNFS::FileSystemTNFS() : _dirstream(&_mountinfo, &_dirlistings)
 {
     // TODO: Maybe allocate space for our TNFS packet so it doesn't have to get put on the stack?
 }
 
 FileSystemTNFS::~FileSystemTNFS()
 {
+    _dirstream.stop();
     if (_started)
         tnfs_umount(&_mountinfo);
 #ifdef ESP_PLATFORM
@@ -283,7 +284,33 @@ bool FileSystemTNFS::dir_open(const char * path, const char *pattern, uint16_t d
     if(diropts & DIR_OPTION_FILEDATE)
         s_opt |= TNFS_DIRSORT_MODIFIED;
 
-    if(TNFS_RESULT_SUCCESS == tnfs_opendirx(&_mountinfo, path, s_opt, d_opt, thepat, 0))
+    // a listing is only reused while the directory's modification time is unchanged
+    tnfsStat tstat;
+    time_t mtime = 0;
+    if(TNFS_RESULT_SUCCESS == tnfs_stat(&_mountinfo, &tstat, path) && tstat.isDir)
+        mtime = tstat.m_time;
+
+    // the listing still being fetched since the last close, one from the cache,
+    // or a new one which the rest of is fetched in the background
+    bool opened = _dirstream.resume(path, pattern, diropts, mtime);
+    if(!opened)
+    {
+        std::shared_ptr<DirListing> listing = _dirlistings.find(path, pattern, diropts, mtime);
+        if(listing != nullptr)
+            opened = !_dirstream.start(listing);
+        else
+        {
+            // the server keeps one directory open per mount
+            _dirstream.stop();
+            if(TNFS_RESULT_SUCCESS == tnfs_opendirx(&_mountinfo, path, s_opt, d_opt, thepat, 0))
+            {
+                opened = !_dirstream.start(std::make_shared<DirListing>(path, pattern, diropts, mtime));
+                _dirstream.prefetch();
+            }
+        }
+    }
+
+    if(opened)
     {
         // Save the directory for later use, making sure it starts and ends with '/''
         if(path[0] != '/')
@@ -313,24 +340,14 @@ fsdir_entry * FileSystemTNFS::dir_read()
     if(!_started)
         return nullptr;
 
-    tnfsStat fstat;
-
-    _direntry.filename[0] = '\0';
-    if(TNFS_RESULT_SUCCESS != tnfs_readdirx(&_mountinfo, &fstat, _direntry.filename, sizeof(_direntry.filename)))
-        return nullptr;
-
-    _direntry.size = fstat.filesize;
-    _direntry.modified_time = fstat.m_time;
-    _direntry.isDir = fstat.isDir;
-
-    return &_direntry;
+    return _dirstream.read();
 }
 
 void FileSystemTNFS::dir_close()
 {
     if(!_started)
         return;
-    tnfs_closedir(&_mountinfo);
+    _dirstream.close();
     _current_dirpath[0] = '\0';
 }
 
@@ -339,11 +356,7 @@ uint16_t FileSystemTNFS::dir_tell()
     if(!_started)
         return FNFS_INVALID_DIRPOS;;
 
-    uint16_t position;
-    if(0 != tnfs_telldir(&_mountinfo, &position))
-        position = FNFS_INVALID_DIRPOS;
-
-    return position;
+    return _dirstream.tell();
 }
 
 bool FileSystemTNFS::dir_seek(uint16_t position)
@@ -351,7 +364,36 @@ bool FileSystemTNFS::dir_seek(uint16_t position)
     if(!_started)
         return false;
 
-    return 0 == tnfs_seekdir(&_mountinfo, position);
+    return _dirstream.seek(position);
+}
+
+// Returns TRUE if an error condition occurred
+bool DirStreamTNFS::fetch_page()
+{
+    tnfsStat fstat;
+    char filename[sizeof(fsdir_entry::filename)];
+
+    // tnfs_readdirx goes to the server once for every TNFS_MAX_DIRCACHE_ENTRIES
+    for(int i = 0; i < DIRSTREAM_PAGE; i++)
+    {
+        filename[0] = '\0';
+        int result = tnfs_readdirx(_mountinfo, &fstat, filename, sizeof(filename));
+        if(result == TNFS_RESULT_END_OF_FILE)
+        {
+            _listing->complete = true;
+            break;
+        }
+        if(result != TNFS_RESULT_SUCCESS)
+            return true;
+
+        _listing->add(filename, fstat.isDir, fstat.filesize, fstat.m_time);
+    }
+    return false;
+}
+
+void DirStreamTNFS::finish()
+{
+    tnfs_closedir(_mountinfo);
 }
 
 #ifdef ESP_PLATFORM
@@ -2,11 +2,27 @@
 #define _FN_FSTNFS_
 
 #include "fnFS.h"
+#include "fnDirStream.h"
 #include "tnfslib.h"
 #ifdef ESP_PLATFORM
 #include <esp_timer.h>
 #endif /* ESP_PLATFORM */
 
+// Pages through the one directory a TNFS mount can have open
+class DirStreamTNFS : public DirStream
+{
+private:
+    tnfsMountInfo *_mountinfo;
+
+protected:
+    bool fetch_page() override;
+    void finish() override;
+
+public:
+    DirStreamTNFS(tnfsMountInfo *mountinfo, DirListingCache *cache) : DirStream(cache), _mountinfo(mountinfo) {};
+    ~DirStreamTNFS() override { stop(); };
+};
+
 class FileSystemTNFS : public FileSystem
 {
 private:
@@ -19,6 +35,9 @@ private:
 #endif
     char _current_dirpath[TNFS_MAX_FILELEN];
 
+    DirListingCache _dirlistings;
+    DirStreamTNFS _dirstream;
+
 public:
     FileSystemTNFS();
     ~FileSystemTNFS();
@@ -194,6 +194,9 @@ void systemBus::op_readex()
     // finally, send the transaction status
     fnDwCom.write(rc);
     fnDwCom.flush();
+
+    if (rc == DISK_CTRL_STATUS_CLEAR)
+        d->read_ahead(lsn);
 }
 
 void systemBus::op_write()
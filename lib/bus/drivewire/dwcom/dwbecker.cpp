@@ -47,7 +47,10 @@ BeckerPort::BeckerPort() :
     _fd(-1),
     _listen_fd(-1),
     _state(&BeckerStopped::getInstance()),
-    _errcount(0)
+    _errcount(0),
+    _rxhead(0),
+    _rxtail(0),
+    _txlen(0)
 {}
 
 BeckerPort::~BeckerPort()
@@ -88,7 +91,7 @@ void BeckerPort::end()
     setState(BeckerStopped::getInstance());
 }
 
-/* Returns number of bytes available in receive buffer or -1 on error
+/* Returns number of bytes available to read without waiting
 */
 int BeckerPort::available()
 {
@@ -96,24 +99,11 @@ int BeckerPort::available()
     if (_state != &BeckerConnected::getInstance())
         return 0;
 
-    // check if socket is still connected
-    if (!connected())
-    {
-        // connection was closed or it has an error
-        suspend_on_disconnect();
-        return 0;
-    }
+    if (_rxhead < _rxtail)
+        return _rxtail - _rxhead;
 
-#if defined(_WIN32)
-    unsigned long count;
-    int res = ioctlsocket(_fd, FIONREAD, &count);
-    res = res != 0 ? -1 : count;
-#else
-    int count;
-    int res = ioctl(_fd, FIONREAD, &count);
-    res = res < 0 ? -1 : count;
-#endif
-    return res;
+    // nothing buffered, take in what has arrived (this notices a closed connection too)
+    return recv_pending();
 }
 
 /* Discards anything in the input buffer
@@ -125,16 +115,14 @@ void BeckerPort::flush_input()
         return;
 
     // waste all input data
-    uint8_t rxbuf[256];
-    int avail;
-    while ((avail = available()) > 0)
+    do
     {
-        recv(_fd, (char *)rxbuf, avail > sizeof(rxbuf) ? sizeof(rxbuf) : avail, 0);
-    }
+        _rxhead = _rxtail = 0;
+    } while (recv_pending() > 0);
 }
 
-/* Clears input buffer and flushes out transmit buffer waiting at most
-   waiting MAX_FLUSH_WAIT_TICKS until all sends are completed
+/* Sends the held output, write_sock() having waited for room for it
+   in the socket buffer
 */
 void BeckerPort::flush()
 {
@@ -142,7 +130,7 @@ void BeckerPort::flush()
     if (_state != &BeckerConnected::getInstance())
         return;
 
-    wait_sock_writable(250);
+    send_pending();
 }
 
 // specific to BeckerPort
@@ -317,6 +305,9 @@ void BeckerPort::make_connection()
         return;
     }
 
+    // before connecting, so the buffer sizes count in the handshake
+    set_connection_options();
+
     // Remote address
     if (_host[0] == '\0')
     {
@@ -390,16 +381,7 @@ bool BeckerPort::accept_connection()
     }
     Debug_printf("BeckerPort: connection from: %s\r\n", inet_ntoa(addr.sin_addr));
 
-    // Set socket options
-    int val = 1;
-    if (setsockopt(_fd, SOL_SOCKET, SO_KEEPALIVE, (char *)&val, sizeof(val)) < 0)
-    {
-        Debug_printf("BeckerPort warning: failed to set KEEPALIVE on socket\n");
-    }
-    if (setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, (char *)&val, sizeof(val)) < 0)
-    {
-        Debug_printf("BeckerPort warning: failed to set NODELAY on socket\n");
-    }
+    set_connection_options();
 
     // Set socket non-blocking
     if (!compat_socket_set_nonblocking(_fd))
@@ -418,6 +400,41 @@ bool BeckerPort::accept_connection()
     return true;
 }
 
+// Socket options of a new connection, which starts with empty buffers
+void BeckerPort::set_connection_options()
+{
+    int val = 1;
+    if (setsockopt(_fd, SOL_SOCKET, SO_KEEPALIVE, (char *)&val, sizeof(val)) < 0)
+    {
+        Debug_printf("BeckerPort warning: failed to set KEEPALIVE on socket\n");
+    }
+    if (setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, (char *)&val, sizeof(val)) < 0)
+    {
+        Debug_printf("BeckerPort warning: failed to set NODELAY on socket\n");
+    }
+
+#ifndef ESP_PLATFORM
+    // Only ever make the socket buffers bigger, setting them turns off the
+    // host's own tuning of them
+    int opts[] = {SO_RCVBUF, SO_SNDBUF};
+    for (int opt : opts)
+    {
+        int size = 0;
+        socklen_t len = (socklen_t)sizeof(size);
+        if (getsockopt(_fd, SOL_SOCKET, opt, (char *)&size, &len) == 0 && size >= BECKER_SOCKBUF_SIZE)
+            continue;
+        size = BECKER_SOCKBUF_SIZE;
+        if (setsockopt(_fd, SOL_SOCKET, opt, (char *)&size, sizeof(size)) < 0)
+        {
+            Debug_printf("BeckerPort warning: failed to set %s on socket\n", opt == SO_RCVBUF ? "RCVBUF" : "SNDBUF");
+        }
+    }
+#endif
+
+    _rxhead = _rxtail = 0;
+    _txlen = 0;
+}
+
 void BeckerPort::suspend(int short_ms, int long_ms, int threshold)
 {
     if (_fd >= 0)
@@ -476,16 +493,20 @@ bool BeckerPort::suspend_period_expired()
     return (fnSystem.millis() - _suspend_time > _suspend_period);
 }
 
-bool BeckerPort::connected()
+/* Takes whatever has arrived on the socket into the empty receive buffer,
+   without waiting. A closed connection or an error suspends the port.
+   Returns the number of bytes taken in
+*/
+int BeckerPort::recv_pending()
 {
-    uint8_t dummy;
-    bool con = false;
-    int res = recv(_fd, (char *)&dummy, 1, MSG_PEEK);
+    int res = recv(_fd, (char *)_rxbuf, sizeof(_rxbuf), 0);
     if (res > 0)
     {
-        con = true;
+        _rxhead = 0;
+        _rxtail = res;
+        return res;
     }
-    else if (res == 0)
+    if (res == 0)
     {
         Debug_print("### BeckerPort disconnected ###\n");
     }
@@ -500,24 +521,54 @@ bool BeckerPort::connected()
         case EWOULDBLOCK:
         case ENOENT: // Caused by VFS
 #endif
-            con = true;
-            break;
+            return 0;
         default:
             Debug_printf("BeckerPort: connection error: %d - %s\n", 
                 compat_getsockerr(), compat_sockstrerror(err));
             break;
         }
     }
-    return con;
+    // connection was closed or it has an error
+    suspend_on_disconnect();
+    return 0;
 }
 
-bool BeckerPort::poll_connection(int ms)
+/* Waits for input and takes in all that has arrived, so a request and
+   anything the emulator has sent behind it come in with one recv()
+   Returns FALSE on timeout or when the connection went away
+*/
+bool BeckerPort::fill_rxbuf()
 {
-    if (wait_sock_readable(ms) && !connected())
+    // what is being waited for may be the answer to output still held here,
+    // in which case it won't have arrived yet
+    bool answer = _txlen > 0;
+    if (!send_pending())
+        return false;
+
+    if (!answer)
     {
-        // connection was closed or it has an error
-        suspend_on_disconnect();
+        if (recv_pending() > 0)
+            return true;
+        if (_state != &BeckerConnected::getInstance())
+            return false;
     }
+
+    ssize_t result = read_sock(_rxbuf, sizeof(_rxbuf));
+    if (result <= 0)
+        return false;
+    _rxhead = 0;
+    _rxtail = result;
+    return true;
+}
+
+bool BeckerPort::poll_connection(int ms)
+{
+    if (!send_pending())
+        return false;
+
+    // wake as soon as input arrives and take it in, which notices a closed connection too
+    if (_rxhead == _rxtail && wait_sock_readable(ms))
+        recv_pending();
     return false;
 }
 
@@ -531,23 +582,55 @@ timeval BeckerPort::timeval_from_ms(const uint32_t millis)
 
 size_t BeckerPort::do_read(uint8_t *buffer, size_t size)
 {
-    int result;
-    int to_recv;
-    int rxbytes = 0;
+    size_t rxbytes = 0;
 
     while (rxbytes < size)
     {
-        to_recv = size - rxbytes;
-        result = read_sock(buffer+rxbytes, to_recv);
-        if (result > 0)
-            rxbytes += result;
-        else // result <= 0 for disconnected or write error
-            break;
+        if (_rxhead == _rxtail && !fill_rxbuf())
+            break; // timeout, disconnected or read error
+
+        size_t n = _rxtail - _rxhead;
+        if (n > size - rxbytes)
+            n = size - rxbytes;
+        memcpy(buffer + rxbytes, _rxbuf + _rxhead, n);
+        _rxhead += n;
+        rxbytes += n;
     }
     return rxbytes;
 }
 
+/* Output is held until the port waits for input, is flushed or polled,
+   or the buffer fills, so a reply made of several writes goes out as one
+   segment
+*/
 ssize_t BeckerPort::do_write(const uint8_t *buffer, size_t size)
+{
+    if (_txlen + size > sizeof(_txbuf) && !send_pending())
+        return -1;
+
+    // too big to hold, send it as it is
+    if (size > sizeof(_txbuf))
+        return send_all(buffer, size);
+
+    memcpy(_txbuf + _txlen, buffer, size);
+    _txlen += size;
+    return size;
+}
+
+/* Sends the held output, dropping it if the connection fails
+   Returns FALSE if not all of it could be sent
+*/
+bool BeckerPort::send_pending()
+{
+    if (_txlen == 0)
+        return true;
+
+    size_t len = _txlen;
+    _txlen = 0;
+    return send_all(_txbuf, len) == (ssize_t)len;
+}
+
+ssize_t BeckerPort::send_all(const uint8_t *buffer, size_t size)
 {
     int result;
     int to_send;
@@ -590,6 +673,22 @@ ssize_t BeckerPort::read_sock(const uint8_t *buffer, size_t size, uint32_t timeo
 
 ssize_t BeckerPort::write_sock(const uint8_t *buffer, size_t size, uint32_t timeout_ms)
 {
+    // the socket is non-blocking, only wait for it when its buffer is full
+    ssize_t result = send(_fd, (char *)buffer, size, 0);
+    if (result >= 0)
+        return result;
+    int err = compat_getsockerr();
+#if defined(_WIN32)
+    if (err != WSAEWOULDBLOCK)
+#else
+    if (err != EWOULDBLOCK && err != EAGAIN)
+#endif
+    {
+        Debug_printf("BeckerPort write_sock() error %d: %s\n", err, compat_sockstrerror(err));
+        suspend_on_disconnect();
+        return result;
+    }
+
     if (!wait_sock_writable(timeout_ms))
     {
         int err = compat_getsockerr();
@@ -608,7 +707,7 @@ ssize_t BeckerPort::write_sock(const uint8_t *buffer, size_t size, uint32_t time
         return -1;
     }
 
-    ssize_t result = send(_fd, (char *)buffer, size, 0);
+    result = send(_fd, (char *)buffer, size, 0);
     if (result < 0)
     {
         Debug_printf("BeckerPort write_sock() error %d: %s\n", 
@@ -12,6 +12,13 @@
 #define BECKER_CONNECT_TMOUT    2000
 #define BECKER_SUSPEND_MS       5000
 
+// Bytes the port gathers on each side of the connection: a READ/WRITE request
+// with its sector fits the receive buffer, so it comes in with one recv()
+#define BECKER_RXBUF_SIZE       1024
+#define BECKER_TXBUF_SIZE       512
+// Socket buffers asked for on the host, lwIP sizes its own from sdkconfig
+#define BECKER_SOCKBUF_SIZE     65536
+
 class BeckerPort;
 
 class BeckerState
@@ -106,11 +113,20 @@ private:
 #endif
     int _suspend_period;
 
+    // Input taken off the socket and not read yet is _rxbuf[_rxhead.._rxtail),
+    // output not sent yet is _txbuf[0.._txlen)
+    uint8_t _rxbuf[BECKER_RXBUF_SIZE];
+    size_t _rxhead;
+    size_t _rxtail;
+    uint8_t _txbuf[BECKER_TXBUF_SIZE];
+    size_t _txlen;
+
 protected:
 	void start_connection();
 	void listen_for_connection();
 	void make_connection();
 	bool accept_connection();
+	void set_connection_options();
 
 	void suspend(int short_ms, int long_ms=0, int threshold=0);
 	void suspend_on_disconnect();
@@ -119,9 +135,13 @@ protected:
 
 	bool accept_pending_connection(int ms);
 
-	bool connected();
 	bool poll_connection(int ms);
 
+	int recv_pending();
+	bool fill_rxbuf();
+	bool send_pending();
+	ssize_t send_all(const uint8_t *buffer, size_t size);
+
 	static timeval timeval_from_ms(const uint32_t millis);
 
 	size_t do_read(uint8_t *buffer, size_t size);
@@ -31,6 +31,9 @@ enum {
   SP_CMD_CLOSE	= 0x07,
   SP_CMD_READ	= 0x08,
   SP_CMD_WRITE	= 0x09,
+  // #FujiNet extensions, only over SLIP
+  SP_CMD_READBLOCKS	= 0x0B,
+  SP_CMD_WRITEBLOCKS	= 0x0C,
 };
 
 // see page 81-82 in Apple IIc ROM reference and Table 7-5 in IIgs firmware ref
@@ -133,6 +136,7 @@ union cmdFrame_t
 
 #define BLOCK_DATA_LEN      512
 #define MAX_DATA_LEN        767
+#define SP_MAX_BLOCKS       16  // most blocks moved by one SP_CMD_READBLOCKS or SP_CMD_WRITEBLOCKS
 
 union iwm_decoded_cmd_t
 {
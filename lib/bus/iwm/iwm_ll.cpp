@@ -5,10 +5,12 @@
 #include <string.h>
 
 #include "esp_rom_gpio.h"
+#include "esp_timer.h"
 #include "soc/spi_periph.h"
 
 #include "iwm_ll.h"
 #include "iwm.h"
+#include "iwm_sp_codec.h"
 #include "../device/iwm/disk2.h"
 #include "../device/iwm/fuji.h"
 #include "fnSystem.h"
@@ -146,33 +148,9 @@ inline void iwm_ll::iwm_extra_clr()
 
 void IRAM_ATTR iwm_sp_ll::encode_spi_packet()
 {
-  // clear out spi buffer
-  memset(spi_buffer, 0, SPI_SP_LEN);
-  // loop through "l" bytes of the buffer "packet_buffer"
-  uint16_t i=0,j=0;
-  while(packet_buffer[i])
-  {
-    // Debug_printf("\nByte %02X: ",packet_buffer[i]);
-    // for each byte, loop through 4 x 2-bit pairs
-    uint8_t mask = 0x80;
-    for (int k = 0; k < 4; k++)
-    {
-      if (packet_buffer[i] & mask)
-      {
-        spi_buffer[j] |= 0x40;
-      }
-      mask >>= 1;
-      if (packet_buffer[i] & mask)
-      {
-        spi_buffer[j] |= 0x04;
-      }
-      mask >>= 1;
-      // Debug_printf("%02x",spi_buffer[j]);
-      j++;
-    }
-    i++;
-  }
-  spi_len = --j;
+  // every sample byte up to spi_len is written, so no need to clear the buffer first.
+  // the last one, the low bits of the 0xc8 end byte, isn't sent
+  spi_len = sp_encode_spi(spi_buffer, packet_buffer) - 1;
 }
 
 
@@ -676,48 +654,12 @@ void iwm_sp_ll::encode_packet(uint8_t source, iwm_packet_type_t packet_type, uin
 
   if ((data != nullptr) && (num != 0))
   {
-  int grpbyte, grpcount;
-  uint8_t grpmsb;
-  uint8_t group_buffer[7];
-                                    // Calculate checksum of sector bytes before we destroy them
-    for (int count = 0; count < num; count++) // xor all the data bytes
-      checksum = checksum ^ data[count];
-
-    // Start assembling the packet at the rear and work
-    // your way to the front so we don't overwrite data
-    // we haven't encoded yet
-
     // how many groups of 7?
     numgrps = num / 7;
     numodds = num % 7;
 
-    // grps of 7
-    for (grpcount = numgrps - 1; grpcount >= 0; grpcount--) // 73
-    {
-      memcpy(group_buffer, data + numodds + (grpcount * 7), 7);
-      // add group msb byte
-      grpmsb = 0;
-      for (grpbyte = 0; grpbyte < 7; grpbyte++)
-        grpmsb = grpmsb | ((group_buffer[grpbyte] >> (grpbyte + 1)) & (0x80 >> (grpbyte + 1)));
-      // groups start after odd bytes, which is at 13 + numodds + (numodds != 0) + 1
-      int grpstart = 13 + numodds + (numodds != 0) + 1;
-      packet_buffer[grpstart + (grpcount * 8)] = grpmsb | 0x80; // set msb to one
-
-      // now add the group data bytes bits 6-0
-      for (grpbyte = 0; grpbyte < 7; grpbyte++)
-        packet_buffer[grpstart + 1 + (grpcount * 8) + grpbyte] = group_buffer[grpbyte] | 0x80;
-    }
-
-    // oddbytes
-    if(numodds)
-    {
-      packet_buffer[14] = 0x80; // init the oddmsb
-      for (int oddcnt = 0; oddcnt < numodds; oddcnt++)
-      {
-        packet_buffer[14] |= (data[oddcnt] & 0x80) >> (1 + oddcnt);
-        packet_buffer[15 + oddcnt] = data[oddcnt] | 0x80;
-      }
-    }
+    // odd bytes and groups go after the header, checksumming the data on the way
+    sp_encode_data(&packet_buffer[14], data, num, checksum);
   }
 
   // header
@@ -763,11 +705,8 @@ size_t iwm_sp_ll::decode_data_packet(uint8_t* output_data)
 
 size_t iwm_sp_ll::decode_data_packet(uint8_t* input_data, uint8_t* output_data)
 {
-  int grpbyte, grpcount;
   uint8_t numgrps, numodd;
   size_t numdata;
-  uint8_t bit0to6, bit7;
-  uint8_t group_buffer[8];
 
   //Handle arbitrary length packets :)
   numodd = input_data[11] & 0x7f;
@@ -775,23 +714,8 @@ size_t iwm_sp_ll::decode_data_packet(uint8_t* input_data, uint8_t* output_data)
   numdata = numodd + numgrps * 7;
   Debug_printf("\nDecoding %d bytes",numdata);
 
-  // decode oddbyte(s), 1 in a 512 data packet
-  for(int i = 0; i < numodd; i++){
-    output_data[i] = ((input_data[13] << (i+1)) & 0x80) | (input_data[14+i] & 0x7f);
-  }
-
-  // decode groups of 7, 73 grps of 7 in a 512 byte packet
-  int grpstart = 12 + numodd + (numodd != 0) + 1;
-  for (grpcount = 0; grpcount < numgrps; grpcount++)
-  {
-    memcpy(group_buffer, input_data + grpstart + (grpcount * 8), 8);
-    for (grpbyte = 0; grpbyte < 7; grpbyte++)
-    {
-      bit7 = (group_buffer[0] << (grpbyte + 1)) & 0x80;
-      bit0to6 = (group_buffer[grpbyte + 1]) & 0x7f;
-      output_data[numodd + (grpcount * 7) + grpbyte] = bit7 | bit0to6;
-    }
-  }
+  // oddbyte(s) then groups of 7, 1 and 73 in a 512 byte packet
+  sp_decode_data(output_data, &input_data[13], numodd, numgrps);
 
   return numdata;
 }
@@ -831,7 +755,8 @@ void iwm_diskii_ll::start(uint8_t drive)
 {
   diskii_xface.set_output_to_rmt();
   diskii_xface.enable_output();
-  ESP_ERROR_CHECK(fnRMT.rmt_write_bitstream(RMT_TX_CHANNEL, track_buffer, track_numbits, track_bit_period));
+  // the translator reads through nextbit(), src only has to be there
+  ESP_ERROR_CHECK(fnRMT.rmt_write_bitstream(RMT_TX_CHANNEL, ring[0].data, track_numbits, track_bit_period));
   fnLedManager.set(LED_BUS, true);
   Debug_printf("\nstart diskII d%d",drive+1);
 }
@@ -987,9 +912,12 @@ void IRAM_ATTR encode_rmt_bitstream(const void* src, rmt_item32_t* dest, size_t
 void iwm_diskii_ll::setup_rmt()
 {
 #define RMT_TX_CHANNEL rmt_channel_t::RMT_CHANNEL_0
-  track_buffer = (uint8_t *)heap_caps_malloc(TRACK_LEN, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-  if (track_buffer == NULL)
-    Debug_println("could not allocate track buffer");
+  for (int i = 0; i < DISKII_RING_SLOTS; i++)
+  {
+    ring[i].data = (uint8_t *)heap_caps_malloc(TRACK_LEN, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (ring[i].data == NULL)
+      Debug_println("could not allocate track buffer");
+  }
 
   config.rmt_mode = rmt_mode_t::RMT_MODE_TX;
   config.channel = RMT_TX_CHANNEL;
@@ -1018,8 +946,10 @@ bool IRAM_ATTR iwm_diskii_ll::nextbit()
   int track_byte_ctr = track_location / 8;
   int track_bit_ctr = track_location % 8;
 
-  bool outbit;
-  outbit = (track_buffer[track_byte_ctr] & (0x80 >> track_bit_ctr)) != 0; // bits go MSB first
+  bool outbit = false;
+  uint8_t *buffer = track_buffer;
+  if (buffer != nullptr)
+    outbit = (buffer[track_byte_ctr] & (0x80 >> track_bit_ctr)) != 0; // bits go MSB first
 
   track_location++;
   if (track_location >= track_numbits)
@@ -1057,21 +987,170 @@ bool IRAM_ATTR iwm_diskii_ll::fakebit()
   return (MC3470[MC3470_byte_ctr] & (0x01 << MC3470_bit_ctr)) != 0;
 }
 
-void IRAM_ATTR iwm_diskii_ll::copy_track(uint8_t *track, size_t tracklen, size_t trackbits, int bitperiod)
+int IRAM_ATTR iwm_diskii_ll::find_slot(const void *disk, uint8_t track)
 {
-  // copy track from SPIRAM to INTERNAL RAM
-  if (track != nullptr)
-    memcpy(track_buffer, track, tracklen);
-  else
-    memset(track_buffer, 0, tracklen);
+  for (int i = 0; i < DISKII_RING_SLOTS; i++)
+    if (ring[i].ready && ring[i].disk == disk && ring[i].track == track)
+      return i;
+  return -1;
+}
+
+// Call with ring_mux held
+void IRAM_ATTR iwm_diskii_ll::go_live(int slot)
+{
+  size_t numbits = (slot < 0) ? BLANK_TRACK_LEN * 8 : ring[slot].numbits;
 
   // new_position = current_position * new_track_length / current_track_length
-  track_location *= trackbits;
+  track_location *= numbits;
   track_location /= track_numbits;
   // update track info
-  track_numbytes = tracklen;
-  track_numbits = trackbits;
+  track_buffer = (slot < 0) ? nullptr : ring[slot].data;
+  track_numbytes = (slot < 0) ? BLANK_TRACK_LEN : ring[slot].numbytes;
+  track_numbits = numbits;
+  ring_live = slot;
+}
+
+// Call with ring_mux held
+void IRAM_ATTR iwm_diskii_ll::count_latency(int64_t since)
+{
+  uint32_t us = esp_timer_get_time() - since;
+  ring_counters.last_us = us;
+  ring_counters.total_us += us;
+  if (us > ring_counters.max_us)
+    ring_counters.max_us = us;
+}
+
+bool IRAM_ATTR iwm_diskii_ll::select_track(const void *disk, uint8_t track, int bitperiod)
+{
+  int64_t start = esp_timer_get_time();
+  bool missed = false;
+
+  portENTER_CRITICAL_SAFE(&ring_mux);
   track_bit_period = bitperiod;
+  pending_disk = nullptr;
+  ring_counters.changes++;
+
+  int slot = find_slot(disk, track);
+  if (track == DISKII_NO_TRACK)
+  {
+    go_live(-1);
+  }
+  else if (slot >= 0)
+  {
+    go_live(slot);
+    ring_counters.hits++;
+    count_latency(start);
+  }
+  else
+  {
+    // blank until the prefetch task has it
+    go_live(-1);
+    pending_disk = disk;
+    pending_track = track;
+    pending_since = start;
+    ring_counters.underruns++;
+    missed = true;
+  }
+  portEXIT_CRITICAL_SAFE(&ring_mux);
+
+  return missed;
+}
+
+bool iwm_diskii_ll::has_track(const void *disk, uint8_t track)
+{
+  portENTER_CRITICAL(&ring_mux);
+  bool found = find_slot(disk, track) >= 0;
+  portEXIT_CRITICAL(&ring_mux);
+  return found;
+}
+
+int iwm_diskii_ll::claim_slot(const void *disk, const uint8_t *wanted, int count)
+{
+  int slot = -1;
+
+  portENTER_CRITICAL(&ring_mux);
+  for (int i = 0; i < DISKII_RING_SLOTS && slot < 0; i++)
+  {
+    if (i == ring_live || ring[i].data == nullptr)
+      continue;
+    if (!ring[i].ready || ring[i].disk != disk)
+    {
+      slot = i;
+      break;
+    }
+    bool keep = false;
+    for (int w = 0; w < count; w++)
+      keep = keep || (ring[i].track == wanted[w]);
+    if (!keep)
+      slot = i;
+  }
+  if (slot >= 0)
+    ring[slot].ready = false;
+  portEXIT_CRITICAL(&ring_mux);
+
+  return slot;
+}
+
+void iwm_diskii_ll::fill_slot(int slot, const void *disk, uint8_t track, const uint8_t *data, size_t numbytes, size_t numbits)
+{
+  // WOZ tracks are padded out to whole blocks, past TRACK_LEN
+  if (numbytes > TRACK_LEN)
+    numbytes = TRACK_LEN;
+  if (numbits > numbytes * 8)
+    numbits = numbytes * 8;
+
+  // nobody else touches a claimed slot
+  if (data != nullptr)
+    memcpy(ring[slot].data, data, numbytes);
+  else
+    memset(ring[slot].data, 0, numbytes);
+
+  portENTER_CRITICAL(&ring_mux);
+  ring[slot].disk = disk;
+  ring[slot].track = track;
+  ring[slot].numbytes = numbytes;
+  ring[slot].numbits = numbits;
+  ring[slot].ready = true;
+  ring_counters.fills++;
+  if (pending_disk == disk && pending_track == track)
+  {
+    go_live(slot);
+    count_latency(pending_since);
+    pending_disk = nullptr;
+  }
+  portEXIT_CRITICAL(&ring_mux);
+}
+
+void iwm_diskii_ll::forget(const void *disk)
+{
+  portENTER_CRITICAL(&ring_mux);
+  for (int i = 0; i < DISKII_RING_SLOTS; i++)
+  {
+    if (ring[i].disk != disk)
+      continue;
+    if (i == ring_live)
+      go_live(-1);
+    ring[i].ready = false;
+    ring[i].disk = nullptr;
+  }
+  if (pending_disk == disk)
+    pending_disk = nullptr;
+  portEXIT_CRITICAL(&ring_mux);
+}
+
+diskii_ring_counters iwm_diskii_ll::get_counters()
+{
+  portENTER_CRITICAL(&ring_mux);
+  diskii_ring_counters c = ring_counters;
+  portEXIT_CRITICAL(&ring_mux);
+  return c;
+}
+
+void iwm_diskii_ll::reset_counters()
+{
+  portENTER_CRITICAL(&ring_mux);
+  ring_counters = {};
+  portEXIT_CRITICAL(&ring_mux);
 }
 
 uint8_t IRAM_ATTR iwm_diskii_ll::iwm_enable_states()
@@ -17,6 +17,7 @@
 
 // #define SPI_II_LEN 27000        // 200 ms at 1 mbps for disk ii + some extra
 #define TRACK_LEN 6646          // https://applesaucefdc.com/woz/reference2/
+#define BLANK_TRACK_LEN 6400    // what goes out when there's no track, see iwmDisk2::change_track()
 #define SPI_SP_LEN 6000         // should be long enough for 20.1 ms (for SoftSP) + some margin - call it 22 ms. 2051282*.022 =  45128.204 bits / 8 = 5641.0255 bytes
 #define BLOCK_PACKET_LEN    604 //606
 
@@ -268,19 +269,61 @@ public:
 // move "swithc to SPI" into send data spi routine (enable / disable output using spi fix - no external tristate)
 // done - move disable output into disk ii stop
 // figure out how to make it all work for three cases: (1) original, (2) spi fix, (3) bypassed buffer
+
+// Tracks ready to go out: the one under the head and its neighbours
+#define DISKII_RING_SLOTS 3
+// trackmap() value for no track, blank bits go out
+#define DISKII_NO_TRACK 0xFF
+
+struct diskii_ring_slot
+{
+  uint8_t *data = nullptr;      // TRACK_LEN of internal RAM
+  const void *disk = nullptr;   // MediaType the track came from
+  uint8_t track = DISKII_NO_TRACK;
+  bool ready = false;           // false while empty or being filled
+  size_t numbytes = 0;
+  size_t numbits = 0;
+};
+
+struct diskii_ring_counters
+{
+  uint32_t changes;             // track changes asked for
+  uint32_t hits;                // the track was in the ring already
+  uint32_t underruns;           // it wasn't, blank bits went out until it was
+  uint32_t fills;               // tracks copied into the ring
+  uint32_t last_us;             // from a change until its track was going out
+  uint32_t max_us;
+  uint64_t total_us;
+};
+
 class iwm_diskii_ll : public iwm_ll
 {
 private:
   // RMT data handling
   fn_rmt_config_t config;
 
-  // track bit information
+  // track bit information, track_buffer is nullptr while blank bits go out
   uint8_t* track_buffer = nullptr; // 
-  size_t track_numbits = 6400 * 8;
-  size_t track_numbytes = 6400;
+  size_t track_numbits = BLANK_TRACK_LEN * 8;
+  size_t track_numbytes = BLANK_TRACK_LEN;
   size_t track_location = 0;
   int track_bit_period = 4000;
 
+  // Track changes swap track_buffer between the slots, which the prefetch
+  // task in iwmDisk2 fills. Every slot is TRACK_LEN, so a swap seen half done
+  // by the RMT translator can't take it off the end of a buffer.
+  diskii_ring_slot ring[DISKII_RING_SLOTS];
+  int ring_live = -1;           // slot going out, -1 if none
+  const void *pending_disk = nullptr; // track waited for after an underrun
+  uint8_t pending_track = DISKII_NO_TRACK;
+  int64_t pending_since = 0;
+  diskii_ring_counters ring_counters = {};
+  portMUX_TYPE ring_mux = portMUX_INITIALIZER_UNLOCKED;
+
+  int find_slot(const void *disk, uint8_t track);
+  void go_live(int slot);
+  void count_latency(int64_t since);
+
   void set_output_to_rmt();
 
   bool enabledD2 = true;
@@ -298,7 +341,22 @@ public:
 
   bool nextbit();
   bool fakebit();
-  void copy_track(uint8_t *track, size_t tracklen, size_t trackbits, int bitperiod);
+
+  // Safe from the phase ISR. Puts the track out if the ring has it, or blank
+  // bits until the prefetch task fills it.
+  // Returns TRUE if the track wasn't ready
+  bool select_track(const void *disk, uint8_t track, int bitperiod);
+  bool has_track(const void *disk, uint8_t track);
+  // A slot holding none of the wanted tracks, taken out of use for filling, or -1
+  int claim_slot(const void *disk, const uint8_t *wanted, int count);
+  // Copies a track into a claimed slot, data nullptr for a blank one. It goes
+  // out straight away if the head is waiting on it.
+  void fill_slot(int slot, const void *disk, uint8_t track, const uint8_t *data, size_t numbytes, size_t numbits);
+  // Drops the disk's tracks, before it goes away
+  void forget(const void *disk);
+
+  diskii_ring_counters get_counters();
+  void reset_counters();
 
   void set_output_to_low();
 
@@ -64,17 +64,12 @@ void iwm_slip::end_request_thread()
 {
 	std::cout << "Ending request thread" << std::endl;
 	// stop listening for requests, and stop the connection.
-	is_responding_ = false;
 	if (connection_)
 	{
 		connection_->set_is_connected(false);
 		connection_->join();
 		connection_->close_connection();
 	}
-	if (request_thread_.joinable())
-	{
-		request_thread_.join();
-	}
 	connection_ = nullptr;
 }
 
@@ -117,9 +112,6 @@ void iwm_slip::setup_spi()
 				std::cout << "." << std::flush;
 			}
 			std::this_thread::sleep_for(std::chrono::milliseconds(100)); // pause for 0.1s every loop around. keeps it slightly less busy.
-		} else {
-			is_responding_ = true;
-			request_thread_ = std::thread(&iwm_slip::wait_for_requests, this);
 		}
 	}
 	std::cout << std::endl << "iwm_slip::setup_spi - connection to server successful" << std::endl;
@@ -138,24 +130,31 @@ uint8_t iwm_slip::iwm_phase_vector()
 		return PHASE_RESET;
 	}
 
-	// Lock the mutex before accessing the queue
-	std::lock_guard<std::mutex> lock(queue_mutex_);
-
-	// Check for a new Request Packet on the transport layer
-	if (request_queue_.empty())
+	// Check for a new Request Packet on the transport layer.
+	// The connection's reading thread puts them in a ring that is read here without locking.
+	const std::vector<uint8_t> *request_data = connection_->peek_request();
+	if (request_data == nullptr)
 	{
 		sp_command_mode = sp_cmd_state_t::standby;
 		return PHASE_IDLE;
 	}
 
-	// create a Request object from the data
-	std::vector<uint8_t> request_data = request_queue_.front();
-	request_queue_.pop();
-	current_request = Request::from_packet(request_data);
+	// create a Request object from the data, dropping frames that are too short or not understood
+	try
+	{
+		current_request = Request::from_packet(*request_data);
+	} catch (const std::runtime_error &e)
+	{
+		std::cerr << "iwm_slip::iwm_read_packet_spi ERROR bad request: " << e.what() << std::endl;
+		connection_->pop_request();
+		sp_command_mode = sp_cmd_state_t::standby;
+		return PHASE_IDLE;
+	}
 
 	std::fill(std::begin(IWM.command_packet.data), std::end(IWM.command_packet.data), 0);
 	// The request data is the raw bytes of the request object, we're only really interested in the header part
-	std::copy(request_data.begin(), request_data.begin() + 8, IWM.command_packet.data);
+	std::copy_n(request_data->begin(), std::min<size_t>(request_data->size(), COMMAND_LEN), IWM.command_packet.data);
+	connection_->pop_request();
 
 	// signal we have a command to process
 	sp_command_mode = sp_cmd_state_t::command;
@@ -233,29 +232,6 @@ size_t iwm_slip::decode_data_packet(uint8_t *input_data, uint8_t *output_data)
 	return 0; // unused
 }
 
-void iwm_slip::wait_for_requests()
-{
-	while (is_responding_)
-	{
-		auto request_data = connection_->wait_for_request();
-		if (!request_data.empty())
-		{
-			// int chars_to_print = request_data.size();
-			// if (chars_to_print > 32)
-			// 	chars_to_print = 32;
-			// std::string msg = util_hexdump(request_data.data(), chars_to_print);
-			// printf("\nNEW Request data:\n%s\n", msg.c_str());
-			// if (chars_to_print != request_data.size())
-			// {
-			// 	printf("... truncated\n");
-			// }
-
-			std::lock_guard<std::mutex> lock(queue_mutex_);
-			request_queue_.push(request_data);
-		}
-	}
-}
-
 void iwm_slip::restart()
 {
 	std::cout << "iwm_slip::restarting" << std::endl;
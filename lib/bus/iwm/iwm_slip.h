@@ -6,7 +6,6 @@
 #include <cstdint>
 #include <thread>
 #include <atomic>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <unordered_map>
@@ -82,17 +81,11 @@ public:
 	connector_com connector;
 #endif
 
-	void wait_for_requests();
 	void end_request_thread();
 
 	uint8_t packet_buffer[PACKET_LEN];
 	size_t packet_size;
 	std::shared_ptr<Connection> connection_ = nullptr;
-	std::thread request_thread_;
-	std::atomic<bool> is_responding_{false};
-
-	std::queue<std::vector<uint8_t>> request_queue_;
-	std::mutex queue_mutex_;
 
 	std::unique_ptr<Request> current_request;
 	std::unique_ptr<Response> current_response;
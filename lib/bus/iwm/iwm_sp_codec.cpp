@@ -0,0 +1,145 @@
+#include "iwm_sp_codec.h"
+
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define IRAM_ATTR
+#define DRAM_ATTR
+#endif
+
+// Groups are moved 7 bytes at a time in a 64 bit word, first byte lowest
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "SmartPort packet coding assumes a little-endian CPU"
+#endif
+
+#define GROUP_LOW_BITS 0x007f7f7f7f7f7f7fULL
+#define GROUP_HIGH_BITS 0x0080808080808080ULL
+// Multiplying by these moves bit 7 of group byte n to bit 62 - n, and back
+// from bit 6 - n of the high bit byte to bit 7 of byte n. No two partial
+// products land on the same bit, so nothing carries.
+#define GATHER_HIGH_BITS 0x4020100804020100ULL
+#define SCATTER_HIGH_BITS 0x0080402010080402ULL
+
+// SPI samples for each packet byte, the sample for bits 7 and 6 in the low byte
+static const DRAM_ATTR uint32_t sp_spi_samples[256] = {
+    0x00000000, 0x04000000, 0x40000000, 0x44000000, 0x00040000, 0x04040000, 0x40040000, 0x44040000,
+    0x00400000, 0x04400000, 0x40400000, 0x44400000, 0x00440000, 0x04440000, 0x40440000, 0x44440000,
+    0x00000400, 0x04000400, 0x40000400, 0x44000400, 0x00040400, 0x04040400, 0x40040400, 0x44040400,
+    0x00400400, 0x04400400, 0x40400400, 0x44400400, 0x00440400, 0x04440400, 0x40440400, 0x44440400,
+    0x00004000, 0x04004000, 0x40004000, 0x44004000, 0x00044000, 0x04044000, 0x40044000, 0x44044000,
+    0x00404000, 0x04404000, 0x40404000, 0x44404000, 0x00444000, 0x04444000, 0x40444000, 0x44444000,
+    0x00004400, 0x04004400, 0x40004400, 0x44004400, 0x00044400, 0x04044400, 0x40044400, 0x44044400,
+    0x00404400, 0x04404400, 0x40404400, 0x44404400, 0x00444400, 0x04444400, 0x40444400, 0x44444400,
+    0x00000004, 0x04000004, 0x40000004, 0x44000004, 0x00040004, 0x04040004, 0x40040004, 0x44040004,
+    0x00400004, 0x04400004, 0x40400004, 0x44400004, 0x00440004, 0x04440004, 0x40440004, 0x44440004,
+    0x00000404, 0x04000404, 0x40000404, 0x44000404, 0x00040404, 0x04040404, 0x40040404, 0x44040404,
+    0x00400404, 0x04400404, 0x40400404, 0x44400404, 0x00440404, 0x04440404, 0x40440404, 0x44440404,
+    0x00004004, 0x04004004, 0x40004004, 0x44004004, 0x00044004, 0x04044004, 0x40044004, 0x44044004,
+    0x00404004, 0x04404004, 0x40404004, 0x44404004, 0x00444004, 0x04444004, 0x40444004, 0x44444004,
+    0x00004404, 0x04004404, 0x40004404, 0x44004404, 0x00044404, 0x04044404, 0x40044404, 0x44044404,
+    0x00404404, 0x04404404, 0x40404404, 0x44404404, 0x00444404, 0x04444404, 0x40444404, 0x44444404,
+    0x00000040, 0x04000040, 0x40000040, 0x44000040, 0x00040040, 0x04040040, 0x40040040, 0x44040040,
+    0x00400040, 0x04400040, 0x40400040, 0x44400040, 0x00440040, 0x04440040, 0x40440040, 0x44440040,
+    0x00000440, 0x04000440, 0x40000440, 0x44000440, 0x00040440, 0x04040440, 0x40040440, 0x44040440,
+    0x00400440, 0x04400440, 0x40400440, 0x44400440, 0x00440440, 0x04440440, 0x40440440, 0x44440440,
+    0x00004040, 0x04004040, 0x40004040, 0x44004040, 0x00044040, 0x04044040, 0x40044040, 0x44044040,
+    0x00404040, 0x04404040, 0x40404040, 0x44404040, 0x00444040, 0x04444040, 0x40444040, 0x44444040,
+    0x00004440, 0x04004440, 0x40004440, 0x44004440, 0x00044440, 0x04044440, 0x40044440, 0x44044440,
+    0x00404440, 0x04404440, 0x40404440, 0x44404440, 0x00444440, 0x04444440, 0x40444440, 0x44444440,
+    0x00000044, 0x04000044, 0x40000044, 0x44000044, 0x00040044, 0x04040044, 0x40040044, 0x44040044,
+    0x00400044, 0x04400044, 0x40400044, 0x44400044, 0x00440044, 0x04440044, 0x40440044, 0x44440044,
+    0x00000444, 0x04000444, 0x40000444, 0x44000444, 0x00040444, 0x04040444, 0x40040444, 0x44040444,
+    0x00400444, 0x04400444, 0x40400444, 0x44400444, 0x00440444, 0x04440444, 0x40440444, 0x44440444,
+    0x00004044, 0x04004044, 0x40004044, 0x44004044, 0x00044044, 0x04044044, 0x40044044, 0x44044044,
+    0x00404044, 0x04404044, 0x40404044, 0x44404044, 0x00444044, 0x04444044, 0x40444044, 0x44444044,
+    0x00004444, 0x04004444, 0x40004444, 0x44004444, 0x00044444, 0x04044444, 0x40044444, 0x44044444,
+    0x00404444, 0x04404444, 0x40404444, 0x44404444, 0x00444444, 0x04444444, 0x40444444, 0x44444444,
+};
+
+static inline uint8_t xor_bytes(uint64_t x)
+{
+  x ^= x >> 32;
+  x ^= x >> 16;
+  x ^= x >> 8;
+  return x;
+}
+
+size_t sp_encode_data(uint8_t *dest, const uint8_t *data, uint16_t num, uint8_t &checksum)
+{
+  int numodds = num % 7;
+  int numgrps = num / 7;
+  uint8_t *p = dest;
+
+  if (numodds)
+  {
+    uint8_t oddmsb = 0x80;
+    for (int i = 0; i < numodds; i++)
+    {
+      checksum ^= data[i];
+      oddmsb |= (data[i] & 0x80) >> (1 + i);
+      p[1 + i] = data[i] | 0x80;
+    }
+    p[0] = oddmsb;
+    p += 1 + numodds;
+    data += numodds;
+  }
+
+  for (int grp = 0; grp < numgrps; grp++)
+  {
+    uint64_t x = 0;
+    memcpy(&x, data, 7);
+    checksum ^= xor_bytes(x);
+    p[0] = 0x80 | ((((x & GROUP_HIGH_BITS) >> 7) * GATHER_HIGH_BITS) >> 56);
+    x |= GROUP_HIGH_BITS;
+    memcpy(p + 1, &x, 7);
+    p += 8;
+    data += 7;
+  }
+
+  return p - dest;
+}
+
+size_t sp_decode_data(uint8_t *dest, const uint8_t *src, uint8_t numodd, uint8_t numgrps, uint8_t *checksum)
+{
+  uint8_t sum = 0;
+  uint8_t *p = dest;
+
+  if (numodd)
+  {
+    for (int i = 0; i < numodd; i++)
+    {
+      p[i] = ((src[0] << (i + 1)) & 0x80) | (src[1 + i] & 0x7f);
+      sum ^= p[i];
+    }
+    src += 1 + numodd;
+    p += numodd;
+  }
+
+  for (int grp = 0; grp < numgrps; grp++)
+  {
+    uint64_t x = 0;
+    memcpy(&x, src + 1, 7);
+    x = (x & GROUP_LOW_BITS) | (((src[0] & 0x7f) * SCATTER_HIGH_BITS) & GROUP_HIGH_BITS);
+    sum ^= xor_bytes(x);
+    memcpy(p, &x, 7);
+    src += 8;
+    p += 7;
+  }
+
+  if (checksum != nullptr)
+    *checksum ^= sum;
+  return p - dest;
+}
+
+size_t IRAM_ATTR sp_encode_spi(uint8_t *dest, const uint8_t *packet)
+{
+  uint8_t *p = dest;
+  while (*packet)
+  {
+    memcpy(p, &sp_spi_samples[*packet++], SP_SPI_BYTES_PER_BYTE);
+    p += SP_SPI_BYTES_PER_BYTE;
+  }
+  return p - dest;
+}
@@ -0,0 +1,37 @@
+#ifndef IWM_SP_CODEC_H
+#define IWM_SP_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * SmartPort packet coding, kept apart from the bus so it can run on the host.
+ *
+ * The data in a packet goes 7 bytes to a group, each group led by a byte
+ * holding the high bits of the seven, with the odd bytes left over from
+ * num % 7 and their own high bit byte ahead of the groups. Every byte on the
+ * wire has its top bit set.
+ *
+ * On the way out each packet byte becomes 4 bytes of SPI samples, two bits
+ * to a sample byte, 0x40 for the first and 0x04 for the second: one lookup
+ * a byte instead of a loop over its bits.
+ */
+
+// SPI sample bytes sent for each packet byte
+#define SP_SPI_BYTES_PER_BYTE 4
+
+// Writes the odd bytes and groups for num bytes of data to dest and xors the
+// data into checksum as it goes.
+// Returns the number of bytes written
+size_t sp_encode_data(uint8_t *dest, const uint8_t *data, uint16_t num, uint8_t &checksum);
+
+// Reads numodd odd bytes and numgrps groups from src back into dest, xoring
+// what comes out into checksum if one is given.
+// Returns the number of bytes decoded, numodd + numgrps * 7
+size_t sp_decode_data(uint8_t *dest, const uint8_t *src, uint8_t numodd, uint8_t numgrps, uint8_t *checksum = nullptr);
+
+// Turns packet bytes up to the 0x00 that ends the packet into SPI samples.
+// Returns the number of sample bytes written
+size_t sp_encode_spi(uint8_t *dest, const uint8_t *packet);
+
+#endif // IWM_SP_CODEC_H
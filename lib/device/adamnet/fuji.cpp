@@ -16,6 +16,7 @@
 
 #include "utils.h"
 #include "string_utils.h"
+#include "fujiDirBlock.h"
 
 #define ADDITIONAL_DETAILS_BYTES 12
 
@@ -735,6 +736,13 @@ void adamFuji::adamnet_read_directory_entry()
     {
         Debug_printf("Fuji cmd: READ DIRECTORY ENTRY (max=%hu)\n", maxlen);
 
+        if (DIRBLOCK_IS_BLOCK(addtl))
+        {
+            response_len = fuji_read_directory_block(&_fnHosts[_current_open_directory_slot], response, sizeof(response),
+                                                     maxlen, addtl, ADDITIONAL_DETAILS_BYTES, _set_additional_direntry_details);
+            return;
+        }
+
         fsdir_entry_t *f = _fnHosts[_current_open_directory_slot].dir_nextfile();
 
         if (f == nullptr)
@@ -1312,66 +1320,40 @@ void adamFuji::setup(systemBus *siobus)
 void adamFuji::mount_all()
 {
     bool nodisks = true; // Check at the end if no disks are in a slot and disable config
+    bool enabled[4] = {Config.get_device_slot_enable_1(), Config.get_device_slot_enable_2(),
+                       Config.get_device_slot_enable_3(), Config.get_device_slot_enable_4()};
+    uint32_t slot_mask = 0;
 
     active_rotate_slot=0;
 
     for (int i = 0; i < 4; i++)
     {
-        fujiDisk &disk = _fnDisks[i];
-        fujiHost &host = _fnHosts[disk.host_slot];
-        char flag[3] = {'r', 0, 0};
-
-        if (i == 0 && !Config.get_device_slot_enable_1())
-        {
-            disk.disk_dev.device_active = false;
-        }
-        else if (i == 1 && !Config.get_device_slot_enable_2())
-        {
-            disk.disk_dev.device_active = false;
-        }
-        else if (i == 2 && !Config.get_device_slot_enable_3())
-        {
-            disk.disk_dev.device_active = false;
-        }
-        else if (i == 3 && !Config.get_device_slot_enable_4())
-        {
-            disk.disk_dev.device_active = false;
-        }
+        if (enabled[i])
+            slot_mask |= 1 << i;
         else
-        {
-
-            if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-                flag[1] = '+';
-
-            if (disk.host_slot != INVALID_HOST_SLOT && strlen(disk.filename) > 0)
-            {
-                nodisks = false; // We have a disk in a slot
-
-                if (host.mount() == false)
-                {
-                    return;
-                }
+            _fnDisks[i].disk_dev.device_active = false;
+    }
 
-                Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n",
-                             disk.filename, disk.host_slot, flag, i + 1);
+    // Hosts are mounted and images opened all at once
+    _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, 4, "r", "r+", slot_mask);
 
-                disk.fileh = host.file_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
+    for (int i = 0; i < 4; i++)
+    {
+        fujiDisk &disk = _fnDisks[i];
+        fujiMountReport *report = _mount_all.report(i);
 
-                if (disk.fileh == nullptr)
-                {
-                    return;
-                }
+        if (report->result == MOUNT_EMPTY)
+            continue;
+        nodisks = false; // We have a disk in a slot
 
-                // We've gotten this far, so make sure our bootable CONFIG disk is disabled
-                boot_config = false;
+        if (report->result != MOUNT_OK)
+            continue;
 
-                // We need the file size for loading XEX files and for CASSETTE, so get that too
-                disk.disk_size = host.file_size(disk.fileh);
+        // We've gotten this far, so make sure our bootable CONFIG disk is disabled
+        boot_config = false;
 
-                // And now mount it
-                disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-            }
-        }
+        // And now mount it
+        disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
     }
 
     if (nodisks)
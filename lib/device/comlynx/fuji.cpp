@@ -15,6 +15,7 @@
 
 #include "utils.h"
 #include "string_utils.h"
+#include "fujiDirBlock.h"
 
 #define ADDITIONAL_DETAILS_BYTES 12
 
@@ -406,45 +407,26 @@ void lynxFuji::mount_all()
 {
     bool nodisks = true; // Check at the end if no disks are in a slot and disable config
 
+    // Hosts are mounted and images opened all at once
+    bool error = _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, MAX_DISK_DEVICES, "r", "r+");
+
     for (int i = 0; i < MAX_DISK_DEVICES; i++)
     {
         fujiDisk &disk = _fnDisks[i];
-        fujiHost &host = _fnHosts[disk.host_slot];
-        char flag[3] = {'r', 0, 0};
-
-        if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-            flag[1] = '+';
-
-        if (disk.host_slot != INVALID_HOST_SLOT && strlen(disk.filename) > 0)
-        {
-            nodisks = false; // We have a disk in a slot
+        fujiMountReport *report = _mount_all.report(i);
 
-            if (host.mount() == false)
-            {
-                comlynx_response_nack();
-                return;
-            }
-
-            Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n",
-                         disk.filename, disk.host_slot, flag, i + 1);
-
-            disk.fileh = host.file_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
-
-            if (disk.fileh == nullptr)
-            {
-                comlynx_response_nack();
-                return;
-            }
+        if (report->result == MOUNT_EMPTY)
+            continue;
+        nodisks = false; // We have a disk in a slot
 
-            // We've gotten this far, so make sure our bootable CONFIG disk is disabled
-            boot_config = false;
+        if (report->result != MOUNT_OK)
+            continue;
 
-            // We need the file size for loading XEX files and for CASSETTE, so get that too
-            disk.disk_size = host.file_size(disk.fileh);
+        // We've gotten this far, so make sure our bootable CONFIG disk is disabled
+        boot_config = false;
 
-            // And now mount it
-            disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-        }
+        // And now mount it
+        disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
     }
 
     if (nodisks)
@@ -453,6 +435,12 @@ void lynxFuji::mount_all()
         boot_config = false;
     }
 
+    if (error)
+    {
+        comlynx_response_nack();
+        return;
+    }
+
     // Go ahead and respond ok
     comlynx_response_ack();
 }
@@ -704,6 +692,13 @@ void lynxFuji::comlynx_read_directory_entry()
     {
         Debug_printf("Fuji cmd: READ DIRECTORY ENTRY (max=%hu)\n", maxlen);
 
+        if (DIRBLOCK_IS_BLOCK(addtl))
+        {
+            response_len = fuji_read_directory_block(&_fnHosts[_current_open_directory_slot], response, sizeof(response),
+                                                     maxlen, addtl, ADDITIONAL_DETAILS_BYTES, _set_additional_direntry_details);
+            return;
+        }
+
         fsdir_entry_t *f = _fnHosts[_current_open_directory_slot].dir_nextfile();
 
         if (f == nullptr)
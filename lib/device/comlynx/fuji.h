@@ -10,6 +10,7 @@
 #include "fujiHost.h"
 #include "fujiDisk.h"
 #include "fujiCmd.h"
+#include "fujiMountAll.h"
 
 #define MAX_HOSTS 8
 #define MAX_DISK_DEVICES 8
@@ -70,6 +71,8 @@ private:
 
     fujiDisk _fnDisks[MAX_DISK_DEVICES];
 
+    fujiMountAll _mount_all;
+
     int _current_open_directory_slot = -1;
 
     lynxDisk *_bootDisk = nullptr; // special disk drive just for configuration
@@ -12,6 +12,7 @@
 #include "fujiHost.h"
 #include "fujiDisk.h"
 #include "fujiCmd.h"
+#include "fujiMountAll.h"
 
 #define MAX_HOSTS 8
 #define MAX_DISK_DEVICES 8
@@ -63,6 +64,8 @@ private:
 
     fujiDisk _fnDisks[MAX_DISK_DEVICES];
 
+    fujiMountAll _mount_all;
+
     int _current_open_directory_slot = -1;
 
     uint8_t _countScannedSSIDs = 0;
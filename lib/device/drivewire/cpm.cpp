@@ -44,6 +44,9 @@ static void cpmTask(void *arg)
         _puts(CCPHEAD);
         _PatchCPM();
         _ccp();
+#ifdef ESP_PLATFORM // OS
+        _cpm_stop_point();
+#endif
     }
 }
 
@@ -84,7 +87,8 @@ void drivewireCPM::boot()
 #ifdef ESP_PLATFORM
     if (cpmTaskHandle != NULL)
     {
-        vTaskDelete(cpmTaskHandle);
+        // the task writes back what the last session left buffered and ends itself
+        _cpm_stop();
         cpmTaskHandle = NULL;
     }
 
@@ -34,6 +34,7 @@ mediatype_t drivewireDisk::mount(fnFile *f, const char *filename, uint32_t disks
         delete _media;
         _media = nullptr;
     }
+    prefetch.reset();
 
     // Determine MediaType based on filename extension
     if (disk_type == MEDIATYPE_UNKNOWN && filename != nullptr)
@@ -78,6 +79,15 @@ bool drivewireDisk::read(uint32_t lsn, uint8_t *buf)
     return r;
 }
 
+// OP_READEX calls this after its status byte is out. DriveWire asks for one
+// sector per transaction, so two LSNs in a row mean a file is being loaded,
+// and the DW_PREFETCH_SECTORS that follow are brought into the cache while
+// the bus loop is free for the next request.
+void drivewireDisk::read_ahead(uint32_t lsn)
+{
+    prefetch.read_done(lsn);
+}
+
 bool drivewireDisk::write(uint32_t lsn, uint8_t *buf)
 {
     if (!buf)
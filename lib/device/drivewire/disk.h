@@ -4,11 +4,19 @@
 #include <fujiHost.h>
 #include "bus.h"
 #include "media.h"
+#include "mediaPrefetch.h"
+
+// Sectors read ahead after a read that follows on from the one before
+#define DW_PREFETCH_SECTORS 16
 
 class drivewireDisk : public virtualDevice
 {
 private:
     MediaType *_media = nullptr;
+    MediaPrefetch prefetch{DW_PREFETCH_SECTORS, [this](uint32_t lsn) {
+        if (_media != nullptr)
+            _media->prefetch(lsn, 1);
+    }};
 
 public:
     drivewireDisk();
@@ -24,6 +32,7 @@ public:
 
     bool read(uint32_t sector, uint8_t *buf);
     bool write(uint32_t sector, uint8_t *buf);
+    void read_ahead(uint32_t lsn);
 
     void get_media_buffer(uint8_t **p_buffer, uint16_t *p_blk_size);
     uint8_t get_media_status();
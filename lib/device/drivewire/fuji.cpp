@@ -21,6 +21,7 @@
 #include "led.h"
 #include "utils.h"
 #include "string_utils.h"
+#include "fujiDirBlock.h"
 
 #include "../../encoding/base64.h"
 #include "../../encoding/hash.h"
@@ -483,48 +484,31 @@ void drivewireFuji::mount_all()
 
     Debug_printf("drivewireFuji::mount_all()\n");
 
+    // Hosts are mounted and images opened all at once
+    _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, 4, "r", "r+");
+
     for (int i = 0; i < 4; i++)
     {
         fujiDisk &disk = _fnDisks[i];
-        fujiHost &host = _fnHosts[disk.host_slot];
-        char flag[3] = {'r', 0, 0};
-
-        if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-            flag[1] = '+';
-
-        if (disk.host_slot != INVALID_HOST_SLOT && strlen(disk.filename) > 0)
-        {
-            nodisks = false; // We have a disk in a slot
+        fujiMountReport *report = _mount_all.report(i);
 
-            if (host.mount() == false)
-            {
-                return;
-            }
-
-            Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n",
-                         disk.filename, disk.host_slot, flag, i + 1);
-
-            disk.fileh = host.fnfile_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
-
-            if (disk.fileh == nullptr)
-            {
-                return;
-            }
+        if (report->result == MOUNT_EMPTY)
+            continue;
+        nodisks = false; // We have a disk in a slot
 
-            // We've gotten this far, so make sure our bootable CONFIG disk is disabled
-            boot_config = false;
+        if (report->result != MOUNT_OK)
+            continue;
 
-            // We need the file size for loading XEX files and for CASSETTE, so get that too
-            disk.disk_size = host.file_size(disk.fileh);
+        // We've gotten this far, so make sure our bootable CONFIG disk is disabled
+        boot_config = false;
 
-            // Set the host slot for high score mode
-            // TODO: Refactor along with mount disk image.
-            disk.disk_dev.host = &host;
+        // Set the host slot for high score mode
+        // TODO: Refactor along with mount disk image.
+        disk.disk_dev.host = disk.host;
 
-            // And now mount it
-            disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-            disk.disk_dev.device_active = true;
-        }
+        // And now mount it
+        disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
+        disk.disk_dev.device_active = true;
     }
 
     if (nodisks)
@@ -868,6 +852,14 @@ void drivewireFuji::read_directory_entry()
 
     Debug_printf("Fuji cmd: READ DIRECTORY ENTRY (max=%hu) (addtl=%02x)\n", maxlen, addtl);
 
+    if (DIRBLOCK_IS_BLOCK(addtl))
+    {
+        response.resize(DIRBLOCK_MAX_SIZE);
+        response.resize(fuji_read_directory_block(&_fnHosts[_current_open_directory_slot], (uint8_t *)&response[0], response.size(),
+                                                  maxlen, addtl, ADDITIONAL_DETAILS_BYTES, _set_additional_direntry_details));
+        return;
+    }
+
     memset(current_entry, 0, sizeof(current_entry));
 
     fsdir_entry_t *f = _fnHosts[_current_open_directory_slot].dir_nextfile();
@@ -1375,32 +1367,25 @@ void drivewireFuji::base64_encode_input()
 
     std::vector<unsigned char> p(len);
     fnDwCom.readBytes(p.data(), len);
-    base64.base64_buffer += std::string((const char *)p.data(), len);
+    base64.encode_input(p.data(), len);
     errorCode = 1;
 }
 
 void drivewireFuji::base64_encode_compute()
 {
-    size_t out_len;
-
-    std::unique_ptr<char[]> p = Base64::encode(base64.base64_buffer.c_str(), base64.base64_buffer.size(), &out_len);
-
-    if (!p)
+    if (!base64.encode_compute())
     {
         Debug_printf("base64_encode_compute() failed.\n");
         errorCode = 144;
         return;
     }
 
-    base64.base64_buffer.clear();
-    base64.base64_buffer = std::string(p.get(), out_len);
-
     errorCode = 1;
 }
 
 void drivewireFuji::base64_encode_length()
 {
-    size_t l = base64.base64_buffer.length();
+    size_t l = base64.output_length();
     uint8_t o[4] = 
     {
         (uint8_t)(l >> 24),
@@ -1431,9 +1416,7 @@ void drivewireFuji::base64_encode_output()
     }
 
     std::vector<unsigned char> p(len);
-    std::memcpy(p.data(), base64.base64_buffer.data(), len);
-    base64.base64_buffer.erase(0, len);
-    base64.base64_buffer.shrink_to_fit();
+    base64.output(p.data(), len);
 
     response = std::string((const char *)p.data(), len);
     errorCode = 1;    
@@ -1454,29 +1437,23 @@ void drivewireFuji::base64_decode_input()
 
     std::vector<unsigned char> p(len);
     fnDwCom.readBytes(p.data(), len);
-    base64.base64_buffer += std::string((const char *)p.data(), len);
+    base64.decode_input((const char *)p.data(), len);
 
     errorCode = 1;
 }
 
 void drivewireFuji::base64_decode_compute()
 {
-    size_t out_len;
-
     Debug_printf("FUJI: BASE64 DECODE COMPUTE\n");
 
-    std::unique_ptr<unsigned char[]> p = Base64::decode(base64.base64_buffer.c_str(), base64.base64_buffer.size(), &out_len);
-    if (!p)
+    if (!base64.decode_compute())
     {
         Debug_printf("base64_encode compute failed\n");
         errorCode = 144;
         return;
     }
 
-    base64.base64_buffer.clear();
-    base64.base64_buffer = std::string((const char *)p.get(), out_len);
-
-    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", out_len);
+    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", base64.output_length());
     errorCode = 1;
 }
 
@@ -1484,7 +1461,7 @@ void drivewireFuji::base64_decode_length()
 {
     Debug_printf("FUJI: BASE64 DECODE LENGTH\n");
 
-    size_t len = base64.base64_buffer.length();
+    size_t len = base64.output_length();
     uint8_t _response[4] = {
         (uint8_t)(len >>  24),
         (uint8_t)(len >>  16),
@@ -1522,9 +1499,9 @@ void drivewireFuji::base64_decode_output()
         errorCode = 144;
         return;
     }
-    else if (len > base64.base64_buffer.length())
+    else if (len > base64.output_length())
     {
-        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.base64_buffer.length());
+        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.output_length());
         errorCode = 144;
         return;
     }
@@ -1534,9 +1511,7 @@ void drivewireFuji::base64_decode_output()
     }
 
     std::vector<unsigned char> p(len);
-    memcpy(p.data(), base64.base64_buffer.data(), len);
-    base64.base64_buffer.erase(0, len);
-    base64.base64_buffer.shrink_to_fit();
+    base64.output(p.data(), len);
     response.clear();
     response.shrink_to_fit();
     response = std::string((const char *)p.data(), len);
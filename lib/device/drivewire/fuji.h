@@ -12,6 +12,7 @@
 #include "fujiHost.h"
 #include "fujiDisk.h"
 #include "fujiCmd.h"
+#include "fujiMountAll.h"
 
 #include "hash.h"
 
@@ -98,6 +99,8 @@ private:
 
     fujiDisk _fnDisks[MAX_DISK_DEVICES];
 
+    fujiMountAll _mount_all;
+
     Hash::Algorithm algorithm = Hash::Algorithm::UNKNOWN;
 
 #ifdef ESP_PLATFORM
@@ -45,6 +45,7 @@ static void cpmTask(void *arg)
         _puts(CCPHEAD);
         _PatchCPM();
         _ccp();
+        _cpm_stop_point();
     }
 }
 
@@ -71,7 +72,11 @@ void iecCpm::iec_open()
 void iecCpm::iec_close()
 {
     if (cpmTaskHandle != NULL)
-        vTaskDelete(cpmTaskHandle);
+    {
+        // the task writes back what the session left buffered and ends itself
+        _cpm_stop();
+        cpmTaskHandle = NULL;
+    }
 
     commanddata.init();
     state = DEVICE_IDLE;
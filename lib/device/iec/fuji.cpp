@@ -854,54 +854,36 @@ void iecFuji::mount_all()
 {
     // Check at the end if no disks are in a slot and disable config
     bool nodisks = true;
+    int failed = -1; // first slot which didn't mount, for the status
+
+    // Hosts are mounted and images opened all at once
+    _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, MAX_DISK_DEVICES, "r", "r+");
 
     for (int i = 0; i < MAX_DISK_DEVICES; i++)
     {
         fujiDisk &disk = _fnDisks[i];
-        fujiHost &host = _fnHosts[disk.host_slot];
-        char flag[3] = {'r', 0, 0};
+        fujiMountReport *report = _mount_all.report(i);
 
-        if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-            flag[1] = '+';
+        if (report->result == MOUNT_EMPTY)
+            continue;
+        nodisks = false; // We have a disk in a slot
 
-        if (disk.host_slot != INVALID_HOST_SLOT && strlen(disk.filename) > 0)
+        if (report->result != MOUNT_OK)
         {
-            nodisks = false; // We have a disk in a slot
-
-            if (!host.mount())
-            {
-                std::string slotno = std::to_string(i);
-                response = "error: unable to mount slot " + slotno + "\r";
-                set_fuji_iec_status(DEVICE_ERROR, response);
-                return;
-            }
-
-            Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n",
-                         disk.filename, disk.host_slot, flag, i + 1);
-
-            disk.fileh = host.file_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
-
-            if (disk.fileh == nullptr)
-            {
-                std::string slotno = std::to_string(i);
-                response = "error: invalid file handle for slot " + slotno + "\r";
-                set_fuji_iec_status(DEVICE_ERROR, response);
-                return;
-            }
-
-            // We've gotten this far, so make sure our bootable CONFIG disk is disabled
-            boot_config = false;
+            if (failed < 0)
+                failed = i;
+            continue;
+        }
 
-            // We need the file size for loading XEX files and for CASSETTE, so get that too
-            disk.disk_size = host.file_size(disk.fileh);
+        // We've gotten this far, so make sure our bootable CONFIG disk is disabled
+        boot_config = false;
 
-            // Set the host slot for high score mode
-            // TODO: Refactor along with mount disk image.
-            disk.disk_dev.host = &host;
+        // Set the host slot for high score mode
+        // TODO: Refactor along with mount disk image.
+        disk.disk_dev.host = disk.host;
 
-            // And now mount it
-            disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-        }
+        // And now mount it
+        disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
     }
 
     if (nodisks)
@@ -910,6 +892,17 @@ void iecFuji::mount_all()
         boot_config = false;
     }
 
+    if (failed >= 0)
+    {
+        std::string slotno = std::to_string(failed);
+        if (_mount_all.report(failed)->result == MOUNT_OPEN_FAILED)
+            response = "error: invalid file handle for slot " + slotno + "\r";
+        else
+            response = "error: unable to mount slot " + slotno + "\r";
+        set_fuji_iec_status(DEVICE_ERROR, response);
+        return;
+    }
+
     response = "ok";
     if (is_raw_command) {
         set_fuji_iec_status(0, "");
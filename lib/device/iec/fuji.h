@@ -12,6 +12,7 @@
 #include "../fuji/fujiHost.h"
 #include "../fuji/fujiDisk.h"
 #include "../fuji/fujiCmd.h"
+#include "../fuji/fujiMountAll.h"
 
 #include "hash.h"
 
@@ -93,6 +94,8 @@ private:
 
     fujiDisk _fnDisks[MAX_DISK_DEVICES];
 
+    fujiMountAll _mount_all;
+
     int _current_open_directory_slot = -1;
 
     iecDrive _bootDisk; // special disk drive just for configuration
@@ -258,6 +258,16 @@ void iwmDisk::process(iwm_decoded_cmd_t cmd)
     Debug_printf("\r\nhandling write block command");
     iwm_writeblock(cmd);
     break;
+#ifdef DEV_RELAY_SLIP
+  case SP_CMD_READBLOCKS:
+    Debug_printf("\r\nhandling read blocks command");
+    iwm_readblocks(cmd);
+    break;
+  case SP_CMD_WRITEBLOCKS:
+    Debug_printf("\r\nhandling write blocks command");
+    iwm_writeblocks(cmd);
+    break;
+#endif
   case SP_CMD_FORMAT:
     iwm_return_noerror();
     break;
@@ -328,9 +338,97 @@ void iwmDisk::iwm_readblock(iwm_decoded_cmd_t cmd)
   
   // send_data_packet();
   Debug_printf("\r\nsending block packet ...");
-  if (IWM.iwm_send_packet(id(), iwm_packet_type_t::data, 0, data_buffer, BLOCK_DATA_LEN))
-   ((MediaTypePO*)_disk)->reset_seek_opto();  // force seek next time if send error
+  IWM.iwm_send_packet(id(), iwm_packet_type_t::data, 0, data_buffer, BLOCK_DATA_LEN);
+  read_ahead.read_done(block_num, 1);
+}
+
+#ifdef DEV_RELAY_SLIP
+void iwmDisk::iwm_readblocks(iwm_decoded_cmd_t cmd)
+{
+  uint32_t block_num = get_block_number(cmd);
+  uint16_t count = get_block_count(cmd);
+  Debug_printf("\r\nDrive %02x Read %u blocks from %06x\r\n", id(), count, block_num);
+
+  if (_disk == nullptr || !device_active)
+  {
+    Debug_printf("iwm_readblocks while device offline!\r\n");
+    send_reply_packet(SP_ERR_OFFLINE);
+    return;
+  }
+  if (switched && block_num > 2)
+  {
+    Debug_printf("iwm_readblocks() returning disk switched error\r\n");
+    send_reply_packet(SP_ERR_OFFLINE);
+    switched = false;
+    return;
+  }
+  if (count == 0 || count > SP_MAX_BLOCKS)
+  {
+    send_reply_packet(SP_ERR_BADCTLPARM);
+    return;
+  }
+  switched = false;
+
+  blocks_buffer.resize(count * BLOCK_DATA_LEN);
+  for (uint16_t i = 0; i < count; i++)
+  {
+    uint16_t sdstato = BLOCK_DATA_LEN;
+    if (_disk->read(block_num + i, &sdstato, &blocks_buffer[i * BLOCK_DATA_LEN]))
+    {
+      Debug_printf("\r\nFile Seek or Read err on block %06x", block_num + i);
+      send_reply_packet(SP_ERR_IOERROR);
+      return;
+    }
+  }
+
+  IWM.iwm_send_packet(id(), iwm_packet_type_t::data, 0, blocks_buffer.data(), blocks_buffer.size());
+  read_ahead.read_done(block_num, count);
+}
+
+void iwmDisk::iwm_writeblocks(iwm_decoded_cmd_t cmd)
+{
+  uint32_t block_num = get_block_number(cmd);
+  uint16_t count = get_block_count(cmd);
+  Debug_printf("\r\nDrive %02x Write %u blocks from %06x", id(), count, block_num);
+
+  // the blocks came with the request, only take them if they are all there
+  if (count == 0 || count > SP_MAX_BLOCKS || smartport.current_request->payload_size() != count * BLOCK_DATA_LEN)
+  {
+    send_reply_packet(SP_ERR_BADCTLPARM);
+    return;
+  }
+  blocks_buffer.resize(count * BLOCK_DATA_LEN);
+  IWM.iwm_decode_data_packet(blocks_buffer.data(), data_len);
+
+  if (_disk == nullptr || !device_active)
+  {
+    Debug_printf("iwm_writeblocks while device offline!\r\n");
+    send_reply_packet(SP_ERR_OFFLINE);
+    return;
+  }
+  if (switched)
+  {
+    Debug_printf("iwm_writeblocks while disk switched = true\r\n");
+    send_reply_packet(readonly ? SP_ERR_NOWRITE : SP_ERR_OFFLINE);
+    switched = false;
+    return;
+  }
+  if (readonly)
+  {
+    Debug_printf("\r\niwm_writeblocks tried to write while readonly = true!");
+    send_reply_packet(SP_ERR_NOWRITE);
+    return;
+  }
+
+  if (_disk->write_blocks(block_num, count, blocks_buffer.data()))
+  {
+    Debug_printf("\r\nFile Write err on blocks %06x..%06x", block_num, block_num + count - 1);
+    send_reply_packet(SP_ERR_IOERROR);
+    return;
+  }
+  send_reply_packet(SP_ERR_NOERROR);
 }
+#endif /* DEV_RELAY_SLIP */
 
 void iwmDisk::iwm_writeblock(iwm_decoded_cmd_t cmd)
 {
@@ -514,6 +612,7 @@ void iwmDisk::unmount()
         _disk->unmount();
         delete _disk;
         _disk = nullptr;
+        read_ahead.reset();
         device_active = false;
         readonly = true;
         Debug_printf("Disk UNMOUNTED!!!!\r\n");
@@ -4,11 +4,19 @@
 
 #include "bus.h"
 #include "../media/media.h"
+#include "../media/mediaPrefetch.h"
+
+// Blocks read ahead after a read that follows on from the one before
+#define IWM_PREFETCH_BLOCKS 8
 
 class iwmDisk : public iwmDevice
 {
 private:
     uint8_t err_result = SP_ERR_NOERROR;
+    MediaPrefetch read_ahead{IWM_PREFETCH_BLOCKS, [this](uint32_t block) {
+        if (_disk != nullptr)
+            _disk->prefetch(block, 1);
+    }};
 
 protected:
     void send_status_reply_packet() override;
@@ -28,6 +36,12 @@ protected:
     void iwm_readblock(iwm_decoded_cmd_t cmd) override;
     void iwm_writeblock(iwm_decoded_cmd_t cmd) override;
     uint32_t get_block_number(iwm_decoded_cmd_t cmd) {return cmd.params[2] + (cmd.params[3] << 8) + (cmd.params[4] << 16); };
+#ifdef DEV_RELAY_SLIP
+    void iwm_readblocks(iwm_decoded_cmd_t cmd);
+    void iwm_writeblocks(iwm_decoded_cmd_t cmd);
+    uint16_t get_block_count(iwm_decoded_cmd_t cmd) {return cmd.params[0] + (cmd.params[1] << 8); };
+    std::vector<uint8_t> blocks_buffer;
+#endif
 
     // void derive_percom_block(uint16_t numSectors);
     // void iwm_read_percom_block();
@@ -9,14 +9,59 @@
 #include "fnHardwareTimer.h"
 #endif
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
 #include "compat_esp.h" // empty IRAM_ATTR macro for FujiNet-PC
 
 #define NS_PER_BIT_TIME 125
-#define BLANK_TRACK_LEN 6400
+
+// Below the bus service loop, the ring only has to keep ahead of the head
+#define DISK2_PREFETCH_STACK 4096
+#define DISK2_PREFETCH_PRIORITY 5
+// Furthest a neighbouring track is looked for, in quarter tracks
+#define DISK2_NEIGHBOUR_SEARCH 8
 
 const int8_t phase2seq[16] = {-1, 0, 2, 1, 4, -1, 3, -1, 6, 7, -1, -1, 5, -1, -1, -1};
 const int8_t seq2steps[8] = {0, 1, 2, 3, 0, -3, -2, -1};
 
+// One task fills the ring for whichever drive last moved its head
+static TaskHandle_t _prefetch_task = nullptr;
+static SemaphoreHandle_t _prefetch_lock = nullptr; // held while a drive's _disk is in use or replaced
+static iwmDisk2 *volatile _prefetch_drive = nullptr;
+
+static void disk2_prefetch_task(void *param)
+{
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    iwmDisk2 *drive = _prefetch_drive;
+    if (drive == nullptr)
+      continue;
+    xSemaphoreTake(_prefetch_lock, portMAX_DELAY);
+    drive->prefetch();
+    xSemaphoreGive(_prefetch_lock);
+  }
+}
+
+static void IRAM_ATTR disk2_prefetch_wake(iwmDisk2 *drive)
+{
+  _prefetch_drive = drive;
+  if (_prefetch_task == nullptr)
+    return;
+
+  if (xPortInIsrContext())
+  {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(_prefetch_task, &woken);
+    if (woken)
+      portYIELD_FROM_ISR();
+  }
+  else
+    xTaskNotifyGive(_prefetch_task);
+}
+
 iwmDisk2::~iwmDisk2()
 {
 }
@@ -50,9 +95,18 @@ mediatype_t iwmDisk2::mount(fnFile *f, uint32_t disksize, mediatype_t disk_type)
 
   // Debug_printf("disk MOUNT %s\n", filename);
 
+  if (_prefetch_task == nullptr)
+  {
+    _prefetch_lock = xSemaphoreCreateMutex();
+    if (xTaskCreate(disk2_prefetch_task, "fnDisk2Ring", DISK2_PREFETCH_STACK, nullptr, DISK2_PREFETCH_PRIORITY, &_prefetch_task) != pdPASS)
+      Debug_printf("\nCould not start the Disk ][ prefetch task");
+  }
+  xSemaphoreTake(_prefetch_lock, portMAX_DELAY);
+
   // Destroy any existing MediaType
   if (_disk != nullptr)
   {
+    diskii_xface.forget(_disk);
     delete _disk;
     _disk = nullptr;
   }
@@ -77,6 +131,8 @@ mediatype_t iwmDisk2::mount(fnFile *f, uint32_t disksize, mediatype_t disk_type)
         break;
     }
 
+    xSemaphoreGive(_prefetch_lock);
+
     if (mt == MEDIATYPE_WOZ) {
         change_track(0); // initialize spi buffer
     } else {
@@ -114,6 +170,8 @@ bool IRAM_ATTR iwmDisk2::move_head()
     //phases_lut[oldphases][newphases];
     old_pos = track_pos;
     track_pos += delta;
+    if (delta != 0)
+      step_dir = (delta > 0) ? 1 : -1;
     if (track_pos < 0)
     {
       track_pos = 0;
@@ -140,25 +198,70 @@ void IRAM_ATTR iwmDisk2::change_track(int indicator)
     return;
 
 #ifndef DEV_RELAY_SLIP
-  // need to tell diskii_xface the number of bits in the track
-  // and where the track data is located so it can convert it
-  if (((MediaTypeWOZ *)_disk)->trackmap(track_pos) != 255)
+  // A pointer swap if the track is in the ring, blank bits if it isn't until
+  // the prefetch task has it. Tracks that aren't in the image (trackmap 255)
+  // are blank as well.
+  MediaTypeWOZ *woz = (MediaTypeWOZ *)_disk;
+  diskii_xface.select_track(_disk, woz->trackmap(track_pos), NS_PER_BIT_TIME * woz->optimal_bit_timing);
+  disk2_prefetch_wake(this);
+#endif // !SLIP
+}
+
+// The nearest quarter track position the other way from pos holding a
+// different track, or -1
+int iwmDisk2::neighbour(int pos, int dir)
+{
+  MediaTypeWOZ *woz = (MediaTypeWOZ *)_disk;
+  uint8_t here = woz->trackmap(pos);
+
+  for (int p = pos + dir, n = 0; p >= 0 && p < MAX_TRACKS && n < DISK2_NEIGHBOUR_SEARCH; p += dir, n++)
   {
-    diskii_xface.copy_track(
-        ((MediaTypeWOZ *)_disk)->get_track(track_pos),
-        ((MediaTypeWOZ *)_disk)->track_len(track_pos),
-        ((MediaTypeWOZ *)_disk)->num_bits(track_pos),
-        NS_PER_BIT_TIME * ((MediaTypeWOZ *)_disk)->optimal_bit_timing);
-    Debug_printf("\nCopy track: %d", track_pos);
+    uint8_t t = woz->trackmap(p);
+    if (t != DISKII_NO_TRACK && t != here)
+      return p;
+  }
+  return -1;
+}
+
+void iwmDisk2::prefetch()
+{
+  if (!device_active || _disk == nullptr)
+    return;
+
+  MediaTypeWOZ *woz = (MediaTypeWOZ *)_disk;
+  int pos = track_pos;
+  int dir = step_dir;
+
+  // the track under the head, the next one the way it's stepping, then the one behind
+  int positions[DISKII_RING_SLOTS] = {pos, neighbour(pos, dir), neighbour(pos, -dir)};
+  uint8_t wanted[DISKII_RING_SLOTS];
+  for (int i = 0; i < DISKII_RING_SLOTS; i++)
+    wanted[i] = (positions[i] < 0) ? DISKII_NO_TRACK : woz->trackmap(positions[i]);
+
+  uint32_t underruns = diskii_xface.get_counters().underruns;
+  bool filled = false;
+  for (int i = 0; i < DISKII_RING_SLOTS; i++)
+  {
+    if (wanted[i] == DISKII_NO_TRACK || diskii_xface.has_track(_disk, wanted[i]))
+      continue;
+
+    int slot = diskii_xface.claim_slot(_disk, wanted, DISKII_RING_SLOTS);
+    if (slot < 0)
+      break;
+
+    // DSK images make the track when it's first asked for
+    uint8_t *track = woz->get_track(positions[i]);
+    diskii_xface.fill_slot(slot, _disk, wanted[i], track, woz->track_len(positions[i]), woz->num_bits(positions[i]));
+    filled = true;
+  }
+
+  if (filled)
+  {
+    diskii_ring_counters c = diskii_xface.get_counters();
+    Debug_printf("\nDisk ][ ring: %lu changes, %lu hits, %lu underruns%s, last %lu us, max %lu us",
+                 (unsigned long)c.changes, (unsigned long)c.hits, (unsigned long)c.underruns,
+                 c.underruns != underruns ? " (new)" : "", (unsigned long)c.last_us, (unsigned long)c.max_us);
   }
-  else
-    diskii_xface.copy_track(
-        nullptr, 
-        BLANK_TRACK_LEN, 
-        BLANK_TRACK_LEN * 8, 
-        NS_PER_BIT_TIME * ((MediaTypeWOZ *)_disk)->optimal_bit_timing);
-#endif // !SLIP
-  // Since the empty track has no data, and therefore no length, using a fake length of 51,200 bits (6400 bytes) works very well.
 }
 
 #endif /* !SLIP */
@@ -25,8 +25,11 @@ protected:
     bool enabledD2 = true;
     int track_pos;
     int old_pos;
+    int step_dir = 1; // which way the head last moved, +1 in
     uint8_t oldphases;
 
+    int neighbour(int pos, int dir);
+
 public:
     iwmDisk2();
     void init();
@@ -37,6 +40,8 @@ public:
     bool phases_valid(uint8_t phases);
     bool move_head();
     void change_track(int indicator);
+    // On the prefetch task, fills the ring with the tracks around the head
+    void prefetch();
     void disableD2() { 
         enabledD2 = false;
 #ifndef DEV_RELAY_SLIP
@@ -16,6 +16,7 @@
 #include "fsFlash.h"
 #include "utils.h"
 #include "string_utils.h"
+#include "fujiDirBlock.h"
 
 #include "compat_string.h"
 
@@ -460,44 +461,30 @@ bool iwmFuji::mount_all()
 {
 	bool nodisks = true; // Check at the end if no disks are in a slot and disable config
 
+	// Mounts the hosts together and opens the images
+	bool error = _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, MAX_DISK_DEVICES, "rb", "rb+");
+
 	for (int i = 0; i < MAX_DISK_DEVICES; i++)
 	{
 		fujiDisk &disk = _fnDisks[i];
-		fujiHost &host = _fnHosts[disk.host_slot];
-		char flag[4] = {'r', 'b', 0, 0};
-		if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-			flag[2] = '+';
-
-        if (disk.host_slot != INVALID_HOST_SLOT && strlen(disk.filename) > 0)
-		{
-			nodisks = false; // We have a disk in a slot
-
-			if (host.mount() == false)
-			{
-				return true;
-			}
-
-			Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n", disk.filename, disk.host_slot, flag, i + 1);
+		fujiMountReport *report = _mount_all.report(i);
 
-			disk.fileh = host.fnfile_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
+		if (report == nullptr || report->result == MOUNT_EMPTY)
+			continue;
 
-			if (disk.fileh == nullptr)
-			{
-				return true;
-			}
+		nodisks = false; // We have a disk in a slot
 
-			// We've gotten this far, so make sure our bootable CONFIG disk is disabled
-			boot_config = false;
+		if (report->result != MOUNT_OK)
+			continue;
 
-			// We need the file size for loading XEX files and for CASSETTE, so get that too
-			disk.disk_size = host.file_size(disk.fileh);
+		// We've gotten this far, so make sure our bootable CONFIG disk is disabled
+		boot_config = false;
 
-			// And now mount it
-			disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-			if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-			{
-				disk.disk_dev.readonly = false;
-			}
+		// And now mount it
+		disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
+		if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
+		{
+			disk.disk_dev.readonly = false;
 		}
 	}
 
@@ -507,8 +494,7 @@ bool iwmFuji::mount_all()
 		boot_config = false;
 	}
 
-	// Go ahead and respond ok
-	return false;
+	return error;
 }
 
 // Set boot mode
@@ -754,6 +740,14 @@ void iwmFuji::iwm_ctrl_read_directory_entry()
 	// {
 	Debug_printf("Fuji cmd: READ DIRECTORY ENTRY (max=%hu)\n", maxlen);
 
+	// the status call hands back whatever is left in ctrl_stat_buffer
+	if (DIRBLOCK_IS_BLOCK(addtl))
+	{
+		ctrl_stat_len = fuji_read_directory_block(&_fnHosts[_current_open_directory_slot], ctrl_stat_buffer, sizeof(ctrl_stat_buffer),
+												  maxlen, addtl, ADDITIONAL_DETAILS_BYTES, _set_additional_direntry_details);
+		return;
+	}
+
 	fsdir_entry_t *f = _fnHosts[_current_open_directory_slot].dir_nextfile();
 
 	if (f != nullptr)
@@ -1472,9 +1466,7 @@ void iwmFuji::handle_ctl_eject(uint8_t spid)
 
 void iwmFuji::iwm_ctrl_hash_input()
 {
-    std::vector<uint8_t> data(data_len, 0);
-    std::copy(&data_buffer[0], &data_buffer[0] + data_len, data.begin());
-    hasher.add_data(data);
+    hasher.add_data(data_buffer, data_len);
 }
 
 void iwmFuji::iwm_ctrl_hash_compute(bool clear_data)
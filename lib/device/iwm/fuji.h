@@ -19,6 +19,7 @@
 #include "../fuji/fujiHost.h"
 #include "../fuji/fujiDisk.h"
 #include "../fuji/fujiCmd.h"
+#include "../fuji/fujiMountAll.h"
 
 #include "hash.h"
 
@@ -114,6 +115,8 @@ private:
 
     fujiDisk _fnDisks[MAX_DISK_DEVICES];
 
+    fujiMountAll _mount_all;
+
     iwmNetwork *theNetwork;
 
     iwmCPM *theCPM;
@@ -26,6 +26,9 @@ mediatype_t macFloppy::mount(FILE *f, const char *filename, uint32_t disksize, m
 
   _disk_size_in_blocks = disksize/512;
 
+  // 400K/800K images in the floppy drive are made into tracks as it steps
+  uint32_t gcr_size = (id() == '4') ? MediaTypeGCR::image_size(f, disksize, disk_type) : 0;
+
   switch (disk_type)
   {
   case MEDIATYPE_MOOF:
@@ -34,24 +37,18 @@ mediatype_t macFloppy::mount(FILE *f, const char *filename, uint32_t disksize, m
     device_active = (id() == '4');
     _disk = new MediaTypeMOOF();
     mt = ((MediaTypeMOOF *)_disk)->mount(f);
-    track_pos = 0;
-    old_pos = 2; // makde different to force change_track buffer copy
-    change_track(0); // initialize rmt buffer
-    change_track(1); // initialize rmt buffer
-    switch (_disk->num_sides)
+    start_floppy();
+    break;
+  case MEDIATYPE_DSK:
+    if (gcr_size != 0)
     {
-    case 1:
-      fnUartBUS.write('s');
-      fnUartBUS.write(track_pos | 128);
-      break;
-    case 2:
-      fnUartBUS.write('d');
-      fnUartBUS.write(track_pos | 128);
-    default:
+      Debug_printf("\nMounting Media Type DSK as GCR floppy");
+      device_active = true;
+      _disk = new MediaTypeGCR();
+      mt = ((MediaTypeGCR *)_disk)->mount(f, gcr_size);
+      start_floppy();
       break;
     }
-    break;
-  case MEDIATYPE_DSK:
     Debug_printf("\nMounting Media Type DSK for DCD");
     device_active = true;
     _disk = new MediaTypeDCD();
@@ -59,6 +56,15 @@ mediatype_t macFloppy::mount(FILE *f, const char *filename, uint32_t disksize, m
     MAC.add_dcd_mount(id());
     break;
   case MEDIATYPE_DC42:
+    if (gcr_size != 0)
+    {
+      Debug_printf("\nMounting Media Type DC42 as GCR floppy");
+      device_active = true;
+      _disk = new MediaTypeGCR(0x54); // offset of image data in Disk Copy 4.2 file
+      mt = ((MediaTypeGCR *)_disk)->mount(f, gcr_size + 0x54);
+      start_floppy();
+      break;
+    }
     Debug_printf("\nMounting Media Type DC42 for DCD");
     device_active = true;
     _disk = new MediaTypeDCD(0x54); // offset of image data in Disk Copy 4.2 file
@@ -81,6 +87,27 @@ mediatype_t macFloppy::mount(FILE *f, const char *filename, uint32_t disksize, m
   return mt;
 }
 
+// Puts the heads on track 0 and tells the RP2040 how many sides there are
+void macFloppy::start_floppy()
+{
+  track_pos = 0;
+  old_pos = 2; // makde different to force change_track buffer copy
+  change_track(0); // initialize rmt buffer
+  change_track(1); // initialize rmt buffer
+  switch (_disk->num_sides)
+  {
+  case 1:
+    fnUartBUS.write('s');
+    fnUartBUS.write(track_pos | 128);
+    break;
+  case 2:
+    fnUartBUS.write('d');
+    fnUartBUS.write(track_pos | 128);
+  default:
+    break;
+  }
+}
+
 // void macFloppy::init()
 // {
 //   track_pos = 80;
@@ -144,7 +171,7 @@ void macFloppy::unmount()
   else if (_disk != nullptr)
     _disk->unmount();
   if (_disk != nullptr)
-    free(_disk);
+    delete _disk;
 
   _disk = nullptr;
 
@@ -199,9 +226,11 @@ void IRAM_ATTR macFloppy::change_track(int side)
 
   // need to tell diskii_xface the number of bits in the track
   // and where the track data is located so it can convert it
-  if (((MediaTypeMOOF *)_disk)->trackmap(tp) != 255)
+  // get_track() first, a GCR image makes the track then
+  uint8_t *track = (((MediaTypeMOOF *)_disk)->trackmap(tp) != 255) ? ((MediaTypeMOOF *)_disk)->get_track(tp) : nullptr;
+  if (track != nullptr)
     floppy_ll.copy_track(
-        ((MediaTypeMOOF *)_disk)->get_track(tp), 
+        track,
         side,
         ((MediaTypeMOOF *)_disk)->track_len(tp),
         ((MediaTypeMOOF *)_disk)->num_bits(tp),
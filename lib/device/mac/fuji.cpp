@@ -174,47 +174,30 @@ bool macFuji::mount_all()
 {
     bool nodisks = true; // Check at the end if no disks are in a slot and disable config
 
+    // Hosts are mounted and images opened all at once
+    bool error = _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, MAX_DISK_DEVICES, "r", "r+");
+
     for (int i = 0; i < MAX_DISK_DEVICES; i++)
     {
         fujiDisk &disk = _fnDisks[i];
-        fujiHost &host = _fnHosts[disk.host_slot];
-        char flag[3] = {'r', 0, 0};
+        fujiMountReport *report = _mount_all.report(i);
 
-        if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-            flag[1] = '+';
+        if (report->result == MOUNT_EMPTY)
+            continue;
+        nodisks = false; // We have a disk in a slot
 
-        if (disk.host_slot != 0xFF)
-        {
-            nodisks = false; // We have a disk in a slot
+        if (report->result != MOUNT_OK)
+            continue;
 
-            if (host.mount() == false)
-            {
-                return true;
-            }
-
-            Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n",
-                         disk.filename, disk.host_slot, flag, i + 1);
-
-            disk.fileh = host.file_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
-
-            if (disk.fileh == nullptr)
-            {
-                return true;
-            }
-
-            // We've gotten this far, so make sure our bootable CONFIG disk is disabled
-            boot_config = false;
- 
-            // We need the file size for loading XEX files and for CASSETTE, so get that too
-            disk.disk_size = host.file_size(disk.fileh);
+        // We've gotten this far, so make sure our bootable CONFIG disk is disabled
+        boot_config = false;
 
-            // And now mount it
-            disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-            disk.disk_dev.readonly = true;
-            if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-            {
-              disk.disk_dev.readonly = false;
-            }
+        // And now mount it
+        disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
+        disk.disk_dev.readonly = true;
+        if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
+        {
+          disk.disk_dev.readonly = false;
         }
     }
 
@@ -223,8 +206,7 @@ bool macFuji::mount_all()
         boot_config = false;
     }
 
-    // Go ahead and respond ok
-    return false;
+    return error;
 } 
 
 int macFuji::get_disk_id(int drive_slot)
@@ -16,6 +16,7 @@
 #include "../fuji/fujiHost.h"
 #include "../fuji/fujiDisk.h"
 #include "../fuji/fujiCmd.h"
+#include "../fuji/fujiMountAll.h"
 
 #define MAX_HOSTS 8
 #define MAX_DISK_DEVICES 5 // 4 DCD devices + 1 floppy devices
@@ -86,6 +87,8 @@ private:
 
     fujiDisk _fnDisks[MAX_DISK_DEVICES];
 
+    fujiMountAll _mount_all;
+
     // iwmNetwork *theNetwork;
 
     // iwmCPM *theCPM;
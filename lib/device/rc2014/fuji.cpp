@@ -13,6 +13,7 @@
 
 #include "utils.h"
 #include "string_utils.h"
+#include "fujiDirBlock.h"
 
 #include "../../encoding/base64.h"
 #include "../../encoding/hash.h"
@@ -515,6 +516,16 @@ void rc2014Fuji::rc2014_read_directory_entry()
 
     Debug_printf("Fuji cmd: READ DIRECTORY ENTRY (max=%hu)\n", maxlen);
 
+    if (DIRBLOCK_IS_BLOCK(addtl))
+    {
+        response_len = fuji_read_directory_block(&_fnHosts[_current_open_directory_slot], response, sizeof(response),
+                                                 maxlen, addtl, ADDITIONAL_DETAILS_BYTES, _set_additional_direntry_details);
+        rc2014_send_buffer(response, response_len);
+        rc2014_flush();
+        rc2014_send_complete();
+        return;
+    }
+
     fsdir_entry_t *f = _fnHosts[_current_open_directory_slot].dir_nextfile();
 
     if (f == nullptr)
@@ -980,18 +991,15 @@ void rc2014Fuji::rc2014_base64_encode_input()
     rc2014_send_ack();
     rc2014_recv_buffer((uint8_t *)p.data(), len);
     rc2014_send_ack();
-    base64.base64_buffer += std::string((const char *)p.data(), len);
+    base64.encode_input(p.data(), len);
     rc2014_send_complete();
 }
 
 void rc2014Fuji::rc2014_base64_encode_compute()
 {
-    size_t out_len;
-
     Debug_printf("FUJI: BASE64 ENCODE COMPUTE\n");
 
-    std::unique_ptr<char[]> p = Base64::encode(base64.base64_buffer.c_str(), base64.base64_buffer.size(), &out_len);
-    if (!p)
+    if (!base64.encode_compute())
     {
         Debug_printf("base64_encode compute failed\n");
         rc2014_send_error();
@@ -1000,10 +1008,7 @@ void rc2014Fuji::rc2014_base64_encode_compute()
 
     rc2014_send_ack();
 
-    base64.base64_buffer.clear();
-    base64.base64_buffer = std::string(p.get(), out_len);
-
-    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", out_len);
+    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", base64.output_length());
     rc2014_send_complete();
 }
 
@@ -1011,7 +1016,7 @@ void rc2014Fuji::rc2014_base64_encode_length()
 {
     Debug_printf("FUJI: BASE64 ENCODE LENGTH\n");
 
-    size_t l = base64.base64_buffer.length();
+    size_t l = base64.output_length();
     if (!l)
     {
         Debug_printf("BASE64 buffer is 0 bytes, sending error.\n");
@@ -1037,9 +1042,9 @@ void rc2014Fuji::rc2014_base64_encode_output()
         rc2014_send_error();
         return;
     }
-    else if (len > base64.base64_buffer.length())
+    else if (len > base64.output_length())
     {
-        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.base64_buffer.length());
+        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.output_length());
         rc2014_send_error();
         return;
     }
@@ -1051,9 +1056,7 @@ void rc2014Fuji::rc2014_base64_encode_output()
     std::vector<unsigned char> p(len);
     rc2014_send_ack();
 
-    memcpy(p.data(), base64.base64_buffer.data(), len);
-    base64.base64_buffer.erase(0, len);
-    base64.base64_buffer.shrink_to_fit();
+    base64.output(p.data(), len);
 
     rc2014_send_buffer(p.data(), len);
     rc2014_flush();
@@ -1078,18 +1081,15 @@ void rc2014Fuji::rc2014_base64_decode_input()
 
     rc2014_recv_buffer((uint8_t *)p.data(), len);
     rc2014_send_ack();
-    base64.base64_buffer += std::string((const char *)p.data(), len);
+    base64.decode_input((const char *)p.data(), len);
     rc2014_send_complete();
 }
 
 void rc2014Fuji::rc2014_base64_decode_compute()
 {
-    size_t out_len;
-
     Debug_printf("FUJI: BASE64 DECODE COMPUTE\n");
 
-    std::unique_ptr<unsigned char[]> p = Base64::decode(base64.base64_buffer.c_str(),base64.base64_buffer.size(),&out_len);
-    if (!p)
+    if (!base64.decode_compute())
     {
         Debug_printf("base64_encode compute failed\n");
         rc2014_send_error();
@@ -1098,10 +1098,7 @@ void rc2014Fuji::rc2014_base64_decode_compute()
 
     rc2014_send_ack();
 
-    base64.base64_buffer.clear();
-    base64.base64_buffer = std::string((const char *)p.get(), out_len);
-
-    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", out_len);
+    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", base64.output_length());
     rc2014_send_complete();
 }
 
@@ -1110,7 +1107,7 @@ void rc2014Fuji::rc2014_base64_decode_length()
     Debug_printf("FUJI: BASE64 DECODE LENGTH\n");
     rc2014_send_ack();
 
-    size_t len = base64.base64_buffer.length();
+    size_t len = base64.output_length();
 
     if (!len)
     {
@@ -1137,9 +1134,9 @@ void rc2014Fuji::rc2014_base64_decode_output()
         rc2014_send_error();
         return;
     }
-    else if (len > base64.base64_buffer.length())
+    else if (len > base64.output_length())
     {
-        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.base64_buffer.length());
+        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.output_length());
         rc2014_send_error();
         return;
     }
@@ -1150,9 +1147,7 @@ void rc2014Fuji::rc2014_base64_decode_output()
 
     std::vector<unsigned char> p(len);
     rc2014_send_ack();
-    memcpy(p.data(), base64.base64_buffer.data(), len);
-    base64.base64_buffer.erase(0, len);
-    base64.base64_buffer.shrink_to_fit();
+    base64.output(p.data(), len);
 
     rc2014_send_buffer(p.data(), len);
     rc2014_flush();
@@ -1271,43 +1266,26 @@ void rc2014Fuji::mount_all()
 {
     bool nodisks = true; // Check at the end if no disks are in a slot and disable config
 
+    // Hosts are mounted and images opened all at once
+    _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, 8, "r", "r+");
+
     for (int i = 0; i < 8; i++)
     {
         fujiDisk &disk = _fnDisks[i];
-        fujiHost &host = _fnHosts[disk.host_slot];
-        char flag[3] = {'r', 0, 0};
-
-        if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-            flag[1] = '+';
+        fujiMountReport *report = _mount_all.report(i);
 
-        if (disk.host_slot != INVALID_HOST_SLOT && strlen(disk.filename) > 0)
-        {
-            nodisks = false; // We have a disk in a slot
-
-            if (host.mount() == false)
-            {
-                return;
-            }
-
-            Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n",
-                         disk.filename, disk.host_slot, flag, i + 1);
+        if (report->result == MOUNT_EMPTY)
+            continue;
+        nodisks = false; // We have a disk in a slot
 
-            disk.fileh = host.file_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
+        if (report->result != MOUNT_OK)
+            continue;
 
-            if (disk.fileh == nullptr)
-            {
-                return;
-            }
-
-            // We've gotten this far, so make sure our bootable CONFIG disk is disabled
-            boot_config = false;
-
-            // We need the file size for loading XEX files and for CASSETTE, so get that too
-            disk.disk_size = host.file_size(disk.fileh);
+        // We've gotten this far, so make sure our bootable CONFIG disk is disabled
+        boot_config = false;
 
-            // And now mount it
-            disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-        }
+        // And now mount it
+        disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
     }
 
     if (nodisks)
@@ -17,6 +17,7 @@
 #include "led.h"
 #include "utils.h"
 #include "string_utils.h"
+#include "fujiDirBlock.h"
 
 rs232Fuji theFuji; // global fuji device object
 
@@ -434,46 +435,27 @@ void rs232Fuji::mount_all()
 {
     bool nodisks = true; // Check at the end if no disks are in a slot and disable config
 
+    // Hosts are mounted and images opened all at once
+    bool error = _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, 8, "r", "r+");
+
     for (int i = 0; i < 8; i++)
     {
         fujiDisk &disk = _fnDisks[i];
-        fujiHost &host = _fnHosts[disk.host_slot];
-        char flag[3] = {'r', 0, 0};
-
-        if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-            flag[1] = '+';
-
-        if (disk.host_slot != INVALID_HOST_SLOT && strlen(disk.filename) > 0)
-        {
-            nodisks = false; // We have a disk in a slot
-
-            if (host.mount() == false)
-            {
-                rs232_error();
-                return;
-            }
+        fujiMountReport *report = _mount_all.report(i);
 
-            Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n",
-                         disk.filename, disk.host_slot, flag, i + 1);
+        if (report->result == MOUNT_EMPTY)
+            continue;
+        nodisks = false; // We have a disk in a slot
 
-            disk.fileh = host.file_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
+        if (report->result != MOUNT_OK)
+            continue;
 
-            if (disk.fileh == nullptr)
-            {
-                rs232_error();
-                return;
-            }
-
-            // We've gotten this far, so make sure our bootable CONFIG disk is disabled
-            boot_config = false;
-            status_wait_count = 0;
-
-            // We need the file size for loading XEX files and for CASSETTE, so get that too
-            disk.disk_size = host.file_size(disk.fileh);
+        // We've gotten this far, so make sure our bootable CONFIG disk is disabled
+        boot_config = false;
+        status_wait_count = 0;
 
-            // And now mount it
-            disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-        }
+        // And now mount it
+        disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
     }
 
     if (nodisks){
@@ -481,6 +463,12 @@ void rs232Fuji::mount_all()
         boot_config = false;
     }
 
+    if (error)
+    {
+        rs232_error();
+        return;
+    }
+
     rs232_complete();
 }
 
@@ -814,6 +802,8 @@ void rs232Fuji::rs232_open_directory()
         rs232_error();
 }
 
+#define ADDITIONAL_DETAILS_BYTES 10
+
 void _set_additional_direntry_details(fsdir_entry_t *f, uint8_t *dest, uint8_t maxlen)
 {
     // File modified date-time
@@ -862,6 +852,15 @@ void rs232Fuji::rs232_read_directory_entry()
         return;
     }
 
+    if (DIRBLOCK_IS_BLOCK(cmdFrame.aux2))
+    {
+        uint8_t block[DIRBLOCK_MAX_SIZE];
+        uint16_t block_size = fuji_read_directory_block(&_fnHosts[_current_open_directory_slot], block, sizeof(block),
+                                                        maxlen, cmdFrame.aux2, ADDITIONAL_DETAILS_BYTES, _set_additional_direntry_details);
+        bus_to_computer(block, block_size, false);
+        return;
+    }
+
     char current_entry[256];
 
     fsdir_entry_t *f = _fnHosts[_current_open_directory_slot].dir_nextfile();
@@ -879,7 +878,6 @@ void rs232Fuji::rs232_read_directory_entry()
         int bufsize = sizeof(current_entry);
         char *filenamedest = current_entry;
 
-#define ADDITIONAL_DETAILS_BYTES 10
         // If 0x80 is set on AUX2, send back additional information
         if (cmdFrame.aux2 & 0x80)
         {
@@ -3,6 +3,7 @@
 #include "cassette.h"
 
 #include <cstring>
+#include <cmath>
 
 #include "../../include/debug.h"
 
@@ -65,70 +66,6 @@ static void IRAM_ATTR cas_isr_handler(void *arg)
 
 softUART casUART;
 
-uint8_t softUART::available()
-{
-    return index_in - index_out;
-}
-
-void softUART::set_baud(uint16_t b)
-{
-    baud = b;
-    period = 1000000 / baud;
-};
-
-uint8_t softUART::read()
-{
-    return buffer[index_out++];
-}
-
-int8_t softUART::service(uint8_t b)
-{
-    unsigned long t = fnSystem.micros();
-    if (state_counter == STARTBIT)
-    {
-        if (b == 1)
-        { // found start bit - sync up clock
-            state_counter++;
-            received_byte = 0; // clear data
-            baud_clock = t;    // approx beginning of start bit
-//            Debug_println("Start bit received!");
-        }
-    }
-    else if (t > baud_clock + period * state_counter + period / 4)
-    {
-        if (t < baud_clock + period * state_counter + 9 * period / 4)
-        {
-            if (state_counter == STOPBIT)
-            {
-                buffer[index_in++] = received_byte;
-                state_counter = STARTBIT;
-//                Debug_printf("received %02X\n", received_byte);
-                if (b != 0)
-                {
-                    Debug_println("Stop bit invalid!");
-                    return -1; // frame sync error
-                }
-            }
-            else
-            {
-                uint8_t bb = (b == 1) ? 0 : 1;
-                received_byte |= (bb << (state_counter - 1));
-                state_counter++;
-//                Debug_printf("bit %u ", state_counter - 1);
-//                Debug_printf("%u\n ", b);
-            }
-        }
-        else
-        {
-            Debug_println("Bit slip error!");
-            state_counter = STARTBIT;
-            return -1; // frame sync error
-        }
-    }
-    return 0;
-}
-
-
 //************************************************************************************************************
 // ***** nerd at work! ******
 
@@ -284,7 +221,9 @@ void sioCassette::sio_handle_cassette()
 {
     if (cassetteMode == cassette_mode_t::playback)
     {
-        if (tape_flags.FUJI)
+        if (tape_flags.WAV)
+            tape_offset = send_WAV_tape_block(tape_offset);
+        else if (tape_flags.FUJI)
             tape_offset = send_FUJI_tape_block(tape_offset);
         else
             tape_offset = send_tape_block(tape_offset);
@@ -398,6 +337,17 @@ void sioCassette::check_for_FUJI_file()
     struct tape_FUJI_hdr *hdr = (struct tape_FUJI_hdr *)atari_sector_buffer;
     uint8_t *p = hdr->chunk_type;
 
+    // WAV images are decoded on the fly, see send_WAV_tape_block()
+    tape_flags.WAV = wav.open(_file);
+    if (tape_flags.WAV)
+    {
+        tape_flags.FUJI = 0;
+        Debug_println("WAV File Found");
+        baud = CASSETTE_BAUDRATE;
+        block = 0;
+        return;
+    }
+
     // faccess_offset(FILE_ACCESS_READ, 0, sizeof(struct tape_FUJI_hdr));
     fnio::fseek(_file, 0, SEEK_SET);
     fnio::fread(atari_sector_buffer, 1, sizeof(struct tape_FUJI_hdr), _file);
@@ -426,6 +376,36 @@ void sioCassette::check_for_FUJI_file()
     return;
 }
 
+// Inter-record gap: returns false if the motor was switched off during it
+bool sioCassette::wait_tape_gap(uint16_t gap)
+{
+    // TO DO : turn on LED
+    fnLedManager.set(eLed::LED_BUS, true);
+    while (gap)
+    {
+#ifdef ESP_PLATFORM
+        gap--;
+        fnSystem.delay_microseconds(999); // shave off a usec for the MOTOR pin check
+#else
+        int step;
+        // FN_BUS_LINK is fnSioCom
+        if (FN_BUS_LINK.get_sio_mode() == SioCom::sio_mode::NETSIO)
+            step = gap > 1000 ? 1000 : gap; // step is 1000 ms (NetSIO)
+        else
+            step = gap > 20 ? 20 : gap; // step is 20 ms (SerialSIO)
+        gap -= step;
+        FN_BUS_LINK.bus_idle(step); // idle bus (i.e. delay for SerialSIO, BUS_IDLE message for NetSIO)
+#endif
+        if (has_pulldown() && !motor_line() && gap > 1000)
+        {
+            fnLedManager.set(eLed::LED_BUS, false);
+            return false;
+        }
+    }
+    fnLedManager.set(eLed::LED_BUS, false);
+    return true;
+}
+
 size_t sioCassette::send_FUJI_tape_block(size_t offset)
 {
     size_t r;
@@ -472,30 +452,8 @@ size_t sioCassette::send_FUJI_tape_block(size_t offset)
     len = hdr->chunk_length;
     Debug_printf("Baud: %u Length: %u Gap: %u ", baud, len, gap);
 
-    // TO DO : turn on LED
-    fnLedManager.set(eLed::LED_BUS, true);
-    while (gap)
-    {
-#ifdef ESP_PLATFORM
-        gap--;
-        fnSystem.delay_microseconds(999); // shave off a usec for the MOTOR pin check
-#else
-        int step;
-        // FN_BUS_LINK is fnSioCom
-        if (FN_BUS_LINK.get_sio_mode() == SioCom::sio_mode::NETSIO)
-            step = gap > 1000 ? 1000 : gap; // step is 1000 ms (NetSIO)
-        else
-            step = gap > 20 ? 20 : gap; // step is 20 ms (SerialSIO)
-        gap -= step;
-        FN_BUS_LINK.bus_idle(step); // idle bus (i.e. delay for SerialSIO, BUS_IDLE message for NetSIO)
-#endif
-        if (has_pulldown() && !motor_line() && gap > 1000)
-        {
-            fnLedManager.set(eLed::LED_BUS, false);
-            return starting_offset;
-        }
-    }
-    fnLedManager.set(eLed::LED_BUS, false);
+    if (!wait_tape_gap(gap))
+        return starting_offset;
 
     // wait until after delay for new line so can see it in timestamp
     Debug_printf("\r\n");
@@ -552,6 +510,36 @@ size_t sioCassette::send_FUJI_tape_block(size_t offset)
     return (offset);
 }
 
+// offset is the WAV frame position + 1, so that 0 still means start/end of tape
+size_t sioCassette::send_WAV_tape_block(size_t offset)
+{
+    size_t pos = offset == 0 ? 0 : offset - 1;
+    uint16_t gap, wav_baud;
+
+    size_t len = wav.read_block(&pos, atari_sector_buffer, sizeof(atari_sector_buffer), &gap, &wav_baud);
+    if (len == 0)
+    {
+        Debug_println("CASSETTE END");
+        return 0;
+    }
+
+    block++;
+    Debug_printf("Block %u Baud: %u Length: %u Gap: %u\r\n", block, wav_baud, (unsigned)len, gap);
+    if (wav_baud != baud)
+    {
+        baud = wav_baud;
+        FN_BUS_LINK.set_baudrate(baud);
+    }
+
+    if (!wait_tape_gap(gap))
+        return offset; // motor stopped, play this record again next time
+
+    FN_BUS_LINK.write(atari_sector_buffer, len);
+    FN_BUS_LINK.flush(); // wait for all data to be sent just like a tape
+
+    return pos + 1;
+}
+
 size_t sioCassette::receive_FUJI_tape_block(size_t offset)
 {
 #ifdef ESP_PLATFORM
@@ -646,4 +634,5 @@ uint8_t sioCassette::decode_fsk()
     // Debug_printf("%u\n", out);
     return out;
 }
+
 #endif /* BUILD_ATARI */
@@ -6,61 +6,16 @@
 #include "bus.h"
 #include "fnSystem.h"
 #include "fnio.h"
+#include "cassetteDecode.h"
 
-#define CASSETTE_BAUDRATE 600
 #define BLOCK_LEN 128
 
-#define STARTBIT 0
-#define STOPBIT 9
-
 enum class cassette_mode_t
 {
     playback = 0,
     record
 };
 
-// software uart conops for cassette
-// wait for falling edge and set fsk_clock
-// find next falling edge and compute period
-// check if period different than last (reset denoise counter)
-// if not different, increment denoise counter if < denoise threshold
-// when denoise counter == denoise threshold, set demod output
-
-// if state counter == 0, check demod output for start bit edge (low voltage, logic high)
-// if start bit edge, record time in baud_clock;
-// wait 1/2 period and then read demod output (check it is start bit)
-// wait 1 period and get (next) first bit, (shift received byte to right) store it in received_byte;
-// increment state counter; go back and wait
-// when all 8 bits received wait one more period and check for stop bit
-// if not stop bit, throw a frame sync error
-// if stop bit, store byte in buffer, reset some stuff,
-
-class softUART
-{
-protected:
-    uint64_t baud_clock;
-    uint16_t baud = CASSETTE_BAUDRATE;             // bps
-    uint32_t period = 1000000 / CASSETTE_BAUDRATE; // microseconds
-
-    uint8_t demod_output;
-    uint8_t denoise_counter;
-    uint8_t denoise_threshold = 3;
-
-    uint8_t received_byte;
-    uint8_t state_counter;
-
-    uint8_t buffer[256];
-    uint8_t index_in = 0;
-    uint8_t index_out = 0;
-
-public:
-    uint8_t available();
-    void set_baud(uint16_t b);
-    uint16_t get_baud() { return baud; };
-    uint8_t read();
-    int8_t service(uint8_t b);
-};
-
 class sioCassette : public virtualDevice
 {
 protected:
@@ -128,8 +83,11 @@ private:
     {
         unsigned char FUJI : 1;
         unsigned char turbo : 1;
+        unsigned char WAV : 1;
     } tape_flags;
 
+    wavTape wav;
+
     uint8_t atari_sector_buffer[256];
 
     void Clear_atari_sector_buffer(uint16_t len);
@@ -139,7 +97,9 @@ private:
 
     size_t send_tape_block(size_t offset);
     void check_for_FUJI_file();
+    bool wait_tape_gap(uint16_t gap);
     size_t send_FUJI_tape_block(size_t offset);
+    size_t send_WAV_tape_block(size_t offset);
     size_t receive_FUJI_tape_block(size_t offset);
 };
 
@@ -0,0 +1,367 @@
+#ifdef BUILD_ATARI
+
+#include "cassetteDecode.h"
+
+#include <cstring>
+#include <cmath>
+
+#include "../../include/debug.h"
+
+#include "fnSystem.h"
+
+uint8_t softUART::available()
+{
+    return index_in - index_out;
+}
+
+void softUART::set_baud(uint16_t b)
+{
+    baud = b;
+    period = 1000000 / baud;
+};
+
+uint8_t softUART::read()
+{
+    return buffer[index_out++];
+}
+
+void softUART::reset()
+{
+    state_counter = STARTBIT;
+    index_in = 0;
+    index_out = 0;
+}
+
+int8_t softUART::service(uint8_t b)
+{
+    return service(b, fnSystem.micros());
+}
+
+int8_t softUART::service(uint8_t b, uint64_t t)
+{
+    uint32_t sample_offset = period * sample_quarters / 4;
+    if (state_counter == STARTBIT)
+    {
+        if (b == 1)
+        { // found start bit - sync up clock
+            state_counter++;
+            received_byte = 0; // clear data
+            baud_clock = t;    // approx beginning of start bit
+//            Debug_println("Start bit received!");
+        }
+    }
+    else if (t > baud_clock + period * state_counter + sample_offset)
+    {
+        if (t < baud_clock + period * state_counter + sample_offset + 2 * period)
+        {
+            if (state_counter == STOPBIT)
+            {
+                buffer[index_in++] = received_byte;
+                state_counter = STARTBIT;
+//                Debug_printf("received %02X\n", received_byte);
+                if (b != 0)
+                {
+                    Debug_println("Stop bit invalid!");
+                    return -1; // frame sync error
+                }
+            }
+            else
+            {
+                uint8_t bb = (b == 1) ? 0 : 1;
+                received_byte |= (bb << (state_counter - 1));
+                state_counter++;
+//                Debug_printf("bit %u ", state_counter - 1);
+//                Debug_printf("%u\n ", b);
+            }
+        }
+        else
+        {
+            Debug_println("Bit slip error!");
+            state_counter = STARTBIT;
+            return -1; // frame sync error
+        }
+    }
+    return 0;
+}
+
+
+//************************************************************************************************************
+// WAV tape decoding
+
+#define WAV_FREQ_SPACE 3995
+#define WAV_FREQ_MARK 5327
+#define WAV_GAP_BITS 20    // this many idle bit times end a record
+#define WAV_MIN_LEVEL 300  // minimum signal amplitude to be taken as carrier
+
+static int16_t wav_sine[256];
+
+static uint16_t wav_le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t wav_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool wavTape::open(fnFile *f)
+{
+    uint8_t hdr[12];
+
+    _file = nullptr;
+    fnio::fseek(f, 0, SEEK_SET);
+    if (fnio::fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) ||
+        memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0)
+        return false;
+
+    // walk the chunks for "fmt " and "data"
+    bool have_fmt = false;
+    size_t offset = sizeof(hdr);
+    while (true)
+    {
+        uint8_t chunk[24];
+        fnio::fseek(f, offset, SEEK_SET);
+        if (fnio::fread(chunk, 1, 8, f) != 8)
+            return false;
+        uint32_t len = wav_le32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0)
+        {
+            if (len < 16 || fnio::fread(chunk + 8, 1, 16, f) != 16)
+                return false;
+            uint16_t format = wav_le16(chunk + 8);
+            _channels = wav_le16(chunk + 10);
+            _sample_rate = wav_le32(chunk + 12);
+            _bits = wav_le16(chunk + 22);
+            // PCM or WAVE_FORMAT_EXTENSIBLE, 8 or 16 bit
+            if ((format != 1 && format != 0xFFFE) || (_bits != 8 && _bits != 16) ||
+                _channels == 0 || _sample_rate < 2 * WAV_FREQ_MARK)
+            {
+                Debug_printf("Unsupported WAV format %u, %u bits, %u Hz\r\n", format, _bits, (unsigned)_sample_rate);
+                return false;
+            }
+            _frame_size = _channels * _bits / 8;
+            have_fmt = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!have_fmt)
+                return false;
+            _data_offset = offset + 8;
+            _num_frames = len / _frame_size;
+            break;
+        }
+        offset += 8 + len + (len & 1);
+    }
+
+    if (wav_sine[64] == 0)
+    {
+        for (int i = 0; i < 256; i++)
+            wav_sine[i] = (int16_t)lround(16384 * sin(2 * M_PI * i / 256));
+    }
+
+    // about 1 ms of samples: long enough to tell the tones apart,
+    // short enough for 600 baud bits (1.67 ms) to stand out
+    _window = _sample_rate / 1000;
+    if (_window > WAV_MAX_WINDOW)
+        _window = WAV_MAX_WINDOW;
+    _step_mark = (uint32_t)(((uint64_t)WAV_FREQ_MARK << 32) / _sample_rate);
+    _step_space = (uint32_t)(((uint64_t)WAV_FREQ_SPACE << 32) / _sample_rate);
+
+    _file = f;
+    _pcm_count = 0;
+    _uart.set_baud(CASSETTE_BAUDRATE);
+    _uart.set_sample_point(2); // sample mid-bit, the filter output has clean edges
+    Debug_printf("WAV tape: %u Hz, %u bits, %u channel(s), %u frames\r\n",
+                 (unsigned)_sample_rate, _bits, _channels, (unsigned)_num_frames);
+    return true;
+}
+
+bool wavTape::load_block(size_t frame)
+{
+    uint8_t raw[WAV_BLOCK_FRAMES * 4];
+    size_t frames = WAV_BLOCK_FRAMES;
+    size_t max_frames = sizeof(raw) / _frame_size;
+
+    if (frames > max_frames)
+        frames = max_frames;
+    if (frames > _num_frames - frame)
+        frames = _num_frames - frame;
+
+    fnio::fseek(_file, _data_offset + frame * _frame_size, SEEK_SET);
+    frames = fnio::fread(raw, _frame_size, frames, _file);
+
+    // keep the first channel, as signed 16 bit
+    if (_bits == 16)
+        for (size_t i = 0; i < frames; i++)
+            _pcm[i] = (int16_t)wav_le16(raw + i * _frame_size);
+    else
+        for (size_t i = 0; i < frames; i++)
+            _pcm[i] = (int16_t)((raw[i * _frame_size] - 128) << 8);
+
+    _pcm_start = frame;
+    _pcm_count = frames;
+    return frames > 0;
+}
+
+void wavTape::reset_demod()
+{
+    memset(_ring, 0, sizeof(_ring));
+    memset(_acc, 0, sizeof(_acc));
+    _ring_pos = 0;
+    _phase_mark = 0;
+    _phase_space = 0;
+    _demod = 0;
+    _uart.reset();
+}
+
+// Baud rate from the 20 alternating bits of two 0x55 sync bytes, 0 if the edges
+// aren't evenly spaced. Edges 0 and 18 are both space edges, which keeps any
+// difference in filter delay between rising and falling edges out of it.
+uint32_t wavTape::sync_baud(const size_t *edges)
+{
+    size_t span = edges[18] - edges[0];
+    for (int i = 0; i < 18; i++)
+    {
+        size_t bit = (edges[i + 1] - edges[i]) * 18;
+        if (bit < span / 2 || bit > span * 3 / 2)
+            return 0;
+    }
+    return (uint64_t)_sample_rate * 18 / span;
+}
+
+// Returns 1 for space (logic 0, start bit) and 0 for mark or no carrier,
+// the same convention as sioCassette::decode_fsk()
+uint8_t wavTape::demodulate(int16_t x)
+{
+    int32_t *slot = _ring[_ring_pos];
+    int32_t term[5];
+
+    term[0] = (x * wav_sine[(_phase_mark >> 24) & 0xFF]) >> 8;
+    term[1] = (x * wav_sine[((_phase_mark >> 24) + 64) & 0xFF]) >> 8;
+    term[2] = (x * wav_sine[(_phase_space >> 24) & 0xFF]) >> 8;
+    term[3] = (x * wav_sine[((_phase_space >> 24) + 64) & 0xFF]) >> 8;
+    term[4] = (x * x) >> 10;
+    _phase_mark += _step_mark;
+    _phase_space += _step_space;
+
+    for (int i = 0; i < 5; i++)
+    {
+        _acc[i] += term[i] - slot[i];
+        slot[i] = term[i];
+    }
+    if (++_ring_pos == _window)
+        _ring_pos = 0;
+
+    int64_t p_mark = (int64_t)_acc[0] * _acc[0] + (int64_t)_acc[1] * _acc[1];
+    int64_t p_space = (int64_t)_acc[2] * _acc[2] + (int64_t)_acc[3] * _acc[3];
+    int64_t energy = (int64_t)_acc[4] * _window;
+
+    // carrier: loud enough, and most of the energy is in our two tones
+    // (a pure tone gives p = energy << 21)
+    if (_acc[4] < (int32_t)_window * (WAV_MIN_LEVEL * WAV_MIN_LEVEL / 2048) ||
+        p_mark + p_space < (energy << 19))
+        _demod = 0;
+    else if (_demod == 0 && p_space * 2 > p_mark * 3)
+        _demod = 1;
+    else if (_demod == 1 && p_mark * 2 > p_space * 3)
+        _demod = 0;
+
+    return _demod;
+}
+
+size_t wavTape::read_block(size_t *pos, uint8_t *buf, size_t maxlen, uint16_t *irg_ms, uint16_t *baud)
+{
+    if (_file == nullptr)
+        return 0;
+
+    size_t frame = *pos;
+    size_t count = 0;
+    size_t start_frame = frame; // start bit edge of the first byte
+    size_t last_byte = frame;   // frame at which the last byte completed
+    size_t sync_edges[20];      // bit edges from the first start bit on, for the baud rate
+    int num_edges = 0;
+    bool retimed = false;
+    uint8_t last_bit = 0;
+    size_t gap_frames = (size_t)_sample_rate * WAV_GAP_BITS / CASSETTE_BAUDRATE;
+
+    reset_demod();
+
+    while (frame < _num_frames && count < maxlen)
+    {
+        if (frame < _pcm_start || frame >= _pcm_start + _pcm_count)
+        {
+            if (!load_block(frame))
+                break;
+        }
+
+        uint8_t bit = demodulate(_pcm[frame - _pcm_start]);
+        if (bit != last_bit)
+        {
+            // a space edge while idle may be the first start bit
+            if (bit == 1 && count == 0 && _uart.idle())
+            {
+                start_frame = frame;
+                num_edges = 0;
+            }
+            if (count < 2 && num_edges < 20)
+                sync_edges[num_edges++] = frame;
+            last_bit = bit;
+        }
+
+        // Once the sync bytes have gone by, check the tape speed. If it's off by more
+        // than a couple of percent, decode the record again at the measured rate.
+        if (num_edges == 20 && !retimed)
+        {
+            retimed = true;
+            uint32_t measured = sync_baud(sync_edges);
+            if (measured != 0 && (measured * 50 < _uart.get_baud() * 49 || measured * 49 > _uart.get_baud() * 50))
+            {
+                _uart.set_baud(measured);
+                reset_demod();
+                frame = start_frame > 2 * _window ? start_frame - 2 * _window : 0;
+                count = 0;
+                num_edges = 0;
+                last_bit = 0;
+                continue;
+            }
+        }
+
+        if (_uart.service(bit, (uint64_t)frame * 1000000 / _sample_rate) < 0 && count == 0)
+            _uart.reset(); // noise ahead of the record, not a real byte
+        if (_uart.available())
+        {
+            buf[count++] = _uart.read();
+            last_byte = frame;
+        }
+        else if (count > 0 && frame - last_byte > gap_frames && _uart.idle())
+            break;
+
+        frame++;
+    }
+
+    if (count == 0)
+    {
+        *pos = frame;
+        return 0;
+    }
+    // resume right after the last byte so the next gap is measured in full
+    size_t begin = *pos;
+    *pos = last_byte + 1;
+
+    uint64_t irg = (uint64_t)(start_frame - begin) * 1000 / _sample_rate;
+    *irg_ms = irg > 0xFFFF ? 0xFFFF : irg;
+
+    *baud = _uart.get_baud();
+    if (count >= 2 && buf[0] == 0x55 && buf[1] == 0x55 && num_edges == 20)
+    {
+        uint32_t measured = sync_baud(sync_edges);
+        if (measured != 0)
+            *baud = measured;
+    }
+
+    return count;
+}
+
+#endif /* BUILD_ATARI */
@@ -0,0 +1,121 @@
+#ifndef CASSETTE_DECODE_H
+#define CASSETTE_DECODE_H
+
+// Decoding the Atari's tape signal, apart from the bus so it can be tested
+// on its own: the software UART the cassette runs on FSK bits, and the WAV
+// image reader built on it.
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "fnio.h"
+
+#define CASSETTE_BAUDRATE 600
+
+#define STARTBIT 0
+#define STOPBIT 9
+
+// software uart conops for cassette
+// wait for falling edge and set fsk_clock
+// find next falling edge and compute period
+// check if period different than last (reset denoise counter)
+// if not different, increment denoise counter if < denoise threshold
+// when denoise counter == denoise threshold, set demod output
+
+// if state counter == 0, check demod output for start bit edge (low voltage, logic high)
+// if start bit edge, record time in baud_clock;
+// wait 1/2 period and then read demod output (check it is start bit)
+// wait 1 period and get (next) first bit, (shift received byte to right) store it in received_byte;
+// increment state counter; go back and wait
+// when all 8 bits received wait one more period and check for stop bit
+// if not stop bit, throw a frame sync error
+// if stop bit, store byte in buffer, reset some stuff,
+
+class softUART
+{
+protected:
+    uint64_t baud_clock;
+    uint16_t baud = CASSETTE_BAUDRATE;             // bps
+    uint32_t period = 1000000 / CASSETTE_BAUDRATE; // microseconds
+
+    uint8_t demod_output;
+    uint8_t denoise_counter;
+    uint8_t denoise_threshold = 3;
+
+    uint8_t received_byte;
+    uint8_t state_counter = STARTBIT;
+    uint8_t sample_quarters = 1; // where in a bit period to sample, in quarter periods
+
+    uint8_t buffer[256];
+    uint8_t index_in = 0;
+    uint8_t index_out = 0;
+
+public:
+    uint8_t available();
+    void set_baud(uint16_t b);
+    uint16_t get_baud() { return baud; };
+    void set_sample_point(uint8_t quarters) { sample_quarters = quarters; };
+    void reset();
+    bool idle() { return state_counter == STARTBIT; };
+    uint8_t read();
+    int8_t service(uint8_t b);
+    int8_t service(uint8_t b, uint64_t t); // t in microseconds
+};
+
+// WAV tape image decoder
+// Reads PCM in blocks and demodulates the Atari FSK tones (3995 Hz space,
+// 5327 Hz mark) with a sliding-window Goertzel filter per tone. The bit
+// stream goes through a softUART running on sample time, and bytes are
+// grouped into records by the inter-record gaps, like a FUJI "data" chunk.
+#define WAV_BLOCK_FRAMES 512
+#define WAV_MAX_WINDOW 256
+
+class wavTape
+{
+private:
+    fnFile *_file = nullptr;
+    uint32_t _sample_rate = 0;
+    uint16_t _channels = 0;
+    uint16_t _bits = 0;
+    uint16_t _frame_size = 0;
+    size_t _data_offset = 0;
+    size_t _num_frames = 0;
+
+    // PCM block buffer (first channel only, as signed 16 bit)
+    int16_t _pcm[WAV_BLOCK_FRAMES];
+    size_t _pcm_start = 0;
+    size_t _pcm_count = 0;
+
+    // Sliding Goertzel state, one I/Q pair per tone. The per-sample terms are
+    // kept in a ring so they can be subtracted exactly when they leave the window.
+    uint16_t _window = 0;
+    uint16_t _ring_pos = 0;
+    uint32_t _phase_mark = 0;
+    uint32_t _phase_space = 0;
+    uint32_t _step_mark = 0;
+    uint32_t _step_space = 0;
+    int32_t _ring[WAV_MAX_WINDOW][5];
+    int32_t _acc[5];
+    uint8_t _demod = 0;
+
+    softUART _uart;
+
+    void reset_demod();
+    uint8_t demodulate(int16_t x);
+    uint32_t sync_baud(const size_t *edges);
+    bool load_block(size_t frame);
+
+public:
+    // Parse the RIFF header, returns false if this isn't a usable PCM WAV file
+    bool open(fnFile *f);
+    bool is_open() { return _file != nullptr; };
+    size_t num_frames() { return _num_frames; };
+    uint32_t sample_rate() { return _sample_rate; };
+
+    // Decode the next record starting at frame *pos and advance *pos past it.
+    // Returns the number of bytes, 0 at the end of the tape. irg_ms is the gap
+    // before the record, baud is measured from the 0x55 0x55 sync bytes.
+    size_t read_block(size_t *pos, uint8_t *buf, size_t maxlen, uint16_t *irg_ms, uint16_t *baud);
+};
+
+#endif // CASSETTE_DECODE_H
@@ -33,6 +33,9 @@
 
 #include "base64.h"
 #include "hash.h"
+#include "fujiHostCopy.h"
+#include "fujiHostHash.h"
+#include "fujiDirBlock.h"
 
 #define ADDITIONAL_DETAILS_BYTES 10
 
@@ -543,6 +546,8 @@ void sioFuji::sio_set_boot_config()
 }
 
 // Do SIO copy
+// Setting bit 7 of aux1 returns as soon as the copy has started, progress is
+// then read with COPY STATUS. Otherwise the command completes with the copy.
 void sioFuji::sio_copy_file()
 {
     uint8_t csBuf[256];
@@ -550,19 +555,10 @@ void sioFuji::sio_copy_file()
     std::string sourcePath;
     std::string destPath;
     uint8_t ck;
-    fnFile *sourceFile;
-    fnFile *destFile;
-    char *dataBuf;
     unsigned char sourceSlot;
     unsigned char destSlot;
-
-    dataBuf = (char *)malloc(532);
-
-    if (dataBuf == nullptr)
-    {
-        sio_error();
-        return;
-    }
+    bool background = (cmdFrame.aux1 & 0x80) != 0;
+    uint8_t sourceAux = cmdFrame.aux1 & 0x7F;
 
     memset(&csBuf, 0, sizeof(csBuf));
 
@@ -571,7 +567,6 @@ void sioFuji::sio_copy_file()
     if (ck != sio_checksum(csBuf, sizeof(csBuf)))
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
@@ -583,25 +578,22 @@ void sioFuji::sio_copy_file()
     if (copySpec.empty() || copySpec.find_first_of("|") == std::string::npos)
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
-    if (cmdFrame.aux1 < 1 || cmdFrame.aux1 > 8)
+    if (sourceAux < 1 || sourceAux > 8)
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
     if (cmdFrame.aux2 < 1 || cmdFrame.aux2 > 8)
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
-    sourceSlot = cmdFrame.aux1 - 1;
+    sourceSlot = sourceAux - 1;
     destSlot = cmdFrame.aux2 - 1;
 
     // All good, after this point...
@@ -618,71 +610,90 @@ void sioFuji::sio_copy_file()
         destPath += sourceFilename;
     }
 
-    // Mount hosts, if needed.
-    _fnHosts[sourceSlot].mount();
-    _fnHosts[destSlot].mount();
-
-    // Open files...
-    sourceFile = _fnHosts[sourceSlot].fnfile_open(sourcePath.c_str(), (char *)sourcePath.c_str(), sourcePath.size() + 1, FILE_READ);
-
-    if (sourceFile == nullptr)
+    if (!hostCopy.start(&_fnHosts[sourceSlot], sourcePath.c_str(), &_fnHosts[destSlot], destPath.c_str()))
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
-    destFile = _fnHosts[destSlot].fnfile_open(destPath.c_str(), (char *)destPath.c_str(), destPath.size() + 1, FILE_WRITE);
-
-    if (destFile == nullptr)
+    if (background)
     {
-        sio_error();
-        fnio::fclose(sourceFile);
-        free(dataBuf);
+        sio_complete();
         return;
     }
 
-    size_t readCount = 0;
-    size_t readTotal = 0;
-    size_t writeCount = 0;
-    size_t expected = _fnHosts[sourceSlot].file_size(sourceFile); // get the filesize
-    bool err = false;
-    do
+    if (hostCopy.wait())
     {
-        readCount = fnio::fread(dataBuf, 1, 532, sourceFile);
-        readTotal += readCount;
-        // Check if we got enough bytes on the read
-        if (readCount < 532 && readTotal != expected)
-        {
-            err = true;
-            break;
-        }
-        writeCount = fnio::fwrite(dataBuf, 1, readCount, destFile);
-        // Check if we sent enough bytes on the write
-        if (writeCount != readCount)
-        {
-            err = true;
-            break;
-        }
-        Debug_printf("Copy File: %d bytes of %d\n", readTotal, expected);
-    } while (readTotal < expected);
+        sio_complete();
+        return;
+    }
 
-    if (err == true)
+    // Remove the destination file and error, unless it was only paused
+    Debug_printf("Copy File Error! %s at %lu of %lu bytes\n", hostCopy.state_name(),
+                 (unsigned long)hostCopy.copied(), (unsigned long)hostCopy.total());
+    hostCopy.remove_destination();
+    sio_error();
+}
+
+// Progress of the current or last copy
+void sioFuji::sio_copy_status()
+{
+    uint8_t status[12];
+    uint32_t copied = hostCopy.copied();
+    uint32_t total = hostCopy.total();
+    uint32_t rate = hostCopy.rate_kbs();
+    int percent = hostCopy.percent();
+
+    Debug_printf("FUJI: COPY STATUS\n");
+
+    status[0] = hostCopy.state();
+    status[1] = percent < 0 ? 0xFF : percent;
+    status[2] = copied & 0xFF;
+    status[3] = (copied >> 8) & 0xFF;
+    status[4] = (copied >> 16) & 0xFF;
+    status[5] = (copied >> 24) & 0xFF;
+    status[6] = total & 0xFF;
+    status[7] = (total >> 8) & 0xFF;
+    status[8] = (total >> 16) & 0xFF;
+    status[9] = (total >> 24) & 0xFF;
+    if (rate > 0xFFFF)
+        rate = 0xFFFF;
+    status[10] = rate & 0xFF;
+    status[11] = (rate >> 8) & 0xFF;
+
+    bus_to_computer(status, sizeof(status), false);
+}
+
+// aux1: 0 = cancel, 1 = pause, 2 = resume (also restarts a cancelled or failed copy where it stopped)
+void sioFuji::sio_copy_control()
+{
+    fujiHostCopy::copy_state state = hostCopy.state();
+
+    Debug_printf("FUJI: COPY CONTROL %u\n", cmdFrame.aux1);
+
+    if (state == fujiHostCopy::COPY_IDLE || state == fujiHostCopy::COPY_DONE)
     {
-        // Remove the destination file and error
-        _fnHosts[destSlot].file_remove((char *)destPath.c_str());
         sio_error();
-        Debug_printf("Copy File Error! wCount: %d, rCount: %d, rTotal: %d, Expect: %d\n", writeCount, readCount, readTotal, expected);
+        return;
     }
-    else
+
+    switch (cmdFrame.aux1)
     {
-        sio_complete();
+    case 0:
+        hostCopy.cancel();
+        break;
+    case 1:
+        hostCopy.pause();
+        break;
+    case 2:
+        hostCopy.resume();
+        break;
+    default:
+        sio_error();
+        return;
     }
 
-    // copyEnd:
-    fnio::fclose(sourceFile);
-    fnio::fclose(destFile);
-    free(dataBuf);
+    sio_complete();
 }
 
 // Mount all
@@ -692,60 +703,34 @@ void sioFuji::mount_all()
 int sioFuji::mount_all(bool siomode)
 #endif
 {
+    // Hosts are mounted and images opened all at once
+    bool error = _mount_all.run(_fnHosts, MAX_HOSTS, _fnDisks, MAX_DISK_DEVICES, "rb", "rb+");
     bool nodisks = true; // Check at the end if no disks are in a slot and disable config
 
-    for (int i = 0; i < 8; i++)
+    for (int i = 0; i < MAX_DISK_DEVICES; i++)
     {
         fujiDisk &disk = _fnDisks[i];
-        fujiHost &host = _fnHosts[disk.host_slot];
-        char flag[4] = {'r', 'b', 0, 0};
-
-        if (disk.access_mode == DISK_ACCESS_MODE_WRITE)
-            flag[2] = '+';
-
-        if (disk.host_slot != INVALID_HOST_SLOT && strlen(disk.filename) > 0)
-        {
-            nodisks = false; // We have a disk in a slot
-
-            if (host.mount() == false)
-            {
-#ifdef ESP_PLATFORM
-                sio_error();
-                return;
-#else
-                return _on_error(siomode);
-#endif
-            }
+        fujiMountReport *report = _mount_all.report(i);
 
-            Debug_printf("Selecting '%s' from host #%u as %s on D%u:\n",
-                         disk.filename, disk.host_slot, flag, i + 1);
+        if (report->result == MOUNT_EMPTY)
+            continue;
+        nodisks = false; // We have a disk in a slot
 
-            disk.fileh = host.fnfile_open(disk.filename, disk.filename, sizeof(disk.filename), flag);
+        if (report->result != MOUNT_OK)
+            continue;
 
-            if (disk.fileh == nullptr)
-            {
-#ifdef ESP_PLATFORM
-                sio_error();
-                return;
-#else
-                return _on_error(siomode);
-#endif
-            }
-
-            // We've gotten this far, so make sure our bootable CONFIG disk is disabled
-            boot_config = false;
-            status_wait_count = 0;
+        Debug_printf("Mounting '%s' from host #%u on D%u:\n", disk.filename, disk.host_slot, i + 1);
 
-            // We need the file size for loading XEX files and for CASSETTE, so get that too
-            disk.disk_size = host.file_size(disk.fileh);
+        // We've gotten this far, so make sure our bootable CONFIG disk is disabled
+        boot_config = false;
+        status_wait_count = 0;
 
-            // Set the host slot for high score mode
-            // TODO: Refactor along with mount disk image.
-            disk.disk_dev.host = &host;
+        // Set the host slot for high score mode
+        // TODO: Refactor along with mount disk image.
+        disk.disk_dev.host = disk.host;
 
-            // And now mount it
-            disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
-        }
+        // And now mount it
+        disk.disk_type = disk.disk_dev.mount(disk.fileh, disk.filename, disk.disk_size);
     }
 
     if (nodisks)
@@ -754,6 +739,16 @@ int sioFuji::mount_all(bool siomode)
         boot_config = false;
     }
 
+    if (error)
+    {
+#ifdef ESP_PLATFORM
+        sio_error();
+        return;
+#else
+        return _on_error(siomode);
+#endif
+    }
+
 #ifdef ESP_PLATFORM
     sio_complete();
 #else
@@ -1195,25 +1190,10 @@ void _set_additional_direntry_details(fsdir_entry_t *f, uint8_t *dest, uint8_t m
 // TODO: VERIFY THIS CODE. THE STASH SEEMED CORRUPT
 void sioFuji::sio_read_directory_block()
 {
-    // aux1 holds entry size for each record
+    // aux1 holds entry size for each record, aux2 the pages and options (see fujiDirBlock.h)
     uint8_t maxlen = cmdFrame.aux1;
 
-    // aux2:
-    // b0-2 = number of pages - 1 (i.e. 1 to 8)
-    // b3,4 = not used
-    // b5   = extended entry information (as per normal, adds 10 bytes of information to each entry at start)
-    // b6,7 = block mode marker already checked.
-
-    bool is_extended = ((cmdFrame.aux2 & 0x20) == 0x20);
-    uint8_t pages = (cmdFrame.aux2 & 0x07) + 1;
-
-    Debug_printf("Fuji cmd: READ DIRECTORY BLOCK (pages=%d, maxlen=%d, extended: %d)\n", pages, maxlen, is_extended);
-
-    std::vector<uint8_t> response;
-    std::vector<uint8_t> start_offsets; // holds all the offsets for each dir entry in the response
-    std::vector<uint8_t> data_block;    // the data for each dir entry. no terminator char needed as we track the offsets. Double 0x7f is end of dir, and no more entries will come
-
-    uint16_t response_max = pages * 256;
+    Debug_printf("Fuji cmd: READ DIRECTORY BLOCK (aux2=%02x, maxlen=%d)\n", cmdFrame.aux2, maxlen);
 
     if (_current_open_directory_slot == -1)
     {
@@ -1222,157 +1202,17 @@ void sioFuji::sio_read_directory_block()
         return;
     }
 
-    bool is_eod = false;
-    char current_entry[256];
-    uint16_t num_entries = 0;
-    uint16_t total_size = 9; // header bytes
+    uint8_t block[DIRBLOCK_MAX_SIZE];
+    uint16_t block_size = fuji_read_directory_block(&_fnHosts[_current_open_directory_slot], block, sizeof(block),
+                                                    maxlen, cmdFrame.aux2,
+                                                    ADDITIONAL_DETAILS_BYTES, _set_additional_direntry_details);
 
-    uint16_t initial_pos = _fnHosts[_current_open_directory_slot].dir_tell();
-
-    // keep filling buffers up until it can't fit another maxlen (plus header bytes etc)
-    // or we hit end of dir
-    while ( !is_eod && num_entries < 256 )
-    {
-        uint16_t additional_size = 0;
-        uint16_t pos_before_next = _fnHosts[_current_open_directory_slot].dir_tell();
-        fsdir_entry_t *f = _fnHosts[_current_open_directory_slot].dir_nextfile();
-        if (f == nullptr)
-        {
-            // reached end of dir
-            is_eod = true;
-            current_entry[0] = 0x7F;
-            current_entry[1] = 0x7F;
-            current_entry[2] = 0;
-            additional_size = 2;
-        }
-        else
-        {
-            Debug_printf("::read_direntry \"%s\"\n", f->filename);
-
-            int bufsize;
-            char *filenamedest = current_entry;
-
-            // If 0x80 is set on AUX2, send back additional information
-            if (is_extended)
-            {
-                _set_additional_direntry_details(f, (uint8_t *)current_entry, maxlen);
-                // Adjust remaining size of buffer and file path destination
-                bufsize = sizeof(current_entry) - ADDITIONAL_DETAILS_BYTES;
-                filenamedest = current_entry + ADDITIONAL_DETAILS_BYTES;
-            }
-            else
-            {
-                bufsize = maxlen;
-            }
-
-            int filelen = util_ellipsize(f->filename, filenamedest, bufsize);
-            additional_size = filelen + (is_extended ? ADDITIONAL_DETAILS_BYTES : 0);
-
-            // Add a slash at the end of directory entries
-            if (f->isDir && filelen < (bufsize - 2))
-            {
-                current_entry[filelen] = '/';
-                current_entry[filelen + 1] = '\0';
-                additional_size++;
-            }
-
-        }
-
-        // would this take us over the limit? 2 for start_offset bytes.
-        uint16_t new_size = total_size + 2 + additional_size;
-
-        if (new_size > response_max) {
-            Debug_printf("skipping add, would have taken us to %d size. additional was: %d\n", new_size, additional_size);
-            // reset to previous pos, and exit loop
-            _fnHosts[_current_open_directory_slot].dir_seek(pos_before_next);
-            break;
-        } else {
-            Debug_printf("adding additional entry with size: %d\n", additional_size);
-        }
-
-
-        start_offsets.push_back(static_cast<uint8_t>(data_block.size() & 0xFF)); // lo byte of current size (which is same as offset)
-        start_offsets.push_back(static_cast<uint8_t>((data_block.size() >> 8) & 0xFF)); // high byte
-
-        // add the string to the data block without the terminating null
-        if (is_extended)
-        {
-            // strlen doesn't work as we have prepended some additional information
-            // add the additional bytes first
-            for(int i=0; i < ADDITIONAL_DETAILS_BYTES; i++)
-            {
-                data_block.push_back(static_cast<uint8_t>(current_entry[i]));
-            }
-            // Then add the string part
-            //int s_len = std::strlen(current_entry + ADDITIONAL_DETAILS_BYTES);
-            data_block.insert(data_block.end(), current_entry + ADDITIONAL_DETAILS_BYTES, current_entry + ADDITIONAL_DETAILS_BYTES + std::strlen(current_entry + ADDITIONAL_DETAILS_BYTES));
-        } else {
-            data_block.insert(data_block.end(), current_entry, current_entry + std::strlen(current_entry));
-        }
-
-        total_size = 9 + data_block.size() + start_offsets.size();
-        Debug_printf("current sizes, data: %d, offsets: %d, total: %d\n", data_block.size(), start_offsets.size(), data_block.size() + start_offsets.size());
-
-
-        num_entries++;
-    }
-
-    // ###################################################################
-    // CREATE THE RESPONSE BLOCK:
-    // ###################################################################
-    // byte 0-1 = "MF" (Multi-File, take your pick :D )
-    // byte 2   = Flags (currently 0x80 = Extended Information)
-    // byte 3   = Max Size Per Entry (maxlen from input)
-    // byte 4   = Num Entries in block (max 255)
-    // byte 5-6 = Total size of block (i.e. size without padding)
-    // byte 7-8 = First Position in block (i.e. dir pos value at start), allows up to 64k entries over all blocks
-    // Num Entries x 2 = Offsets in Data for each entry
-    // Data x Num Entries = data for each dir.
-    //
-    // All above is < pages x 256 in size
-
-    // HEADER BYTES
-    std::string headerBytes = "MF";
-    response.insert(response.end(), headerBytes.begin(), headerBytes.end());
-
-    // FLAGS
-    uint8_t header_flags = is_extended ? 0x80 : 0;  // more flags may come
-    response.push_back(header_flags);
-
-    // MAX SIZE PER ENTRY
-    response.push_back(maxlen);
-
-    // NUM ENTRIES
-    response.push_back(static_cast<uint8_t>(num_entries));
-
-    // Total size
-    int final_size = 9 + data_block.size() + start_offsets.size();
-    response.push_back(static_cast<uint8_t>(final_size & 0xFF));
-    response.push_back(static_cast<uint8_t>((final_size >> 8) & 0xFF));
-
-    // INITIAL POS VALUE
-    response.push_back(static_cast<uint8_t>(initial_pos & 0xFF));
-    response.push_back(static_cast<uint8_t>((initial_pos >> 8) & 0xFF));
-
-    // OFFSETS
-    response.insert(response.end(), start_offsets.begin(), start_offsets.end());
-
-    // DATA
-    response.insert(response.end(), data_block.begin(), data_block.end());
-
-    Debug_printf("Actual data size: %d to atari\n", response.size());
-    std::string s = util_hexdump(response.data(), response.size());
-    Debug_printf("dump: \n%s\n", s.c_str());
-
-    // buffer with 0s to requested size
-    response.resize(response_max, 0);
-
-    bus_to_computer(response.data(), response_max, false);
+    bus_to_computer(block, block_size, false);
 }
 
 void sioFuji::sio_read_directory_entry()
 {
-     if ((cmdFrame.aux2 & 0xC0) == 0xC0) {
+     if (DIRBLOCK_IS_BLOCK(cmdFrame.aux2)) {
         // Block mode directory entry
         sio_read_directory_block();
         return;
@@ -2201,28 +2041,22 @@ void sioFuji::sio_base64_encode_input()
 
     std::vector<unsigned char> p(len);
     bus_to_peripheral(p.data(), len);
-    base64.base64_buffer += std::string((const char *)p.data(), len);
+    base64.encode_input(p.data(), len);
     sio_complete();
 }
 
 void sioFuji::sio_base64_encode_compute()
 {
-    size_t out_len;
-
     Debug_printf("FUJI: BASE64 ENCODE COMPUTE\n");
 
-    std::unique_ptr<char[]> p = Base64::encode(base64.base64_buffer.c_str(), base64.base64_buffer.size(), &out_len);
-    if (!p)
+    if (!base64.encode_compute())
     {
         Debug_printf("base64_encode compute failed\n");
         sio_error();
         return;
     }
 
-    base64.base64_buffer.clear();
-    base64.base64_buffer = std::string(p.get(), out_len);
-
-    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", out_len);
+    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", base64.output_length());
     sio_complete();
 }
 
@@ -2230,7 +2064,7 @@ void sioFuji::sio_base64_encode_length()
 {
     Debug_printf("FUJI: BASE64 ENCODE LENGTH\n");
 
-    size_t l = base64.base64_buffer.length();
+    size_t l = base64.output_length();
     uint8_t response[4] = {
         (uint8_t)(l >>  0),
         (uint8_t)(l >>  8),
@@ -2260,9 +2094,9 @@ void sioFuji::sio_base64_encode_output()
         Debug_printf("Refusing to send a zero byte buffer. Aborting\n");
         return;
     }
-    else if (len > base64.base64_buffer.length())
+    else if (len > base64.output_length())
     {
-        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.base64_buffer.length());
+        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.output_length());
         return;
     }
     else
@@ -2271,9 +2105,7 @@ void sioFuji::sio_base64_encode_output()
     }
 
     std::vector<unsigned char> p(len);
-    std::memcpy(p.data(), base64.base64_buffer.data(), len);
-    base64.base64_buffer.erase(0, len);
-    base64.base64_buffer.shrink_to_fit();
+    base64.output(p.data(), len);
 
     bus_to_computer(p.data(), len, false);
 }
@@ -2293,28 +2125,22 @@ void sioFuji::sio_base64_decode_input()
 
     std::vector<unsigned char> p(len);
     bus_to_peripheral(p.data(), len);
-    base64.base64_buffer += std::string((const char *)p.data(), len);
+    base64.decode_input((const char *)p.data(), len);
     sio_complete();
 }
 
 void sioFuji::sio_base64_decode_compute()
 {
-    size_t out_len;
-
     Debug_printf("FUJI: BASE64 DECODE COMPUTE\n");
 
-    std::unique_ptr<unsigned char[]> p = Base64::decode(base64.base64_buffer.c_str(), base64.base64_buffer.size(), &out_len);
-    if (!p)
+    if (!base64.decode_compute())
     {
         Debug_printf("base64_encode compute failed\n");
         sio_error();
         return;
     }
 
-    base64.base64_buffer.clear();
-    base64.base64_buffer = std::string((const char *)p.get(), out_len);
-
-    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", out_len);
+    Debug_printf("Resulting BASE64 encoded data is: %u bytes\n", base64.output_length());
     sio_complete();
 }
 
@@ -2322,7 +2148,7 @@ void sioFuji::sio_base64_decode_length()
 {
     Debug_printf("FUJI: BASE64 DECODE LENGTH\n");
 
-    size_t len = base64.base64_buffer.length();
+    size_t len = base64.output_length();
     uint8_t response[4] = {
         (uint8_t)(len >>  0),
         (uint8_t)(len >>  8),
@@ -2354,9 +2180,9 @@ void sioFuji::sio_base64_decode_output()
         sio_error();
         return;
     }
-    else if (len > base64.base64_buffer.length())
+    else if (len > base64.output_length())
     {
-        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.base64_buffer.length());
+        Debug_printf("Requested %u bytes, but buffer is only %u bytes, aborting.\n", len, base64.output_length());
         sio_error();
         return;
     }
@@ -2366,9 +2192,7 @@ void sioFuji::sio_base64_decode_output()
     }
 
     std::vector<unsigned char> p(len);
-    memcpy(p.data(), base64.base64_buffer.data(), len);
-    base64.base64_buffer.erase(0, len);
-    base64.base64_buffer.shrink_to_fit();
+    base64.output(p.data(), len);
     bus_to_computer(p.data(), len, false);
 }
 
@@ -2385,6 +2209,12 @@ void sioFuji::sio_hash_input()
 
     std::vector<unsigned char> p(len);
     bus_to_peripheral(p.data(), len);
+    if (hostHash.busy())
+    {
+        Debug_printf("A host file is being hashed. Aborting");
+        sio_error();
+        return;
+    }
     hasher.add_data(p);
     sio_complete();
 }
@@ -2392,6 +2222,11 @@ void sioFuji::sio_hash_input()
 void sioFuji::sio_hash_compute(bool clear_data)
 {
     Debug_printf("FUJI: HASH COMPUTE\n");
+    if (hostHash.busy())
+    {
+        sio_error();
+        return;
+    }
     algorithm = Hash::to_algorithm(sio_get_aux());
     hasher.compute(algorithm, clear_data);
     sio_complete();
@@ -2420,13 +2255,78 @@ void sioFuji::sio_hash_output()
     bus_to_computer(hashed_data.data(), hashed_data.size(), false);
 }
 
+/*
+ aux1 = the algorithms the following HASH INPUT will be computed with, bit n
+ for HASH COMPUTE's algorithm n (1 = MD5, 4 = SHA256...), 0 for all four.
+ The others come out empty. The set holds until the next HASH CLEAR.
+*/
 void sioFuji::sio_hash_clear()
 {
     Debug_printf("FUJI: HASH CLEAR\n");
-    hasher.clear();
+    hostHash.cancel();
+    hasher.clear(cmdFrame.aux1);
+    sio_complete();
+}
+
+/*
+ Feed a file on a host slot to the hasher, as if it had been sent with HASH INPUT
+ aux1 = host slot, aux2 = algorithm (as HASH COMPUTE, anything else keeps all four)
+ data frame = 256 byte path
+ Completes once the file is open and hashes it in the background. Poll HASH
+ STATUS until it is done, then fetch the digest with HASH COMPUTE/LENGTH/OUTPUT
+ as usual. HASH CLEAR cancels it.
+*/
+void sioFuji::sio_hash_host_file()
+{
+    char path[256];
+    uint8_t hostSlot = cmdFrame.aux1;
+
+    Debug_printf("FUJI: HASH HOST FILE\n");
+
+    memset(path, 0, sizeof(path));
+    uint8_t ck = bus_to_peripheral((uint8_t *)path, sizeof(path));
+
+    if (ck != sio_checksum((uint8_t *)path, sizeof(path)) || !_validate_host_slot(hostSlot, "sio_hash_host_file"))
+    {
+        sio_error();
+        return;
+    }
+    path[sizeof(path) - 1] = '\0';
+
+    // Fails if the host doesn't mount, the file doesn't open or a file is already being hashed
+    if (!hostHash.start(&_fnHosts[hostSlot], path, Hash::to_algorithm(cmdFrame.aux2)))
+    {
+        sio_error();
+        return;
+    }
+
     sio_complete();
 }
 
+// Progress of the current or last HASH HOST FILE
+void sioFuji::sio_hash_status()
+{
+    uint8_t status[10];
+    uint32_t hashed = hostHash.hashed();
+    uint32_t total = hostHash.total();
+    int percent = hostHash.percent();
+
+    Debug_printf("FUJI: HASH STATUS\n");
+
+    status[0] = hostHash.state();
+    status[1] = percent < 0 ? 0xFF : percent;
+    status[2] = hashed & 0xFF;
+    status[3] = (hashed >> 8) & 0xFF;
+    status[4] = (hashed >> 16) & 0xFF;
+    status[5] = (hashed >> 24) & 0xFF;
+    status[6] = total & 0xFF;
+    status[7] = (total >> 8) & 0xFF;
+    status[8] = (total >> 16) & 0xFF;
+    status[9] = (total >> 24) & 0xFF;
+
+    bus_to_computer(status, sizeof(status), false);
+}
+
 void sioFuji::sio_process(uint32_t commanddata, uint8_t checksum)
 {
     cmdFrame.commanddata = commanddata;
@@ -2652,6 +2552,22 @@ void sioFuji::sio_process(uint32_t commanddata, uint8_t checksum)
         sio_ack();
         sio_hash_clear();
         break;
+    case FUJICMD_HASH_HOST_FILE:
+        sio_late_ack();
+        sio_hash_host_file();
+        break;
+    case FUJICMD_COPY_STATUS:
+        sio_ack();
+        sio_copy_status();
+        break;
+    case FUJICMD_COPY_CONTROL:
+        sio_ack();
+        sio_copy_control();
+        break;
+    case FUJICMD_HASH_STATUS:
+        sio_ack();
+        sio_hash_status();
+        break;
     default:
         sio_nak();
     }
@@ -18,6 +18,7 @@
 #include "fujiHost.h"
 #include "fujiDisk.h"
 #include "fujiCmd.h"
+#include "fujiMountAll.h"
 
 #include "hash.h"
 
@@ -91,6 +92,8 @@ private:
 
     fujiDisk _fnDisks[MAX_DISK_DEVICES];
 
+    fujiMountAll _mount_all;
+
     sioCassette _cassetteDev;
 
     int _current_open_directory_slot = -1;
@@ -176,6 +179,10 @@ protected:
     void sio_hash_output();            // 0xC5
     void sio_get_adapter_config_extended(); // 0xC4
     void sio_hash_clear();             // 0xC2
+    void sio_hash_host_file();         // 0xC1
+    void sio_copy_status();            // 0xC0
+    void sio_copy_control();           // 0xBF
+    void sio_hash_status();            // 0xBE
 
     void sio_status() override;
     void sio_process(uint32_t commanddata, uint8_t checksum) override;
@@ -27,6 +27,7 @@
 #include "fnSystem.h"
 
 #include "pclink.h"
+#include "pclink_dir.h"
 
 #include "../../include/debug.h"
 
@@ -132,7 +133,7 @@ static struct
 	union
 	{
 		FILE *file;
-		DIR *dir;
+		PCL_DIRSNAP *snap;	/* directories: what dir_cache is built from */
 	} fps;
 
 	DIRENTRY *dir_cache;	/* used only for directories */
@@ -316,7 +317,7 @@ uexpand(uchar *rawname, char *name83)
 }
 
 static int
-match_dos_names(char *name, char *mask, uchar fatr1, struct stat *sb)
+match_dos_names(char *name, char *mask, uchar fatr1, mode_t mode)
 {
 	ushort i;
 
@@ -353,7 +354,7 @@ match_dos_names(char *name, char *mask, uchar fatr1, struct stat *sb)
 
 	if (fatr1 & RA_PROTECT)
 	{
-		if (sb->st_mode & (S_IWUSR|S_IWGRP))
+		if (mode & (S_IWUSR|S_IWGRP))
 		{
 			if (log_flag)
 				Debug_printf("atr mismatch: not PROTECTED\n");
@@ -364,7 +365,7 @@ match_dos_names(char *name, char *mask, uchar fatr1, struct stat *sb)
 
 	if (fatr1 & RA_NO_PROTECT)
 	{
-		if ((sb->st_mode & (S_IWUSR|S_IWGRP)) == 0)
+		if ((mode & (S_IWUSR|S_IWGRP)) == 0)
 		{
 			if (log_flag)
 				Debug_printf("atr mismatch: not UNPROTECTED\n");
@@ -375,7 +376,7 @@ match_dos_names(char *name, char *mask, uchar fatr1, struct stat *sb)
 
 	if (fatr1 & RA_SUBDIR)
 	{
-		if (!S_ISDIR(sb->st_mode))
+		if (!S_ISDIR(mode))
 		{
 			if (log_flag)
 				Debug_printf("atr mismatch: not SUBDIR\n");
@@ -386,7 +387,7 @@ match_dos_names(char *name, char *mask, uchar fatr1, struct stat *sb)
 
 	if (fatr1 & RA_NO_SUBDIR)
 	{
-		if (S_ISDIR(sb->st_mode))
+		if (S_ISDIR(mode))
 		{
 			if (log_flag)
 				Debug_printf("atr mismatch: not FILE\n");
@@ -440,55 +441,31 @@ validate_dos_name(char *fname)
 }
 
 static int
-check_dos_name(char *newpath, struct dirent *dp, struct stat *sb)
+skip_dos_name(const char *fname)
 {
-	char temp_fspec[1024], fname[256];
-
-	strcpy(fname, dp->d_name);
-
 	if (log_flag)
-		Debug_printf("%s: got fname '%s'\n", __func__, fname); 
-
-	if (validate_dos_name(fname))
-		return 1;
-
-	/* stat() the file (fetches the length) */
-	sprintf(temp_fspec, "%s/%s", newpath, fname);
+		Debug_printf("%s: got fname '%s'\n", __func__, fname);
 
-	if (log_flag)
-		Debug_printf("%s: stat '%s'\n", __func__, temp_fspec);
-
-	if (stat(temp_fspec, sb))
-	{
-		Debug_printf("cannot stat '%s'\n", temp_fspec);
-		return 1;
-	}
+	return validate_dos_name((char *)fname);
+}
 
-	if (!S_ISREG(sb->st_mode) && !S_ISDIR(sb->st_mode))
+/* Next entry of the snapshot from *pos on that matches mask and fatr1 */
+static PCL_DIRENT *
+snap_next(PCL_DIRSNAP *snap, ulong *pos, char *mask, uchar fatr1, char *raw_name)
+{
+	while (*pos < snap->count)
 	{
-		Debug_printf("'%s' is not regular file nor directory\n", temp_fspec);
-		return 1;
-	}
+		PCL_DIRENT *e = &snap->ent[(*pos)++];
 
-	/*if (sb->st_uid != our_uid)
-	{
-		Debug_printf("'%s' wrong uid\n", temp_fspec);
-		return 1;
-	}*/
+		/* convert 8+3 to NNNNNNNNXXX */
+		ugefina(e->name, raw_name);
 
-	if ((sb->st_mode & S_IRUSR) == 0)
-	{
-		Debug_printf("'%s' is unreadable\n", temp_fspec);
-		return 1;
+		/* match */
+		if (match_dos_names(raw_name, mask, fatr1, e->mode) == 0)
+			return e;
 	}
 
-	if (S_ISDIR(sb->st_mode) && ((sb->st_mode & S_IXUSR) == 0))
-	{
-		Debug_printf("dir '%s' is unbrowseable\n", temp_fspec);
-		return 1;
-	}
-
-	return 0;
+	return NULL;
 }
 
 static void
@@ -497,7 +474,7 @@ fps_close(int i)
 	if (iodesc[i].fps.file != NULL)
 	{
 		if (iodesc[i].fpmode & 0x10)
-			closedir(iodesc[i].fps.dir);
+			pcl_dir_release(iodesc[i].fps.snap);
 		else
 			fclose(iodesc[i].fps.file);
 	}
@@ -533,21 +510,11 @@ static ulong
 get_file_len(uchar handle)
 {
 	ulong filelen;
-	struct dirent *dp;
-	struct stat sb;
 
 	if (iodesc[handle].fpmode & 0x10)	/* directory */
 	{
-		rewinddir(iodesc[handle].fps.dir);
 		filelen = sizeof(DIRENTRY);
-
-		while ((dp = readdir(iodesc[handle].fps.dir)) != NULL)
-		{
-			if (check_dos_name(iodesc[handle].pathname, dp, &sb))
-				continue;
-			filelen += sizeof(DIRENTRY);
-		}
-		rewinddir(iodesc[handle].fps.dir);
+		filelen += iodesc[handle].fps.snap->count * sizeof(DIRENTRY);
 	}
 	else
 		filelen = iodesc[handle].fpstat.st_size;
@@ -564,10 +531,9 @@ cache_dir(uchar handle)
 	char *bs, *cwd;
 	uchar dirnode = 0x00;
 	ushort node;
-	ulong dlen, flen, sl, dirlen = iodesc[handle].fpstat.st_size;
+	ulong dlen, flen, sl, i, dirlen = iodesc[handle].fpstat.st_size;
 	DIRENTRY *dbuf, *dir;
-	struct dirent *dp;
-	struct stat sb;
+	PCL_DIRSNAP *snap = iodesc[handle].fps.snap;
 
 	if (iodesc[handle].dir_cache != NULL)
 	{
@@ -620,20 +586,18 @@ cache_dir(uchar handle)
 
 	node = 1;
 
-	while ((dp = readdir(iodesc[handle].fps.dir)) != NULL)
+	for (i = 0; snap != NULL && i < snap->count; i++)
 	{
 		ushort map;
+		PCL_DIRENT *e = &snap->ent[i];
 
-		if (check_dos_name(iodesc[handle].pathname, dp, &sb))
-			continue;
-
-		dlen = sb.st_size;
+		dlen = e->size;
 		if (dlen > SDX_MAXLEN)
 			dlen = SDX_MAXLEN;
 
-		dir->status = (sb.st_mode & (S_IWUSR|S_IWGRP)) ? 0x08 : 0x09;
+		dir->status = (e->mode & (S_IWUSR|S_IWGRP)) ? 0x08 : 0x09;
 
-		if (S_ISDIR(sb.st_mode))
+		if (S_ISDIR(e->mode))
 		{
 			dir->status |= 0x20;		/* directory */
 			dlen = sizeof(DIRENTRY);
@@ -648,9 +612,9 @@ cache_dir(uchar handle)
 		dir->len_m = (dlen & 0x0000ff00L) >> 8;
 		dir->len_h = (dlen & 0x00ff0000L) >> 16;
 
-		ugefina(dp->d_name, (char *)dir->fname);
+		ugefina(e->name, (char *)dir->fname);
 
-		unix_time_2_sdx(&sb.st_mtime, dir->stamp);
+		unix_time_2_sdx(&e->mtime, dir->stamp);
 
 		node++;
 		dir++;
@@ -911,7 +875,6 @@ do_pclink(uchar devno, uchar ccom, uchar caux1, uchar caux2)
 	ushort cunit = caux2 & 0x0f, parsize;
 	ulong faux;
 	struct stat sb;
-	struct dirent *dp;
 	static uchar old_ccom = 0;
 
 	if (caux2 & 0xf0)	/* protocol version number must be 0 */
@@ -1352,23 +1315,22 @@ do_pclink(uchar devno, uchar ccom, uchar caux1, uchar caux2)
 
 			do
 			{
-				struct stat ts;
+				mode_t mode = 0;
 
-				memset(&ts, 0, sizeof(ts));
 				memset(pcl_dbf.dirbuf, 0, sizeof(pcl_dbf.dirbuf));
 				iodesc[handle].fppos += dir_read(pcl_dbf.dirbuf, sizeof(pcl_dbf.dirbuf), handle, &eof_flg);
 
 				if (!eof_flg)
 				{
-					/* fake stat to satisfy match_dos_names() */
+					/* rebuild the mode bits match_dos_names() looks at */
 					if ((pcl_dbf.dirbuf[0] & 0x01) == 0)
-						ts.st_mode |= (S_IWUSR|S_IWGRP);
+						mode |= (S_IWUSR|S_IWGRP);
 					if (pcl_dbf.dirbuf[0] & 0x20)
-						ts.st_mode |= S_IFDIR;
+						mode |= S_IFDIR;
 					else
-						ts.st_mode |= S_IFREG;
+						mode |= S_IFREG;
 
-					match = !match_dos_names((char *)pcl_dbf.dirbuf+6, iodesc[handle].fpname, iodesc[handle].fatr1, &ts);
+					match = !match_dos_names((char *)pcl_dbf.dirbuf+6, iodesc[handle].fpname, iodesc[handle].fatr1, mode);
 				}
 
 			} while (!eof_flg && !match);
@@ -1439,6 +1401,9 @@ do_pclink(uchar devno, uchar ccom, uchar caux1, uchar caux2)
 
 		fps_close(handle);	/* this clears out iodesc[handle] */
 
+		if (fpmode & 0x08)
+			pcl_dir_invalidate_parent(pathname);
+
 		if (mtime && (fpmode & 0x08))
 		{
             utimbuf ub;
@@ -1495,7 +1460,6 @@ do_pclink(uchar devno, uchar ccom, uchar caux1, uchar caux2)
 		}
 		else	/* ccom not 'P', execution stage */
 		{
-			DIR *dh;
 			uchar i;
 			long sl;
 			struct stat tempstat;
@@ -1562,49 +1526,43 @@ do_pclink(uchar devno, uchar ccom, uchar caux1, uchar caux2)
 				goto complete_fopen;
 			}
 
-			dh = opendir(newpath);
-
 			if (device[cunit].parbuf.fmode & 0x10)
 			{
-				iodesc[i].fps.dir = dh;
+				iodesc[i].fps.snap = pcl_dir_snapshot(newpath, skip_dos_name);
 				memcpy(&sb, &tempstat, sizeof(sb));
 			}
 			else
 			{
-				while ((dp = readdir(dh)) != NULL)
-				{
-					if (check_dos_name(newpath, dp, &sb))
-						continue;
-		
-					/* convert 8+3 to NNNNNNNNXXX */
-					ugefina(dp->d_name, raw_name);
-
-					/* match */
-					if (match_dos_names(raw_name, \
-						(char *)device[cunit].parbuf.name, \
-							device[cunit].parbuf.fatr1, &sb) == 0)
-						break;
-				}
+				PCL_DIRSNAP *snap = pcl_dir_snapshot(newpath, skip_dos_name);
+				PCL_DIRENT *e = NULL;
+				ulong pos = 0;
+
+				if (snap != NULL)
+					e = snap_next(snap, &pos, (char *)device[cunit].parbuf.name, \
+						device[cunit].parbuf.fatr1, raw_name);
 
 				sl = strlen(newpath);
 				if (sl && (newpath[sl-1] != '/'))
 					strcat(newpath, "/");
 
-				if (dp)
+				if (e)
 				{
-					strcat(newpath, dp->d_name);
-					ugefina(dp->d_name, raw_name);
+					strcat(newpath, e->name);
+					memset(&sb, 0, sizeof(struct stat));
+					sb.st_mode = e->mode;
+					sb.st_size = e->size;
+					sb.st_mtime = e->mtime;
 					if ((device[cunit].parbuf.fmode & 0x0c) == 0x08)
 						sb.st_mtime = timestamp2mtime(&device[cunit].parbuf.f1);
 				}
-				else
+				pcl_dir_release(snap);
+
+				if (e == NULL)
 				{
 					if ((device[cunit].parbuf.fmode & 0x0c) == 0x04)
 					{
 						Debug_printf("FOPEN: file not found\n");
 						device[cunit].status.err = 170;
-						closedir(dh);
-						dp = NULL;
 						goto complete_fopen;
 					}
 					else
@@ -1687,8 +1645,8 @@ do_pclink(uchar devno, uchar ccom, uchar caux1, uchar caux2)
 				else if ((device[cunit].parbuf.fmode & 0x0d) == 0x0c)
 					iodesc[i].fps.file = fopen(newpath, "r+");
 
-				closedir(dh);
-				dp = NULL;
+				if (iodesc[i].fps.file && (device[cunit].parbuf.fmode & 0x08))
+					pcl_dir_invalidate_parent(newpath);
 			}
 
 			if (iodesc[i].fps.file == NULL)
@@ -1817,9 +1775,10 @@ complete_fopen:
 
 	if (fno == 0x0b)	/* RENAME/RENDIR */
 	{
-		char newpath[1024];
-		DIR *renamedir;
-		ulong fcnt = 0;
+		char newpath[1024], raw_name[12];
+		PCL_DIRSNAP *renamedir;
+		PCL_DIRENT *e;
+		ulong fcnt = 0, pos = 0;
 
 		if (ccom == 'R')
 		{
@@ -1838,7 +1797,7 @@ complete_fopen:
 			goto complete;
 		}
 
-		renamedir = opendir(newpath);
+		renamedir = pcl_dir_snapshot(newpath, skip_dos_name);
 
 		if (renamedir == NULL)
 		{
@@ -1852,63 +1811,53 @@ complete_fopen:
 
 		device[cunit].status.err = 1;
 
-		while ((dp = readdir(renamedir)) != NULL)
+		while ((e = snap_next(renamedir, &pos, (char *)device[cunit].parbuf.name, \
+			device[cunit].parbuf.fatr1 | RA_NO_PROTECT, raw_name)) != NULL)
 		{
-			char raw_name[12];
- 
-			if (check_dos_name(newpath, dp, &sb))
-				continue;
+			char xpath[1024], xpath2[1024], newname[16];
+			uchar names[12];
+			struct stat dummy;
+			ushort x;
 
-			/* convert 8+3 to NNNNNNNNXXX */
-			ugefina(dp->d_name, raw_name);
-
-			/* match */
-			if (match_dos_names(raw_name, (char *)device[cunit].parbuf.name, \
-				device[cunit].parbuf.fatr1 | RA_NO_PROTECT, &sb) == 0)
-			{
-				char xpath[1024], xpath2[1024], newname[16];
-				uchar names[12];
-				struct stat dummy;
-				ushort x;
+			fcnt++;
 
-				fcnt++;
+			strcpy(xpath, newpath);
+			strcat(xpath, "/");
+			strcat(xpath, e->name);
 
-				strcpy(xpath, newpath);
-				strcat(xpath, "/");
-				strcat(xpath, dp->d_name);
+			memcpy(names, device[cunit].parbuf.names, 12);
 
-				memcpy(names, device[cunit].parbuf.names, 12);
-
-				for (x = 0; x < 12; x++)
-				{
-					if (names[x] == '?')
-						names[x] = raw_name[x];
-				}
+			for (x = 0; x < 12; x++)
+			{
+				if (names[x] == '?')
+					names[x] = raw_name[x];
+			}
 
-				uexpand(names, newname);
+			uexpand(names, newname);
 
-				strcpy(xpath2, newpath);
-				strcat(xpath2, "/");
-				strcat(xpath2, newname);
+			strcpy(xpath2, newpath);
+			strcat(xpath2, "/");
+			strcat(xpath2, newname);
 
-				Debug_printf("RENAME: renaming '%s' -> '%s'\n", dp->d_name, newname);
+			Debug_printf("RENAME: renaming '%s' -> '%s'\n", e->name, newname);
 
-				if (stat(xpath2, &dummy) == 0)
-				{
-					Debug_printf("RENAME: '%s' already exists\n", xpath2);
-					device[cunit].status.err = 151;
-					break;
-				}
+			if (stat(xpath2, &dummy) == 0)
+			{
+				Debug_printf("RENAME: '%s' already exists\n", xpath2);
+				device[cunit].status.err = 151;
+				break;
+			}
 
-				if (rename(xpath, xpath2))
-				{
-					Debug_printf("RENAME: %s\n", strerror(errno));
-					device[cunit].status.err = 255;
-				}
+			if (rename(xpath, xpath2))
+			{
+				Debug_printf("RENAME: %s\n", strerror(errno));
+				device[cunit].status.err = 255;
 			}
 		}
 
-		closedir(renamedir);
+		pcl_dir_release(renamedir);
+		if (fcnt)
+			pcl_dir_invalidate(newpath);
 
 		if ((fcnt == 0) && (device[cunit].status.err == 1))
 			device[cunit].status.err = 170;
@@ -1917,9 +1866,10 @@ complete_fopen:
 
 	if (fno == 0x0c)	/* REMOVE */
 	{
-		char newpath[1024];
-		DIR *deldir;
-		ulong delcnt = 0;
+		char newpath[1024], raw_name[12];
+		PCL_DIRSNAP *deldir;
+		PCL_DIRENT *e;
+		ulong delcnt = 0, pos = 0;
 
 		if (ccom == 'R')
 		{
@@ -1940,7 +1890,7 @@ complete_fopen:
 
 		Debug_printf("local path '%s'\n", newpath);
 
-		deldir = opendir(newpath);
+		deldir = pcl_dir_snapshot(newpath, skip_dos_name);
 
 		if (deldir == NULL)
 		{
@@ -1951,49 +1901,40 @@ complete_fopen:
 
 		device[cunit].status.err = 1;
 
-		while ((dp = readdir(deldir)) != NULL)
+		while ((e = snap_next(deldir, &pos, (char *)device[cunit].parbuf.name, \
+			RA_NO_PROTECT | RA_NO_SUBDIR | RA_NO_HIDDEN, raw_name)) != NULL)
 		{
-			char raw_name[12];
- 
-			if (check_dos_name(newpath, dp, &sb))
-				continue;
-
-			/* convert 8+3 to NNNNNNNNXXX */
-			ugefina(dp->d_name, raw_name);
-
-			/* match */
-			if (match_dos_names(raw_name, (char *)device[cunit].parbuf.name, \
-				RA_NO_PROTECT | RA_NO_SUBDIR | RA_NO_HIDDEN, &sb) == 0)
-			{
-				char xpath[1024];
+			char xpath[1024];
 
-				strcpy(xpath, newpath);
-				strcat(xpath, "/");
-				strcat(xpath, dp->d_name);
+			strcpy(xpath, newpath);
+			strcat(xpath, "/");
+			strcat(xpath, e->name);
 
-				if (!S_ISDIR(sb.st_mode))
-				{				
-					Debug_printf("REMOVE: delete '%s'\n", xpath);
-					if (unlink(xpath))
-					{
-						Debug_printf("REMOVE: cannot delete '%s'\n", xpath);
-						device[cunit].status.err = 255;
-					}
-					delcnt++;
+			if (!S_ISDIR(e->mode))
+			{				
+				Debug_printf("REMOVE: delete '%s'\n", xpath);
+				if (unlink(xpath))
+				{
+					Debug_printf("REMOVE: cannot delete '%s'\n", xpath);
+					device[cunit].status.err = 255;
 				}
+				delcnt++;
 			}
 		}
-		closedir(deldir);
+		pcl_dir_release(deldir);
 		if (delcnt == 0)
 			device[cunit].status.err = 170;
+		else
+			pcl_dir_invalidate(newpath);
 		goto complete;
 	}
 
 	if (fno == 0x0d)	/* CHMOD */
 	{
-		char newpath[1024];
-		DIR *chmdir;
-		ulong fcnt = 0;
+		char newpath[1024], raw_name[12];
+		PCL_DIRSNAP *chmdir;
+		PCL_DIRENT *e;
+		ulong fcnt = 0, pos = 0;
 		uchar fatr2 = device[cunit].parbuf.fatr2;
 
 		if (ccom == 'R')
@@ -2023,7 +1964,7 @@ complete_fopen:
 		Debug_printf("local path '%s', fatr1 $%02x fatr2 $%02x\n", newpath, \
 				device[cunit].parbuf.fatr1, fatr2);
 
-		chmdir = opendir(newpath);
+		chmdir = pcl_dir_snapshot(newpath, skip_dos_name);
 
 		if (chmdir == NULL)
 		{
@@ -2035,47 +1976,37 @@ complete_fopen:
 
 		device[cunit].status.err = 1;
 
-		while ((dp = readdir(chmdir)) != NULL)
+		while ((e = snap_next(chmdir, &pos, (char *)device[cunit].parbuf.name, \
+			device[cunit].parbuf.fatr1, raw_name)) != NULL)
 		{
-			char raw_name[12];
- 
-			if (check_dos_name(newpath, dp, &sb))
-				continue;
+			char xpath[1024];
+			mode_t newmode = e->mode;
 
-			/* convert 8+3 to NNNNNNNNXXX */
-			ugefina(dp->d_name, raw_name);
+			strcpy(xpath, newpath);
+			strcat(xpath, "/");
+			strcat(xpath, e->name);
+			Debug_printf("CHMOD: change atrs in '%s'\n", xpath);
 
-			/* match */
-			if (match_dos_names(raw_name, (char *)device[cunit].parbuf.name, \
-				device[cunit].parbuf.fatr1, &sb) == 0)
-			{
-				char xpath[1024];
-				mode_t newmode = sb.st_mode;
-
-				strcpy(xpath, newpath);
-				strcat(xpath, "/");
-				strcat(xpath, dp->d_name);
-				Debug_printf("CHMOD: change atrs in '%s'\n", xpath);
-
-				/* On Unix, ignore Hidden and Archive bits */
-				if (fatr2 & SA_UNPROTECT)
-					newmode |= S_IWUSR;
-				if (fatr2 & SA_PROTECT)
-					newmode &= ~S_IWUSR;
-				// TODO - chmod is not available on platformio
+			/* On Unix, ignore Hidden and Archive bits */
+			if (fatr2 & SA_UNPROTECT)
+				newmode |= S_IWUSR;
+			if (fatr2 & SA_PROTECT)
+				newmode &= ~S_IWUSR;
+			// TODO - chmod is not available on platformio
 #ifndef ESP_PLATFORM
-				if (chmod(xpath, newmode))
-				{
-					Debug_printf("CHMOD: failed on '%s'\n", xpath);
-					device[cunit].status.err |= 255;
-				}
-#endif
-				fcnt++;
+			if (chmod(xpath, newmode))
+			{
+				Debug_printf("CHMOD: failed on '%s'\n", xpath);
+				device[cunit].status.err |= 255;
 			}
+#endif
+			fcnt++;
 		}
-		closedir(chmdir);
+		pcl_dir_release(chmdir);
 		if (fcnt == 0)
 			device[cunit].status.err = 170;
+		else
+			pcl_dir_invalidate(newpath);
 		goto complete;
 	}
 
@@ -2135,6 +2066,8 @@ complete_fopen:
 		{
 			time_t mtime = timestamp2mtime(dt);
 
+			pcl_dir_invalidate_parent(newpath);
+
 			device[cunit].status.err = 1;
 
 			if (mtime)
@@ -2226,6 +2159,11 @@ complete_fopen:
 			else
 				device[cunit].status.err = 255;
 		}
+		else
+		{
+			pcl_dir_invalidate(newpath);
+			pcl_dir_invalidate_parent(newpath);
+		}
 		goto complete;
 	}
 
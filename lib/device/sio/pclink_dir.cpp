@@ -0,0 +1,193 @@
+#ifdef BUILD_ATARI
+
+#include "pclink_dir.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "compat_dirent.h"
+#include "compat_string.h"
+
+#include "fnSystem.h"
+
+#include "../../include/debug.h"
+
+static PCL_DIRSNAP *last_snap = NULL;
+
+static int
+same_dir(const char *a, const char *b)
+{
+	size_t la = strlen(a), lb = strlen(b);
+
+	/* "dir" and "dir/" are the same thing */
+	while (la > 1 && a[la-1] == '/')
+		la--;
+	while (lb > 1 && b[lb-1] == '/')
+		lb--;
+
+	return (la == lb) && (strncmp(a, b, la) == 0);
+}
+
+static int
+usable(const char *temp_fspec, struct stat *sb)
+{
+	if (!S_ISREG(sb->st_mode) && !S_ISDIR(sb->st_mode))
+	{
+		Debug_printf("'%s' is not regular file nor directory\n", temp_fspec);
+		return 0;
+	}
+
+	if ((sb->st_mode & S_IRUSR) == 0)
+	{
+		Debug_printf("'%s' is unreadable\n", temp_fspec);
+		return 0;
+	}
+
+	if (S_ISDIR(sb->st_mode) && ((sb->st_mode & S_IXUSR) == 0))
+	{
+		Debug_printf("dir '%s' is unbrowseable\n", temp_fspec);
+		return 0;
+	}
+
+	return 1;
+}
+
+static PCL_DIRSNAP *
+scan_dir(const char *path, int (*skip)(const char *name))
+{
+	DIR *dh;
+	struct dirent *dp;
+	struct stat sb;
+	char temp_fspec[1024];
+	unsigned long alloc = 0;
+	PCL_DIRSNAP *snap;
+
+	dh = opendir(path);
+	if (dh == NULL)
+	{
+		Debug_printf("cannot open dir '%s'\n", path);
+		return NULL;
+	}
+
+	snap = (PCL_DIRSNAP *)calloc(1, sizeof(PCL_DIRSNAP));
+	if (snap == NULL)
+	{
+		closedir(dh);
+		return NULL;
+	}
+	strlcpy(snap->path, path, sizeof(snap->path));
+
+	while ((dp = readdir(dh)) != NULL)
+	{
+		PCL_DIRENT *e;
+
+		if (strlen(dp->d_name) >= sizeof(e->name) || skip(dp->d_name))
+			continue;
+
+		/* stat() the file (fetches the length) */
+		snprintf(temp_fspec, sizeof(temp_fspec), "%s/%s", path, dp->d_name);
+
+		if (stat(temp_fspec, &sb))
+		{
+			Debug_printf("cannot stat '%s'\n", temp_fspec);
+			continue;
+		}
+
+		if (!usable(temp_fspec, &sb))
+			continue;
+
+		if (snap->count == alloc)
+		{
+			unsigned long n = alloc ? alloc * 2 : 64;
+			PCL_DIRENT *ne = (PCL_DIRENT *)realloc(snap->ent, n * sizeof(PCL_DIRENT));
+
+			if (ne == NULL)
+			{
+				Debug_printf("out of memory after %lu entries of '%s'\n", snap->count, path);
+				break;
+			}
+			snap->ent = ne;
+			alloc = n;
+		}
+
+		e = &snap->ent[snap->count++];
+		strcpy(e->name, dp->d_name);
+		e->mode = sb.st_mode;
+		e->size = sb.st_size;
+		e->mtime = sb.st_mtime;
+	}
+
+	closedir(dh);
+
+	snap->taken = fnSystem.millis();
+	return snap;
+}
+
+PCL_DIRSNAP *
+pcl_dir_snapshot(const char *path, int (*skip)(const char *name))
+{
+	PCL_DIRSNAP *snap;
+
+	if (last_snap != NULL)
+	{
+		if (same_dir(last_snap->path, path) && \
+			(fnSystem.millis() - last_snap->taken) < PCL_DIRSNAP_TTL_MS)
+		{
+			last_snap->refs++;
+			return last_snap;
+		}
+		pcl_dir_release(last_snap);
+		last_snap = NULL;
+	}
+
+	snap = scan_dir(path, skip);
+	if (snap == NULL)
+		return NULL;
+
+	/* one reference for the caller, one for last_snap */
+	snap->refs = 2;
+	last_snap = snap;
+
+	return snap;
+}
+
+void
+pcl_dir_release(PCL_DIRSNAP *snap)
+{
+	if (snap == NULL || --snap->refs > 0)
+		return;
+
+	free(snap->ent);
+	free(snap);
+}
+
+void
+pcl_dir_invalidate(const char *dir)
+{
+	if (last_snap != NULL && same_dir(last_snap->path, dir))
+	{
+		pcl_dir_release(last_snap);
+		last_snap = NULL;
+	}
+}
+
+void
+pcl_dir_invalidate_parent(const char *path)
+{
+	char dir[1024];
+	char *slash;
+
+	strlcpy(dir, path, sizeof(dir));
+	slash = strrchr(dir, '/');
+	if (slash == NULL)
+		return;
+	if (slash == dir)
+		slash++;	/* keep the root */
+	*slash = 0;
+
+	pcl_dir_invalidate(dir);
+}
+
+#endif /* BUILD_ATARI */
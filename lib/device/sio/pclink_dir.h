@@ -0,0 +1,57 @@
+#ifndef PCLINK_DIR_H
+#define PCLINK_DIR_H
+
+/*
+ * Directory snapshots for PCLink
+ *
+ * A snapshot is one readdir() pass over a host directory with every usable
+ * entry stat()ed exactly once. Directory handles, FOPEN name lookups and the
+ * wildcard commands (RENAME, REMOVE, CHMOD) all work from a snapshot instead
+ * of walking and stat()ing the directory again.
+ *
+ * The most recent snapshot is kept and handed out again for the same path
+ * until PCLink changes that directory (pcl_dir_invalidate()) or it is older
+ * than PCL_DIRSNAP_TTL_MS, which bounds how long changes made on the host
+ * side can go unnoticed.
+ */
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define PCL_DIRSNAP_TTL_MS 2000
+
+typedef struct
+{
+	char name[13];		/* host file name, 8.3 at most */
+	mode_t mode;
+	unsigned long size;
+	time_t mtime;
+} PCL_DIRENT;
+
+typedef struct
+{
+	int refs;
+	uint64_t taken;		/* fnSystem.millis() at scan time */
+	unsigned long count;
+	PCL_DIRENT *ent;
+	char path[1024];
+} PCL_DIRSNAP;
+
+/*
+ * Return a referenced snapshot of path, or NULL if it cannot be read.
+ * Entries for which skip(name) returns non-zero are dropped before they
+ * are stat()ed, as are anything but readable files and browseable dirs.
+ */
+PCL_DIRSNAP *pcl_dir_snapshot(const char *path, int (*skip)(const char *name));
+
+/* Drop a reference taken with pcl_dir_snapshot() */
+void pcl_dir_release(PCL_DIRSNAP *snap);
+
+/* Forget any kept snapshot of dir, call after changing its contents */
+void pcl_dir_invalidate(const char *dir);
+
+/* Same as pcl_dir_invalidate() for the directory that contains path */
+void pcl_dir_invalidate_parent(const char *path);
+
+#endif // PCLINK_DIR_H
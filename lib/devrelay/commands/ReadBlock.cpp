@@ -53,8 +53,7 @@ std::unique_ptr<Response> ReadBlockRequest::create_response(uint8_t source, uint
 	std::unique_ptr<ReadBlockResponse> response = std::make_unique<ReadBlockResponse>(get_request_sequence_number(), status, num);
 	// Copy the return data if the status is OK
 	if (status == 0) {
-		std::vector<uint8_t> data_vector(data, data + num);
-		response->set_block_data(data_vector.begin(), data_vector.end());
+		response->set_block_data(data, num);
 	}
 	return response;
 }
@@ -67,6 +66,7 @@ ReadBlockResponse::ReadBlockResponse(const uint8_t request_sequence_number, cons
 std::vector<uint8_t> ReadBlockResponse::serialize() const
 {
 	std::vector<uint8_t> data;
+	data.reserve(block_data_.size() + 2);
 	data.push_back(this->get_request_sequence_number());
 	data.push_back(this->get_status());
 	data.insert(data.end(), block_data_.begin(), block_data_.end());
@@ -78,6 +78,11 @@ void ReadBlockResponse::set_block_data(std::vector<uint8_t>::const_iterator begi
 	std::copy(begin, end, block_data_.begin()); // NOLINT(performance-unnecessary-value-param)
 }
 
+void ReadBlockResponse::set_block_data(const uint8_t *data, size_t length)
+{
+	std::copy_n(data, std::min(length, block_data_.size()), block_data_.begin());
+}
+
 const std::vector<uint8_t>& ReadBlockResponse::get_block_data() const {
 	return block_data_;
 }
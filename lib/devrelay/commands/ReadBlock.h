@@ -37,6 +37,7 @@ public:
 	std::vector<uint8_t> serialize() const override;
 
 	void set_block_data(std::vector<uint8_t>::const_iterator begin, std::vector<uint8_t>::const_iterator end);
+	void set_block_data(const uint8_t *data, size_t length);
 	const std::vector<uint8_t>& get_block_data() const;
 	const uint16_t get_block_size() const;
 
@@ -0,0 +1,91 @@
+#ifdef DEV_RELAY_SLIP
+
+#include "ReadBlocks.h"
+
+ReadBlocksRequest::ReadBlocksRequest(const uint8_t request_sequence_number, const uint8_t device_id, uint16_t block_count) : Request(request_sequence_number, CMD_READ_BLOCKS, device_id), block_number_{}, block_count_(block_count) {}
+
+std::vector<uint8_t> ReadBlocksRequest::serialize() const
+{
+	std::vector<uint8_t> request_data;
+	request_data.push_back(this->get_request_sequence_number());
+	request_data.push_back(this->get_command_number());
+	request_data.push_back(this->get_device_id());
+	request_data.push_back(this->get_block_count() & 0xFF);
+	request_data.push_back((this->get_block_count() >> 8) & 0xFF);
+	request_data.insert(request_data.end(), block_number_.begin(), block_number_.end());
+	return request_data;
+}
+
+std::unique_ptr<Response> ReadBlocksRequest::deserialize(const std::vector<uint8_t> &data) const
+{
+	if (data.size() < 2)
+	{
+		throw std::runtime_error("Not enough data to deserialize ReadBlocksResponse");
+	}
+
+	auto response = std::make_unique<ReadBlocksResponse>(data[0], data[1]);
+	// an error comes back without the blocks
+	if (response->get_status() == 0)
+	{
+		if (data.size() != (block_count_ * 512 + 2))
+		{
+			throw std::runtime_error("Not enough data to deserialize ReadBlocksResponse");
+		}
+		response->set_block_data(data.data() + 2, data.size() - 2);
+	}
+	return response;
+}
+
+const std::array<uint8_t, 3> &ReadBlocksRequest::get_block_number() const { return block_number_; }
+
+const uint16_t ReadBlocksRequest::get_block_count() const { return block_count_; }
+
+void ReadBlocksRequest::set_block_number_from_ptr(const uint8_t *ptr, const size_t offset) { std::copy_n(ptr + offset, block_number_.size(), block_number_.begin()); }
+
+void ReadBlocksRequest::set_block_number_from_bytes(uint8_t l, uint8_t m, uint8_t h)
+{
+	block_number_[0] = l;
+	block_number_[1] = m;
+	block_number_[2] = h;
+}
+
+void ReadBlocksRequest::create_command(uint8_t *cmd_data) const {
+	init_command(cmd_data);
+	cmd_data[2] = block_count_ & 0xFF;
+	cmd_data[3] = (block_count_ >> 8) & 0xFF;
+	std::copy(block_number_.begin(), block_number_.end(), cmd_data + 4);
+}
+
+std::unique_ptr<Response> ReadBlocksRequest::create_response(uint8_t source, uint8_t status, const uint8_t *data, uint16_t num) const {
+	std::unique_ptr<ReadBlocksResponse> response = std::make_unique<ReadBlocksResponse>(get_request_sequence_number(), status);
+	// Copy the return data if the status is OK
+	if (status == 0) {
+		response->set_block_data(data, num);
+	}
+	return response;
+}
+
+
+ReadBlocksResponse::ReadBlocksResponse(const uint8_t request_sequence_number, const uint8_t status) : Response(request_sequence_number, status) {}
+
+std::vector<uint8_t> ReadBlocksResponse::serialize() const
+{
+	std::vector<uint8_t> data;
+	data.reserve(block_data_.size() + 2);
+	data.push_back(this->get_request_sequence_number());
+	data.push_back(this->get_status());
+	data.insert(data.end(), block_data_.begin(), block_data_.end());
+	return data;
+}
+
+void ReadBlocksResponse::set_block_data(const uint8_t *data, size_t length)
+{
+	block_data_.assign(data, data + length);
+}
+
+const std::vector<uint8_t>& ReadBlocksResponse::get_block_data() const {
+	return block_data_;
+}
+
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "../types/Request.h"
+#include "../types/Response.h"
+
+// Reads block_count consecutive 512 byte blocks in one request, for hosts that
+// know the #FujiNet extension. Same header as ReadBlock, with the count in
+// place of the block size.
+class ReadBlocksRequest : public Request
+{
+public:
+	ReadBlocksRequest(uint8_t request_sequence_number, uint8_t device_id, uint16_t block_count);
+	std::vector<uint8_t> serialize() const override;
+	std::unique_ptr<Response> deserialize(const std::vector<uint8_t> &data) const override;
+	const std::array<uint8_t, 3> &get_block_number() const;
+	void set_block_number_from_ptr(const uint8_t *ptr, size_t offset);
+	void set_block_number_from_bytes(uint8_t l, uint8_t m, uint8_t h);
+	const uint16_t get_block_count() const;
+
+	void create_command(uint8_t *output_data) const override;
+	void copy_payload(uint8_t *data) const override {}
+	size_t payload_size() const override { return 0; };
+	std::unique_ptr<Response> create_response(uint8_t source, uint8_t status, const uint8_t *data, uint16_t num) const override;
+
+private:
+	std::array<uint8_t, 3> block_number_;
+	uint16_t block_count_;
+};
+
+
+class ReadBlocksResponse : public Response
+{
+public:
+	explicit ReadBlocksResponse(uint8_t request_sequence_number, uint8_t status);
+	std::vector<uint8_t> serialize() const override;
+
+	void set_block_data(const uint8_t *data, size_t length);
+	const std::vector<uint8_t>& get_block_data() const;
+
+private:
+	std::vector<uint8_t> block_data_;
+};
@@ -0,0 +1,87 @@
+#ifdef DEV_RELAY_SLIP
+
+#include "WriteBlocks.h"
+#include <cstdint>
+
+WriteBlocksRequest::WriteBlocksRequest(const uint8_t request_sequence_number, const uint8_t device_id, const uint16_t block_count) : Request(request_sequence_number, CMD_WRITE_BLOCKS, device_id), block_number_{}, block_data_{}, block_count_(block_count) {}
+
+std::vector<uint8_t> WriteBlocksRequest::serialize() const
+{
+	std::vector<uint8_t> request_data;
+	request_data.reserve(block_data_.size() + 8);
+	request_data.push_back(this->get_request_sequence_number());
+	request_data.push_back(this->get_command_number());
+	request_data.push_back(this->get_device_id());
+	request_data.push_back(this->get_block_count() & 0xFF);
+	request_data.push_back((this->get_block_count() >> 8) & 0xFF);
+	request_data.insert(request_data.end(), block_number_.begin(), block_number_.end());
+	request_data.insert(request_data.end(), block_data_.begin(), block_data_.end());
+
+	return request_data;
+}
+
+std::unique_ptr<Response> WriteBlocksRequest::deserialize(const std::vector<uint8_t> &data) const
+{
+	if (data.size() < 2)
+	{
+		throw std::runtime_error("Not enough data to deserialize WriteBlocksResponse");
+	}
+
+	auto response = std::make_unique<WriteBlocksResponse>(data[0], data[1]);
+	return response;
+}
+
+const std::array<uint8_t, 3> &WriteBlocksRequest::get_block_number() const { return block_number_; }
+
+const std::vector<uint8_t> &WriteBlocksRequest::get_block_data() const { return block_data_; }
+
+const uint16_t WriteBlocksRequest::get_block_count() const { return block_count_; }
+
+void WriteBlocksRequest::set_block_number_from_ptr(const uint8_t *ptr, const size_t offset) { std::copy_n(ptr + offset, block_number_.size(), block_number_.begin()); }
+
+void WriteBlocksRequest::set_block_data_from_ptr(const uint8_t *ptr, const size_t offset, const size_t length)
+{
+	block_data_.assign(ptr + offset, ptr + offset + length);
+}
+
+void WriteBlocksRequest::set_block_number_from_bytes(uint8_t l, uint8_t m, uint8_t h)
+{
+	block_number_[0] = l;
+	block_number_[1] = m;
+	block_number_[2] = h;
+}
+
+void WriteBlocksRequest::create_command(uint8_t* cmd_data) const
+{
+	init_command(cmd_data);
+	cmd_data[2] = block_count_ & 0xFF;
+	cmd_data[3] = (block_count_ >> 8) & 0xFF;
+	std::copy(block_number_.begin(), block_number_.end(), cmd_data + 4);
+}
+
+void WriteBlocksRequest::copy_payload(uint8_t* data) const {
+	std::copy(block_data_.begin(), block_data_.end(), data);
+}
+
+size_t WriteBlocksRequest::payload_size() const { 
+	return block_data_.size();
+}
+
+std::unique_ptr<Response> WriteBlocksRequest::create_response(uint8_t source, uint8_t status, const uint8_t* data, uint16_t num) const
+{
+	std::unique_ptr<WriteBlocksResponse> response = std::make_unique<WriteBlocksResponse>(get_request_sequence_number(), status);
+	return response;
+}
+
+WriteBlocksResponse::WriteBlocksResponse(const uint8_t request_sequence_number, const uint8_t status) : Response(request_sequence_number, status) {}
+
+std::vector<uint8_t> WriteBlocksResponse::serialize() const
+{
+	std::vector<uint8_t> data;
+	data.push_back(this->get_request_sequence_number());
+	data.push_back(this->get_status());
+	return data;
+}
+
+
+#endif
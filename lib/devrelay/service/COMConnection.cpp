@@ -16,7 +16,9 @@ void COMConnection::send_data(const std::vector<uint8_t> &data)
 		return;
 	}
 
-	const auto slip_data = SLIP::encode(data);
+	// each sending thread keeps its frame buffer for the next packet
+	thread_local std::vector<uint8_t> slip_data;
+	SLIP::encode_into(data.data(), data.size(), slip_data);
 	sp_nonblocking_write(port_, slip_data.data(), slip_data.size());
 }
 
@@ -24,26 +26,16 @@ void COMConnection::create_read_channel()
 {
 	reading_thread_ = std::thread([self = shared_from_this()]() {
 		std::vector<uint8_t> buffer(1024);
+		std::vector<uint8_t> complete_data;
 		while (self->is_connected())
 		{
 			int bytes_read = sp_nonblocking_read(self->port_, buffer.data(), buffer.size());
 			if (bytes_read > 0)
 			{
-				std::vector<std::vector<uint8_t>> decoded_packets = SLIP::split_into_packets(buffer.data(), buffer.size());
-				if (!decoded_packets.empty())
-				{
-					for (const auto &packet : decoded_packets)
-					{
-						if (!packet.empty())
-						{
-							{
-								std::lock_guard<std::mutex> lock(self->data_mutex_);
-								self->data_map_[packet[0]] = packet;
-							}
-							self->data_cv_.notify_all();
-						}
-					}
-				}
+				// a packet bigger than a read arrives over several of them
+				complete_data.insert(complete_data.end(), buffer.begin(), buffer.begin() + bytes_read);
+				size_t consumed = self->take_packets(complete_data.data(), complete_data.size());
+				complete_data.erase(complete_data.begin(), complete_data.begin() + consumed);
 			}
 		}
 	});
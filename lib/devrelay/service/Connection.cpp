@@ -4,22 +4,83 @@
 #include <cstdint>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 #include "Connection.h"
+#include "../slip/SLIP.h"
+
+// Wakes the threads waiting for packets, if there are any; the thread polling peek_request() isn't one
+void Connection::notify_waiters()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waiters_.load(std::memory_order_relaxed) > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(data_mutex_);
+		}
+		data_cv_.notify_all();
+	}
+}
+
+size_t Connection::take_packets(const uint8_t *data, size_t bytes_read)
+{
+	size_t pos = 0;
+	bool pushed = false;
+	while (true)
+	{
+		std::vector<uint8_t> *packet;
+		// a full ring waits for the other end to catch up
+		while ((packet = packets_.back()) == nullptr && is_connected_)
+		{
+			notify_waiters();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if (packet == nullptr || !SLIP::next_packet(data, bytes_read, pos, *packet))
+			break;
+		if (!packet->empty())
+		{
+			packets_.push();
+			pushed = true;
+		}
+	}
+	if (pushed)
+		notify_waiters();
+	// up to the packet still arriving, or all of it
+	return pos;
+}
+
+// Moves the packets from the ring to data_map_, with data_mutex_ held so only one thread takes from it at a time
+void Connection::take_responses()
+{
+	std::vector<uint8_t> *packet;
+	while ((packet = packets_.front()) != nullptr)
+	{
+		data_map_[(*packet)[0]].assign(packet->begin(), packet->end());
+		packets_.pop();
+	}
+}
 
 // This is called after AppleWin sends a request to a device, and is waiting for the response
 std::vector<uint8_t> Connection::wait_for_response(uint8_t request_id, std::chrono::seconds timeout)
 {
 	std::unique_lock<std::mutex> lock(data_mutex_);
-	// mutex is unlocked as it goes into a wait, so then the inserting thread can
-	// add to map, and this can then pick it up when notified, or timeout.
-	if (!data_cv_.wait_for(lock, timeout, [this, request_id]() { return data_map_.count(request_id) > 0; }))
+	waiters_++;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	// mutex is unlocked as it goes into a wait, so then the reading thread can
+	// add to the ring, and this can then pick it up when notified, or timeout.
+	bool found = data_cv_.wait_for(lock, timeout, [this, request_id]() {
+		take_responses();
+		return data_map_.count(request_id) > 0;
+	});
+	waiters_--;
+	if (!found)
 	{
 		throw std::runtime_error("Timeout waiting for response");
 	}
-	std::vector<uint8_t> response_data = data_map_[request_id];
-	data_map_.erase(request_id);
+	auto it = data_map_.find(request_id);
+	std::vector<uint8_t> response_data = std::move(it->second);
+	data_map_.erase(it);
 	return response_data;
 }
 
@@ -31,11 +92,14 @@ std::vector<uint8_t> Connection::wait_for_request()
 	while (is_connected_)
 	{
 		std::unique_lock<std::mutex> lock(data_mutex_);
-		if (data_cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() { return !data_map_.empty(); }))
+		waiters_++;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		bool found = data_cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() { return peek_request() != nullptr; });
+		waiters_--;
+		if (found)
 		{
-			const auto it = data_map_.begin();
-			std::vector<uint8_t> request_data = it->second;
-			data_map_.erase(it);
+			std::vector<uint8_t> request_data = *peek_request();
+			pop_request();
 
 			return request_data;
 		}
@@ -11,6 +11,8 @@
 #include <thread>
 #include <vector>
 
+#include "FrameRing.h"
+
 class Connection
 {
 public:
@@ -26,17 +28,33 @@ public:
 	std::vector<uint8_t> wait_for_response(uint8_t request_id, std::chrono::seconds timeout);
 	std::vector<uint8_t> wait_for_request();
 
+	// The oldest request, nullptr if none has come. It stays put until pop_request(), and neither waits or locks,
+	// for the one thread answering requests to poll.
+	const std::vector<uint8_t> *peek_request() { return packets_.front(); }
+	void pop_request() { packets_.pop(); }
+
 	void join();
 
 private:
 	std::atomic<bool> is_connected_{false};
+	std::atomic<int> waiters_{0};
+
+	void notify_waiters();
+	void take_responses();
 
 protected:
+	// Packets go from the reading thread through packets_. Responses are then kept in data_map_ by sequence number
+	// for the thread that sent the request, requests are taken in order straight from the ring.
+	FrameRing packets_;
 	std::map<uint8_t, std::vector<uint8_t>> data_map_;
 	std::thread reading_thread_;
 
 	std::mutex data_mutex_;
 	std::condition_variable data_cv_;
+
+	// For the reading thread: decodes the whole packets in data into packets_, returning the bytes used.
+	// The rest is a packet still arriving.
+	size_t take_packets(const uint8_t *data, size_t bytes_read);
 };
 
 #endif
\ No newline at end of file
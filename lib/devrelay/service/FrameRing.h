@@ -0,0 +1,54 @@
+#pragma once
+#ifdef DEV_RELAY_SLIP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A lock free queue of decoded packets between one producer, the connection's reading thread, and one consumer.
+// The producer decodes into back() and calls push(); the consumer reads front() and calls pop() when done with it.
+// The packet buffers are made with the ring and reused, so once one has grown to the biggest packet seen
+// a packet costs no allocation.
+class FrameRing
+{
+public:
+	static constexpr size_t FRAMES = 16;		 // a power of 2
+	static constexpr size_t FRAME_RESERVE = 1024; // enough for a block request, WriteBlocks grows its frame once
+
+	FrameRing()
+	{
+		for (auto &frame : frames_)
+			frame.reserve(FRAME_RESERVE);
+	}
+
+	// The buffer to decode the next packet into, nullptr if the ring is full
+	std::vector<uint8_t> *back()
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) == FRAMES)
+			return nullptr;
+		return &frames_[tail % FRAMES];
+	}
+
+	void push() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+	// The oldest packet, nullptr if there are none
+	std::vector<uint8_t> *front()
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire))
+			return nullptr;
+		return &frames_[head % FRAMES];
+	}
+
+	void pop() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+	std::vector<uint8_t> frames_[FRAMES];
+	// apart, so the two threads don't share a cache line
+	alignas(64) std::atomic<size_t> head_{0};
+	alignas(64) std::atomic<size_t> tail_{0};
+};
+
+#endif
@@ -98,7 +98,7 @@ std::vector<uint8_t> SLIP::decode(const std::vector<uint8_t> &data)
 
 // This breaks up a vector of data into a list of decoded vectors of serialized objects.
 // The returned data is already "SLIP::decode"d
-std::vector<std::vector<uint8_t>> SLIP::split_into_packets(const uint8_t *data, size_t bytes_read)
+std::vector<std::vector<uint8_t>> SLIP::split_into_packets(const uint8_t *data, size_t bytes_read, size_t *consumed)
 {
 	// The list of decoded SLIP packets
 	std::vector<std::vector<uint8_t>> decoded_packets;
@@ -112,6 +112,8 @@ std::vector<std::vector<uint8_t>> SLIP::split_into_packets(const uint8_t *data,
 	// Iterate over the data and find the SLIP packet boundaries
 	size_t i = 0;
 	const uint8_t *packet_start = nullptr; // Keep track of where the packet starts
+	if (consumed != nullptr)
+		*consumed = 0;
 	while (i < bytes_read)
 	{
 		switch (state)
@@ -136,14 +138,78 @@ std::vector<std::vector<uint8_t>> SLIP::split_into_packets(const uint8_t *data,
 
 				// Transition back to the NotParsing state
 				state = State::NotParsing;
+				if (consumed != nullptr)
+					*consumed = i + 1;
 			}
 			break;
 		}
 		i++;
 	}
+	// bytes outside any packet are dropped, there is nothing to wait for
+	if (consumed != nullptr && state == State::NotParsing)
+		*consumed = bytes_read;
 
 	return decoded_packets;
 }
 
 
+void SLIP::encode_into(const uint8_t *data, size_t len, std::vector<uint8_t> &frame)
+{
+	// at worst every byte is escaped
+	frame.resize(len * 2 + 2);
+	uint8_t *out = frame.data();
+
+	*out++ = SLIP_END;
+	for (size_t i = 0; i < len; i++)
+	{
+		if (data[i] == SLIP_END || data[i] == SLIP_ESC)
+		{
+			*out++ = SLIP_ESC;
+			*out++ = data[i] == SLIP_END ? SLIP_ESC_END : SLIP_ESC_ESC;
+		}
+		else
+		{
+			*out++ = data[i];
+		}
+	}
+	*out++ = SLIP_END;
+
+	frame.resize(out - frame.data());
+}
+
+bool SLIP::next_packet(const uint8_t *data, size_t bytes_read, size_t &pos, std::vector<uint8_t> &packet)
+{
+	// bytes outside any packet are dropped, as split_into_packets does
+	while (pos < bytes_read && data[pos] != SLIP_END)
+		pos++;
+
+	size_t start = pos;
+	size_t end = start + 1;
+	while (end < bytes_read && data[end] != SLIP_END)
+		end++;
+	if (end >= bytes_read)
+		return false;
+
+	// the decoded packet is never longer than the frame
+	packet.resize(end - start - 1);
+	uint8_t *out = packet.data();
+	for (size_t i = start + 1; i < end; i++)
+	{
+		if (data[i] != SLIP_ESC)
+			*out++ = data[i];
+		else if (data[i + 1] == SLIP_ESC_END || data[i + 1] == SLIP_ESC_ESC)
+			*out++ = data[++i] == SLIP_ESC_END ? SLIP_END : SLIP_ESC;
+		else
+		{
+			// Invalid escape sequence
+			out = packet.data();
+			break;
+		}
+	}
+	packet.resize(out - packet.data());
+
+	pos = end + 1;
+	return true;
+}
+
 #endif
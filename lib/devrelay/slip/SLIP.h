@@ -15,5 +15,14 @@ public:
 	// these encode and decode exactly one SLIP frame, and expect it to be sane.
 	static std::vector<uint8_t> encode(const std::vector<uint8_t> &data);
 	static std::vector<uint8_t> decode(const std::vector<uint8_t> &data);
-	static std::vector<std::vector<uint8_t>> split_into_packets(const uint8_t *data, size_t bytes_read);
+	// consumed, if given, is set to the bytes up to the end of the last whole packet, the rest is one still arriving
+	static std::vector<std::vector<uint8_t>> split_into_packets(const uint8_t *data, size_t bytes_read, size_t *consumed = nullptr);
+
+	// These work in buffers the caller keeps, which only grow when a bigger packet comes along.
+	// encode_into replaces frame with the SLIP frame for len bytes of data.
+	static void encode_into(const uint8_t *data, size_t len, std::vector<uint8_t> &frame);
+	// next_packet decodes the first whole frame from pos into packet, and moves pos past it.
+	// Returns false, leaving pos at the frame still arriving if there is one, when there are no more.
+	// A frame with a bad escape comes back as an empty packet.
+	static bool next_packet(const uint8_t *data, size_t bytes_read, size_t &pos, std::vector<uint8_t> &packet);
 };
@@ -0,0 +1,62 @@
+#ifdef DEV_RELAY_SLIP
+
+#include <new>
+
+#include "Command.h"
+
+// Free lists of Command sized blocks, by size in steps of POOL_GRAIN.
+// Each thread has its own, so nothing is locked. A block can be freed on another thread than made it, it then
+// joins that thread's list. Lists are kept short, and left to the process when a thread ends, as a Command
+// can outlive its thread's thread_locals (smartport's current_request does).
+#define POOL_GRAIN 16
+#define POOL_SIZES 16	  // up to 256 bytes, bigger ones use the heap
+#define POOL_KEEP 8		  // blocks kept of each size
+
+namespace
+{
+struct FreeBlock
+{
+	FreeBlock *next;
+};
+
+struct CommandPool
+{
+	FreeBlock *free[POOL_SIZES];
+	uint8_t count[POOL_SIZES];
+};
+
+thread_local CommandPool pool; // trivially destructible, so usable until the thread is gone
+} // namespace
+
+void *Command::operator new(size_t size)
+{
+	size_t grains = (size + POOL_GRAIN - 1) / POOL_GRAIN;
+	if (grains >= POOL_SIZES)
+		return ::operator new(size);
+
+	FreeBlock *block = pool.free[grains];
+	if (block != nullptr)
+	{
+		pool.free[grains] = block->next;
+		pool.count[grains]--;
+		return block;
+	}
+	return ::operator new(grains * POOL_GRAIN);
+}
+
+void Command::operator delete(void *ptr, size_t size)
+{
+	size_t grains = (size + POOL_GRAIN - 1) / POOL_GRAIN;
+	if (grains >= POOL_SIZES || pool.count[grains] >= POOL_KEEP)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	FreeBlock *block = static_cast<FreeBlock *>(ptr);
+	block->next = pool.free[grains];
+	pool.free[grains] = block;
+	pool.count[grains]++;
+}
+
+#endif
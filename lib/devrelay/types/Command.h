@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <stdint.h>
 #include <vector>
 
@@ -15,7 +16,10 @@ enum
 	CMD_CLOSE = 7,
 	CMD_READ = 8,
 	CMD_WRITE = 9,
-	CMD_RESET = 10
+	CMD_RESET = 10,
+	// #FujiNet extensions
+	CMD_READ_BLOCKS = 11,
+	CMD_WRITE_BLOCKS = 12
 };
 
 class Command
@@ -29,4 +33,8 @@ public:
 
     uint8_t get_request_sequence_number() const { return request_sequence_number_; }
     virtual std::vector<uint8_t> serialize() const = 0;
+
+    // A Request and its Response are made for every packet, so their memory is pooled rather than going back to the heap
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
 };
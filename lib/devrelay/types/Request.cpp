@@ -11,10 +11,12 @@
 #include "../commands/Open.h"
 #include "../commands/Read.h"
 #include "../commands/ReadBlock.h"
+#include "../commands/ReadBlocks.h"
 #include "../commands/Reset.h"
 #include "../commands/Status.h"
 #include "../commands/Write.h"
 #include "../commands/WriteBlock.h"
+#include "../commands/WriteBlocks.h"
 
 Request::Request(const uint8_t request_sequence_number, const uint8_t command_number, const uint8_t device_id) : Command(request_sequence_number), command_number_(command_number), device_id_(device_id) {}
 
@@ -29,18 +31,31 @@ void Request::init_command(uint8_t* cmd_data) const {
 	cmd_data[0] = get_command_number();
 }
 
+// Frames come straight off the wire, so check one is long enough before reading its fields
+static void require_length(const std::vector<uint8_t>& packet, size_t length) {
+  if (packet.size() < length) {
+    std::ostringstream oss;
+    oss << "Not enough data for command " << (packet.size() > 1 ? (int)packet[1] : -1) << ": " << packet.size() << " < " << length;
+    throw std::runtime_error(oss.str());
+  }
+}
+
 std::unique_ptr<Request> Request::from_packet(const std::vector<uint8_t>& packet) {
 	std::unique_ptr<Request> request;
+  // sequence number, command and device id
+  require_length(packet, 3);
   uint8_t command = packet[1];
   switch(command) {
 
   case CMD_STATUS: {
+    require_length(packet, 4);
     uint8_t network_unit = packet.size() > 4 ? packet[4] : 0;
     request = std::make_unique<StatusRequest>(packet[0], packet[2], packet[3], network_unit);
     break;
   }
 
   case CMD_CONTROL: {
+    require_length(packet, 7);
     uint8_t network_unit = packet.size() > 4 ? packet[4] : 0;
     // +7 = 3 for "header", 1 for control code, 1 for network unit, 2 for length bytes we need to skip
     std::vector<uint8_t> payload(packet.begin() + 7, packet.end());
@@ -49,6 +64,7 @@ std::unique_ptr<Request> Request::from_packet(const std::vector<uint8_t>& packet
   }
 
   case CMD_READ_BLOCK: {
+    require_length(packet, 8);
     auto bs = (packet[4] << 8) | packet[3];
     auto readBlockRequest = std::make_unique<ReadBlockRequest>(packet[0], packet[2], bs);
     readBlockRequest->set_block_number_from_ptr(packet.data(), 5);
@@ -57,7 +73,9 @@ std::unique_ptr<Request> Request::from_packet(const std::vector<uint8_t>& packet
   }
 
   case CMD_WRITE_BLOCK: {
+    require_length(packet, 8);
     auto bs = (packet[4] << 8) | packet[3];
+    require_length(packet, 8 + bs);
     auto writeBlockRequest = std::make_unique<WriteBlockRequest>(packet[0], packet[2], bs);
     writeBlockRequest->set_block_number_from_ptr(packet.data(), 5);
     writeBlockRequest->set_block_data_from_ptr(packet.data(), 8);
@@ -65,6 +83,25 @@ std::unique_ptr<Request> Request::from_packet(const std::vector<uint8_t>& packet
     break;
   }
 
+  case CMD_READ_BLOCKS: {
+    require_length(packet, 8);
+    auto count = (packet[4] << 8) | packet[3];
+    auto readBlocksRequest = std::make_unique<ReadBlocksRequest>(packet[0], packet[2], count);
+    readBlocksRequest->set_block_number_from_ptr(packet.data(), 5);
+    request = std::move(readBlocksRequest);
+    break;
+  }
+
+  case CMD_WRITE_BLOCKS: {
+    require_length(packet, 8);
+    auto count = (packet[4] << 8) | packet[3];
+    auto writeBlocksRequest = std::make_unique<WriteBlocksRequest>(packet[0], packet[2], count);
+    writeBlocksRequest->set_block_number_from_ptr(packet.data(), 5);
+    writeBlocksRequest->set_block_data_from_ptr(packet.data(), 8, packet.size() - 8);
+    request = std::move(writeBlocksRequest);
+    break;
+  }
+
   case CMD_FORMAT: {
     request = std::make_unique<FormatRequest>(packet[0], packet[2]);
     break;
@@ -86,6 +123,7 @@ std::unique_ptr<Request> Request::from_packet(const std::vector<uint8_t>& packet
   }
 
   case CMD_READ: {
+    require_length(packet, 8);
     auto readRequest = std::make_unique<ReadRequest>(packet[0], packet[2]);
     readRequest->set_byte_count_from_ptr(packet.data(), 3);
     readRequest->set_address_from_ptr(packet.data(), 5);
@@ -94,6 +132,7 @@ std::unique_ptr<Request> Request::from_packet(const std::vector<uint8_t>& packet
   }
 
   case CMD_WRITE: {
+    require_length(packet, 8);
     auto writeRequest = std::make_unique<WriteRequest>(packet[0], packet[2]);
     writeRequest->set_byte_count_from_ptr(packet.data(), 3);
     writeRequest->set_address_from_ptr(packet.data(), 5);
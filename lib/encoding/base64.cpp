@@ -148,3 +148,223 @@ std::unique_ptr<unsigned char[]> Base64::decode(const char* src, size_t len, siz
 std::unique_ptr<unsigned char[]> Base64::url_decode(const char* src, size_t len, size_t* out_len) {
     return base64_gen_decode(src, len, out_len, base64_url_table);
 }
+
+/* Streaming codec */
+
+static const char stream_enc[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* 0x80 marks everything that is not a plain alphabet character, '=' included */
+struct StreamDecodeTable {
+    uint8_t v[256];
+    constexpr StreamDecodeTable() : v() {
+        for (int i = 0; i < 256; i++)
+            v[i] = 0x80;
+        for (int i = 0; i < 64; i++)
+            v[(unsigned char)stream_enc[i]] = i;
+    }
+};
+static constexpr StreamDecodeTable stream_dec;
+
+#define B64_LINE_GROUPS 18 /* 72 characters per line */
+
+static inline char *encode_group(char *pos, const uint8_t *in)
+{
+    uint32_t v = (in[0] << 16) | (in[1] << 8) | in[2];
+    pos[0] = stream_enc[v >> 18];
+    pos[1] = stream_enc[(v >> 12) & 0x3f];
+    pos[2] = stream_enc[(v >> 6) & 0x3f];
+    pos[3] = stream_enc[v & 0x3f];
+    return pos + 4;
+}
+
+void Base64Encoder::update(const uint8_t* src, size_t len, std::string& out) {
+    const uint8_t *in = src, *end = src + len;
+    size_t groups = (carry_len + len) / 3;
+    size_t start = out.size();
+
+    // room for every group plus a line feed per (possibly partial) line
+    out.resize(start + groups * 4 + groups / B64_LINE_GROUPS + 1);
+    char *pos = &out[start];
+
+    if (carry_len) {
+        while (carry_len < 3 && in < end)
+            carry[carry_len++] = *in++;
+        if (carry_len < 3) {
+            out.resize(start);
+            return;
+        }
+        pos = encode_group(pos, carry);
+        carry_len = 0;
+        if ((line_len += 4) == B64_LINE_GROUPS * 4) {
+            *pos++ = '\n';
+            line_len = 0;
+        }
+    }
+
+    while (end - in >= 3) {
+        // whole lines at a time once aligned
+        if (line_len == 0 && end - in >= B64_LINE_GROUPS * 3) {
+            for (int g = 0; g < B64_LINE_GROUPS; g++, in += 3)
+                pos = encode_group(pos, in);
+            *pos++ = '\n';
+            continue;
+        }
+        pos = encode_group(pos, in);
+        in += 3;
+        if ((line_len += 4) == B64_LINE_GROUPS * 4) {
+            *pos++ = '\n';
+            line_len = 0;
+        }
+    }
+
+    while (in < end)
+        carry[carry_len++] = *in++;
+
+    out.resize(pos - out.data());
+}
+
+void Base64Encoder::finish(std::string& out) {
+    if (carry_len) {
+        out += stream_enc[carry[0] >> 2];
+        if (carry_len == 1) {
+            out += stream_enc[(carry[0] & 0x03) << 4];
+            out += "==";
+        } else {
+            out += stream_enc[((carry[0] & 0x03) << 4) | (carry[1] >> 4)];
+            out += stream_enc[(carry[1] & 0x0f) << 2];
+            out += '=';
+        }
+        line_len += 4;
+    }
+    if (line_len)
+        out += '\n';
+    reset();
+}
+
+char* Base64Decoder::push(char c, char* pos) {
+    uint8_t tmp;
+
+    if (c == '=') {
+        tmp = 0;
+        pad++;
+    } else if ((tmp = stream_dec.v[(unsigned char)c]) == 0x80) {
+        return pos;
+    }
+
+    seen = true;
+    block[count++] = tmp;
+    if (count < 4)
+        return pos;
+
+    count = 0;
+    *pos++ = (char)((block[0] << 2) | (block[1] >> 4));
+    *pos++ = (char)((block[1] << 4) | (block[2] >> 2));
+    *pos++ = (char)((block[2] << 6) | block[3]);
+    if (pad) {
+        if (pad <= 2)
+            pos -= pad;
+        else
+            failed = true; /* Invalid padding */
+        done = true;
+    }
+    return pos;
+}
+
+void Base64Decoder::update(const char* src, size_t len, std::string& out) {
+    const unsigned char *in = (const unsigned char *)src, *end = in + len;
+
+    if (done)
+        return;
+
+    // the carried characters complete at most one more block
+    size_t start = out.size();
+    out.resize(start + len / 4 * 3 + 3);
+    char *pos = &out[start];
+
+    while (in < end && !done) {
+        if (count == 0 && end - in >= 4) {
+            uint8_t a = stream_dec.v[in[0]], b = stream_dec.v[in[1]];
+            uint8_t c = stream_dec.v[in[2]], d = stream_dec.v[in[3]];
+
+            // a whole clean quad: no padding, line feeds or junk in it
+            if (((a | b | c | d) & 0x80) == 0) {
+                uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+                pos[0] = (char)(v >> 16);
+                pos[1] = (char)(v >> 8);
+                pos[2] = (char)v;
+                pos += 3;
+                in += 4;
+                seen = true;
+                continue;
+            }
+        }
+        pos = push(*in++, pos);
+    }
+
+    out.resize(pos - out.data());
+}
+
+bool Base64Decoder::finish(std::string& out) {
+    bool ok;
+
+    if (!done && seen) {
+        char tail[3];
+        char *pos = tail;
+        while (count != 0 && !done)
+            pos = push('=', pos);
+        out.append(tail, pos - tail);
+    }
+    ok = seen && !failed;
+    reset();
+    return ok;
+}
+
+void Base64::encode_input(const void* src, size_t len) {
+    if (computed)
+        clear_buffer();
+    encoder.update(static_cast<const uint8_t*>(src), len, base64_buffer);
+}
+
+bool Base64::encode_compute() {
+    encoder.finish(base64_buffer);
+    computed = true;
+    return true;
+}
+
+void Base64::decode_input(const char* src, size_t len) {
+    if (computed)
+        clear_buffer();
+    decoder.update(src, len, base64_buffer);
+}
+
+bool Base64::decode_compute() {
+    if (!decoder.finish(base64_buffer)) {
+        clear_buffer();
+        return false;
+    }
+    computed = true;
+    return true;
+}
+
+size_t Base64::output(void* dst, size_t len) {
+    size_t avail = output_length();
+
+    if (len > avail)
+        len = avail;
+    std::memcpy(dst, base64_buffer.data() + output_pos, len);
+    output_pos += len;
+
+    if (output_pos == base64_buffer.size())
+        clear_buffer();
+
+    return len;
+}
+
+void Base64::clear_buffer() {
+    base64_buffer.clear();
+    base64_buffer.shrink_to_fit();
+    output_pos = 0;
+    computed = false;
+    encoder.reset();
+    decoder.reset();
+}
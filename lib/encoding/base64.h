@@ -14,6 +14,48 @@
 #include <string>
 #include <memory>
 
+/**
+ * Streaming encoder, produces exactly what Base64::encode() does for the
+ * concatenation of everything passed to update(): line feeds every 72
+ * characters and after the last line. Up to two input bytes are carried
+ * between update() calls.
+ */
+class Base64Encoder {
+public:
+    void reset() { carry_len = 0; line_len = 0; }
+    void update(const uint8_t* src, size_t len, std::string& out);
+    void finish(std::string& out);
+
+private:
+    uint8_t carry[3];
+    uint8_t carry_len = 0;
+    int line_len = 0;
+};
+
+/**
+ * Streaming decoder, produces exactly what Base64::decode() does for the
+ * concatenation of everything passed to update(). Characters outside the
+ * alphabet are skipped and decoding stops after the first padded block.
+ * Up to three characters are carried between update() calls.
+ */
+class Base64Decoder {
+public:
+    void reset() { count = 0; pad = 0; seen = false; done = false; failed = false; }
+    void update(const char* src, size_t len, std::string& out);
+    /* false if there was nothing to decode or the padding was invalid */
+    bool finish(std::string& out);
+
+private:
+    uint8_t block[4];
+    uint8_t count = 0;
+    uint8_t pad = 0;
+    bool seen = false;
+    bool done = false;
+    bool failed = false;
+
+    char* push(char c, char* pos);
+};
+
 class Base64 {
 private:
     static inline const char base64_table[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -50,13 +92,31 @@ public:
     static std::unique_ptr<unsigned char[]> decode(const char* src, size_t len, size_t* out_len);
     static std::unique_ptr<unsigned char[]> url_decode(const char* src, size_t len, size_t* out_len);
 
-    std::string get_buffer() const { return base64_buffer; }
-    void set_buffer(const std::string& buffer) { base64_buffer = buffer; }
-    void clear_buffer() { base64_buffer.clear(); }
+    /*
+     * The fuji BASE64 commands: every INPUT frame goes through the streaming
+     * codec as it arrives, so only the result is ever held. COMPUTE flushes
+     * the codec and OUTPUT hands out the result front to back.
+     */
+    void encode_input(const void* src, size_t len);
+    bool encode_compute();
+    void decode_input(const char* src, size_t len);
+    bool decode_compute();
+    size_t output_length() const { return base64_buffer.size() - output_pos; }
+    size_t output(void* dst, size_t len);
+
+    std::string get_buffer() const { return base64_buffer.substr(output_pos); }
+    void set_buffer(const std::string& buffer) { clear_buffer(); base64_buffer = buffer; }
+    void clear_buffer();
     void add_buffer(const std::string& extra) { base64_buffer += extra; }
 
     std::string base64_buffer;
 
+private:
+    Base64Encoder encoder;
+    Base64Decoder decoder;
+    size_t output_pos = 0;
+    bool computed = false;
+
 };
 
 extern Base64 base64;
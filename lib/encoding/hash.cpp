@@ -5,12 +5,143 @@
 
 Hash hasher;
 
-Hash::Hash() {}
+Hash::Context::Context(Algorithm algorithm) {
+    start(algorithm);
+}
+
+Hash::Context::Context(const Context& other) {
+    *this = other;
+}
 
-Hash::~Hash() {
+Hash::Context& Hash::Context::operator=(const Context& other) {
+    if (this == &other) {
+        return *this;
+    }
+    release();
+    _algorithm = other._algorithm;
+    switch (_algorithm) {
+        case Algorithm::MD5:
+            mbedtls_md5_init(&_ctx.md5);
+            mbedtls_md5_clone(&_ctx.md5, &other._ctx.md5);
+            break;
+        case Algorithm::SHA1:
+            mbedtls_sha1_init(&_ctx.sha1);
+            mbedtls_sha1_clone(&_ctx.sha1, &other._ctx.sha1);
+            break;
+        case Algorithm::SHA256:
+            mbedtls_sha256_init(&_ctx.sha256);
+            mbedtls_sha256_clone(&_ctx.sha256, &other._ctx.sha256);
+            break;
+        case Algorithm::SHA512:
+            mbedtls_sha512_init(&_ctx.sha512);
+            mbedtls_sha512_clone(&_ctx.sha512, &other._ctx.sha512);
+            break;
+        default:
+            break;
+    }
+    return *this;
+}
+
+Hash::Context::~Context() {
+    release();
+}
+
+void Hash::Context::release() {
+    switch (_algorithm) {
+        case Algorithm::MD5:
+            mbedtls_md5_free(&_ctx.md5);
+            break;
+        case Algorithm::SHA1:
+            mbedtls_sha1_free(&_ctx.sha1);
+            break;
+        case Algorithm::SHA256:
+            mbedtls_sha256_free(&_ctx.sha256);
+            break;
+        case Algorithm::SHA512:
+            mbedtls_sha512_free(&_ctx.sha512);
+            break;
+        default:
+            break;
+    }
+    _algorithm = Algorithm::UNKNOWN;
+}
+
+void Hash::Context::start(Algorithm algorithm) {
+    release();
+    _algorithm = algorithm;
+    switch (_algorithm) {
+        case Algorithm::MD5:
+            mbedtls_md5_init(&_ctx.md5);
+            mbedtls_md5_starts(&_ctx.md5);
+            break;
+        case Algorithm::SHA1:
+            mbedtls_sha1_init(&_ctx.sha1);
+            mbedtls_sha1_starts(&_ctx.sha1);
+            break;
+        case Algorithm::SHA256:
+            mbedtls_sha256_init(&_ctx.sha256);
+            mbedtls_sha256_starts(&_ctx.sha256, 0);
+            break;
+        case Algorithm::SHA512:
+            mbedtls_sha512_init(&_ctx.sha512);
+            mbedtls_sha512_starts(&_ctx.sha512, 0);
+            break;
+        default:
+            break;
+    }
+}
+
+void Hash::Context::update(const uint8_t* data, size_t len) {
+    switch (_algorithm) {
+        case Algorithm::MD5:
+            mbedtls_md5_update(&_ctx.md5, data, len);
+            break;
+        case Algorithm::SHA1:
+            mbedtls_sha1_update(&_ctx.sha1, data, len);
+            break;
+        case Algorithm::SHA256:
+            mbedtls_sha256_update(&_ctx.sha256, data, len);
+            break;
+        case Algorithm::SHA512:
+            mbedtls_sha512_update(&_ctx.sha512, data, len);
+            break;
+        default:
+            break;
+    }
+}
+
+std::vector<uint8_t> Hash::Context::finish() {
+    std::vector<uint8_t> digest;
+    switch (_algorithm) {
+        case Algorithm::MD5:
+            digest.resize(16);
+            mbedtls_md5_finish(&_ctx.md5, digest.data());
+            break;
+        case Algorithm::SHA1:
+            digest.resize(20);
+            mbedtls_sha1_finish(&_ctx.sha1, digest.data());
+            break;
+        case Algorithm::SHA256:
+            digest.resize(32);
+            mbedtls_sha256_finish(&_ctx.sha256, digest.data());
+            break;
+        case Algorithm::SHA512:
+            digest.resize(64);
+            mbedtls_sha512_finish(&_ctx.sha512, digest.data());
+            break;
+        default:
+            break;
+    }
+    release();
+    return digest;
+}
+
+Hash::Hash() {
     clear();
 }
 
+Hash::~Hash() {}
+
 Hash::Algorithm Hash::to_algorithm(uint8_t value) {
     switch (value) {
         case static_cast<uint8_t>(Algorithm::MD5):
@@ -41,16 +172,53 @@ Hash::Algorithm Hash::from_string(std::string hash_name)
     }
 }
 
+void Hash::add_data(const uint8_t* data, size_t len) {
+    for (auto& ctx : contexts) {
+        ctx.update(data, len);
+    }
+}
+
 void Hash::add_data(const std::vector<uint8_t>& data) {
-    accumulated_data.insert(accumulated_data.end(), data.begin(), data.end());
+    add_data(data.data(), data.size());
 }
 
 void Hash::add_data(const std::string& data) {
-    accumulated_data.insert(accumulated_data.end(), data.begin(), data.end());
+    add_data(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+uint8_t Hash::algorithm_bit(Algorithm algorithm) {
+    if (algorithm == Algorithm::UNKNOWN) {
+        return 0;
+    }
+    return 1 << static_cast<int>(algorithm);
 }
 
 void Hash::clear() {
-    accumulated_data.clear();
+    for (int i = 0; i < 4; i++) {
+        Algorithm algorithm = static_cast<Algorithm>(i);
+        if (_algorithms & algorithm_bit(algorithm)) {
+            contexts[i].start(algorithm);
+        } else {
+            contexts[i] = Context();
+        }
+    }
+}
+
+void Hash::clear(uint8_t algorithms) {
+    algorithms &= ALL_ALGORITHMS;
+    _algorithms = algorithms == 0 ? ALL_ALGORITHMS : algorithms;
+    clear();
+}
+
+void Hash::select(Algorithm algorithm) {
+    if (algorithm == Algorithm::UNKNOWN) {
+        return;
+    }
+    for (auto& ctx : contexts) {
+        if (ctx.algorithm() != algorithm) {
+            ctx = Context();
+        }
+    }
 }
 
 size_t Hash::hash_length(Algorithm algorithm, bool is_hex) const {
@@ -76,18 +244,10 @@ size_t Hash::hash_length(Algorithm algorithm, bool is_hex) const {
 
 void Hash::compute(Algorithm algorithm, bool clear_data) {
     hash_output.clear();
-    switch (algorithm) {
-        case Algorithm::SHA1:
-            compute_sha1();
-            break;
-        case Algorithm::SHA256:
-            compute_sha256();
-            break;
-        case Algorithm::SHA512:
-            compute_sha512();
-            break;
-        default:
-            break;
+    if (algorithm != Algorithm::UNKNOWN) {
+        // finish a copy so more data can still follow when not clearing
+        Context ctx = contexts[static_cast<int>(algorithm)];
+        hash_output = ctx.finish();
     }
     if (clear_data) {
         clear();
@@ -102,36 +262,6 @@ std::string Hash::output_hex() const {
     return bytes_to_hex(hash_output);
 }
 
-void Hash::compute_sha1() {
-    mbedtls_sha1_context ctx;
-    mbedtls_sha1_init(&ctx);
-    mbedtls_sha1_starts(&ctx);
-    mbedtls_sha1_update(&ctx, accumulated_data.data(), accumulated_data.size());
-    hash_output.resize(20);
-    mbedtls_sha1_finish(&ctx, hash_output.data());
-    mbedtls_sha1_free(&ctx);
-}
-
-void Hash::compute_sha256() {
-    mbedtls_sha256_context ctx;
-    mbedtls_sha256_init(&ctx);
-    mbedtls_sha256_starts(&ctx, 0);
-    mbedtls_sha256_update(&ctx, accumulated_data.data(), accumulated_data.size());
-    hash_output.resize(32);
-    mbedtls_sha256_finish(&ctx, hash_output.data());
-    mbedtls_sha256_free(&ctx);
-}
-
-void Hash::compute_sha512() {
-    mbedtls_sha512_context ctx;
-    mbedtls_sha512_init(&ctx);
-    mbedtls_sha512_starts(&ctx, 0);
-    mbedtls_sha512_update(&ctx, accumulated_data.data(), accumulated_data.size());
-    hash_output.resize(64);
-    mbedtls_sha512_finish(&ctx, hash_output.data());
-    mbedtls_sha512_free(&ctx);
-}
-
 std::string Hash::bytes_to_hex(const std::vector<uint8_t>& bytes) const {
     std::stringstream hex_stream;
     hex_stream << std::hex << std::setfill('0');
@@ -14,12 +14,54 @@ public:
         UNKNOWN = -1, MD5, SHA1, SHA256, SHA512
     };
 
+    // Sets of algorithms for clear(), bit n for Algorithm n
+    static constexpr uint8_t ALL_ALGORITHMS = 0x0F;
+    static uint8_t algorithm_bit(Algorithm algorithm);
+
+    // A single running digest: start(), any number of update() calls, finish().
+    // On the ESP32 the SHA variants use the hardware engine when
+    // CONFIG_MBEDTLS_HARDWARE_SHA is set, mbedtls falls back to software for
+    // contexts that cannot get it.
+    class Context {
+    public:
+        Context() = default;
+        explicit Context(Algorithm algorithm);
+        Context(const Context& other);
+        Context& operator=(const Context& other);
+        ~Context();
+
+        void start(Algorithm algorithm);
+        void update(const uint8_t* data, size_t len);
+        std::vector<uint8_t> finish();
+        Algorithm algorithm() const { return _algorithm; }
+
+    private:
+        Algorithm _algorithm = Algorithm::UNKNOWN;
+        union {
+            mbedtls_md5_context md5;
+            mbedtls_sha1_context sha1;
+            mbedtls_sha256_context sha256;
+            mbedtls_sha512_context sha512;
+        } _ctx;
+
+        void release();
+    };
+
     Hash();
     ~Hash();
 
+    void add_data(const uint8_t* data, size_t len);
     void add_data(const std::vector<uint8_t>& data);
     void add_data(const std::string& data);
+    // Start over, running the same algorithms as before
     void clear();
+    // Start over, running only these algorithms until the next clear(algorithms),
+    // so input doesn't pay for digests nobody will ask for. The others compute
+    // to an empty result. 0 runs all four.
+    void clear(uint8_t algorithms);
+    // Keep only this algorithm's running digest until the next clear(), for
+    // input that has started already. UNKNOWN leaves them all running.
+    void select(Algorithm algorithm);
     size_t hash_length(Algorithm algorithm, bool is_hex) const;
     void compute(Algorithm algorithm, bool clear_data);
     std::vector<uint8_t> output_binary() const;
@@ -29,15 +71,15 @@ public:
     static Hash::Algorithm from_string(std::string hash_name);
 
 private:
-    std::vector<uint8_t> accumulated_data;
+    // The algorithms asked for run alongside each other as data arrives, so
+    // any of them can be computed afterwards without keeping the data itself.
+    Context contexts[4];
+    uint8_t _algorithms = ALL_ALGORITHMS;
     std::vector<uint8_t> hash_output;
 
-    void compute_sha1();
-    void compute_sha256();
-    void compute_sha512();
     std::string bytes_to_hex(const std::vector<uint8_t>& bytes) const;
 };
 
 extern Hash hasher;
 
-#endif // HASH_H
\ No newline at end of file
+#endif // HASH_H
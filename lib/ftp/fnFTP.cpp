@@ -784,12 +784,33 @@ bool fnFTP::reconnect()
 
 bool fnFTP::open_file(string path, bool stor)
 {
+    return start_transfer(path, stor, 0, false);
+}
+
+bool fnFTP::open_file_at(string path, long offset)
+{
+    return start_transfer(path, false, offset, false);
+}
+
+bool fnFTP::store_file_at(string path, long offset, bool append)
+{
+    return start_transfer(path, true, offset, append);
+}
+
+bool fnFTP::start_transfer(const string &path, bool stor, long offset, bool append)
+{
+    const char *verb = append ? "APPE" : (stor ? "STOR" : "RETR");
+
     if (!control->connected())
     {
         Debug_printf("fnFTP::open_file(%s) attempted while not logged in. Aborting.\r\n", path.c_str());
         return true;
     }
 
+    // there is only one data connection
+    if (_retr_open)
+        abort_transfer();
+
     int retries = 2;
     while (get_data_port())
     {
@@ -800,12 +821,28 @@ bool fnFTP::open_file(string path, bool stor)
             if (!reconnect())
                 continue; // successfully reconnected
         }
-        Debug_printf("fnFTP::open_file(%s, %s) could not get data port. Aborting.\n", path.c_str(), stor ? "STOR" : "RETR");
+        Debug_printf("fnFTP::open_file(%s, %s) could not get data port. Aborting.\n", path.c_str(), verb);
         return true;
     }
 
+    if (offset > 0 && !append)
+    {
+        REST(offset);
+
+        if (parse_response() || !is_positive_intermediate_reply())
+        {
+            Debug_printf("Server refused REST %ld. Response was: %s\r\n", offset, controlResponse.c_str());
+            data->stop();
+            return true;
+        }
+    }
+
     // Do command
-    if (stor == true)
+    if (append)
+    {
+        APPE(path);
+    }
+    else if (stor == true)
     {
         STOR(path);
     }
@@ -824,6 +861,8 @@ bool fnFTP::open_file(string path, bool stor)
     {
         _stor = stor;
         _expect_control_response = !stor;
+        _retr_open = !stor;
+        _transfer_id++;
         Debug_printf("Server began transfer.\r\n");
         return false;
     }
@@ -834,6 +873,75 @@ bool fnFTP::open_file(string path, bool stor)
     }
 }
 
+bool fnFTP::abort_transfer()
+{
+    bool res = false;
+    Debug_printf("fnFTP::abort_transfer()\r\n");
+
+    if (_stor)
+        return close();
+
+    // the reply to the transfer may be in already
+    if (_expect_control_response && control->available())
+        _expect_control_response = parse_response();
+
+    data->stop();
+
+    if (_expect_control_response)
+    {
+        // first reply ends the transfer: 426, or 226 if it had just finished
+        ABOR();
+        res = parse_response();
+
+        // then comes the reply to ABOR, which follows 426 for certain but
+        // not every server sends one after 226
+        if (!res)
+        {
+            bool broken = is_negative_transient_reply();
+            int tmout_counter = 1 + FTP_ABORT_TIMEOUT / FTP_POLL_MS;
+            while (!broken && control->available() == 0 && --tmout_counter)
+                fnSystem.delay(FTP_POLL_MS);
+            if (broken || control->available())
+                res = parse_response();
+        }
+    }
+
+    _expect_control_response = false;
+    _retr_open = false;
+    _transfer_id++;
+    return res;
+}
+
+bool fnFTP::get_size(string path, long &size)
+{
+    if (!control->connected())
+    {
+        Debug_printf("fnFTP::get_size(%s) attempted while not logged in. Aborting.\r\n", path.c_str());
+        return true;
+    }
+
+    // replies to a running transfer would get in the way
+    if (_retr_open)
+        abort_transfer();
+
+    SIZE(path);
+
+    if (parse_response())
+    {
+        Debug_printf("Timed out waiting for 213 response.\r\n");
+        return true;
+    }
+
+    if (_statusCode != 213)
+    {
+        Debug_printf("Server could not give size. Response was: %s\r\n", controlResponse.c_str());
+        return true;
+    }
+
+    size = atol(controlResponse.substr(4).c_str());
+    return false;
+}
+
 bool fnFTP::open_directory(string path, string pattern)
 {
     if (!control->connected())
@@ -842,6 +950,9 @@ bool fnFTP::open_directory(string path, string pattern)
         return true;
     }
 
+    if (_retr_open)
+        abort_transfer();
+
     int retries = 2;
     while (get_data_port())
     {
@@ -995,6 +1106,8 @@ bool fnFTP::close()
     }
     _stor = false;
     _expect_control_response = false;
+    _retr_open = false;
+    _transfer_id++;
     control->flush();
     return res;
 }
@@ -1069,7 +1182,7 @@ int fnFTP::read_response_line(char *buf, int buflen)
 {
     int num_read = 0;
     int c;
-    int tmout_counter = 1 + FTP_TIMEOUT / 50;
+    int tmout_counter = 1 + FTP_TIMEOUT / FTP_POLL_MS;
 
     while(true)
     {
@@ -1080,7 +1193,7 @@ int fnFTP::read_response_line(char *buf, int buflen)
                 Debug_printf("fnFTP::read_response_line() - Timeout waiting response\r\n");
                 return -1;
             }
-            fnSystem.delay(50);
+            fnSystem.delay(FTP_POLL_MS);
             continue;
         }
 
@@ -1103,7 +1216,7 @@ int fnFTP::read_response_line(char *buf, int buflen)
         // store char, ignore rest of too long response
         if (num_read < buflen)
             buf[num_read++] = (char) c;
-        tmout_counter = 1 + FTP_TIMEOUT / 50; // reset timeout counter
+        tmout_counter = 1 + FTP_TIMEOUT / FTP_POLL_MS; // reset timeout counter
     }
     return num_read;
 }
@@ -1231,4 +1344,22 @@ void fnFTP::STOR(string path)
 {
     Debug_printf("fnFTP::STOR(%s)\r\n",path.c_str());
     control->write("STOR " + path + "\r\n");
+}
+
+void fnFTP::APPE(string path)
+{
+    Debug_printf("fnFTP::APPE(%s)\r\n",path.c_str());
+    control->write("APPE " + path + "\r\n");
+}
+
+void fnFTP::REST(long offset)
+{
+    Debug_printf("fnFTP::REST(%ld)\r\n",offset);
+    control->write("REST " + std::to_string(offset) + "\r\n");
+}
+
+void fnFTP::SIZE(string path)
+{
+    Debug_printf("fnFTP::SIZE(%s)\r\n",path.c_str());
+    control->write("SIZE " + path + "\r\n");
 }
\ No newline at end of file
@@ -12,6 +12,8 @@
 using std::string;
 
 #define FTP_TIMEOUT 15000 // This is how long we wait for a reply packet from the server
+#define FTP_ABORT_TIMEOUT 1000 // How long we wait for a reply to ABOR which may never come
+#define FTP_POLL_MS 10 // How often we look for a reply, every command waits for one
 
 class fnFTP
 {
@@ -58,6 +60,47 @@ public:
      */
     bool open_file(string path, bool stor);
 
+    /**
+     * Open file on FTP server for reading, starting at offset (REST + RETR).
+     * Data is then taken with read_file() for as long as the caller wants,
+     * abort_transfer() stops it early.
+     * @param path to file to open.
+     * @param offset first byte wanted.
+     * @return TRUE if error, FALSE if successful.
+     */
+    bool open_file_at(string path, long offset);
+
+    /**
+     * Open file on FTP server for writing at offset. Writing at the end of
+     * the file uses APPE, anywhere else REST + STOR, which leaves the rest of
+     * the file in place on servers that support restarted uploads.
+     * @param path to file to write.
+     * @param offset first byte to write.
+     * @param append TRUE if offset is the current end of file.
+     * @return TRUE if error, FALSE if successful.
+     */
+    bool store_file_at(string path, long offset, bool append);
+
+    /**
+     * Stop a running transfer and collect the server replies for it.
+     * @return TRUE if error, FALSE if successful.
+     */
+    bool abort_transfer();
+
+    /**
+     * Get size of file on FTP server (SIZE).
+     * @param path file to ask for.
+     * @param size receives the size in bytes.
+     * @return TRUE if error or not supported, FALSE if successful.
+     */
+    bool get_size(string path, long &size);
+
+    /**
+     * @brief changes each time a data transfer starts or ends, so the owner
+     * of a transfer can tell whether it is still the one running.
+     */
+    uint32_t transfer_id() { return _transfer_id; }
+
     /**
      * Open directory on FTP server, grab it, and return back.
      * @param path directory to retrieve.
@@ -133,6 +176,12 @@ private:
     /* if to check control channel too while dealing with data channel */
     bool _expect_control_response = false;
 
+    /* a RETR is open which may be left before its end */
+    bool _retr_open = false;
+
+    /* see transfer_id() */
+    uint32_t _transfer_id = 0;
+
     /* FTP status code, taken from FTP server response */
     int _statusCode = 0;
 
@@ -188,6 +237,12 @@ private:
      */
     int read_response_line(char *buf, int buflen);
 
+    /**
+     * Start RETR, STOR or APPE of path, after REST offset if not 0.
+     * @return TRUE if error, FALSE if successful.
+     */
+    bool start_transfer(const string &path, bool stor, long offset, bool append);
+
     /**
      * Ask server to prepare a data port for us in extended passive mode.
      * Port is set and returned in data_port variable.
@@ -316,6 +371,24 @@ private:
      */
     void STOR(string path);
 
+    /**
+     * @brief ask server to append to path
+     * @param path path to append to
+     */
+    void APPE(string path);
+
+    /**
+     * @brief set offset for the next RETR or STOR
+     * @param offset byte offset
+     */
+    void REST(long offset);
+
+    /**
+     * @brief ask server for size of path
+     * @param path file to ask for
+     */
+    void SIZE(string path);
+
 };
 
 #endif /* FNFTP_H */
\ No newline at end of file
@@ -71,6 +71,10 @@
 #define FUJICMD_GET_ADAPTERCONFIG_EXTENDED 0xC4
 #define FUJICMD_HASH_COMPUTE_NO_CLEAR	   0xC3
 #define FUJICMD_HASH_CLEAR				   0xC2
+#define FUJICMD_HASH_HOST_FILE			   0xC1
+#define FUJICMD_COPY_STATUS				   0xC0
+#define FUJICMD_COPY_CONTROL			   0xBF
+#define FUJICMD_HASH_STATUS			   0xBE
 #define FUJICMD_SEND_ERROR				   0x02
 #define FUJICMD_SEND_RESPONSE			   0x01
 #define FUJICMD_DEVICE_READY			   0x00
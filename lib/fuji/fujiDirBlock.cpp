@@ -0,0 +1,114 @@
+
+#include "fujiDirBlock.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+#include "../../include/debug.h"
+
+
+uint16_t fuji_read_directory_block(fujiHost *host, uint8_t *buf, uint16_t bufsize,
+                                   uint8_t maxlen, uint8_t options,
+                                   uint8_t details_size, fujiDirDetails details)
+{
+    bool is_extended = (options & DIRBLOCK_EXTENDED) == DIRBLOCK_EXTENDED;
+    uint16_t pages = DIRBLOCK_PAGES(options);
+    if (pages * DIRBLOCK_PAGE_SIZE > bufsize)
+        pages = bufsize / DIRBLOCK_PAGE_SIZE;
+    if (pages == 0)
+        return 0;
+    uint16_t block_size = pages * DIRBLOCK_PAGE_SIZE;
+
+    Debug_printf("fuji_read_directory_block (pages=%u, maxlen=%u, extended: %d)\n", pages, maxlen, is_extended);
+
+    // Entries are written straight after the header as they are read, and
+    // moved up past the offsets once we know how many there are
+    uint8_t *data = buf + DIRBLOCK_HEADER_SIZE;
+    uint16_t data_size = 0;
+    uint16_t offsets[DIRBLOCK_MAX_ENTRIES];
+    uint16_t num_entries = 0;
+    char current_entry[256];
+
+    uint16_t initial_pos = host->dir_tell();
+
+    while (num_entries < DIRBLOCK_MAX_ENTRIES)
+    {
+        uint16_t pos_before_next = host->dir_tell();
+        fsdir_entry_t *f = host->dir_nextfile();
+        uint16_t entry_size;
+
+        if (f == nullptr)
+        {
+            // reached end of dir
+            current_entry[0] = 0x7F;
+            current_entry[1] = 0x7F;
+            entry_size = 2;
+        }
+        else
+        {
+            int bufsize;
+            char *filenamedest = current_entry;
+
+            if (is_extended)
+            {
+                details(f, (uint8_t *)current_entry, maxlen);
+                bufsize = sizeof(current_entry) - details_size;
+                filenamedest = current_entry + details_size;
+            }
+            else
+            {
+                bufsize = maxlen;
+            }
+
+            util_ellipsize(f->filename, filenamedest, bufsize);
+            int filelen = strlen(filenamedest);
+
+            // Add a slash at the end of directory entries
+            if (f->isDir && filelen < (bufsize - 2))
+                filenamedest[filelen++] = '/';
+
+            entry_size = (filenamedest - current_entry) + filelen;
+        }
+
+        // would this take us over the limit? 2 for its offset
+        if (DIRBLOCK_HEADER_SIZE + (num_entries + 1) * 2 + data_size + entry_size > block_size)
+        {
+            // leave it for the next block
+            if (f != nullptr)
+                host->dir_seek(pos_before_next);
+            break;
+        }
+
+        memcpy(data + data_size, current_entry, entry_size);
+        offsets[num_entries++] = data_size;
+        data_size += entry_size;
+
+        if (f == nullptr)
+            break;
+    }
+
+    uint16_t offsets_size = num_entries * 2;
+    memmove(data + offsets_size, data, data_size);
+    for (int i = 0; i < num_entries; i++)
+    {
+        data[i * 2] = offsets[i] & 0xFF;
+        data[i * 2 + 1] = offsets[i] >> 8;
+    }
+
+    uint16_t total_size = DIRBLOCK_HEADER_SIZE + offsets_size + data_size;
+    buf[0] = 'M';
+    buf[1] = 'F';
+    buf[2] = is_extended ? 0x80 : 0; // more flags may come
+    buf[3] = maxlen;
+    buf[4] = num_entries;
+    buf[5] = total_size & 0xFF;
+    buf[6] = total_size >> 8;
+    buf[7] = initial_pos & 0xFF;
+    buf[8] = initial_pos >> 8;
+
+    memset(buf + total_size, 0, block_size - total_size);
+
+    Debug_printf("fuji_read_directory_block - %u entries, %u of %u bytes\n", num_entries, total_size, block_size);
+    return block_size;
+}
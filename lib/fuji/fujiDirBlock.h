@@ -0,0 +1,50 @@
+#ifndef _FUJI_DIRBLOCK_
+#define _FUJI_DIRBLOCK_
+
+#include <stdint.h>
+
+#include "fujiHost.h"
+
+/*
+ * READ DIRECTORY ENTRY in block mode, as first done for the Atari: when both
+ * of the top bits of the options byte (aux2 on SIO) are set, as many entries
+ * as fit are packed into 1 to 8 pages of 256 bytes.
+ *
+ * Options:
+ *   b0-2 = number of pages - 1
+ *   b5   = extended entry information before each name
+ *   b6,7 = block mode marker
+ *
+ * Block, zero padded to the number of pages asked for:
+ *   byte 0-1 = "MF"
+ *   byte 2   = flags, 0x80 = extended information
+ *   byte 3   = max size per entry, as asked for
+ *   byte 4   = number of entries in the block
+ *   byte 5-6 = size of the block without the padding
+ *   byte 7-8 = directory position of the first entry
+ *   then a 2 byte offset into the data for each entry, then the data for each
+ *   entry with no terminator. An entry of 0x7F 0x7F is the end of the directory.
+ */
+#define DIRBLOCK_MODE 0xC0
+#define DIRBLOCK_EXTENDED 0x20
+#define DIRBLOCK_PAGES(options) (((options) & 0x07) + 1)
+
+#define DIRBLOCK_PAGE_SIZE 256
+#define DIRBLOCK_MAX_SIZE (8 * DIRBLOCK_PAGE_SIZE)
+#define DIRBLOCK_HEADER_SIZE 9
+#define DIRBLOCK_MAX_ENTRIES 255
+
+#define DIRBLOCK_IS_BLOCK(options) (((options) & DIRBLOCK_MODE) == DIRBLOCK_MODE)
+
+// Each platform's extended information, written to dest ahead of the name
+typedef void (*fujiDirDetails)(fsdir_entry_t *f, uint8_t *dest, uint8_t maxlen);
+
+// Packs entries from host's open directory into buf, leaving the directory
+// positioned at the first entry that didn't fit. There are fewer pages than
+// asked for if buf is too small for them. Returns the length of the padded
+// block, or 0 if not even one page fits.
+uint16_t fuji_read_directory_block(fujiHost *host, uint8_t *buf, uint16_t bufsize,
+                                   uint8_t maxlen, uint8_t options,
+                                   uint8_t details_size, fujiDirDetails details);
+
+#endif // _FUJI_DIRBLOCK_
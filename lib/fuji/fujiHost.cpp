@@ -476,6 +476,25 @@ bool fujiHost::mount()
     return 0 == mount_tnfs();
 }
 
+/* Used by fujiMountAll, which mounts hosts on a fujiHost of its own
+*  away from the main loop and hands the result over when it is done
+*/
+void fujiHost::adopt(fujiHost &other)
+{
+    Debug_printf("::adopt {%d} \"%s\"\n", slotid, other._hostname);
+
+    if (_fs != nullptr)
+        cleanup();
+
+    _type = other._type;
+    _fs = other._fs;
+    strlcpy(_hostname, other._hostname, sizeof(_hostname));
+
+    other._type = HOSTTYPE_UNINITIALIZED;
+    other._fs = nullptr;
+    other._hostname[0] = '\0';
+}
+
 /* Returns true if successful
 *  We expect a valid devicename, currently:
 *  "SD" = local
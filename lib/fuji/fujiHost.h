@@ -50,6 +50,9 @@ public:
 
     bool mount();
     bool umount();
+    bool mounted() { return _fs != nullptr && _fs->running(); };
+    // Take over the filesystem other has mounted, leaving other unmounted
+    void adopt(fujiHost &other);
 
     // Host prefixes are used for host file operations that take a path (file_exists, file_open, dir_open)
     void set_prefix(const char *prefix);
@@ -0,0 +1,413 @@
+#include "fujiHostCopy.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "compat_string.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+#include "../../include/debug.h"
+
+#include "fnSystem.h"
+#include "fnTaskManager.h"
+
+fujiHostCopy hostCopy;
+
+class fujiHostCopyTask : public fnTask
+{
+public:
+    virtual ~fujiHostCopyTask() override;
+    virtual int get_progress() override { return hostCopy.percent(); };
+
+protected:
+    virtual int start() override { return 0; };
+    virtual int abort() override;
+    virtual int step() override { return hostCopy.step(); };
+};
+
+fujiHostCopyTask::~fujiHostCopyTask()
+{
+    hostCopy._task = nullptr;
+}
+
+// Only taskMgr shutting down aborts the task, leave the copy resumable
+int fujiHostCopyTask::abort()
+{
+    if (hostCopy._state == fujiHostCopy::COPY_RUNNING || hostCopy._state == fujiHostCopy::COPY_PAUSED)
+        hostCopy.stop(fujiHostCopy::COPY_CANCELLED);
+    return 0;
+}
+
+bool fujiHostCopy::start(fujiHost *src, const char *src_path, fujiHost *dst, const char *dst_path)
+{
+    if (_state == COPY_RUNNING)
+    {
+        Debug_println("hostCopy: a copy is already running");
+        return false;
+    }
+
+    // a paused or stopped copy is dropped, its partial destination stays
+    close_files();
+
+    _src = src;
+    _dst = dst;
+    strlcpy(_src_path, src_path, sizeof(_src_path));
+    strlcpy(_dst_path, dst_path, sizeof(_dst_path));
+    _dst_fullpath[0] = '\0';
+    _copied = 0;
+    _last_rate = 0;
+    _request = REQ_NONE;
+
+    if (!open_files(false))
+    {
+        _state = COPY_FAILED;
+        return false;
+    }
+
+    if (_task == nullptr)
+    {
+        _task = new fujiHostCopyTask();
+        if (taskMgr.submit_task(_task) == 0)
+        {
+            delete _task;
+            stop(COPY_FAILED);
+            return false;
+        }
+    }
+
+    Debug_printf("hostCopy: \"%s\" -> \"%s\", %lu bytes\n", _src_path, _dst_path, (unsigned long)_total);
+    _state = COPY_RUNNING;
+    return true;
+}
+
+bool fujiHostCopy::wait()
+{
+    while (_state == COPY_RUNNING)
+        taskMgr.service();
+
+    return _state == COPY_DONE;
+}
+
+void fujiHostCopy::remove_destination()
+{
+    if (_state != COPY_FAILED && _state != COPY_CANCELLED)
+        return;
+
+    if (_dst != nullptr && _dst_fullpath[0] != '\0')
+        _dst->file_remove(_dst_fullpath);
+
+    // nothing left to resume, the task ends at its next step
+    _state = COPY_IDLE;
+}
+
+const char *fujiHostCopy::state_name()
+{
+    switch (_state)
+    {
+    case COPY_RUNNING:
+        return "copying";
+    case COPY_PAUSED:
+        return "paused";
+    case COPY_DONE:
+        return "done";
+    case COPY_FAILED:
+        return "failed";
+    case COPY_CANCELLED:
+        return "cancelled";
+    default:
+        return "idle";
+    }
+}
+
+int fujiHostCopy::percent()
+{
+    if (_state == COPY_DONE)
+        return 100;
+    if (_total == 0)
+        return -1;
+    return (int)((uint64_t)_copied * 100 / _total);
+}
+
+uint32_t fujiHostCopy::rate_kbs()
+{
+    if (_state != COPY_RUNNING)
+        return _last_rate;
+
+    uint64_t ms = fnSystem.millis() - _run_ms;
+    if (ms == 0)
+        return 0;
+    return (uint32_t)((uint64_t)(_copied - _run_start) * 1000 / 1024 / ms);
+}
+
+static void json_string(std::string &out, const char *s)
+{
+    out += '"';
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            out += '\\';
+        if ((unsigned char)*s >= ' ')
+            out += *s;
+    }
+    out += '"';
+}
+
+std::string fujiHostCopy::status_json()
+{
+    char nums[96];
+    std::string json = "{\"state\":\"";
+
+    json += state_name();
+    json += "\",\"source\":";
+    json_string(json, _src_path);
+    json += ",\"destination\":";
+    json_string(json, _dst_path);
+    snprintf(nums, sizeof(nums), ",\"copied\":%lu,\"total\":%lu,\"percent\":%d,\"rate\":%lu}",
+             (unsigned long)_copied, (unsigned long)_total, percent(), (unsigned long)rate_kbs());
+    json += nums;
+
+    return json;
+}
+
+bool fujiHostCopy::alloc_buffers()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (_buf[i] != nullptr)
+            continue;
+#ifdef ESP_PLATFORM
+        _buf[i] = (uint8_t *)heap_caps_malloc(HOSTCOPY_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+        if (_buf[i] == nullptr)
+            _buf[i] = (uint8_t *)malloc(HOSTCOPY_BUFFER_SIZE);
+#else
+        _buf[i] = (uint8_t *)malloc(HOSTCOPY_BUFFER_SIZE);
+#endif
+        if (_buf[i] == nullptr)
+        {
+            Debug_println("hostCopy: out of memory");
+            free_buffers();
+            return false;
+        }
+    }
+    return true;
+}
+
+void fujiHostCopy::free_buffers()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        free(_buf[i]);
+        _buf[i] = nullptr;
+    }
+}
+
+bool fujiHostCopy::open_files(bool resuming)
+{
+    char src_fullpath[MAX_COPY_PATHLEN];
+
+    if (!alloc_buffers())
+        return false;
+
+    // Mount hosts, if needed.
+    _src->mount();
+    _dst->mount();
+
+    _src_file = _src->fnfile_open(_src_path, src_fullpath, sizeof(src_fullpath), FILE_READ);
+    if (_src_file == nullptr)
+    {
+        Debug_printf("hostCopy: can't open source \"%s\"\n", _src_path);
+        free_buffers();
+        return false;
+    }
+
+    long size = _src->file_size(_src_file);
+    _total = size > 0 ? size : 0;
+
+    // a resumed copy writes over whatever followed the last good byte
+    _dst_file = _dst->fnfile_open(_dst_path, _dst_fullpath, sizeof(_dst_fullpath),
+                                  resuming ? FILE_READ_WRITE : FILE_WRITE);
+    if (_dst_file == nullptr)
+    {
+        Debug_printf("hostCopy: can't open destination \"%s\"\n", _dst_path);
+        close_files();
+        free_buffers();
+        return false;
+    }
+
+    if (resuming && (fnio::fseek(_src_file, _copied, SEEK_SET) != 0 ||
+                     fnio::fseek(_dst_file, _copied, SEEK_SET) != 0))
+    {
+        Debug_printf("hostCopy: can't resume at %lu\n", (unsigned long)_copied);
+        close_files();
+        free_buffers();
+        return false;
+    }
+
+    _read = _copied;
+    _fill = 0;
+    _fill_len = 0;
+    _drain_len = 0;
+    _drain_pos = 0;
+    _eof = false;
+    _run_start = _copied;
+    _run_ms = fnSystem.millis();
+    return true;
+}
+
+void fujiHostCopy::close_files()
+{
+    if (_src_file != nullptr)
+        fnio::fclose(_src_file);
+    if (_dst_file != nullptr)
+        fnio::fclose(_dst_file);
+    _src_file = nullptr;
+    _dst_file = nullptr;
+}
+
+void fujiHostCopy::stop(copy_state why)
+{
+    // data still in the buffers is read again on resume
+    _last_rate = rate_kbs();
+    close_files();
+    free_buffers();
+    _stopped_ms = fnSystem.millis();
+    _state = why;
+    Debug_printf("hostCopy: %s at %lu of %lu bytes\n", state_name(), (unsigned long)_copied, (unsigned long)_total);
+}
+
+int fujiHostCopy::step()
+{
+    copy_request req = _request;
+    if (req != REQ_NONE)
+        _request = REQ_NONE;
+
+    switch (req)
+    {
+    case REQ_CANCEL:
+        if (_state == COPY_RUNNING || _state == COPY_PAUSED)
+            stop(COPY_CANCELLED);
+        break;
+    case REQ_PAUSE:
+        if (_state == COPY_RUNNING)
+        {
+            _last_rate = rate_kbs();
+            _stopped_ms = fnSystem.millis();
+            _state = COPY_PAUSED;
+        }
+        break;
+    case REQ_RESUME:
+        if (_state == COPY_PAUSED)
+        {
+            _run_start = _copied;
+            _run_ms = fnSystem.millis();
+            _state = COPY_RUNNING;
+        }
+        else if (_state == COPY_FAILED || _state == COPY_CANCELLED)
+        {
+            if (open_files(true))
+                _state = COPY_RUNNING;
+            else
+                _state = COPY_FAILED;
+        }
+        break;
+    default:
+        break;
+    }
+
+    switch (_state)
+    {
+    case COPY_RUNNING:
+        break;
+    case COPY_IDLE:
+        return 1; // task is no longer needed
+    default:
+        // wait to be resumed or replaced, but not forever
+        if (fnSystem.millis() - _stopped_ms < HOSTCOPY_IDLE_TIMEOUT_MS)
+            return 0;
+        Debug_printf("hostCopy: dropped, %s for too long\n", state_name());
+        close_files();
+        free_buffers();
+        _state = COPY_IDLE;
+        return 1;
+    }
+
+    int result = pump();
+    if (result < 0)
+    {
+        stop(COPY_FAILED);
+        return 0;
+    }
+    if (result > 0)
+    {
+        _last_rate = rate_kbs();
+        close_files();
+        free_buffers();
+        _state = COPY_DONE;
+        Debug_printf("hostCopy: done, %lu bytes at %lu KB/s\n", (unsigned long)_copied, (unsigned long)_last_rate);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * One slice into the filling buffer, one slice out of the draining one.
+ * Returns 1 once everything is written, -1 on a read or write error.
+ */
+int fujiHostCopy::pump()
+{
+    if (!_eof && _fill_len < HOSTCOPY_BUFFER_SIZE)
+    {
+        size_t want = HOSTCOPY_BUFFER_SIZE - _fill_len;
+        if (want > HOSTCOPY_SLICE_SIZE)
+            want = HOSTCOPY_SLICE_SIZE;
+        if (_total != 0 && _total - _read < want)
+            want = _total - _read;
+
+        size_t n = want ? fnio::fread(_buf[_fill] + _fill_len, 1, want, _src_file) : 0;
+        _fill_len += n;
+        _read += n;
+
+        if (n < want || want == 0)
+        {
+            // Check if we got enough bytes on the read
+            if (_total != 0 && _read != _total)
+            {
+                Debug_printf("hostCopy: short read at %lu of %lu\n", (unsigned long)_read, (unsigned long)_total);
+                return -1;
+            }
+            _eof = true;
+        }
+    }
+
+    if (_drain_pos < _drain_len)
+    {
+        size_t n = _drain_len - _drain_pos;
+        if (n > HOSTCOPY_SLICE_SIZE)
+            n = HOSTCOPY_SLICE_SIZE;
+
+        size_t w = fnio::fwrite(_buf[_fill ^ 1] + _drain_pos, 1, n, _dst_file);
+        _drain_pos += w;
+        _copied = _copied + w;
+
+        // Check if we sent enough bytes on the write
+        if (w != n)
+        {
+            Debug_printf("hostCopy: short write at %lu\n", (unsigned long)_copied);
+            return -1;
+        }
+    }
+
+    // swap once the destination has caught up
+    if (_drain_pos == _drain_len && (_fill_len == HOSTCOPY_BUFFER_SIZE || (_eof && _fill_len != 0)))
+    {
+        _fill ^= 1;
+        _drain_len = _fill_len;
+        _drain_pos = 0;
+        _fill_len = 0;
+    }
+
+    return (_eof && _fill_len == 0 && _drain_pos == _drain_len) ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+#ifndef _FUJI_HOSTCOPY_
+#define _FUJI_HOSTCOPY_
+
+#include <stdint.h>
+#include <string>
+
+#include "fujiHost.h"
+#include "fnio.h"
+
+#define MAX_COPY_PATHLEN 256
+
+// Two of these: the destination is written from one while the other fills
+#define HOSTCOPY_BUFFER_SIZE 16384
+// Most that is read and written per task step, which keeps every step
+// short enough for the bus to be serviced in between
+#define HOSTCOPY_SLICE_SIZE 2048
+// A paused, cancelled or failed copy left this long without being resumed is
+// dropped, its partial destination stays, and its task ends
+#define HOSTCOPY_IDLE_TIMEOUT_MS (10 * 60 * 1000)
+
+class fujiHostCopyTask;
+
+/*
+ * Host to host file copy, run as a task under taskMgr so the main loop keeps
+ * servicing the bus while it goes. Only one copy exists at a time. A copy
+ * that is cancelled or fails keeps its partial destination and position, and
+ * resume() carries on from there, until HOSTCOPY_IDLE_TIMEOUT_MS passes.
+ * Cancel, pause and resume only post a request which the next task step acts
+ * on, so the web server task may call them too.
+ *
+ * taskMgr is serviced from the main loop whatever the bus, but only the SIO
+ * fuji device and the web UI start and control copies so far. COPY FILE on
+ * the other buses still copies inline, in their own handlers.
+ */
+class fujiHostCopy
+{
+public:
+    enum copy_state : uint8_t
+    {
+        COPY_IDLE = 0,
+        COPY_RUNNING,
+        COPY_PAUSED,
+        COPY_DONE,
+        COPY_FAILED,
+        COPY_CANCELLED
+    };
+
+    // Call from the main loop only. Fails if a copy is running or the files can't be opened.
+    bool start(fujiHost *src, const char *src_path, fujiHost *dst, const char *dst_path);
+    // Step the copy on the caller's thread until it stops, true if it completed
+    bool wait();
+    // Remove what a stopped copy has written so far
+    void remove_destination();
+
+    void cancel() { _request = REQ_CANCEL; };
+    void pause() { _request = REQ_PAUSE; };
+    void resume() { _request = REQ_RESUME; };
+
+    copy_state state() { return _state; };
+    const char *state_name();
+    uint32_t copied() { return _copied; };
+    uint32_t total() { return _total; };
+    int percent();
+    uint32_t rate_kbs();
+    const char *source() { return _src_path; };
+    const char *destination() { return _dst_path; };
+    // For the web UI
+    std::string status_json();
+
+private:
+    enum copy_request : uint8_t
+    {
+        REQ_NONE = 0,
+        REQ_CANCEL,
+        REQ_PAUSE,
+        REQ_RESUME
+    };
+
+    friend class fujiHostCopyTask;
+
+    fujiHostCopyTask *_task = nullptr;
+    volatile copy_state _state = COPY_IDLE;
+    volatile copy_request _request = REQ_NONE;
+
+    fujiHost *_src = nullptr;
+    fujiHost *_dst = nullptr;
+    char _src_path[MAX_COPY_PATHLEN] = { '\0' };
+    char _dst_path[MAX_COPY_PATHLEN] = { '\0' };
+    char _dst_fullpath[MAX_COPY_PATHLEN] = { '\0' };
+    fnFile *_src_file = nullptr;
+    fnFile *_dst_file = nullptr;
+
+    volatile uint32_t _copied = 0; // bytes written to the destination
+    volatile uint32_t _total = 0;  // source size, 0 if unknown
+    uint32_t _read = 0;            // bytes read from the source
+    uint32_t _run_start = 0;       // _copied when the current run began
+    uint64_t _run_ms = 0;          // fnSystem.millis() when the current run began
+    uint32_t _last_rate = 0;       // rate of the last run, once stopped
+    uint64_t _stopped_ms = 0;      // fnSystem.millis() when it was last paused or stopped
+
+    uint8_t *_buf[2] = { nullptr, nullptr };
+    int _fill = 0;                 // buffer being read into, the other one drains
+    size_t _fill_len = 0;
+    size_t _drain_len = 0;
+    size_t _drain_pos = 0;
+    bool _eof = false;
+
+    bool open_files(bool resuming);
+    void close_files();
+    bool alloc_buffers();
+    void free_buffers();
+    void stop(copy_state why);
+    int step();
+    int pump();
+};
+
+extern fujiHostCopy hostCopy;
+
+#endif // _FUJI_HOSTCOPY_
@@ -0,0 +1,139 @@
+#include "fujiHostHash.h"
+
+#include <cstdlib>
+
+#include "../../include/debug.h"
+
+#include "fnTaskManager.h"
+
+fujiHostHash hostHash;
+
+class fujiHostHashTask : public fnTask
+{
+public:
+    virtual ~fujiHostHashTask() override;
+    virtual int get_progress() override { return hostHash.percent(); };
+
+protected:
+    virtual int start() override { return 0; };
+    virtual int abort() override;
+    virtual int step() override { return hostHash.step(); };
+};
+
+fujiHostHashTask::~fujiHostHashTask()
+{
+    hostHash._task = nullptr;
+}
+
+int fujiHostHashTask::abort()
+{
+    if (hostHash._state == fujiHostHash::HASH_RUNNING)
+        hostHash.stop(fujiHostHash::HASH_CANCELLED);
+    return 0;
+}
+
+bool fujiHostHash::start(fujiHost *host, const char *path, Hash::Algorithm algorithm)
+{
+    char fullpath[MAX_PATHLEN];
+
+    if (_state == HASH_RUNNING)
+    {
+        Debug_println("hostHash: a file is already being hashed");
+        return false;
+    }
+
+    _hashed = 0;
+    _total = 0;
+    _cancel = false;
+
+    if (!host->mount())
+    {
+        Debug_println("hostHash: can't mount host");
+        _state = HASH_FAILED;
+        return false;
+    }
+
+    _file = host->fnfile_open(path, fullpath, sizeof(fullpath), FILE_READ);
+    if (_file == nullptr)
+    {
+        Debug_printf("hostHash: can't open \"%s\"\n", path);
+        _state = HASH_FAILED;
+        return false;
+    }
+
+    _buf = (uint8_t *)malloc(HOSTHASH_SLICE_SIZE);
+    if (_buf == nullptr)
+    {
+        Debug_println("hostHash: out of memory");
+        stop(HASH_FAILED);
+        return false;
+    }
+
+    if (_task == nullptr)
+    {
+        _task = new fujiHostHashTask();
+        if (taskMgr.submit_task(_task) == 0)
+        {
+            delete _task;
+            stop(HASH_FAILED);
+            return false;
+        }
+    }
+
+    long size = host->file_size(_file);
+    _total = size > 0 ? size : 0;
+    hasher.select(algorithm);
+
+    Debug_printf("hostHash: \"%s\", %lu bytes\n", fullpath, (unsigned long)_total);
+    _state = HASH_RUNNING;
+    return true;
+}
+
+int fujiHostHash::percent()
+{
+    if (_state == HASH_DONE)
+        return 100;
+    if (_total == 0)
+        return -1;
+    return (int)((uint64_t)_hashed * 100 / _total);
+}
+
+void fujiHostHash::stop(hash_state why)
+{
+    if (_file != nullptr)
+        fnio::fclose(_file);
+    _file = nullptr;
+    free(_buf);
+    _buf = nullptr;
+    _state = why;
+    Debug_printf("hostHash: stopped (%d) at %lu of %lu bytes\n", why, (unsigned long)_hashed, (unsigned long)_total);
+}
+
+int fujiHostHash::step()
+{
+    if (_state != HASH_RUNNING)
+        return 1; // task is no longer needed
+
+    if (_cancel)
+    {
+        stop(HASH_CANCELLED);
+        return 1;
+    }
+
+    size_t n = fnio::fread(_buf, 1, HOSTHASH_SLICE_SIZE, _file);
+    hasher.add_data(_buf, n);
+    _hashed = _hashed + n;
+
+    if (n < HOSTHASH_SLICE_SIZE)
+    {
+        if (_total != 0 && _hashed != _total)
+        {
+            Debug_printf("hostHash: short read at %lu of %lu\n", (unsigned long)_hashed, (unsigned long)_total);
+            stop(HASH_FAILED);
+            return 1;
+        }
+        stop(HASH_DONE);
+        return 1;
+    }
+    return 0;
+}
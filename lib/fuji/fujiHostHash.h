@@ -0,0 +1,63 @@
+#ifndef _FUJI_HOSTHASH_
+#define _FUJI_HOSTHASH_
+
+#include <stdint.h>
+
+#include "fujiHost.h"
+#include "fnio.h"
+#include "hash.h"
+
+// Most that is read and hashed per task step, which keeps every step
+// short enough for the bus to be serviced in between
+#define HOSTHASH_SLICE_SIZE 4096
+
+class fujiHostHashTask;
+
+/*
+ * Feeds a file on a host to the global hasher, as if it had been sent with
+ * HASH INPUT, run as a task under taskMgr so the main loop keeps servicing
+ * the bus while it goes. Only the requested algorithm is run. Only one file
+ * is hashed at a time.
+ */
+class fujiHostHash
+{
+public:
+    enum hash_state : uint8_t
+    {
+        HASH_IDLE = 0,
+        HASH_RUNNING,
+        HASH_DONE,
+        HASH_FAILED,
+        HASH_CANCELLED
+    };
+
+    // Call from the main loop only. Fails if the host can't be mounted or the file opened.
+    bool start(fujiHost *host, const char *path, Hash::Algorithm algorithm);
+    // Takes effect at the next task step
+    void cancel() { _cancel = true; };
+
+    hash_state state() { return _state; };
+    bool busy() { return _state == HASH_RUNNING; };
+    uint32_t hashed() { return _hashed; };
+    uint32_t total() { return _total; };
+    int percent();
+
+private:
+    friend class fujiHostHashTask;
+
+    fujiHostHashTask *_task = nullptr;
+    volatile hash_state _state = HASH_IDLE;
+    volatile bool _cancel = false;
+
+    fnFile *_file = nullptr;
+    uint8_t *_buf = nullptr;
+    volatile uint32_t _hashed = 0;
+    volatile uint32_t _total = 0; // file size, 0 if unknown
+
+    void stop(hash_state why);
+    int step();
+};
+
+extern fujiHostHash hostHash;
+
+#endif // _FUJI_HOSTHASH_
@@ -0,0 +1,303 @@
+
+#include "fujiMountAll.h"
+
+#include <string.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+#include "compat_string.h"
+#include "fnSystem.h"
+#include "fnio.h"
+
+#include "../../include/debug.h"
+
+// how often the main loop looks to see whether the workers are done
+#define MOUNTALL_POLL_MS 10
+
+// A host slot to mount, on the worker's own fujiHost
+struct mount_host
+{
+    int host_slot;
+    fujiHost host;
+};
+
+// A disk slot to open once its host is mounted
+struct mount_disk
+{
+    int slot;
+    mount_host *host;
+    char filename[MAX_FILENAME_LEN];
+    const char *mode;
+    fnFile *fileh = nullptr;
+    long size = 0;
+    fujiMountResult result = MOUNT_TIMED_OUT;
+    uint32_t ms = 0;
+};
+
+// Everything on one server, done in turn by one worker. Shared between the
+// worker and run(), whichever lets go of it last frees it.
+struct mount_job
+{
+    std::vector<std::unique_ptr<mount_host>> hosts;
+    std::vector<mount_disk> disks;
+    uint64_t start = 0;
+
+    std::mutex lock;
+    bool done = false;      // the worker has let go of everything above
+    bool abandoned = false; // run() gave up waiting
+};
+
+
+// Returns nullptr if the image didn't open
+static fnFile *open_image(fujiHost &host, char *filename, int filename_len, const char *mode, long *size)
+{
+    Debug_printf("fujiMountAll opening '%s' from \"%s\" as %s\n", filename, host.get_hostname(), mode);
+
+    fnFile *fileh = host.fnfile_open(filename, filename, filename_len, mode);
+    if (fileh != nullptr)
+        *size = host.file_size(fileh);
+    return fileh;
+}
+
+static void mount_job_run(std::shared_ptr<mount_job> job)
+{
+    for (auto &mh : job->hosts)
+    {
+        bool mounted = mh->host.mount();
+        if (!mounted)
+            Debug_printf("fujiMountAll host #%d \"%s\" failed to mount\n", mh->host_slot, mh->host.get_hostname());
+
+        for (auto &md : job->disks)
+        {
+            if (md.host != mh.get())
+                continue;
+
+            if (!mounted)
+                md.result = MOUNT_HOST_FAILED;
+            else if ((md.fileh = open_image(mh->host, md.filename, sizeof(md.filename), md.mode, &md.size)) == nullptr)
+                md.result = MOUNT_OPEN_FAILED;
+            else
+                md.result = MOUNT_OK;
+            md.ms = fnSystem.millis() - job->start;
+        }
+    }
+
+    bool abandoned;
+    {
+        std::lock_guard<std::mutex> guard(job->lock);
+        job->done = true;
+        abandoned = job->abandoned;
+    }
+
+    // too late, nobody is going to use these
+    if (abandoned)
+    {
+        Debug_printf("fujiMountAll \"%s\" finished after the deadline, closing it\n", job->hosts[0]->host.get_hostname());
+        for (auto &md : job->disks)
+            if (md.fileh != nullptr)
+                fnio::fclose(md.fileh);
+    }
+}
+
+#ifdef ESP_PLATFORM
+static void mount_job_task(void *param)
+{
+    std::shared_ptr<mount_job> *job = (std::shared_ptr<mount_job> *)param;
+    mount_job_run(*job);
+    delete job;
+    vTaskDelete(nullptr);
+}
+#endif
+
+static void mount_job_start(std::shared_ptr<mount_job> job)
+{
+#ifdef ESP_PLATFORM
+    std::shared_ptr<mount_job> *param = new std::shared_ptr<mount_job>(job);
+    if (xTaskCreate(mount_job_task, "fnMountAll", MOUNTALL_STACK_SIZE, param, MOUNTALL_PRIORITY, nullptr) != pdPASS)
+    {
+        Debug_println("fujiMountAll couldn't start a worker, mounting here");
+        delete param;
+        mount_job_run(job);
+    }
+#else
+    std::thread(mount_job_run, job).detach();
+#endif
+}
+
+bool fujiMountAll::run(fujiHost *hosts, int host_count, fujiDisk *disks, int count,
+                       const char *read_mode, const char *write_mode,
+                       uint32_t slot_mask, uint32_t deadline_ms)
+{
+    uint64_t start = fnSystem.millis();
+
+    _count = count < MOUNTALL_MAX_SLOTS ? count : MOUNTALL_MAX_SLOTS;
+    for (int i = 0; i < MOUNTALL_MAX_SLOTS; i++)
+        _report[i] = fujiMountReport();
+
+    std::vector<std::shared_ptr<mount_job>> jobs;
+    std::vector<int> mounted_slots;
+
+    for (int i = 0; i < _count; i++)
+    {
+        fujiDisk &disk = disks[i];
+        if ((slot_mask & (1 << i)) == 0 || disk.host_slot == INVALID_HOST_SLOT ||
+            disk.host_slot >= host_count || disk.filename[0] == '\0')
+            continue;
+
+        fujiHost &host = hosts[disk.host_slot];
+
+        // the main loop opens these itself while the workers go
+        if (host.mounted())
+        {
+            mounted_slots.push_back(i);
+            continue;
+        }
+
+        // one job per server
+        std::shared_ptr<mount_job> job;
+        for (auto &j : jobs)
+            if (strcasecmp(j->hosts[0]->host.get_hostname(), host.get_hostname()) == 0)
+                job = j;
+        if (job == nullptr)
+        {
+            job = std::make_shared<mount_job>();
+            job->start = start;
+            jobs.push_back(job);
+        }
+
+        // one mount per host slot
+        mount_host *mh = nullptr;
+        for (auto &h : job->hosts)
+            if (h->host_slot == disk.host_slot)
+                mh = h.get();
+        if (mh == nullptr)
+        {
+            job->hosts.push_back(std::unique_ptr<mount_host>(new mount_host));
+            mh = job->hosts.back().get();
+            mh->host_slot = disk.host_slot;
+            mh->host.slotid = host.slotid;
+            mh->host.set_hostname(host.get_hostname());
+            mh->host.set_prefix(host.get_prefix());
+        }
+
+        mount_disk md;
+        md.slot = i;
+        md.host = mh;
+        md.mode = disk.access_mode == DISK_ACCESS_MODE_WRITE ? write_mode : read_mode;
+        strlcpy(md.filename, disk.filename, sizeof(md.filename));
+        job->disks.push_back(md);
+    }
+
+    Debug_printf("fujiMountAll %u servers to mount, %u slots on hosts already mounted\n", jobs.size(), mounted_slots.size());
+
+    for (auto &job : jobs)
+        mount_job_start(job);
+
+    for (int i : mounted_slots)
+    {
+        fujiDisk &disk = disks[i];
+        fujiHost &host = hosts[disk.host_slot];
+        long size = 0;
+        const char *mode = disk.access_mode == DISK_ACCESS_MODE_WRITE ? write_mode : read_mode;
+
+        disk.fileh = open_image(host, disk.filename, sizeof(disk.filename), mode, &size);
+        _report[i].result = disk.fileh != nullptr ? MOUNT_OK : MOUNT_OPEN_FAILED;
+        _report[i].ms = fnSystem.millis() - start;
+        if (disk.fileh != nullptr)
+        {
+            disk.disk_size = size;
+            disk.host = &host;
+        }
+    }
+
+    // wait for the slowest
+    while (fnSystem.millis() - start < deadline_ms)
+    {
+        bool all_done = true;
+        for (auto &job : jobs)
+        {
+            std::lock_guard<std::mutex> guard(job->lock);
+            all_done = all_done && job->done;
+        }
+        if (all_done)
+            break;
+        fnSystem.delay(MOUNTALL_POLL_MS);
+    }
+
+    for (auto &job : jobs)
+    {
+        bool done;
+        {
+            std::lock_guard<std::mutex> guard(job->lock);
+            done = job->done;
+            job->abandoned = !done;
+        }
+
+        if (!done)
+        {
+            for (auto &md : job->disks)
+            {
+                _report[md.slot].result = MOUNT_TIMED_OUT;
+                _report[md.slot].ms = deadline_ms;
+            }
+            continue;
+        }
+
+        for (auto &mh : job->hosts)
+            if (mh->host.mounted())
+                hosts[mh->host_slot].adopt(mh->host);
+
+        for (auto &md : job->disks)
+        {
+            _report[md.slot].result = md.result;
+            _report[md.slot].ms = md.ms;
+            if (md.result != MOUNT_OK)
+                continue;
+
+            fujiDisk &disk = disks[md.slot];
+            disk.fileh = md.fileh;
+            disk.disk_size = md.size;
+            disk.host = &hosts[md.host->host_slot];
+            strlcpy(disk.filename, md.filename, sizeof(disk.filename));
+        }
+    }
+
+    bool error = false;
+    for (int i = 0; i < _count; i++)
+    {
+        if (_report[i].result == MOUNT_EMPTY)
+            continue;
+        Debug_printf("fujiMountAll slot %d: %s after %u ms\n", i + 1, result_name(_report[i].result), (unsigned)_report[i].ms);
+        if (_report[i].result != MOUNT_OK)
+            error = true;
+    }
+    Debug_printf("fujiMountAll done in %u ms\n", (unsigned)(fnSystem.millis() - start));
+
+    return error;
+}
+
+const char *fujiMountAll::result_name(fujiMountResult result)
+{
+    switch (result)
+    {
+    case MOUNT_EMPTY:
+        return "empty";
+    case MOUNT_OK:
+        return "mounted";
+    case MOUNT_HOST_FAILED:
+        return "host failed";
+    case MOUNT_OPEN_FAILED:
+        return "open failed";
+    case MOUNT_TIMED_OUT:
+        return "timed out";
+    }
+    return "?";
+}
@@ -0,0 +1,66 @@
+#ifndef _FUJI_MOUNTALL_
+#define _FUJI_MOUNTALL_
+
+#include <stdint.h>
+
+#include "fujiHost.h"
+#include "fujiDisk.h"
+
+#define MOUNTALL_MAX_SLOTS 16
+// Longest mount_all waits for the slowest host before giving up on it
+#define MOUNTALL_DEADLINE_MS 15000
+// Each worker does a host's DNS lookup, session setup and opens
+#define MOUNTALL_STACK_SIZE 8192
+#define MOUNTALL_PRIORITY 5
+
+enum fujiMountResult : uint8_t
+{
+    MOUNT_EMPTY = 0,    // nothing in the slot, or not asked for
+    MOUNT_OK,
+    MOUNT_HOST_FAILED,  // host would not mount
+    MOUNT_OPEN_FAILED,  // host mounted but the image would not open
+    MOUNT_TIMED_OUT     // host took longer than the deadline
+};
+
+struct fujiMountReport
+{
+    fujiMountResult result = MOUNT_EMPTY;
+    uint32_t ms = 0;    // from the start until the slot's image was open
+};
+
+/*
+ * mount_all for every platform: mounts all the hosts the disk slots use at
+ * once, each on a worker of its own, and opens their images, so booting is
+ * as slow as the slowest host rather than all of them one after another.
+ *
+ * Hosts which aren't mounted yet are mounted on a fujiHost belonging to the
+ * worker, and adopted by the host slot once the worker is done. A worker
+ * still going at the deadline is left to finish on its own and then close
+ * what it opened, so it never touches anything the main loop uses. Slots on
+ * the same host share one mount, and slots naming the same server are mounted
+ * by one worker in turn rather than asking it for two sessions at once.
+ *
+ * run() leaves fileh, disk_size, filename (with the host prefix) and host set
+ * on the slots which opened; mounting the image on the disk device is left to
+ * the platform.
+ */
+class fujiMountAll
+{
+private:
+    fujiMountReport _report[MOUNTALL_MAX_SLOTS];
+    int _count = 0;
+
+public:
+    // Mounts the hosts of disks[0 .. count) and opens their images with
+    // read_mode, or write_mode for slots mounted for writing. Only the slots
+    // set in slot_mask are looked at.
+    // Returns TRUE if an error condition occurred in any of them
+    bool run(fujiHost *hosts, int host_count, fujiDisk *disks, int count,
+             const char *read_mode, const char *write_mode,
+             uint32_t slot_mask = 0xFFFF, uint32_t deadline_ms = MOUNTALL_DEADLINE_MS);
+
+    fujiMountReport *report(int slot) { return (slot >= 0 && slot < _count) ? &_report[slot] : nullptr; };
+    const char *result_name(fujiMountResult result);
+};
+
+#endif // _FUJI_MOUNTALL_
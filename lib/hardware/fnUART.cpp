@@ -226,6 +226,21 @@ int UARTManager::read(void)
         return byte;
 }
 
+/* Returns a single byte from the incoming stream, blocking the task for up
+ * to timeout_ms until one arrives. A timeout is expected here, not logged
+ */
+int UARTManager::read_timeout(uint32_t timeout_ms)
+{
+    uint8_t byte;
+    TickType_t ticks = pdMS_TO_TICKS(timeout_ms);
+    // at least a tick, or a short wait doesn't wait at all
+    if (ticks == 0 && timeout_ms > 0)
+        ticks = 1;
+    if (uart_read_bytes(_uart_num, &byte, 1, ticks) < 1)
+        return -1;
+    return byte;
+}
+
 /* Since the underlying Stream calls this Read() multiple times to get more than one
  *  character for ReadBytes(), we override with a single call to uart_read_bytes
  */
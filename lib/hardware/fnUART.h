@@ -71,6 +71,8 @@ public:
     void flush_input();
 
     int read();
+    // Waits up to timeout_ms for a byte, -1 if none came
+    int read_timeout(uint32_t timeout_ms);
     size_t readBytes(uint8_t *buffer, size_t length);
     size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); };
 
@@ -22,6 +22,9 @@
 #include "httpServiceConfigurator.h"
 #include "httpServiceParser.h"
 #include "fuji.h"
+#ifdef BUILD_ATARI
+#include "fujiHostCopy.h"
+#endif
 
 using namespace std;
 
@@ -441,12 +444,6 @@ esp_err_t fnHttpService::get_handler_print(httpd_req_t *req)
         Debug_println("No virtual printer");
         return ESP_FAIL;
     }
-    if (now - printer->lastPrintTime() < PRINTER_BUSY_TIME)
-    {
-        fnHTTPD.addToErrMsg("Printer is busy. Try again later.\n");
-        send_file(req, "error_page.html");
-        return ESP_OK;
-    }
     // Get printer emulator pointer from sioP (which is now extern)
     printer_emu *currentPrinter = printer->getPrinterPtr();
 
@@ -457,6 +454,13 @@ esp_err_t fnHttpService::get_handler_print(httpd_req_t *req)
         return_http_error(req, err);
         return ESP_FAIL;
     }
+    // A busy printer can only be followed live if its output is spooled in RAM
+    if (now - printer->lastPrintTime() < PRINTER_BUSY_TIME && !currentPrinter->isOutputStreamable())
+    {
+        fnHTTPD.addToErrMsg("Printer is busy. Try again later.\n");
+        send_file(req, "error_page.html");
+        return ESP_OK;
+    }
 
     // Build a print output name
     const char *exts;
@@ -499,15 +503,6 @@ esp_err_t fnHttpService::get_handler_print(httpd_req_t *req)
     string filename = "printout.";
     filename += exts;
 
-    // Tell printer to finish its output and get a read handle to the file
-    FILE *poutput = currentPrinter->closeOutputAndProvideReadHandle();
-    if (poutput == nullptr)
-    {
-        fnHTTPD.addToErrMsg("Unable to open printer output.\n");
-        send_file(req, "error_page.html");
-        return ESP_OK;
-    }
-
     // Set the expected content type based on the filename/extension
     set_file_content_type(req, filename.c_str());
 
@@ -520,10 +515,50 @@ esp_err_t fnHttpService::get_handler_print(httpd_req_t *req)
     }
     // NOTE: Don't set the Content-Length, as it's invalid when using CHUNKED
 
-    // Finally, write the data
-    // Send the file content out in chunks
     char *buf = (char *)malloc(FNWS_SEND_BUFF_SIZE);
+    if (buf == nullptr)
+    {
+        Debug_println("Couldn't allocate print buffer");
+        return_http_error(req, fnwserr_memory);
+        return ESP_FAIL;
+    }
     size_t count = 0, total = 0;
+
+    // While the printer is still busy, pass its output on as it arrives
+    while (true)
+    {
+        uint64_t idle = fnSystem.millis() - printer->lastPrintTime();
+        if (idle >= PRINTER_BUSY_TIME)
+            break;
+
+        count = currentPrinter->readOutput(total, (uint8_t *)buf, FNWS_SEND_BUFF_SIZE);
+        if (count == 0)
+        {
+            // Sleep until the spool grows, or until the printer would count as idle
+            currentPrinter->waitOutput(total, PRINTER_BUSY_TIME - idle);
+            continue;
+        }
+        if (httpd_resp_send_chunk(req, buf, count) != ESP_OK)
+        {
+            Debug_println("Print stream closed by client");
+            free(buf);
+            return ESP_FAIL;
+        }
+        total += count;
+    }
+
+    // Tell printer to finish its output and get a read handle to the file
+    FILE *poutput = currentPrinter->closeOutputAndProvideReadHandle();
+    if (poutput == nullptr)
+    {
+        Debug_println("Unable to open printer output");
+        free(buf);
+        httpd_resp_send_chunk(req, nullptr, 0);
+        return ESP_OK;
+    }
+
+    // Send whatever hasn't been streamed yet (all of it, unless we were following along)
+    fseek(poutput, total, SEEK_SET);
     do
     {
         count = fread((uint8_t *)buf, 1, FNWS_SEND_BUFF_SIZE, poutput);
@@ -876,6 +911,28 @@ esp_err_t fnHttpService::get_handler_kybd(httpd_req_t *req)
 }
 #endif /* BUILD_ADAM */
 
+#ifdef BUILD_ATARI
+// Host to host copy progress as JSON, "action" cancels, pauses or resumes it
+esp_err_t fnHttpService::get_handler_copy(httpd_req_t *req)
+{
+    queryparts qp;
+    parse_query(req, &qp);
+
+    string action = qp.query_parsed["action"];
+    if (action == "cancel")
+        hostCopy.cancel();
+    else if (action == "pause")
+        hostCopy.pause();
+    else if (action == "resume")
+        hostCopy.resume();
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, hostCopy.status_json().c_str());
+
+    return ESP_OK;
+}
+#endif
+
 esp_err_t fnHttpService::get_handler_dir(httpd_req_t *req)
 {
     queryparts qp;
@@ -1411,6 +1468,15 @@ httpd_handle_t fnHttpService::start_server(serverstate &state)
          .is_websocket = false,
          .handle_ws_control_frames = false,
          .supported_subprotocol = nullptr},
+#ifdef BUILD_ATARI
+        {.uri = "/copy",
+         .method = HTTP_GET,
+         .handler = get_handler_copy,
+         .user_ctx = NULL,
+         .is_websocket = false,
+         .handle_ws_control_frames = false,
+         .supported_subprotocol = nullptr},
+#endif
 #ifdef BUILD_ADAM
         {.uri = "/term",
          .method = HTTP_GET,
@@ -59,6 +59,7 @@ If a file has an extention pre-determined to support parsing (see/update
 #define MSG_ERR_RECEIVE_FAILURE  "Failed to receive posted data"
 
 #define PRINTER_BUSY_TIME 2000 // milliseconds to wait until printer is done
+#define PRINTER_STREAM_BACKLOG (4 * FNWS_SEND_BUFF_SIZE) // unsent bytes before a live print stream waits for the client
 
 class fnHttpService 
 {
@@ -106,6 +107,7 @@ class fnHttpService
 // !ESP_PLATFORM
     static struct mg_mgr * start_server(serverstate &state);
     static void cb(struct mg_connection *c, int ev, void *ev_data);
+    static void print_stream_poll(struct mg_connection *c);
     static void return_http_error(struct mg_connection *c, _fnwserr errnum);
     static const char * find_mimetype_str(const char *extension);
     static const char * get_extension(const char *filename);
@@ -136,6 +138,9 @@ public:
     static esp_err_t get_handler_modem_sniffer(httpd_req_t *req);
     static esp_err_t get_handler_mount(httpd_req_t *req);
     static esp_err_t get_handler_eject(httpd_req_t *req);
+#ifdef BUILD_ATARI
+    static esp_err_t get_handler_copy(httpd_req_t *req);
+#endif
     static esp_err_t get_handler_dir(httpd_req_t *req);
     static esp_err_t get_handler_slot(httpd_req_t *req);
 
@@ -152,6 +157,9 @@ public:
     static int get_handler_swap(struct mg_connection *c, struct mg_http_message *hm);
     static int get_handler_mount(struct mg_connection *c, struct mg_http_message *hm);
     static int get_handler_eject(mg_connection *c, mg_http_message *hm);
+#ifdef BUILD_ATARI
+    static int get_handler_copy(mg_connection *c, mg_http_message *hm);
+#endif
 
     static int post_handler_config(struct mg_connection *c, struct mg_http_message *hm);
 
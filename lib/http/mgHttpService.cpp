@@ -16,6 +16,9 @@
 #include "modem.h"
 #include "printer.h"
 #include "fuji.h"
+#ifdef BUILD_ATARI
+#include "fujiHostCopy.h"
+#endif
 
 #include "httpService.h"
 #include "httpServiceConfigurator.h"
@@ -239,6 +242,15 @@ int fnHttpService::redirect_or_result(mg_connection *c, mg_http_message *hm, int
     return result;
 }
 
+// Live print stream, kept at the start of the connection's data area
+// (mongoose keeps its static file length at the end)
+struct print_stream
+{
+    bool active;
+    size_t sent;
+};
+static_assert(sizeof(print_stream) <= MG_DATA_SIZE - sizeof(size_t), "print_stream doesn't fit in mg_connection::data");
+
 int fnHttpService::get_handler_print(struct mg_connection *c)
 {
     Debug_println("Print request handler");
@@ -246,15 +258,17 @@ int fnHttpService::get_handler_print(struct mg_connection *c)
     uint64_t now = fnSystem.millis();
     // Get a pointer to the current (only) printer
     PRINTER_CLASS *printer = (PRINTER_CLASS *)fnPrinters.get_ptr(0);
+    // Get printer emulator pointer from sioP (which is now extern)
+    printer_emu *currentPrinter = printer->getPrinterPtr();
 
-    if (now - printer->lastPrintTime() < PRINTER_BUSY_TIME)
+    // A busy printer can only be followed live if its output is spooled in RAM
+    bool busy = now - printer->lastPrintTime() < PRINTER_BUSY_TIME;
+    if (busy && !currentPrinter->isOutputStreamable())
     {
         _fnwserr err = fnwserr_post_fail;
         return_http_error(c, err);
         return -1; //ESP_FAIL;
     }
-    // Get printer emulator pointer from sioP (which is now extern)
-    printer_emu *currentPrinter = printer->getPrinterPtr();
 
     // Build a print output name
     const char *exts;
@@ -297,6 +311,21 @@ int fnHttpService::get_handler_print(struct mg_connection *c)
     string filename = "printout.";
     filename += exts;
 
+    if (busy)
+    {
+        // Send the headers now and the output from print_stream_poll() as it arrives
+        mg_printf(c, "HTTP/1.1 200 OK\r\n");
+        set_file_content_type(c, filename.c_str());
+        if (sendAsAttachment)
+            mg_printf(c, "Content-Disposition: attachment; filename=\"%s\"\r\n", filename.c_str());
+        mg_printf(c, "Transfer-Encoding: chunked\r\n\r\n");
+
+        print_stream *ps = (print_stream *)c->data;
+        ps->active = true;
+        ps->sent = 0;
+        return 0;
+    }
+
     // Tell printer to finish its output and get a read handle to the file
     FILE *poutput = currentPrinter->closeOutputAndProvideReadHandle();
     if (poutput == nullptr)
@@ -320,7 +349,7 @@ int fnHttpService::get_handler_print(struct mg_connection *c)
 
     // Finally, write the data
     // Send the file content out in chunks
-    char *buf = (char *)malloc(FNWS_SEND_BUFF_SIZE);
+    char buf[FNWS_SEND_BUFF_SIZE];
     size_t count = 0, total = 0;
     do
     {
@@ -335,7 +364,6 @@ int fnHttpService::get_handler_print(struct mg_connection *c)
 
     Debug_printf("Sent %u bytes total from print file\n", (unsigned)total);
 
-    free(buf);
     fclose(poutput);
 
     // Tell the printer it can start writing from the beginning
@@ -346,6 +374,61 @@ int fnHttpService::get_handler_print(struct mg_connection *c)
     return 0; //ESP_OK;
 }
 
+/* Pass on new printer output to a client following a print job. The printer
+   runs in the same loop as the web server, so this only ever sends what's
+   already there. Once the printer goes idle, close its output and send the rest.
+*/
+void fnHttpService::print_stream_poll(struct mg_connection *c)
+{
+    print_stream *ps = (print_stream *)c->data;
+    if (!ps->active || c->send.len > PRINTER_STREAM_BACKLOG)
+        return;
+
+    PRINTER_CLASS *printer = (PRINTER_CLASS *)fnPrinters.get_ptr(0);
+    printer_emu *currentPrinter = printer->getPrinterPtr();
+    char buf[FNWS_SEND_BUFF_SIZE];
+    size_t count;
+
+    // Output that spilled over to the file can only be sent once the printer is done
+    if (fnSystem.millis() - printer->lastPrintTime() < PRINTER_BUSY_TIME)
+    {
+        count = currentPrinter->readOutput(ps->sent, (uint8_t *)buf, sizeof(buf));
+        if (count > 0)
+        {
+            mg_http_write_chunk(c, buf, count);
+            ps->sent += count;
+        }
+        return;
+    }
+
+    ps->active = false;
+    FILE *poutput = currentPrinter->closeOutputAndProvideReadHandle();
+    if (poutput == nullptr)
+    {
+        Debug_printf("Unable to open printer output\n");
+        mg_http_write_chunk(c, "", 0);
+        return;
+    }
+
+    // Send whatever hasn't been streamed yet
+    fseek(poutput, ps->sent, SEEK_SET);
+    while ((count = fread((uint8_t *)buf, 1, sizeof(buf), poutput)) > 0)
+    {
+        mg_http_write_chunk(c, buf, count);
+        ps->sent += count;
+    }
+    mg_http_write_chunk(c, "", 0);
+
+    Debug_printf("Sent %u bytes total from print file\n", (unsigned)ps->sent);
+
+    fclose(poutput);
+
+    // Tell the printer it can start writing from the beginning
+    printer->reset_printer(); // destroy,create new printer emulator object of previous type.
+
+    Debug_println("Print request completed");
+}
+
 int fnHttpService::post_handler_config(struct mg_connection *c, struct mg_http_message *hm)
 {
 
@@ -420,6 +503,25 @@ int fnHttpService::get_handler_mount(mg_connection *c, mg_http_message *hm)
     return redirect_or_result(c, hm, 0);
 }
 
+#ifdef BUILD_ATARI
+// Host to host copy progress as JSON, "action" cancels, pauses or resumes it
+int fnHttpService::get_handler_copy(mg_connection *c, mg_http_message *hm)
+{
+    char action[10] = "";
+    mg_http_get_var(&hm->query, "action", action, sizeof(action));
+
+    if (strcmp(action, "cancel") == 0)
+        hostCopy.cancel();
+    else if (strcmp(action, "pause") == 0)
+        hostCopy.pause();
+    else if (strcmp(action, "resume") == 0)
+        hostCopy.resume();
+
+    mg_http_reply(c, 200, "Content-Type: application/json\r\n", "%s\n", hostCopy.status_json().c_str());
+    return 0;
+}
+#endif
+
 int fnHttpService::get_handler_eject(mg_connection *c, mg_http_message *hm)
 {
     // get "deviceslot" query variable
@@ -488,7 +590,11 @@ void fnHttpService::cb(struct mg_connection *c, int ev, void *ev_data)
 {
     static const char *s_root_dir = "data/www";
 
-    if (ev == MG_EV_HTTP_MSG)
+    if (ev == MG_EV_POLL)
+    {
+        print_stream_poll(c);
+    }
+    else if (ev == MG_EV_HTTP_MSG)
     {
         struct mg_http_message *hm = (struct mg_http_message *) ev_data;
         if (mg_http_match_uri(hm, "/test"))
@@ -553,6 +659,13 @@ void fnHttpService::cb(struct mg_connection *c, int ev, void *ev_data)
             // eject handler
             get_handler_eject(c, hm);
         }
+#ifdef BUILD_ATARI
+        else if (mg_http_match_uri(hm, "/copy"))
+        {
+            // host copy progress
+            get_handler_copy(c, hm);
+        }
+#endif
         else if (mg_http_match_uri(hm, "/restart"))
         {
             // get "exit" query variable
@@ -2,6 +2,8 @@
 #define _MEDIA_TYPE_
 
 #include <stdio.h>
+
+#include "../mediaCache.h"
 #include <fujiHost.h>
 
 #define INVALID_SECTOR_VALUE 0xFFFFFFFF
@@ -27,6 +29,7 @@ class MediaType
 {
 protected:
     FILE *_media_fileh = nullptr;
+    MediaCache _media_cache;
     FILE *oldFileh = nullptr;
     FILE *hsFileh = nullptr;
 
@@ -55,13 +55,10 @@ bool MediaTypeROM::read(uint32_t blockNum, uint16_t *readcount)
     }
     else // (blocknum > 1)
     {
-        // // Perform a seek if we're not reading the sector after the last one we read
         uint32_t offset = _block_to_offset(blockNum - 2); // minus the two boot blocks
-        err = fseek(_media_fileh, offset, SEEK_SET) != 0;
         _media_last_block = INVALID_SECTOR_VALUE;
 
-        if (err == false)
-            err = fread(_media_blockbuff, 1, 1024, _media_fileh) != 1024;
+        err = _media_cache.read(offset, _media_blockbuff, 1024);
 
         if (err == false)
         {
@@ -119,6 +116,7 @@ mediatype_t MediaTypeROM::mount(FILE *f, uint32_t disksize)
     Debug_print("ROM MOUNT\r\n");
 
     _media_fileh = f;
+    _media_cache.attach(f);
     _mediatype = MEDIATYPE_ROM;
     _media_num_blocks = disksize / 1024;
     _media_num_blocks += 2; // to account for the two boot blocks.
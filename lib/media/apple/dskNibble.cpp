@@ -0,0 +1,285 @@
+
+#include "dskNibble.h"
+
+#include <string.h>
+
+// Track layout and 6-and-2 encoding as in DSK2WOZ by Tom Harte
+// https://github.com/TomHarte/dsk2woz (MIT License)
+
+#define SYNC_COUNT_GAP1 16
+#define SYNC_COUNT_GAP2 7
+#define SYNC_COUNT_GAP3 16
+
+#define ENCODED_SECTOR_LEN 343 // 342 nibbles and the checksum
+#define ENCODED_AUX_LEN 86     // the bottom two bits of each byte
+
+static const uint8_t six_and_two_mapping[64] = {
+    0x96, 0x97, 0x9a, 0x9b, 0x9d, 0x9e, 0x9f, 0xa6,
+    0xa7, 0xab, 0xac, 0xad, 0xae, 0xaf, 0xb2, 0xb3,
+    0xb4, 0xb5, 0xb6, 0xb7, 0xb9, 0xba, 0xbb, 0xbc,
+    0xbd, 0xbe, 0xbf, 0xcb, 0xcd, 0xce, 0xcf, 0xd3,
+    0xd6, 0xd7, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde,
+    0xdf, 0xe5, 0xe6, 0xe7, 0xe9, 0xea, 0xeb, 0xec,
+    0xed, 0xee, 0xef, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6,
+    0xf7, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+
+// six_and_two_mapping backwards, for nibbles 0x80-0xFF, 0xFF if not a data nibble
+static const uint8_t six_and_two_unmapping[128] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x01,
+    0xff, 0xff, 0x02, 0x03, 0xff, 0x04, 0x05, 0x06,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x07, 0x08,
+    0xff, 0xff, 0xff, 0x09, 0x0a, 0x0b, 0x0c, 0x0d,
+    0xff, 0xff, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13,
+    0xff, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x1b, 0xff, 0x1c, 0x1d, 0x1e,
+    0xff, 0xff, 0xff, 0x1f, 0xff, 0xff, 0x20, 0x21,
+    0xff, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x29, 0x2a, 0x2b,
+    0xff, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32,
+    0xff, 0xff, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38,
+    0xff, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f
+};
+
+// The two low bits are stored swapped, this is its own inverse
+static const uint8_t bit_reverse[4] = {0, 2, 1, 3};
+
+int dsk_logical_sector(int physical, bool is_prodos)
+{
+    return (physical == 15) ? 15 : ((physical * (is_prodos ? 8 : 7)) % 15);
+}
+
+/*
+ * Bitstream writer, a whole nibble or sync at a time
+ */
+struct nib_writer
+{
+    uint8_t *p;
+    uint32_t acc = 0;
+    int pending = 0;
+    uint32_t bits = 0;
+
+    nib_writer(uint8_t *dest) : p(dest) {};
+
+    void put(uint32_t value, int count)
+    {
+        acc = (acc << count) | value;
+        pending += count;
+        bits += count;
+        while (pending >= 8)
+        {
+            pending -= 8;
+            *p++ = acc >> pending;
+        }
+    }
+
+    void nibble(uint8_t value) { put(value, 8); };
+    // 0xFF and two zero bits
+    void sync(int count)
+    {
+        while (count-- > 0)
+            put(0x3FC, 10);
+    };
+    void four_and_four(uint8_t value)
+    {
+        nibble((value >> 1) | 0xaa);
+        nibble(value | 0xaa);
+    };
+    void flush()
+    {
+        if (pending > 0)
+            *p++ = acc << (8 - pending);
+        pending = 0;
+    };
+};
+
+// 256 bytes to the 343 nibbles of a sector's data field
+static void encode_6_and_2(uint8_t *dest, const uint8_t *src)
+{
+    // The first 86 values hold the bottom two bits of three bytes each, the
+    // 256 after them the top six bits
+    uint8_t values[ENCODED_SECTOR_LEN - 1];
+    for (int c = 0; c < ENCODED_AUX_LEN - 2; c++)
+        values[c] = bit_reverse[src[c] & 3] |
+                    (bit_reverse[src[c + 86] & 3] << 2) |
+                    (bit_reverse[src[c + 172] & 3] << 4);
+    values[84] = bit_reverse[src[84] & 3] | (bit_reverse[src[170] & 3] << 2);
+    values[85] = bit_reverse[src[85] & 3] | (bit_reverse[src[171] & 3] << 2);
+    for (int c = 0; c < 256; c++)
+        values[ENCODED_AUX_LEN + c] = src[c] >> 2;
+
+    // Each is stored exclusive ORed with the one before, then the last as the checksum
+    uint8_t last = 0;
+    for (int c = 0; c < ENCODED_SECTOR_LEN - 1; c++)
+    {
+        dest[c] = six_and_two_mapping[values[c] ^ last];
+        last = values[c];
+    }
+    dest[ENCODED_SECTOR_LEN - 1] = six_and_two_mapping[last];
+}
+
+// The 343 nibbles of a data field back to 256 bytes
+// Returns TRUE if an error condition occurred
+static bool decode_6_and_2(uint8_t *dest, const uint8_t *src)
+{
+    uint8_t values[ENCODED_SECTOR_LEN - 1];
+    uint8_t last = 0;
+    for (int c = 0; c < ENCODED_SECTOR_LEN; c++)
+    {
+        uint8_t v = (src[c] & 0x80) ? six_and_two_unmapping[src[c] & 0x7F] : 0xFF;
+        if (v == 0xFF)
+            return true;
+        last ^= v;
+        if (c < ENCODED_SECTOR_LEN - 1)
+            values[c] = last;
+    }
+    // what's left after the checksum is folded in
+    if (last != 0)
+        return true;
+
+    for (int c = 0; c < 256; c++)
+    {
+        int aux = c % ENCODED_AUX_LEN;
+        int shift = (c / ENCODED_AUX_LEN) * 2;
+        dest[c] = (values[ENCODED_AUX_LEN + c] << 2) | bit_reverse[(values[aux] >> shift) & 3];
+    }
+    return false;
+}
+
+uint32_t dsk_nibblize_track(uint8_t *dest, const uint8_t *src, uint8_t track_number, bool is_prodos)
+{
+    nib_writer w(dest);
+    uint8_t contents[ENCODED_SECTOR_LEN];
+
+    w.sync(SYNC_COUNT_GAP1);
+
+    // Step through the sectors in physical order
+    for (int sector = 0; sector < DSK_SECTORS_PER_TRACK; sector++)
+    {
+        // Address field
+        w.nibble(0xd5);
+        w.nibble(0xaa);
+        w.nibble(0x96);
+        w.four_and_four(DSK_VOLUME);
+        w.four_and_four(track_number);
+        w.four_and_four(sector);
+        w.four_and_four(DSK_VOLUME ^ track_number ^ sector);
+        w.nibble(0xde);
+        w.nibble(0xaa);
+        w.nibble(0xeb);
+
+        w.sync(SYNC_COUNT_GAP2);
+
+        // Data field
+        w.nibble(0xd5);
+        w.nibble(0xaa);
+        w.nibble(0xad);
+        encode_6_and_2(contents, &src[dsk_logical_sector(sector, is_prodos) * DSK_BYTES_PER_SECTOR]);
+        for (int c = 0; c < ENCODED_SECTOR_LEN; c++)
+            w.nibble(contents[c]);
+        w.nibble(0xde);
+        w.nibble(0xaa);
+        w.nibble(0xeb);
+
+        w.sync(SYNC_COUNT_GAP3);
+    }
+
+    w.flush();
+    return w.bits;
+}
+
+/*
+ * Reads nibbles as the Disk II controller does: bits shift in until the top
+ * one is set, so the zero bits after a sync drop out.
+ */
+struct nib_reader
+{
+    const uint8_t *bits;
+    uint32_t num_bits;
+    uint32_t pos;
+    uint32_t budget; // bits left to read before giving up
+
+    // -1 once the budget is spent
+    int next()
+    {
+        uint8_t reg = 0;
+        while ((reg & 0x80) == 0)
+        {
+            if (budget == 0)
+                return -1;
+            budget--;
+            reg = (reg << 1) | ((bits[pos >> 3] >> (7 - (pos & 7))) & 1);
+            if (++pos == num_bits)
+                pos = 0;
+        }
+        return reg;
+    }
+
+    // Looks for the three nibble prologue, within limit nibbles
+    bool find(uint8_t a, uint8_t b, uint8_t c, int limit)
+    {
+        int n0 = -1, n1 = -1, n2;
+        while (limit-- > 0 && (n2 = next()) >= 0)
+        {
+            if (n0 == a && n1 == b && n2 == c)
+                return true;
+            n0 = n1;
+            n1 = n2;
+        }
+        return false;
+    }
+};
+
+// Nibbles between the end of an address field and its data field's prologue
+#define DATA_PROLOGUE_SEARCH 48
+
+uint16_t dsk_denibblize_track(uint8_t *dest, const uint8_t *bits, uint32_t num_bits, uint8_t track_number, bool is_prodos)
+{
+    if (num_bits == 0)
+        return 0;
+
+    // twice round, so a sector split at the end of the stream is seen whole
+    nib_reader r = {bits, num_bits, 0, num_bits * 2};
+    uint16_t found = 0;
+    uint8_t contents[ENCODED_SECTOR_LEN];
+
+    while (found != 0xFFFF && r.find(0xd5, 0xaa, 0x96, r.budget))
+    {
+        int field[8];
+        for (int i = 0; i < 8; i++)
+            field[i] = r.next();
+        if (field[7] < 0)
+            break;
+
+        uint8_t volume = ((field[0] << 1) | 1) & field[1];
+        uint8_t track = ((field[2] << 1) | 1) & field[3];
+        uint8_t sector = ((field[4] << 1) | 1) & field[5];
+        uint8_t checksum = ((field[6] << 1) | 1) & field[7];
+        if ((volume ^ track ^ sector) != checksum || track != track_number || sector >= DSK_SECTORS_PER_TRACK)
+            continue;
+
+        int logical = dsk_logical_sector(sector, is_prodos);
+        if (!r.find(0xd5, 0xaa, 0xad, DATA_PROLOGUE_SEARCH))
+            continue;
+
+        int c;
+        for (c = 0; c < ENCODED_SECTOR_LEN; c++)
+        {
+            int n = r.next();
+            if (n < 0)
+                break;
+            contents[c] = n;
+        }
+        if (c < ENCODED_SECTOR_LEN)
+            break;
+
+        if (decode_6_and_2(&dest[logical * DSK_BYTES_PER_SECTOR], contents))
+            continue;
+        found |= 1 << logical;
+    }
+
+    return found;
+}
@@ -0,0 +1,37 @@
+#ifndef _DSK_NIBBLE_
+#define _DSK_NIBBLE_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 6-and-2 GCR for Disk II tracks: turns the 16 sectors of a DSK/DO/PO track
+ * into the bitstream the drive would read (the layout dsk2woz makes), and
+ * finds and decodes the sectors in a bitstream the computer wrote.
+ */
+
+#define DSK_SECTORS_PER_TRACK 16
+#define DSK_BYTES_PER_SECTOR 256
+#define DSK_BYTES_PER_TRACK (DSK_SECTORS_PER_TRACK * DSK_BYTES_PER_SECTOR)
+#define DSK_VOLUME 254
+
+// Length of every track dsk_nibblize_track() makes
+#define DSK_TRACK_BITS 50304
+#define DSK_TRACK_BYTES ((DSK_TRACK_BITS + 7) / 8)
+
+// Logical sector held by a physical sector, in DOS 3.3 or ProDOS order
+int dsk_logical_sector(int physical, bool is_prodos);
+
+// Writes the track's bitstream to dest, which must hold DSK_TRACK_BYTES.
+// src is the 4096 bytes of the track as they are in the image.
+// Returns the number of bits written, DSK_TRACK_BITS
+uint32_t dsk_nibblize_track(uint8_t *dest, const uint8_t *src, uint8_t track_number, bool is_prodos);
+
+// Decodes the sectors of track_number found in num_bits of a bitstream into
+// dest, 4096 bytes in image order. The stream is circular, a sector may
+// start near the end and carry on at the beginning. Sectors with a bad
+// checksum or for another track are left alone.
+// Returns a mask of the logical sectors decoded, bit n for sector n
+uint16_t dsk_denibblize_track(uint8_t *dest, const uint8_t *bits, uint32_t num_bits, uint8_t track_number, bool is_prodos);
+
+#endif // _DSK_NIBBLE_
@@ -27,10 +27,23 @@ bool MediaType::format(uint16_t *responsesize)
 //     return true;
 // }
 
+// Returns TRUE if an error condition occurred
+bool MediaType::write_blocks(uint32_t blockNum, uint16_t blocks, uint8_t* buffer)
+{
+    for (uint16_t i = 0; i < blocks; i++)
+    {
+        uint16_t count = 512;
+        if (write(blockNum + i, &count, &buffer[i * 512]))
+            return true;
+    }
+    return false;
+}
+
 void MediaType::unmount()
 {
     if (_media_fileh != nullptr)
     {
+        _media_cache.detach();
         fnio::fclose(_media_fileh);
         _media_fileh = nullptr;
     }
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "fnio.h"
 #include"../fuji/fujiHost.h"
+#include "../mediaCache.h"
 
 #define INVALID_SECTOR_VALUE 65536
 
@@ -29,6 +30,7 @@ class MediaType
 {
 protected:
     fnFile *_media_fileh = nullptr;
+    MediaCache _media_cache;
     fnFile *oldFileh = nullptr; /* Temp fileh for high score enabled games */
     fnFile *hsFileh = nullptr; /* Temp fileh for high score enabled games */
 
@@ -81,6 +83,11 @@ public:
     virtual bool read(uint32_t blockNum, uint16_t *count, uint8_t* buffer) = 0;
     // Returns TRUE if an error condition occurred
     virtual bool write(uint32_t blockNum, uint16_t *count, uint8_t* buffer) = 0;
+    // Writes 512 byte blocks from blockNum on, going back to the image once
+    // Returns TRUE if an error condition occurred
+    virtual bool write_blocks(uint32_t blockNum, uint16_t blocks, uint8_t* buffer);
+    // Cache the 512 byte blocks from blockNum on, ahead of reads expected for them
+    virtual void prefetch(uint32_t blockNum, uint16_t blocks) {};
 
     // virtual uint16_t sector_size(uint16_t sectornum);
     
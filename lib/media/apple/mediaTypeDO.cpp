@@ -36,17 +36,50 @@ bool MediaTypeDO::read_sector(int track, int sector, uint8_t* buffer)
 {
     Debug_printf("\r\nMediaTypeDO read track %d sector %d", track, sector);
     
-    bool err = false;
     uint32_t offset = (track * BYTES_PER_TRACK) + (sector * BYTES_PER_SECTOR);
 
-    err = fnio::fseek(_media_fileh, offset, SEEK_SET) != 0;
+    return _media_cache.read(offset, buffer, BYTES_PER_SECTOR);
+}
+
+bool MediaTypeDO::write_blocks(uint32_t blockNum, uint16_t blocks, uint8_t* buffer)
+{
+    if (blockNum + blocks > num_blocks)
+    {
+        Debug_printf("\r\nwrite blocks BEYOND END %lu > %lu", blockNum + blocks - 1, num_blocks);
+        return true;
+    }
+
+    bool err = false;
+    for (uint16_t i = 0; i < blocks && !err; i++)
+    {
+        uint32_t track = (blockNum + i) / BLOCKS_PER_TRACK;
+        const int* sectors = prodos2dos[(blockNum + i) % BLOCKS_PER_TRACK];
+        uint8_t* block = &buffer[i * BYTES_PER_BLOCK];
+
+        err = write_sector(track, sectors[0], block);
+        if (!err)
+            err = write_sector(track, sectors[1], &block[BYTES_PER_SECTOR]);
+    }
 
+    // all of them go back together
     if (!err)
-        err = fnio::fread(buffer, 1, BYTES_PER_SECTOR, _media_fileh) != BYTES_PER_SECTOR;
+        err = _media_cache.flush();
 
     return err;
 }
 
+// The sectors of a block are spread over its track, so whole tracks are fetched
+void MediaTypeDO::prefetch(uint32_t blockNum, uint16_t blocks)
+{
+    if (blockNum >= num_blocks || blocks == 0)
+        return;
+    if (blocks > num_blocks - blockNum)
+        blocks = num_blocks - blockNum;
+    uint32_t first = blockNum / BLOCKS_PER_TRACK;
+    uint32_t last = (blockNum + blocks - 1) / BLOCKS_PER_TRACK;
+    _media_cache.prefetch(first * BYTES_PER_TRACK, (last - first + 1) * BYTES_PER_TRACK);
+}
+
 bool MediaTypeDO::write(uint32_t blockNum, uint16_t *count, uint8_t* buffer)
 {
     // Return an error if we're trying to write beyond the end of the disk
@@ -65,6 +98,10 @@ bool MediaTypeDO::write(uint32_t blockNum, uint16_t *count, uint8_t* buffer)
     if (!err)
         err = write_sector(track, sectors[1], &buffer[BYTES_PER_SECTOR]);
 
+    // both sectors go back together
+    if (!err)
+        err = _media_cache.flush();
+
     return err;
 }
 
@@ -72,15 +109,9 @@ bool MediaTypeDO::write_sector(int track, int sector, uint8_t* buffer)
 {
     Debug_printf("\r\nMediaTypeDO write track %d sector %d", track, sector);
 
-    bool err = false;
     uint32_t offset = (track * BYTES_PER_TRACK) + (sector * BYTES_PER_SECTOR);
 
-    err = fnio::fseek(_media_fileh, offset, SEEK_SET) != 0;
-
-    if (!err)
-        err = fnio::fwrite(buffer, 1, BYTES_PER_SECTOR, _media_fileh) != BYTES_PER_SECTOR;
-
-    return err;
+    return _media_cache.write(offset, buffer, BYTES_PER_SECTOR);
 }
 
 bool MediaTypeDO::format(uint16_t *responsesize)
@@ -103,6 +134,7 @@ mediatype_t MediaTypeDO::mount(fnFile *f, uint32_t disksize)
 
     diskiiemulation = false;
     _media_fileh = f;
+    _media_cache.attach(f);
     num_blocks = disksize / BYTES_PER_BLOCK;
     return MEDIATYPE_DO;
 }
@@ -14,6 +14,8 @@ private:
 public:
     virtual bool read(uint32_t blockNum, uint16_t *count, uint8_t* buffer) override;
     virtual bool write(uint32_t blockNum, uint16_t *count, uint8_t* buffer) override;
+    virtual bool write_blocks(uint32_t blockNum, uint16_t blocks, uint8_t* buffer) override;
+    virtual void prefetch(uint32_t blockNum, uint16_t blocks) override;
 
     virtual bool format(uint16_t *responsesize) override;
 
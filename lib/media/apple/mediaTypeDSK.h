@@ -4,6 +4,7 @@
 #include <stdio.h>
 
 #include "mediaTypeWOZ.h"
+#include "../trackLRU.h"
 
 // #define MAX_TRACKS 160
 
@@ -15,18 +16,32 @@
 // };
 
 
+// Tracks kept as bitstreams, the least recently used goes when another is needed
+#define DSK_CACHED_TRACKS 8
+#define DSK_CACHED_TRACKS_NO_PSRAM 2
+
+/*
+ * DSK/DO/PO images for the Disk II. A track is made into its bitstream the
+ * first time the head steps onto it rather than all of them at mount, and
+ * only the last few are kept. Tracks the computer writes are decoded back
+ * into sectors and written to the image.
+ */
 class MediaTypeDSK  : public MediaTypeWOZ
 {
 private:
     size_t num_tracks = 0;
+    TrackLRU<DSK_CACHED_TRACKS> _cached{trk_ptrs}; // by track number
 
     void dsk2woz_info();
     void dsk2woz_tmap();
-    bool dsk2woz_tracks(uint8_t *dsk); 
+    // Returns TRUE if an error condition occurred
+    bool dsk2woz_track(uint8_t track);
 
 public:
 
     virtual mediatype_t mount(fnFile *f, uint32_t disksize) override;
+    virtual uint8_t *get_track(int t) override;
+    virtual bool write_track(int t, const uint8_t *bits, uint32_t num_bits) override;
     // virtual void unmount() override;
 
     // static bool create(FILE *f, uint32_t numBlock);
@@ -8,30 +8,35 @@
 
 bool MediaTypePO::read(uint32_t blockNum, uint16_t *count, uint8_t* buffer)
 {
-    size_t readsize = *count;
-if (blockNum == 0 || blockNum != last_block_num + 1) // example optimization, only do seek if not reading next block -tschak
-  {
-     if (fnio::fseek(_media_fileh, (blockNum * readsize) + offset, SEEK_SET))
-    {
-        reset_seek_opto();
-        return true;
-    }
-  }
+    return _media_cache.read((blockNum * *count) + offset, buffer, *count);
+}
 
-  if (high_score_enabled && blockNum >= _high_score_block_lb && blockNum <= _high_score_block_ub)
-    last_block_num = INVALID_SECTOR_VALUE; // try to invalidate cache if game re-reads hs table
-  else
-    last_block_num = blockNum;
+bool MediaTypePO::write_blocks(uint32_t blockNum, uint16_t blocks, uint8_t* buffer)
+{
+    // high score blocks go to their own file handle, one at a time
+    if (high_score_enabled && blockNum <= _high_score_block_ub && blockNum + blocks > _high_score_block_lb)
+        return MediaType::write_blocks(blockNum, blocks, buffer);
+
+    bool err = _media_cache.write((blockNum * 512) + offset, buffer, blocks * 512);
+    if (!err)
+        err = _media_cache.flush(_media_fileh);
+    return err;
+}
 
-  readsize = fnio::fread((unsigned char *)buffer, 1, readsize, _media_fileh); // Reading block from SD Card
-  return (readsize != *count);
+void MediaTypePO::prefetch(uint32_t blockNum, uint16_t blocks)
+{
+    if (blockNum >= num_blocks)
+        return;
+    if (blocks > num_blocks - blockNum)
+        blocks = num_blocks - blockNum;
+    _media_cache.prefetch((blockNum * 512) + offset, blocks * 512);
 }
 
 bool MediaTypePO::write(uint32_t blockNum, uint16_t *count, uint8_t* buffer)
 {
-    size_t writesize = *count;
+    bool high_score = high_score_enabled && blockNum >= _high_score_block_lb && blockNum <= _high_score_block_ub;
 
-    if (high_score_enabled && blockNum >= _high_score_block_lb && blockNum <= _high_score_block_ub)
+    if (high_score)
     {
         Debug_printf("high score: Swapping file handles\r\n");
         oldFileh = _media_fileh;
@@ -39,33 +44,21 @@ bool MediaTypePO::write(uint32_t blockNum, uint16_t *count, uint8_t* buffer)
         _media_fileh = hsFileh;
     }
 
-    if (blockNum != last_block_num + 1) // example optimization, only do seek if not writing next block -tschak
-    {
-         if (fnio::fseek(_media_fileh, (blockNum * writesize) + offset, SEEK_SET))
-        {
-            reset_seek_opto();
-            return true;
-        }
-    }
-    last_block_num = blockNum;
-    writesize = fnio::fwrite((unsigned char *)buffer, 1, writesize, _media_fileh);
-    if (writesize != *count)
-    {
-       reset_seek_opto();
-       return true;
-    }
+    // the cache keeps what was written, so a game re-reading its high score table sees it
+    bool err = _media_cache.write((blockNum * *count) + offset, buffer, *count);
+    if (!err)
+        err = _media_cache.flush(_media_fileh);
 
-    if (high_score_enabled && blockNum >= _high_score_block_lb && blockNum <= _high_score_block_ub)
+    if (high_score)
     {
         Debug_printf("high score: Reverting file handles.\r\n");
         if (hsFileh != nullptr)
             fnio::fclose(hsFileh);
 
         _media_fileh = oldFileh;
-        last_block_num = INVALID_SECTOR_VALUE; // Invalidate cache
     }
 
-    return false;
+    return err;
 }
 
 bool MediaTypePO::format(uint16_t *responsesize)
@@ -101,6 +94,7 @@ mediatype_t MediaTypePO::mount(fnFile *f, uint32_t disksize)
         offset = 64;
     }
   _media_fileh = f;
+  _media_cache.attach(f);
   disksize -= offset;
   num_blocks = disksize/512;
   return MEDIATYPE_PO;
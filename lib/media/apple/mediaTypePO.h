@@ -8,11 +8,12 @@
 class MediaTypePO : public MediaType
 {
 private:
-    uint32_t last_block_num = 0xFFFFFFFF;
     uint32_t offset = 0;
 public:
     virtual bool read(uint32_t blockNum, uint16_t *count, uint8_t* buffer) override;
     virtual bool write(uint32_t blockNum, uint16_t *count, uint8_t* buffer) override;
+    virtual bool write_blocks(uint32_t blockNum, uint16_t blocks, uint8_t* buffer) override;
+    virtual void prefetch(uint32_t blockNum, uint16_t blocks) override;
 
     virtual bool format(uint16_t *responsesize) override;
 
@@ -23,7 +24,6 @@ public:
     // static bool create(FILE *f, uint32_t numBlock);
 
     size_t size() {return _media_num_sectors;}
-    void reset_seek_opto() {last_block_num = 0xFFFFFFFF;};
 };
 
 
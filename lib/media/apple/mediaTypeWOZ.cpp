@@ -47,10 +47,16 @@ mediatype_t MediaTypeWOZ::mount(fnFile *f, uint32_t disksize)
 void MediaTypeWOZ::unmount()
 {
     MediaType::unmount();
+    free_tracks();
+}
+
+void MediaTypeWOZ::free_tracks()
+{
     for (int i = 0; i < MAX_TRACKS; i++)
     {
         if (trk_ptrs[i] != nullptr)
             free(trk_ptrs[i]);
+        trk_ptrs[i] = nullptr;
     }
 }
 
@@ -29,6 +29,8 @@ private:
     bool woz2_read_tracks();
 
 protected:
+    void free_tracks();
+
     uint8_t tmap[MAX_TRACKS];
     TRK_t trks[MAX_TRACKS];
     uint8_t *trk_ptrs[MAX_TRACKS] = { };
@@ -45,10 +47,16 @@ public:
     virtual bool status() override {return (_media_fileh != nullptr);}
 
     uint8_t trackmap(uint8_t t) { return tmap[t]; };
-    uint8_t *get_track(int t) { return trk_ptrs[tmap[t]]; };
+    // Ask for the track before its length and bit count, it may only exist once asked for
+    virtual uint8_t *get_track(int t) { return trk_ptrs[tmap[t]]; };
     int track_len(int t) { return trks[tmap[t]].block_count * 512; };
     int num_bits(int t) { return trks[tmap[t]].bit_count; };
     uint8_t optimal_bit_timing;
+    // Replaces the track with num_bits of a bitstream written by the computer
+    // Returns TRUE if an error condition occurred
+    virtual bool write_track(int t, const uint8_t *bits, uint32_t num_bits) { return true; };
+
+    virtual ~MediaTypeWOZ() { free_tracks(); };
     // static bool create(FILE *f, uint32_t numBlock);
 };
 
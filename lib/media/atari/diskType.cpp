@@ -138,6 +138,7 @@ void MediaType::unmount()
 {
     if (_disk_fileh != nullptr)
     {
+        _disk_cache.detach();
         fnio::fclose(_disk_fileh);
         _disk_fileh = nullptr;
     }
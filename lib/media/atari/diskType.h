@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "fnio.h"
 #include "fujiHost.h"
+#include "../mediaCache.h"
 
 #define INVALID_SECTOR_VALUE 65536
 
@@ -47,6 +48,7 @@ class MediaType
 {
 protected:
     fnFile *_disk_fileh = nullptr;
+    MediaCache _disk_cache;
     uint32_t _disk_image_size = 0;
     int32_t _disk_last_sector = INVALID_SECTOR_VALUE;
     uint8_t _disk_controller_status = DISK_CTRL_STATUS_CLEAR;
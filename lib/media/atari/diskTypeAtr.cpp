@@ -69,16 +69,7 @@ bool MediaTypeATR::read(uint16_t sectornum, uint16_t *readcount)
 
     memset(_disk_sectorbuff, 0, sizeof(_disk_sectorbuff));
 
-    bool err = false;
-    // Perform a seek if we're not reading the sector after the last one we read
-    if (sectornum != _disk_last_sector + 1)
-    {
-        uint32_t offset = _sector_to_offset(sectornum);
-        err = fnio::fseek(_disk_fileh, offset, SEEK_SET) != 0;
-    }
-
-    if (err == false)
-        err = fnio::fread(_disk_sectorbuff, 1, sectorSize, _disk_fileh) != sectorSize;
+    bool err = _disk_cache.read(_sector_to_offset(sectornum), _disk_sectorbuff, sectorSize);
 
     if (err == false)
         _disk_last_sector = sectornum;
@@ -131,27 +122,12 @@ bool MediaTypeATR::write(uint16_t sectornum, bool verify)
 
     _disk_last_sector = INVALID_SECTOR_VALUE;
 
-    // Perform a seek if we're writing to the sector after the last one
-    int e;
-    if (sectornum != _disk_last_sector + 1)
-    {
-        e = fnio::fseek(_disk_fileh, offset, SEEK_SET);
-        if (e != 0)
-        {
-            Debug_printf("::write seek error %d\r\n", e);
-            return true;
-        }
-    }
-    // Write the data
-    e = fnio::fwrite(_disk_sectorbuff, 1, sectorSize, _disk_fileh);
-    if (e != sectorSize)
-    {
-        Debug_printf("::write error %d, %d\r\n", e, errno);
-        return true;
-    }
-
-    int ret = fnio::fflush(_disk_fileh); // Since we might get reset at any moment, go ahead and sync the file
-    Debug_printf("ATR::write fflush:%d\r\n", ret);
+    // Write the data, and since we might get reset at any moment, go ahead and sync the file
+    bool err = _disk_cache.write(offset, _disk_sectorbuff, sectorSize);
+    if (err == false)
+        err = _disk_cache.flush(_disk_fileh);
+    if (err)
+        Debug_printf("::write error %d\r\n", errno);
 
     if (_high_score_sector != 0)
     {
@@ -163,10 +139,10 @@ bool MediaTypeATR::write(uint16_t sectornum, bool verify)
         _disk_fileh = oldFileh;
         _disk_last_sector = INVALID_SECTOR_VALUE; // force a cache invalidate.
     }
-    else
+    else if (err == false)
         _disk_last_sector = sectornum;
 
-    return false;
+    return err;
 }
 
 void MediaTypeATR::status(uint8_t statusbuff[4])
@@ -264,6 +240,7 @@ mediatype_t MediaTypeATR::mount(fnFile *f, uint32_t disksize)
     derive_percom_block(_disk_num_sectors);
 
     _disk_fileh = f;
+    _disk_cache.attach(f);
     _disk_image_size = disksize;
     _disk_last_sector = INVALID_SECTOR_VALUE;
 
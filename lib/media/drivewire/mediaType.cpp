@@ -36,6 +36,7 @@ void MediaType::unmount()
 {
     if (_media_fileh != nullptr)
     {
+        _media_cache.detach();
         fnio::fclose(_media_fileh);
         _media_fileh = nullptr;
     }
@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <fujiHost.h>
 
+#include "../mediaCache.h"
+
 #define INVALID_SECTOR_VALUE 0xFFFFFFFF
 
 #define MEDIA_BLOCK_SIZE 256
@@ -22,6 +24,7 @@ class MediaType
 {
 protected:
     fnFile *_media_fileh = nullptr;
+    MediaCache _media_cache;
     uint32_t _media_image_size = 0;
     uint32_t _media_num_blocks = 256;
     uint16_t _media_sector_size = MEDIA_BLOCK_SIZE;
@@ -63,6 +66,8 @@ public:
     virtual bool read(uint32_t blockNum, uint16_t *readcount) = 0;
     // Returns TRUE if an error condition occurred
     virtual bool write(uint32_t blockNum, bool verify);
+    // Cache the sectors from blockNum on, ahead of reads expected for them
+    virtual void prefetch(uint32_t blockNum, uint16_t blocks) {};
 
     virtual void get_block_buffer(uint8_t **p_buffer, uint16_t *p_blk_size);
     
@@ -33,16 +33,7 @@ bool MediaTypeDSK::read(uint32_t blockNum, uint16_t *readcount)
 
     memset(_media_blockbuff, 0, sizeof(_media_blockbuff));
 
-    bool err = false;
-    // Perform a seek if we're not reading the sector after the last one we read
-    if (blockNum != _media_last_block + 1)
-    {
-        uint32_t offset = _block_to_offset(blockNum);
-        err = fnio::fseek(_media_fileh, offset, SEEK_SET) != 0;
-    }
-    
-    if (err == false)
-        err = fnio::fread(_media_blockbuff, 1, MEDIA_BLOCK_SIZE, _media_fileh) != MEDIA_BLOCK_SIZE;
+    bool err = _media_cache.read(_block_to_offset(blockNum), _media_blockbuff, MEDIA_BLOCK_SIZE);
 
     if (err == false)
         _media_last_block = blockNum;
@@ -54,6 +45,15 @@ bool MediaTypeDSK::read(uint32_t blockNum, uint16_t *readcount)
     return err;
 }
 
+void MediaTypeDSK::prefetch(uint32_t blockNum, uint16_t blocks)
+{
+    if (blockNum >= _media_num_blocks)
+        return;
+    if (blocks > _media_num_blocks - blockNum)
+        blocks = _media_num_blocks - blockNum;
+    _media_cache.prefetch(_block_to_offset(blockNum), blocks * MEDIA_BLOCK_SIZE);
+}
+
 // Returns TRUE if an error condition occurred
 bool MediaTypeDSK::write(uint32_t blockNum, bool verify)
 {
@@ -63,32 +63,13 @@ bool MediaTypeDSK::write(uint32_t blockNum, bool verify)
 
     _media_last_block = INVALID_SECTOR_VALUE;
 
-    // Perform a seek if we're writing to the sector after the last one
-    int e;
-    e = fnio::fseek(_media_fileh, offset, SEEK_SET);
-    if (e != 0)
+    // Write the data, fnio::fflush() in the cache's flush should be sufficient for syncing
+    if (_media_cache.write(offset, _media_blockbuff, MEDIA_BLOCK_SIZE) || _media_cache.flush())
     {
-        Debug_printf("::write seek error %d\n", e);
+        Debug_printf("::write error %d\n", errno);
         _media_controller_status = 2;
         return true;
     }
-    // Write the data
-    e = fnio::fwrite(&_media_blockbuff, 1, MEDIA_BLOCK_SIZE, _media_fileh);
-
-    if (e != MEDIA_BLOCK_SIZE)
-    {
-        Debug_printf("::write error %d, %d\n", e, errno);
-        return true;
-    }
-
-    int ret = fnio::fflush(_media_fileh);    // This doesn't seem to be connected to anything in ESP-IDF VF, so it may not do anything
-    
-    // This next line is commented out because there's no fsync in the 
-    // fnio class. In a discussion with @apc from the following discussion:
-    // https://discord.com/channels/655893677146636301/1209535440915406848/1231880068528214026
-    // fnio::fflush() should be sufficient for syncing as well.
-//    ret = fsync(fileno(_media_fileh)); // Since we might get reset at any moment, go ahead and sync the file (not clear if fflush does this)
-    Debug_printf("DSK::write fsync:%d\n", ret);
 
     _media_last_block = INVALID_SECTOR_VALUE;
     _media_controller_status = 0;
@@ -111,6 +92,7 @@ mediatype_t MediaTypeDSK::mount(fnFile *f, uint32_t disksize)
     Debug_print("DSK MOUNT\n");
 
     _media_fileh = f;
+    _media_cache.attach(f);
     _mediatype = MEDIATYPE_DSK;
     _media_num_blocks = disksize / MEDIA_BLOCK_SIZE;
 
@@ -13,6 +13,7 @@ private:
 public:
     virtual bool read(uint32_t blockNum, uint16_t *readcount) override;
     virtual bool write(uint32_t blockNum, bool verify) override;
+    virtual void prefetch(uint32_t blockNum, uint16_t blocks) override;
 
     virtual bool format(uint16_t *responsesize) override;
 
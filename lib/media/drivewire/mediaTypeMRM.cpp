@@ -33,22 +33,13 @@ bool MediaTypeMRM::read(uint32_t blockNum, uint16_t *readcount)
 
     memset(_media_blockbuff, 0xFF, sizeof(_media_blockbuff));
 
-    bool err = false;
-    // Perform a seek if we're not reading the sector after the last one we read
-    if (blockNum != _media_last_block + 1)
-    {
-        uint32_t offset = _block_to_offset(blockNum);
-        err = fnio::fseek(_media_fileh, offset, SEEK_SET) != 0;
-    }
-    
     uint16_t to_read;
     if (_block_to_offset(blockNum + 1) > _media_image_size)
         to_read = _media_image_size - _block_to_offset(blockNum);
     else
         to_read = MRM_BLOCK_SIZE;
 
-    if (err == false)
-        err = fnio::fread(_media_blockbuff, 1, to_read, _media_fileh) != to_read;
+    bool err = _media_cache.read(_block_to_offset(blockNum), _media_blockbuff, to_read);
 
     if (err == false)
         _media_last_block = blockNum;
@@ -92,6 +83,7 @@ mediatype_t MediaTypeMRM::mount(fnFile *f, uint32_t disksize)
     Debug_print("DSK MOUNT\n");
 
     _media_fileh = f;
+    _media_cache.attach(f);
     _media_image_size = disksize;
     _mediatype = MEDIATYPE_MRM;
     _media_num_blocks = (disksize + MRM_BLOCK_SIZE - 1) / MRM_BLOCK_SIZE;
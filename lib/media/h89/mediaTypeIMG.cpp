@@ -165,16 +165,7 @@ bool MediaTypeIMG::read(uint16_t sectornum, uint16_t *readcount)
 
     memset(_media_sectorbuff, 0, sizeof(_media_sectorbuff));
 
-    bool err = false;
-    // Perform a seek if we're not reading the sector after the last one we read
-    if (sectornum != _media_last_sector + 1)
-    {
-        uint32_t offset = _sector_to_offset(sectornum);
-        err = fseek(_media_fileh, offset, SEEK_SET) != 0;
-    }
-
-    if (err == false)
-        err = fread(_media_sectorbuff, 1, sectorSize, _media_fileh) != sectorSize;
+    bool err = _media_cache.read(_sector_to_offset(sectornum), _media_sectorbuff, sectorSize);
 
     if (err == false)
         _media_last_sector = sectornum;
@@ -203,29 +194,13 @@ bool MediaTypeIMG::write(uint16_t sectornum, bool verify)
 
     _media_last_sector = INVALID_SECTOR_VALUE;
 
-    // Perform a seek if we're writing to the sector after the last one
-    int e;
-    if (sectornum != _media_last_sector + 1)
+    // Write the data, and since we might get reset at any moment, go ahead and sync the file
+    if (_media_cache.write(offset, _media_sectorbuff, DISK_BYTES_PER_SECTOR_BLOCK) || _media_cache.flush())
     {
-        e = fseek(_media_fileh, offset, SEEK_SET);
-        if (e != 0)
-        {
-            Debug_printf("::write seek error %d\n", e);
-            return true;
-        }
-    }
-    // Write the data
-    e = fwrite(_media_sectorbuff, 1, DISK_BYTES_PER_SECTOR_BLOCK, _media_fileh);
-    if (e != DISK_BYTES_PER_SECTOR_BLOCK)
-    {
-        Debug_printf("::write error %d, %d\n", e, errno);
+        Debug_printf("::write error %d\n", errno);
         return true;
     }
 
-    int ret = fflush(_media_fileh);    // This doesn't seem to be connected to anything in ESP-IDF VF, so it may not do anything
-    ret = fsync(fileno(_media_fileh)); // Since we might get reset at any moment, go ahead and sync the file (not clear if fflush does this)
-    Debug_printf("IMG::write fsync:%d\n", ret);
-
     _media_last_sector = sectornum;
     _media_controller_status=0;
 
@@ -263,6 +238,7 @@ mediatype_t MediaTypeIMG::mount(FILE *f, uint32_t disksize, mediatype_t disk_typ
     Debug_print("IMG MOUNT\n");
 
     _media_fileh = f;
+    _media_cache.attach(f);
     _media_num_sectors = disksize / 512;
     _mediatype = disk_type;
 
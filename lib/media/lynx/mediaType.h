@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 
+#include "../mediaCache.h"
+
 #define INVALID_SECTOR_VALUE 0xFFFFFFFF
 
 #define MEDIA_BLOCK_SIZE 256
@@ -26,6 +28,7 @@ class MediaType
 {
 protected:
     FILE *_media_fileh = nullptr;
+    MediaCache _media_cache;
     uint32_t _media_image_size = 0;
     uint32_t _media_num_blocks = 256;
     uint16_t _media_sector_size = DISK_BYTES_PER_SECTOR_SINGLE;
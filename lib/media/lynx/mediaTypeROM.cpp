@@ -32,17 +32,7 @@ bool MediaTypeROM::read(uint32_t blockNum, uint16_t *readcount)
 
     memset(_media_blockbuff, 0, sizeof(_media_blockbuff));
 
-    bool err = false;
-    // // Perform a seek if we're not reading the sector after the last one we read
-     if (blockNum != _media_last_block + 1)
-     {
-        uint32_t offset = _block_to_offset(blockNum);
-        err = fseek(_media_fileh, offset, SEEK_SET) != 0;
-        _media_last_block = INVALID_SECTOR_VALUE;
-     }
-
-    if (err == false)
-        err = fread(_media_blockbuff, 1, 256, _media_fileh) != 256;
+    bool err = _media_cache.read(_block_to_offset(blockNum), _media_blockbuff, 256);
 
     if (err == false)
     {
@@ -82,6 +72,7 @@ mediatype_t MediaTypeROM::mount(FILE *f, uint32_t disksize)
     Debug_print("ROM MOUNT\r\n");
 
     _media_fileh = f;
+    _media_cache.attach(f);
     _mediatype = MEDIATYPE_ROM;
     _media_num_blocks = disksize / 256;
 
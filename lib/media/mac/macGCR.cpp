@@ -0,0 +1,436 @@
+
+#include "macGCR.h"
+
+#include <string.h>
+
+#define CYLINDERS_PER_ZONE 16
+
+// Self-sync bytes, 0xFF and two zero bits
+#define SYNC_COUNT_GAP1 64
+#define SYNC_COUNT_GAP2 6
+
+#define TAGGED_SECTOR_SIZE (MAC_GCR_TAG_SIZE + MAC_GCR_SECTOR_SIZE) // 524
+#define ENCODED_GROUPS 175                                         // of three bytes, the last only two
+#define ENCODED_DATA_LEN (ENCODED_GROUPS * 4 - 1)                  // 699
+#define ENCODED_CHECKSUM_LEN 4
+
+// 8 bit nibbles of the address field, data field and its header and trailer
+#define ADDRESS_FIELD_BITS ((3 + 5 + 2) * 8)
+#define DATA_FIELD_BITS ((3 + 1 + ENCODED_DATA_LEN + ENCODED_CHECKSUM_LEN + 2) * 8)
+
+// Format byte, 0x20 for two sides, and the interleave
+#define FORMAT_ONE_SIDE 0x02
+#define FORMAT_TWO_SIDES 0x22
+#define INTERLEAVE 2
+
+// Bits in one turn at each zone's speed: 394, 429, 472, 525 and 590 RPM
+static const uint32_t zone_track_bits[MAC_GCR_CYLINDERS / CYLINDERS_PER_ZONE] = {
+    76142, 69930, 63559, 57142, 50847
+};
+
+// The same 6 to 8 bit mapping as the Disk II
+static const uint8_t gcr_mapping[64] = {
+    0x96, 0x97, 0x9a, 0x9b, 0x9d, 0x9e, 0x9f, 0xa6,
+    0xa7, 0xab, 0xac, 0xad, 0xae, 0xaf, 0xb2, 0xb3,
+    0xb4, 0xb5, 0xb6, 0xb7, 0xb9, 0xba, 0xbb, 0xbc,
+    0xbd, 0xbe, 0xbf, 0xcb, 0xcd, 0xce, 0xcf, 0xd3,
+    0xd6, 0xd7, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde,
+    0xdf, 0xe5, 0xe6, 0xe7, 0xe9, 0xea, 0xeb, 0xec,
+    0xed, 0xee, 0xef, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6,
+    0xf7, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+
+// gcr_mapping backwards, for nibbles 0x80-0xFF, 0xFF if not a data nibble
+static const uint8_t gcr_unmapping[128] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x01,
+    0xff, 0xff, 0x02, 0x03, 0xff, 0x04, 0x05, 0x06,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x07, 0x08,
+    0xff, 0xff, 0xff, 0x09, 0x0a, 0x0b, 0x0c, 0x0d,
+    0xff, 0xff, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13,
+    0xff, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x1b, 0xff, 0x1c, 0x1d, 0x1e,
+    0xff, 0xff, 0xff, 0x1f, 0xff, 0xff, 0x20, 0x21,
+    0xff, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0x29, 0x2a, 0x2b,
+    0xff, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32,
+    0xff, 0xff, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38,
+    0xff, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f
+};
+
+int mac_gcr_sectors(int cylinder)
+{
+    return MAC_GCR_MAX_SECTORS - cylinder / CYLINDERS_PER_ZONE;
+}
+
+uint32_t mac_gcr_track_bits(int cylinder)
+{
+    return zone_track_bits[cylinder / CYLINDERS_PER_ZONE];
+}
+
+uint32_t mac_gcr_first_block(int cylinder, int side, int sides)
+{
+    uint32_t block = 0;
+    for (int c = 0; c < cylinder; c++)
+        block += mac_gcr_sectors(c) * sides;
+    return block + side * mac_gcr_sectors(cylinder);
+}
+
+// Sector at each physical position round the track
+static void interleave(uint8_t *order, int count)
+{
+    bool used[MAC_GCR_MAX_SECTORS] = {};
+    int pos = 0;
+    for (int s = 0; s < count; s++)
+    {
+        while (used[pos])
+            pos = (pos + 1) % count;
+        order[pos] = s;
+        used[pos] = true;
+        pos = (pos + INTERLEAVE) % count;
+    }
+}
+
+/*
+ * Bitstream writer, a whole nibble or sync at a time
+ */
+struct gcr_writer
+{
+    uint8_t *p;
+    uint32_t acc = 0;
+    int pending = 0;
+    uint32_t bits = 0;
+
+    gcr_writer(uint8_t *dest) : p(dest) {};
+
+    void put(uint32_t value, int count)
+    {
+        acc = (acc << count) | value;
+        pending += count;
+        bits += count;
+        while (pending >= 8)
+        {
+            pending -= 8;
+            *p++ = acc >> pending;
+        }
+    }
+
+    void nibble(uint8_t value) { put(value, 8); };
+    void value(uint8_t six_bits) { put(gcr_mapping[six_bits & 0x3F], 8); };
+    void sync(int count)
+    {
+        while (count-- > 0)
+            put(0x3FC, 10);
+    };
+    void flush()
+    {
+        if (pending > 0)
+            *p++ = acc << (8 - pending);
+        pending = 0;
+    };
+};
+
+/*
+ * The 524 bytes of a tagged sector become 699 six bit values and a 4 value
+ * checksum. Three running sums, rotated and carried into one another, are
+ * exclusive ORed into the bytes of each group of three; the top two bits of
+ * each group go in a value of their own ahead of it.
+ */
+static void encode_sector(uint8_t *dest, const uint8_t *src)
+{
+    uint8_t b1[ENCODED_GROUPS], b2[ENCODED_GROUPS], b3[ENCODED_GROUPS];
+    uint32_t c1 = 0, c2 = 0, c3 = 0;
+    int i = 0;
+
+    for (int j = 0;; j++)
+    {
+        c1 = (c1 & 0xFF) << 1;
+        if (c1 & 0x100)
+            c1++;
+
+        uint8_t val = src[i++];
+        c3 += val;
+        if (c1 & 0x100)
+        {
+            c3++;
+            c1 &= 0xFF;
+        }
+        b1[j] = val ^ c1;
+
+        val = src[i++];
+        c2 += val;
+        if (c3 > 0xFF)
+        {
+            c2++;
+            c3 &= 0xFF;
+        }
+        b2[j] = val ^ c3;
+
+        if (i == TAGGED_SECTOR_SIZE)
+            break;
+
+        val = src[i++];
+        c1 += val;
+        if (c2 > 0xFF)
+        {
+            c1++;
+            c2 &= 0xFF;
+        }
+        b3[j] = val ^ c2;
+    }
+    b3[ENCODED_GROUPS - 1] = 0;
+
+    for (int j = 0; j < ENCODED_GROUPS; j++)
+    {
+        *dest++ = ((b1[j] & 0xC0) >> 2) | ((b2[j] & 0xC0) >> 4) | ((b3[j] & 0xC0) >> 6);
+        *dest++ = b1[j] & 0x3F;
+        *dest++ = b2[j] & 0x3F;
+        if (j != ENCODED_GROUPS - 1)
+            *dest++ = b3[j] & 0x3F;
+    }
+
+    *dest++ = ((c1 & 0xC0) >> 6) | ((c2 & 0xC0) >> 4) | ((c3 & 0xC0) >> 2);
+    *dest++ = c3 & 0x3F;
+    *dest++ = c2 & 0x3F;
+    *dest++ = c1 & 0x3F;
+}
+
+// The 703 six bit values of a data field back to 524 bytes
+// Returns TRUE if an error condition occurred
+static bool decode_sector(uint8_t *dest, const uint8_t *src)
+{
+    uint8_t b1[ENCODED_GROUPS], b2[ENCODED_GROUPS], b3[ENCODED_GROUPS];
+
+    for (int j = 0; j < ENCODED_GROUPS; j++)
+    {
+        uint8_t w4 = *src++;
+        uint8_t w1 = *src++;
+        uint8_t w2 = *src++;
+        uint8_t w3 = (j != ENCODED_GROUPS - 1) ? *src++ : 0;
+        b1[j] = w1 | ((w4 << 2) & 0xC0);
+        b2[j] = w2 | ((w4 << 4) & 0xC0);
+        b3[j] = w3 | ((w4 << 6) & 0xC0);
+    }
+
+    uint32_t c1 = 0, c2 = 0, c3 = 0;
+    int i = 0;
+    for (int j = 0;; j++)
+    {
+        c1 = (c1 & 0xFF) << 1;
+        if (c1 & 0x100)
+            c1++;
+
+        uint8_t val = b1[j] ^ c1;
+        c3 += val;
+        if (c1 & 0x100)
+        {
+            c3++;
+            c1 &= 0xFF;
+        }
+        dest[i++] = val;
+
+        val = b2[j] ^ c3;
+        c2 += val;
+        if (c3 > 0xFF)
+        {
+            c2++;
+            c3 &= 0xFF;
+        }
+        dest[i++] = val;
+
+        if (i == TAGGED_SECTOR_SIZE)
+            break;
+
+        val = b3[j] ^ c2;
+        c1 += val;
+        if (c2 > 0xFF)
+        {
+            c1++;
+            c2 &= 0xFF;
+        }
+        dest[i++] = val;
+    }
+
+    uint8_t w4 = src[0];
+    return (uint8_t)(src[1] | ((w4 << 2) & 0xC0)) != (uint8_t)c3 ||
+           (uint8_t)(src[2] | ((w4 << 4) & 0xC0)) != (uint8_t)c2 ||
+           (uint8_t)(src[3] | ((w4 << 6) & 0xC0)) != (uint8_t)c1;
+}
+
+// Syncs after each sector, what's left of the turn shared out between them
+static int gap3_syncs(int cylinder)
+{
+    int count = mac_gcr_sectors(cylinder);
+    uint32_t used = SYNC_COUNT_GAP1 * 10 + count * (ADDRESS_FIELD_BITS + SYNC_COUNT_GAP2 * 10 + DATA_FIELD_BITS);
+    return (mac_gcr_track_bits(cylinder) - used) / (count * 10);
+}
+
+uint32_t mac_gcr_encoded_bits(int cylinder)
+{
+    int count = mac_gcr_sectors(cylinder);
+    return SYNC_COUNT_GAP1 * 10 +
+           count * (ADDRESS_FIELD_BITS + SYNC_COUNT_GAP2 * 10 + DATA_FIELD_BITS + gap3_syncs(cylinder) * 10);
+}
+
+uint32_t mac_gcr_encode_track(uint8_t *dest, const uint8_t *sectors, int cylinder, int side, int sides)
+{
+    int count = mac_gcr_sectors(cylinder);
+    int gap3 = gap3_syncs(cylinder);
+    uint8_t order[MAC_GCR_MAX_SECTORS];
+    interleave(order, count);
+
+    uint8_t format = (sides == 2) ? FORMAT_TWO_SIDES : FORMAT_ONE_SIDE;
+    uint8_t track_lo = cylinder & 0x3F;
+    uint8_t side_hi = (side ? 0x20 : 0x00) | (cylinder >> 6);
+
+    uint8_t tagged[TAGGED_SECTOR_SIZE];
+    uint8_t values[ENCODED_DATA_LEN + ENCODED_CHECKSUM_LEN];
+    memset(tagged, 0, MAC_GCR_TAG_SIZE);
+
+    gcr_writer w(dest);
+    w.sync(SYNC_COUNT_GAP1);
+
+    for (int p = 0; p < count; p++)
+    {
+        uint8_t sector = order[p];
+
+        // Address field
+        w.nibble(0xd5);
+        w.nibble(0xaa);
+        w.nibble(0x96);
+        w.value(track_lo);
+        w.value(sector);
+        w.value(side_hi);
+        w.value(format);
+        w.value(track_lo ^ sector ^ side_hi ^ format);
+        w.nibble(0xde);
+        w.nibble(0xaa);
+
+        w.sync(SYNC_COUNT_GAP2);
+
+        // Data field
+        w.nibble(0xd5);
+        w.nibble(0xaa);
+        w.nibble(0xad);
+        w.value(sector);
+        memcpy(tagged + MAC_GCR_TAG_SIZE, sectors + sector * MAC_GCR_SECTOR_SIZE, MAC_GCR_SECTOR_SIZE);
+        encode_sector(values, tagged);
+        for (int c = 0; c < ENCODED_DATA_LEN + ENCODED_CHECKSUM_LEN; c++)
+            w.value(values[c]);
+        w.nibble(0xde);
+        w.nibble(0xaa);
+
+        w.sync(gap3);
+    }
+
+    w.flush();
+    return w.bits;
+}
+
+/*
+ * Reads nibbles as the IWM does: bits shift in until the top one is set, so
+ * the zero bits after a sync drop out.
+ */
+struct gcr_reader
+{
+    const uint8_t *bits;
+    uint32_t num_bits;
+    uint32_t pos;
+    uint32_t budget; // bits left to read before giving up
+
+    // -1 once the budget is spent
+    int next()
+    {
+        uint8_t reg = 0;
+        while ((reg & 0x80) == 0)
+        {
+            if (budget == 0)
+                return -1;
+            budget--;
+            reg = (reg << 1) | ((bits[pos >> 3] >> (7 - (pos & 7))) & 1);
+            if (++pos == num_bits)
+                pos = 0;
+        }
+        return reg;
+    }
+
+    // The next nibble as a six bit value, -1 if it isn't one
+    int value()
+    {
+        int n = next();
+        if (n < 0)
+            return -1;
+        uint8_t v = gcr_unmapping[n & 0x7F];
+        return (v == 0xFF) ? -1 : v;
+    }
+
+    // Looks for the three nibble prologue, within limit nibbles
+    bool find(uint8_t a, uint8_t b, uint8_t c, int limit)
+    {
+        int n0 = -1, n1 = -1, n2;
+        while (limit-- > 0 && (n2 = next()) >= 0)
+        {
+            if (n0 == a && n1 == b && n2 == c)
+                return true;
+            n0 = n1;
+            n1 = n2;
+        }
+        return false;
+    }
+};
+
+// Nibbles between the end of an address field and its data field's prologue
+#define DATA_PROLOGUE_SEARCH 48
+
+uint16_t mac_gcr_decode_track(uint8_t *dest, const uint8_t *bits, uint32_t num_bits, int cylinder, int side)
+{
+    if (num_bits == 0)
+        return 0;
+
+    int count = mac_gcr_sectors(cylinder);
+    uint16_t all = (1 << count) - 1;
+
+    // twice round, so a sector split at the end of the stream is seen whole
+    gcr_reader r = {bits, num_bits, 0, num_bits * 2};
+    uint16_t found = 0;
+    uint8_t values[ENCODED_DATA_LEN + ENCODED_CHECKSUM_LEN];
+    uint8_t tagged[TAGGED_SECTOR_SIZE];
+
+    while (found != all && r.find(0xd5, 0xaa, 0x96, r.budget))
+    {
+        int field[5];
+        for (int i = 0; i < 5; i++)
+            field[i] = r.value();
+        if (field[0] < 0 || field[1] < 0 || field[2] < 0 || field[3] < 0 || field[4] < 0)
+            continue;
+        if ((field[0] ^ field[1] ^ field[2] ^ field[3]) != field[4])
+            continue;
+
+        int track = field[0] | ((field[2] & 0x01) << 6);
+        int sector = field[1];
+        int track_side = (field[2] & 0x20) ? 1 : 0;
+        if (track != cylinder || track_side != side || sector >= count)
+            continue;
+
+        if (!r.find(0xd5, 0xaa, 0xad, DATA_PROLOGUE_SEARCH) || r.value() != sector)
+            continue;
+
+        int c;
+        for (c = 0; c < ENCODED_DATA_LEN + ENCODED_CHECKSUM_LEN; c++)
+        {
+            int v = r.value();
+            if (v < 0)
+                break;
+            values[c] = v;
+        }
+        if (c < ENCODED_DATA_LEN + ENCODED_CHECKSUM_LEN || decode_sector(tagged, values))
+            continue;
+
+        memcpy(dest + sector * MAC_GCR_SECTOR_SIZE, tagged + MAC_GCR_TAG_SIZE, MAC_GCR_SECTOR_SIZE);
+        found |= 1 << sector;
+    }
+
+    return found;
+}
@@ -0,0 +1,51 @@
+#ifndef _MAC_GCR_
+#define _MAC_GCR_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Sony GCR for 400K/800K Macintosh floppies: makes the bitstream of a track
+ * from its 512 byte sectors, and finds and decodes the sectors in a written
+ * one. The drive runs slower towards the middle, so the 80 cylinders are in
+ * five zones of 16 with 12 sectors a track on the outside down to 8 on the
+ * inside. Sectors are 2:1 interleaved, and each carries 12 tag bytes ahead of
+ * its data, written as zeros here since sector images have none.
+ */
+
+#define MAC_GCR_CYLINDERS 80
+#define MAC_GCR_MAX_SECTORS 12
+#define MAC_GCR_SECTOR_SIZE 512
+#define MAC_GCR_TAG_SIZE 12
+
+// 800 blocks a side
+#define MAC_GCR_400K 409600
+#define MAC_GCR_800K 819200
+
+// 2us bit cells, in 125ns units as MOOF optimal bit timing
+#define MAC_GCR_BIT_TIMING 16
+// Longest track, on the outside zone
+#define MAC_GCR_MAX_TRACK_BITS 76142
+#define MAC_GCR_MAX_TRACK_BYTES ((MAC_GCR_MAX_TRACK_BITS + 7) / 8)
+
+int mac_gcr_sectors(int cylinder);
+// Most bits a track on the cylinder holds in one turn of the disk
+uint32_t mac_gcr_track_bits(int cylinder);
+// First block of the track in a sector image
+uint32_t mac_gcr_first_block(int cylinder, int side, int sides);
+
+// Length of the bitstream mac_gcr_encode_track() makes for the cylinder
+uint32_t mac_gcr_encoded_bits(int cylinder);
+
+// Writes the track's bitstream to dest, which must hold MAC_GCR_MAX_TRACK_BYTES.
+// sectors is the track's mac_gcr_sectors() blocks as they are in the image.
+// Returns the number of bits written, mac_gcr_encoded_bits()
+uint32_t mac_gcr_encode_track(uint8_t *dest, const uint8_t *sectors, int cylinder, int side, int sides);
+
+// Decodes the sectors of cylinder and side found in num_bits of a bitstream
+// into dest, in image order. The stream is circular. Sectors with a bad
+// checksum or for another track are left alone.
+// Returns a mask of the sectors decoded, bit n for sector n
+uint16_t mac_gcr_decode_track(uint8_t *dest, const uint8_t *bits, uint32_t num_bits, int cylinder, int side);
+
+#endif // _MAC_GCR_
@@ -18,6 +18,7 @@ void MediaType::unmount()
 {
     if (_media_fileh != nullptr)
     {
+        _media_cache.detach();
         fclose(_media_fileh);
         _media_fileh = nullptr;
     }
@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 
+#include "../mediaCache.h"
+
 #define INVALID_SECTOR_VALUE 65536
 
 #define DISK_SECTORBUF_SIZE 512
@@ -27,6 +29,7 @@ class MediaType
 {
 protected:
     FILE *_media_fileh = nullptr;
+    MediaCache _media_cache;
     uint32_t _media_image_size = 0;
     uint32_t _media_num_sectors = 0;
     uint16_t _media_sector_size = 512; //DISK_BYTES_PER_SECTOR_SINGLE;
@@ -8,64 +8,15 @@
 
 bool MediaTypeDCD::read(uint32_t blockNum, uint8_t* buffer)
 {
-    size_t readsize = 512;//_media_sector_size;
-if ((blockNum == 0) || (blockNum != last_block_num + 1)) // example optimization, only do seek if not reading next block -tschak
-  {
-     if (fseek(_media_fileh, (blockNum * readsize) + offset, SEEK_SET))
-    {
-        reset_seek_opto();
-        return true;
-    }
-  }
-
-//   if (high_score_enabled && blockNum >= _high_score_block_lb && blockNum <= _high_score_block_ub)
-//     last_block_num = INVALID_SECTOR_VALUE; // try to invalidate cache if game re-reads hs table
-//   else
-    last_block_num = blockNum;
-
-  readsize = fread((unsigned char *)buffer, 1, readsize, _media_fileh); // Reading block from SD Card
-  return (readsize != _media_sector_size);
+    return _media_cache.read((blockNum * _media_sector_size) + offset, buffer, _media_sector_size);
 }
 
 bool MediaTypeDCD::write(uint32_t blockNum, uint8_t* buffer)
 {
-    size_t writesize = 512; //_media_sector_size;
-
-    // if (high_score_enabled && blockNum >= _high_score_block_lb && blockNum <= _high_score_block_ub)
-    // {
-    //     Debug_printf("high score: Swapping file handles\r\n");
-    //     oldFileh = _media_fileh;
-    //     hsFileh = _media_host->file_open(_disk_filename, _disk_filename, strlen(_disk_filename) +1, "r+");
-    //     _media_fileh = hsFileh;
-    // }
-
-    if (blockNum != last_block_num + 1) // example optimization, only do seek if not writing next block -tschak
-    {
-         if (fseek(_media_fileh, (blockNum * writesize) + offset, SEEK_SET))
-        {
-            reset_seek_opto();
-            return true;
-        }
-    }
-    last_block_num = blockNum;
-    writesize = fwrite((unsigned char *)buffer, 1, writesize, _media_fileh);
-    if (writesize != _media_sector_size)
-    {
-       reset_seek_opto();
-       return true;
-    }
-
-    // if (high_score_enabled && blockNum >= _high_score_block_lb && blockNum <= _high_score_block_ub)
-    // {
-    //     Debug_printf("high score: Reverting file handles.\r\n");
-    //     if (hsFileh != nullptr)
-    //         fclose(hsFileh);
-
-    //     _media_fileh = oldFileh;
-    //     last_block_num = INVALID_SECTOR_VALUE; // Invalidate cache
-    // }
+    if (_media_cache.write((blockNum * _media_sector_size) + offset, buffer, _media_sector_size))
+        return true;
 
-    return false;
+    return _media_cache.flush();
 }
 
 bool MediaTypeDCD::format(uint16_t *responsesize)
@@ -102,6 +53,7 @@ mediatype_t MediaTypeDCD::mount(FILE *f, uint32_t disksize)
     // }
     // offset = 0; // set value at constructor
     _media_fileh = f;
+    _media_cache.attach(f);
     disksize -= offset;
     _media_sector_size = 512;
     num_blocks = disksize / _media_sector_size;
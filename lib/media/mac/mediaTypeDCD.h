@@ -8,7 +8,6 @@
 class MediaTypeDCD : public MediaType
 {
 private:
-    uint32_t last_block_num = 0xFFFFFFFF;
     uint32_t offset = 0;
 public:
     virtual bool read(uint32_t blockNum, uint8_t* buffer) override;
@@ -25,7 +24,6 @@ public:
 
     size_t size() {return _media_num_sectors;}
     size_t sectorsize() {return _media_sector_size;}
-    void reset_seek_opto() {last_block_num = 0xFFFFFFFF;};
 
     MediaTypeDCD(int x = 0) : offset(x) {}
 };
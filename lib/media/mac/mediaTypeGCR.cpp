@@ -0,0 +1,151 @@
+#ifdef BUILD_MAC
+
+#include "esp_heap_caps.h"
+#include "mediaTypeGCR.h"
+#include "fnSystem.h"
+#include "../../include/debug.h"
+#include <string.h>
+
+// Where the sector data size is in a Disk Copy 4.2 header, big endian
+#define DC42_DATA_SIZE 0x40
+
+uint32_t MediaTypeGCR::image_size(FILE *f, uint32_t disksize, mediatype_t disk_type)
+{
+    uint32_t size = disksize;
+
+    if (disk_type == MEDIATYPE_DC42)
+    {
+        uint8_t be[4];
+        if (fseek(f, DC42_DATA_SIZE, SEEK_SET) || fread(be, 1, sizeof(be), f) != sizeof(be))
+            return 0;
+        size = (be[0] << 24) | (be[1] << 16) | (be[2] << 8) | be[3];
+    }
+    else if (disk_type != MEDIATYPE_DSK)
+        return 0;
+
+    return (size == MAC_GCR_400K || size == MAC_GCR_800K) ? size : 0;
+}
+
+mediatype_t MediaTypeGCR::mount(FILE *f, uint32_t disksize)
+{
+    uint32_t size = disksize - offset;
+    if (size != MAC_GCR_400K && size != MAC_GCR_800K)
+    {
+        Debug_printf("\nMediaTypeGCR error: unsupported disk image size %lu", size);
+        return MEDIATYPE_UNKNOWN;
+    }
+
+    _media_fileh = f;
+    floppy_emulation = true;
+    num_sides = (size == MAC_GCR_800K) ? 2 : 1;
+    optimal_bit_timing = MAC_GCR_BIT_TIMING;
+    num_blocks = (MAC_GCR_MAX_TRACK_BYTES + 511) / 512;
+
+    // tracks are read as the head gets to them
+    if (_media_cache.attach(f))
+        return MEDIATYPE_UNKNOWN;
+    _cached.reset(fnSystem.get_psram_size() > 0 ? GCR_CACHED_TRACKS : GCR_CACHED_TRACKS_NO_PSRAM);
+
+    // track numbers as MOOF has them, cylinder * 2 + side, each its own entry
+    memset(tmap, 0xff, sizeof(tmap));
+    memset(trks, 0, sizeof(trks));
+    for (int c = 0; c < MAC_GCR_CYLINDERS; c++)
+    {
+        for (int s = 0; s < num_sides; s++)
+        {
+            int t = c * 2 + s;
+            tmap[t] = t;
+            trks[t].block_count = (mac_gcr_track_bits(c) + 8 * 512 - 1) / (8 * 512);
+            trks[t].bit_count = mac_gcr_encoded_bits(c);
+        }
+    }
+
+    Debug_printf("\nMediaTypeGCR %s sided, data at %lu", num_sides == 2 ? "double" : "single", offset);
+    return MEDIATYPE_MOOF;
+}
+
+uint8_t *MediaTypeGCR::get_track(int t)
+{
+    uint8_t track = tmap[t];
+    if (track == 0xFF)
+        return nullptr;
+
+    if (trk_ptrs[track] == nullptr && gcr_track(track))
+        return nullptr;
+
+    _cached.touch(track);
+    return trk_ptrs[track];
+}
+
+bool MediaTypeGCR::gcr_track(uint8_t track)
+{
+    _cached.make_room();
+
+    int cylinder = track / 2;
+    int side = track % 2;
+    size_t len = trks[track].block_count * 512;
+    size_t sectors_len = mac_gcr_sectors(cylinder) * MAC_GCR_SECTOR_SIZE;
+
+    // the whole of track_len() is copied out, so the buffer is padded to it
+    uint8_t *dest = (uint8_t *)heap_caps_malloc(len, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
+    uint8_t *src = (uint8_t *)malloc(sectors_len);
+    if (dest == nullptr || src == nullptr)
+    {
+        Debug_printf("\nNo RAM allocated!");
+        free(dest);
+        free(src);
+        return true;
+    }
+
+    uint32_t block = mac_gcr_first_block(cylinder, side, num_sides);
+    if (_media_cache.read(offset + block * MAC_GCR_SECTOR_SIZE, src, sectors_len))
+    {
+        Debug_printf("\nMediaTypeGCR couldn't read track %u", track);
+        free(dest);
+        free(src);
+        return true;
+    }
+
+    memset(dest, 0, len);
+    mac_gcr_encode_track(dest, src, cylinder, side, num_sides);
+    free(src);
+
+    trk_ptrs[track] = dest;
+    Debug_printf("\nMediaTypeGCR made track %u/%u from block %lu", cylinder, side, block);
+    return false;
+}
+
+bool MediaTypeGCR::write_track(int t, const uint8_t *bits, uint32_t num_bits)
+{
+    uint8_t track = tmap[t];
+    if (track == 0xFF)
+        return true;
+
+    int cylinder = track / 2;
+    int side = track % 2;
+    uint8_t *sectors = (uint8_t *)malloc(MAC_GCR_MAX_SECTORS * MAC_GCR_SECTOR_SIZE);
+    if (sectors == nullptr)
+        return true;
+
+    // only the sectors that decode are written, the others keep what the image has
+    uint16_t found = mac_gcr_decode_track(sectors, bits, num_bits, cylinder, side);
+    uint32_t block = mac_gcr_first_block(cylinder, side, num_sides);
+    bool err = (found == 0);
+    for (int s = 0; s < mac_gcr_sectors(cylinder) && !err; s++)
+    {
+        if (found & (1 << s))
+            err = _media_cache.write(offset + (block + s) * MAC_GCR_SECTOR_SIZE,
+                                     &sectors[s * MAC_GCR_SECTOR_SIZE], MAC_GCR_SECTOR_SIZE);
+    }
+    if (!err)
+        err = _media_cache.flush();
+    free(sectors);
+
+    // made again from the image next time the head is on it
+    _cached.drop(track);
+
+    Debug_printf("\nMediaTypeGCR wrote track %u/%u, sectors %03x%s", cylinder, side, found, err ? " FAILED" : "");
+    return err;
+}
+
+#endif // BUILD_MAC
@@ -0,0 +1,39 @@
+#ifndef _MEDIATYPE_GCR_
+#define _MEDIATYPE_GCR_
+
+#include "mediaTypeMOOF.h"
+#include "macGCR.h"
+#include "../trackLRU.h"
+
+// Tracks kept as bitstreams, the least recently used goes when another is needed
+#define GCR_CACHED_TRACKS 16
+#define GCR_CACHED_TRACKS_NO_PSRAM 4
+
+/*
+ * 400K/800K sector images, raw or Disk Copy 4.2, for the floppy rather than
+ * the DCD path. A track is made into its Sony GCR bitstream the first time
+ * the head steps onto it, so the image needs no conversion to MOOF. Tracks
+ * the computer writes are decoded back into sectors and written to the image.
+ */
+class MediaTypeGCR : public MediaTypeMOOF
+{
+private:
+    uint32_t offset = 0;
+    TrackLRU<GCR_CACHED_TRACKS> _cached{trk_ptrs}; // by cylinder * 2 + side
+
+    // Returns TRUE if an error condition occurred
+    bool gcr_track(uint8_t track);
+
+public:
+    MediaTypeGCR(int x = 0) : offset(x) {}
+
+    virtual mediatype_t mount(FILE *f, uint32_t disksize) override;
+
+    virtual uint8_t *get_track(int t) override;
+    virtual bool write_track(int t, const uint8_t *bits, uint32_t num_bits) override;
+
+    // Bytes of sector data in the image, if it is one this can mount, else 0
+    static uint32_t image_size(FILE *f, uint32_t disksize, mediatype_t disk_type);
+};
+
+#endif // _MEDIATYPE_GCR_
@@ -60,7 +60,10 @@ public:
     virtual bool status() override { return (_media_fileh != nullptr); }
 
     uint8_t trackmap(uint8_t t) { return tmap[t]; };
-    uint8_t *get_track(int t);
+    virtual uint8_t *get_track(int t);
+    // Takes back a track the computer wrote
+    // Returns TRUE if an error condition occurred
+    virtual bool write_track(int t, const uint8_t *bits, uint32_t num_bits) { return true; };
     int track_len(int t) { return trks[tmap[t]].block_count * 512; };
     int num_bits(int t) { return trks[tmap[t]].bit_count; };
     uint8_t optimal_bit_timing;
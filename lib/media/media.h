@@ -42,6 +42,7 @@
 #ifdef BUILD_MAC
 #include "mac/mediaType.h"
 #include "mac/mediaTypeMOOF.h"
+#include "mac/mediaTypeGCR.h"
 #include "mac/mediaTypeDCD.h"
 #endif
 
@@ -0,0 +1,413 @@
+
+#include "mediaCache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+#include "fnSystem.h"
+
+#include "../../include/debug.h"
+
+
+MediaCache::~MediaCache()
+{
+    // the image may already be closed, so nothing is written back here
+    invalidate();
+    if (_blocks != nullptr)
+    {
+        for (int i = 0; i < _block_count; i++)
+            free(_blocks[i].data);
+        free(_blocks);
+    }
+}
+
+// Returns TRUE if an error condition occurred
+bool MediaCache::attach(fnFile *f, uint16_t block_size, int blocks)
+{
+    if (_file != nullptr)
+        detach();
+
+    if (blocks <= 0)
+        blocks = fnSystem.get_psram_size() > 0 ? MEDIACACHE_BLOCKS : MEDIACACHE_BLOCKS_NO_PSRAM;
+
+    // block data is allocated as blocks are first used
+    if (_blocks == nullptr || blocks != _block_count || block_size != _block_size)
+    {
+        if (_blocks != nullptr)
+        {
+            for (int i = 0; i < _block_count; i++)
+                free(_blocks[i].data);
+            free(_blocks);
+        }
+        _block_count = 0;
+        _blocks = (cache_block *)calloc(blocks, sizeof(cache_block));
+        if (_blocks == nullptr)
+        {
+            Debug_println("MediaCache::attach - failed to allocate block cache");
+            return true;
+        }
+        _block_count = blocks;
+        _block_size = block_size;
+    }
+
+    _file = f;
+    invalidate();
+    reset_counters();
+    return false;
+}
+
+void MediaCache::detach()
+{
+    if (_file == nullptr)
+        return;
+
+    flush();
+    Debug_printf("MediaCache::detach hits=%lu misses=%lu readahead=%lu seeks=%lu written=%lu runs=%lu\r\n",
+                 (unsigned long)_counters.hits, (unsigned long)_counters.misses,
+                 (unsigned long)_counters.readahead, (unsigned long)_counters.seeks,
+                 (unsigned long)_counters.written, (unsigned long)_counters.runs);
+    invalidate();
+    _file = nullptr;
+}
+
+void MediaCache::invalidate()
+{
+    for (int i = 0; i < _block_count; i++)
+    {
+        _blocks[i].index = MEDIACACHE_NO_BLOCK;
+        _blocks[i].dirty = false;
+        _blocks[i].length = 0;
+    }
+    _file_pos = -1;
+    _last_miss = MEDIACACHE_NO_BLOCK;
+    _readahead = 0;
+}
+
+// Returns TRUE if an error condition occurred
+bool MediaCache::read(uint32_t offset, void *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len)
+    {
+        uint32_t index = (offset + done) / _block_size;
+        size_t in_block = (offset + done) % _block_size;
+        size_t n = _block_size - in_block;
+        if (n > len - done)
+            n = len - done;
+
+        cache_block *b = get_block(index, true);
+        if (b == nullptr)
+            return true;
+
+        if (in_block + n > b->length)
+        {
+            // short of the end of the image, or a read that failed part way,
+            // either way it is read again next time rather than kept
+            Debug_printf("MediaCache::read - offset %lu beyond image\r\n", (unsigned long)(offset + done));
+            if (!b->dirty)
+                b->index = MEDIACACHE_NO_BLOCK;
+            return true;
+        }
+
+        memcpy((uint8_t *)buf + done, b->data + in_block, n);
+        done += n;
+    }
+
+    return false;
+}
+
+// Returns TRUE if an error condition occurred
+bool MediaCache::prefetch(uint32_t offset, size_t len)
+{
+    if (len == 0 || _block_count < 2)
+        return false;
+
+    uint32_t first = offset / _block_size;
+    uint32_t last = (offset + len - 1) / _block_size;
+    if (last - first >= (uint32_t)(_block_count / 2))
+        last = first + _block_count / 2 - 1;
+
+    for (uint32_t index = first; index <= last; index++)
+    {
+        if (find_block(index) != nullptr)
+            continue;
+
+        // no room without writing back, so stop there
+        cache_block *b = take_block(false);
+        if (b == nullptr)
+            break;
+        if (fill(b, index))
+            return true;
+        _counters.readahead++;
+        if (b->length < _block_size)
+            break;
+    }
+
+    return false;
+}
+
+// Returns TRUE if an error condition occurred
+bool MediaCache::write(uint32_t offset, const void *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len)
+    {
+        uint32_t index = (offset + done) / _block_size;
+        size_t in_block = (offset + done) % _block_size;
+        size_t n = _block_size - in_block;
+        if (n > len - done)
+            n = len - done;
+
+        // a whole block replaced needs nothing from the image
+        cache_block *b = get_block(index, n != _block_size);
+        if (b == nullptr)
+            return true;
+
+        memcpy(b->data + in_block, (const uint8_t *)buf + done, n);
+        if (b->length < in_block + n)
+            b->length = in_block + n;
+        b->dirty = true;
+        done += n;
+    }
+
+    return false;
+}
+
+// Returns TRUE if an error condition occurred
+bool MediaCache::flush(fnFile *f)
+{
+    if (f == nullptr)
+        f = _file;
+    if (f == nullptr)
+        return false;
+
+    return write_back(f);
+}
+
+MediaCache::cache_block *MediaCache::find_block(uint32_t index)
+{
+    for (int i = 0; i < _block_count; i++)
+        if (_blocks[i].index == index)
+            return &_blocks[i];
+    return nullptr;
+}
+
+// block for index, read from the image on a miss if fill is set,
+// reading further ahead each time misses come in order
+MediaCache::cache_block *MediaCache::get_block(uint32_t index, bool fill)
+{
+    cache_block *b = find_block(index);
+    if (b != nullptr)
+    {
+        _counters.hits++;
+        b->used = ++_clock;
+        return b;
+    }
+
+    b = take_block(true);
+    if (b == nullptr)
+        return nullptr;
+
+    if (!fill)
+    {
+        memset(b->data, 0, _block_size);
+        b->index = index;
+        b->length = 0;
+        b->used = ++_clock;
+        return b;
+    }
+
+    if (index == _last_miss + 1)
+    {
+        _readahead = _readahead ? _readahead * 2 : 1;
+        if (_readahead > MEDIACACHE_READAHEAD_MAX)
+            _readahead = MEDIACACHE_READAHEAD_MAX;
+        // leave most of the cache to what was asked for
+        if (_readahead > _block_count / 2)
+            _readahead = _block_count / 2;
+    }
+    else
+        _readahead = 0;
+
+    _counters.misses++;
+    if (this->fill(b, index))
+        return nullptr;
+    _last_miss = index;
+
+    // the file is already there, but never write back to make room
+    for (int i = 1; i <= _readahead && b->length == _block_size; i++)
+    {
+        uint32_t next = index + i;
+        if (find_block(next) != nullptr)
+            break;
+
+        cache_block *ahead = take_block(false);
+        if (ahead == nullptr || this->fill(ahead, next))
+            break;
+        _counters.readahead++;
+        _last_miss = next;
+        if (ahead->length < _block_size)
+            break;
+    }
+
+    b->used = ++_clock;
+    return b;
+}
+
+// least recently used block, dirty blocks written back first if allowed,
+// with its data allocated and its index cleared
+MediaCache::cache_block *MediaCache::take_block(bool write_back_dirty)
+{
+    cache_block *b = nullptr;
+
+    for (int i = 0; i < _block_count; i++)
+    {
+        if (_blocks[i].index == MEDIACACHE_NO_BLOCK)
+        {
+            b = &_blocks[i];
+            break;
+        }
+        if (b == nullptr || _blocks[i].used < b->used)
+            b = &_blocks[i];
+    }
+    if (b == nullptr)
+        return nullptr;
+
+    // the whole dirty set goes back together, so it still goes in runs
+    if (b->dirty && (!write_back_dirty || write_back(_file)))
+        return nullptr;
+
+    if (b->data == nullptr)
+    {
+#ifdef ESP_PLATFORM
+        b->data = (uint8_t *)heap_caps_malloc(_block_size, MALLOC_CAP_SPIRAM);
+        if (b->data == nullptr)
+            b->data = (uint8_t *)malloc(_block_size);
+#else
+        b->data = (uint8_t *)malloc(_block_size);
+#endif
+        if (b->data == nullptr)
+        {
+            Debug_println("MediaCache::take_block - failed to allocate block");
+            return nullptr;
+        }
+    }
+
+    b->index = MEDIACACHE_NO_BLOCK;
+    b->dirty = false;
+    b->length = 0;
+    return b;
+}
+
+// fill b with block index from the image, a short block at the end of it
+// Returns TRUE if an error condition occurred
+bool MediaCache::fill(cache_block *b, uint32_t index)
+{
+    long offset = (long)index * _block_size;
+
+    if (seek_to(_file, offset))
+        return true;
+
+    size_t n = fnio::fread(b->data, 1, _block_size, _file);
+    if (n < _block_size)
+    {
+        memset(b->data + n, 0, _block_size - n);
+        // where a short read leaves the file is not certain
+        _file_pos = -1;
+    }
+    else
+        _file_pos = offset + n;
+
+    b->index = index;
+    b->length = n;
+    b->dirty = false;
+    b->used = ++_clock;
+    return false;
+}
+
+// Returns TRUE if an error condition occurred
+bool MediaCache::seek_to(fnFile *f, long offset)
+{
+    if (f == _file && offset == _file_pos)
+        return false;
+
+    _counters.seeks++;
+    if (fnio::fseek(f, offset, SEEK_SET) != 0)
+    {
+        Debug_printf("MediaCache::seek_to - seek to %ld failed\r\n", offset);
+        if (f == _file)
+            _file_pos = -1;
+        return true;
+    }
+    if (f == _file)
+        _file_pos = offset;
+    return false;
+}
+
+// write back dirty blocks in order, a seek for each contiguous run and one
+// flush for the lot, blocks that fail to go back are dropped from the cache
+// Returns TRUE if an error condition occurred
+bool MediaCache::write_back(fnFile *f)
+{
+    bool err = false;
+    uint32_t next = MEDIACACHE_NO_BLOCK;
+    int dirty = 0;
+
+    for (;;)
+    {
+        // lowest dirty block left, the cache is small enough to just look
+        cache_block *b = nullptr;
+        for (int i = 0; i < _block_count; i++)
+            if (_blocks[i].dirty && (b == nullptr || _blocks[i].index < b->index))
+                b = &_blocks[i];
+        if (b == nullptr)
+            break;
+        dirty++;
+
+        long offset = (long)b->index * _block_size;
+        if (b->index != next)
+        {
+            // always seek to start a run, stdio wants one between a read and a write
+            _counters.runs++;
+            _counters.seeks++;
+            if (fnio::fseek(f, offset, SEEK_SET) != 0)
+            {
+                err = true;
+                b->dirty = false;
+                b->index = MEDIACACHE_NO_BLOCK;
+                next = MEDIACACHE_NO_BLOCK;
+                continue;
+            }
+        }
+
+        size_t n = fnio::fwrite(b->data, 1, b->length, f);
+        b->dirty = false;
+        if (n != b->length)
+        {
+            Debug_printf("MediaCache::write_back - block %lu failed\r\n", (unsigned long)b->index);
+            err = true;
+            b->index = MEDIACACHE_NO_BLOCK;
+            next = MEDIACACHE_NO_BLOCK;
+            continue;
+        }
+        _counters.written++;
+        next = b->length == _block_size ? b->index + 1 : MEDIACACHE_NO_BLOCK;
+    }
+
+    if (dirty > 0)
+    {
+        if (fnio::fflush(f) != 0)
+            err = true;
+        // and reads seek again after writing
+        if (f == _file)
+            _file_pos = -1;
+    }
+
+    return err;
+}
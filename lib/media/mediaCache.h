@@ -0,0 +1,101 @@
+#ifndef _MEDIA_CACHE_
+#define _MEDIA_CACHE_
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "fnio.h"
+
+// Unit of caching, read-ahead and write-back
+#define MEDIACACHE_BLOCK_SIZE 1024
+// Cached blocks per mounted image, fewer when there is no PSRAM to put them in
+#define MEDIACACHE_BLOCKS 32
+#define MEDIACACHE_BLOCKS_NO_PSRAM 4
+// Most blocks read ahead of a sequential miss, the window doubles up to this
+#define MEDIACACHE_READAHEAD_MAX 8
+
+#define MEDIACACHE_NO_BLOCK 0xFFFFFFFF
+
+/*
+ * Block cache between a MediaType and its image file, shared by every
+ * platform. MediaTypes map their sectors or blocks to byte offsets and go
+ * through read() and write() here instead of fseek + fread/fwrite, so the
+ * image is read in whole cache blocks, sequential misses read ahead in a
+ * growing window, and the pieces of a write are gathered into runs of
+ * blocks that go back with one seek and one flush when the write is done.
+ */
+class MediaCache
+{
+public:
+    struct counters
+    {
+        uint32_t hits;          // blocks found in the cache
+        uint32_t misses;        // blocks that had to be read
+        uint32_t readahead;     // blocks read ahead of a miss
+        uint32_t seeks;         // seeks on the image file
+        uint32_t written;       // blocks written back
+        uint32_t runs;          // contiguous runs written back
+    };
+
+protected:
+    struct cache_block
+    {
+        uint32_t index;         // block number in the image, MEDIACACHE_NO_BLOCK if unused
+        uint8_t *data;
+        uint16_t length;        // bytes of the image in this block, short at the end of it
+        bool dirty;
+        uint32_t used;          // LRU stamp
+    };
+
+    fnFile *_file = nullptr;
+    long _file_pos = -1;        // where the image file is, -1 if not known
+
+    uint8_t *_data = nullptr;
+    cache_block *_blocks = nullptr;
+    int _block_count = 0;
+    uint16_t _block_size = MEDIACACHE_BLOCK_SIZE;
+    uint32_t _clock = 0;
+
+    uint32_t _last_miss = MEDIACACHE_NO_BLOCK;
+    int _readahead = 0;
+
+    counters _counters = {};
+
+    cache_block *find_block(uint32_t index);
+    cache_block *take_block(bool write_back_dirty);
+    cache_block *get_block(uint32_t index, bool fill);
+    bool fill(cache_block *b, uint32_t index);
+    bool write_back(fnFile *f);
+    bool seek_to(fnFile *f, long offset);
+
+public:
+    MediaCache() {};
+    ~MediaCache();
+
+    // Start caching an image, blocks = 0 picks the count for this board
+    // Returns TRUE if an error condition occurred
+    bool attach(fnFile *f, uint16_t block_size = MEDIACACHE_BLOCK_SIZE, int blocks = 0);
+    // Write back and let go of the image
+    void detach();
+    bool attached() { return _file != nullptr; }
+
+    // Returns TRUE if an error condition occurred
+    bool read(uint32_t offset, void *buf, size_t len);
+    // Bring what is not cached yet of a range in ahead of it being read, never
+    // writing back to make room, and no more than half the cache
+    // Returns TRUE if an error condition occurred
+    bool prefetch(uint32_t offset, size_t len);
+    // Data stays in the cache until flush()
+    // Returns TRUE if an error condition occurred
+    bool write(uint32_t offset, const void *buf, size_t len);
+    // Write back dirty blocks, through f when given instead of the attached file
+    // Returns TRUE if an error condition occurred
+    bool flush(fnFile *f = nullptr);
+    // Forget everything cached, without writing it back
+    void invalidate();
+
+    const counters &get_counters() { return _counters; }
+    void reset_counters() { _counters = {}; }
+};
+
+#endif // _MEDIA_CACHE_
@@ -0,0 +1,62 @@
+#include "mediaPrefetch.h"
+
+#include "fnTaskManager.h"
+
+
+class MediaPrefetchTask : public fnTask
+{
+public:
+    MediaPrefetchTask(MediaPrefetch *prefetch) : _prefetch(prefetch) {};
+    virtual ~MediaPrefetchTask() override { _prefetch->_task = nullptr; };
+
+protected:
+    MediaPrefetch *_prefetch;
+
+    virtual int start() override { return 0; };
+    virtual int step() override { return _prefetch->step(); };
+};
+
+MediaPrefetch::~MediaPrefetch()
+{
+    if (_task != nullptr)
+        taskMgr.abort_task(_tid);
+}
+
+void MediaPrefetch::read_done(uint32_t block, uint16_t count)
+{
+    bool sequential = (block == _next_read);
+    _next_read = block + count;
+    if (!sequential)
+        return;
+
+    _next = _next_read;
+    _left = count > _depth ? count : _depth;
+    if (_task == nullptr)
+    {
+        _task = new MediaPrefetchTask(this);
+        _tid = taskMgr.submit_task(_task);
+        if (_tid == 0)
+        {
+            delete _task;
+            _left = 0;
+        }
+    }
+}
+
+void MediaPrefetch::reset()
+{
+    _next_read = UINT32_MAX;
+    _left = 0;
+}
+
+// One block, 1 once there is nothing left to do
+int MediaPrefetch::step()
+{
+    if (_left == 0)
+        return 1;
+
+    _fetch(_next);
+    _next++;
+    _left--;
+    return _left == 0 ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+#ifndef _MEDIA_PREFETCH_
+#define _MEDIA_PREFETCH_
+
+#include <stdint.h>
+#include <functional>
+
+class MediaPrefetchTask;
+
+/*
+ * Read ahead for a disk device whose MediaType goes through MediaCache.
+ * The device reports each read once it has gone back to the host. When a
+ * read follows on from the last one, the blocks after it are brought into
+ * the cache by an fnTask, one block each time taskMgr is serviced. That
+ * happens between passes of the bus loop, so a command that arrives in the
+ * meantime waits for at most one block from the image.
+ */
+class MediaPrefetch
+{
+public:
+    // Brings one block of the image into the cache
+    typedef std::function<void(uint32_t block)> fetch_fn;
+
+    MediaPrefetch(uint16_t depth, fetch_fn fetch) : _fetch(fetch), _depth(depth) {};
+    ~MediaPrefetch();
+
+    // Called once count blocks from block have gone back to the host
+    void read_done(uint32_t block, uint16_t count = 1);
+    // Forget the reads so far and drop what is left to fetch, when the media goes
+    void reset();
+    bool busy() { return _left != 0; }
+
+private:
+    friend class MediaPrefetchTask;
+
+    fetch_fn _fetch;
+    uint16_t _depth;                    // blocks read ahead, or the last read's count if more
+    uint32_t _next_read = UINT32_MAX;   // block after the last one read, to spot sequential reads
+    uint32_t _next = 0;
+    uint16_t _left = 0;
+    MediaPrefetchTask *_task = nullptr;
+    uint8_t _tid = 0;
+
+    int step();
+};
+
+#endif // _MEDIA_PREFETCH_
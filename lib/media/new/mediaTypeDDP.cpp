@@ -32,16 +32,7 @@ bool MediaTypeDDP::read(uint32_t blockNum, uint16_t *readcount)
 
     memset(_media_blockbuff, 0, sizeof(_media_blockbuff));
 
-    bool err = false;
-    // Perform a seek if we're not reading the sector after the last one we read
-    if (blockNum != _media_last_block + 1)
-    {
-        uint32_t offset = _block_to_offset(blockNum);
-        err = fseek(_media_fileh, offset, SEEK_SET) != 0;
-    }
-
-    if (err == false)
-        err = fread(_media_blockbuff, 1, 1024, _media_fileh) != 1024;
+    bool err = _media_cache.read(_block_to_offset(blockNum), _media_blockbuff, 1024);
 
     if (err == false)
         _media_last_block = blockNum;
@@ -62,34 +53,14 @@ bool MediaTypeDDP::write(uint32_t blockNum, bool verify)
 
     _media_last_block = INVALID_SECTOR_VALUE;
 
-    // Perform a seek if we're writing to the sector after the last one
-    int e;
-//    if (blockNum != _media_last_block + 1)
-//    {
-        e = fseek(_media_fileh, offset, SEEK_SET);
-        if (e != 0)
-        {
-            Debug_printf("::write seek error %d\r\n", e);
-            _media_controller_status=2;
-            return true;
-        }
-//    }
-    // Write the data
-    e = fwrite(&_media_blockbuff[0], 1, 256, _media_fileh);
-    e += fwrite(&_media_blockbuff[256], 1, 256, _media_fileh);
-    e += fwrite(&_media_blockbuff[512], 1, 256, _media_fileh);
-    e += fwrite(&_media_blockbuff[768], 1, 256, _media_fileh);
-    
-    if (e != 1024)
+    // Write the data, and since we might get reset at any moment, go ahead and sync the file
+    if (_media_cache.write(offset, _media_blockbuff, 1024) || _media_cache.flush(_media_fileh))
     {
-        Debug_printf("::write error %d, %d\r\n", e, errno);
+        Debug_printf("::write error %d\r\n", errno);
+        _media_controller_status=2;
         return true;
     }
 
-    int ret = fflush(_media_fileh);    // This doesn't seem to be connected to anything in ESP-IDF VF, so it may not do anything
-    ret = fsync(fileno(_media_fileh)); // Since we might get reset at any moment, go ahead and sync the file (not clear if fflush does this)
-    Debug_printf("DDP::write fsync:%d\r\n", ret);
-
     _media_last_block = INVALID_SECTOR_VALUE;
     _media_controller_status=0;
     return false;
@@ -111,6 +82,7 @@ mediatype_t MediaTypeDDP::mount(FILE *f, uint32_t disksize)
     Debug_print("DDP MOUNT\r\n");
 
     _media_fileh = f;
+    _media_cache.attach(f);
     _mediatype = MEDIATYPE_DDP;
     _media_num_blocks = disksize / 1024;
 
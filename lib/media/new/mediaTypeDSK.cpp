@@ -44,19 +44,12 @@ bool MediaTypeDSK::read(uint32_t blockNum, uint16_t *readcount)
 
     bool err = false;
 
-    // Read lower part of block    
-    std::pair <uint32_t, uint32_t> offsets = _block_to_offsets(blockNum);
-    err = fseek(_media_fileh, offsets.first, SEEK_SET) != 0;
-
-    if (err == false)
-        err = fread(_media_blockbuff, 1, 512, _media_fileh) != 512;
-
-   // Read upper part of block
-    if (err == false)
-        err = fseek(_media_fileh, offsets.second, SEEK_SET) != 0;
+    // Read lower and upper parts of block
+    std::pair<uint32_t, uint32_t> offsets = _block_to_offsets(blockNum);
+    err = _media_cache.read(offsets.first, _media_blockbuff, 512);
 
     if (err == false)
-        err = fread(&_media_blockbuff[512],1,512,_media_fileh) != 512;
+        err = _media_cache.read(offsets.second, &_media_blockbuff[512], 512);
 
     if (err == false)
         _media_last_block = blockNum;
@@ -84,20 +77,15 @@ bool MediaTypeDSK::write(uint32_t blockNum, bool verify)
 
     std::pair <uint32_t, uint32_t> offsets = _block_to_offsets(blockNum);
 
-    // Write lower part of block
-    err = fseek(_media_fileh, offsets.first, SEEK_SET) != 0;
+    // Write lower and upper parts of block, they go back together with the flush
+    err = _media_cache.write(offsets.first, _media_blockbuff, 512);
     if (err == false)
-        err = fwrite(_media_blockbuff,1,512,_media_fileh) != 512;
-    
-    // Write upper part of block
-    if (err == false)
-        err = fseek(_media_fileh, offsets.second, SEEK_SET) != 0;
-    if (err == false)
-        err = fwrite(&_media_blockbuff[512],1,512,_media_fileh) != 512;
+        err = _media_cache.write(offsets.second, &_media_blockbuff[512], 512);
 
-    int ret = fflush(_media_fileh);    // This doesn't seem to be connected to anything in ESP-IDF VF, so it may not do anything
-    ret = fsync(fileno(_media_fileh)); // Since we might get reset at any moment, go ahead and sync the file (not clear if fflush does this)
-    Debug_printf("DSK::write fsync:%d\r\n", ret);
+    // Since we might get reset at any moment, go ahead and sync the file
+    if (err == false)
+        err = _media_cache.flush(_media_fileh);
+    Debug_printf("DSK::write flush:%d\r\n", err);
 
     _media_controller_status=0;
 
@@ -123,6 +111,7 @@ mediatype_t MediaTypeDSK::mount(FILE *f, uint32_t disksize)
     Debug_print("DSK MOUNT\r\n");
 
     _media_fileh = f;
+    _media_cache.attach(f);
     _mediatype = MEDIATYPE_DSK;
     _media_num_blocks = disksize / 1024;
     Debug_printf("_media_num_blocks %lu\r\n",_media_num_blocks);
@@ -3,6 +3,8 @@
 
 #include <string>
 
+#include "../mediaCache.h"
+
 #define INVALID_SECTOR_VALUE 0xFFFFFFFF
 
 #define DISK_BYTES_PER_SECTOR_SINGLE 512
@@ -29,6 +31,7 @@ class MediaType
 {
 protected:
     FILE *_media_fileh = nullptr;
+    MediaCache _media_cache;
     uint32_t _media_image_size = 0;
     uint32_t _media_num_sectors = 0;
     uint16_t _media_sector_size = DISK_BYTES_PER_SECTOR_SINGLE;
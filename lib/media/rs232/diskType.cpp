@@ -55,6 +55,7 @@ void MediaType::unmount()
 {
     if (_disk_fileh != nullptr)
     {
+        _disk_cache.detach();
         fclose(_disk_fileh);
         _disk_fileh = nullptr;
     }
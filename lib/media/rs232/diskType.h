@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 
+#include "../mediaCache.h"
+
 #define INVALID_SECTOR_VALUE 65536
 
 #define DISK_SECTORBUF_SIZE 512
@@ -41,6 +43,7 @@ class MediaType
 {
 protected:
     FILE *_disk_fileh = nullptr;
+    MediaCache _disk_cache;
     uint32_t _disk_image_size = 0;
     uint32_t _disk_num_sectors = 0;
     uint16_t _disk_sector_size = DISK_BYTES_PER_SECTOR_SINGLE;
@@ -37,16 +37,7 @@ bool MediaTypeImg::read(uint16_t sectornum, uint16_t *readcount)
 
     memset(_disk_sectorbuff, 0, sizeof(_disk_sectorbuff));
 
-    bool err = false;
-    // Perform a seek if we're not reading the sector after the last one we read
-    if (sectornum != _disk_last_sector + 1)
-    {
-        uint32_t offset = _sector_to_offset(sectornum);
-        err = fseek(_disk_fileh, offset, SEEK_SET) != 0;
-    }
-
-    if (err == false)
-        err = fread(_disk_sectorbuff, 1, sectorSize, _disk_fileh) != sectorSize;
+    bool err = _disk_cache.read(_sector_to_offset(sectornum), _disk_sectorbuff, sectorSize);
 
     if (err == false)
         _disk_last_sector = sectornum;
@@ -75,29 +66,13 @@ bool MediaTypeImg::write(uint16_t sectornum, bool verify)
 
     _disk_last_sector = INVALID_SECTOR_VALUE;
 
-    // Perform a seek if we're writing to the sector after the last one
-    int e;
-    if (sectornum != _disk_last_sector + 1)
+    // Write the data, and since we might get reset at any moment, go ahead and sync the file
+    if (_disk_cache.write(offset, _disk_sectorbuff, sectorSize) || _disk_cache.flush())
     {
-        e = fseek(_disk_fileh, offset, SEEK_SET);
-        if (e != 0)
-        {
-            Debug_printf("::write seek error %d\r\n", e);
-            return true;
-        }
-    }
-    // Write the data
-    e = fwrite(_disk_sectorbuff, 1, sectorSize, _disk_fileh);
-    if (e != sectorSize)
-    {
-        Debug_printf("::write error %d, %d\r\n", e, errno);
+        Debug_printf("::write error %d\r\n", errno);
         return true;
     }
 
-    int ret = fflush(_disk_fileh);    // This doesn't seem to be connected to anything in ESP-IDF VF, so it may not do anything
-    ret = fsync(fileno(_disk_fileh)); // Since we might get reset at any moment, go ahead and sync the file (not clear if fflush does this)
-    Debug_printf("IMG::write fsync:%d\r\n", ret);
-
     _disk_last_sector = sectornum;
 
     return false;
@@ -158,6 +133,7 @@ mediatype_t MediaTypeImg::mount(FILE *f, uint32_t disksize)
     Debug_print("IMG MOUNT\r\n");
 
     _disk_fileh = f;
+    _disk_cache.attach(f);
     _disk_num_sectors = disksize / 512;
     _disktype = MEDIATYPE_IMG;
 
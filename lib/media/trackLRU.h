@@ -0,0 +1,70 @@
+#ifndef _MEDIA_TRACKLRU_
+#define _MEDIA_TRACKLRU_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Which of an image's track bitstreams are made, most recently used first.
+ * Images that make a track the first time the head steps onto it keep only
+ * the last few, so making one more frees the track used longest ago. The
+ * buffers are the image's own trk_ptrs, freed here when a track goes.
+ */
+template <int N>
+class TrackLRU
+{
+private:
+    uint8_t **_ptrs;
+    uint8_t _tracks[N];
+    int _count = 0;
+    int _max = N;
+
+public:
+    TrackLRU(uint8_t **ptrs) : _ptrs(ptrs) {}
+
+    // At mount, starts with no tracks and keeps at most max of them
+    void reset(int max)
+    {
+        _count = 0;
+        _max = max < N ? max : N;
+    }
+
+    // Frees the least recently used track if there is no room to make another
+    void make_room()
+    {
+        if (_count >= _max)
+            drop(_tracks[_count - 1]);
+    }
+
+    // Moves the track to the front, adding it if it isn't there
+    void touch(uint8_t track)
+    {
+        int i = 0;
+        while (i < _count && _tracks[i] != track)
+            i++;
+        if (i == _count)
+            _count++;
+        memmove(&_tracks[1], &_tracks[0], i);
+        _tracks[0] = track;
+    }
+
+    // Frees the track's bitstream so it is made again next time
+    void drop(uint8_t track)
+    {
+        free(_ptrs[track]);
+        _ptrs[track] = nullptr;
+
+        for (int i = 0; i < _count; i++)
+        {
+            if (_tracks[i] == track)
+            {
+                memmove(&_tracks[i], &_tracks[i + 1], _count - i - 1);
+                _count--;
+                break;
+            }
+        }
+    }
+};
+
+#endif // _MEDIA_TRACKLRU_
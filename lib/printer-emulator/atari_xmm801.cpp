@@ -52,17 +52,23 @@ void xmm801::pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2)
 
             if (epson_font_mask & fnt_proportional)
             {
-                fprintf(_file, " )%d(", (int)(280 - epson_cmd.cmd * 40));
+                pdf_puts(" )");
+                pdf_put_int((int)(280 - epson_cmd.cmd * 40));
+                pdf_putc('(');
                 pdf_X += 0.48 * (double)epson_cmd.cmd;
             }
             else if (epson_font_mask & fnt_compressed)
             {
-                fprintf(_file, " )%d(", (int)(360 - epson_cmd.cmd * 40)); // need correct value for 16.7 CPI
+                pdf_puts(" )");
+                pdf_put_int((int)(360 - epson_cmd.cmd * 40)); // need correct value for 16.7 CPI
+                pdf_putc('(');
                 pdf_X += 0.48 * (double)epson_cmd.cmd;
             }
             else
             {
-                fprintf(_file, " )%d(", (int)(600 - epson_cmd.cmd * 60)); // need correct value for 10 CPI
+                pdf_puts(" )");
+                pdf_put_int((int)(600 - epson_cmd.cmd * 60)); // need correct value for 10 CPI
+                pdf_putc('(');
                 pdf_X += 0.72 * (double)epson_cmd.cmd;
             }
 
@@ -283,7 +289,9 @@ void xmm801::pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2)
                 default:
                     charWidth = 1.2;
                 }
-                fprintf(_file, ")]TJ /F%d 9 Tf 100 Tz [(", NUMFONTS); // set font to GFX mode
+                pdf_puts(")]TJ /F"); // set font to GFX mode
+                pdf_put_int(NUMFONTS);
+                pdf_puts(" 9 Tf 100 Tz [(");
                 fontUsed[NUMFONTS - 1] = true;
             }
 
@@ -297,13 +305,13 @@ void xmm801::pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2)
                 //case 'L': // Sets dot graphics mode to 960 dots per 8" line
                 //case 'Y': // on FX-80 this is double speed but with gotcha
                 case 'V': // XMM
-                    fprintf(_file, ")66.5(");
+                    pdf_puts(")66.5(");
                     break;
                     //case 'Z': // on FX-80 this is double speed but with gotcha
-                    //    fprintf(_file, ")99.75(");
+                    //    pdf_puts(")99.75(");
                     //    break;
                 }
-                //fprintf(_file, "]TJ [(");
+                //pdf_puts("]TJ [(");
                 if (epson_cmd.ctr == (epson_cmd.N + 2))
                 {
                     // reset font
@@ -416,7 +424,9 @@ void xmm801::pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2)
             One quirk in using the backspace. In expanded mode, CHR$(8) causes a full double
             width backspace as we would expect. The fun begins when several backspaces
             are done in succession. All except for the first one are normal-width backspaces */
-            fprintf(_file, ")%d(", (int)(charWidth / lineHeight * 900.));
+            pdf_putc(')');
+            pdf_put_int((int)(charWidth / lineHeight * 900.));
+            pdf_putc('(');
             pdf_X -= charWidth; // update x position
             // XMM
             break;
@@ -531,15 +541,15 @@ void xmm801::pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2)
                     }
                 if (valid)
                 {
-                    fputc(d, _file);
+                    pdf_putc(d);
                     pdf_X += charWidth; // update x position
                 }
             }
             else if (c > 31 && c < 127)
             {
                 if (c == '\\' || c == '(' || c == ')')
-                    fputc('\\', _file);
-                fputc(c, _file);
+                    pdf_putc('\\');
+                pdf_putc(c);
                 pdf_X += charWidth; // update x position
             }
             // if (c > 31) // && c < 127)
@@ -551,8 +561,8 @@ void xmm801::pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2)
             //         epson_set_font(new_F, new_w);
             //     }
             //     if (c == '\\' || c == '(' || c == ')')
-            //         fputc('\\', _file);
-            //     fputc(c, _file);
+            //         pdf_putc('\\');
+            //     pdf_putc(c);
             //     pdf_X += charWidth; // update x position
             // }
             break;
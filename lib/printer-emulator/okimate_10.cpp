@@ -63,9 +63,9 @@ void okimate10::fprint_color_array(uint8_t font_mask)
 {
     for (int i = 0; i < 4; i++)
     {
-        fprintf(_file, " %d", (font_mask >> (i + 4) & 0x01));
+        pdf_puts((font_mask >> (i + 4) & 0x01) ? " 1" : " 0");
     }
-    fprintf(_file, " k ");
+    pdf_puts(" k ");
 }
 
 void okimate10::okimate_set_char_width()
@@ -114,14 +114,14 @@ void okimate10::okimate_handle_font()
         return;
 
     if (!BOLflag)
-        fprintf(_file, ")]TJ\n ");
+        pdf_puts(")]TJ\n ");
 
     if (okimate_new_fnt_mask & fnt_gfx)
     {
         if (fnt_is_invalid || !(okimate_current_fnt_mask & fnt_gfx))
         {
             charWidth = 1.2;
-            fprintf(_file, "/F2 12 Tf 100 Tz"); // set font to GFX mode
+            pdf_puts("/F2 12 Tf 100 Tz"); // set font to GFX mode
             fontUsed[1] = true;
         }
     }
@@ -129,7 +129,9 @@ void okimate10::okimate_handle_font()
     {
         okimate_set_char_width();
         double w = font_widths[okimate_new_fnt_mask & 0x03];
-        fprintf(_file, "/F1 12 Tf %g Tz", w);
+        pdf_puts("/F1 12 Tf ");
+        pdf_put_num(w);
+        pdf_puts(" Tz");
     }
 
     // check and change color or reset font color when leaving REVERSE mode
@@ -144,10 +146,15 @@ void okimate10::okimate_handle_font()
     {
         // make a rectangle "x y l w re f"
         fprint_color_array(okimate_current_fnt_mask);
-        fprintf(_file, "%g %g %g 7 re f 0 0 0 0 k ", pdf_X + leftMargin, pdf_Y, charWidth);
+        pdf_put_num(pdf_X + leftMargin);
+        pdf_putc(' ');
+        pdf_put_num(pdf_Y);
+        pdf_putc(' ');
+        pdf_put_num(charWidth);
+        pdf_puts(" 7 re f 0 0 0 0 k ");
     }
 
-    fprintf(_file, " [(");
+    pdf_puts(" [(");
 }
 
 uint16_t okimate10::okimate_cmd_ascii_to_int(uint8_t c)
@@ -170,11 +177,14 @@ void okimate10::print_7bit_gfx(uint8_t c)
     // e.g., [(0)99(1)99(4)99(50)]TJ
     // lead with '0' to enter a space
     // then shift back with 100 and print each pin
-    fprintf(_file, "0");
+    pdf_puts("0");
     for (unsigned i = 0; i < 7; i++)
     {
         if ((c >> (6 - i)) & 0x01) // have the gfx font points backwards or Okimate dot-graphics are upside down
-            fprintf(_file, ")99(%u", i + 1);
+        {
+            pdf_puts(")99(");
+            pdf_put_int(i + 1);
+        }
     }
 }
 
@@ -247,7 +257,7 @@ void okimate10::okimate_output_color_line()
                     set_mode(fnt_C | fnt_M | fnt_Y);
                     okimate_handle_font();
                     print_7bit_gfx(c);
-                    fprintf(_file, ")99(");
+                    pdf_puts(")99(");
                 }
                 // 110 Y&M
                 c = color_buffer[i][1] & color_buffer[i][2] & ~color_buffer[i][3];
@@ -257,7 +267,7 @@ void okimate10::okimate_output_color_line()
                     clear_mode(fnt_C);
                     okimate_handle_font();
                     print_7bit_gfx(c);
-                    fprintf(_file, ")99(");
+                    pdf_puts(")99(");
                 }
                 // 101 C&Y
                 c = color_buffer[i][1] & ~color_buffer[i][2] & color_buffer[i][3];
@@ -267,7 +277,7 @@ void okimate10::okimate_output_color_line()
                     clear_mode(fnt_M);
                     okimate_handle_font();
                     print_7bit_gfx(c);
-                    fprintf(_file, ")99(");
+                    pdf_puts(")99(");
                 }
                 // 110 M&C
                 c = ~color_buffer[i][1] & color_buffer[i][2] & color_buffer[i][3];
@@ -277,7 +287,7 @@ void okimate10::okimate_output_color_line()
                     clear_mode(fnt_Y);
                     okimate_handle_font();
                     print_7bit_gfx(c);
-                    fprintf(_file, ")99(");
+                    pdf_puts(")99(");
                 }
                 // 100 Y
                 c = color_buffer[i][1] & ~color_buffer[i][2] & ~color_buffer[i][3];
@@ -287,7 +297,7 @@ void okimate10::okimate_output_color_line()
                     clear_mode(fnt_C | fnt_M);
                     okimate_handle_font();
                     print_7bit_gfx(c);
-                    fprintf(_file, ")99(");
+                    pdf_puts(")99(");
                 }
                 // 010 M
                 c = ~color_buffer[i][1] & color_buffer[i][2] & ~color_buffer[i][3];
@@ -297,7 +307,7 @@ void okimate10::okimate_output_color_line()
                     clear_mode(fnt_C | fnt_Y);
                     okimate_handle_font();
                     print_7bit_gfx(c);
-                    fprintf(_file, ")99(");
+                    pdf_puts(")99(");
                 }
                 // 001 C
                 c = ~color_buffer[i][1] & ~color_buffer[i][2] & color_buffer[i][3];
@@ -307,9 +317,9 @@ void okimate10::okimate_output_color_line()
                     clear_mode(fnt_M | fnt_Y);
                     okimate_handle_font();
                     print_7bit_gfx(c);
-                    fprintf(_file, ")99(");
+                    pdf_puts(")99(");
                 }
-                fprintf(_file, " ");
+                pdf_puts(" ");
                 pdf_X += charWidth;
             }
             else
@@ -347,10 +357,10 @@ void okimate10::okimate_output_color_line()
     //okimate_current_fnt_mask = 0xFF;
     okimate_new_fnt_mask = 0x80; // set color back to
     Debug_println("Color output line complete");
-    fprintf(_file, ")]TJ\r\n"); // close the line
+    pdf_puts(")]TJ\r\n"); // close the line
     pdf_X = 0;                // CR
     pdf_clear_modes();
-    fprintf(_file, "0 0 Td [(");
+    pdf_puts("0 0 Td [(");
     BOLflag = false;
     //pdf_end_line();
     //pdf_new_line();
@@ -448,7 +458,7 @@ void okimate10::pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2)
                 set_mode(fnt_gfx);
                 clear_mode(fnt_compressed | fnt_inverse | fnt_expanded); // may not be necessary
                 // charWidth = 1.2;
-                // fprintf(_file, ")]TJ /F2 12 Tf 100 Tz [("); // set font to GFX mode
+                // pdf_puts(")]TJ /F2 12 Tf 100 Tz [("); // set font to GFX mode
                 // fontUsed[1] = true;
                 // do I need to write out new font now? How to handle switchting to color mode after gfx?
                 // need to catch 0x99 while in 0x25 esc mode!
@@ -647,7 +657,7 @@ void okimate10::pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2)
                     uint8_t M = N - uint8_t(pdf_X / 1.2);
                     for (int i = 1; i < M; i++) // i=1 for BW on D:LEARN
                     {
-                        fprintf(_file, " ");
+                        pdf_puts(" ");
                         pdf_X += charWidth;
                     }
                 }
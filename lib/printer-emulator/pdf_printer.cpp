@@ -1,22 +1,148 @@
 #include "pdf_printer.h"
 
+#include <cstring>
+
 #include "../../include/debug.h"
 
 #include "fsFlash.h"
 
 #include "utils.h"
 
+void pdfPrinter::pdf_flush()
+{
+    if (_pdf_outlen == 0)
+        return;
+
+    if (_file == nullptr)
+        Debug_printf("pdf flush: no output file, dropping %u bytes\r\n", (unsigned)_pdf_outlen);
+    else
+        fwrite(_pdf_outbuf, 1, _pdf_outlen, _file);
+
+    _pdf_offset += _pdf_outlen;
+    _pdf_outlen = 0;
+}
+
+void pdfPrinter::pdf_write(const void *data, size_t len)
+{
+    const uint8_t *src = (const uint8_t *)data;
+    while (len > 0)
+    {
+        if (_pdf_outlen == PDF_OUTBUF_SIZE)
+            pdf_flush();
+        size_t n = PDF_OUTBUF_SIZE - _pdf_outlen;
+        if (n > len)
+            n = len;
+        memcpy(_pdf_outbuf + _pdf_outlen, src, n);
+        _pdf_outlen += n;
+        src += n;
+        len -= n;
+    }
+}
+
+// Copy len bytes from f straight into the output buffer
+void pdfPrinter::pdf_copy_from(FILE *f, size_t len)
+{
+    while (len > 0)
+    {
+        if (_pdf_outlen == PDF_OUTBUF_SIZE)
+            pdf_flush();
+        size_t n = PDF_OUTBUF_SIZE - _pdf_outlen;
+        if (n > len)
+            n = len;
+        n = fread(_pdf_outbuf + _pdf_outlen, 1, n, f);
+        if (n == 0)
+            break;
+        _pdf_outlen += n;
+        len -= n;
+    }
+}
+
+void pdfPrinter::pdf_puts(const char *s)
+{
+    pdf_write(s, strlen(s));
+}
+
+void pdfPrinter::pdf_put_int(int n)
+{
+    char tmp[12];
+    char *p = tmp + sizeof(tmp);
+    unsigned u = n < 0 ? 0U - (unsigned)n : (unsigned)n;
+    do
+    {
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (u > 0);
+    if (n < 0)
+        *--p = '-';
+    pdf_write(p, tmp + sizeof(tmp) - p);
+}
+
+// Stand-in for "%g": up to three decimals, trailing zeros dropped
+void pdfPrinter::pdf_put_num(double n)
+{
+    char tmp[24];
+    char *p = tmp + sizeof(tmp);
+    bool neg = n < 0;
+    uint32_t scaled = (uint32_t)((neg ? -n : n) * 1000. + .5);
+    uint32_t ipart = scaled / 1000;
+    uint32_t fpart = scaled % 1000;
+
+    if (fpart != 0)
+    {
+        int digits = 3;
+        while (fpart % 10 == 0)
+        {
+            fpart /= 10;
+            digits--;
+        }
+        while (digits-- > 0)
+        {
+            *--p = '0' + fpart % 10;
+            fpart /= 10;
+        }
+        *--p = '.';
+    }
+    do
+    {
+        *--p = '0' + ipart % 10;
+        ipart /= 10;
+    } while (ipart > 0);
+    if (neg && scaled != 0)
+        *--p = '-';
+    pdf_write(p, tmp + sizeof(tmp) - p);
+}
+
+// Stand-in for "%02X"
+void pdfPrinter::pdf_put_hex(uint8_t n)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    char tmp[2] = {digits[n >> 4], digits[n & 0x0f]};
+    pdf_write(tmp, 2);
+}
+
+void pdfPrinter::pdf_mark_object(int obj)
+{
+    if (objLocations.size() <= (size_t)obj)
+        objLocations.resize(obj + 1, 0);
+    objLocations[obj] = pdf_tell();
+}
+
 void pdfPrinter::pdf_header()
 {
     Debug_println("pdf header");
     pdf_Y = 0;
     pdf_X = 0;
     pdf_pageCounter = 0;
-    fprintf(_file, "%%PDF-1.4\n");
+    pageObjects.clear();
+    objLocations.clear();
+    // new document: start filling the output buffer from file offset 0
+    _pdf_outlen = 0;
+    _pdf_offset = 0;
+    pdf_puts("%PDF-1.4\n");
     // first object: catalog of pages
     pdf_objCtr = 1;
-    objLocations[pdf_objCtr] = ftell(_file);
-    fprintf(_file, "1 0 obj\n<</Type /Catalog /Pages 2 0 R>>\nendobj\n");
+    pdf_mark_object(pdf_objCtr);
+    pdf_puts("1 0 obj\n<</Type /Catalog /Pages 2 0 R>>\nendobj\n");
     // object 2 0 R is printed by pdf_page_resource() before xref
     // object 3 0 R is printed at pdf_font_resource() before xref
     pdf_objCtr = 3; // set up counter for pdf_add_font()
@@ -24,21 +150,24 @@ void pdfPrinter::pdf_header()
 
 void pdfPrinter::pdf_page_resource()
 {
-    objLocations[2] = ftell(_file); // hard code page catalog as object #2
-    fprintf(_file, "2 0 obj\n<</Type /Pages /Kids [ ");
+    pdf_mark_object(2); // hard code page catalog as object #2
+    pdf_puts("2 0 obj\n<</Type /Pages /Kids [ ");
     for (int i = 0; i < pdf_pageCounter; i++)
     {
-        fprintf(_file, "%d 0 R ", pageObjects[i]);
+        pdf_put_int(pageObjects[i]);
+        pdf_puts(" 0 R ");
     }
-    fprintf(_file, "] /Count %d>>\nendobj\n", pdf_pageCounter);
+    pdf_puts("] /Count ");
+    pdf_put_int(pdf_pageCounter);
+    pdf_puts(">>\nendobj\n");
 }
 
 void pdfPrinter::pdf_font_resource()
 {
     int fntCtr = 0;
-    objLocations[3] = ftell(_file);
+    pdf_mark_object(3);
     // font catalog
-    fprintf(_file, "3 0 obj\n<</Font <<");
+    pdf_puts("3 0 obj\n<</Font <<");
     for (int i = 0; i < MAXFONTS; i++)
     {
         if (fontUsed[i])
@@ -48,11 +177,15 @@ void pdfPrinter::pdf_font_resource()
             //  font descriptor
             //  font widths
             //  font file
-            fprintf(_file, "/F%d %d 0 R ", i + 1, pdf_objCtr + 1 + fntCtr * 4); /// F1 4 0 R /F2 8 0 R>>>>\nendobj\n
+            pdf_puts("/F"); /// F1 4 0 R /F2 8 0 R>>>>\nendobj\n
+            pdf_put_int(i + 1);
+            pdf_putc(' ');
+            pdf_put_int(pdf_objCtr + 1 + fntCtr * 4);
+            pdf_puts(" 0 R ");
             fntCtr++;
         }
     }
-    fprintf(_file, ">>>>\nendobj\n");
+    pdf_puts(">>>>\nendobj\n");
 }
 
 void pdfPrinter::pdf_add_fonts() // pdfFont_t *fonts[],
@@ -77,92 +210,65 @@ void pdfPrinter::pdf_add_fonts() // pdfFont_t *fonts[],
         // assign fontObjPos[] matrix
         if (fontUsed[i])
         {
+            // each "%d" placeholder in the font file is replaced by an object number,
+            // the bytes in between are copied through in bulk
             size_t fp = 0;
             char fname[30];                                        // filename: /f/shortname/Fi
             sprintf(fname, "/f/%s/F%d", shortname.c_str(), i + 1); // e.g. /f/a820/F2
             FILE *fff = fsFlash.file_open(fname);                 // Font File File - fff
 
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
+            fseek(fff, 2, SEEK_CUR); // '%d'
+            fp += 2;
             pdf_objCtr++; // = 6;
-            objLocations[pdf_objCtr] = ftell(_file);
-            fprintf(_file, "%d", pdf_objCtr); // 6
-            while (fp < fontObjPos[0])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            fprintf(_file, "%d", pdf_objCtr + 1); // 7
-            while (fp < fontObjPos[1])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            fprintf(_file, "%d", pdf_objCtr + 3); // 9
-            while (fp < fontObjPos[2])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
+            pdf_mark_object(pdf_objCtr);
+            pdf_put_int(pdf_objCtr); // 6
+            pdf_copy_from(fff, fontObjPos[0] - fp);
+            fp = fontObjPos[0];
+
+            fseek(fff, 2, SEEK_CUR); // '%d'
+            fp += 2;
+            pdf_put_int(pdf_objCtr + 1); // 7
+            pdf_copy_from(fff, fontObjPos[1] - fp);
+            fp = fontObjPos[1];
+
+            fseek(fff, 2, SEEK_CUR); // '%d'
+            fp += 2;
+            pdf_put_int(pdf_objCtr + 3); // 9
+            pdf_copy_from(fff, fontObjPos[2] - fp);
+            fp = fontObjPos[2];
+
+            fseek(fff, 2, SEEK_CUR); // '%d'
+            fp += 2;
             pdf_objCtr++; // = 7;
-            objLocations[pdf_objCtr] = ftell(_file);
-            fprintf(_file, "%d", pdf_objCtr); // 7
-            while (fp < fontObjPos[3])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            fprintf(_file, "%d", pdf_objCtr + 1); // 8
-            while (fp < fontObjPos[4])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
+            pdf_mark_object(pdf_objCtr);
+            pdf_put_int(pdf_objCtr); // 7
+            pdf_copy_from(fff, fontObjPos[3] - fp);
+            fp = fontObjPos[3];
+
+            fseek(fff, 2, SEEK_CUR); // '%d'
+            fp += 2;
+            pdf_put_int(pdf_objCtr + 1); // 8
+            pdf_copy_from(fff, fontObjPos[4] - fp);
+            fp = fontObjPos[4];
+
+            fseek(fff, 2, SEEK_CUR); // '%d'
+            fp += 2;
             pdf_objCtr++; // = 8;
-            objLocations[pdf_objCtr] = ftell(_file);
-            fprintf(_file, "%d", pdf_objCtr); // 8
-            while (fp < fontObjPos[5])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
+            pdf_mark_object(pdf_objCtr);
+            pdf_put_int(pdf_objCtr); // 8
+            pdf_copy_from(fff, fontObjPos[5] - fp);
+            fp = fontObjPos[5];
+
+            fseek(fff, 2, SEEK_CUR); // '%d'
+            fp += 2;
             pdf_objCtr++; // = 9;
-            objLocations[pdf_objCtr] = ftell(_file);
-            fprintf(_file, "%d", pdf_objCtr); // 9
+            pdf_mark_object(pdf_objCtr);
+            pdf_put_int(pdf_objCtr); // 9
             // insert rest of file
-            while (fp < fontObjPos[6]) //(fff.available())
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
+            pdf_copy_from(fff, fontObjPos[6] - fp);
+
             fclose(fff);
-            fputc('\n', _file); // make sure there's a seperator
+            pdf_putc('\n'); // make sure there's a seperator
         }
         else
             Debug_print("unused; ");
@@ -176,19 +282,25 @@ void pdfPrinter::pdf_new_page()
 { // open a new page
     Debug_println("pdf new page");
     pdf_objCtr++;
-    pageObjects[pdf_pageCounter] = pdf_objCtr;
-    objLocations[pdf_objCtr] = ftell(_file);
-    fprintf(_file, "%d 0 obj\n<</Type /Page /Parent 2 0 R /Resources 3 0 R /MediaBox [0 0 %g %g] /Contents [ ", pdf_objCtr, pageWidth, pageHeight);
+    pageObjects.push_back(pdf_objCtr);
+    pdf_mark_object(pdf_objCtr);
+    pdf_put_int(pdf_objCtr);
+    pdf_puts(" 0 obj\n<</Type /Page /Parent 2 0 R /Resources 3 0 R /MediaBox [0 0 ");
+    pdf_put_num(pageWidth);
+    pdf_putc(' ');
+    pdf_put_num(pageHeight);
+    pdf_puts("] /Contents [ ");
     pdf_objCtr++; // increment for the contents stream object
-    fprintf(_file, "%d 0 R ", pdf_objCtr);
-    fprintf(_file, "]>>\nendobj\n");
+    pdf_put_int(pdf_objCtr);
+    pdf_puts(" 0 R ]>>\nendobj\n");
 
-    // open content stream
-    objLocations[pdf_objCtr] = ftell(_file);
-    fprintf(_file, "%d 0 obj\n<</Length ", pdf_objCtr);
-    idx_stream_length = ftell(_file);
-    fprintf(_file, "0000000000 >>\nstream\n");
-    idx_stream_start = ftell(_file);
+    // open content stream, its length is the object that follows it (see pdf_end_page)
+    pdf_mark_object(pdf_objCtr);
+    pdf_put_int(pdf_objCtr);
+    pdf_puts(" 0 obj\n<</Length ");
+    pdf_put_int(pdf_objCtr + 1);
+    pdf_puts(" 0 R>>\nstream\n");
+    idx_stream_start = pdf_tell();
 
     // open new text object
     pdf_begin_text(pageHeight - topMargin);
@@ -198,10 +310,19 @@ void pdfPrinter::pdf_begin_text(double Y)
 {
     Debug_println("pdf begin text");
     // open new text object
-    fprintf(_file, "BT\n");
+    pdf_puts("BT\n");
     TOPflag = false;
-    fprintf(_file, "/F%u %g Tf %d Tz\n", fontNumber, fontSize, fontHorizScale);
-    fprintf(_file, "%g %g Td\n", leftMargin, Y);
+    pdf_puts("/F");
+    pdf_put_int(fontNumber);
+    pdf_putc(' ');
+    pdf_put_num(fontSize);
+    pdf_puts(" Tf ");
+    pdf_put_int(fontHorizScale);
+    pdf_puts(" Tz\n");
+    pdf_put_num(leftMargin);
+    pdf_putc(' ');
+    pdf_put_num(Y);
+    pdf_puts(" Td\n");
     pdf_Y = Y; // reset print roller to top of page
     pdf_X = 0; // set carriage to LHS
     BOLflag = true;
@@ -213,11 +334,13 @@ void pdfPrinter::pdf_new_line()
 
     // position new line and start text string array
     if (pdf_dY != 0)
-        fprintf(_file, "0 Ts ");
+        pdf_puts("0 Ts ");
 #if !defined(BUILD_APPLE) && !defined(BUILD_RC2014)
     pdf_dY -= lineHeight;
 #endif
-    fprintf(_file, "0 %g Td [(", pdf_dY);
+    pdf_puts("0 ");
+    pdf_put_num(pdf_dY);
+    pdf_puts(" Td [(");
     pdf_Y += pdf_dY; // line feed
     pdf_dY = 0;
     // pdf_X = 0;              // CR over in end line()
@@ -227,7 +350,7 @@ void pdfPrinter::pdf_new_line()
 void pdfPrinter::pdf_end_line()
 {
     Debug_println("pdf end line");
-    fprintf(_file, ")]TJ\n"); // close the line
+    pdf_puts(")]TJ\n"); // close the line
     // pdf_Y -= lineHeight; // line feed - moved to new line()
     pdf_X = 0; // CR
     BOLflag = true;
@@ -237,7 +360,9 @@ void pdfPrinter::pdf_end_line()
 
 void pdfPrinter::pdf_set_rise()
 {
-    fprintf(_file, ")]TJ %g Ts [(", pdf_dY);
+    pdf_puts(")]TJ ");
+    pdf_put_num(pdf_dY);
+    pdf_puts(" Ts [(");
 }
 
 void pdfPrinter::pdf_end_page()
@@ -246,15 +371,17 @@ void pdfPrinter::pdf_end_page()
     // close text object & stream
     if (!BOLflag)
         pdf_end_line();
-    fprintf(_file, "ET\n");
-    idx_stream_stop = ftell(_file);
-    fprintf(_file, "endstream\nendobj\n");
-    size_t idx_temp = ftell(_file);
-    fflush(_file);
-    fseek(_file, idx_stream_length, SEEK_SET);
-    fprintf(_file, "%10u", (unsigned)(idx_stream_stop - idx_stream_start));
-    fflush(_file);
-    fseek(_file, idx_temp, SEEK_SET);
+    pdf_puts("ET\n");
+    idx_stream_stop = pdf_tell();
+    pdf_puts("endstream\nendobj\n");
+    // the stream length goes in its own object after the stream, so nothing
+    // already written ever has to be revisited
+    pdf_objCtr++;
+    pdf_mark_object(pdf_objCtr);
+    pdf_put_int(pdf_objCtr);
+    pdf_puts(" 0 obj\n");
+    pdf_put_int((int)(idx_stream_stop - idx_stream_start));
+    pdf_puts("\nendobj\n");
     // set counters
     pdf_pageCounter++;
     TOPflag = true;
@@ -263,19 +390,27 @@ void pdfPrinter::pdf_end_page()
 void pdfPrinter::pdf_xref()
 {
     Debug_println("pdf xref");
-    size_t xref = ftell(_file);
+    size_t xref = pdf_tell();
     pdf_objCtr++;
-    fprintf(_file, "xref\n");
-    fprintf(_file, "0 %d\n", pdf_objCtr);
-    fprintf(_file, "0000000000 65535 f\n");
+    pdf_puts("xref\n0 ");
+    pdf_put_int(pdf_objCtr);
+    pdf_puts("\n0000000000 65535 f\n");
+    char entry[] = "0000000000 00000 n\n";
     for (int i = 1; i < pdf_objCtr; i++)
     {
-        fprintf(_file, "%010u 00000 n\n", (unsigned)objLocations[i]);
+        size_t loc = (size_t)i < objLocations.size() ? objLocations[i] : 0;
+        for (int d = 9; d >= 0; d--)
+        {
+            entry[d] = '0' + loc % 10;
+            loc /= 10;
+        }
+        pdf_write(entry, sizeof(entry) - 1);
     }
-    fprintf(_file, "trailer <</Size %d/Root 1 0 R>>\n", pdf_objCtr);
-    fprintf(_file, "startxref\n");
-    fprintf(_file, "%u\n", (unsigned)xref);
-    fprintf(_file, "%%%%EOF\n");
+    pdf_puts("trailer <</Size ");
+    pdf_put_int(pdf_objCtr);
+    pdf_puts("/Root 1 0 R>>\nstartxref\n");
+    pdf_put_int((int)xref);
+    pdf_puts("\n%%EOF\n");
 }
 
 bool pdfPrinter::process_buffer(uint8_t n, uint8_t aux1, uint8_t aux2)
@@ -418,6 +553,7 @@ void pdfPrinter::pre_close_file()
     pdf_add_fonts();
     pdf_page_resource();
     pdf_xref();
+    pdf_flush();
 
     // printer_emu::pageEject();
 }
@@ -5,6 +5,7 @@
  inherited from by other, full-fledged printer classes (e.g. Atari 820/822)
 */
 #include <string>
+#include <vector>
 
 #include "../../include/atascii.h"
 
@@ -13,6 +14,10 @@
 
 #define MAXFONTS 33 // maximum number of fonts can use
 
+// PDF output is collected in RAM and written out in blocks of this size,
+// which matches the flash sector size so SPIFFS/LittleFS see whole-sector writes
+#define PDF_OUTBUF_SIZE 4096
+
 enum class colorMode_t
 {
     off = 0,
@@ -47,10 +52,13 @@ protected:
     bool textMode = true;
     colorMode_t colorMode = colorMode_t::off;
 
-    int pageObjects[256];
+    std::vector<int> pageObjects;       // object number of each page
     int pdf_pageCounter = 0.;
-    size_t objLocations[256]; // reference table storage
-    int pdf_objCtr = 0;       // count the objects
+    std::vector<uint32_t> objLocations; // reference table storage, by object number
+    int pdf_objCtr = 0;                 // count the objects
+
+    // Records that object number obj starts at the current offset
+    void pdf_mark_object(int obj);
 
     void pdf_header();
     void pdf_add_fonts(); // pdfFont_t *fonts[],
@@ -64,10 +72,31 @@ protected:
     void pdf_font_resource();
     void pdf_xref();
 
-    size_t idx_stream_length = 0; // file location of stream length indictor
     size_t idx_stream_start = 0;  // file location of start of stream
     size_t idx_stream_stop = 0;   // file location of end of stream
 
+    // Output buffer. Everything the PDF printers emit goes through these
+    // helpers; object offsets come from pdf_tell() rather than ftell(), and
+    // the file is only touched when the buffer fills or the document closes.
+    uint8_t _pdf_outbuf[PDF_OUTBUF_SIZE];
+    size_t _pdf_outlen = 0;  // bytes waiting in _pdf_outbuf
+    size_t _pdf_offset = 0;  // bytes already written to _file
+
+    size_t pdf_tell() { return _pdf_offset + _pdf_outlen; };
+    void pdf_flush();
+    void pdf_write(const void *data, size_t len);
+    void pdf_copy_from(FILE *f, size_t len);
+    void pdf_puts(const char *s);
+    void pdf_putc(uint8_t c)
+    {
+        if (_pdf_outlen == PDF_OUTBUF_SIZE)
+            pdf_flush();
+        _pdf_outbuf[_pdf_outlen++] = c;
+    };
+    void pdf_put_int(int n);
+    void pdf_put_num(double n);
+    void pdf_put_hex(uint8_t n);
+
     virtual void pdf_clear_modes() = 0;
     virtual void pdf_handle_char(uint16_t c, uint8_t aux1, uint8_t aux2) = 0;
     virtual bool process_buffer(uint8_t linelen, uint8_t aux1, uint8_t aux2) override;
@@ -77,7 +106,13 @@ protected:
 public:
 
     // virtual const char *modelname(void) = 0;
-    pdfPrinter() { _paper_type = PDF; };
+    pdfPrinter()
+    {
+        _paper_type = PDF;
+        // fonts and 3 objects a page, enough for a few pages before growing
+        objLocations.reserve(64);
+        pageObjects.reserve(16);
+    };
 
 };
 
@@ -3,6 +3,7 @@
 #include "../../include/debug.h"
 
 #include "fsFlash.h"
+#include "fnSystem.h"
 
 #define PRINTER_OUTFILE "/paper"
 
@@ -10,6 +11,14 @@
 void printer_emu::initPrinter(FileSystem *fs)
 {
     _FS = fs;
+
+    // Spool to RAM when there's room for it, the file on _FS is the fallback
+    if (_spool == nullptr)
+    {
+        size_t limit = printer_spool::default_limit();
+        if (limit > 0)
+            _spool = new printer_spool(limit);
+    }
 }
 
 
@@ -22,6 +31,35 @@ printer_emu::~printer_emu()
         fclose(_file);
         _file = nullptr;
     }
+    delete _spool;
+}
+
+FILE *printer_emu::open_output(const char *mode)
+{
+    if (_spooling)
+        return _spool->file_open(mode);
+    return _FS->file_open(PRINTER_OUTFILE, mode);
+}
+
+// Move spooled output to the output file once the spool gets close to its limit
+void printer_emu::spill_spool()
+{
+    if (!_spooling || !_spool->nearly_full())
+        return;
+
+    Debug_printf("Printer spool full at %u bytes, moving output to file\r\n", (unsigned)_spool->size());
+    FILE *f = _FS->file_open(PRINTER_OUTFILE, "wb");
+    if (f == nullptr)
+    {
+        Debug_println("Error opening printer file");
+        return;
+    }
+    _spool->copy_to(f);
+    fclose(f);
+
+    // Readers following the spool see it end here and pick up the rest from the file
+    _spooling = false;
+    _spool->truncate();
 }
 
 // virtual void flushOutput(); // do this in pageEject
@@ -61,6 +99,9 @@ size_t printer_emu::getOutputSize()
     if(_file != nullptr)
         return FileSystem::filesize(_file);
 
+    if (_spooling)
+        return _spool->size();
+
     long result = _FS->filesize(PRINTER_OUTFILE);
 
     return result == -1 ? 0 : result;
@@ -79,8 +120,10 @@ bool printer_emu::process(uint8_t linelen, uint8_t aux1, uint8_t aux2)
             return false;
     }
 
+    spill_spool();
+
     // Open output file for appending
-    _file = _FS->file_open(PRINTER_OUTFILE, "rb+"); // This is supposed to open the file for writing at the end, but reading at the beginnig
+    _file = open_output("rb+"); // This is supposed to open the file for writing at the end, but reading at the beginnig
     fseek(_file, 0, SEEK_END); // Make sure we're at the end of the file for reading in case the emaulator code expects that
 
     bool result = process_buffer(linelen, aux1, aux2);
@@ -97,7 +140,26 @@ bool printer_emu::process(uint8_t linelen, uint8_t aux1, uint8_t aux2)
 FILE * printer_emu::closeOutputAndProvideReadHandle()
 {
     closeOutput();
-    return _FS->file_open(PRINTER_OUTFILE);
+    return open_output("rb");
+}
+
+// Copy output from the given offset without closing it, so a reader can follow
+// along while printing is in progress. Returns 0 when caught up.
+size_t printer_emu::readOutput(size_t offset, uint8_t *buf, size_t len)
+{
+    if (!_spooling)
+        return 0;
+    return _spool->read_at(offset, buf, len);
+}
+
+bool printer_emu::waitOutput(size_t offset, uint32_t timeout_ms)
+{
+    if (!_spooling)
+    {
+        fnSystem.delay(timeout_ms);
+        return false;
+    }
+    return _spool->wait_for_data(offset, timeout_ms);
 }
 
 // Closes the output file, giving the printer emulators a chance to provide closing output
@@ -110,7 +172,8 @@ void printer_emu::closeOutput()
     // Give printer emulator chance to finish output
     if(_file == nullptr)
     {
-        _file = _FS->file_open(PRINTER_OUTFILE, "rb+"); // Seeks don't work right if we use "append" mode - use "rb+"
+        spill_spool();
+        _file = open_output("rb+"); // Seeks don't work right if we use "append" mode - use "rb+"
         fseek(_file, 0, SEEK_END);
     }
 
@@ -128,7 +191,8 @@ void printer_emu::restart_output()
     _output_started = false;
     if(_file != nullptr)
         fclose(_file);
-    _file = _FS->file_open(PRINTER_OUTFILE, "wb"); // This should create/truncate the file
+    _spooling = _spool != nullptr;
+    _file = open_output("wb"); // This should create/truncate the file
 #ifdef DEBUG
     if (_file != nullptr)
     {
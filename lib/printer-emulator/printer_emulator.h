@@ -5,6 +5,8 @@
 
 #include "fnFsSD.h"
 
+#include "printer_spool.h"
+
 // TODO: Combine html_printer.cpp/h and file_printer.cpp/h
 
 // I think the way we're using this value is as a switch to tell the printer
@@ -28,6 +30,13 @@ class printer_emu
 private:
     bool _output_started = false;
 
+    // Output goes to RAM instead of a file on _FS while _spooling is set
+    printer_spool *_spool = nullptr;
+    bool _spooling = false;
+
+    FILE *open_output(const char *mode);
+    void spill_spool();
+
 protected:
     FileSystem *_FS = nullptr;
     FILE * _file = nullptr;
@@ -75,6 +84,13 @@ public:
     virtual const char *modelname()=0;
     size_t getOutputSize();
 
+    // Live access to output while printing is in progress (spooled output only)
+    bool isOutputStreamable() { return _spooling && _paper_type != SVG; };
+    size_t readOutput(size_t offset, uint8_t *buf, size_t len);
+    // Waits up to timeout_ms for output past offset, returns true once there is some.
+    // Output that isn't spooled can't be followed, so that just waits out the timeout.
+    bool waitOutput(size_t offset, uint32_t timeout_ms);
+
     void setEOLBypass(bool t) { _eol_bypass = t; };
 
     bool getEOLBypass() { return _eol_bypass; }
@@ -0,0 +1,250 @@
+#include "printer_spool.h"
+
+#include <string.h>
+
+#include <chrono>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+#include "../../include/debug.h"
+
+#include "fnSystem.h"
+
+#ifdef PRINTER_SPOOL_SUPPORTED
+
+#if defined(PRINTER_SPOOL_FUNOPEN)
+typedef fpos_t spool_off_t;
+#elif defined(ESP_PLATFORM)
+typedef _off64_t spool_off_t;
+#else
+typedef off64_t spool_off_t;
+#endif
+
+struct spool_cookie
+{
+    printer_spool *spool;
+    size_t pos;
+};
+
+static ssize_t spool_cookie_read(void *cookie, char *buf, size_t size)
+{
+    spool_cookie *c = (spool_cookie *)cookie;
+    size_t n = c->spool->read_at(c->pos, buf, size);
+    c->pos += n;
+    return n;
+}
+
+static ssize_t spool_cookie_write(void *cookie, const char *buf, size_t size)
+{
+    spool_cookie *c = (spool_cookie *)cookie;
+    size_t n = c->spool->write_at(c->pos, buf, size);
+    c->pos += n;
+    // a short write makes stdio set the error flag on the FILE
+    return n == size ? (ssize_t)n : -1;
+}
+
+static int spool_cookie_seek(void *cookie, spool_off_t *offset, int whence)
+{
+    spool_cookie *c = (spool_cookie *)cookie;
+    spool_off_t base;
+    switch (whence)
+    {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = c->pos;
+        break;
+    case SEEK_END:
+        base = c->spool->size();
+        break;
+    default:
+        return -1;
+    }
+    if (base + *offset < 0)
+        return -1;
+    c->pos = base + *offset;
+    *offset = c->pos;
+    return 0;
+}
+
+static int spool_cookie_close(void *cookie)
+{
+    delete (spool_cookie *)cookie;
+    return 0;
+}
+
+#ifdef PRINTER_SPOOL_FUNOPEN
+// funopen() takes int lengths and returns the new offset from seek
+static int spool_funopen_read(void *cookie, char *buf, int size)
+{
+    return (int)spool_cookie_read(cookie, buf, size);
+}
+
+static int spool_funopen_write(void *cookie, const char *buf, int size)
+{
+    return (int)spool_cookie_write(cookie, buf, size);
+}
+
+static fpos_t spool_funopen_seek(void *cookie, fpos_t offset, int whence)
+{
+    return spool_cookie_seek(cookie, &offset, whence) == 0 ? offset : -1;
+}
+#endif
+
+#endif // PRINTER_SPOOL_SUPPORTED
+
+printer_spool::~printer_spool()
+{
+    truncate();
+}
+
+size_t printer_spool::default_limit()
+{
+#ifndef PRINTER_SPOOL_SUPPORTED
+    return 0;
+#elif defined(ESP_PLATFORM)
+    // Internal RAM is too tight to spool into, use the output file instead
+    return fnSystem.get_psram_size() > 0 ? 1024 * 1024 : 0;
+#else
+    return 16 * 1024 * 1024;
+#endif
+}
+
+void printer_spool::truncate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (uint8_t *chunk : _chunks)
+        free(chunk);
+    _chunks.clear();
+    _size = 0;
+    _grown.notify_all();
+}
+
+size_t printer_spool::size()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size;
+}
+
+size_t printer_spool::write_at(size_t pos, const void *data, size_t len)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (pos > _size || pos >= _limit)
+        return 0;
+    if (len > _limit - pos)
+        len = _limit - pos;
+
+    const uint8_t *src = (const uint8_t *)data;
+    size_t done = 0;
+    while (done < len)
+    {
+        size_t idx = (pos + done) / PRINTER_SPOOL_CHUNK;
+        size_t off = (pos + done) % PRINTER_SPOOL_CHUNK;
+        if (idx == _chunks.size())
+        {
+#ifdef ESP_PLATFORM
+            uint8_t *chunk = (uint8_t *)heap_caps_malloc(PRINTER_SPOOL_CHUNK, MALLOC_CAP_SPIRAM);
+            if (chunk == nullptr)
+                chunk = (uint8_t *)malloc(PRINTER_SPOOL_CHUNK);
+#else
+            uint8_t *chunk = (uint8_t *)malloc(PRINTER_SPOOL_CHUNK);
+#endif
+            if (chunk == nullptr)
+            {
+                Debug_println("printer_spool: out of memory");
+                break;
+            }
+            _chunks.push_back(chunk);
+        }
+        size_t n = PRINTER_SPOOL_CHUNK - off;
+        if (n > len - done)
+            n = len - done;
+        memcpy(_chunks[idx] + off, src + done, n);
+        done += n;
+    }
+
+    if (pos + done > _size)
+    {
+        _size = pos + done;
+        _grown.notify_all();
+    }
+    return done;
+}
+
+size_t printer_spool::read_at(size_t pos, void *data, size_t len)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (pos >= _size)
+        return 0;
+    if (len > _size - pos)
+        len = _size - pos;
+
+    uint8_t *dst = (uint8_t *)data;
+    size_t done = 0;
+    while (done < len)
+    {
+        size_t idx = (pos + done) / PRINTER_SPOOL_CHUNK;
+        size_t off = (pos + done) % PRINTER_SPOOL_CHUNK;
+        size_t n = PRINTER_SPOOL_CHUNK - off;
+        if (n > len - done)
+            n = len - done;
+        memcpy(dst + done, _chunks[idx] + off, n);
+        done += n;
+    }
+    return done;
+}
+
+bool printer_spool::wait_for_data(size_t pos, uint32_t timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _grown.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&]
+                           { return _size > pos; });
+}
+
+FILE *printer_spool::file_open(const char *mode)
+{
+#ifdef PRINTER_SPOOL_SUPPORTED
+    if (mode[0] == 'w')
+        truncate();
+
+    spool_cookie *cookie = new spool_cookie{this, 0};
+#ifdef PRINTER_SPOOL_FUNOPEN
+    FILE *f = funopen(cookie, spool_funopen_read, spool_funopen_write, spool_funopen_seek, spool_cookie_close);
+#else
+    cookie_io_functions_t funcs = {
+        .read = spool_cookie_read,
+        .write = spool_cookie_write,
+        .seek = spool_cookie_seek,
+        .close = spool_cookie_close};
+
+    FILE *f = fopencookie(cookie, mode, funcs);
+#endif
+    if (f == nullptr)
+        delete cookie;
+    return f;
+#else
+    return nullptr;
+#endif
+}
+
+size_t printer_spool::copy_to(FILE *f)
+{
+    uint8_t *buf = (uint8_t *)malloc(PRINTER_SPOOL_CHUNK);
+    if (buf == nullptr)
+        return 0;
+
+    size_t pos = 0, count;
+    while ((count = read_at(pos, buf, PRINTER_SPOOL_CHUNK)) > 0)
+    {
+        if (fwrite(buf, 1, count, f) != count)
+            break;
+        pos += count;
+    }
+    free(buf);
+    return pos;
+}
@@ -0,0 +1,68 @@
+#ifndef PRINTER_SPOOL_H
+#define PRINTER_SPOOL_H
+
+/* RAM (PSRAM where available) backing store for printer output.
+
+ The printer emulators write through a stdio FILE*, so the spool hands out
+ FILE handles backed by fopencookie() (funopen() on macOS and the BSDs). That
+ keeps every emulator unchanged while keeping the output off flash, and lets
+ a reader (the web UI) pull bytes out while the Atari is still printing.
+ Windows has neither, so FujiNet-PC there prints to the output file as before.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#if defined(ESP_PLATFORM) || defined(__linux__)
+#define PRINTER_SPOOL_SUPPORTED 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define PRINTER_SPOOL_SUPPORTED 1
+#define PRINTER_SPOOL_FUNOPEN 1
+#endif
+
+#define PRINTER_SPOOL_CHUNK 4096
+
+class printer_spool
+{
+private:
+    std::vector<uint8_t *> _chunks;
+    size_t _size = 0;
+    size_t _limit = 0;
+    std::mutex _mutex;
+    std::condition_variable _grown;
+
+public:
+    printer_spool(size_t limit) : _limit(limit) {};
+    ~printer_spool();
+
+    // Spool size limit for this system, 0 if spooling isn't available
+    static size_t default_limit();
+
+    // Drop all spooled data
+    void truncate();
+
+    size_t size();
+    // Leave a quarter of the spool free for whatever gets written at close
+    // time (e.g. the fonts embedded in a PDF)
+    bool nearly_full() { return size() >= _limit - _limit / 4; };
+
+    // Returns number of bytes written, short when the limit is reached
+    size_t write_at(size_t pos, const void *data, size_t len);
+    size_t read_at(size_t pos, void *data, size_t len);
+
+    // Blocks until there's data past pos or timeout_ms passes.
+    // Returns true if there's data to read.
+    bool wait_for_data(size_t pos, uint32_t timeout_ms);
+
+    // stdio view of the spool. "w" truncates, "r+" keeps contents.
+    FILE *file_open(const char *mode);
+
+    // Copy everything spooled so far to f
+    size_t copy_to(FILE *f);
+};
+
+#endif // PRINTER_SPOOL_H
@@ -107,6 +107,8 @@ uint32 _HardwareIn(const uint32 Port) {
 
 /* filesystem (disk) abstraction fuctions */
 /*===============================================================================*/
+#include "disk_cache.h"
+
 FILE *rootdir;
 FILE *userdir;
 
@@ -135,35 +137,39 @@ int _sys_select(uint8_t *disk)
 	return fnSDFAT.exists(full_path((char *)disk));
 }
 
-long _sys_filesize(uint8_t *fn)
+FILE *_dc_fopen(uint8_t *fn, const char *mode)
 {
-	unsigned long fs = -1;
-	FILE *fp = fnSDFAT.file_open(full_path((char *)fn), "r");
+	return fnSDFAT.file_open(full_path((char *)fn), mode);
+}
 
-	if (fp)
+void _dc_scan(dc_dir_t *dir)
+{
+	fsdir_entry *entry;
+
+	if (!fnSDFAT.dir_open(full_path(dir->path), "*", 0))
+		return;
+	while ((entry = fnSDFAT.dir_read()))
 	{
-		fseek(fp, 0L, SEEK_END);
-		fs = ftell(fp);
+		if (!entry->isDir)
+			_dc_add(dir, entry->filename, entry->size);
 	}
+	fnSDFAT.dir_close();
+}
 
-	fclose(fp);
-	return fs;
+long _sys_filesize(uint8_t *fn)
+{
+	return _dc_size(fn);
 }
 
 int _sys_openfile(uint8_t *fn)
 {
-	FILE *fp = fnSDFAT.file_open(full_path((char *)fn), "r");
-	if (fp)
-	{
-		fclose(fp);
-		return 1;
-	}
-	else
-		return 0;
+	return _dc_get(fn) != NULL;
 }
 
 int _sys_makefile(uint8_t *fn)
 {
+	_dc_close(fn);
+	_dc_dirchanged(fn);
 	FILE *fp = fnSDFAT.file_open(full_path((char *)fn), "w");
 	if (fp)
 	{
@@ -176,6 +182,8 @@ int _sys_makefile(uint8_t *fn)
 
 int _sys_deletefile(uint8_t *fn)
 {
+	_dc_close(fn);
+	_dc_dirchanged(fn);
 	return fnSDFAT.remove(full_path((char *)fn));
 }
 
@@ -183,6 +191,10 @@ int _sys_renamefile(uint8_t *fn, uint8_t *newname)
 {
 	std::string from, to;
 
+	_dc_close(fn);
+	_dc_close(newname);
+	_dc_dirchanged(fn);
+
 	from = std::string(full_path((char *)fn));
 	to = std::string(full_path((char *)newname));
 
@@ -194,179 +206,58 @@ void _sys_logbuffer(uint8_t *buffer)
 	// not implemented at present.
 }
 
-bool _sys_extendfile(char *fn, unsigned long fpos)
-{
-	FILE *fp = fnSDFAT.file_open(full_path((char *)fn), "a");
-
-	if (!fp)
-		return false;
-
-	long origSize = fnSDFAT.filesize(full_path(fn));
-
-	// This was patterned after the arduino abstraction, and I do not like how this works.
-
-	if (fpos > origSize)
-	{
-		for (long i = 0; i < (origSize - fpos); ++i)
-		{
-			if (fwrite("\0", sizeof(uint8_t), 1, fp) != 1)
-			{
-				fclose(fp);
-				return false;
-			}
-		}
-	}
-	fclose(fp);
-	return true;
-}
-
 uint8_t _sys_readseq(uint8_t *fn, long fpos)
 {
-	uint8_t result = 0xff;
-	FILE *f;
-	uint8_t bytesread;
 	uint8_t dmabuf[BlkSZ];
-	int seekErr;
-
-	f = fnSDFAT.file_open(full_path((char *)fn), "r");
-	if (!f)
-	{
-		result = 0x10;
-		return result;
-	}
+	int bytesread = _dc_read(fn, fpos, dmabuf);
 
-	seekErr = fseek(f, fpos, SEEK_SET);
-	if (f)
-	{
-		if (fpos > 0 && seekErr != 0)
-		{
-			// EOF
-			result = 0x01;
-		}
-		else
-		{
-			// set DMA buffer to EOF
-			memset(dmabuf, 0x1a, BlkSZ);
-			bytesread = fread(&dmabuf[0], BlkSZ, sizeof(uint8_t), f);
-			if (bytesread)
-				memcpy((uint8_t *)&RAM[dmaAddr], dmabuf, BlkSZ);
-			result = bytesread ? 0x00 : 0x01;
-		}
-	}
-	else
-	{
-		result = 0x10;
-	}
-	fclose(f);
-	return (result);
+	if (bytesread < 0)
+		return 0x10;
+	if (bytesread == 0)
+		return 0x01; // EOF
+	memcpy((uint8_t *)&RAM[dmaAddr], dmabuf, BlkSZ);
+	return 0x00;
 }
 
 uint8_t _sys_writeseq(uint8_t *fn, long fpos)
 {
-	uint8_t result = 0xff;
-	FILE *f;
-
-	if (_sys_extendfile((char *)fn, fpos))
-		f = fnSDFAT.file_open(full_path((char *)fn), "r+");
-	else
-		return result;
-
-	if (f)
-	{
-		if (fseek(f, fpos, SEEK_SET) == 0)
-		{
-			if (fwrite(_RamSysAddr(dmaAddr), BlkSZ, sizeof(uint8_t), f))
-				result = 0x00;
-		}
-		else
-		{
-			result = 0x01;
-		}
-	}
-	else
-	{
-		result = 0x10;
-	}
-	fclose(f);
-	return (result);
+	if (_dc_write(fn, fpos, _RamSysAddr(dmaAddr)))
+		return 0xff;
+	return 0x00;
 }
 
 uint8_t _sys_readrand(uint8_t *fn, long fpos)
 {
-	uint8 result = 0xff;
-	FILE *f;
-	uint8 bytesread;
 	uint8 dmabuf[BlkSZ];
 	long extSize;
+	int bytesread = _dc_read(fn, fpos, dmabuf);
 
-	f = fnSDFAT.file_open(full_path((char *)fn), "r+");
-	if (f)
+	if (bytesread < 0)
+		return 0x10;
+	if (bytesread > 0)
 	{
-		if (fseek(f, fpos, SEEK_SET) == 0)
-		{
-			memset(dmabuf, 0x1A, BlkSZ);
-			bytesread = fread(&dmabuf[0], BlkSZ, sizeof(uint8_t), f);
-			if (bytesread)
-				memcpy((uint8_t *)&RAM[dmaAddr], dmabuf, BlkSZ);
-			result = bytesread ? 0x00 : 0x01;
-		}
-		else
-		{
-			if (fpos >= 65536L * BlkSZ)
-			{
-				result = 0x06; // seek past 8MB (largest file size in CP/M)
-			}
-			else
-			{
-				extSize = _sys_filesize((uint8_t *)full_path((char *)fn));
-
-				// round file size up to next full logical extent
-				extSize = ExtSZ * ((extSize / ExtSZ) + ((extSize % ExtSZ) ? 1 : 0));
-				if (fpos < extSize)
-					result = 0x01; // reading unwritten data
-				else
-					result = 0x04; // seek to unwritten extent
-			}
-		}
+		memcpy((uint8_t *)&RAM[dmaAddr], dmabuf, BlkSZ);
+		return 0x00;
 	}
+	if (fpos >= 65536L * BlkSZ)
+		return 0x06; // seek past 8MB (largest file size in CP/M)
+
+	extSize = _dc_size(fn);
+	// round file size up to next full logical extent
+	extSize = ExtSZ * ((extSize / ExtSZ) + ((extSize % ExtSZ) ? 1 : 0));
+	if (fpos < extSize)
+		return 0x01; // reading unwritten data
 	else
-	{
-		result = 0x10;
-	}
-	fclose(f);
-	return (result);
+		return 0x04; // seek to unwritten extent
 }
 
 uint8_t _sys_writerand(uint8_t *fn, long fpos)
 {
-	uint8 result = 0xff;
-	FILE *f;
-
-	if (_sys_extendfile((char *)fn, fpos))
-	{
-		f = fnSDFAT.file_open(full_path((char *)fn), "r+");
-	}
-	else
-		return result;
-
-	if (f)
-	{
-		if (fseek(f, fpos, SEEK_SET) == 0)
-		{
-			if (fwrite(_RamSysAddr(dmaAddr), BlkSZ, sizeof(uint8_t), f))
-				result = 0x00;
-		}
-		else
-		{
-			result = 0x06;
-		}
-	}
-	else
-	{
-		result = 0x10;
-	}
-	fclose(f);
-	return (result);
+	if (fpos >= 65536L * BlkSZ)
+		return 0x06;
+	if (_dc_write(fn, fpos, _RamSysAddr(dmaAddr)))
+		return 0xff;
+	return 0x00;
 }
 
 uint8_t findNextDirName[17];
@@ -374,13 +265,13 @@ uint16_t fileRecords = 0;
 uint16_t fileExtents = 0;
 uint16_t fileExtentsUsed = 0;
 uint16_t firstFreeAllocBlock;
+dc_dir_t *findDir = NULL;
 
 uint8_t _findnext(uint8_t isdir)
 {
 	uint8 result = 0xff;
-	bool isfile;
 	uint32 bytes;
-	fsdir_entry *entry;
+	dc_dirent_t *entry;
 
 	if (allExtents && fileRecords)
 	{
@@ -389,13 +280,11 @@ uint8_t _findnext(uint8_t isdir)
 	}
 	else
 	{
-		while ((entry = fnSDFAT.dir_read()))
+		while (findDir != NULL && dirPos < findDir->count)
 		{
-			strcpy((char *)findNextDirName, entry->filename); // careful watch for string overflow!
-			isfile = !entry->isDir;
+			entry = &findDir->entries[dirPos++];
+			strcpy((char *)findNextDirName, entry->name);
 			bytes = entry->size;
-			if (!isfile)
-				continue;
 			_HostnameToFCBname(findNextDirName, fcbname);
 			if (match(fcbname, pattern))
 			{
@@ -432,11 +321,11 @@ uint8_t _findnext(uint8_t isdir)
 
 uint8_t _findfirst(uint8_t isdir)
 {
-	uint8 path[4] = {'?', FOLDERCHAR, '?', 0};
+	char path[4] = {'?', FOLDERCHAR, '?', 0};
 	path[0] = filename[0];
 	path[2] = filename[2];
-	fnSDFAT.dir_close();
-	fnSDFAT.dir_open(full_path((char *)path), "*", 0);
+	findDir = _dc_dir(path);
+	dirPos = 0;
 	_HostnameToFCBname(filename, pattern);
 	fileRecords = 0;
 	fileExtents = 0;
@@ -508,43 +397,73 @@ uint8_t _sys_makedisk(uint8_t drive)
 	return (result);
 }
 
-/* Console abstraction functions */
+/* Ending the CP/M task */
 /*===============================================================================*/
+#ifdef ESP_PLATFORM // OS
+/* The device never deletes the task from outside: it could be part way
+   through an SD card write, holding the driver's locks, or through a disk
+   cache update. _cpm_stop() asks RunCPM to end, as the BIOS BOOT call does,
+   and waits. The task ends itself at a point where it holds nothing: once
+   _ccp() has returned, or while it waits on the console link. It writes
+   back its disk cache before it goes. */
+
+#define CPM_STOP_POLL_MS 10 // how often _cpm_stop() asks again
+
+extern volatile int32 Status;
 
-int _kbhit(void)
+static volatile bool cpm_stopping = false;
+static TaskHandle_t cpm_stopper = NULL;
+
+// On the CP/M task: ends it here if the device asked for that
+void _cpm_stop_point(void)
 {
-#ifdef ESP_PLATFORM // OS
-	return uxQueueMessagesWaiting(txq);
-#else
-	return 0;
-#endif
+	if (!cpm_stopping)
+		return;
+	_dc_reset();
+	xTaskNotifyGive(cpm_stopper);
+	vTaskDelete(NULL);
 }
 
-uint8_t _getch(void)
+// On the device: ends the CP/M task and returns once it has written back
+void _cpm_stop(void)
 {
-	uint8_t c;
-#ifdef ESP_PLATFORM // OS
-	xQueueReceive(txq,&c,portMAX_DELAY);
-#endif
-	return c;
+	cpm_stopper = xTaskGetCurrentTaskHandle();
+	cpm_stopping = true;
+	// Z80run() and the CCP stop on Status, and a program starting clears it
+	do
+		Status = 1;
+	while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CPM_STOP_POLL_MS)) == 0);
+	cpm_stopping = false;
 }
+#endif
+
+/* Console abstraction functions */
+/*===============================================================================*/
 
-uint8_t _getche(void)
+void _con_send(uint8_t *buf, uint16_t len)
 {
-	uint8_t c = _getch();
 #ifdef ESP_PLATFORM // OS
-	xQueueSend(rxq,&c,portMAX_DELAY);
+	for (uint16_t i = 0; i < len; i++)
+		while (xQueueSend(rxq, &buf[i], pdMS_TO_TICKS(CPM_STOP_POLL_MS)) != pdTRUE)
+			_cpm_stop_point(); // nobody is reading, maybe because the device is stopping us
 #endif
-	return c;
 }
 
-void _putch(uint8_t ch)
+int _con_receive(uint32_t ms)
 {
 #ifdef ESP_PLATFORM // OS
-	xQueueSend(rxq,&ch,portMAX_DELAY);
+	uint8_t c;
+	if (xQueueReceive(txq, &c, pdMS_TO_TICKS(ms)) == pdTRUE)
+		return c;
+	_cpm_stop_point();
+#else
+	fnSystem.delay(ms);
 #endif
+	return -1;
 }
 
+#include "console_buffer.h"
+
 void _clrscr(void)
 {
 	_putch(0x1B);
@@ -132,41 +132,62 @@ int _sys_rename(uint8* name1, uint8* name2) {
 	return(rename((const char*)name1, (const char*)name2));
 }
 
+#include "disk_cache.h"
+
+FILE* _dc_fopen(uint8* filename, const char* mode) {
+	return(fopen((const char*)filename, mode));
+}
+
+void _dc_scan(dc_dir_t* dir) {
+	char mask[6] = { '?', FOLDERCHAR, '?', FOLDERCHAR, '*', 0 };
+	glob_t pglob;
+	struct stat st;
+	size_t i;
+
+	mask[0] = dir->path[0];
+	mask[2] = dir->path[2];
+	if (!glob(mask, 0, NULL, &pglob)) {
+		for (i = 0; i < pglob.gl_pathc; ++i) {
+			if ((stat(pglob.gl_pathv[i], &st) == 0) && ((st.st_mode & S_IFREG) != 0))
+				_dc_add(dir, pglob.gl_pathv[i], st.st_size);
+		}
+		globfree(&pglob);
+	}
+}
+
 int _sys_select(uint8* disk) {
 	struct stat st;
 	return((stat((char*)disk, &st) == 0) && ((st.st_mode & S_IFDIR) != 0));
 }
 
 long _sys_filesize(uint8* filename) {
-	long l = -1;
-	FILE* file = _sys_fopen_r(filename);
-	if (file != NULL) {
-		_sys_fseek(file, 0, SEEK_END);
-		l = _sys_ftell(file);
-		_sys_fclose(file);
-	}
-	return(l);
+	return(_dc_size(filename));
 }
 
 int _sys_openfile(uint8* filename) {
-	FILE* file = _sys_fopen_r(filename);
-	if (file != NULL)
-		_sys_fclose(file);
-	return(file != NULL);
+	return(_dc_get(filename) != NULL);
 }
 
 int _sys_makefile(uint8* filename) {
-	FILE* file = _sys_fopen_a(filename);
+	FILE* file;
+	_dc_close(filename);
+	_dc_dirchanged(filename);
+	file = _sys_fopen_a(filename);
 	if (file != NULL)
 		_sys_fclose(file);
 	return(file != NULL);
 }
 
 int _sys_deletefile(uint8* filename) {
+	_dc_close(filename);
+	_dc_dirchanged(filename);
 	return(!_sys_remove(filename));
 }
 
 int _sys_renamefile(uint8* filename, uint8* newname) {
+	_dc_close(filename);
+	_dc_close(newname);
+	_dc_dirchanged(filename);
 	return(!_sys_rename(&filename[0], &newname[0]));
 }
 
@@ -188,25 +209,16 @@ void _sys_logbuffer(uint8* buffer) {
 
 uint8 _sys_readseq(uint8* filename, long fpos) {
 	uint8 result = 0xff;
-	uint8 bytesread;
 	uint8 dmabuf[128];
 	uint8 i;
 
-	FILE* file = _sys_fopen_r(&filename[0]);
-	if (file != NULL) {
-		if (!_sys_fseek(file, fpos, 0)) {
+	int bytesread = _dc_read(filename, fpos, dmabuf);
+	if (bytesread >= 0) {
+		if (bytesread) {
 			for (i = 0; i < 128; ++i)
-				dmabuf[i] = 0x1a;
-			bytesread = (uint8)_sys_fread(&dmabuf[0], 1, 128, file);
-			if (bytesread) {
-				for (i = 0; i < 128; ++i)
-					_RamWrite(dmaAddr + i, dmabuf[i]);
-			}
-			result = bytesread ? 0x00 : 0x01;
-		} else {
-			result = 0x01;
+				_RamWrite(dmaAddr + i, dmabuf[i]);
 		}
-		_sys_fclose(file);
+		result = bytesread ? 0x00 : 0x01;
 	} else {
 		result = 0x10;
 	}
@@ -215,57 +227,32 @@ uint8 _sys_readseq(uint8* filename, long fpos) {
 }
 
 uint8 _sys_writeseq(uint8* filename, long fpos) {
-	uint8 result = 0xff;
-
-	FILE* file = _sys_fopen_rw(&filename[0]);
-	if (file != NULL) {
-		if (!_sys_fseek(file, fpos, 0)) {
-			if (_sys_fwrite(_RamSysAddr(dmaAddr), 1, 128, file))
-				result = 0x00;
-		} else {
-			result = 0x01;
-		}
-		_sys_fclose(file);
-	} else {
-		result = 0x10;
-	}
-
-	return(result);
+	return(_dc_write(filename, fpos, _RamSysAddr(dmaAddr)) ? 0xff : 0x00);
 }
 
 uint8 _sys_readrand(uint8* filename, long fpos) {
 	uint8 result = 0xff;
-	uint8 bytesread;
 	uint8 dmabuf[128];
 	uint8 i;
 	long extSize;
 
-	FILE* file = _sys_fopen_r(&filename[0]);
-	if (file != NULL) {
-		if (!_sys_fseek(file, fpos, 0)) {
-			for (i = 0; i < 128; ++i)
-				dmabuf[i] = 0x1a;
-			bytesread = (uint8)_sys_fread(&dmabuf[0], 1, 128, file);
-			if (bytesread) {
-				for (i = 0; i < 128; ++i)
-					_RamWrite(dmaAddr + i, dmabuf[i]);
-			}
-			result = bytesread ? 0x00 : 0x01;
+	int bytesread = _dc_read(filename, fpos, dmabuf);
+	if (bytesread > 0) {
+		for (i = 0; i < 128; ++i)
+			_RamWrite(dmaAddr + i, dmabuf[i]);
+		result = 0x00;
+	} else if (bytesread == 0) {
+		if (fpos >= 65536L * 128) {
+			result = 0x06;	// seek past 8MB (largest file size in CP/M)
 		} else {
-			if (fpos >= 65536L * 128) {
-				result = 0x06;	// seek past 8MB (largest file size in CP/M)
-			} else {
-				_sys_fseek(file, 0, SEEK_END);
-				extSize = _sys_ftell(file);
-				// round file size up to next full logical extent
-				extSize = 16384 * ((extSize / 16384) + ((extSize % 16384) ? 1 : 0));
-				if (fpos < extSize)
-					result = 0x01;	// reading unwritten data
-				else
-					result = 0x04; // seek to unwritten extent
-			}
+			extSize = _dc_size(filename);
+			// round file size up to next full logical extent
+			extSize = 16384 * ((extSize / 16384) + ((extSize % 16384) ? 1 : 0));
+			if (fpos < extSize)
+				result = 0x01;	// reading unwritten data
+			else
+				result = 0x04; // seek to unwritten extent
 		}
-		_sys_fclose(file);
 	} else {
 		result = 0x10;
 	}
@@ -274,22 +261,9 @@ uint8 _sys_readrand(uint8* filename, long fpos) {
 }
 
 uint8 _sys_writerand(uint8* filename, long fpos) {
-	uint8 result = 0xff;
-
-	FILE* file = _sys_fopen_rw(&filename[0]);
-	if (file != NULL) {
-		if (!_sys_fseek(file, fpos, 0)) {
-			if (_sys_fwrite(_RamSysAddr(dmaAddr), 1, 128, file))
-				result = 0x00;
-		} else {
-			result = 0x06;
-		}
-		_sys_fclose(file);
-	} else {
-		result = 0x10;
-	}
-
-	return(result);
+	if (fpos >= 65536L * 128)
+		return(0x06);
+	return(_dc_write(filename, fpos, _RamSysAddr(dmaAddr)) ? 0xff : 0x00);
 }
 
 uint8 _Truncate(char* fn, uint8 rc) {
@@ -363,7 +337,6 @@ uint8 _RunLuaScript(char* filename) {
 #define POLLRDNORM 0
 #endif
 
-glob_t	pglob;
 int	dirPos;
 
 static char findNextDirName[17];
@@ -374,9 +347,9 @@ static uint16 firstFreeAllocBlock;
 
 uint8 _findnext(uint8 isdir) {
 	uint8 result = 0xff;
-	char dir[6] = { '?', FOLDERCHAR, 0, FOLDERCHAR, '*', 0 };
+	char dir[4] = { '?', FOLDERCHAR, '?', 0 };
+	dc_dir_t* listing;
 	int i;
-	struct stat st;
 	uint32 bytes;
 
 	if (allExtents && fileRecords) {
@@ -396,15 +369,13 @@ uint8 _findnext(uint8 isdir) {
 			dir[2] = '?';
 		else
 			dir[2] = filename[2];
-		if (!glob(dir, 0, NULL, &pglob)) {
-			for (i = dirPos; i < pglob.gl_pathc; ++i) {
+		if ((listing = _dc_dir(dir)) != NULL) {
+			for (i = dirPos; i < listing->count; ++i) {
 				++dirPos;
-				strncpy(findNextDirName, pglob.gl_pathv[i], sizeof(findNextDirName) - 1);
+				strncpy(findNextDirName, listing->entries[i].name, sizeof(findNextDirName) - 1);
 				findNextDirName[sizeof(findNextDirName) - 1] = 0;
 				_HostnameToFCBname((uint8*)findNextDirName, fcbname);
 				if (match(fcbname, pattern) &&
-					(stat(findNextDirName, &st) == 0) &&
-					((st.st_mode & S_IFREG) != 0) &&
 					isxdigit((uint8)findNextDirName[2]) &&
 					(isupper((uint8)findNextDirName[2]) || isdigit((uint8)findNextDirName[2]))) {
 					if (allUsers)
@@ -412,7 +383,7 @@ uint8 _findnext(uint8 isdir) {
 					if (isdir) {
 						// account for host files that aren't multiples of the block size
 						// by rounding their bytes up to the next multiple of blocks
-						bytes = st.st_size;
+						bytes = listing->entries[i].size;
 						if (bytes & (BlkSZ - 1)) {
 							bytes = (bytes & ~(BlkSZ - 1)) + BlkSZ;
 						}
@@ -438,7 +409,6 @@ uint8 _findnext(uint8 isdir) {
 					break;
 				}
 			}
-			globfree(&pglob);
 		}
 	}
 	return(result);
@@ -655,6 +655,9 @@ void _ccp_readInput(void) {
     uint8 i;
     uint8 chars;
     
+#ifdef DISK_CACHE
+    _dc_reset();    // Nothing stays open or buffered between commands
+#endif
     if (sFlag) {                                // Are we running a submit?
         if (!sRecs) {                           // Are we already counting?
             _ccp_bdos(F_OPEN, BatchFCB);        // Open the batch file
@@ -0,0 +1,103 @@
+#ifndef CONSOLE_BUFFER_H
+#define CONSOLE_BUFFER_H
+
+/* Console I/O shared by the #FujiNet abstractions
+
+   Output gathers in a buffer and goes to the link a run at a time instead of
+   a write per character. The buffer is sent when it fills, and before every
+   console read or status poll, so a prompt is always out before CP/M waits
+   for the answer. BDOS calls past the console ones (disk, mostly) send it
+   first too, as they may take a while. Any other BIOS or BDOS call, and the
+   next character, send it once its oldest character has waited
+   CONBUF_FLUSH_MS. A program that prints and then only computes, making no
+   calls at all, keeps its output until it does.
+
+   Input blocks on the link with a timeout instead of spinning. A program that
+   does nothing but poll console status gets CONBUF_IDLE_POLLS quick answers,
+   then each poll waits up to CONBUF_IDLE_MS for a character, which lets the
+   core sleep while CP/M sits at a prompt. Output, or time spent between
+   polls, puts it back to quick answers.
+
+   The abstraction includes this and supplies:
+	void _con_send(uint8 *buf, uint16 len)	writes a run of output to the link, buf may be changed
+	int _con_receive(uint32 ms)				waits up to ms for a character, -1 if none came
+*/
+
+#ifndef CONBUF_MILLIS
+#define CONBUF_MILLIS() fnSystem.millis()
+#endif
+
+#define CONBUF_SIZE 256			// Most output held back at once
+#define CONBUF_FLUSH_MS 20		// Longest a character is held back
+#define CONBUF_WAIT_MS 50		// _getch() waits on the link this long at a time
+#define CONBUF_IDLE_POLLS 64	// Empty status polls in a row before they start waiting
+#define CONBUF_IDLE_MS 10		// and how long each then waits, a FreeRTOS tick
+
+void _con_send(uint8* buf, uint16 len);
+int _con_receive(uint32 ms);
+
+static uint8 conbuf[CONBUF_SIZE];
+static uint16 conbuf_len = 0;
+static uint64_t conbuf_since = 0;	// When the first character in the buffer was put there
+static int16 con_ahead = -1;		// Character taken from the link by _kbhit(), -1 if none
+static uint16 con_idle_polls = 0;	// Empty status polls back to back
+static uint64_t con_poll_at = 0;	// When the last empty status poll returned
+
+void _conbuf_flush(void) {
+	if (conbuf_len) {
+		_con_send(conbuf, conbuf_len);
+		conbuf_len = 0;
+	}
+}
+
+// Sends the buffer if it has been held back long enough, from the BIOS and BDOS dispatch
+void _conbuf_idle(void) {
+	if (conbuf_len && CONBUF_MILLIS() - conbuf_since >= CONBUF_FLUSH_MS)
+		_conbuf_flush();
+}
+
+int _kbhit(void) {
+	_conbuf_flush();
+	if (con_ahead < 0) {
+		if (CONBUF_MILLIS() - con_poll_at > 1)	// the program did something else since the last poll
+			con_idle_polls = 0;
+		con_ahead = _con_receive(con_idle_polls < CONBUF_IDLE_POLLS ? 0 : CONBUF_IDLE_MS);
+		con_poll_at = CONBUF_MILLIS();
+	}
+	if (con_ahead < 0) {
+		if (con_idle_polls < CONBUF_IDLE_POLLS)
+			con_idle_polls++;
+		return 0;
+	}
+	con_idle_polls = 0;
+	return 1;
+}
+
+uint8 _getch(void) {
+	_conbuf_flush();
+	con_idle_polls = 0;
+	int ch = con_ahead;
+	con_ahead = -1;
+	while (ch < 0)
+		ch = _con_receive(CONBUF_WAIT_MS);
+	return ch;
+}
+
+void _putch(uint8 ch) {
+	con_idle_polls = 0;
+	if (conbuf_len == 0)
+		conbuf_since = CONBUF_MILLIS();
+	conbuf[conbuf_len++] = ch;
+	if (conbuf_len == CONBUF_SIZE)
+		_conbuf_flush();
+	else
+		_conbuf_idle();
+}
+
+uint8 _getche(void) {
+	uint8 ch = _getch();
+	_putch(ch);
+	return ch;
+}
+
+#endif
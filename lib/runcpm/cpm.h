@@ -447,9 +447,15 @@ void _Bios(void) {
 #ifdef DEBUGLOG
 	_logBiosIn(ch);
 #endif
+#ifdef CONSOLE_BUFFER_H
+	_conbuf_idle();
+#endif
 
 	switch (ch) {
 		case 0x00: {
+#ifdef DISK_CACHE
+			_dc_reset();
+#endif
 			Status = 1; // 0 - BOOT - Ends RunCPM
 			break;
 		}
@@ -570,6 +576,12 @@ void _Bdos(void) {
 #ifdef DEBUGLOG
 	_logBdosIn(ch);
 #endif
+#ifdef CONSOLE_BUFFER_H
+	if (ch > GET_VERSION)
+		_conbuf_flush();
+	else
+		_conbuf_idle();
+#endif
 
 	HL = 0x0000;                            // HL is reset by the BDOS
 	SET_LOW_REGISTER(BC, LOW_REGISTER(DE)); // C ends up equal to E
@@ -977,6 +989,9 @@ void _Bdos(void) {
 		   C = 13 (0Dh) : Reset disk system
 		 */
 		case DRV_ALLRESET: {
+#ifdef DISK_CACHE
+			_dc_reset();        // Writes back and closes all files
+#endif
 			roVector = 0;       // Make all drives R/W
 			loginVector = 0;
 			dmaAddr = 0x0080;
@@ -18,7 +18,7 @@ int32 DE1; /* alternate DE register                        */
 int32 HL1; /* alternate HL register                        */
 int32 IFF; /* Interrupt Flip Flop                          */
 int32 IR;  /* Interrupt (upper) / Refresh (lower) register */
-int32 Status = 0; /* Status of the CPU 0=running 1=end request 2=back to CCP */
+volatile int32 Status = 0; /* Status of the CPU 0=running 1=end request 2=back to CCP, can be set from another task */
 int32 Debug = 0;
 int32 Break = -1;
 int32 Step = -1;
@@ -1132,14 +1132,30 @@ static void PUT_BYTE(uint32 Addr, uint32 Value) {
 	_RamWrite(Addr & ADDRMASK, Value);
 }
 
+#ifdef RAM_FAST
+/* Straight from RAM unless the word wraps round the top of memory */
+static inline uint16 GET_WORD(uint32 a) {
+	a &= ADDRMASK;
+	if (a != ADDRMASK)
+		return RAM[a] | (RAM[a + 1] << 8);
+	return RAM[ADDRMASK] | (RAM[0] << 8);
+}
+
+static inline void PUT_WORD(uint32 Addr, uint32 Value) {
+	Addr &= ADDRMASK;
+	RAM[Addr] = Value;
+	RAM[(Addr + 1) & ADDRMASK] = Value >> 8;
+}
+#else
 static uint16 GET_WORD(uint32 a) {
 	return GET_BYTE(a) | (GET_BYTE(a + 1) << 8);
 }
 
 static void PUT_WORD(uint32 Addr, uint32 Value) {
-	_RamWrite(Addr, Value);
-	_RamWrite(++Addr, Value >> 8);
+	PUT_BYTE(Addr, Value);
+	PUT_BYTE(Addr + 1, Value >> 8);
 }
+#endif
 
 #define RAM_MM(a)   GET_BYTE(a--)
 #define RAM_PP(a)   GET_BYTE(a++)
@@ -1459,6 +1475,43 @@ void Z80debug(void) {
 }
 #endif
 
+/* Threaded dispatch needs the GCC labels as values extension, and the debuggers need the main loop */
+#if defined(Z80_THREADED) && (!defined(__GNUC__) || defined(DEBUG) || defined(iDEBUG))
+#undef Z80_THREADED
+#endif
+
+#ifdef Z80_COUNT
+uint64_t Z80instructions = 0;	/* instructions run since the last reset */
+#define COUNT_INSTR ++Z80instructions
+#else
+#define COUNT_INSTR
+#endif
+
+/*
+	OP(n) labels the code for opcode n. With Z80_THREADED it is also a label
+	the code before it can jump straight to, and NEXT ends each instruction by
+	fetching the next one and jumping to its code, so every opcode has its own
+	indirect branch to predict. Otherwise NEXT goes back round the main loop.
+*/
+#ifdef Z80_THREADED
+#define OP(n)	case n: op_##n
+#define NEXT	do {                                \
+	if (Status)                                     \
+		goto end_decode;                            \
+	PCX = PC;                                       \
+	INCR(1);                                        \
+	COUNT_INSTR;                                    \
+	goto *opcodes[RAM_PP(PC)];                      \
+} while (0)
+#define OPS16(h)	&&op_0x##h##0, &&op_0x##h##1, &&op_0x##h##2, &&op_0x##h##3, \
+	&&op_0x##h##4, &&op_0x##h##5, &&op_0x##h##6, &&op_0x##h##7, \
+	&&op_0x##h##8, &&op_0x##h##9, &&op_0x##h##a, &&op_0x##h##b, \
+	&&op_0x##h##c, &&op_0x##h##d, &&op_0x##h##e, &&op_0x##h##f
+#else
+#define OP(n)	case n
+#define NEXT	break
+#endif
+
 static inline void Z80run(void) {
 	uint32 temp = 0;
 	uint32 acu = 0;
@@ -1467,6 +1520,13 @@ static inline void Z80run(void) {
 	uint32 op = 0;
 	uint32 adr = 0;
 
+#ifdef Z80_THREADED
+	static const void* const opcodes[256] = {
+		OPS16(0), OPS16(1), OPS16(2), OPS16(3), OPS16(4), OPS16(5), OPS16(6), OPS16(7),
+		OPS16(8), OPS16(9), OPS16(a), OPS16(b), OPS16(c), OPS16(d), OPS16(e), OPS16(f)
+	};
+#endif
+
 	/* main instruction fetch/decode loop */
 	while (!Status) {	/* loop until Status != 0 */
 
@@ -1487,6 +1547,7 @@ static inline void Z80run(void) {
 
 		PCX = PC;
 		INCR(1); /* Add one M1 cycle to refresh counter */
+		COUNT_INSTR;
 
 #ifdef iDEBUG
 		iLogFile = fopen("iDump.log", "a");
@@ -1509,205 +1570,205 @@ static inline void Z80run(void) {
 
 		switch (RAM_PP(PC)) {
 
-		case 0x00:      /* NOP */
-			break;
+		OP(0x00):      /* NOP */
+			NEXT;
 
-		case 0x01:      /* LD BC,nnnn */
+		OP(0x01):      /* LD BC,nnnn */
 			BC = GET_WORD(PC);
 			PC += 2;
-			break;
+			NEXT;
 
-		case 0x02:      /* LD (BC),A */
+		OP(0x02):      /* LD (BC),A */
 			PUT_BYTE(BC, HIGH_REGISTER(AF));
-			break;
+			NEXT;
 
-		case 0x03:      /* INC BC */
+		OP(0x03):      /* INC BC */
 			++BC;
-			break;
+			NEXT;
 
-		case 0x04:      /* INC B */
+		OP(0x04):      /* INC B */
 			BC += 0x100;
 			temp = HIGH_REGISTER(BC);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80); /* SET_PV2 uses temp */
-			break;
+			NEXT;
 
-		case 0x05:      /* DEC B */
+		OP(0x05):      /* DEC B */
 			BC -= 0x100;
 			temp = HIGH_REGISTER(BC);
 			AF = (AF & ~0xfe) | decTable[temp] | SET_PV2(0x7f); /* SET_PV2 uses temp */
-			break;
+			NEXT;
 
-		case 0x06:      /* LD B,nn */
+		OP(0x06):      /* LD B,nn */
 			SET_HIGH_REGISTER(BC, RAM_PP(PC));
-			break;
+			NEXT;
 
-		case 0x07:      /* RLCA */
+		OP(0x07):      /* RLCA */
 			AF = ((AF >> 7) & 0x0128) | ((AF << 1) & ~0x1ff) |
 				(AF & 0xc4) | ((AF >> 15) & 1);
-			break;
+			NEXT;
 
-		case 0x08:      /* EX AF,AF' */
+		OP(0x08):      /* EX AF,AF' */
 			temp = AF;
 			AF = AF1;
 			AF1 = temp;
-			break;
+			NEXT;
 
-		case 0x09:      /* ADD HL,BC */
+		OP(0x09):      /* ADD HL,BC */
 			HL &= ADDRMASK;
 			BC &= ADDRMASK;
 			sum = HL + BC;
 			AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(HL ^ BC ^ sum) >> 8];
 			HL = sum;
-			break;
+			NEXT;
 
-		case 0x0a:      /* LD A,(BC) */
+		OP(0x0a):      /* LD A,(BC) */
 			SET_HIGH_REGISTER(AF, GET_BYTE(BC));
-			break;
+			NEXT;
 
-		case 0x0b:      /* DEC BC */
+		OP(0x0b):      /* DEC BC */
 			--BC;
-			break;
+			NEXT;
 
-		case 0x0c:      /* INC C */
+		OP(0x0c):      /* INC C */
 			temp = LOW_REGISTER(BC) + 1;
 			SET_LOW_REGISTER(BC, temp);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80);
-			break;
+			NEXT;
 
-		case 0x0d:      /* DEC C */
+		OP(0x0d):      /* DEC C */
 			temp = LOW_REGISTER(BC) - 1;
 			SET_LOW_REGISTER(BC, temp);
 			AF = (AF & ~0xfe) | decTable[temp & 0xff] | SET_PV2(0x7f);
-			break;
+			NEXT;
 
-		case 0x0e:      /* LD C,nn */
+		OP(0x0e):      /* LD C,nn */
 			SET_LOW_REGISTER(BC, RAM_PP(PC));
-			break;
+			NEXT;
 
-		case 0x0f:      /* RRCA */
+		OP(0x0f):      /* RRCA */
 			AF = (AF & 0xc4) | rrcaTable[HIGH_REGISTER(AF)];
-			break;
+			NEXT;
 
-		case 0x10:      /* DJNZ dd */
+		OP(0x10):      /* DJNZ dd */
 			if ((BC -= 0x100) & 0xff00)
 				PC += (int8)GET_BYTE(PC) + 1;
 			else
 				++PC;
-			break;
+			NEXT;
 
-		case 0x11:      /* LD DE,nnnn */
+		OP(0x11):      /* LD DE,nnnn */
 			DE = GET_WORD(PC);
 			PC += 2;
-			break;
+			NEXT;
 
-		case 0x12:      /* LD (DE),A */
+		OP(0x12):      /* LD (DE),A */
 			PUT_BYTE(DE, HIGH_REGISTER(AF));
-			break;
+			NEXT;
 
-		case 0x13:      /* INC DE */
+		OP(0x13):      /* INC DE */
 			++DE;
-			break;
+			NEXT;
 
-		case 0x14:      /* INC D */
+		OP(0x14):      /* INC D */
 			DE += 0x100;
 			temp = HIGH_REGISTER(DE);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80); /* SET_PV2 uses temp */
-			break;
+			NEXT;
 
-		case 0x15:      /* DEC D */
+		OP(0x15):      /* DEC D */
 			DE -= 0x100;
 			temp = HIGH_REGISTER(DE);
 			AF = (AF & ~0xfe) | decTable[temp] | SET_PV2(0x7f); /* SET_PV2 uses temp */
-			break;
+			NEXT;
 
-		case 0x16:      /* LD D,nn */
+		OP(0x16):      /* LD D,nn */
 			SET_HIGH_REGISTER(DE, RAM_PP(PC));
-			break;
+			NEXT;
 
-		case 0x17:      /* RLA */
+		OP(0x17):      /* RLA */
 			AF = ((AF << 8) & 0x0100) | ((AF >> 7) & 0x28) | ((AF << 1) & ~0x01ff) |
 				(AF & 0xc4) | ((AF >> 15) & 1);
-			break;
+			NEXT;
 
-		case 0x18:      /* JR dd */
+		OP(0x18):      /* JR dd */
 			PC += (int8)GET_BYTE(PC) + 1;
-			break;
+			NEXT;
 
-		case 0x19:      /* ADD HL,DE */
+		OP(0x19):      /* ADD HL,DE */
 			HL &= ADDRMASK;
 			DE &= ADDRMASK;
 			sum = HL + DE;
 			AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(HL ^ DE ^ sum) >> 8];
 			HL = sum;
-			break;
+			NEXT;
 
-		case 0x1a:      /* LD A,(DE) */
+		OP(0x1a):      /* LD A,(DE) */
 			SET_HIGH_REGISTER(AF, GET_BYTE(DE));
-			break;
+			NEXT;
 
-		case 0x1b:      /* DEC DE */
+		OP(0x1b):      /* DEC DE */
 			--DE;
-			break;
+			NEXT;
 
-		case 0x1c:      /* INC E */
+		OP(0x1c):      /* INC E */
 			temp = LOW_REGISTER(DE) + 1;
 			SET_LOW_REGISTER(DE, temp);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80);
-			break;
+			NEXT;
 
-		case 0x1d:      /* DEC E */
+		OP(0x1d):      /* DEC E */
 			temp = LOW_REGISTER(DE) - 1;
 			SET_LOW_REGISTER(DE, temp);
 			AF = (AF & ~0xfe) | decTable[temp & 0xff] | SET_PV2(0x7f);
-			break;
+			NEXT;
 
-		case 0x1e:      /* LD E,nn */
+		OP(0x1e):      /* LD E,nn */
 			SET_LOW_REGISTER(DE, RAM_PP(PC));
-			break;
+			NEXT;
 
-		case 0x1f:      /* RRA */
+		OP(0x1f):      /* RRA */
 			AF = ((AF & 1) << 15) | (AF & 0xc4) | rraTable[HIGH_REGISTER(AF)];
-			break;
+			NEXT;
 
-		case 0x20:      /* JR NZ,dd */
+		OP(0x20):      /* JR NZ,dd */
 			if (TSTFLAG(Z))
 				++PC;
 			else
 				PC += (int8)GET_BYTE(PC) + 1;
-			break;
+			NEXT;
 
-		case 0x21:      /* LD HL,nnnn */
+		OP(0x21):      /* LD HL,nnnn */
 			HL = GET_WORD(PC);
 			PC += 2;
-			break;
+			NEXT;
 
-		case 0x22:      /* LD (nnnn),HL */
+		OP(0x22):      /* LD (nnnn),HL */
 			temp = GET_WORD(PC);
 			PUT_WORD(temp, HL);
 			PC += 2;
-			break;
+			NEXT;
 
-		case 0x23:      /* INC HL */
+		OP(0x23):      /* INC HL */
 			++HL;
-			break;
+			NEXT;
 
-		case 0x24:      /* INC H */
+		OP(0x24):      /* INC H */
 			HL += 0x100;
 			temp = HIGH_REGISTER(HL);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80); /* SET_PV2 uses temp */
-			break;
+			NEXT;
 
-		case 0x25:      /* DEC H */
+		OP(0x25):      /* DEC H */
 			HL -= 0x100;
 			temp = HIGH_REGISTER(HL);
 			AF = (AF & ~0xfe) | decTable[temp] | SET_PV2(0x7f); /* SET_PV2 uses temp */
-			break;
+			NEXT;
 
-		case 0x26:      /* LD H,nn */
+		OP(0x26):      /* LD H,nn */
 			SET_HIGH_REGISTER(HL, RAM_PP(PC));
-			break;
+			NEXT;
 
-		case 0x27:      /* DAA */
+		OP(0x27):      /* DAA */
 			acu = HIGH_REGISTER(AF);
 			temp = LOW_DIGIT(acu);
 			cbits = TSTFLAG(C);
@@ -1730,350 +1791,350 @@ static inline void Z80run(void) {
 					acu += 0x60;   /* adjust high digit */
 			}
 			AF = (AF & 0x12) | rrdrldTable[acu & 0xff] | ((acu >> 8) & 1) | cbits;
-			break;
+			NEXT;
 
-		case 0x28:      /* JR Z,dd */
+		OP(0x28):      /* JR Z,dd */
 			if (TSTFLAG(Z))
 				PC += (int8)GET_BYTE(PC) + 1;
 			else
 				++PC;
-			break;
+			NEXT;
 
-		case 0x29:      /* ADD HL,HL */
+		OP(0x29):      /* ADD HL,HL */
 			HL &= ADDRMASK;
 			sum = HL + HL;
 			AF = (AF & ~0x3b) | cbitsDup16Table[sum >> 8];
 			HL = sum;
-			break;
+			NEXT;
 
-		case 0x2a:      /* LD HL,(nnnn) */
+		OP(0x2a):      /* LD HL,(nnnn) */
 			temp = GET_WORD(PC);
 			HL = GET_WORD(temp);
 			PC += 2;
-			break;
+			NEXT;
 
-		case 0x2b:      /* DEC HL */
+		OP(0x2b):      /* DEC HL */
 			--HL;
-			break;
+			NEXT;
 
-		case 0x2c:      /* INC L */
+		OP(0x2c):      /* INC L */
 			temp = LOW_REGISTER(HL) + 1;
 			SET_LOW_REGISTER(HL, temp);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80);
-			break;
+			NEXT;
 
-		case 0x2d:      /* DEC L */
+		OP(0x2d):      /* DEC L */
 			temp = LOW_REGISTER(HL) - 1;
 			SET_LOW_REGISTER(HL, temp);
 			AF = (AF & ~0xfe) | decTable[temp & 0xff] | SET_PV2(0x7f);
-			break;
+			NEXT;
 
-		case 0x2e:      /* LD L,nn */
+		OP(0x2e):      /* LD L,nn */
 			SET_LOW_REGISTER(HL, RAM_PP(PC));
-			break;
+			NEXT;
 
-		case 0x2f:      /* CPL */
+		OP(0x2f):      /* CPL */
 			AF = (~AF & ~0xff) | (AF & 0xc5) | ((~AF >> 8) & 0x28) | 0x12;
-			break;
+			NEXT;
 
-		case 0x30:      /* JR NC,dd */
+		OP(0x30):      /* JR NC,dd */
 			if (TSTFLAG(C))
 				++PC;
 			else
 				PC += (int8)GET_BYTE(PC) + 1;
-			break;
+			NEXT;
 
-		case 0x31:      /* LD SP,nnnn */
+		OP(0x31):      /* LD SP,nnnn */
 			SP = GET_WORD(PC);
 			PC += 2;
-			break;
+			NEXT;
 
-		case 0x32:      /* LD (nnnn),A */
+		OP(0x32):      /* LD (nnnn),A */
 			temp = GET_WORD(PC);
 			PUT_BYTE(temp, HIGH_REGISTER(AF));
 			PC += 2;
-			break;
+			NEXT;
 
-		case 0x33:      /* INC SP */
+		OP(0x33):      /* INC SP */
 			++SP;
-			break;
+			NEXT;
 
-		case 0x34:      /* INC (HL) */
+		OP(0x34):      /* INC (HL) */
 			temp = GET_BYTE(HL) + 1;
 			PUT_BYTE(HL, temp);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80);
-			break;
+			NEXT;
 
-		case 0x35:      /* DEC (HL) */
+		OP(0x35):      /* DEC (HL) */
 			temp = GET_BYTE(HL) - 1;
 			PUT_BYTE(HL, temp);
 			AF = (AF & ~0xfe) | decTable[temp & 0xff] | SET_PV2(0x7f);
-			break;
+			NEXT;
 
-		case 0x36:      /* LD (HL),nn */
+		OP(0x36):      /* LD (HL),nn */
 			PUT_BYTE(HL, RAM_PP(PC));
-			break;
+			NEXT;
 
-		case 0x37:      /* SCF */
+		OP(0x37):      /* SCF */
 			AF = (AF & ~0x3b) | ((AF >> 8) & 0x28) | 1;
-			break;
+			NEXT;
 
-		case 0x38:      /* JR C,dd */
+		OP(0x38):      /* JR C,dd */
 			if (TSTFLAG(C))
 				PC += (int8)GET_BYTE(PC) + 1;
 			else
 				++PC;
-			break;
+			NEXT;
 
-		case 0x39:      /* ADD HL,SP */
+		OP(0x39):      /* ADD HL,SP */
 			HL &= ADDRMASK;
 			SP &= ADDRMASK;
 			sum = HL + SP;
 			AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(HL ^ SP ^ sum) >> 8];
 			HL = sum;
-			break;
+			NEXT;
 
-		case 0x3a:      /* LD A,(nnnn) */
+		OP(0x3a):      /* LD A,(nnnn) */
 			temp = GET_WORD(PC);
 			SET_HIGH_REGISTER(AF, GET_BYTE(temp));
 			PC += 2;
-			break;
+			NEXT;
 
-		case 0x3b:      /* DEC SP */
+		OP(0x3b):      /* DEC SP */
 			--SP;
-			break;
+			NEXT;
 
-		case 0x3c:      /* INC A */
+		OP(0x3c):      /* INC A */
 			AF += 0x100;
 			temp = HIGH_REGISTER(AF);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80); /* SET_PV2 uses temp */
-			break;
+			NEXT;
 
-		case 0x3d:      /* DEC A */
+		OP(0x3d):      /* DEC A */
 			AF -= 0x100;
 			temp = HIGH_REGISTER(AF);
 			AF = (AF & ~0xfe) | decTable[temp] | SET_PV2(0x7f); /* SET_PV2 uses temp */
-			break;
+			NEXT;
 
-		case 0x3e:      /* LD A,nn */
+		OP(0x3e):      /* LD A,nn */
 			SET_HIGH_REGISTER(AF, RAM_PP(PC));
-			break;
+			NEXT;
 
-		case 0x3f:      /* CCF */
+		OP(0x3f):      /* CCF */
 			AF = (AF & ~0x3b) | ((AF >> 8) & 0x28) | ((AF & 1) << 4) | (~AF & 1);
-			break;
+			NEXT;
 
-		case 0x40:      /* LD B,B */
-			break;
+		OP(0x40):      /* LD B,B */
+			NEXT;
 
-		case 0x41:      /* LD B,C */
+		OP(0x41):      /* LD B,C */
 			BC = (BC & 0xff) | ((BC & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x42:      /* LD B,D */
+		OP(0x42):      /* LD B,D */
 			BC = (BC & 0xff) | (DE & ~0xff);
-			break;
+			NEXT;
 
-		case 0x43:      /* LD B,E */
+		OP(0x43):      /* LD B,E */
 			BC = (BC & 0xff) | ((DE & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x44:      /* LD B,H */
+		OP(0x44):      /* LD B,H */
 			BC = (BC & 0xff) | (HL & ~0xff);
-			break;
+			NEXT;
 
-		case 0x45:      /* LD B,L */
+		OP(0x45):      /* LD B,L */
 			BC = (BC & 0xff) | ((HL & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x46:      /* LD B,(HL) */
+		OP(0x46):      /* LD B,(HL) */
 			SET_HIGH_REGISTER(BC, GET_BYTE(HL));
-			break;
+			NEXT;
 
-		case 0x47:      /* LD B,A */
+		OP(0x47):      /* LD B,A */
 			BC = (BC & 0xff) | (AF & ~0xff);
-			break;
+			NEXT;
 
-		case 0x48:      /* LD C,B */
+		OP(0x48):      /* LD C,B */
 			BC = (BC & ~0xff) | ((BC >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x49:      /* LD C,C */
-			break;
+		OP(0x49):      /* LD C,C */
+			NEXT;
 
-		case 0x4a:      /* LD C,D */
+		OP(0x4a):      /* LD C,D */
 			BC = (BC & ~0xff) | ((DE >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x4b:      /* LD C,E */
+		OP(0x4b):      /* LD C,E */
 			BC = (BC & ~0xff) | (DE & 0xff);
-			break;
+			NEXT;
 
-		case 0x4c:      /* LD C,H */
+		OP(0x4c):      /* LD C,H */
 			BC = (BC & ~0xff) | ((HL >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x4d:      /* LD C,L */
+		OP(0x4d):      /* LD C,L */
 			BC = (BC & ~0xff) | (HL & 0xff);
-			break;
+			NEXT;
 
-		case 0x4e:      /* LD C,(HL) */
+		OP(0x4e):      /* LD C,(HL) */
 			SET_LOW_REGISTER(BC, GET_BYTE(HL));
-			break;
+			NEXT;
 
-		case 0x4f:      /* LD C,A */
+		OP(0x4f):      /* LD C,A */
 			BC = (BC & ~0xff) | ((AF >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x50:      /* LD D,B */
+		OP(0x50):      /* LD D,B */
 			DE = (DE & 0xff) | (BC & ~0xff);
-			break;
+			NEXT;
 
-		case 0x51:      /* LD D,C */
+		OP(0x51):      /* LD D,C */
 			DE = (DE & 0xff) | ((BC & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x52:      /* LD D,D */
-			break;
+		OP(0x52):      /* LD D,D */
+			NEXT;
 
-		case 0x53:      /* LD D,E */
+		OP(0x53):      /* LD D,E */
 			DE = (DE & 0xff) | ((DE & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x54:      /* LD D,H */
+		OP(0x54):      /* LD D,H */
 			DE = (DE & 0xff) | (HL & ~0xff);
-			break;
+			NEXT;
 
-		case 0x55:      /* LD D,L */
+		OP(0x55):      /* LD D,L */
 			DE = (DE & 0xff) | ((HL & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x56:      /* LD D,(HL) */
+		OP(0x56):      /* LD D,(HL) */
 			SET_HIGH_REGISTER(DE, GET_BYTE(HL));
-			break;
+			NEXT;
 
-		case 0x57:      /* LD D,A */
+		OP(0x57):      /* LD D,A */
 			DE = (DE & 0xff) | (AF & ~0xff);
-			break;
+			NEXT;
 
-		case 0x58:      /* LD E,B */
+		OP(0x58):      /* LD E,B */
 			DE = (DE & ~0xff) | ((BC >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x59:      /* LD E,C */
+		OP(0x59):      /* LD E,C */
 			DE = (DE & ~0xff) | (BC & 0xff);
-			break;
+			NEXT;
 
-		case 0x5a:      /* LD E,D */
+		OP(0x5a):      /* LD E,D */
 			DE = (DE & ~0xff) | ((DE >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x5b:      /* LD E,E */
-			break;
+		OP(0x5b):      /* LD E,E */
+			NEXT;
 
-		case 0x5c:      /* LD E,H */
+		OP(0x5c):      /* LD E,H */
 			DE = (DE & ~0xff) | ((HL >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x5d:      /* LD E,L */
+		OP(0x5d):      /* LD E,L */
 			DE = (DE & ~0xff) | (HL & 0xff);
-			break;
+			NEXT;
 
-		case 0x5e:      /* LD E,(HL) */
+		OP(0x5e):      /* LD E,(HL) */
 			SET_LOW_REGISTER(DE, GET_BYTE(HL));
-			break;
+			NEXT;
 
-		case 0x5f:      /* LD E,A */
+		OP(0x5f):      /* LD E,A */
 			DE = (DE & ~0xff) | ((AF >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x60:      /* LD H,B */
+		OP(0x60):      /* LD H,B */
 			HL = (HL & 0xff) | (BC & ~0xff);
-			break;
+			NEXT;
 
-		case 0x61:      /* LD H,C */
+		OP(0x61):      /* LD H,C */
 			HL = (HL & 0xff) | ((BC & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x62:      /* LD H,D */
+		OP(0x62):      /* LD H,D */
 			HL = (HL & 0xff) | (DE & ~0xff);
-			break;
+			NEXT;
 
-		case 0x63:      /* LD H,E */
+		OP(0x63):      /* LD H,E */
 			HL = (HL & 0xff) | ((DE & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x64:      /* LD H,H */
-			break;
+		OP(0x64):      /* LD H,H */
+			NEXT;
 
-		case 0x65:      /* LD H,L */
+		OP(0x65):      /* LD H,L */
 			HL = (HL & 0xff) | ((HL & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x66:      /* LD H,(HL) */
+		OP(0x66):      /* LD H,(HL) */
 			SET_HIGH_REGISTER(HL, GET_BYTE(HL));
-			break;
+			NEXT;
 
-		case 0x67:      /* LD H,A */
+		OP(0x67):      /* LD H,A */
 			HL = (HL & 0xff) | (AF & ~0xff);
-			break;
+			NEXT;
 
-		case 0x68:      /* LD L,B */
+		OP(0x68):      /* LD L,B */
 			HL = (HL & ~0xff) | ((BC >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x69:      /* LD L,C */
+		OP(0x69):      /* LD L,C */
 			HL = (HL & ~0xff) | (BC & 0xff);
-			break;
+			NEXT;
 
-		case 0x6a:      /* LD L,D */
+		OP(0x6a):      /* LD L,D */
 			HL = (HL & ~0xff) | ((DE >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x6b:      /* LD L,E */
+		OP(0x6b):      /* LD L,E */
 			HL = (HL & ~0xff) | (DE & 0xff);
-			break;
+			NEXT;
 
-		case 0x6c:      /* LD L,H */
+		OP(0x6c):      /* LD L,H */
 			HL = (HL & ~0xff) | ((HL >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x6d:      /* LD L,L */
-			break;
+		OP(0x6d):      /* LD L,L */
+			NEXT;
 
-		case 0x6e:      /* LD L,(HL) */
+		OP(0x6e):      /* LD L,(HL) */
 			SET_LOW_REGISTER(HL, GET_BYTE(HL));
-			break;
+			NEXT;
 
-		case 0x6f:      /* LD L,A */
+		OP(0x6f):      /* LD L,A */
 			HL = (HL & ~0xff) | ((AF >> 8) & 0xff);
-			break;
+			NEXT;
 
-		case 0x70:      /* LD (HL),B */
+		OP(0x70):      /* LD (HL),B */
 			PUT_BYTE(HL, HIGH_REGISTER(BC));
-			break;
+			NEXT;
 
-		case 0x71:      /* LD (HL),C */
+		OP(0x71):      /* LD (HL),C */
 			PUT_BYTE(HL, LOW_REGISTER(BC));
-			break;
+			NEXT;
 
-		case 0x72:      /* LD (HL),D */
+		OP(0x72):      /* LD (HL),D */
 			PUT_BYTE(HL, HIGH_REGISTER(DE));
-			break;
+			NEXT;
 
-		case 0x73:      /* LD (HL),E */
+		OP(0x73):      /* LD (HL),E */
 			PUT_BYTE(HL, LOW_REGISTER(DE));
-			break;
+			NEXT;
 
-		case 0x74:      /* LD (HL),H */
+		OP(0x74):      /* LD (HL),H */
 			PUT_BYTE(HL, HIGH_REGISTER(HL));
-			break;
+			NEXT;
 
-		case 0x75:      /* LD (HL),L */
+		OP(0x75):      /* LD (HL),L */
 			PUT_BYTE(HL, LOW_REGISTER(HL));
-			break;
+			NEXT;
 
-		case 0x76:      /* HALT */
+		OP(0x76):      /* HALT */
 #ifdef DEBUG
 			_puts("\r\n::CPU HALTED::");	// A halt is a good indicator of broken code
 			_puts("Press any key...");
@@ -2081,383 +2142,383 @@ static inline void Z80run(void) {
 #endif
 			--PC;
 			goto end_decode;
-			break;
+			NEXT;
 
-		case 0x77:      /* LD (HL),A */
+		OP(0x77):      /* LD (HL),A */
 			PUT_BYTE(HL, HIGH_REGISTER(AF));
-			break;
+			NEXT;
 
-		case 0x78:      /* LD A,B */
+		OP(0x78):      /* LD A,B */
 			AF = (AF & 0xff) | (BC & ~0xff);
-			break;
+			NEXT;
 
-		case 0x79:      /* LD A,C */
+		OP(0x79):      /* LD A,C */
 			AF = (AF & 0xff) | ((BC & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x7a:      /* LD A,D */
+		OP(0x7a):      /* LD A,D */
 			AF = (AF & 0xff) | (DE & ~0xff);
-			break;
+			NEXT;
 
-		case 0x7b:      /* LD A,E */
+		OP(0x7b):      /* LD A,E */
 			AF = (AF & 0xff) | ((DE & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x7c:      /* LD A,H */
+		OP(0x7c):      /* LD A,H */
 			AF = (AF & 0xff) | (HL & ~0xff);
-			break;
+			NEXT;
 
-		case 0x7d:      /* LD A,L */
+		OP(0x7d):      /* LD A,L */
 			AF = (AF & 0xff) | ((HL & 0xff) << 8);
-			break;
+			NEXT;
 
-		case 0x7e:      /* LD A,(HL) */
+		OP(0x7e):      /* LD A,(HL) */
 			SET_HIGH_REGISTER(AF, GET_BYTE(HL));
-			break;
+			NEXT;
 
-		case 0x7f:      /* LD A,A */
-			break;
+		OP(0x7f):      /* LD A,A */
+			NEXT;
 
-		case 0x80:      /* ADD A,B */
+		OP(0x80):      /* ADD A,B */
 			temp = HIGH_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x81:      /* ADD A,C */
+		OP(0x81):      /* ADD A,C */
 			temp = LOW_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x82:      /* ADD A,D */
+		OP(0x82):      /* ADD A,D */
 			temp = HIGH_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x83:      /* ADD A,E */
+		OP(0x83):      /* ADD A,E */
 			temp = LOW_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x84:      /* ADD A,H */
+		OP(0x84):      /* ADD A,H */
 			temp = HIGH_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x85:      /* ADD A,L */
+		OP(0x85):      /* ADD A,L */
 			temp = LOW_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x86:      /* ADD A,(HL) */
+		OP(0x86):      /* ADD A,(HL) */
 			temp = GET_BYTE(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x87:      /* ADD A,A */
+		OP(0x87):      /* ADD A,A */
 			cbits = 2 * HIGH_REGISTER(AF);
 			AF = cbitsDup8Table[cbits] | (SET_PVS(cbits));
-			break;
+			NEXT;
 
-		case 0x88:      /* ADC A,B */
+		OP(0x88):      /* ADC A,B */
 			temp = HIGH_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x89:      /* ADC A,C */
+		OP(0x89):      /* ADC A,C */
 			temp = LOW_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x8a:      /* ADC A,D */
+		OP(0x8a):      /* ADC A,D */
 			temp = HIGH_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x8b:      /* ADC A,E */
+		OP(0x8b):      /* ADC A,E */
 			temp = LOW_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x8c:      /* ADC A,H */
+		OP(0x8c):      /* ADC A,H */
 			temp = HIGH_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x8d:      /* ADC A,L */
+		OP(0x8d):      /* ADC A,L */
 			temp = LOW_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x8e:      /* ADC A,(HL) */
+		OP(0x8e):      /* ADC A,(HL) */
 			temp = GET_BYTE(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x8f:      /* ADC A,A */
+		OP(0x8f):      /* ADC A,A */
 			cbits = 2 * HIGH_REGISTER(AF) + TSTFLAG(C);
 			AF = cbitsDup8Table[cbits] | (SET_PVS(cbits));
-			break;
+			NEXT;
 
-		case 0x90:      /* SUB B */
+		OP(0x90):      /* SUB B */
 			temp = HIGH_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x91:      /* SUB C */
+		OP(0x91):      /* SUB C */
 			temp = LOW_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x92:      /* SUB D */
+		OP(0x92):      /* SUB D */
 			temp = HIGH_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x93:      /* SUB E */
+		OP(0x93):      /* SUB E */
 			temp = LOW_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x94:      /* SUB H */
+		OP(0x94):      /* SUB H */
 			temp = HIGH_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x95:      /* SUB L */
+		OP(0x95):      /* SUB L */
 			temp = LOW_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x96:      /* SUB (HL) */
+		OP(0x96):      /* SUB (HL) */
 			temp = GET_BYTE(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x97:      /* SUB A */
+		OP(0x97):      /* SUB A */
 			AF = 0x42;
-			break;
+			NEXT;
 
-		case 0x98:      /* SBC A,B */
+		OP(0x98):      /* SBC A,B */
 			temp = HIGH_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x99:      /* SBC A,C */
+		OP(0x99):      /* SBC A,C */
 			temp = LOW_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x9a:      /* SBC A,D */
+		OP(0x9a):      /* SBC A,D */
 			temp = HIGH_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x9b:      /* SBC A,E */
+		OP(0x9b):      /* SBC A,E */
 			temp = LOW_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x9c:      /* SBC A,H */
+		OP(0x9c):      /* SBC A,H */
 			temp = HIGH_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x9d:      /* SBC A,L */
+		OP(0x9d):      /* SBC A,L */
 			temp = LOW_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x9e:      /* SBC A,(HL) */
+		OP(0x9e):      /* SBC A,(HL) */
 			temp = GET_BYTE(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0x9f:      /* SBC A,A */
+		OP(0x9f):      /* SBC A,A */
 			cbits = -TSTFLAG(C);
 			AF = subTable[cbits & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PVS(cbits));
-			break;
+			NEXT;
 
-		case 0xa0:      /* AND B */
+		OP(0xa0):      /* AND B */
 			AF = andTable[((AF & BC) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa1:      /* AND C */
+		OP(0xa1):      /* AND C */
 			AF = andTable[((AF >> 8)& BC) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa2:      /* AND D */
+		OP(0xa2):      /* AND D */
 			AF = andTable[((AF & DE) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa3:      /* AND E */
+		OP(0xa3):      /* AND E */
 			AF = andTable[((AF >> 8)& DE) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa4:      /* AND H */
+		OP(0xa4):      /* AND H */
 			AF = andTable[((AF & HL) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa5:      /* AND L */
+		OP(0xa5):      /* AND L */
 			AF = andTable[((AF >> 8)& HL) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa6:      /* AND (HL) */
+		OP(0xa6):      /* AND (HL) */
 			AF = andTable[((AF >> 8)& GET_BYTE(HL)) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa7:      /* AND A */
+		OP(0xa7):      /* AND A */
 			AF = andTable[(AF >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa8:      /* XOR B */
+		OP(0xa8):      /* XOR B */
 			AF = xororTable[((AF ^ BC) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xa9:      /* XOR C */
+		OP(0xa9):      /* XOR C */
 			AF = xororTable[((AF >> 8) ^ BC) & 0xff];
-			break;
+			NEXT;
 
-		case 0xaa:      /* XOR D */
+		OP(0xaa):      /* XOR D */
 			AF = xororTable[((AF ^ DE) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xab:      /* XOR E */
+		OP(0xab):      /* XOR E */
 			AF = xororTable[((AF >> 8) ^ DE) & 0xff];
-			break;
+			NEXT;
 
-		case 0xac:      /* XOR H */
+		OP(0xac):      /* XOR H */
 			AF = xororTable[((AF ^ HL) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xad:      /* XOR L */
+		OP(0xad):      /* XOR L */
 			AF = xororTable[((AF >> 8) ^ HL) & 0xff];
-			break;
+			NEXT;
 
-		case 0xae:      /* XOR (HL) */
+		OP(0xae):      /* XOR (HL) */
 			AF = xororTable[((AF >> 8) ^ GET_BYTE(HL)) & 0xff];
-			break;
+			NEXT;
 
-		case 0xaf:      /* XOR A */
+		OP(0xaf):      /* XOR A */
 			AF = 0x44;
-			break;
+			NEXT;
 
-		case 0xb0:      /* OR B */
+		OP(0xb0):      /* OR B */
 			AF = xororTable[((AF | BC) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xb1:      /* OR C */
+		OP(0xb1):      /* OR C */
 			AF = xororTable[((AF >> 8) | BC) & 0xff];
-			break;
+			NEXT;
 
-		case 0xb2:      /* OR D */
+		OP(0xb2):      /* OR D */
 			AF = xororTable[((AF | DE) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xb3:      /* OR E */
+		OP(0xb3):      /* OR E */
 			AF = xororTable[((AF >> 8) | DE) & 0xff];
-			break;
+			NEXT;
 
-		case 0xb4:      /* OR H */
+		OP(0xb4):      /* OR H */
 			AF = xororTable[((AF | HL) >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xb5:      /* OR L */
+		OP(0xb5):      /* OR L */
 			AF = xororTable[((AF >> 8) | HL) & 0xff];
-			break;
+			NEXT;
 
-		case 0xb6:      /* OR (HL) */
+		OP(0xb6):      /* OR (HL) */
 			AF = xororTable[((AF >> 8) | GET_BYTE(HL)) & 0xff];
-			break;
+			NEXT;
 
-		case 0xb7:      /* OR A */
+		OP(0xb7):      /* OR A */
 			AF = xororTable[(AF >> 8) & 0xff];
-			break;
+			NEXT;
 
-		case 0xb8:      /* CP B */
+		OP(0xb8):      /* CP B */
 			temp = HIGH_REGISTER(BC);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2465,9 +2526,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			NEXT;
 
-		case 0xb9:      /* CP C */
+		OP(0xb9):      /* CP C */
 			temp = LOW_REGISTER(BC);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2475,9 +2536,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			NEXT;
 
-		case 0xba:      /* CP D */
+		OP(0xba):      /* CP D */
 			temp = HIGH_REGISTER(DE);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2485,9 +2546,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			NEXT;
 
-		case 0xbb:      /* CP E */
+		OP(0xbb):      /* CP E */
 			temp = LOW_REGISTER(DE);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2495,9 +2556,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			NEXT;
 
-		case 0xbc:      /* CP H */
+		OP(0xbc):      /* CP H */
 			temp = HIGH_REGISTER(HL);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2505,9 +2566,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			NEXT;
 
-		case 0xbd:      /* CP L */
+		OP(0xbd):      /* CP L */
 			temp = LOW_REGISTER(HL);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2515,9 +2576,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			NEXT;
 
-		case 0xbe:      /* CP (HL) */
+		OP(0xbe):      /* CP (HL) */
 			temp = GET_BYTE(HL);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2525,64 +2586,64 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			NEXT;
 
-		case 0xbf:      /* CP A */
+		OP(0xbf):      /* CP A */
 			SET_LOW_REGISTER(AF, (HIGH_REGISTER(AF) & 0x28) | 0x42);
-			break;
+			NEXT;
 
-		case 0xc0:      /* RET NZ */
+		OP(0xc0):      /* RET NZ */
 			if (!(TSTFLAG(Z)))
 				POP(PC);
-			break;
+			NEXT;
 
-		case 0xc1:      /* POP BC */
+		OP(0xc1):      /* POP BC */
 			POP(BC);
-			break;
+			NEXT;
 
-		case 0xc2:      /* JP NZ,nnnn */
+		OP(0xc2):      /* JP NZ,nnnn */
 			JPC(!TSTFLAG(Z));
-			break;
+			NEXT;
 
-		case 0xc3:      /* JP nnnn */
+		OP(0xc3):      /* JP nnnn */
 			JPC(1);
-			break;
+			NEXT;
 
-		case 0xc4:      /* CALL NZ,nnnn */
+		OP(0xc4):      /* CALL NZ,nnnn */
 			CALLC(!TSTFLAG(Z));
-			break;
+			NEXT;
 
-		case 0xc5:      /* PUSH BC */
+		OP(0xc5):      /* PUSH BC */
 			PUSH(BC);
-			break;
+			NEXT;
 
-		case 0xc6:      /* ADD A,nn */
+		OP(0xc6):      /* ADD A,nn */
 			temp = RAM_PP(PC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0xc7:      /* RST 0 */
+		OP(0xc7):      /* RST 0 */
 			PUSH(PC);
 			PC = 0;
-			break;
+			NEXT;
 
-		case 0xc8:      /* RET Z */
+		OP(0xc8):      /* RET Z */
 			if (TSTFLAG(Z))
 				POP(PC);
-			break;
+			NEXT;
 
-		case 0xc9:      /* RET */
+		OP(0xc9):      /* RET */
 			POP(PC);
-			break;
+			NEXT;
 
-		case 0xca:      /* JP Z,nnnn */
+		OP(0xca):      /* JP Z,nnnn */
 			JPC(TSTFLAG(Z));
-			break;
+			NEXT;
 
-		case 0xcb:      /* CB prefix */
+		OP(0xcb):      /* CB prefix */
 			INCR(1); /* Add one M1 cycle to refresh counter */
 			adr = HL;
 			switch ((op = GET_BYTE(PC)) & 7) {
@@ -2727,73 +2788,73 @@ static inline void Z80run(void) {
 				SET_HIGH_REGISTER(AF, temp);
 				break;
 			}
-			break;
+			NEXT;
 
-		case 0xcc:      /* CALL Z,nnnn */
+		OP(0xcc):      /* CALL Z,nnnn */
 			CALLC(TSTFLAG(Z));
-			break;
+			NEXT;
 
-		case 0xcd:      /* CALL nnnn */
+		OP(0xcd):      /* CALL nnnn */
 			CALLC(1);
-			break;
+			NEXT;
 
-		case 0xce:      /* ADC A,nn */
+		OP(0xce):      /* ADC A,nn */
 			temp = RAM_PP(PC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0xcf:      /* RST 8 */
+		OP(0xcf):      /* RST 8 */
 			PUSH(PC);
 			PC = 8;
-			break;
+			NEXT;
 
-		case 0xd0:      /* RET NC */
+		OP(0xd0):      /* RET NC */
 			if (!(TSTFLAG(C)))
 				POP(PC);
-			break;
+			NEXT;
 
-		case 0xd1:      /* POP DE */
+		OP(0xd1):      /* POP DE */
 			POP(DE);
-			break;
+			NEXT;
 
-		case 0xd2:      /* JP NC,nnnn */
+		OP(0xd2):      /* JP NC,nnnn */
 			JPC(!TSTFLAG(C));
-			break;
+			NEXT;
 
-		case 0xd3:      /* OUT (nn),A */
+		OP(0xd3):      /* OUT (nn),A */
 			cpu_out(RAM_PP(PC), HIGH_REGISTER(AF));
-			break;
+			NEXT;
 
-		case 0xd4:      /* CALL NC,nnnn */
+		OP(0xd4):      /* CALL NC,nnnn */
 			CALLC(!TSTFLAG(C));
-			break;
+			NEXT;
 
-		case 0xd5:      /* PUSH DE */
+		OP(0xd5):      /* PUSH DE */
 			PUSH(DE);
-			break;
+			NEXT;
 
-		case 0xd6:      /* SUB nn */
+		OP(0xd6):      /* SUB nn */
 			temp = RAM_PP(PC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0xd7:      /* RST 10H */
+		OP(0xd7):      /* RST 10H */
 			PUSH(PC);
 			PC = 0x10;
-			break;
+			NEXT;
 
-		case 0xd8:      /* RET C */
+		OP(0xd8):      /* RET C */
 			if (TSTFLAG(C))
 				POP(PC);
-			break;
+			NEXT;
 
-		case 0xd9:      /* EXX */
+		OP(0xd9):      /* EXX */
 			temp = BC;
 			BC = BC1;
 			BC1 = temp;
@@ -2803,21 +2864,21 @@ static inline void Z80run(void) {
 			temp = HL;
 			HL = HL1;
 			HL1 = temp;
-			break;
+			NEXT;
 
-		case 0xda:      /* JP C,nnnn */
+		OP(0xda):      /* JP C,nnnn */
 			JPC(TSTFLAG(C));
-			break;
+			NEXT;
 
-		case 0xdb:      /* IN A,(nn) */
+		OP(0xdb):      /* IN A,(nn) */
 			SET_HIGH_REGISTER(AF, cpu_in(RAM_PP(PC)));
-			break;
+			NEXT;
 
-		case 0xdc:      /* CALL C,nnnn */
+		OP(0xdc):      /* CALL C,nnnn */
 			CALLC(TSTFLAG(C));
-			break;
+			NEXT;
 
-		case 0xdd:      /* DD prefix */
+		OP(0xdd):      /* DD prefix */
 			INCR(1); /* Add one M1 cycle to refresh counter */
 			switch (RAM_PP(PC)) {
 
@@ -3410,81 +3471,81 @@ static inline void Z80run(void) {
 			default:                /* ignore DD */
 				--PC;
 			}
-			break;
+			NEXT;
 
-		case 0xde:          /* SBC A,nn */
+		OP(0xde):          /* SBC A,nn */
 			temp = RAM_PP(PC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			NEXT;
 
-		case 0xdf:      /* RST 18H */
+		OP(0xdf):      /* RST 18H */
 			PUSH(PC);
 			PC = 0x18;
-			break;
+			NEXT;
 
-		case 0xe0:      /* RET PO */
+		OP(0xe0):      /* RET PO */
 			if (!(TSTFLAG(P)))
 				POP(PC);
-			break;
+			NEXT;
 
-		case 0xe1:      /* POP HL */
+		OP(0xe1):      /* POP HL */
 			POP(HL);
-			break;
+			NEXT;
 
-		case 0xe2:      /* JP PO,nnnn */
+		OP(0xe2):      /* JP PO,nnnn */
 			JPC(!TSTFLAG(P));
-			break;
+			NEXT;
 
-		case 0xe3:      /* EX (SP),HL */
+		OP(0xe3):      /* EX (SP),HL */
 			temp = HL;
 			POP(HL);
 			PUSH(temp);
-			break;
+			NEXT;
 
-		case 0xe4:      /* CALL PO,nnnn */
+		OP(0xe4):      /* CALL PO,nnnn */
 			CALLC(!TSTFLAG(P));
-			break;
+			NEXT;
 
-		case 0xe5:      /* PUSH HL */
+		OP(0xe5):      /* PUSH HL */
 			PUSH(HL);
-			break;
+			NEXT;
 
-		case 0xe6:      /* AND nn */
+		OP(0xe6):      /* AND nn */
 			AF = andTable[((AF >> 8)& RAM_PP(PC)) & 0xff];
-			break;
+			NEXT;
 
-		case 0xe7:      /* RST 20H */
+		OP(0xe7):      /* RST 20H */
 			PUSH(PC);
 			PC = 0x20;
-			break;
+			NEXT;
 
-		case 0xe8:      /* RET PE */
+		OP(0xe8):      /* RET PE */
 			if (TSTFLAG(P))
 				POP(PC);
-			break;
+			NEXT;
 
-		case 0xe9:      /* JP (HL) */
+		OP(0xe9):      /* JP (HL) */
 			PC = HL;
-			break;
+			NEXT;
 
-		case 0xea:      /* JP PE,nnnn */
+		OP(0xea):      /* JP PE,nnnn */
 			JPC(TSTFLAG(P));
-			break;
+			NEXT;
 
-		case 0xeb:      /* EX DE,HL */
+		OP(0xeb):      /* EX DE,HL */
 			temp = HL;
 			HL = DE;
 			DE = temp;
-			break;
+			NEXT;
 
-		case 0xec:      /* CALL PE,nnnn */
+		OP(0xec):      /* CALL PE,nnnn */
 			CALLC(TSTFLAG(P));
-			break;
+			NEXT;
 
-		case 0xed:      /* ED prefix */
+		OP(0xed):      /* ED prefix */
 			INCR(1); /* Add one M1 cycle to refresh counter */
 			switch (RAM_PP(PC)) {
 
@@ -4000,73 +4061,73 @@ static inline void Z80run(void) {
 			default:    /* ignore ED and following byte */
 				break;
 			}
-			break;
+			NEXT;
 
-		case 0xee:      /* XOR nn */
+		OP(0xee):      /* XOR nn */
 			AF = xororTable[((AF >> 8) ^ RAM_PP(PC)) & 0xff];
-			break;
+			NEXT;
 
-		case 0xef:      /* RST 28H */
+		OP(0xef):      /* RST 28H */
 			PUSH(PC);
 			PC = 0x28;
-			break;
+			NEXT;
 
-		case 0xf0:      /* RET P */
+		OP(0xf0):      /* RET P */
 			if (!(TSTFLAG(S)))
 				POP(PC);
-			break;
+			NEXT;
 
-		case 0xf1:      /* POP AF */
+		OP(0xf1):      /* POP AF */
 			POP(AF);
-			break;
+			NEXT;
 
-		case 0xf2:      /* JP P,nnnn */
+		OP(0xf2):      /* JP P,nnnn */
 			JPC(!TSTFLAG(S));
-			break;
+			NEXT;
 
-		case 0xf3:      /* DI */
+		OP(0xf3):      /* DI */
 			IFF = 0;
-			break;
+			NEXT;
 
-		case 0xf4:      /* CALL P,nnnn */
+		OP(0xf4):      /* CALL P,nnnn */
 			CALLC(!TSTFLAG(S));
-			break;
+			NEXT;
 
-		case 0xf5:      /* PUSH AF */
+		OP(0xf5):      /* PUSH AF */
 			PUSH(AF);
-			break;
+			NEXT;
 
-		case 0xf6:      /* OR nn */
+		OP(0xf6):      /* OR nn */
 			AF = xororTable[((AF >> 8) | RAM_PP(PC)) & 0xff];
-			break;
+			NEXT;
 
-		case 0xf7:      /* RST 30H */
+		OP(0xf7):      /* RST 30H */
 			PUSH(PC);
 			PC = 0x30;
-			break;
+			NEXT;
 
-		case 0xf8:      /* RET M */
+		OP(0xf8):      /* RET M */
 			if (TSTFLAG(S))
 				POP(PC);
-			break;
+			NEXT;
 
-		case 0xf9:      /* LD SP,HL */
+		OP(0xf9):      /* LD SP,HL */
 			SP = HL;
-			break;
+			NEXT;
 
-		case 0xfa:      /* JP M,nnnn */
+		OP(0xfa):      /* JP M,nnnn */
 			JPC(TSTFLAG(S));
-			break;
+			NEXT;
 
-		case 0xfb:      /* EI */
+		OP(0xfb):      /* EI */
 			IFF = 3;
-			break;
+			NEXT;
 
-		case 0xfc:      /* CALL M,nnnn */
+		OP(0xfc):      /* CALL M,nnnn */
 			CALLC(TSTFLAG(S));
-			break;
+			NEXT;
 
-		case 0xfd:      /* FD prefix */
+		OP(0xfd):      /* FD prefix */
 			INCR(1); /* Add one M1 cycle to refresh counter */
 			switch (RAM_PP(PC)) {
 
@@ -4659,9 +4720,9 @@ static inline void Z80run(void) {
 			default:            /* ignore FD */
 				--PC;
 			}
-			break;
+			NEXT;
 
-		case 0xfe:      /* CP nn */
+		OP(0xfe):      /* CP nn */
 			temp = RAM_PP(PC);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -4669,11 +4730,12 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			NEXT;
 
-		case 0xff:      /* RST 38H */
+		OP(0xff):      /* RST 38H */
 			PUSH(PC);
 			PC = 0x38;
+			NEXT;
 		}
 	}
 end_decode:
@@ -0,0 +1,281 @@
+#ifndef DISK_CACHE_H
+#define DISK_CACHE_H
+
+/* Host file and directory caching for the BDOS disk calls
+
+   Every CP/M record read or write used to open the host file, seek, move 128
+   bytes and close it again, and every search rescanned the host directory.
+   Here files stay open between BDOS calls, DC_FILES at a time, each with a
+   window of DC_RECORDS records: a read brings in the whole window, and writes
+   collect in it until the window moves on. The listing of the user area last
+   searched on each drive is kept too.
+
+   Buffered records are written back when the file is closed, renamed or
+   deleted, when its handle is reused, and by _dc_reset(), which also forgets
+   the listings. That is called at BDOS reset (13) and whenever the CCP reads
+   a command, so nothing is held once a program has finished.
+
+   A write back that fails while the window moves on, or before a search,
+   has no BDOS call of its own to report it. The slot keeps the error: every
+   later write to the file fails and so does its close, which is when CP/M
+   programs look. Slots holding an error are reused last. _dc_reset() drops
+   any error still held.
+
+   The abstraction includes this and supplies:
+	FILE* _dc_fopen(uint8* filename, const char* mode)	opens the host file
+	void _dc_scan(dc_dir_t* dir)						lists dir->path with _dc_add()
+*/
+
+#define DISK_CACHE
+
+#define DC_FILES 4			// Host files kept open at once
+#define DC_RECORDS 16		// Records read ahead and written back together
+#define DC_WINDOW (DC_RECORDS * BlkSZ)
+#define DC_DRIVES 16
+
+typedef struct {
+	uint8 name[17];		// Host filename, as in filename[], empty if the slot is free
+	FILE* file;
+	bool writable;
+	bool err;			// A write back failed, reported by every write and the close
+	long size;			// Size of the file, counting records not written back yet
+	long hostsize;		// and without them
+	long base;			// Offset in the file of buf[0], -1 if nothing is buffered
+	uint16 valid;		// Bytes of buf that hold the file
+	uint16 dirty_lo;	// Bytes of buf to write back, none if dirty_lo == dirty_hi
+	uint16 dirty_hi;
+	uint32 used;		// For reusing the least recently used slot
+	uint8* buf;
+} dc_file_t;
+
+typedef struct {
+	char name[17];
+	uint32 size;
+} dc_dirent_t;
+
+typedef struct {
+	char path[4];		// Host folder listed, as "A/0", empty if the listing is stale
+	uint16 count;
+	uint16 capacity;
+	dc_dirent_t* entries;
+} dc_dir_t;
+
+FILE* _dc_fopen(uint8* filename, const char* mode);
+void _dc_scan(dc_dir_t* dir);
+
+static dc_file_t dc_files[DC_FILES];
+static uint32 dc_clock = 0;
+static dc_dir_t dc_dirs[DC_DRIVES];
+
+// Adds a file found by _dc_scan() to the listing
+void _dc_add(dc_dir_t* dir, const char* name, uint32 size) {
+	if (dir->count == dir->capacity) {
+		uint16 capacity = dir->capacity ? dir->capacity * 2 : 64;
+		dc_dirent_t* entries = (dc_dirent_t*)realloc(dir->entries, capacity * sizeof(dc_dirent_t));
+		if (entries == NULL)
+			return;
+		dir->entries = entries;
+		dir->capacity = capacity;
+	}
+	strncpy(dir->entries[dir->count].name, name, sizeof(dir->entries[0].name) - 1);
+	dir->entries[dir->count].name[sizeof(dir->entries[0].name) - 1] = 0;
+	dir->entries[dir->count].size = size;
+	dir->count++;
+}
+
+// Forgets the listing of the drive the host file is on
+void _dc_dirchanged(uint8* filename) {
+	uint8 drive = filename[0] - 'A';
+	if (drive < DC_DRIVES)
+		dc_dirs[drive].path[0] = 0;
+}
+
+// Writes back the buffered records
+// Returns TRUE if an error condition occurred
+bool _dc_writeback(dc_file_t* f) {
+	bool err = FALSE;
+	if (f->dirty_lo != f->dirty_hi) {
+		err = fseek(f->file, f->base + f->dirty_lo, SEEK_SET) != 0 ||
+			fwrite(&f->buf[f->dirty_lo], 1, f->dirty_hi - f->dirty_lo, f->file) != (size_t)(f->dirty_hi - f->dirty_lo);
+		if (f->base + f->dirty_hi > f->hostsize) {
+			f->hostsize = f->base + f->dirty_hi;
+			_dc_dirchanged(f->name);	// it grew
+		}
+		f->dirty_lo = f->dirty_hi = 0;
+	}
+	return(err);
+}
+
+// Writes back and closes the host file held in the slot
+// Returns TRUE if an error condition occurred
+bool _dc_release(dc_file_t* f) {
+	bool err = FALSE;
+	if (f->name[0]) {
+		if (_dc_writeback(f) || f->err)
+			err = TRUE;
+		if (fclose(f->file) != 0)
+			err = TRUE;
+		f->name[0] = 0;
+		f->err = FALSE;
+	}
+	return(err);
+}
+
+// The open host file, opening it if need be. NULL if it can't be opened
+dc_file_t* _dc_get(uint8* filename) {
+	dc_file_t* f = NULL;
+	int i;
+
+	for (i = 0; i < DC_FILES; ++i) {
+		if (dc_files[i].name[0] && !strcmp((char*)dc_files[i].name, (char*)filename)) {
+			f = &dc_files[i];
+			f->used = ++dc_clock;
+			return(f);
+		}
+	}
+
+	// Least recently used, free slots first, slots with an error to report last
+	f = &dc_files[0];
+	for (i = 1; i < DC_FILES; ++i) {
+		if (!f->name[0])
+			break;
+		if (!dc_files[i].name[0] || (f->err && !dc_files[i].err) ||
+			(f->err == dc_files[i].err && dc_files[i].used < f->used))
+			f = &dc_files[i];
+	}
+	_dc_release(f);
+
+	if (f->buf == NULL && (f->buf = (uint8*)malloc(DC_WINDOW)) == NULL)
+		return(NULL);
+	f->writable = TRUE;
+	f->err = FALSE;
+	if ((f->file = _dc_fopen(filename, "r+b")) == NULL) {
+		f->writable = FALSE;
+		if ((f->file = _dc_fopen(filename, "rb")) == NULL)
+			return(NULL);
+	}
+	fseek(f->file, 0, SEEK_END);
+	f->size = f->hostsize = ftell(f->file);
+	f->base = -1;
+	f->valid = f->dirty_lo = f->dirty_hi = 0;
+	f->used = ++dc_clock;
+	strcpy((char*)f->name, (char*)filename);
+	return(f);
+}
+
+// Brings the window holding fpos into the buffer
+void _dc_window(dc_file_t* f, long fpos) {
+	long base = fpos - (fpos % DC_WINDOW);
+	if (f->base == base)
+		return;
+	if (_dc_writeback(f))
+		f->err = TRUE;
+	f->base = base;
+	f->valid = 0;
+	if (base < f->size && fseek(f->file, base, SEEK_SET) == 0)
+		f->valid = fread(f->buf, 1, DC_WINDOW, f->file);
+}
+
+// Reads the record at fpos into dest, padded with ^Z past the end of the file
+// Returns the bytes of the file read, -1 if it can't be opened
+int _dc_read(uint8* filename, long fpos, uint8* dest) {
+	dc_file_t* f = _dc_get(filename);
+	int bytes;
+
+	if (f == NULL)
+		return(-1);
+	if (fpos >= f->size)
+		return(0);
+	_dc_window(f, fpos);
+	bytes = f->base + f->valid - fpos;
+	if (bytes > BlkSZ)
+		bytes = BlkSZ;
+	if (bytes < 0)
+		bytes = 0;
+	memcpy(dest, &f->buf[fpos - f->base], bytes);
+	memset(dest + bytes, 0x1a, BlkSZ - bytes);
+	return(bytes);
+}
+
+// Writes the record at fpos, past the end of the file is filled with zeros
+// Returns TRUE if an error condition occurred
+bool _dc_write(uint8* filename, long fpos, const uint8* src) {
+	dc_file_t* f = _dc_get(filename);
+	uint16 off;
+
+	if (f == NULL || !f->writable)
+		return(TRUE);
+	_dc_window(f, fpos);
+	if (f->err)
+		return(TRUE);
+	off = fpos - f->base;
+	if (off > f->valid) {		// a gap up to the record
+		memset(&f->buf[f->valid], 0, off - f->valid);
+		if (f->dirty_lo == f->dirty_hi || f->valid < f->dirty_lo)
+			f->dirty_lo = f->valid;
+	} else if (f->dirty_lo == f->dirty_hi || off < f->dirty_lo) {
+		f->dirty_lo = off;
+	}
+	memcpy(&f->buf[off], src, BlkSZ);
+	if (off + BlkSZ > f->valid)
+		f->valid = off + BlkSZ;
+	if (off + BlkSZ > f->dirty_hi)
+		f->dirty_hi = off + BlkSZ;
+	if (fpos + BlkSZ > f->size)
+		f->size = fpos + BlkSZ;
+	return(FALSE);
+}
+
+// Size of the file counting buffered records, -1 if it can't be opened
+long _dc_size(uint8* filename) {
+	dc_file_t* f = _dc_get(filename);
+	return(f ? f->size : -1);
+}
+
+// Writes back and closes the file if it is open, before a close, rename or delete
+// Returns TRUE if an error condition occurred
+bool _dc_close(uint8* filename) {
+	int i;
+	for (i = 0; i < DC_FILES; ++i) {
+		if (dc_files[i].name[0] && !strcmp((char*)dc_files[i].name, (char*)filename))
+			return(_dc_release(&dc_files[i]));
+	}
+	return(FALSE);
+}
+
+// The listing of a host folder, "A/0" say, scanning it if it isn't kept
+dc_dir_t* _dc_dir(const char* path) {
+	uint8 drive = path[0] - 'A';
+	dc_dir_t* dir;
+	int i;
+
+	if (drive >= DC_DRIVES)
+		return(NULL);
+	// sizes on the host must take in the buffered records
+	for (i = 0; i < DC_FILES; ++i) {
+		if (dc_files[i].name[0] == path[0] && _dc_writeback(&dc_files[i]))
+			dc_files[i].err = TRUE;
+	}
+	dir = &dc_dirs[drive];
+	if (strncmp(dir->path, path, sizeof(dir->path))) {
+		strncpy(dir->path, path, sizeof(dir->path) - 1);
+		dir->path[sizeof(dir->path) - 1] = 0;
+		dir->count = 0;
+		_dc_scan(dir);
+	}
+	return(dir);
+}
+
+// Writes back and closes all files and forgets all listings
+void _dc_reset(void) {
+	int i;
+	for (i = 0; i < DC_FILES; ++i) {
+		_dc_release(&dc_files[i]);
+		free(dc_files[i].buf);
+		dc_files[i].buf = NULL;
+	}
+	for (i = 0; i < DC_DRIVES; ++i)
+		dc_dirs[i].path[0] = 0;
+}
+
+#endif
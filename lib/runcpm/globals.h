@@ -96,6 +96,12 @@
 //#define PROFILE		// For measuring time taken to run a CP/M command
 						// This should be enabled only for debugging purposes when trying to improve emulation speed
 
+#ifndef Z80_SWITCH
+#define Z80_THREADED	// Each instruction jumps straight to the code for the next (GCC computed goto)
+						// Define Z80_SWITCH to go back round the main loop through one switch instead
+#endif
+//#define Z80_COUNT		// Counts the instructions run in Z80instructions, for measuring emulation speed
+
 #define NOHIGHUSER		// Prevents the creation of user folders above 'F' (15) by programs
 						// Original CP/M BDOS allows it, but I prefer to keep the folders clean
 
@@ -0,0 +1,34 @@
+#ifndef SAMPROMPTS_H
+#define SAMPROMPTS_H
+
+// Precomputed output for the fixed phrases spoken during disk swaps, so
+// they can be played straight off the flash filesystem without running the
+// renderer.
+//
+// Each file is the unsigned 8-bit 22050 Hz PCM that SAMMain() produces for
+// the phrase in phonetic mode with util_sam_say()'s default voice (pitch 64,
+// speed 96, mouth 128, throat 128). They live in
+// data/webui/device_specific/BUILD_ATARI/sam. If render.c changes, regenerate
+// them from a host build: sam -phonetic -pitch 64 -speed 96 -wav out.wav "<phrase>"
+// and keep the data chunk of out.wav (everything after the 44 byte header).
+
+struct SamPrompt
+{
+    const char *phrase;
+    const char *path;
+};
+
+static const SamPrompt samPrompts[] =
+{
+    {"WAH7NQ", "/sam/one.pcm"},
+    {"TUW7", "/sam/two.pcm"},
+    {"THRIYY7Q", "/sam/three.pcm"},
+    {"FOH7R", "/sam/four.pcm"},
+    {"F7AYVQ", "/sam/five.pcm"},
+    {"SIH7IHKSQ", "/sam/six.pcm"},
+    {"SEHV7EHNQ", "/sam/seven.pcm"},
+    {"AEY74Q", "/sam/eight.pcm"},
+    {"DIHSK7Q ", "/sam/disk.pcm"},
+};
+
+#endif /* SAMPROMPTS_H */
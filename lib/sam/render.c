@@ -48,7 +48,7 @@ unsigned char trans(unsigned char mem39212, unsigned char mem39213);
 
 // contains the final soundbuffer
 extern int bufferpos;
-extern char *buffer;
+void WriteSample(int index, unsigned char value);
 
 //timetable for more accurate c64 simulation
 int timetable[5][5] =
@@ -60,6 +60,8 @@ int timetable[5][5] =
         {199, 0, 0, 54, 54}};
 
 static unsigned oldtimetableindex = 0;
+void ResetTimetable() { oldtimetableindex = 0; }
+
 void Output8BitAry(int index, unsigned char ary[5])
 {
     // printf("Output8BitAry\r\n");
@@ -70,9 +72,17 @@ void Output8BitAry(int index, unsigned char ary[5])
     for (k = 0; k < 5; k++)
     {
         // printf("%d %d\r\n", bufferpos,k);
-        buffer[bufferpos / 50 + k] = ary[k];
+        WriteSample(bufferpos / 50 + k, ary[k]);
     }
 }
+// Sampled consonants advance three samples per bit; hold the level across
+// all of them so the ring never replays stale data from a previous lap.
+void HoldSample(unsigned char A)
+{
+    int k;
+    for (k = 0; k < 3; k++)
+        WriteSample(bufferpos / 50 + k, A);
+}
 void Output8Bit(int index, unsigned char A)
 {
     unsigned char ary[5] = {A, A, A, A, A};
@@ -977,14 +987,14 @@ void Render()
                 X = 26;
                 // mem[54296] = X;
                 bufferpos += 150;
-                buffer[bufferpos / 50] = (X & 15) * 16;
+                HoldSample((X & 15) * 16);
             }
             else
             {
                 //mem[54296] = 6;
                 X = 6;
                 bufferpos += 150;
-                buffer[bufferpos / 50] = (X & 15) * 16;
+                HoldSample((X & 15) * 16);
             }
 
             for (X = wait2; X > 0; X--)
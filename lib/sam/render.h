@@ -2,6 +2,7 @@
 #define RENDER_H
 
 void Render();
+void ResetTimetable();
 void SetMouthThroat(unsigned char mouth, unsigned char throat);
 
 #endif
@@ -1,8 +1,6 @@
 
 #include "sam.h"
 
-#include <esp_heap_caps.h>
-
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -43,9 +41,14 @@ unsigned char phonemeIndexOutput[60];  //tab47296
 unsigned char stressOutput[60];        //tab47365
 unsigned char phonemeLengthOutput[60]; //tab47416
 
-// contains the final soundbuffer
+// contains the final soundbuffer. Render() only ever writes a few samples
+// ahead of bufferpos / 50, so everything behind that point is finished and
+// is handed to the output callback whenever the ring is about to wrap.
+#define SAM_RING_SIZE 1024 // power of two
 int bufferpos = 0;
-char *buffer = NULL;
+static unsigned char buffer[SAM_RING_SIZE];
+static int drainpos = 0; // samples already passed to output
+static SamOutputFn output = NULL;
 
 void SetInput(char *_input)
 {
@@ -63,9 +66,29 @@ void SetPitch(unsigned char _pitch) { pitch = _pitch; }
 void SetMouth(unsigned char _mouth) { mouth = _mouth; }
 void SetThroat(unsigned char _throat) { throat = _throat; }
 void EnableSingmode() { singmode = 1; }
-char *GetBuffer() { return buffer; }
-int GetBufferLength() { return bufferpos; }
-void FreeBuffer() { free(buffer); }
+void SetOutput(SamOutputFn fn) { output = fn; }
+
+// Pass finished samples up to (not including) index end to the output
+void DrainOutput(int end)
+{
+    while (drainpos < end)
+    {
+        int start = drainpos & (SAM_RING_SIZE - 1);
+        int n = end - drainpos;
+        if (n > SAM_RING_SIZE - start)
+            n = SAM_RING_SIZE - start;
+        if (output != NULL)
+            output(&buffer[start], n);
+        drainpos += n;
+    }
+}
+
+void WriteSample(int index, unsigned char value)
+{
+    if (index - drainpos >= SAM_RING_SIZE)
+        DrainOutput(bufferpos / 50);
+    buffer[index & (SAM_RING_SIZE - 1)] = value;
+}
 
 void Init();
 int Parser1();
@@ -97,17 +120,9 @@ void Init()
     SetMouthThroat(mouth, throat);
 
     bufferpos = 0;
-    // TODO, check for free the memory, 10 seconds of output should be more than enough
-    //buffer = (char*)ps_malloc(22050 * 5);
-    // switch to ESP-IDF equivalent
-    buffer = (char *)heap_caps_malloc(22050 * 10, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    /*
-    Due to a technical limitation, the maximum statically allocated DRAM usage is 160KB. 
-    The remaining 160KB (for a total of 320KB of DRAM) can only be allocated at runtime as heap.
-    https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/mem_alloc.html
-    */
-
-    // printf("buffer pointer %d\r\n", buffer);
+    drainpos = 0;
+    memset(buffer, 0x80, sizeof(buffer));
+    ResetTimetable();
 
     /*
     freq2data = &mem[45136];
@@ -183,6 +198,7 @@ int SAMMain()
     }
 
     PrepareOutput();
+    DrainOutput(bufferpos / 50);
 
     return 1;
 }
@@ -998,7 +1014,7 @@ void Parser2()
         A = flags[Y] & 1;
         if (A == 0)
             goto pos41749;
-        A = phonemeindex[pos - 1];
+        A = pos > 0 ? phonemeindex[pos - 1] : 0; // nothing before the first
         if (A != 32) // 'S'
         {
             A = Y;
@@ -1024,7 +1040,7 @@ void Parser2()
         if (A == 53) // 'UW'
         {
             // ALVEOLAR flag set?
-            Y = phonemeindex[X - 1];
+            Y = X > 0 ? phonemeindex[X - 1] : 0;
             A = flags2[Y] & 4;
             // If not set, continue processing next phoneme
             if (A == 0)
@@ -1089,7 +1105,7 @@ void Parser2()
         //pos41825:
 
         // If prior phoneme is not a vowel, continue processing phonemes
-        if ((flags[phonemeindex[X - 1]] & 128) == 0)
+        if (X == 0 || (flags[phonemeindex[X - 1]] & 128) == 0)
         {
             pos++;
             continue;
@@ -1275,8 +1291,7 @@ void AdjustLengths()
                 mem56 = flags[index];
 
             // not a consonant
-            /// @todo code above check if index == 255, if it is, then flags[index] is out of bounds
-            if ((flags[index] & 64) == 0)
+            if ((mem56 & 64) == 0)
             {
                 // RX or LX?
                 if ((index == 18) || (index == 19)) // 'RX' & 'LX'
@@ -1286,7 +1301,7 @@ void AdjustLengths()
                     index = phonemeindex[X];
 
                     // next phoneme a consonant?
-                    if ((flags[index] & 64) != 0)
+                    if (index != 255 && (flags[index] & 64) != 0)
                     {
                         // RULE: <VOWEL> RX | LX <CONSONANT>
 
@@ -1516,8 +1531,8 @@ void AdjustLengths()
         {
             // R*, L*, W*, Y*
 
-            // get the prior phoneme
-            index = phonemeindex[X - 1];
+            // get the prior phoneme, a pause if this is the first
+            index = X > 0 ? phonemeindex[X - 1] : 0;
 
             // prior phoneme a stop consonant>
             if ((flags[index] & 2) != 0)
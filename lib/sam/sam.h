@@ -16,9 +16,10 @@ extern "C"
 
     int SAMMain();
 
-    char *GetBuffer();
-    int GetBufferLength();
-    void FreeBuffer();
+    // SAMMain() streams 8-bit unsigned 22050 Hz samples to this callback
+    // in small pieces while rendering, rather than into one large buffer.
+    typedef void (*SamOutputFn)(const unsigned char *samples, int count);
+    void SetOutput(SamOutputFn fn);
     
     //char input[]={"/HAALAOAO MAYN NAAMAEAE IHSTT SAEBAASTTIHAAN \x9b\x9b\0"};
     //unsigned char input[]={"/HAALAOAO \x9b\0"};
@@ -2,57 +2,88 @@
 #include "samlib.h"
 
 #include <freertos/FreeRTOS.h>
-#include <freertos/timers.h>
-#include <driver/gpio.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <esp_idf_version.h>
 #ifndef CONFIG_IDF_TARGET_ESP32S3
-#include <driver/dac.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <driver/dac_continuous.h>
+#else
+#include <driver/i2s.h>
+#endif
 #endif
 
+#include "SamPrompts.h"
 
-#include "fnSystem.h"
+#include "../../include/debug.h"
+
+#ifdef ESP_PLATFORM
+#include "fsFlash.h"
+#endif
 
 #ifdef __cplusplus
 extern char input[256];
-extern char *buffer;
 #endif
 
 int debug = 0;
 
+#define SAM_SAMPLE_RATE 22050
+
 #ifndef ESP_PLATFORM
 
-void WriteWav(char *filename, char *buffer, int bufferlength)
+static FILE *wavfile = NULL;
+
+static void WriteWavSamples(const unsigned char *samples, int count)
 {
-    FILE *file = fopen(filename, "wb");
-    if (file == NULL)
-        return;
-    //RIFF header
-    fwrite("RIFF", 4, 1, file);
-    unsigned int filesize = bufferlength + 12 + 16 + 8 - 8;
-    fwrite(&filesize, 4, 1, file);
-    fwrite("WAVE", 4, 1, file);
+    fwrite(samples, count, 1, wavfile);
+}
+
+int WriteWav(char *filename)
+{
+    wavfile = fopen(filename, "wb");
+    if (wavfile == NULL)
+        return 0;
+    //RIFF header, sizes are patched once the length is known
+    fwrite("RIFF", 4, 1, wavfile);
+    unsigned int filesize = 0;
+    fwrite(&filesize, 4, 1, wavfile);
+    fwrite("WAVE", 4, 1, wavfile);
 
     //format chunk
-    fwrite("fmt ", 4, 1, file);
+    fwrite("fmt ", 4, 1, wavfile);
     unsigned int fmtlength = 16;
-    fwrite(&fmtlength, 4, 1, file);
+    fwrite(&fmtlength, 4, 1, wavfile);
     unsigned short int format = 1; //PCM
-    fwrite(&format, 2, 1, file);
+    fwrite(&format, 2, 1, wavfile);
     unsigned short int channels = 1;
-    fwrite(&channels, 2, 1, file);
-    unsigned int samplerate = 22050;
-    fwrite(&samplerate, 4, 1, file);
-    fwrite(&samplerate, 4, 1, file); // bytes/second
+    fwrite(&channels, 2, 1, wavfile);
+    unsigned int samplerate = SAM_SAMPLE_RATE;
+    fwrite(&samplerate, 4, 1, wavfile);
+    fwrite(&samplerate, 4, 1, wavfile); // bytes/second
     unsigned short int blockalign = 1;
-    fwrite(&blockalign, 2, 1, file);
+    fwrite(&blockalign, 2, 1, wavfile);
     unsigned short int bitspersample = 8;
-    fwrite(&bitspersample, 2, 1, file);
+    fwrite(&bitspersample, 2, 1, wavfile);
 
     //data chunk
-    fwrite("data", 4, 1, file);
-    fwrite(&bufferlength, 4, 1, file);
-    fwrite(buffer, bufferlength, 1, file);
-
-    fclose(file);
+    fwrite("data", 4, 1, wavfile);
+    unsigned int bufferlength = 0;
+    fwrite(&bufferlength, 4, 1, wavfile);
+
+    SetOutput(WriteWavSamples);
+    int ok = SAMMain();
+    SetOutput(NULL);
+
+    bufferlength = ftell(wavfile) - 44;
+    filesize = bufferlength + 12 + 16 + 8 - 8;
+    fseek(wavfile, 4, SEEK_SET);
+    fwrite(&filesize, 4, 1, wavfile);
+    fseek(wavfile, 40, SEEK_SET);
+    fwrite(&bufferlength, 4, 1, wavfile);
+
+    fclose(wavfile);
+    wavfile = NULL;
+    return ok;
 }
 #endif // NOT ESP_PLATFORM
 
@@ -104,84 +135,133 @@ void PrintUsage()
     */
 }
 
-#ifdef USESDL
+#if defined(ESP_PLATFORM) && !defined(CONFIG_IDF_TARGET_ESP32S3)
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+
+// The built-in DAC runs in continuous (DMA) mode, so once started, playback
+// keeps going at the right rate while the next piece is being rendered and
+// dac_continuous_write() blocks the renderer whenever it gets too far ahead.
+#define SAM_DMA_BUFFERS 8
+#define SAM_DMA_BUF_SIZE 512
+
+static dac_continuous_handle_t sam_dac = NULL;
 
-int pos = 0;
-void MixAudio(void *unused, Uint8 *stream, int len)
+static void OutputSamples(const unsigned char *samples, int count)
 {
-    int bufferpos = GetBufferLength();
-    char *buffer = GetBuffer();
-    int i;
-    if (pos >= bufferpos)
-        return;
-    if ((bufferpos - pos) < len)
-        len = (bufferpos - pos);
-    for (i = 0; i < len; i++)
-    {
-        stream[i] = buffer[pos];
-        pos++;
-    }
+    dac_continuous_write(sam_dac, (uint8_t *)samples, count, NULL, -1);
 }
 
-void OutputSound()
+static bool StartOutput()
 {
-    int bufferpos = GetBufferLength();
-    bufferpos /= 50;
-    SDL_AudioSpec fmt;
-
-    fmt.freq = 22050;
-    fmt.format = AUDIO_U8;
-    fmt.channels = 1;
-    fmt.samples = 2048;
-    fmt.callback = MixAudio;
-    fmt.userdata = NULL;
-
-    /* Open the audio device and start playing sound! */
-    if (SDL_OpenAudio(&fmt, NULL) < 0)
+    dac_continuous_config_t cfg = {};
+    cfg.chan_mask = DAC_CHANNEL_MASK_CH0; // PIN_DAC1 (GPIO25)
+    cfg.desc_num = SAM_DMA_BUFFERS;
+    cfg.buf_size = SAM_DMA_BUF_SIZE;
+    cfg.freq_hz = SAM_SAMPLE_RATE;
+    cfg.offset = 0;
+    cfg.clk_src = DAC_DIGI_CLK_SRC_DEFAULT;
+    cfg.chan_mode = DAC_CHANNEL_MODE_SIMUL;
+
+    if (dac_continuous_new_channels(&cfg, &sam_dac) != ESP_OK)
     {
-        printf("Unable to open audio: %s\r\n", SDL_GetError());
-        exit(1);
+        Debug_println("SAM: could not start DAC output");
+        return false;
     }
-    SDL_PauseAudio(0);
-    //SDL_Delay((bufferpos)/7);
-
-    while (pos < bufferpos)
+    if (dac_continuous_enable(sam_dac) != ESP_OK)
     {
-        SDL_Delay(100);
+        Debug_println("SAM: could not enable DAC output");
+        dac_continuous_del_channels(sam_dac);
+        sam_dac = NULL;
+        return false;
     }
+    SetOutput(OutputSamples);
+    return true;
+}
 
-    SDL_CloseAudio();
+static void StopOutput()
+{
+    SetOutput(NULL);
+    // Queue a full set of buffers at mid-scale, so everything before them
+    // has played by the time the last one is taken
+    uint8_t silence[SAM_DMA_BUF_SIZE];
+    memset(silence, 0x80, sizeof(silence));
+    for (int i = 0; i < SAM_DMA_BUFFERS; i++)
+        dac_continuous_write(sam_dac, silence, sizeof(silence), NULL, -1);
+    dac_continuous_disable(sam_dac);
+    dac_continuous_del_channels(sam_dac);
+    sam_dac = NULL;
 }
 
 #else
 
-void OutputSound()
-{
-#ifdef ESP_PLATFORM
-#ifndef CONFIG_IDF_TARGET_ESP32S3
-    int n = GetBufferLength() / 50;
-    char *s = GetBuffer();
+// ESP-IDF 4 has no continuous DAC driver; the built-in DAC is fed by I2S0 DMA.
+#define SAM_I2S_PORT I2S_NUM_0
+#define SAM_DMA_BUFFERS 8
+#define SAM_DMA_FRAMES 256
 
-    //fnSystem.dac_output_enable(SystemManager::dac_channel_t::DAC_CHANNEL_1);
-    //fnSystem.dac_output_voltage(SystemManager::dac_channel_t::DAC_CHANNEL_1, 100);
+static void OutputSamples(const unsigned char *samples, int count)
+{
+    // The DAC takes the high byte of each 16-bit slot. Both slots of a frame
+    // carry the same sample so the hardware's slot ordering does not matter.
+    uint16_t frames[64 * 2];
 
-    dac_output_enable(DAC_CHANNEL_1);
+    while (count > 0)
+    {
+        int n = count > 64 ? 64 : count;
+        for (int i = 0; i < n; i++)
+            frames[i * 2] = frames[i * 2 + 1] = samples[i] << 8;
+
+        size_t written;
+        i2s_write(SAM_I2S_PORT, frames, n * sizeof(uint16_t) * 2, &written, portMAX_DELAY);
+        samples += n;
+        count -= n;
+    }
+}
 
-    for (int i = 0; i < n; i++)
+static bool StartOutput()
+{
+    i2s_config_t cfg = {};
+    cfg.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN);
+    cfg.sample_rate = SAM_SAMPLE_RATE;
+    cfg.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    cfg.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+    cfg.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+    cfg.dma_buf_count = SAM_DMA_BUFFERS;
+    cfg.dma_buf_len = SAM_DMA_FRAMES;
+    cfg.tx_desc_auto_clear = true;
+
+    if (i2s_driver_install(SAM_I2S_PORT, &cfg, 0, NULL) != ESP_OK)
     {
-        //dacWrite(DAC1, s[i]);
-        // fnSystem.dac_write(PIN_DAC1, s[i]);
-        dac_output_voltage(DAC_CHANNEL_1, s[i]);
-        //delayMicroseconds(40);
-        fnSystem.delay_microseconds(40);
+        Debug_println("SAM: could not start I2S DAC output");
+        return false;
     }
+    // PIN_DAC1 (GPIO25) is DAC channel 1, the right I2S channel
+    i2s_set_dac_mode(I2S_DAC_CHANNEL_RIGHT_EN);
+    SetOutput(OutputSamples);
+    return true;
+}
 
-    //fnSystem.dac_output_disable(SystemManager::dac_channel_t::DAC_CHANNEL_1);
-    dac_output_disable(DAC_CHANNEL_1);
+static void StopOutput()
+{
+    SetOutput(NULL);
+    // let the queued DMA buffers play out
+    vTaskDelay(pdMS_TO_TICKS(SAM_DMA_BUFFERS * SAM_DMA_FRAMES * 1000 / SAM_SAMPLE_RATE + 10));
+    i2s_set_dac_mode(I2S_DAC_CHANNEL_DISABLE);
+    i2s_driver_uninstall(SAM_I2S_PORT);
+}
 
-    FreeBuffer();
-#endif
-#endif
+#endif // ESP_IDF_VERSION
+
+#else
+
+static bool StartOutput()
+{
+    return false;
+}
+
+static void StopOutput()
+{
 }
 
 #endif
@@ -293,14 +373,6 @@ int sam(int argc, char **argv)
 
         // printf("done phonetic processing\r\n");
 
-#ifdef USESDL
-    if (SDL_Init(SDL_INIT_AUDIO) < 0)
-    {
-        printf("Unable to init SDL: %s\r\n", SDL_GetError());
-        exit(1);
-    }
-    atexit(SDL_Quit);
-#endif
 
 #ifndef __cplusplus
     SetInput(input);
@@ -308,19 +380,151 @@ int sam(int argc, char **argv)
 
     // printf("right before SAMMain");
 
-    if (!SAMMain())
+#ifndef ESP_PLATFORM
+    if (wavfilename != NULL)
+    {
+        if (!WriteWav(wavfilename))
+        {
+            PrintUsage();
+            return 1;
+        }
+        return 0;
+    }
+#endif // ESP_PLATFORM
+
+    // Without an output the phrase is still rendered, just not heard.
+    bool playing = StartOutput();
+    int ok = SAMMain();
+    if (playing)
+        StopOutput();
+
+    if (!ok)
     {
         PrintUsage();
         return 1;
     }
     // printf("right after SAMMain");
 
-#ifndef ESP_PLATFORM
-    if (wavfilename != NULL)
-        WriteWav(wavfilename, GetBuffer(), GetBufferLength() / 50);
-    else
-#endif // ESP_PLATFORM
-        OutputSound();
-
     return 0;
 }
+
+#ifdef ESP_PLATFORM
+
+// Speech runs on its own task so the bus loop only pays for queueing it.
+#define SAM_QUEUE_DEPTH 4
+#define SAM_MAX_ARGS 20
+#define SAM_ARGS_SIZE 400
+
+struct sam_request
+{
+    const SamPrompt *prompt; // played straight off the flash filesystem when set
+    int argc;
+    char args[SAM_ARGS_SIZE]; // argv strings packed back to back
+};
+
+static QueueHandle_t sam_queue = NULL;
+
+static void sam_play(const char *path)
+{
+    FILE *f = fsFlash.file_open(path);
+    if (f == nullptr)
+    {
+        Debug_printf("SAM: could not open %s\r\n", path);
+        return;
+    }
+
+    if (StartOutput())
+    {
+#if !defined(CONFIG_IDF_TARGET_ESP32S3)
+        unsigned char pcm[512];
+        size_t count;
+        while ((count = fread(pcm, 1, sizeof(pcm), f)) > 0)
+            OutputSamples(pcm, count);
+#endif
+        StopOutput();
+    }
+    fclose(f);
+}
+
+static void sam_task(void *arg)
+{
+    sam_request req;
+    char *argv[SAM_MAX_ARGS];
+
+    for (;;)
+    {
+        if (xQueueReceive(sam_queue, &req, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        if (req.prompt != nullptr)
+        {
+            sam_play(req.prompt->path);
+            continue;
+        }
+
+        char *p = req.args;
+        for (int i = 0; i < req.argc; i++)
+        {
+            argv[i] = p;
+            p += strlen(p) + 1;
+        }
+        sam(req.argc, argv);
+    }
+}
+
+static bool sam_enqueue(sam_request *req)
+{
+    if (sam_queue == NULL)
+    {
+        sam_queue = xQueueCreate(SAM_QUEUE_DEPTH, sizeof(sam_request));
+        // pinned away from the bus loop; i2s_write() blocks while DMA plays
+        xTaskCreatePinnedToCore(sam_task, "sam_task", 4096, NULL, 5, NULL, 0);
+    }
+
+    if (xQueueSend(sam_queue, req, 0) != pdTRUE)
+    {
+        Debug_println("SAM: speech queue full, dropping phrase");
+        return false;
+    }
+    return true;
+}
+
+bool sam_async(int argc, char **argv)
+{
+    sam_request req;
+    size_t used = 0;
+
+    if (argc > SAM_MAX_ARGS)
+        return false;
+
+    req.prompt = nullptr;
+    req.argc = argc;
+    for (int i = 0; i < argc; i++)
+    {
+        size_t l = strlen(argv[i]) + 1;
+        if (used + l > sizeof(req.args))
+            return false;
+        memcpy(&req.args[used], argv[i], l);
+        used += l;
+    }
+
+    return sam_enqueue(&req);
+}
+
+bool sam_say_prompt(const char *phrase)
+{
+    for (const SamPrompt &prompt : samPrompts)
+    {
+        // A missing file just means the phrase gets rendered instead
+        if (strcmp(prompt.phrase, phrase) == 0 && fsFlash.exists(prompt.path))
+        {
+            sam_request req;
+            req.prompt = &prompt;
+            req.argc = 0;
+            return sam_enqueue(&req);
+        }
+    }
+    return false;
+}
+
+#endif // ESP_PLATFORM
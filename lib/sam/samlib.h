@@ -7,11 +7,6 @@
 #include "sam.h"
 #include "samdebug.h"
 
-#ifdef USESDL
-#include <SDL.h>
-#include <SDL_audio.h>
-#endif
-
 #ifdef ESP_PLATFORM
 #include "../../include/pinmap.h"
 #endif
@@ -21,16 +16,16 @@ extern char input[256];
 #endif
 
 #ifndef ESP_PLATFORM
-void WriteWav(char *filename, char *buffer, int bufferlength);
+int WriteWav(char *filename);
 #endif // ESP_PLATFORM
 
 void PrintUsage();
 
-#ifdef USESDL
-void MixAudio(void *unused, Uint8 *stream, int len);
-void OutputSound();
-#else
-void OutputSound();
-#endif
-
 int sam(int argc, char **argv);
+
+#ifdef ESP_PLATFORM
+// Queue a sam() invocation for the speech task, returns false if it was dropped
+bool sam_async(int argc, char **argv);
+// Queue one of the precomputed SamPrompts.h phrases, false if there is none
+bool sam_say_prompt(const char *phrase);
+#endif
@@ -49,6 +49,7 @@ protected:
     uint8_t _id;                                    // task ID 1..255, 0 is invalid / not yet assigned ID
     task_state _state;
     done_reason _reason;
+    uint64_t _paused_ms;                            // fnSystem.millis() when paused
     void (*_callback)(fnTask *t, task_state new_state);
 };
 
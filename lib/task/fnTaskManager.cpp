@@ -1,8 +1,7 @@
-#ifndef ESP_PLATFORM
-
 #include <list>
 
 #include "fnTaskManager.h"
+#include "fnSystem.h"
 #include "debug.h"
 
 // global task manager object
@@ -102,6 +101,7 @@ int fnTaskManager::pause_task(uint8_t tid)
         return -1;
     int result = task->pause();
     task->_state = fnTask::TASK_PAUSED;
+    task->_paused_ms = fnSystem.millis();
     // TODO callback
     return result;
 }
@@ -163,6 +163,7 @@ bool fnTaskManager::service()
     fnTask *task;
     std::list <uint8_t> failed;
     std::list <uint8_t> completed;
+    uint64_t now = fnSystem.millis();
 
     // update READY and RUNNING tasks
     for (auto it = _task_map.begin(); it != _task_map.end(); ++it)
@@ -192,22 +193,26 @@ bool fnTaskManager::service()
                 completed.push_back(it->first);
             }
             break;
+
+        case fnTask::TASK_PAUSED:
+            // nobody came back for it
+            if (now - task->_paused_ms >= TASK_PAUSED_TIMEOUT_MS)
+            {
+                Debug_printf("Task %d paused for too long\n", it->first);
+                failed.push_back(it->first);
+            }
+            break;
         default:
             ;
         }
     }
 
-    if (!idle)
-    {
-        // handle failed tasks, if any
-        for (auto it = failed.begin(); it != failed.end(); ++it)
-            abort_task(*it);
-        // handle completed tasks, if any
-        for (auto it = completed.begin(); it != completed.end(); ++it)
-            complete_task(*it);
-    }
+    // handle failed and expired tasks, if any
+    for (auto it = failed.begin(); it != failed.end(); ++it)
+        abort_task(*it);
+    // handle completed tasks, if any
+    for (auto it = completed.begin(); it != completed.end(); ++it)
+        complete_task(*it);
 
     return idle;
 }
-
-#endif // !ESP_PLATFORM
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 #include "fnTask.h"
 
+// Tasks left paused this long are aborted
+#define TASK_PAUSED_TIMEOUT_MS (10 * 60 * 1000)
 
 class fnTaskManager
 {
@@ -1,27 +1,35 @@
 #include "fnDNS.h"
 
+#include <string.h>
+
 #include "../../include/debug.h"
 
 
 // Return a single IP4 address given a hostname
+// Uses getaddrinfo() rather than gethostbyname(), which shares one static
+// result between callers, as hosts may be mounted on more than one task at once
 in_addr_t get_ip4_addr_by_name(const char *hostname)
 {
     in_addr_t result = IPADDR_NONE;
 
     Debug_printf("Resolving hostname \"%s\"\r\n", hostname);
-    struct hostent *info = gethostbyname(hostname);
 
-    if(info == nullptr)
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+
+    struct addrinfo *info = nullptr;
+    if(getaddrinfo(hostname, nullptr, &hints, &info) != 0 || info == nullptr)
     {
         Debug_println("Name failed to resolve");
     }
     else
     {
-        if(info->h_addr_list[0] != nullptr)
-        {
-            result = *((in_addr_t*)(info->h_addr_list[0]));
-            Debug_printf("Resolved to address %s\r\n", compat_inet_ntoa(result));
-        }
+        result = ((struct sockaddr_in *)info->ai_addr)->sin_addr.s_addr;
+        Debug_printf("Resolved to address %s\r\n", compat_inet_ntoa(result));
     }
+
+    if(info != nullptr)
+        freeaddrinfo(info);
     return result;
 }
\ No newline at end of file
@@ -31,17 +31,7 @@ int fnTcpServer::begin(uint16_t port)
         return 0;
     }
 
-    // Bind socket to our interface
-    struct sockaddr_in server;
-    server.sin_family = AF_INET;
-    server.sin_addr.s_addr = INADDR_ANY;
-    server.sin_port = htons(_port);
-    if (bind(_sockfd, (struct sockaddr *)&server, sizeof(server)) < 0)
-    {
-        Debug_printf("fnTcpServer::begin failed to bind socket, err %d\r\n", compat_getsockerr());
-        return 0;
-    }
-
+    // before bind(), or a port left in TIME_WAIT by the last run can't be bound again
     int enable = 1;
 #if defined(_WIN32)
     if (setsockopt(_sockfd, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (char *) &enable, sizeof(enable)) != 0)
@@ -57,6 +47,17 @@ int fnTcpServer::begin(uint16_t port)
     }
 #endif
 
+    // Bind socket to our interface
+    struct sockaddr_in server;
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = INADDR_ANY;
+    server.sin_port = htons(_port);
+    if (bind(_sockfd, (struct sockaddr *)&server, sizeof(server)) < 0)
+    {
+        Debug_printf("fnTcpServer::begin failed to bind socket, err %d\r\n", compat_getsockerr());
+        return 0;
+    }
+
     Debug_printf("Max clients is currently %u\r\n",_max_clients);
 
     // Now listen in on this socket
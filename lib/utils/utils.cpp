@@ -669,6 +669,9 @@ bool util_string_value_is_true(std::string value)
  * @param speed Sam's speed. (1-255) Lower values = higher speed. Default is 72. Values below 20 are usuable.
  * @param mouth The emphasis of transient sounds (1-255), Higher values imply more pronounced mouth movement. Default is 128.
  * @param throat The size of throat, changes resonance of formant sounds (1-255), higher values imply a deeper throat. Default is 128.
+ *
+ * Speech is queued to the SAM task and this returns straight away. Phrases
+ * precomputed in SamPrompts.h are played from flash without rendering.
  */
 void util_sam_say(const char *p,
                   bool phonetic,
@@ -682,6 +685,13 @@ void util_sam_say(const char *p,
     char *a[20];
     char pitchs[4], speeds[4], mouths[4], throats[4]; // itoa temp vars
 
+#ifdef ESP_PLATFORM
+    // The prompts were rendered with the default voice
+    if (phonetic && !sing && pitch == 64 && speed == 96 && mouth == 128 && throat == 128 &&
+        sam_say_prompt(p))
+        return;
+#endif
+
     // Convert to strings.
 #ifdef ESP_PLATFORM
     itoa(pitch, pitchs, 10);
@@ -719,7 +729,7 @@ void util_sam_say(const char *p,
     // Append the phrase to say.
     a[n++] = (char *)p;
 #ifdef ESP_PLATFORM
-    sam(n, a);
+    sam_async(n, a);
 #endif
 }
 
@@ -28,8 +28,9 @@
 
 #include "httpService.h"
 
-#ifndef ESP_PLATFORM
 #include "fnTaskManager.h"
+
+#ifndef ESP_PLATFORM
 #include "version.h"
 #include "build_version.h"
 #endif
@@ -501,14 +502,15 @@ void fn_service_loop(void *param)
 #endif
         SYSTEM_BUS.service();
 
+        // Background jobs such as host to host copies, one step per pass
+        taskMgr.service();
+
 #ifdef ESP_PLATFORM
         taskYIELD(); // Allow other tasks to run
 #else
 // !ESP_PLATFORM
         fnHTTPD.service();
 
-        taskMgr.service();
-
         if (fnSystem.check_deferred_reboot())
         {
             // stop the web server first
@@ -0,0 +1,49 @@
+/**
+ * #FujiNet Tests - fnSystem for the host
+ *
+ * The tests time themselves and wait through fnSystem. The real
+ * lib/hardware/fnSystem.cpp brings in the bus, the file systems and WiFi,
+ * so the host build gets just the calls the tests make.
+ */
+
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "../lib/hardware/fnSystem.h"
+
+SystemManager fnSystem;
+
+SystemManager::SystemManager()
+{
+    memset(_uptime_string, 0, sizeof(_uptime_string));
+    memset(_currenttime_string, 0, sizeof(_currenttime_string));
+    memset(_uname_string, 0, sizeof(_uname_string));
+}
+
+uint64_t SystemManager::micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+uint64_t SystemManager::millis()
+{
+    return micros() / 1000;
+}
+
+void SystemManager::delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void SystemManager::delay_microseconds(uint32_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// as on the PC build
+uint32_t SystemManager::get_psram_size()
+{
+    return 0;
+}
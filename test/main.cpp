@@ -6,6 +6,21 @@
 #include <esp32/rom/ets_sys.h>
 #include "test_pass.h"
 #include "test_networkprotocol_translation.h"
+#include "test_pdf_printer.h"
+#include "test_cassette_wav.h"
+#include "test_pclink_dir.h"
+#include "test_hash.h"
+#include "test_base64.h"
+#include "test_hostcopy.h"
+#include "test_filemem.h"
+#include "test_ftp_file.h"
+#include "test_mediacache.h"
+#include "test_smb_file.h"
+#include "test_dirstream.h"
+#include "test_dsknibble.h"
+#include "test_macgcr.h"
+#include "test_spcodec.h"
+#include "test_sam.h"
 #include "../lib/hardware/fnSystem.h"
 
 extern "C"
@@ -24,6 +39,21 @@ void app_main()
 
     test_pass_run();
     tests_networkprotocol_translation();
+    tests_pdf_printer();
+    tests_cassette_wav();
+    tests_pclink_dir();
+    tests_hash();
+    tests_base64();
+    tests_hostcopy();
+    tests_filemem();
+    tests_ftp_file();
+    tests_mediacache();
+    tests_smb_file();
+    tests_dirstream();
+    tests_dsknibble();
+    tests_macgcr();
+    tests_spcodec();
+    tests_sam();
 
     UNITY_END();
 }
\ No newline at end of file
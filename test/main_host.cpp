@@ -0,0 +1,50 @@
+/**
+ * #FujiNet Unit Tests - Main, for the host
+ *
+ * The tests that don't need the ESP32, built by the fujinet_pc.cmake
+ * "fujinet-tests" target and run with ctest.
+ */
+
+#include <unity.h>
+#include "test_hash.h"
+#include "test_dsknibble.h"
+#include "test_macgcr.h"
+#include "test_spcodec.h"
+#include "test_sam.h"
+#include "test_base64.h"
+#include "test_cassette_wav.h"
+#include "test_filemem.h"
+#include "test_ftp_file.h"
+#include "test_mediacache.h"
+#include "test_smb_file.h"
+#include "test_dirstream.h"
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    tests_hash();
+    tests_dsknibble();
+    tests_macgcr();
+    tests_spcodec();
+    tests_sam();
+    tests_base64();
+#ifdef BUILD_ATARI
+    tests_cassette_wav();
+#endif
+    tests_filemem();
+    tests_ftp_file();
+    tests_mediacache();
+    tests_smb_file();
+    tests_dirstream();
+
+    return UNITY_END();
+}
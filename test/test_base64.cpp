@@ -0,0 +1,233 @@
+/**
+ * #FujiNet Tests - Streaming base64
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "../lib/encoding/base64.h"
+#include "../lib/hardware/fnSystem.h"
+#include "test_base64.h"
+#include "test_unity.h"
+
+#define BENCH_BYTES 65536
+
+static std::vector<uint8_t> test_data(size_t len)
+{
+    std::vector<uint8_t> data(len);
+    uint32_t x = 0x12345678;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        x = x * 1103515245 + 12345;
+        data[i] = x >> 24;
+    }
+    return data;
+}
+
+static std::string oneshot_encode(const std::vector<uint8_t> &data)
+{
+    size_t out_len;
+    std::unique_ptr<char[]> p = Base64::encode(data.data(), data.size(), &out_len);
+    return std::string(p.get(), out_len);
+}
+
+static bool oneshot_decode(const std::string &text, std::string &out)
+{
+    size_t out_len;
+    std::unique_ptr<unsigned char[]> p = Base64::decode(text.data(), text.size(), &out_len);
+    if (!p)
+        return false;
+    out.assign((const char *)p.get(), out_len);
+    return true;
+}
+
+static bool stream_decode(const std::string &text, size_t chunk, std::string &out)
+{
+    Base64Decoder dec;
+
+    out.clear();
+    for (size_t i = 0; i < text.size(); i += chunk)
+        dec.update(text.data() + i, std::min(chunk, text.size() - i), out);
+    return dec.finish(out);
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_base64()
+{
+    RUN_TEST(tests_base64_encode_chunked);
+    RUN_TEST(tests_base64_decode_chunked);
+    RUN_TEST(tests_base64_decode_errors);
+    RUN_TEST(tests_base64_commands);
+    RUN_TEST(tests_base64_throughput);
+}
+
+/**
+ * Lengths either side of a line and of a group, split every which way
+ */
+void tests_base64_encode_chunked()
+{
+    static const size_t lengths[] = {0, 1, 2, 3, 53, 54, 55, 107, 108, 109, 1000};
+
+    for (size_t len : lengths)
+    {
+        std::vector<uint8_t> data = test_data(len);
+        std::string want = oneshot_encode(data);
+
+        for (size_t chunk = 1; chunk <= 80; chunk++)
+        {
+            Base64Encoder enc;
+            std::string got;
+
+            for (size_t i = 0; i < len; i += chunk)
+                enc.update(data.data() + i, std::min(chunk, len - i), got);
+            enc.finish(got);
+
+            TEST_ASSERT_EQUAL_STRING(want.c_str(), got.c_str());
+        }
+    }
+}
+
+/**
+ * Decoder input the fuji commands are likely to see
+ */
+void tests_base64_decode_chunked()
+{
+    std::vector<uint8_t> data = test_data(500);
+    std::string wrapped = oneshot_encode(data);
+    std::string unwrapped, junk, unpadded;
+
+    for (char c : wrapped)
+    {
+        if (c == '\n')
+        {
+            junk += "\r\n";
+            continue;
+        }
+        unwrapped += c;
+        junk += c;
+        if (unwrapped.size() % 7 == 0)
+            junk += ' ';
+    }
+    unpadded = unwrapped.substr(0, unwrapped.find('='));
+
+    const std::string *inputs[] = {&wrapped, &unwrapped, &junk, &unpadded};
+
+    for (const std::string *text : inputs)
+    {
+        std::string want;
+        TEST_ASSERT_TRUE(oneshot_decode(*text, want));
+        TEST_ASSERT_EQUAL(500, want.size());
+
+        for (size_t chunk = 1; chunk <= 80; chunk++)
+        {
+            std::string got;
+            TEST_ASSERT_TRUE(stream_decode(*text, chunk, got));
+            TEST_ASSERT_TRUE(got == want);
+        }
+    }
+
+    /* anything after the padded block is ignored */
+    std::string want, got;
+    TEST_ASSERT_TRUE(oneshot_decode("QUI=QUJD", want));
+    TEST_ASSERT_TRUE(stream_decode("QUI=QUJD", 3, got));
+    TEST_ASSERT_EQUAL_STRING("AB", want.c_str());
+    TEST_ASSERT_TRUE(got == want);
+}
+
+/**
+ * Error cases
+ */
+void tests_base64_decode_errors()
+{
+    static const char *bad[] = {"", "\r\n", "Q", "QUJDR", "Q===", "A=BC"};
+    std::string out;
+
+    for (const char *text : bad)
+    {
+        bool ok = oneshot_decode(text, out);
+        for (size_t chunk = 1; chunk <= 4; chunk++)
+            TEST_ASSERT_TRUE(stream_decode(text, chunk, out) == ok);
+    }
+}
+
+/**
+ * What sio_base64_encode_input() and friends do with the shared instance
+ */
+void tests_base64_commands()
+{
+    std::vector<uint8_t> data = test_data(300);
+    std::string want = oneshot_encode(data);
+    char out[64];
+    std::string got;
+
+    for (size_t i = 0; i < data.size(); i += 128)
+        base64.encode_input(data.data() + i, std::min((size_t)128, data.size() - i));
+    TEST_ASSERT_TRUE(base64.encode_compute());
+    TEST_ASSERT_EQUAL(want.size(), base64.output_length());
+
+    while (base64.output_length())
+    {
+        size_t n = std::min(sizeof(out), base64.output_length());
+        TEST_ASSERT_EQUAL(n, base64.output(out, n));
+        got.append(out, n);
+    }
+    TEST_ASSERT_TRUE(got == want);
+
+    /* round trip, starting over after the last OUTPUT */
+    base64.decode_input(got.data(), got.size());
+    TEST_ASSERT_TRUE(base64.decode_compute());
+    TEST_ASSERT_EQUAL(data.size(), base64.output_length());
+    TEST_ASSERT_EQUAL(data.size(), base64.get_buffer().size());
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), base64.get_buffer().data(), data.size());
+
+    /* a failed COMPUTE leaves nothing behind */
+    base64.clear_buffer();
+    base64.decode_input("Q", 1);
+    TEST_ASSERT_FALSE(base64.decode_compute());
+    TEST_ASSERT_EQUAL(0, base64.output_length());
+}
+
+/**
+ * Benchmark: old whole-buffer path against streaming in 255 byte frames
+ */
+void tests_base64_throughput()
+{
+    std::vector<uint8_t> data = test_data(BENCH_BYTES);
+    std::string text = oneshot_encode(data);
+    char msg[120];
+    size_t out_len;
+
+    uint64_t start = fnSystem.millis();
+    for (int r = 0; r < 16; r++)
+    {
+        std::unique_ptr<char[]> e = Base64::encode(data.data(), data.size(), &out_len);
+        std::unique_ptr<unsigned char[]> d = Base64::decode(e.get(), out_len, &out_len);
+    }
+    uint64_t oneshot_ms = fnSystem.millis() - start;
+
+    start = fnSystem.millis();
+    for (int r = 0; r < 16; r++)
+    {
+        Base64Encoder enc;
+        Base64Decoder dec;
+        std::string e, d;
+
+        for (size_t i = 0; i < data.size(); i += 255)
+            enc.update(data.data() + i, std::min((size_t)255, data.size() - i), e);
+        enc.finish(e);
+        for (size_t i = 0; i < e.size(); i += 255)
+            dec.update(e.data() + i, std::min((size_t)255, e.size() - i), d);
+        TEST_ASSERT_TRUE(dec.finish(d));
+        TEST_ASSERT_EQUAL(BENCH_BYTES, d.size());
+    }
+    uint64_t stream_ms = fnSystem.millis() - start;
+
+    snprintf(msg, sizeof(msg), "16 x %d KB encode+decode: one-shot %u ms, streaming %u ms",
+             BENCH_BYTES / 1024, (unsigned)oneshot_ms, (unsigned)stream_ms);
+    TEST_MESSAGE(msg);
+}
@@ -0,0 +1,51 @@
+/**
+ * #FujiNet Tests - Streaming base64
+ *
+ * The streaming codec behind the fuji BASE64 commands must match the
+ * one-shot Base64::encode()/decode() byte for byte, however the input
+ * is split up. Also built for the host, see test/main_host.cpp.
+ */
+
+#ifndef TEST_BASE64_H
+#define TEST_BASE64_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_base64();
+
+    /**
+     * Encoding in pieces of every size from 1 to 80 bytes
+     */
+    void tests_base64_encode_chunked();
+
+    /**
+     * Decoding wrapped, unwrapped, junk-laden and unpadded text in pieces
+     */
+    void tests_base64_decode_chunked();
+
+    /**
+     * Empty input and bad padding fail the same way as before
+     */
+    void tests_base64_decode_errors();
+
+    /**
+     * INPUT/COMPUTE/OUTPUT sequence as the fuji device runs it
+     */
+    void tests_base64_commands();
+
+    /**
+     * Benchmark: 64 KB through the one-shot and the streaming codec
+     */
+    void tests_base64_throughput();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_BASE64_H */
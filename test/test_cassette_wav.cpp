@@ -0,0 +1,183 @@
+/**
+ * #FujiNet Tests - WAV cassette decoding
+ *
+ * Each test synthesizes a tape (leader, two standard 132 byte records)
+ * into a memory file and checks the records, gaps and baud rate that
+ * wavTape recovers.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "../lib/device/sio/cassetteDecode.h"
+#include "../lib/FileSystem/fnFileMem.h"
+#include "test_cassette_wav.h"
+
+#define TEST_RECORDS 2
+#define TEST_RECORD_LEN 132
+#define TEST_LEADER_MS 2000
+#define TEST_IRG_MS 250
+
+struct wav_synth
+{
+    uint32_t rate;
+    uint16_t bits;
+    uint16_t channels;
+    double speed;     // 1.0 = nominal tape speed
+    double amplitude; // 0..1 of full scale
+    double noise;     // 0..1 of full scale
+
+    std::vector<int16_t> samples;
+    double phase = 0;
+    uint32_t lcg = 12345;
+
+    void tone(double freq, double seconds)
+    {
+        size_t n = (size_t)(seconds * rate);
+        for (size_t i = 0; i < n; i++)
+        {
+            lcg = lcg * 1103515245 + 12345;
+            double r = ((lcg >> 16) & 0x7FFF) / 16384.0 - 1.0;
+            double v = amplitude * sin(phase) + noise * r;
+            phase += 2 * M_PI * freq * speed / rate;
+            samples.push_back((int16_t)(v * 32000));
+        }
+    }
+
+    void bit(int b)
+    {
+        tone(b ? 5327 : 3995, 1.0 / (600 * speed));
+    }
+
+    void byte(uint8_t c)
+    {
+        bit(0);
+        for (int i = 0; i < 8; i++)
+            bit((c >> i) & 1);
+        bit(1);
+    }
+
+    void le(FileHandlerMem *f, uint32_t v, int len)
+    {
+        for (int i = 0; i < len; i++)
+        {
+            uint8_t b = v >> (i * 8);
+            f->write(&b, 1, 1);
+        }
+    }
+
+    FileHandlerMem *wav()
+    {
+        FileHandlerMem *f = new FileHandlerMem();
+        uint32_t data_len = samples.size() * channels * bits / 8;
+        f->write("RIFF", 1, 4);
+        le(f, 36 + data_len, 4);
+        f->write("WAVEfmt ", 1, 8);
+        le(f, 16, 4);
+        le(f, 1, 2);
+        le(f, channels, 2);
+        le(f, rate, 4);
+        le(f, rate * channels * bits / 8, 4);
+        le(f, channels * bits / 8, 2);
+        le(f, bits, 2);
+        f->write("data", 1, 4);
+        le(f, data_len, 4);
+        for (int16_t s : samples)
+            for (int c = 0; c < channels; c++)
+                le(f, bits == 16 ? (uint16_t)s : (uint8_t)((s >> 8) + 128), bits / 8);
+        return f;
+    }
+};
+
+static void make_record(uint8_t *rec, int n)
+{
+    rec[0] = 0x55;
+    rec[1] = 0x55;
+    rec[2] = 0xFC;
+    for (int i = 0; i < 128; i++)
+        rec[3 + i] = (uint8_t)(i * 7 + n * 31);
+    unsigned sum = 0;
+    for (int i = 0; i < 131; i++)
+    {
+        sum += rec[i];
+        sum = (sum >> 8) + (sum & 0xFF);
+    }
+    rec[131] = sum;
+}
+
+static void run_tape(uint32_t rate, uint16_t bits, uint16_t channels, double speed, double amplitude, double noise)
+{
+    wav_synth synth = {rate, bits, channels, speed, amplitude, noise};
+    uint8_t records[TEST_RECORDS][TEST_RECORD_LEN];
+
+    for (int r = 0; r < TEST_RECORDS; r++)
+    {
+        make_record(records[r], r);
+        synth.tone(5327, (r == 0 ? TEST_LEADER_MS : TEST_IRG_MS) / 1000.0 / speed);
+        for (int i = 0; i < TEST_RECORD_LEN; i++)
+            synth.byte(records[r][i]);
+    }
+    synth.tone(5327, 0.5);
+
+    FileHandlerMem *f = synth.wav();
+    wavTape tape;
+    TEST_ASSERT_TRUE(tape.open(f));
+
+    size_t pos = 0;
+    uint8_t buf[256];
+    uint16_t irg, baud;
+    for (int r = 0; r < TEST_RECORDS; r++)
+    {
+        size_t len = tape.read_block(&pos, buf, sizeof(buf), &irg, &baud);
+        TEST_ASSERT_EQUAL_UINT(TEST_RECORD_LEN, len);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(records[r], buf, TEST_RECORD_LEN);
+        // 600 baud scaled by tape speed, within 2%
+        TEST_ASSERT_UINT_WITHIN(600 * speed / 50, 600 * speed, baud);
+        if (r > 0)
+            TEST_ASSERT_UINT_WITHIN(20, TEST_IRG_MS / speed, irg);
+    }
+    TEST_ASSERT_EQUAL_UINT(0, tape.read_block(&pos, buf, sizeof(buf), &irg, &baud));
+
+    f->close();
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_cassette_wav()
+{
+    RUN_TEST(tests_cassette_wav_44k_16bit);
+    RUN_TEST(tests_cassette_wav_22k_8bit);
+    RUN_TEST(tests_cassette_wav_48k_stereo_noisy);
+    RUN_TEST(tests_cassette_wav_fast_tape);
+    RUN_TEST(tests_cassette_wav_reject);
+}
+
+void tests_cassette_wav_44k_16bit()
+{
+    run_tape(44100, 16, 1, 1.0, 0.8, 0.0);
+}
+
+void tests_cassette_wav_22k_8bit()
+{
+    run_tape(22050, 8, 1, 1.0, 0.8, 0.0);
+}
+
+void tests_cassette_wav_48k_stereo_noisy()
+{
+    run_tape(48000, 8, 2, 1.0, 0.1, 0.03);
+}
+
+void tests_cassette_wav_fast_tape()
+{
+    run_tape(44100, 16, 1, 1.06, 0.5, 0.01);
+}
+
+void tests_cassette_wav_reject()
+{
+    FileHandlerMem *f = new FileHandlerMem();
+    f->write("FUJI\x10\0\0\0", 1, 8);
+    wavTape tape;
+    TEST_ASSERT_FALSE(tape.open(f));
+    f->close();
+}
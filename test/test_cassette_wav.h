@@ -0,0 +1,50 @@
+/**
+ * #FujiNet Tests - WAV cassette decoding
+ *
+ * Synthesizes Atari FSK tape recordings and decodes them with wavTape.
+ * Also built for the host in an Atari build, see test/main_host.cpp.
+ */
+
+#ifndef TEST_CASSETTE_WAV_H
+#define TEST_CASSETTE_WAV_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_cassette_wav();
+
+    /**
+     * 44.1 kHz, 16 bit mono, clean signal
+     */
+    void tests_cassette_wav_44k_16bit();
+
+    /**
+     * 22.05 kHz, 8 bit mono
+     */
+    void tests_cassette_wav_22k_8bit();
+
+    /**
+     * 48 kHz, 8 bit stereo, quiet recording with noise
+     */
+    void tests_cassette_wav_48k_stereo_noisy();
+
+    /**
+     * Tape running 6% fast (tones and baud rate both shifted)
+     */
+    void tests_cassette_wav_fast_tape();
+
+    /**
+     * Not a WAV file
+     */
+    void tests_cassette_wav_reject();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_CASSETTE_WAV_H */
@@ -0,0 +1,278 @@
+/**
+ * #FujiNet Tests - Streaming directory listings
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/FileSystem/fnDirStream.h"
+#include "../lib/task/fnTaskManager.h"
+#include "test_dirstream.h"
+
+#define DIR_PATH "/games"
+#define DIR_MTIME 1700000000
+
+/*
+ * Host listing `entries` files, DIRSTREAM_PAGE of them per fetch
+ */
+class paged_stream : public DirStream
+{
+public:
+    uint16_t entries = 0;
+    unsigned pages = 0;
+    unsigned finishes = 0;
+    bool broken = false;
+
+    paged_stream(DirListingCache *cache) : DirStream(cache) {};
+    ~paged_stream() override { stop(); };
+
+    // what the host does on an open
+    bool open(time_t mtime)
+    {
+        if (resume(DIR_PATH, nullptr, 0, mtime))
+            return true;
+        std::shared_ptr<DirListing> listing;
+        if (_cache != nullptr)
+            listing = _cache->find(DIR_PATH, nullptr, 0, mtime);
+        if (listing == nullptr)
+            listing = std::make_shared<DirListing>(DIR_PATH, nullptr, 0, mtime);
+        if (start(listing))
+            return false;
+        prefetch();
+        return true;
+    }
+
+protected:
+    bool fetch_page() override
+    {
+        if (broken)
+            return true;
+        pages++;
+        char name[32];
+        for (int i = 0; i < DIRSTREAM_PAGE; i++)
+        {
+            uint16_t n = _listing->count();
+            if (n >= entries)
+            {
+                _listing->complete = true;
+                break;
+            }
+            snprintf(name, sizeof(name), "FILE%04u.ATR", n);
+            _listing->add(name, false, n * 10, DIR_MTIME + n);
+        }
+        return false;
+    }
+    void finish() override { finishes++; };
+};
+
+static void check_entry(fsdir_entry *e, uint16_t n)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "FILE%04u.ATR", n);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_STRING(name, e->filename);
+    TEST_ASSERT_EQUAL_UINT32(n * 10, e->size);
+    TEST_ASSERT_FALSE(e->isDir);
+}
+
+static void run_tasks()
+{
+    for (int i = 0; i < 1000; i++)
+        taskMgr.service();
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_dirstream()
+{
+    RUN_TEST(tests_dirstream_prefetch);
+    RUN_TEST(tests_dirstream_on_demand);
+    RUN_TEST(tests_dirstream_resume);
+    RUN_TEST(tests_dirstream_reopen_mid_fetch);
+    RUN_TEST(tests_dirstream_cache);
+}
+
+/**
+ * The first page is there on open and the task fetches the rest
+ */
+void tests_dirstream_prefetch()
+{
+    DirListingCache cache;
+    paged_stream s(&cache);
+    s.entries = DIRSTREAM_PAGE * 4 + 5;
+
+    TEST_ASSERT_TRUE(s.open(DIR_MTIME));
+    TEST_ASSERT_EQUAL(1, s.pages);
+    TEST_ASSERT_EQUAL_UINT16(0, s.tell());
+
+    run_tasks();
+    TEST_ASSERT_EQUAL(5, s.pages);
+    TEST_ASSERT_EQUAL(1, s.finishes);
+
+    // all from memory now
+    for (uint16_t n = 0; n < s.entries; n++)
+        check_entry(s.read(), n);
+    TEST_ASSERT_NULL(s.read());
+    TEST_ASSERT_EQUAL(5, s.pages);
+    TEST_ASSERT_EQUAL_UINT16(s.entries, s.tell());
+
+    // an empty directory has no position, as DirCache does
+    s.close();
+    paged_stream empty(&cache);
+    TEST_ASSERT_TRUE(empty.open(DIR_MTIME + 1));
+    TEST_ASSERT_NULL(empty.read());
+    TEST_ASSERT_EQUAL_UINT16(FNFS_INVALID_DIRPOS, empty.tell());
+}
+
+/**
+ * A reader ahead of the task, and seeks past what has been fetched
+ */
+void tests_dirstream_on_demand()
+{
+    paged_stream s(nullptr);
+    s.entries = DIRSTREAM_PAGE * 3;
+
+    TEST_ASSERT_TRUE(s.open(0));
+    for (uint16_t n = 0; n < DIRSTREAM_PAGE + 1; n++)
+        check_entry(s.read(), n);
+    TEST_ASSERT_EQUAL(2, s.pages);
+
+    TEST_ASSERT_TRUE(s.seek(DIRSTREAM_PAGE * 2 + 3));
+    TEST_ASSERT_EQUAL(3, s.pages);
+    check_entry(s.read(), DIRSTREAM_PAGE * 2 + 3);
+
+    // back, without the host
+    TEST_ASSERT_TRUE(s.seek(1));
+    check_entry(s.read(), 1);
+    TEST_ASSERT_FALSE(s.seek(s.entries + 1));
+    TEST_ASSERT_TRUE(s.seek(s.entries));
+    TEST_ASSERT_NULL(s.read());
+
+    // the task has nothing left to do
+    run_tasks();
+    TEST_ASSERT_EQUAL(4, s.pages);
+    TEST_ASSERT_EQUAL(1, s.finishes);
+
+    // a host that stops answering ends the listing early
+    paged_stream b(nullptr);
+    b.entries = DIRSTREAM_PAGE * 3;
+    TEST_ASSERT_TRUE(b.open(0));
+    b.broken = true;
+    TEST_ASSERT_FALSE(b.seek(DIRSTREAM_PAGE * 2));
+    TEST_ASSERT_EQUAL(1, b.finishes);
+    run_tasks();
+    TEST_ASSERT_EQUAL(1, b.finishes);
+}
+
+/**
+ * Closing between pages and opening again carries on with the same listing
+ */
+void tests_dirstream_resume()
+{
+    DirListingCache cache;
+    paged_stream s(&cache);
+    s.entries = DIRSTREAM_PAGE * 6;
+
+    // one screen, then closed as the Atari config program does
+    TEST_ASSERT_TRUE(s.open(DIR_MTIME));
+    for (uint16_t n = 0; n < 10; n++)
+        check_entry(s.read(), n);
+    s.close();
+    TEST_ASSERT_FALSE(s.active());
+    TEST_ASSERT_NULL(s.read());
+    TEST_ASSERT_EQUAL(0, s.finishes);
+
+    // the next screen
+    TEST_ASSERT_TRUE(s.open(DIR_MTIME));
+    TEST_ASSERT_EQUAL(1, s.pages);
+    TEST_ASSERT_TRUE(s.seek(10));
+    check_entry(s.read(), 10);
+    s.close();
+
+    run_tasks();
+    TEST_ASSERT_EQUAL(7, s.pages);
+    TEST_ASSERT_EQUAL(1, s.finishes);
+
+    // changed in between, listed again from the host
+    TEST_ASSERT_TRUE(s.open(DIR_MTIME + 60));
+    TEST_ASSERT_EQUAL(8, s.pages);
+    s.close();
+    run_tasks();
+}
+
+/**
+ * Closed while the task is fetching, then another listing opened
+ */
+void tests_dirstream_reopen_mid_fetch()
+{
+    paged_stream s(nullptr);
+    s.entries = DIRSTREAM_PAGE * 4;
+
+    TEST_ASSERT_TRUE(s.open(DIR_MTIME));
+    // the task starts, then fetches a page
+    taskMgr.service();
+    taskMgr.service();
+    TEST_ASSERT_EQUAL(2, s.pages);
+    s.close();
+    TEST_ASSERT_EQUAL(0, s.finishes);
+
+    // the unfinished listing lets the host go as its task is dropped
+    TEST_ASSERT_TRUE(s.open(DIR_MTIME + 60));
+    TEST_ASSERT_EQUAL(1, s.finishes);
+    TEST_ASSERT_EQUAL(3, s.pages);
+    check_entry(s.read(), 0);
+
+    run_tasks();
+    TEST_ASSERT_EQUAL(7, s.pages);
+    TEST_ASSERT_EQUAL(2, s.finishes);
+    s.close();
+}
+
+/**
+ * A finished listing is reused until the directory changes
+ */
+void tests_dirstream_cache()
+{
+    DirListingCache cache;
+    paged_stream s(&cache);
+    s.entries = DIRSTREAM_PAGE * 2 + 1;
+
+    TEST_ASSERT_TRUE(s.open(DIR_MTIME));
+    run_tasks();
+    s.close();
+    TEST_ASSERT_EQUAL(3, s.pages);
+
+    // from another stream on the same host, as after going up and back down
+    paged_stream again(&cache);
+    again.entries = s.entries;
+    TEST_ASSERT_TRUE(again.open(DIR_MTIME));
+    TEST_ASSERT_EQUAL(0, again.pages);
+    for (uint16_t n = 0; n < again.entries; n++)
+        check_entry(again.read(), n);
+    TEST_ASSERT_NULL(again.read());
+    again.close();
+
+    // the directory changed
+    TEST_ASSERT_TRUE(again.open(DIR_MTIME + 1));
+    TEST_ASSERT_EQUAL(1, again.pages);
+    again.close();
+    run_tasks();
+
+    // an unknown modification time is never cached
+    paged_stream unknown(&cache);
+    unknown.entries = 3;
+    TEST_ASSERT_TRUE(unknown.open(0));
+    unknown.close();
+    TEST_ASSERT_TRUE(unknown.open(0));
+    TEST_ASSERT_EQUAL(2, unknown.pages);
+    unknown.close();
+
+    // and too many listings push the oldest out
+    for (time_t t = 1; t <= DIRLISTING_CACHE_LISTINGS; t++)
+    {
+        TEST_ASSERT_TRUE(unknown.open(DIR_MTIME + 100 + t));
+        unknown.close();
+    }
+    TEST_ASSERT_NULL(cache.find(DIR_PATH, nullptr, 0, DIR_MTIME));
+    TEST_ASSERT_NOT_NULL(cache.find(DIR_PATH, nullptr, 0, DIR_MTIME + 100 + DIRLISTING_CACHE_LISTINGS));
+}
@@ -0,0 +1,51 @@
+/**
+ * #FujiNet Tests - Streaming directory listings
+ *
+ * DirStream over a pretend host which lists a directory of numbered files
+ * a page at a time and counts the pages it is asked for. Also built for the
+ * host, see test/main_host.cpp.
+ */
+
+#ifndef TEST_DIRSTREAM_H
+#define TEST_DIRSTREAM_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_dirstream();
+
+    /**
+     * The first page is there on open and the task fetches the rest
+     */
+    void tests_dirstream_prefetch();
+
+    /**
+     * A reader ahead of the task, and seeks past what has been fetched
+     */
+    void tests_dirstream_on_demand();
+
+    /**
+     * Closing between pages and opening again carries on with the same listing
+     */
+    void tests_dirstream_resume();
+
+    /**
+     * Closing while the task is fetching and opening another listing lets the host go
+     */
+    void tests_dirstream_reopen_mid_fetch();
+
+    /**
+     * A finished listing is reused until the directory changes
+     */
+    void tests_dirstream_cache();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_DIRSTREAM_H */
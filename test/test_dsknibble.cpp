@@ -0,0 +1,120 @@
+/**
+ * #FujiNet Tests - Disk II 6-and-2 tracks
+ */
+
+#include <string.h>
+#include "../lib/media/apple/dskNibble.h"
+#include "test_dsknibble.h"
+
+static uint8_t track_data[DSK_BYTES_PER_TRACK];
+static uint8_t decoded[DSK_BYTES_PER_TRACK];
+static uint8_t bits[DSK_TRACK_BYTES];
+static uint8_t rotated[DSK_TRACK_BYTES];
+
+static void fill_track(uint8_t track)
+{
+    for (int i = 0; i < DSK_BYTES_PER_TRACK; i++)
+        track_data[i] = (uint8_t)(i * 31 + (i >> 8) * 7 + track * 13);
+}
+
+static bool get_bit(const uint8_t *b, uint32_t pos)
+{
+    return (b[pos >> 3] >> (7 - (pos & 7))) & 1;
+}
+
+static void set_bit(uint8_t *b, uint32_t pos, bool v)
+{
+    if (v)
+        b[pos >> 3] |= 0x80 >> (pos & 7);
+    else
+        b[pos >> 3] &= ~(0x80 >> (pos & 7));
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_dsknibble()
+{
+    RUN_TEST(tests_dsknibble_round_trip);
+    RUN_TEST(tests_dsknibble_rotated);
+    RUN_TEST(tests_dsknibble_damaged);
+}
+
+/**
+ * Every track comes back as it went in, in DOS and ProDOS order
+ */
+void tests_dsknibble_round_trip()
+{
+    for (int prodos = 0; prodos < 2; prodos++)
+    {
+        for (uint8_t track = 0; track < 40; track++)
+        {
+            fill_track(track);
+            memset(bits, 0, sizeof(bits));
+            TEST_ASSERT_EQUAL_UINT32(DSK_TRACK_BITS, dsk_nibblize_track(bits, track_data, track, prodos));
+
+            memset(decoded, 0, sizeof(decoded));
+            TEST_ASSERT_EQUAL_HEX16(0xFFFF, dsk_denibblize_track(decoded, bits, DSK_TRACK_BITS, track, prodos));
+            TEST_ASSERT_EQUAL_MEMORY(track_data, decoded, DSK_BYTES_PER_TRACK);
+        }
+    }
+
+    // the first address field, after 16 syncs of 10 bits
+    fill_track(17);
+    dsk_nibblize_track(bits, track_data, 17, false);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, bits[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xD5, bits[20]);
+    TEST_ASSERT_EQUAL_HEX8(0xAA, bits[21]);
+    TEST_ASSERT_EQUAL_HEX8(0x96, bits[22]);
+}
+
+/**
+ * A stream starting part way round the track, as a write would
+ */
+void tests_dsknibble_rotated()
+{
+    fill_track(3);
+    dsk_nibblize_track(bits, track_data, 3, false);
+
+    // odd offsets split nibbles across bytes, and a sector across the end
+    const uint32_t offsets[] = {1, 3000, 12345, DSK_TRACK_BITS - 7};
+    for (uint32_t offset : offsets)
+    {
+        memset(rotated, 0, sizeof(rotated));
+        for (uint32_t i = 0; i < DSK_TRACK_BITS; i++)
+            set_bit(rotated, i, get_bit(bits, (i + offset) % DSK_TRACK_BITS));
+
+        memset(decoded, 0, sizeof(decoded));
+        TEST_ASSERT_EQUAL_HEX16(0xFFFF, dsk_denibblize_track(decoded, rotated, DSK_TRACK_BITS, 3, false));
+        TEST_ASSERT_EQUAL_MEMORY(track_data, decoded, DSK_BYTES_PER_TRACK);
+    }
+}
+
+/**
+ * Damaged sectors and other tracks are left out
+ */
+void tests_dsknibble_damaged()
+{
+    fill_track(5);
+    dsk_nibblize_track(bits, track_data, 5, true);
+
+    // not the track asked for
+    TEST_ASSERT_EQUAL_HEX16(0, dsk_denibblize_track(decoded, bits, DSK_TRACK_BITS, 6, true));
+    TEST_ASSERT_EQUAL_HEX16(0, dsk_denibblize_track(decoded, bits, 0, 5, true));
+
+    // a byte in the middle of physical sector 0's data field: 16 syncs, an
+    // address field, 7 syncs, the data prologue, then 100 nibbles in
+    uint32_t pos = 16 * 10 + 14 * 8 + 7 * 10 + 3 * 8 + 100 * 8;
+    for (int i = 1; i < 8; i++)
+        set_bit(bits, pos + i, !get_bit(bits, pos + i));
+
+    memset(decoded, 0, sizeof(decoded));
+    uint16_t found = dsk_denibblize_track(decoded, bits, DSK_TRACK_BITS, 5, true);
+    int bad = dsk_logical_sector(0, true);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF & ~(1 << bad), found);
+    for (int s = 0; s < DSK_SECTORS_PER_TRACK; s++)
+    {
+        if (s != bad)
+            TEST_ASSERT_EQUAL_MEMORY(&track_data[s * DSK_BYTES_PER_SECTOR], &decoded[s * DSK_BYTES_PER_SECTOR], DSK_BYTES_PER_SECTOR);
+    }
+}
@@ -0,0 +1,41 @@
+/**
+ * #FujiNet Tests - Disk II 6-and-2 tracks
+ *
+ * DSK tracks nibblized into bitstreams and read back the way the computer
+ * would write them: from anywhere on the track, and with damage. Also built
+ * for the host.
+ */
+
+#ifndef TEST_DSKNIBBLE_H
+#define TEST_DSKNIBBLE_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_dsknibble();
+
+    /**
+     * Every track comes back as it went in, in DOS and ProDOS order
+     */
+    void tests_dsknibble_round_trip();
+
+    /**
+     * A stream starting part way round the track, as a write would
+     */
+    void tests_dsknibble_rotated();
+
+    /**
+     * Damaged sectors and other tracks are left out
+     */
+    void tests_dsknibble_damaged();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_DSKNIBBLE_H */
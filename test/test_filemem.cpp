@@ -0,0 +1,182 @@
+/**
+ * #FujiNet Tests - Paged memory file
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/FileSystem/fnFileMem.h"
+#include "../lib/hardware/fnSystem.h"
+#include "test_filemem.h"
+#include "test_unity.h"
+
+static uint8_t pattern(long pos)
+{
+    return (uint8_t)(pos * 13 + (pos >> 9));
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_filemem()
+{
+    RUN_TEST(tests_filemem_round_trip);
+    RUN_TEST(tests_filemem_seek_hole);
+    RUN_TEST(tests_filemem_view);
+    RUN_TEST(tests_filemem_1m_write);
+}
+
+/**
+ * Writes and reads which straddle pages come back intact
+ */
+void tests_filemem_round_trip()
+{
+    FileHandlerMem *f = new FileHandlerMem();
+    uint8_t buf[3000];
+    long pos = 0;
+
+    // odd sizes so every write ends somewhere new inside a page
+    for (int n = 1; pos < 5 * FILEMEM_PAGE_SIZE; n = n * 3 % 2999 + 1)
+    {
+        for (int i = 0; i < n; i++)
+            buf[i] = pattern(pos + i);
+        TEST_ASSERT_EQUAL(n, f->write(buf, 1, n));
+        pos += n;
+    }
+    TEST_ASSERT_EQUAL(pos, f->tell());
+    TEST_ASSERT_EQUAL(pos, f->size());
+
+    TEST_ASSERT_EQUAL(0, f->seek(FILEMEM_PAGE_SIZE - 100, SEEK_SET));
+    TEST_ASSERT_EQUAL(1, f->read(buf, sizeof(buf), 1));
+    for (size_t i = 0; i < sizeof(buf); i++)
+        TEST_ASSERT_EQUAL_UINT8(pattern(FILEMEM_PAGE_SIZE - 100 + i), buf[i]);
+
+    // overwrite across a page boundary, the file must not grow
+    memset(buf, 0xA5, 200);
+    TEST_ASSERT_EQUAL(0, f->seek(2 * FILEMEM_PAGE_SIZE - 100, SEEK_SET));
+    TEST_ASSERT_EQUAL(200, f->write(buf, 1, 200));
+    TEST_ASSERT_EQUAL(pos, f->size());
+    TEST_ASSERT_EQUAL(0, f->seek(2 * FILEMEM_PAGE_SIZE - 101, SEEK_SET));
+    TEST_ASSERT_EQUAL(202, f->read(buf, 1, 202));
+    TEST_ASSERT_EQUAL_UINT8(pattern(2 * FILEMEM_PAGE_SIZE - 101), buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xA5, buf[1]);
+    TEST_ASSERT_EQUAL_UINT8(0xA5, buf[200]);
+    TEST_ASSERT_EQUAL_UINT8(pattern(2 * FILEMEM_PAGE_SIZE + 100), buf[201]);
+
+    // short read at the end of the file
+    TEST_ASSERT_EQUAL(0, f->seek(pos - 10, SEEK_SET));
+    TEST_ASSERT_EQUAL(10, f->read(buf, 1, 100));
+    TEST_ASSERT_EQUAL(0, f->read(buf, 1, 100));
+
+    f->close();
+}
+
+/**
+ * Seeking past the end leaves a hole of zeros, SEEK_END counts from the end
+ */
+void tests_filemem_seek_hole()
+{
+    FileHandlerMem *f = new FileHandlerMem();
+    uint8_t buf[16];
+
+    TEST_ASSERT_EQUAL(4, f->write("head", 1, 4));
+    TEST_ASSERT_EQUAL(0, f->seek(3 * FILEMEM_PAGE_SIZE + 5, SEEK_SET));
+    TEST_ASSERT_EQUAL(4, f->write("tail", 1, 4));
+    TEST_ASSERT_EQUAL(3 * FILEMEM_PAGE_SIZE + 9, f->size());
+
+    TEST_ASSERT_EQUAL(0, f->seek(FILEMEM_PAGE_SIZE + 7, SEEK_SET));
+    TEST_ASSERT_EQUAL(16, f->read(buf, 1, 16));
+    for (int i = 0; i < 16; i++)
+        TEST_ASSERT_EQUAL_UINT8(0, buf[i]);
+
+    TEST_ASSERT_EQUAL(0, f->seek(-4, SEEK_END));
+    TEST_ASSERT_EQUAL(4, f->read(buf, 1, 4));
+    TEST_ASSERT_EQUAL_MEMORY("tail", buf, 4);
+    TEST_ASSERT_EQUAL(0, f->seek(0, SEEK_END));
+    TEST_ASSERT_EQUAL(f->size(), f->tell());
+    TEST_ASSERT_EQUAL(-1, f->seek(-1, SEEK_SET));
+
+    // cut back into the first page, what was cut must read as zeros later
+    TEST_ASSERT_EQUAL(0, f->grow(2));
+    TEST_ASSERT_EQUAL(0, f->seek(FILEMEM_PAGE_SIZE, SEEK_SET));
+    TEST_ASSERT_EQUAL(0, f->seek(0, SEEK_SET));
+    TEST_ASSERT_EQUAL(4, f->read(buf, 1, 4));
+    TEST_ASSERT_EQUAL_MEMORY("he\0\0", buf, 4);
+
+    TEST_ASSERT_EQUAL(-1, f->grow(FILEMEM_MAXSIZE + 1));
+    f->close();
+}
+
+/**
+ * Page views cover the file without crossing pages
+ */
+void tests_filemem_view()
+{
+    FileHandlerMem *f = new FileHandlerMem();
+    const uint8_t *p;
+    long total = 2 * FILEMEM_PAGE_SIZE + 300;
+    size_t n;
+
+    for (long i = 0; i < total; i++)
+    {
+        uint8_t b = pattern(i);
+        f->write(&b, 1, 1);
+    }
+
+    TEST_ASSERT_EQUAL(0, f->seek(100, SEEK_SET));
+    TEST_ASSERT_EQUAL(50, f->view(&p, 50));
+    TEST_ASSERT_EQUAL_UINT8(pattern(100), p[0]);
+    TEST_ASSERT_EQUAL(150, f->tell());
+
+    long pos = 150;
+    while ((n = f->view(&p, 100000)) > 0)
+    {
+        TEST_ASSERT_TRUE(pos / FILEMEM_PAGE_SIZE == (pos + (long)n - 1) / FILEMEM_PAGE_SIZE);
+        for (size_t i = 0; i < n; i++)
+            TEST_ASSERT_EQUAL_UINT8(pattern(pos + i), p[i]);
+        pos += n;
+    }
+    TEST_ASSERT_EQUAL(total, pos);
+
+    f->close();
+}
+
+/**
+ * Benchmark: 1 MB in 1 KB writes, as the FTP cache does, then read back
+ */
+void tests_filemem_1m_write()
+{
+    char msg[96];
+    uint8_t buf[1024];
+    FileHandlerMem *f = new FileHandlerMem();
+
+    uint64_t start = fnSystem.millis();
+    for (long pos = 0; pos < FILEMEM_MAXSIZE; pos += sizeof(buf))
+    {
+        for (size_t i = 0; i < sizeof(buf); i += 256)
+            buf[i] = pattern(pos + i);
+        TEST_ASSERT_EQUAL(sizeof(buf), f->write(buf, 1, sizeof(buf)));
+    }
+    uint64_t write_ms = fnSystem.millis() - start;
+    TEST_ASSERT_EQUAL(FILEMEM_MAXSIZE, f->size());
+    TEST_ASSERT_EQUAL(0, f->write(buf, 1, 1));
+
+    const uint8_t *p;
+    size_t n;
+    long pos = 0;
+    f->seek(0, SEEK_SET);
+    start = fnSystem.millis();
+    while ((n = f->view(&p, FILEMEM_PAGE_SIZE)) > 0)
+    {
+        for (size_t i = 0; i < n; i += 256)
+            TEST_ASSERT_EQUAL_UINT8(pattern(pos + i), p[i]);
+        pos += n;
+    }
+    uint64_t read_ms = fnSystem.millis() - start;
+    TEST_ASSERT_EQUAL(FILEMEM_MAXSIZE, pos);
+
+    f->close();
+
+    snprintf(msg, sizeof(msg), "1 MB memory file: write %u ms, view %u ms",
+             (unsigned)write_ms, (unsigned)read_ms);
+    TEST_MESSAGE(msg);
+}
@@ -0,0 +1,45 @@
+/**
+ * #FujiNet Tests - Paged memory file
+ *
+ * FileHandlerMem as FileSystemFTP::cache_file() uses it. Also built for the
+ * host, see test/main_host.cpp.
+ */
+
+#ifndef TEST_FILEMEM_H
+#define TEST_FILEMEM_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_filemem();
+
+    /**
+     * Writes and reads which straddle pages come back intact
+     */
+    void tests_filemem_round_trip();
+
+    /**
+     * Seeking past the end leaves a hole of zeros, SEEK_END counts from the end
+     */
+    void tests_filemem_seek_hole();
+
+    /**
+     * Page views cover the file without crossing pages
+     */
+    void tests_filemem_view();
+
+    /**
+     * Benchmark: 1 MB in 1 KB writes, as the FTP cache does, then read back
+     */
+    void tests_filemem_1m_write();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_FILEMEM_H */
@@ -0,0 +1,480 @@
+/**
+ * #FujiNet Tests - Ranged FTP file access
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../lib/FileSystem/fnFileFTP.h"
+#include "../lib/FileSystem/fnFileMem.h"
+#include "../lib/ftp/fnFTP.h"
+#include "../lib/tcpip/fnTcpServer.h"
+#include "../lib/hardware/fnSystem.h"
+#include "test_ftp_file.h"
+#include "test_unity.h"
+
+#define STANDIN_CONTROL_PORT 21210
+#define STANDIN_DATA_PORT 21211
+#define TEST_IMAGE_SIZE (256 * 1024)
+#define TEST_IMAGE "/test.atr"
+#define TEST_SECTOR 128
+
+static uint8_t pattern(long pos)
+{
+    return (uint8_t)(pos * 7 + (pos >> 8) * 3);
+}
+
+/*
+ * Just enough of an FTP server: one client, EPSV only, one image in memory.
+ * Handles one command at a time, like the real thing it watches the
+ * control connection for ABOR between pieces of a RETR.
+ */
+class ftp_standin
+{
+public:
+    std::vector<uint8_t> image;
+    std::atomic<int> retr_count{0};
+    std::atomic<int> stor_count{0};
+    std::atomic<int> appe_count{0};
+    std::atomic<long> last_rest{0};
+
+    bool start()
+    {
+        if (!_control_server.begin() || !_data_server.begin())
+            return false;
+        _control_server.setNoDelay(true);
+        _data_server.setNoDelay(true);
+        _running = true;
+        _thread = std::thread(&ftp_standin::run, this);
+        return true;
+    }
+
+private:
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    fnTcpServer _control_server{STANDIN_CONTROL_PORT, 1};
+    fnTcpServer _data_server{STANDIN_DATA_PORT, 1};
+    fnTcpClient _control;
+    fnTcpClient _data;
+    std::string _partial;
+    long _rest = 0;
+
+    void reply(const std::string &line)
+    {
+        _control.write(line + "\r\n");
+    }
+
+    bool read_line(std::string &line)
+    {
+        while (_running && _control.connected())
+        {
+            if (_control.available() == 0)
+            {
+                fnSystem.delay(10);
+                continue;
+            }
+            int c = _control.read();
+            if (c < 0)
+                return false;
+            if (c == '\n')
+            {
+                line = _partial;
+                _partial.clear();
+                return true;
+            }
+            if (c != '\r')
+                _partial += (char)c;
+        }
+        return false;
+    }
+
+    void accept_data()
+    {
+        for (int i = 0; i < 500 && !_data_server.hasClient(); i++)
+            fnSystem.delay(10);
+        _data = _data_server.available();
+    }
+
+    void send_file()
+    {
+        long pos = _rest;
+        bool aborted = false;
+        bool broken = false;
+
+        _rest = 0;
+        if (!_data.connected())
+        {
+            reply("425 No data connection");
+            return;
+        }
+        retr_count++;
+        reply("150 Opening BINARY mode data connection");
+
+        while (pos < (long)image.size())
+        {
+            if (_control.available())
+            {
+                std::string line;
+                if (read_line(line) && line.compare(0, 4, "ABOR") == 0)
+                {
+                    aborted = true;
+                    break;
+                }
+            }
+            size_t n = image.size() - pos > 1024 ? 1024 : image.size() - pos;
+            if (_data.write(&image[pos], n) != n)
+            {
+                broken = true;
+                break;
+            }
+            pos += n;
+        }
+        _data.stop();
+
+        if (aborted)
+        {
+            reply("426 Transfer aborted");
+            reply("226 Abort successful");
+        }
+        else if (broken)
+            reply("426 Connection closed; transfer aborted");
+        else
+            reply("226 Transfer complete");
+    }
+
+    void receive_file(bool append)
+    {
+        uint8_t buf[512];
+        long pos = append ? image.size() : _rest;
+
+        if (!_data.connected())
+        {
+            reply("425 No data connection");
+            return;
+        }
+        if (append)
+            appe_count++;
+        else
+        {
+            stor_count++;
+            // a plain STOR replaces the file, a restarted one writes into it
+            if (_rest == 0)
+                image.clear();
+        }
+        _rest = 0;
+        reply("150 Ok to send data");
+
+        while (true)
+        {
+            int available = _data.available();
+            if (available <= 0)
+            {
+                if (!_data.connected())
+                    break;
+                fnSystem.delay(10);
+                continue;
+            }
+            int n = _data.read(buf, available > (int)sizeof(buf) ? sizeof(buf) : available);
+            if (n <= 0)
+                break;
+            if (pos + n > (long)image.size())
+                image.resize(pos + n);
+            memcpy(&image[pos], buf, n);
+            pos += n;
+        }
+        _data.stop();
+        reply("226 Transfer complete");
+    }
+
+    void run()
+    {
+        std::string line;
+        char msg[64];
+
+        while (_running)
+        {
+            if (!_control.connected())
+            {
+                if (!_control_server.hasClient())
+                {
+                    fnSystem.delay(10);
+                    continue;
+                }
+                _control = _control_server.available();
+                reply("220 FujiNet test stand-in");
+            }
+
+            if (!read_line(line))
+                continue;
+
+            std::string cmd = line.substr(0, 4);
+            std::string arg = line.size() > 5 ? line.substr(5) : "";
+
+            if (cmd == "USER")
+                reply("331 Password required");
+            else if (cmd == "PASS")
+                reply("230 Logged in");
+            else if (cmd == "TYPE")
+                reply("200 Type set to I");
+            else if (cmd == "EPSV")
+            {
+                snprintf(msg, sizeof(msg), "229 Entering Extended Passive Mode (|||%d|)", STANDIN_DATA_PORT);
+                reply(msg);
+                accept_data();
+            }
+            else if (cmd == "SIZE")
+            {
+                snprintf(msg, sizeof(msg), "213 %lu", (unsigned long)image.size());
+                reply(msg);
+            }
+            else if (cmd == "REST")
+            {
+                _rest = atol(arg.c_str());
+                last_rest = _rest;
+                reply("350 Restart position accepted");
+            }
+            else if (cmd == "RETR")
+                send_file();
+            else if (cmd == "STOR")
+                receive_file(false);
+            else if (cmd == "APPE")
+                receive_file(true);
+            else if (cmd == "ABOR")
+                reply("225 No transfer to abort");
+            else if (cmd == "QUIT")
+            {
+                reply("221 Goodbye");
+                _control.stop();
+            }
+            else
+                reply("502 Command not implemented");
+        }
+    }
+};
+
+static ftp_standin *standin = nullptr;
+static fnFTP *ftp = nullptr;
+
+static bool standin_ready()
+{
+    if (standin == nullptr)
+    {
+        standin = new ftp_standin();
+        if (!standin->start())
+            return false;
+    }
+
+    standin->image.resize(TEST_IMAGE_SIZE);
+    for (long i = 0; i < TEST_IMAGE_SIZE; i++)
+        standin->image[i] = pattern(i);
+
+    if (ftp == nullptr)
+    {
+        ftp = new fnFTP();
+        if (ftp->login("fujinet", "test", "127.0.0.1", STANDIN_CONTROL_PORT))
+        {
+            delete ftp;
+            ftp = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_sector(const uint8_t *buf, long pos)
+{
+    for (int i = 0; i < TEST_SECTOR; i++)
+        if (buf[i] != pattern(pos + i))
+            return false;
+    return true;
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_ftp_file()
+{
+    RUN_TEST(tests_ftp_file_first_sector);
+    RUN_TEST(tests_ftp_file_sequential);
+    RUN_TEST(tests_ftp_file_random);
+    RUN_TEST(tests_ftp_file_write_back);
+}
+
+/**
+ * Benchmark: first sector from the middle of the image, against taking the whole file
+ */
+void tests_ftp_file_first_sector()
+{
+    char msg[96];
+    uint8_t buf[1024];
+    long size = 0;
+    long pos = TEST_IMAGE_SIZE / 2 + 3 * TEST_SECTOR;
+
+    if (!standin_ready())
+        TEST_IGNORE_MESSAGE("FTP stand-in did not start");
+
+    int retr = standin->retr_count;
+    uint64_t start = fnSystem.millis();
+    TEST_ASSERT_FALSE(ftp->get_size(TEST_IMAGE, size));
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE, size);
+    FileHandler *fh = new FileHandlerFTP(ftp, TEST_IMAGE, size, false);
+    TEST_ASSERT_EQUAL(0, fh->seek(pos, SEEK_SET));
+    TEST_ASSERT_EQUAL(TEST_SECTOR, fh->read(buf, 1, TEST_SECTOR));
+    uint64_t ranged_ms = fnSystem.millis() - start;
+
+    TEST_ASSERT_TRUE(check_sector(buf, pos));
+    TEST_ASSERT_EQUAL(retr + 1, standin->retr_count);
+    TEST_ASSERT_EQUAL(pos - pos % FTPFILE_BLOCK_SIZE, standin->last_rest);
+    TEST_ASSERT_EQUAL(0, fh->close());
+
+    // what cache_file() does before the first sector can be had
+    start = fnSystem.millis();
+    FileHandlerMem *mem = new FileHandlerMem();
+    TEST_ASSERT_FALSE(ftp->open_file(TEST_IMAGE, false));
+    while (ftp->data_connected() || ftp->data_available() > 0)
+    {
+        int available = ftp->data_available();
+        if (available == 0)
+        {
+            fnSystem.delay(10);
+            continue;
+        }
+        int n = available > (int)sizeof(buf) ? sizeof(buf) : available;
+        TEST_ASSERT_FALSE(ftp->read_file(buf, n));
+        mem->write(buf, 1, n);
+    }
+    ftp->close();
+    mem->seek(pos, SEEK_SET);
+    mem->read(buf, 1, TEST_SECTOR);
+    uint64_t whole_ms = fnSystem.millis() - start;
+
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE, mem->size());
+    TEST_ASSERT_TRUE(check_sector(buf, pos));
+    mem->close();
+
+    snprintf(msg, sizeof(msg), "%d KB image, first sector: ranged %u ms, whole file %u ms",
+             TEST_IMAGE_SIZE / 1024, (unsigned)ranged_ms, (unsigned)whole_ms);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * Reading the image in order runs down a single transfer
+ */
+void tests_ftp_file_sequential()
+{
+    char msg[96];
+    uint8_t buf[TEST_SECTOR];
+
+    if (!standin_ready())
+        TEST_IGNORE_MESSAGE("FTP stand-in did not start");
+
+    int retr = standin->retr_count;
+    FileHandler *fh = new FileHandlerFTP(ftp, TEST_IMAGE, TEST_IMAGE_SIZE, false);
+
+    uint64_t start = fnSystem.millis();
+    for (long pos = 0; pos < TEST_IMAGE_SIZE; pos += TEST_SECTOR)
+    {
+        TEST_ASSERT_EQUAL(TEST_SECTOR, fh->read(buf, 1, TEST_SECTOR));
+        TEST_ASSERT_TRUE(check_sector(buf, pos));
+    }
+    uint64_t elapsed = fnSystem.millis() - start;
+
+    TEST_ASSERT_EQUAL(0, fh->read(buf, 1, TEST_SECTOR));
+    TEST_ASSERT_EQUAL(retr + 1, standin->retr_count);
+    TEST_ASSERT_EQUAL(0, fh->close());
+
+    snprintf(msg, sizeof(msg), "%d sectors in order: %u ms, one RETR",
+             TEST_IMAGE_SIZE / TEST_SECTOR, (unsigned)elapsed);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * Scattered sector reads return the right data
+ */
+void tests_ftp_file_random()
+{
+    char msg[96];
+    uint8_t buf[TEST_SECTOR];
+    uint32_t seed = 12345;
+
+    if (!standin_ready())
+        TEST_IGNORE_MESSAGE("FTP stand-in did not start");
+
+    int retr = standin->retr_count;
+    FileHandler *fh = new FileHandlerFTP(ftp, TEST_IMAGE, TEST_IMAGE_SIZE, false);
+
+    uint64_t start = fnSystem.millis();
+    for (int i = 0; i < 100; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        long pos = (long)((seed >> 8) % (TEST_IMAGE_SIZE / TEST_SECTOR)) * TEST_SECTOR;
+        TEST_ASSERT_EQUAL(0, fh->seek(pos, SEEK_SET));
+        TEST_ASSERT_EQUAL(TEST_SECTOR, fh->read(buf, 1, TEST_SECTOR));
+        TEST_ASSERT_TRUE(check_sector(buf, pos));
+    }
+    uint64_t elapsed = fnSystem.millis() - start;
+    TEST_ASSERT_EQUAL(0, fh->close());
+
+    snprintf(msg, sizeof(msg), "100 scattered sectors: %u ms, %d RETR",
+             (unsigned)elapsed, (int)standin->retr_count - retr);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * Writes go back with REST + STOR in place and APPE at the end
+ */
+void tests_ftp_file_write_back()
+{
+    uint8_t buf[FTPFILE_BLOCK_SIZE];
+
+    if (!standin_ready())
+        TEST_IGNORE_MESSAGE("FTP stand-in did not start");
+
+    int stor = standin->stor_count;
+    int appe = standin->appe_count;
+    FileHandler *fh = new FileHandlerFTP(ftp, TEST_IMAGE, TEST_IMAGE_SIZE, true);
+
+    // part of a block, a whole block, and past the end
+    memset(buf, 0x5A, sizeof(buf));
+    TEST_ASSERT_EQUAL(0, fh->seek(10000, SEEK_SET));
+    TEST_ASSERT_EQUAL(300, fh->write(buf, 1, 300));
+    TEST_ASSERT_EQUAL(0, fh->seek(5 * FTPFILE_BLOCK_SIZE, SEEK_SET));
+    TEST_ASSERT_EQUAL(1, fh->write(buf, sizeof(buf), 1));
+    TEST_ASSERT_EQUAL(0, fh->seek(0, SEEK_END));
+    TEST_ASSERT_EQUAL(1000, fh->write(buf, 1, 1000));
+
+    // nothing reaches the server before a flush
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE, standin->image.size());
+    TEST_ASSERT_EQUAL(0, fh->flush());
+
+    TEST_ASSERT_EQUAL(stor + 2, standin->stor_count);
+    TEST_ASSERT_EQUAL(appe + 1, standin->appe_count);
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE + 1000, standin->image.size());
+    TEST_ASSERT_EQUAL_UINT8(pattern(9999), standin->image[9999]);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, standin->image[10000]);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, standin->image[10299]);
+    TEST_ASSERT_EQUAL_UINT8(pattern(10300), standin->image[10300]);
+    TEST_ASSERT_EQUAL_UINT8(pattern(5 * FTPFILE_BLOCK_SIZE - 1), standin->image[5 * FTPFILE_BLOCK_SIZE - 1]);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, standin->image[6 * FTPFILE_BLOCK_SIZE - 1]);
+    TEST_ASSERT_EQUAL_UINT8(pattern(6 * FTPFILE_BLOCK_SIZE), standin->image[6 * FTPFILE_BLOCK_SIZE]);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, standin->image[TEST_IMAGE_SIZE + 999]);
+
+    // reading back comes from the cache and the server alike
+    TEST_ASSERT_EQUAL(0, fh->seek(9990, SEEK_SET));
+    TEST_ASSERT_EQUAL(20, fh->read(buf, 1, 20));
+    TEST_ASSERT_EQUAL_UINT8(pattern(9999), buf[9]);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, buf[10]);
+    TEST_ASSERT_EQUAL(0, fh->close());
+    TEST_ASSERT_EQUAL(stor + 2, standin->stor_count);
+
+    fh = new FileHandlerFTP(ftp, TEST_IMAGE, TEST_IMAGE_SIZE + 1000, false);
+    TEST_ASSERT_EQUAL(0, fh->seek(-1000, SEEK_END));
+    TEST_ASSERT_EQUAL(1000, fh->read(buf, 1, 2000));
+    TEST_ASSERT_EQUAL_UINT8(0x5A, buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, buf[999]);
+    TEST_ASSERT_EQUAL(0, fh->write(buf, 1, 1));
+    TEST_ASSERT_EQUAL(0, fh->close());
+}
@@ -0,0 +1,46 @@
+/**
+ * #FujiNet Tests - Ranged FTP file access
+ *
+ * Runs FileHandlerFTP against a small FTP server stand-in on the loopback
+ * interface, which serves one image from memory and counts the transfers
+ * it is asked for. Also built for the host, see test/main_host.cpp.
+ */
+
+#ifndef TEST_FTP_FILE_H
+#define TEST_FTP_FILE_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_ftp_file();
+
+    /**
+     * Benchmark: first sector from the middle of the image, against taking the whole file
+     */
+    void tests_ftp_file_first_sector();
+
+    /**
+     * Reading the image in order runs down a single transfer
+     */
+    void tests_ftp_file_sequential();
+
+    /**
+     * Scattered sector reads return the right data
+     */
+    void tests_ftp_file_random();
+
+    /**
+     * Writes go back with REST + STOR in place and APPE at the end
+     */
+    void tests_ftp_file_write_back();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_FTP_FILE_H */
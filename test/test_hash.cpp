@@ -0,0 +1,204 @@
+/**
+ * #FujiNet Tests - Incremental hashing
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+#include "../lib/encoding/hash.h"
+#include "test_hash.h"
+#include "test_unity.h"
+
+struct hash_vector
+{
+    Hash::Algorithm algorithm;
+    const char *empty;
+    const char *abc;
+    const char *million_a;
+};
+
+static const hash_vector vectors[] = {
+    {Hash::Algorithm::MD5,
+     "d41d8cd98f00b204e9800998ecf8427e",
+     "900150983cd24fb0d6963f7d28e17f72",
+     "7707d6ae4e027c70eea2a935c2296f21"},
+    {Hash::Algorithm::SHA1,
+     "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+     "a9993e364706816aba3e25717850c26c9cd0d89d",
+     "34aa973cd4c4daa4f61eeb2bdbad27316534016f"},
+    {Hash::Algorithm::SHA256,
+     "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+     "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+     "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+    {Hash::Algorithm::SHA512,
+     "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+     "47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e",
+     "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+     "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+     "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+     "de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b"},
+};
+
+/**
+ * Tests entrypoint
+ */
+void tests_hash()
+{
+    RUN_TEST(tests_hash_vectors);
+    RUN_TEST(tests_hash_million_a);
+    RUN_TEST(tests_hash_compute_keeps_data);
+    RUN_TEST(tests_hash_select);
+    RUN_TEST(tests_hash_clear_algorithms);
+    RUN_TEST(tests_hash_throughput);
+}
+
+/**
+ * Short vectors
+ */
+void tests_hash_vectors()
+{
+    Hash h;
+
+    for (const auto &v : vectors)
+    {
+        h.compute(v.algorithm, true);
+        TEST_ASSERT_EQUAL_STRING(v.empty, h.output_hex().c_str());
+        TEST_ASSERT_EQUAL(h.hash_length(v.algorithm, false), h.output_binary().size());
+
+        h.add_data(std::string("abc"));
+        h.compute(v.algorithm, true);
+        TEST_ASSERT_EQUAL_STRING(v.abc, h.output_hex().c_str());
+    }
+}
+
+/**
+ * The largest data frame the HASH INPUT command takes is 255 bytes
+ */
+void tests_hash_million_a()
+{
+    Hash h;
+    uint8_t chunk[255];
+    memset(chunk, 'a', sizeof(chunk));
+
+    for (size_t left = 1000000; left > 0;)
+    {
+        size_t n = left < sizeof(chunk) ? left : sizeof(chunk);
+        h.add_data(chunk, n);
+        left -= n;
+    }
+
+    for (const auto &v : vectors)
+    {
+        h.compute(v.algorithm, false);
+        TEST_ASSERT_EQUAL_STRING(v.million_a, h.output_hex().c_str());
+    }
+}
+
+/**
+ * compute(..., false) followed by more data
+ */
+void tests_hash_compute_keeps_data()
+{
+    Hash h;
+
+    h.add_data(std::string("a"));
+    h.compute(Hash::Algorithm::SHA256, false);
+    h.add_data(std::string("bc"));
+    h.compute(Hash::Algorithm::SHA256, true);
+    TEST_ASSERT_EQUAL_STRING(vectors[2].abc, h.output_hex().c_str());
+}
+
+/**
+ * select() as HASH HOST FILE uses it
+ */
+void tests_hash_select()
+{
+    Hash h;
+
+    for (const auto &v : vectors)
+    {
+        h.select(v.algorithm);
+        h.add_data(std::string("abc"));
+        for (const auto &other : vectors)
+        {
+            h.compute(other.algorithm, false);
+            if (other.algorithm == v.algorithm)
+                TEST_ASSERT_EQUAL_STRING(v.abc, h.output_hex().c_str());
+            else
+                TEST_ASSERT_EQUAL(0, h.output_binary().size());
+        }
+        // clear() brings all four back
+        h.compute(v.algorithm, true);
+        h.add_data(std::string("abc"));
+        h.compute(vectors[0].algorithm, true);
+        TEST_ASSERT_EQUAL_STRING(vectors[0].abc, h.output_hex().c_str());
+    }
+}
+
+/**
+ * clear() with the algorithms a HASH CLEAR asked for
+ */
+void tests_hash_clear_algorithms()
+{
+    Hash h;
+
+    h.clear(Hash::algorithm_bit(Hash::Algorithm::MD5) | Hash::algorithm_bit(Hash::Algorithm::SHA256));
+    for (int pass = 0; pass < 2; pass++)
+    {
+        // computing with clear_data keeps the same set
+        h.add_data(std::string("abc"));
+        for (const auto &v : vectors)
+        {
+            h.compute(v.algorithm, false);
+            if (v.algorithm == Hash::Algorithm::MD5 || v.algorithm == Hash::Algorithm::SHA256)
+                TEST_ASSERT_EQUAL_STRING(v.abc, h.output_hex().c_str());
+            else
+                TEST_ASSERT_EQUAL(0, h.output_binary().size());
+        }
+        h.compute(Hash::Algorithm::MD5, true);
+    }
+
+    // 0 brings all four back
+    h.clear(0);
+    h.add_data(std::string("abc"));
+    for (const auto &v : vectors)
+    {
+        h.compute(v.algorithm, false);
+        TEST_ASSERT_EQUAL_STRING(v.abc, h.output_hex().c_str());
+    }
+}
+
+static unsigned hash_megabyte(uint8_t algorithms)
+{
+    static uint8_t chunk[4096];
+    Hash h;
+
+    for (size_t i = 0; i < sizeof(chunk); i++)
+        chunk[i] = (uint8_t)i;
+
+    auto start = std::chrono::steady_clock::now();
+    h.clear(algorithms);
+    for (int i = 0; i < 256; i++)
+        h.add_data(chunk, sizeof(chunk));
+    h.compute(Hash::Algorithm::SHA256, true);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    TEST_ASSERT_EQUAL(32, h.output_binary().size());
+    return (unsigned)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+/**
+ * Benchmark: what hashing a 1 MB host file costs
+ */
+void tests_hash_throughput()
+{
+    char msg[80];
+
+    snprintf(msg, sizeof(msg), "1 MB through MD5+SHA1+SHA256+SHA512 in %u ms",
+             hash_megabyte(Hash::ALL_ALGORITHMS));
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "1 MB through SHA256 alone in %u ms",
+             hash_megabyte(Hash::algorithm_bit(Hash::Algorithm::SHA256)));
+    TEST_MESSAGE(msg);
+}
@@ -0,0 +1,57 @@
+/**
+ * #FujiNet Tests - Incremental hashing
+ *
+ * Checks the running digests against the standard test vectors and times
+ * a large input fed in SIO sized pieces. Also built for the host, see
+ * test/main_host.cpp.
+ */
+
+#ifndef TEST_HASH_H
+#define TEST_HASH_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_hash();
+
+    /**
+     * "" and "abc" for every algorithm, fed in one piece
+     */
+    void tests_hash_vectors();
+
+    /**
+     * One million 'a', fed 255 bytes at a time
+     */
+    void tests_hash_million_a();
+
+    /**
+     * Computing without clearing leaves the running digests usable
+     */
+    void tests_hash_compute_keeps_data();
+
+    /**
+     * After select() only that algorithm gives a digest, until clear()
+     */
+    void tests_hash_select();
+
+    /**
+     * After clear(algorithms) only those give a digest, until clear(0)
+     */
+    void tests_hash_clear_algorithms();
+
+    /**
+     * Benchmark: 1 MB in 4 KB pieces, through all four digests and
+     * through the one a client asks for
+     */
+    void tests_hash_throughput();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_HASH_H */
@@ -0,0 +1,169 @@
+/**
+ * #FujiNet Tests - Host to host copy
+ *
+ * The source is created on the first run and left on the card.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "../lib/fuji/fujiHostCopy.h"
+#include "../lib/task/fnTaskManager.h"
+#include "../lib/hardware/fnSystem.h"
+#include "fnFsSD.h"
+#include "test_hostcopy.h"
+#include "test_unity.h"
+
+#define COPY_BYTES (1024 * 1024)
+
+static fujiHost sd_host;
+
+static uint8_t pattern(uint32_t pos)
+{
+    return (uint8_t)((pos * 2654435761u) >> 24);
+}
+
+static bool source_ready()
+{
+    char path[96];
+    struct stat sb;
+
+    if (!fnSDFAT.running())
+        return false;
+
+    sd_host.set_hostname("SD");
+
+    snprintf(path, sizeof(path), "%s/COPYBNCH", fnSDFAT.basepath());
+    mkdir(path, 0777);
+    snprintf(path, sizeof(path), "%s/COPYBNCH/SRC.BIN", fnSDFAT.basepath());
+    if (stat(path, &sb) == 0 && sb.st_size == COPY_BYTES)
+        return true;
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return false;
+    uint8_t buf[1024];
+    for (uint32_t pos = 0; pos < COPY_BYTES; pos += sizeof(buf))
+    {
+        for (size_t i = 0; i < sizeof(buf); i++)
+            buf[i] = pattern(pos + i);
+        fwrite(buf, 1, sizeof(buf), f);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool destination_matches()
+{
+    char path[96];
+    uint8_t buf[1024];
+    uint32_t pos = 0;
+    bool same = true;
+
+    snprintf(path, sizeof(path), "%s/COPYBNCH/DST.BIN", fnSDFAT.basepath());
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return false;
+
+    size_t n;
+    while (same && (n = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+            same = same && buf[i] == pattern(pos + i);
+        pos += n;
+    }
+    fclose(f);
+    return same && pos == COPY_BYTES;
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_hostcopy()
+{
+    RUN_TEST(tests_hostcopy_full);
+    RUN_TEST(tests_hostcopy_cancel_resume);
+    RUN_TEST(tests_hostcopy_step_time);
+}
+
+/**
+ * Benchmark: whole copy through the task
+ */
+void tests_hostcopy_full()
+{
+    char msg[80];
+
+    if (!source_ready())
+        TEST_IGNORE_MESSAGE("no SD card");
+
+    uint64_t start = fnSystem.millis();
+    TEST_ASSERT_TRUE(hostCopy.start(&sd_host, "/COPYBNCH/SRC.BIN", &sd_host, "/COPYBNCH/DST.BIN"));
+    TEST_ASSERT_TRUE(hostCopy.wait());
+    uint64_t elapsed = fnSystem.millis() - start;
+
+    TEST_ASSERT_EQUAL(COPY_BYTES, hostCopy.copied());
+    TEST_ASSERT_EQUAL(100, hostCopy.percent());
+    TEST_ASSERT_TRUE(destination_matches());
+
+    snprintf(msg, sizeof(msg), "1 MB SD to SD in %u ms, %u KB/s",
+             (unsigned)elapsed, (unsigned)hostCopy.rate_kbs());
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * Cancel after a quarter, resume from where it stopped
+ */
+void tests_hostcopy_cancel_resume()
+{
+    if (!source_ready())
+        TEST_IGNORE_MESSAGE("no SD card");
+
+    TEST_ASSERT_TRUE(hostCopy.start(&sd_host, "/COPYBNCH/SRC.BIN", &sd_host, "/COPYBNCH/DST.BIN"));
+    while (hostCopy.copied() < COPY_BYTES / 4)
+        taskMgr.service();
+
+    hostCopy.cancel();
+    taskMgr.service();
+    TEST_ASSERT_EQUAL(fujiHostCopy::COPY_CANCELLED, hostCopy.state());
+
+    uint32_t stopped_at = hostCopy.copied();
+    TEST_ASSERT_TRUE(stopped_at < COPY_BYTES);
+
+    /* the task stays around to be resumed */
+    for (int i = 0; i < 10; i++)
+        taskMgr.service();
+    TEST_ASSERT_EQUAL(stopped_at, hostCopy.copied());
+
+    hostCopy.resume();
+    taskMgr.service();
+    TEST_ASSERT_EQUAL(fujiHostCopy::COPY_RUNNING, hostCopy.state());
+    TEST_ASSERT_TRUE(hostCopy.wait());
+    TEST_ASSERT_TRUE(destination_matches());
+}
+
+/**
+ * The longest single step, which is how long the bus may go unserviced
+ */
+void tests_hostcopy_step_time()
+{
+    char msg[80];
+    uint64_t worst = 0;
+
+    if (!source_ready())
+        TEST_IGNORE_MESSAGE("no SD card");
+
+    TEST_ASSERT_TRUE(hostCopy.start(&sd_host, "/COPYBNCH/SRC.BIN", &sd_host, "/COPYBNCH/DST.BIN"));
+    while (hostCopy.state() == fujiHostCopy::COPY_RUNNING)
+    {
+        uint64_t start = fnSystem.millis();
+        taskMgr.service();
+        uint64_t took = fnSystem.millis() - start;
+        if (took > worst)
+            worst = took;
+    }
+    TEST_ASSERT_EQUAL(fujiHostCopy::COPY_DONE, hostCopy.state());
+
+    snprintf(msg, sizeof(msg), "longest step %u ms", (unsigned)worst);
+    TEST_MESSAGE(msg);
+}
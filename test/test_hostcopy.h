@@ -0,0 +1,39 @@
+/**
+ * #FujiNet Tests - Host to host copy
+ *
+ * Copies a 1 MB file between folders on the SD card through the copy task.
+ */
+
+#ifndef TEST_HOSTCOPY_H
+#define TEST_HOSTCOPY_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_hostcopy();
+
+    /**
+     * Benchmark: copy the whole file, check every byte and the rate
+     */
+    void tests_hostcopy_full();
+
+    /**
+     * Cancel part way, resume, and end up with the same file
+     */
+    void tests_hostcopy_cancel_resume();
+
+    /**
+     * Task steps stay short enough for the bus to keep up
+     */
+    void tests_hostcopy_step_time();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_HOSTCOPY_H */
@@ -0,0 +1,159 @@
+/**
+ * #FujiNet Tests - Macintosh 400K/800K GCR tracks
+ */
+
+#include <string.h>
+#include "../lib/media/mac/macGCR.h"
+#include "test_macgcr.h"
+
+#define TRACK_DATA_SIZE (MAC_GCR_MAX_SECTORS * MAC_GCR_SECTOR_SIZE)
+
+static uint8_t track_data[TRACK_DATA_SIZE];
+static uint8_t decoded[TRACK_DATA_SIZE];
+static uint8_t bits[MAC_GCR_MAX_TRACK_BYTES];
+static uint8_t rotated[MAC_GCR_MAX_TRACK_BYTES];
+
+static void fill_track(int cylinder, int side)
+{
+    for (int i = 0; i < TRACK_DATA_SIZE; i++)
+        track_data[i] = (uint8_t)(i * 29 + (i >> 9) * 5 + cylinder * 11 + side * 101);
+}
+
+static bool get_bit(const uint8_t *b, uint32_t pos)
+{
+    return (b[pos >> 3] >> (7 - (pos & 7))) & 1;
+}
+
+static void set_bit(uint8_t *b, uint32_t pos, bool v)
+{
+    if (v)
+        b[pos >> 3] |= 0x80 >> (pos & 7);
+    else
+        b[pos >> 3] &= ~(0x80 >> (pos & 7));
+}
+
+static uint16_t all_sectors(int cylinder)
+{
+    return (1 << mac_gcr_sectors(cylinder)) - 1;
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_macgcr()
+{
+    RUN_TEST(tests_macgcr_geometry);
+    RUN_TEST(tests_macgcr_round_trip);
+    RUN_TEST(tests_macgcr_rotated);
+    RUN_TEST(tests_macgcr_damaged);
+}
+
+/**
+ * Zone sizes, speeds and where each track starts in the image
+ */
+void tests_macgcr_geometry()
+{
+    TEST_ASSERT_EQUAL_INT(12, mac_gcr_sectors(0));
+    TEST_ASSERT_EQUAL_INT(12, mac_gcr_sectors(15));
+    TEST_ASSERT_EQUAL_INT(11, mac_gcr_sectors(16));
+    TEST_ASSERT_EQUAL_INT(8, mac_gcr_sectors(79));
+    TEST_ASSERT_EQUAL_UINT32(MAC_GCR_MAX_TRACK_BITS, mac_gcr_track_bits(0));
+    TEST_ASSERT_TRUE(mac_gcr_track_bits(79) < mac_gcr_track_bits(64 - 1));
+
+    // every block once, on one side and on two
+    TEST_ASSERT_EQUAL_UINT32(0, mac_gcr_first_block(0, 0, 2));
+    TEST_ASSERT_EQUAL_UINT32(12, mac_gcr_first_block(0, 1, 2));
+    TEST_ASSERT_EQUAL_UINT32(24, mac_gcr_first_block(1, 0, 2));
+    TEST_ASSERT_EQUAL_UINT32(MAC_GCR_800K / MAC_GCR_SECTOR_SIZE,
+                             mac_gcr_first_block(79, 1, 2) + mac_gcr_sectors(79));
+    TEST_ASSERT_EQUAL_UINT32(MAC_GCR_400K / MAC_GCR_SECTOR_SIZE,
+                             mac_gcr_first_block(79, 0, 1) + mac_gcr_sectors(79));
+}
+
+/**
+ * Every track on both sides comes back as it went in
+ */
+void tests_macgcr_round_trip()
+{
+    for (int side = 0; side < 2; side++)
+    {
+        for (int cylinder = 0; cylinder < MAC_GCR_CYLINDERS; cylinder++)
+        {
+            fill_track(cylinder, side);
+            memset(bits, 0, sizeof(bits));
+            uint32_t num_bits = mac_gcr_encode_track(bits, track_data, cylinder, side, 2);
+            TEST_ASSERT_EQUAL_UINT32(mac_gcr_encoded_bits(cylinder), num_bits);
+            TEST_ASSERT_TRUE(num_bits <= mac_gcr_track_bits(cylinder));
+            // the gaps take up all but a sync's worth of each sector
+            TEST_ASSERT_TRUE(num_bits + mac_gcr_sectors(cylinder) * 10 > mac_gcr_track_bits(cylinder));
+
+            memset(decoded, 0, sizeof(decoded));
+            TEST_ASSERT_EQUAL_HEX16(all_sectors(cylinder), mac_gcr_decode_track(decoded, bits, num_bits, cylinder, side));
+            TEST_ASSERT_EQUAL_MEMORY(track_data, decoded, mac_gcr_sectors(cylinder) * MAC_GCR_SECTOR_SIZE);
+        }
+    }
+
+    // the first address field, after 64 syncs of 10 bits: sector 0 of
+    // cylinder 0 side 1, two sided, as 0x96 0x96 0xd6 0xd9 and the checksum
+    fill_track(0, 1);
+    mac_gcr_encode_track(bits, track_data, 0, 1, 2);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, bits[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xD5, bits[80]);
+    TEST_ASSERT_EQUAL_HEX8(0xAA, bits[81]);
+    TEST_ASSERT_EQUAL_HEX8(0x96, bits[82]);
+    TEST_ASSERT_EQUAL_HEX8(0x96, bits[83]);
+    TEST_ASSERT_EQUAL_HEX8(0x96, bits[84]);
+    TEST_ASSERT_EQUAL_HEX8(0xD6, bits[85]);
+    TEST_ASSERT_EQUAL_HEX8(0xD9, bits[86]);
+}
+
+/**
+ * A stream starting part way round the track, as a write would
+ */
+void tests_macgcr_rotated()
+{
+    const int cylinder = 40;
+    fill_track(cylinder, 0);
+    uint32_t num_bits = mac_gcr_encode_track(bits, track_data, cylinder, 0, 1);
+
+    // odd offsets split nibbles across bytes, and a sector across the end
+    const uint32_t offsets[] = {1, 5000, 33333, num_bits - 9};
+    for (uint32_t offset : offsets)
+    {
+        memset(rotated, 0, sizeof(rotated));
+        for (uint32_t i = 0; i < num_bits; i++)
+            set_bit(rotated, i, get_bit(bits, (i + offset) % num_bits));
+
+        memset(decoded, 0, sizeof(decoded));
+        TEST_ASSERT_EQUAL_HEX16(all_sectors(cylinder), mac_gcr_decode_track(decoded, rotated, num_bits, cylinder, 0));
+        TEST_ASSERT_EQUAL_MEMORY(track_data, decoded, mac_gcr_sectors(cylinder) * MAC_GCR_SECTOR_SIZE);
+    }
+}
+
+/**
+ * Damaged sectors and other tracks are left out
+ */
+void tests_macgcr_damaged()
+{
+    const int cylinder = 70;
+    fill_track(cylinder, 1);
+    uint32_t num_bits = mac_gcr_encode_track(bits, track_data, cylinder, 1, 2);
+
+    // not the track or side asked for
+    TEST_ASSERT_EQUAL_HEX16(0, mac_gcr_decode_track(decoded, bits, num_bits, cylinder - 1, 1));
+    TEST_ASSERT_EQUAL_HEX16(0, mac_gcr_decode_track(decoded, bits, num_bits, cylinder, 0));
+    TEST_ASSERT_EQUAL_HEX16(0, mac_gcr_decode_track(decoded, bits, 0, cylinder, 1));
+
+    // a byte in the middle of the first sector's data field, sector 0: 64
+    // syncs, an address field, 6 syncs, the data prologue and sector number,
+    // then 300 nibbles in
+    uint32_t pos = 64 * 10 + 10 * 8 + 6 * 10 + 4 * 8 + 300 * 8;
+    for (int i = 2; i < 8; i++)
+        set_bit(bits, pos + i, !get_bit(bits, pos + i));
+
+    memset(decoded, 0, sizeof(decoded));
+    uint16_t found = mac_gcr_decode_track(decoded, bits, num_bits, cylinder, 1);
+    TEST_ASSERT_EQUAL_HEX16(all_sectors(cylinder) & ~1, found);
+    for (int s = 1; s < mac_gcr_sectors(cylinder); s++)
+        TEST_ASSERT_EQUAL_MEMORY(&track_data[s * MAC_GCR_SECTOR_SIZE], &decoded[s * MAC_GCR_SECTOR_SIZE], MAC_GCR_SECTOR_SIZE);
+}
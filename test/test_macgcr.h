@@ -0,0 +1,45 @@
+/**
+ * #FujiNet Tests - Macintosh 400K/800K GCR tracks
+ *
+ * Sector images made into Sony GCR bitstreams and read back: every zone and
+ * side, from anywhere on the track, and with damage. Also built for the host.
+ */
+
+#ifndef TEST_MACGCR_H
+#define TEST_MACGCR_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_macgcr();
+
+    /**
+     * Zone sizes, speeds and where each track starts in the image
+     */
+    void tests_macgcr_geometry();
+
+    /**
+     * Every track on both sides comes back as it went in
+     */
+    void tests_macgcr_round_trip();
+
+    /**
+     * A stream starting part way round the track, as a write would
+     */
+    void tests_macgcr_rotated();
+
+    /**
+     * Damaged sectors and other tracks are left out
+     */
+    void tests_macgcr_damaged();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_MACGCR_H */
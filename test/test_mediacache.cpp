@@ -0,0 +1,331 @@
+/**
+ * #FujiNet Tests - Media block cache
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/media/mediaCache.h"
+#include "../lib/hardware/fnSystem.h"
+#include "test_mediacache.h"
+#include "test_unity.h"
+
+#ifndef FNIO_IS_STDIO
+
+#include "../lib/FileSystem/fnFileMem.h"
+
+// ATR layout, a 16 byte header then 128 byte sectors
+#define ATR_HEADER 16
+#define ATR_SECTOR 128
+#define ATR_SECTORS 720
+#define ATR_SIZE (ATR_HEADER + ATR_SECTORS * ATR_SECTOR)
+
+// per call, about what a TNFS round trip costs on a good network
+#define IMAGE_LATENCY_US 1000
+
+static uint8_t pattern(long pos)
+{
+    return (uint8_t)(pos * 7 + (pos >> 8));
+}
+
+/*
+ * Memory image which counts what it is asked to do
+ */
+class counted_image : public FileHandlerMem
+{
+public:
+    unsigned seeks = 0;
+    unsigned reads = 0;
+    unsigned writes = 0;
+    unsigned flushes = 0;
+    bool slow = false;
+
+    int seek(long int off, int whence) override
+    {
+        seeks++;
+        if (slow) fnSystem.delay_microseconds(IMAGE_LATENCY_US);
+        return FileHandlerMem::seek(off, whence);
+    }
+    size_t read(void *ptr, size_t size, size_t count) override
+    {
+        reads++;
+        if (slow) fnSystem.delay_microseconds(IMAGE_LATENCY_US);
+        return FileHandlerMem::read(ptr, size, count);
+    }
+    size_t write(const void *ptr, size_t size, size_t count) override
+    {
+        writes++;
+        return FileHandlerMem::write(ptr, size, count);
+    }
+    int flush() override
+    {
+        flushes++;
+        return FileHandlerMem::flush();
+    }
+    void reset() { seeks = reads = writes = flushes = 0; }
+};
+
+static counted_image *make_image(long size)
+{
+    counted_image *f = new counted_image();
+    uint8_t buf[256];
+    for (long pos = 0; pos < size; pos += sizeof(buf))
+    {
+        size_t n = size - pos < (long)sizeof(buf) ? size - pos : sizeof(buf);
+        for (size_t i = 0; i < n; i++)
+            buf[i] = pattern(pos + i);
+        f->FileHandlerMem::write(buf, 1, n);
+    }
+    f->reset();
+    return f;
+}
+
+static uint32_t atr_offset(uint16_t sector)
+{
+    return ATR_HEADER + (sector - 1) * ATR_SECTOR;
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_mediacache()
+{
+    RUN_TEST(tests_mediacache_round_trip);
+    RUN_TEST(tests_mediacache_sequential);
+    RUN_TEST(tests_mediacache_coalesce);
+    RUN_TEST(tests_mediacache_end_of_image);
+    RUN_TEST(tests_mediacache_prefetch);
+}
+
+/**
+ * Sectors which straddle cache blocks read and write back intact
+ */
+void tests_mediacache_round_trip()
+{
+    counted_image *f = make_image(ATR_SIZE);
+    MediaCache cache;
+    uint8_t buf[ATR_SECTOR];
+
+    TEST_ASSERT_FALSE(cache.attach(f, MEDIACACHE_BLOCK_SIZE, 4));
+
+    // sector 8 runs from the end of the first block into the second
+    TEST_ASSERT_FALSE(cache.read(atr_offset(8), buf, ATR_SECTOR));
+    for (int i = 0; i < ATR_SECTOR; i++)
+        TEST_ASSERT_EQUAL_UINT8(pattern(atr_offset(8) + i), buf[i]);
+
+    // scattered enough to keep evicting
+    for (uint16_t s = 1; s <= ATR_SECTORS; s += 37)
+    {
+        TEST_ASSERT_FALSE(cache.read(atr_offset(s), buf, ATR_SECTOR));
+        TEST_ASSERT_EQUAL_UINT8(pattern(atr_offset(s)), buf[0]);
+        TEST_ASSERT_EQUAL_UINT8(pattern(atr_offset(s) + ATR_SECTOR - 1), buf[ATR_SECTOR - 1]);
+    }
+
+    memset(buf, 0x5A, sizeof(buf));
+    TEST_ASSERT_FALSE(cache.write(atr_offset(8), buf, ATR_SECTOR));
+    TEST_ASSERT_FALSE(cache.flush());
+
+    // on the image, and nothing either side of it touched
+    uint8_t check[ATR_SECTOR + 2];
+    f->FileHandlerMem::seek(atr_offset(8) - 1, SEEK_SET);
+    f->FileHandlerMem::read(check, 1, sizeof(check));
+    TEST_ASSERT_EQUAL_UINT8(pattern(atr_offset(8) - 1), check[0]);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0x5A, &check[1], ATR_SECTOR);
+    TEST_ASSERT_EQUAL_UINT8(pattern(atr_offset(9)), check[ATR_SECTOR + 1]);
+
+    // and read back from the image again rather than from the cache
+    cache.invalidate();
+    TEST_ASSERT_FALSE(cache.read(atr_offset(8), buf, ATR_SECTOR));
+    TEST_ASSERT_EACH_EQUAL_UINT8(0x5A, buf, ATR_SECTOR);
+
+    cache.detach();
+    f->close();
+}
+
+/**
+ * Benchmark: booting an ATR sector by sector, against a seek and read per sector
+ */
+void tests_mediacache_sequential()
+{
+    char msg[128];
+    counted_image *f = make_image(ATR_SIZE);
+    uint8_t buf[ATR_SECTOR];
+    f->slow = true;
+
+    // as the media types used to, a seek unless it is the next sector
+    uint64_t start = fnSystem.millis();
+    for (uint16_t s = 1; s <= ATR_SECTORS; s++)
+    {
+        if (s == 1)
+            f->seek(atr_offset(s), SEEK_SET);
+        TEST_ASSERT_EQUAL(ATR_SECTOR, f->read(buf, 1, ATR_SECTOR));
+    }
+    uint64_t direct_ms = fnSystem.millis() - start;
+    unsigned direct_calls = f->seeks + f->reads;
+
+    f->reset();
+    MediaCache cache;
+    TEST_ASSERT_FALSE(cache.attach(f, MEDIACACHE_BLOCK_SIZE, MEDIACACHE_BLOCKS));
+    start = fnSystem.millis();
+    for (uint16_t s = 1; s <= ATR_SECTORS; s++)
+    {
+        TEST_ASSERT_FALSE(cache.read(atr_offset(s), buf, ATR_SECTOR));
+        TEST_ASSERT_EQUAL_UINT8(pattern(atr_offset(s)), buf[0]);
+    }
+    uint64_t cached_ms = fnSystem.millis() - start;
+    unsigned cached_calls = f->seeks + f->reads;
+
+    // one read per cache block, and one seek to start with
+    TEST_ASSERT_EQUAL((ATR_SIZE + MEDIACACHE_BLOCK_SIZE - 1) / MEDIACACHE_BLOCK_SIZE, f->reads);
+    TEST_ASSERT_EQUAL(1, f->seeks);
+    TEST_ASSERT_TRUE(cache.get_counters().readahead > 0);
+
+    cache.detach();
+    f->close();
+
+    snprintf(msg, sizeof(msg), "720 ATR sectors: direct %u calls %u ms, cached %u calls %u ms",
+             direct_calls, (unsigned)direct_ms, cached_calls, (unsigned)cached_ms);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * The pieces of one write go back as a single run
+ */
+void tests_mediacache_coalesce()
+{
+    counted_image *f = make_image(64 * 1024);
+    MediaCache cache;
+    uint8_t buf[256];
+
+    TEST_ASSERT_FALSE(cache.attach(f, MEDIACACHE_BLOCK_SIZE, 8));
+
+    // a 1K block in four quarters, then the half after it, as DDP and DSK write
+    for (int i = 0; i < 6; i++)
+    {
+        memset(buf, i + 1, sizeof(buf));
+        TEST_ASSERT_FALSE(cache.write(4096 + i * 256, buf, sizeof(buf)));
+    }
+    TEST_ASSERT_EQUAL(0, f->writes);
+    f->reset();
+    TEST_ASSERT_FALSE(cache.flush());
+
+    TEST_ASSERT_EQUAL(1, f->seeks);
+    TEST_ASSERT_EQUAL(2, f->writes);
+    TEST_ASSERT_EQUAL(1, f->flushes);
+    TEST_ASSERT_EQUAL(1, cache.get_counters().runs);
+
+    uint8_t check[6 * 256 + 1];
+    f->FileHandlerMem::seek(4096, SEEK_SET);
+    f->FileHandlerMem::read(check, 1, sizeof(check));
+    for (int i = 0; i < 6; i++)
+        TEST_ASSERT_EACH_EQUAL_UINT8(i + 1, &check[i * 256], 256);
+    TEST_ASSERT_EQUAL_UINT8(pattern(4096 + 6 * 256), check[6 * 256]);
+
+    // nothing dirty, nothing to do
+    f->reset();
+    TEST_ASSERT_FALSE(cache.flush());
+    TEST_ASSERT_EQUAL(0, f->writes);
+    TEST_ASSERT_EQUAL(0, f->flushes);
+
+    // high score style, through another handle
+    counted_image *other = make_image(64 * 1024);
+    memset(buf, 0xEE, sizeof(buf));
+    TEST_ASSERT_FALSE(cache.write(100, buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(cache.flush(other));
+    TEST_ASSERT_EQUAL(0, f->writes);
+    TEST_ASSERT_EQUAL(1, other->writes);
+
+    cache.detach();
+    other->close();
+    f->close();
+}
+
+/**
+ * Reads past the end fail, and are not remembered
+ */
+void tests_mediacache_end_of_image()
+{
+    counted_image *f = make_image(3000);
+    MediaCache cache;
+    uint8_t buf[512];
+
+    TEST_ASSERT_FALSE(cache.attach(f, MEDIACACHE_BLOCK_SIZE, 4));
+
+    // the last block is short but what is there reads
+    TEST_ASSERT_FALSE(cache.read(2900, buf, 100));
+    TEST_ASSERT_EQUAL_UINT8(pattern(2999), buf[99]);
+    TEST_ASSERT_TRUE(cache.read(2900, buf, 101));
+    TEST_ASSERT_TRUE(cache.read(4000, buf, 10));
+
+    // the image grows behind the cache's back, the next read sees it
+    uint8_t more[100];
+    memset(more, 0x11, sizeof(more));
+    f->FileHandlerMem::seek(3000, SEEK_SET);
+    f->FileHandlerMem::write(more, 1, sizeof(more));
+    TEST_ASSERT_FALSE(cache.read(2900, buf, 101));
+    TEST_ASSERT_EQUAL_UINT8(0x11, buf[100]);
+
+    // writing at the end grows the image
+    memset(buf, 0x22, sizeof(buf));
+    TEST_ASSERT_FALSE(cache.write(3100, buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(cache.flush());
+    TEST_ASSERT_EQUAL(3100 + sizeof(buf), f->size());
+
+    cache.detach();
+    f->close();
+}
+
+/**
+ * Prefetched blocks read without going to the image, and never push out dirty ones
+ */
+void tests_mediacache_prefetch()
+{
+    counted_image *f = make_image(64 * 1024);
+    MediaCache cache;
+    uint8_t buf[512];
+
+    TEST_ASSERT_FALSE(cache.attach(f, MEDIACACHE_BLOCK_SIZE, 8));
+
+    // eight SmartPort blocks ahead, four cache blocks, half the cache
+    TEST_ASSERT_FALSE(cache.prefetch(8192, 8 * 512));
+    TEST_ASSERT_EQUAL(4, f->reads);
+    TEST_ASSERT_EQUAL(4, cache.get_counters().readahead);
+    f->reset();
+    for (int b = 0; b < 8; b++)
+    {
+        TEST_ASSERT_FALSE(cache.read(8192 + b * 512, buf, sizeof(buf)));
+        TEST_ASSERT_EQUAL_UINT8(pattern(8192 + b * 512 + 511), buf[511]);
+    }
+    TEST_ASSERT_EQUAL(0, f->reads);
+    TEST_ASSERT_EQUAL(0, f->seeks);
+
+    // no more than half the cache, whatever is asked for
+    cache.invalidate();
+    f->reset();
+    TEST_ASSERT_FALSE(cache.prefetch(0, 32 * 1024));
+    TEST_ASSERT_EQUAL(4, f->reads);
+
+    // with every block dirty there is no room, and nothing goes back for it
+    cache.invalidate();
+    memset(buf, 0x33, sizeof(buf));
+    for (int b = 0; b < 8; b++)
+        TEST_ASSERT_FALSE(cache.write(b * MEDIACACHE_BLOCK_SIZE, buf, sizeof(buf)));
+    f->reset();
+    TEST_ASSERT_FALSE(cache.prefetch(32768, 4096));
+    TEST_ASSERT_EQUAL(0, f->reads);
+    TEST_ASSERT_EQUAL(0, f->writes);
+
+    cache.detach();
+    f->close();
+}
+
+#else
+
+/**
+ * Tests entrypoint
+ */
+void tests_mediacache()
+{
+    TEST_MESSAGE("MediaCache tests need fnio over FileHandler, skipped on stdio builds");
+}
+
+#endif /* FNIO_IS_STDIO */
@@ -0,0 +1,51 @@
+/**
+ * #FujiNet Tests - Media block cache
+ *
+ * MediaCache over an in-memory image that counts the calls made on it and
+ * takes a while to answer each one, like an image on a network host. Also
+ * built for the host, see test/main_host.cpp.
+ */
+
+#ifndef TEST_MEDIACACHE_H
+#define TEST_MEDIACACHE_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_mediacache();
+
+    /**
+     * Sectors which straddle cache blocks read and write back intact
+     */
+    void tests_mediacache_round_trip();
+
+    /**
+     * Benchmark: booting an ATR sector by sector, against a seek and read per sector
+     */
+    void tests_mediacache_sequential();
+
+    /**
+     * The pieces of one write go back as a single run
+     */
+    void tests_mediacache_coalesce();
+
+    /**
+     * Reads past the end fail, and are not remembered
+     */
+    void tests_mediacache_end_of_image();
+
+    /**
+     * Prefetched blocks read without going to the image, and never push out dirty ones
+     */
+    void tests_mediacache_prefetch();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_MEDIACACHE_H */
@@ -0,0 +1,167 @@
+/**
+ * #FujiNet Tests - PCLink directory snapshots
+ *
+ * The folder is created on the first run and left on the card, since
+ * making 5000 files takes far longer than anything being measured.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "compat_dirent.h"
+#include "../lib/device/sio/pclink_dir.h"
+#include "../lib/hardware/fnSystem.h"
+#include "fnFsSD.h"
+#include "test_pclink_dir.h"
+#include "test_unity.h"
+
+#define BENCH_FILES 5000
+
+static char bench_dir[64];
+
+/* PCLink only lists 8.3 names, everything in the folder qualifies */
+static int skip_none(const char *name)
+{
+    return name[0] == '.';
+}
+
+static bool bench_dir_ready()
+{
+    char path[96];
+    struct stat sb;
+
+    if (!fnSDFAT.running())
+        return false;
+
+    snprintf(bench_dir, sizeof(bench_dir), "%s/PCLBENCH", fnSDFAT.basepath());
+    snprintf(path, sizeof(path), "%s/F%04d.DAT", bench_dir, BENCH_FILES - 1);
+    if (stat(path, &sb) == 0)
+        return true;
+
+    mkdir(bench_dir, 0777);
+    for (int i = 0; i < BENCH_FILES; i++)
+    {
+        snprintf(path, sizeof(path), "%s/F%04d.DAT", bench_dir, i);
+        FILE *f = fopen(path, "w");
+        if (f == NULL)
+            return false;
+        fprintf(f, "%d", i);
+        fclose(f);
+    }
+    return true;
+}
+
+/* What get_file_len() followed by cache_dir() used to cost */
+static unsigned long old_scan(const char *dir)
+{
+    char path[96];
+    struct stat sb;
+    unsigned long n = 0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        DIR *dh = opendir(dir);
+        struct dirent *dp;
+
+        n = 0;
+        while ((dp = readdir(dh)) != NULL)
+        {
+            if (skip_none(dp->d_name))
+                continue;
+            snprintf(path, sizeof(path), "%s/%s", dir, dp->d_name);
+            if (stat(path, &sb) == 0)
+                n++;
+        }
+        closedir(dh);
+    }
+    return n;
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_pclink_dir()
+{
+    RUN_TEST(tests_pclink_dir_5k_scan);
+    RUN_TEST(tests_pclink_dir_5k_reuse);
+}
+
+/**
+ * Benchmark: old double scan against one snapshot
+ */
+void tests_pclink_dir_5k_scan()
+{
+    char msg[80];
+
+    if (!bench_dir_ready())
+        TEST_IGNORE_MESSAGE("no SD card");
+
+    pcl_dir_invalidate(bench_dir);
+
+    uint64_t start = fnSystem.millis();
+    unsigned long n = old_scan(bench_dir);
+    uint64_t old_ms = fnSystem.millis() - start;
+
+    start = fnSystem.millis();
+    PCL_DIRSNAP *snap = pcl_dir_snapshot(bench_dir, skip_none);
+    uint64_t snap_ms = fnSystem.millis() - start;
+
+    TEST_ASSERT_NOT_NULL(snap);
+    TEST_ASSERT_EQUAL(BENCH_FILES, n);
+    TEST_ASSERT_EQUAL(BENCH_FILES, snap->count);
+    pcl_dir_release(snap);
+
+    snprintf(msg, sizeof(msg), "%d files: two stat passes %u ms, snapshot %u ms",
+             BENCH_FILES, (unsigned)old_ms, (unsigned)snap_ms);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * FOPEN of every file after a DIR, as COPY *.* does
+ */
+void tests_pclink_dir_5k_reuse()
+{
+    char msg[80];
+    char want[16];
+    unsigned long found = 0;
+
+    if (!bench_dir_ready())
+        TEST_IGNORE_MESSAGE("no SD card");
+
+    PCL_DIRSNAP *first = pcl_dir_snapshot(bench_dir, skip_none);
+    TEST_ASSERT_NOT_NULL(first);
+
+    uint64_t start = fnSystem.millis();
+    for (int i = 0; i < BENCH_FILES; i += 50)
+    {
+        PCL_DIRSNAP *snap = pcl_dir_snapshot(bench_dir, skip_none);
+        TEST_ASSERT_TRUE(snap == first);
+
+        snprintf(want, sizeof(want), "F%04d.DAT", i);
+        for (unsigned long e = 0; e < snap->count; e++)
+        {
+            if (strcmp(snap->ent[e].name, want) == 0)
+            {
+                TEST_ASSERT_TRUE(S_ISREG(snap->ent[e].mode));
+                found++;
+                break;
+            }
+        }
+        pcl_dir_release(snap);
+    }
+    uint64_t elapsed = fnSystem.millis() - start;
+
+    TEST_ASSERT_EQUAL(BENCH_FILES / 50, found);
+
+    /* a change through PCLink must force a rescan */
+    pcl_dir_invalidate(bench_dir);
+    PCL_DIRSNAP *again = pcl_dir_snapshot(bench_dir, skip_none);
+    TEST_ASSERT_TRUE(again != first);
+    pcl_dir_release(again);
+    pcl_dir_release(first);
+
+    snprintf(msg, sizeof(msg), "%d lookups from one snapshot in %u ms",
+             BENCH_FILES / 50, (unsigned)elapsed);
+    TEST_MESSAGE(msg);
+}
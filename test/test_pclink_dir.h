@@ -0,0 +1,34 @@
+/**
+ * #FujiNet Tests - PCLink directory snapshots
+ *
+ * Scans a 5000 file folder on the SD card the old way and from a snapshot.
+ */
+
+#ifndef TEST_PCLINK_DIR_H
+#define TEST_PCLINK_DIR_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_pclink_dir();
+
+    /**
+     * Benchmark: stat()ing a 5000 file folder twice, as DIR used to, against one snapshot
+     */
+    void tests_pclink_dir_5k_scan();
+
+    /**
+     * Wildcard lookups reuse the snapshot until the folder is invalidated
+     */
+    void tests_pclink_dir_5k_reuse();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_PCLINK_DIR_H */
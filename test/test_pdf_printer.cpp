@@ -0,0 +1,150 @@
+/**
+ * #FujiNet Tests - PDF printer output
+ *
+ * The Atari 820 prints 66 lines per page, so 50 pages is 3300 listing lines.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../lib/printer-emulator/atari_820.h"
+#include "../lib/hardware/fnSystem.h"
+#include "fsFlash.h"
+#include "test_pdf_printer.h"
+#include "test_unity.h"
+
+#define LISTING_PAGES 50
+#define LISTING_PAGES_LONG 300
+#define LISTING_LINES_PER_PAGE 66
+
+/**
+ * Tests entrypoint
+ */
+void tests_pdf_printer()
+{
+    RUN_TEST(tests_pdf_printer_listing_50_pages);
+    RUN_TEST(tests_pdf_printer_listing_300_pages);
+}
+
+/**
+ * Prints the listing and returns the finished PDF, or nullptr on failure
+ */
+static char *print_listing(int pages, long *size, uint64_t *elapsed)
+{
+    atari820 printer;
+    char line[48];
+
+    printer.initPrinter(&fsFlash);
+
+    uint64_t start = fnSystem.millis();
+    for (int i = 0; i < pages * LISTING_LINES_PER_PAGE; i++)
+    {
+        int len = snprintf(line, sizeof(line), "%d PRINT \"LINE %d OF THE LISTING\"\x9B", (i + 1) * 10, i + 1);
+        memcpy(printer.provideBuffer(), line, len);
+        if (!printer.process(len, 'N', 0))
+            return nullptr;
+    }
+    FILE *f = printer.closeOutputAndProvideReadHandle();
+    *elapsed = fnSystem.millis() - start;
+    if (f == nullptr)
+        return nullptr;
+
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *pdf = (char *)malloc(*size + 1);
+    if (pdf != nullptr)
+    {
+        *size = fread(pdf, 1, *size, f);
+        pdf[*size] = '\0';
+    }
+    fclose(f);
+    return pdf;
+}
+
+/**
+ * Finds the last occurrence of str, the embedded fonts hold NULs so strstr won't do
+ */
+static const char *find_last(const char *pdf, long size, const char *str)
+{
+    size_t len = strlen(str);
+    for (long i = size - (long)len; i >= 0; i--)
+        if (memcmp(pdf + i, str, len) == 0)
+            return pdf + i;
+    return nullptr;
+}
+
+/**
+ * Checks the trailer, and that every cross-reference entry points at its object
+ */
+static void check_xref(const char *pdf, long size, int pages)
+{
+    char expect[32];
+
+    TEST_ASSERT_TRUE(size > 6);
+    TEST_ASSERT_EQUAL_STRING("%%EOF\n", pdf + size - 6);
+
+    const char *startxref = find_last(pdf, size, "startxref\n");
+    TEST_ASSERT_NOT_NULL(startxref);
+    long xref = atol(startxref + 10);
+    TEST_ASSERT_TRUE(xref > 0 && xref < size);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(pdf + xref, "xref\n0 ", 7));
+
+    char *p;
+    long count = strtol(pdf + xref + 7, &p, 10);
+    // catalog, pages, fonts and three objects a page
+    TEST_ASSERT_TRUE(count > pages * 3);
+    while (*p == '\r' || *p == '\n')
+        p++;
+
+    // one "nnnnnnnnnn ggggg n" entry a line, object 0 is the free list head
+    TEST_ASSERT_EQUAL_INT(0, strncmp(p, "0000000000 65535 f", 18));
+    for (long i = 1; i < count; i++)
+    {
+        p = strchr(p, '\n');
+        TEST_ASSERT_NOT_NULL(p);
+        p++;
+        TEST_ASSERT_EQUAL_INT(0, strncmp(p + 10, " 00000 n", 8));
+        long offset = atol(p);
+        TEST_ASSERT_TRUE(offset > 0 && offset < xref);
+        int len = snprintf(expect, sizeof(expect), "%ld 0 obj", i);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, strncmp(pdf + offset, expect, len), expect);
+    }
+
+    const char *trailer = strstr(p, "trailer <</Size ");
+    TEST_ASSERT_NOT_NULL(trailer);
+    TEST_ASSERT_EQUAL_INT(count, atol(trailer + 16));
+}
+
+/**
+ * Benchmark: 50 page listing
+ */
+void tests_pdf_printer_listing_50_pages()
+{
+    long size = 0;
+    uint64_t elapsed = 0;
+    char msg[64];
+
+    char *pdf = print_listing(LISTING_PAGES, &size, &elapsed);
+    TEST_ASSERT_NOT_NULL(pdf);
+    check_xref(pdf, size, LISTING_PAGES);
+    free(pdf);
+
+    snprintf(msg, sizeof(msg), "%d pages, %ld bytes in %u ms",
+             LISTING_PAGES, size, (unsigned)elapsed);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * 300 page listing, more pages than the old fixed page table held
+ */
+void tests_pdf_printer_listing_300_pages()
+{
+    long size = 0;
+    uint64_t elapsed = 0;
+
+    char *pdf = print_listing(LISTING_PAGES_LONG, &size, &elapsed);
+    TEST_ASSERT_NOT_NULL(pdf);
+    check_xref(pdf, size, LISTING_PAGES_LONG);
+    free(pdf);
+}
@@ -0,0 +1,35 @@
+/**
+ * #FujiNet Tests - PDF printer output
+ *
+ * Prints long listings through the Atari 820 emulator, checks the cross-reference
+ * table against the objects and reports how long it took.
+ */
+
+#ifndef TEST_PDF_PRINTER_H
+#define TEST_PDF_PRINTER_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_pdf_printer();
+
+    /**
+     * Benchmark: print a 50 page program listing and check the PDF is complete
+     */
+    void tests_pdf_printer_listing_50_pages();
+
+    /**
+     * Print a 300 page listing and check every object in the cross-reference table
+     */
+    void tests_pdf_printer_listing_300_pages();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_PDF_PRINTER_H */
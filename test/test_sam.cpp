@@ -0,0 +1,103 @@
+/**
+ * #FujiNet Tests - SAM speech
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "../lib/sam/sam.h"
+#include "../lib/sam/SamPrompts.h"
+#include "test_sam.h"
+
+#ifdef ESP_PLATFORM
+#include "fsFlash.h"
+#else
+// Host builds read the prompts from the source tree
+#ifndef SAM_PROMPT_DIR
+#define SAM_PROMPT_DIR "data/webui/device_specific/BUILD_ATARI"
+#endif
+
+// Normally from samlib.cpp, which needs FreeRTOS
+int debug = 0;
+#endif
+
+static std::vector<unsigned char> rendered;
+
+static void collect(const unsigned char *samples, int count)
+{
+    rendered.insert(rendered.end(), samples, samples + count);
+}
+
+// Renders a phonetic phrase with util_sam_say()'s default voice
+static bool render(const char *phrase)
+{
+    char text[256];
+    snprintf(text, sizeof(text), "%s\x9b", phrase);
+
+    rendered.clear();
+    SetInput(text);
+    SetPitch(64);
+    SetSpeed(96);
+    SetMouth(128);
+    SetThroat(128);
+    SetOutput(collect);
+    int ok = SAMMain();
+    SetOutput(NULL);
+    return ok != 0;
+}
+
+static bool read_prompt(const char *path, std::vector<unsigned char> &pcm)
+{
+#ifdef ESP_PLATFORM
+    FILE *f = fsFlash.file_open(path);
+#else
+    FILE *f = fopen((std::string(SAM_PROMPT_DIR) + path).c_str(), "rb");
+#endif
+    if (f == nullptr)
+        return false;
+
+    unsigned char buf[512];
+    size_t count;
+    pcm.clear();
+    while ((count = fread(buf, 1, sizeof(buf), f)) > 0)
+        pcm.insert(pcm.end(), buf, buf + count);
+    fclose(f);
+    return true;
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_sam()
+{
+    RUN_TEST(tests_sam_prompts_match_render);
+    RUN_TEST(tests_sam_render_repeatable);
+}
+
+void tests_sam_prompts_match_render()
+{
+    std::vector<unsigned char> pcm;
+
+    for (const SamPrompt &prompt : samPrompts)
+    {
+        TEST_ASSERT_TRUE_MESSAGE(read_prompt(prompt.path, pcm), prompt.path);
+        TEST_ASSERT_TRUE_MESSAGE(render(prompt.phrase), prompt.phrase);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(pcm.size(), rendered.size(), prompt.phrase);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(pcm.data(), rendered.data(), pcm.size(), prompt.phrase);
+    }
+}
+
+void tests_sam_render_repeatable()
+{
+    // long enough to wrap the renderer's ring several times
+    const char *phrase = "DIHSK7Q WAH7NQ TUW7 THRIYY7Q";
+
+    TEST_ASSERT_TRUE(render(phrase));
+    std::vector<unsigned char> first = rendered;
+    TEST_ASSERT_TRUE(first.size() > 4096);
+
+    TEST_ASSERT_TRUE(render(phrase));
+    TEST_ASSERT_EQUAL_UINT32(first.size(), rendered.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(first.data(), rendered.data(), first.size());
+}
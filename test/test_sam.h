@@ -0,0 +1,35 @@
+/**
+ * #FujiNet Tests - SAM speech
+ *
+ * The disk swap prompts kept on the flash filesystem have to match what the
+ * renderer would say for them, or a swap would sound different from SAM.
+ */
+
+#ifndef TEST_SAM_H
+#define TEST_SAM_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_sam();
+
+    /**
+     * Every prompt file is what the renderer produces for its phrase
+     */
+    void tests_sam_prompts_match_render();
+
+    /**
+     * Rendering the same phrase twice gives the same samples
+     */
+    void tests_sam_render_repeatable();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_SAM_H */
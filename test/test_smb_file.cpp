@@ -0,0 +1,559 @@
+/**
+ * #FujiNet Tests - Pipelined SMB file access
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <smb2/libsmb2.h>
+#include <smb2/smb2.h>
+#include "../lib/FileSystem/fnFileSMB.h"
+#include "../lib/tcpip/fnTcpServer.h"
+#include "../lib/hardware/fnSystem.h"
+#include "test_smb_file.h"
+#include "test_unity.h"
+
+#define STANDIN_PORT 21220
+#define STANDIN_LATENCY_US 1000
+#define TEST_IMAGE_SIZE (256 * 1024)
+#define TEST_IMAGE "test.atr"
+#define TEST_SECTOR 128
+// what MediaCache asks of the image at a time
+#define TEST_BLOCK 1024
+
+#define SMB2_HEADER 64
+
+static uint8_t pattern(long pos)
+{
+    return (uint8_t)(pos * 5 + (pos >> 9) * 3);
+}
+
+static uint16_t get16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+static uint64_t get64(const uint8_t *p) { return get32(p) | ((uint64_t)get32(p + 4) << 32); }
+static void put16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put32(uint8_t *p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+static void put64(uint8_t *p, uint64_t v) { put32(p, v); put32(p + 4, v >> 32); }
+
+/*
+ * Just enough of an SMB2 server: dialect 2.0.2, an anonymous NTLMSSP logon,
+ * one share and one image in memory. Requests are read as they arrive and
+ * each is answered STANDIN_LATENCY_US later, so requests sent together are
+ * answered together, as a real server would.
+ */
+class smb_standin
+{
+public:
+    std::vector<uint8_t> image;
+    std::mutex image_lock;
+    std::atomic<int> requests{0};
+    std::atomic<int> reads{0};
+    std::atomic<int> writes{0};
+    std::atomic<int> most_waiting{0};
+
+    bool start()
+    {
+        if (!_server.begin())
+            return false;
+        _server.setNoDelay(true);
+        _running = true;
+        _thread = std::thread(&smb_standin::run, this);
+        return true;
+    }
+
+    void reset_counts()
+    {
+        requests = reads = writes = most_waiting = 0;
+    }
+
+private:
+    struct reply_out
+    {
+        uint64_t due;
+        std::vector<uint8_t> frame;
+    };
+
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    fnTcpServer _server{STANDIN_PORT, 1};
+    fnTcpClient _client;
+    std::vector<uint8_t> _in;
+    std::deque<reply_out> _out;
+
+    void queue_reply(const uint8_t *req, uint32_t status, const std::vector<uint8_t> &body, uint32_t tree_id = 1)
+    {
+        reply_out r;
+        r.due = fnSystem.micros() + STANDIN_LATENCY_US;
+        r.frame.assign(4 + SMB2_HEADER, 0);
+        put32(&r.frame[0], __builtin_bswap32(SMB2_HEADER + body.size()));
+
+        uint8_t *h = &r.frame[4];
+        memcpy(h, "\xfeSMB", 4);
+        put16(h + 4, SMB2_HEADER);
+        put16(h + 6, get16(req + 6));               // credit charge
+        put32(h + 8, status);
+        put16(h + 12, get16(req + 12));             // command
+        put16(h + 14, get16(req + 14) ? get16(req + 14) : 1); // credits granted
+        put32(h + 16, SMB2_FLAGS_SERVER_TO_REDIR);
+        put64(h + 24, get64(req + 24));             // message id
+        put32(h + 32, 0xFEFF);
+        put32(h + 36, tree_id);
+        put64(h + 40, 0x1234);                      // session id
+
+        r.frame.insert(r.frame.end(), body.begin(), body.end());
+        _out.push_back(r);
+        if ((int)_out.size() > most_waiting)
+            most_waiting = _out.size();
+    }
+
+    void error_reply(const uint8_t *req, uint32_t status)
+    {
+        std::vector<uint8_t> body(8, 0);
+        put16(&body[0], SMB2_ERROR_REPLY_SIZE);
+        queue_reply(req, status, body);
+    }
+
+    void handle(const uint8_t *req, size_t len)
+    {
+        const uint8_t *b = req + SMB2_HEADER;
+        std::vector<uint8_t> body;
+
+        requests++;
+        switch (get16(req + 12))
+        {
+        case SMB2_NEGOTIATE:
+            body.assign(64, 0);
+            put16(&body[0], SMB2_NEGOTIATE_REPLY_SIZE);
+            put16(&body[2], SMB2_NEGOTIATE_SIGNING_ENABLED);
+            put16(&body[4], SMB2_VERSION_0202);
+            put32(&body[28], 65536);
+            put32(&body[32], 65536);
+            put32(&body[36], 65536);
+            queue_reply(req, SMB2_STATUS_SUCCESS, body, 0);
+            break;
+
+        case SMB2_SESSION_SETUP:
+        {
+            // NTLMSSP message type of what the client sent
+            const uint8_t *blob = req + get16(b + 12);
+            body.assign(8, 0);
+            put16(&body[0], SMB2_SESSION_SETUP_REPLY_SIZE);
+            if (get32(blob + 8) == 1)
+            {
+                // a challenge with nothing in it, the logon is anonymous
+                std::vector<uint8_t> challenge(56, 0);
+                memcpy(&challenge[0], "NTLMSSP", 8);
+                put32(&challenge[8], 2);
+                put32(&challenge[20], 0x00028205);
+                memcpy(&challenge[24], "FUJINET!", 8);
+                put32(&challenge[44], 56);
+                put16(&body[4], SMB2_HEADER + 8);
+                put16(&body[6], challenge.size());
+                body.insert(body.end(), challenge.begin(), challenge.end());
+                queue_reply(req, SMB2_STATUS_MORE_PROCESSING_REQUIRED, body, 0);
+            }
+            else
+                queue_reply(req, SMB2_STATUS_SUCCESS, body, 0);
+            break;
+        }
+
+        case SMB2_TREE_CONNECT:
+            body.assign(16, 0);
+            put16(&body[0], SMB2_TREE_CONNECT_REPLY_SIZE);
+            body[2] = SMB2_SHARE_TYPE_DISK;
+            put32(&body[12], 0x001F01FF);
+            queue_reply(req, SMB2_STATUS_SUCCESS, body);
+            break;
+
+        case SMB2_CREATE:
+            body.assign(88, 0);
+            put16(&body[0], SMB2_CREATE_REPLY_SIZE);
+            put32(&body[4], 1);                  // FILE_OPENED
+            put64(&body[40], image.size());
+            put64(&body[48], image.size());
+            put32(&body[56], SMB2_FILE_ATTRIBUTE_ARCHIVE);
+            put64(&body[64], 1);
+            queue_reply(req, SMB2_STATUS_SUCCESS, body);
+            break;
+
+        case SMB2_QUERY_INFO:
+        {
+            // FileAllInformation, only the end of file matters
+            std::vector<uint8_t> info(104, 0);
+            put64(&info[48], image.size());
+            put32(&info[56], 1);
+            body.assign(8, 0);
+            put16(&body[0], SMB2_QUERY_INFO_REPLY_SIZE);
+            put16(&body[2], SMB2_HEADER + 8);
+            put32(&body[4], info.size());
+            body.insert(body.end(), info.begin(), info.end());
+            queue_reply(req, SMB2_STATUS_SUCCESS, body);
+            break;
+        }
+
+        case SMB2_READ:
+        {
+            uint32_t count = get32(b + 4);
+            uint64_t offset = get64(b + 8);
+            reads++;
+            std::lock_guard<std::mutex> lock(image_lock);
+            if (offset >= image.size())
+            {
+                error_reply(req, SMB2_STATUS_END_OF_FILE);
+                break;
+            }
+            if (count > image.size() - offset)
+                count = image.size() - offset;
+            body.assign(16, 0);
+            put16(&body[0], SMB2_READ_REPLY_SIZE);
+            body[2] = SMB2_HEADER + 16;
+            put32(&body[4], count);
+            body.insert(body.end(), image.begin() + offset, image.begin() + offset + count);
+            queue_reply(req, SMB2_STATUS_SUCCESS, body);
+            break;
+        }
+
+        case SMB2_WRITE:
+        {
+            uint16_t data_offset = get16(b + 2);
+            uint32_t count = get32(b + 4);
+            uint64_t offset = get64(b + 8);
+            writes++;
+            if (data_offset + count > len)
+            {
+                error_reply(req, SMB2_STATUS_INVALID_PARAMETER);
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(image_lock);
+                if (offset + count > image.size())
+                    image.resize(offset + count);
+                memcpy(&image[offset], req + data_offset, count);
+            }
+            body.assign(16, 0);
+            put16(&body[0], SMB2_WRITE_REPLY_SIZE);
+            put32(&body[4], count);
+            queue_reply(req, SMB2_STATUS_SUCCESS, body);
+            break;
+        }
+
+        case SMB2_CLOSE:
+            body.assign(60, 0);
+            put16(&body[0], SMB2_CLOSE_REPLY_SIZE);
+            queue_reply(req, SMB2_STATUS_SUCCESS, body);
+            break;
+
+        case SMB2_FLUSH:
+        case SMB2_TREE_DISCONNECT:
+        case SMB2_LOGOFF:
+        case SMB2_ECHO:
+            body.assign(4, 0);
+            put16(&body[0], 4);
+            queue_reply(req, SMB2_STATUS_SUCCESS, body);
+            break;
+
+        default:
+            error_reply(req, SMB2_STATUS_NOT_SUPPORTED);
+            break;
+        }
+    }
+
+    void run()
+    {
+        uint8_t buf[4096];
+
+        while (_running)
+        {
+            if (!_client.connected())
+            {
+                _in.clear();
+                _out.clear();
+                if (!_server.hasClient())
+                {
+                    fnSystem.delay(10);
+                    continue;
+                }
+                _client = _server.available();
+            }
+
+            int available = _client.available();
+            if (available > 0)
+            {
+                int n = _client.read(buf, available > (int)sizeof(buf) ? sizeof(buf) : available);
+                if (n > 0)
+                    _in.insert(_in.end(), buf, buf + n);
+            }
+
+            // every whole request that has arrived
+            while (_in.size() >= 4)
+            {
+                size_t len = (_in[1] << 16) | (_in[2] << 8) | _in[3];
+                if (_in.size() < 4 + len)
+                    break;
+                if (len >= SMB2_HEADER)
+                    handle(&_in[4], len);
+                _in.erase(_in.begin(), _in.begin() + 4 + len);
+            }
+
+            // and every answer that is due
+            uint64_t now = fnSystem.micros();
+            while (!_out.empty() && _out.front().due <= now)
+            {
+                _client.write(_out.front().frame.data(), _out.front().frame.size());
+                _out.pop_front();
+            }
+
+            if (available <= 0)
+                fnSystem.delay_microseconds(50);
+        }
+    }
+};
+
+static smb_standin *standin = nullptr;
+static struct smb2_context *smb = nullptr;
+
+static bool standin_ready()
+{
+    if (standin == nullptr)
+    {
+        standin = new smb_standin();
+        if (!standin->start())
+            return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(standin->image_lock);
+        standin->image.resize(TEST_IMAGE_SIZE);
+        for (long i = 0; i < TEST_IMAGE_SIZE; i++)
+            standin->image[i] = pattern(i);
+    }
+
+    if (smb == nullptr)
+    {
+        char server[32];
+        snprintf(server, sizeof(server), "127.0.0.1:%d", STANDIN_PORT);
+        smb = smb2_init_context();
+        smb2_set_security_mode(smb, SMB2_NEGOTIATE_SIGNING_ENABLED);
+        if (smb2_connect_share(smb, server, "fujinet", "guest") != 0)
+        {
+            smb2_destroy_context(smb);
+            smb = nullptr;
+            return false;
+        }
+    }
+    standin->reset_counts();
+    return true;
+}
+
+static FileHandler *open_image(int flags = O_RDONLY)
+{
+    struct smb2fh *fh = smb2_open(smb, TEST_IMAGE, flags);
+    if (fh == nullptr)
+        return nullptr;
+    smb2_stat_64 st;
+    if (smb2_fstat(smb, fh, &st) != 0)
+    {
+        smb2_close(smb, fh);
+        return nullptr;
+    }
+    return new FileHandlerSMB(smb, fh, (long)st.smb2_size);
+}
+
+static bool check_data(const uint8_t *buf, long pos, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        if (buf[i] != pattern(pos + i))
+            return false;
+    return true;
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_smb_file()
+{
+    RUN_TEST(tests_smb_file_sequential);
+    RUN_TEST(tests_smb_file_position);
+    RUN_TEST(tests_smb_file_random);
+    RUN_TEST(tests_smb_file_write);
+}
+
+/**
+ * Benchmark: reading the image in order, against one synchronous read per block
+ */
+void tests_smb_file_sequential()
+{
+    char msg[128];
+    uint8_t buf[TEST_BLOCK];
+
+    if (!standin_ready())
+        TEST_IGNORE_MESSAGE("SMB stand-in did not start");
+
+    // a round trip for each block, as the handler used to
+    struct smb2fh *fh = smb2_open(smb, TEST_IMAGE, O_RDONLY);
+    TEST_ASSERT_NOT_NULL(fh);
+    standin->reset_counts();
+    uint64_t start = fnSystem.millis();
+    for (long pos = 0; pos < TEST_IMAGE_SIZE; pos += TEST_BLOCK)
+    {
+        TEST_ASSERT_EQUAL(TEST_BLOCK, smb2_pread(smb, fh, buf, TEST_BLOCK, pos));
+        TEST_ASSERT_TRUE(check_data(buf, pos, TEST_BLOCK));
+    }
+    uint64_t sync_ms = fnSystem.millis() - start;
+    int sync_reads = standin->reads;
+    smb2_close(smb, fh);
+
+    FileHandler *f = open_image();
+    TEST_ASSERT_NOT_NULL(f);
+    standin->reset_counts();
+    start = fnSystem.millis();
+    for (long pos = 0; pos < TEST_IMAGE_SIZE; pos += TEST_BLOCK)
+    {
+        TEST_ASSERT_EQUAL(TEST_BLOCK, f->read(buf, 1, TEST_BLOCK));
+        TEST_ASSERT_TRUE(check_data(buf, pos, TEST_BLOCK));
+    }
+    uint64_t piped_ms = fnSystem.millis() - start;
+
+    // a read per cache block, several of them on the wire at once
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE / SMBFILE_BLOCK_SIZE, standin->reads);
+    TEST_ASSERT_TRUE(standin->most_waiting > 1);
+    TEST_ASSERT_EQUAL(0, f->read(buf, 1, TEST_BLOCK));
+    TEST_ASSERT_EQUAL(0, f->close());
+
+    snprintf(msg, sizeof(msg), "%d KB in %d byte reads: synchronous %d reads %u ms, pipelined %d reads %u ms",
+             TEST_IMAGE_SIZE / 1024, TEST_BLOCK, sync_reads, (unsigned)sync_ms,
+             TEST_IMAGE_SIZE / SMBFILE_BLOCK_SIZE, (unsigned)piped_ms);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * Seeking and telling never go to the server, reads run to the end and no further
+ */
+void tests_smb_file_position()
+{
+    uint8_t buf[3 * SMBFILE_BLOCK_SIZE];
+
+    if (!standin_ready())
+        TEST_IGNORE_MESSAGE("SMB stand-in did not start");
+
+    FileHandler *f = open_image();
+    TEST_ASSERT_NOT_NULL(f);
+    standin->reset_counts();
+
+    TEST_ASSERT_EQUAL(0, f->seek(-100, SEEK_END));
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE - 100, f->tell());
+    TEST_ASSERT_EQUAL(0, f->seek(-50, SEEK_CUR));
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE - 150, f->tell());
+    TEST_ASSERT_EQUAL(-1, f->seek(-1, SEEK_SET));
+    TEST_ASSERT_EQUAL(0, standin->requests);
+
+    // short at the end of the image, then nothing
+    TEST_ASSERT_EQUAL(150, f->read(buf, 1, sizeof(buf)));
+    TEST_ASSERT_TRUE(check_data(buf, TEST_IMAGE_SIZE - 150, 150));
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE, f->tell());
+    TEST_ASSERT_EQUAL(0, f->read(buf, 1, 1));
+
+    // one read across three blocks lands each piece in its place
+    long pos = SMBFILE_BLOCK_SIZE / 2;
+    TEST_ASSERT_EQUAL(0, f->seek(pos, SEEK_SET));
+    TEST_ASSERT_EQUAL(1, f->read(buf, sizeof(buf), 1));
+    TEST_ASSERT_TRUE(check_data(buf, pos, sizeof(buf)));
+    TEST_ASSERT_EQUAL(pos + (long)sizeof(buf), f->tell());
+
+    TEST_ASSERT_EQUAL(0, f->close());
+}
+
+/**
+ * Scattered reads, several blocks at once, return the right data
+ */
+void tests_smb_file_random()
+{
+    uint8_t buf[TEST_BLOCK * 2];
+    uint32_t seed = 4321;
+
+    if (!standin_ready())
+        TEST_IGNORE_MESSAGE("SMB stand-in did not start");
+
+    FileHandler *f = open_image();
+    TEST_ASSERT_NOT_NULL(f);
+
+    for (int i = 0; i < 200; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        long pos = (seed >> 8) % (TEST_IMAGE_SIZE - sizeof(buf));
+        size_t len = TEST_SECTOR + (seed % (sizeof(buf) - TEST_SECTOR));
+        TEST_ASSERT_EQUAL(0, f->seek(pos, SEEK_SET));
+        TEST_ASSERT_EQUAL(len, f->read(buf, 1, len));
+        TEST_ASSERT_TRUE(check_data(buf, pos, len));
+
+        // and sometimes carry on from there for a while
+        if (i % 10 == 0)
+        {
+            for (int j = 0; j < 8 && f->tell() + TEST_SECTOR <= TEST_IMAGE_SIZE; j++)
+            {
+                long at = f->tell();
+                TEST_ASSERT_EQUAL(TEST_SECTOR, f->read(buf, 1, TEST_SECTOR));
+                TEST_ASSERT_TRUE(check_data(buf, at, TEST_SECTOR));
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL(0, f->close());
+}
+
+/**
+ * Writes reach the server and show in blocks already cached
+ */
+void tests_smb_file_write()
+{
+    uint8_t buf[TEST_SECTOR];
+    uint8_t check[TEST_SECTOR + 2];
+
+    if (!standin_ready())
+        TEST_IGNORE_MESSAGE("SMB stand-in did not start");
+
+    FileHandler *f = open_image(O_RDWR);
+    TEST_ASSERT_NOT_NULL(f);
+
+    // get the block into the cache first
+    long pos = 5 * SMBFILE_BLOCK_SIZE + 300;
+    TEST_ASSERT_EQUAL(0, f->seek(pos - 1, SEEK_SET));
+    TEST_ASSERT_EQUAL(1, f->read(check, sizeof(check), 1));
+
+    memset(buf, 0xA5, sizeof(buf));
+    TEST_ASSERT_EQUAL(0, f->seek(pos, SEEK_SET));
+    TEST_ASSERT_EQUAL(1, f->write(buf, sizeof(buf), 1));
+    TEST_ASSERT_EQUAL(pos + TEST_SECTOR, f->tell());
+    TEST_ASSERT_EQUAL(1, standin->writes);
+
+    {
+        std::lock_guard<std::mutex> lock(standin->image_lock);
+        TEST_ASSERT_EACH_EQUAL_UINT8(0xA5, &standin->image[pos], TEST_SECTOR);
+        TEST_ASSERT_EQUAL_UINT8(pattern(pos + TEST_SECTOR), standin->image[pos + TEST_SECTOR]);
+    }
+
+    // read back from the cache, no new read for it
+    int reads = standin->reads;
+    TEST_ASSERT_EQUAL(0, f->seek(pos - 1, SEEK_SET));
+    TEST_ASSERT_EQUAL(1, f->read(check, sizeof(check), 1));
+    TEST_ASSERT_EQUAL(reads, standin->reads);
+    TEST_ASSERT_EQUAL_UINT8(pattern(pos - 1), check[0]);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xA5, &check[1], TEST_SECTOR);
+    TEST_ASSERT_EQUAL_UINT8(pattern(pos + TEST_SECTOR), check[TEST_SECTOR + 1]);
+
+    // past the end grows the file
+    TEST_ASSERT_EQUAL(0, f->seek(0, SEEK_END));
+    TEST_ASSERT_EQUAL(1, f->write(buf, sizeof(buf), 1));
+    TEST_ASSERT_EQUAL(0, f->seek(-TEST_SECTOR, SEEK_END));
+    TEST_ASSERT_EQUAL(TEST_IMAGE_SIZE, f->tell());
+    TEST_ASSERT_EQUAL(1, f->read(check, TEST_SECTOR, 1));
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xA5, check, TEST_SECTOR);
+
+    TEST_ASSERT_EQUAL(0, f->flush());
+    TEST_ASSERT_EQUAL(0, f->close());
+}
@@ -0,0 +1,48 @@
+/**
+ * #FujiNet Tests - Pipelined SMB file access
+ *
+ * Runs FileHandlerSMB against a small SMB2 server stand-in on the loopback
+ * interface. It serves one image from memory to one anonymous client,
+ * answers each request a fixed time after it arrives, like a server across
+ * a LAN, and counts the reads it is asked for. Also built for the host, see
+ * test/main_host.cpp.
+ */
+
+#ifndef TEST_SMB_FILE_H
+#define TEST_SMB_FILE_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_smb_file();
+
+    /**
+     * Benchmark: reading the image in order, against one synchronous read per block
+     */
+    void tests_smb_file_sequential();
+
+    /**
+     * Seeking and telling never go to the server, reads run to the end and no further
+     */
+    void tests_smb_file_position();
+
+    /**
+     * Scattered reads, several blocks at once, return the right data
+     */
+    void tests_smb_file_random();
+
+    /**
+     * Writes reach the server and show in blocks already cached
+     */
+    void tests_smb_file_write();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_SMB_FILE_H */
@@ -0,0 +1,46 @@
+/**
+ * #FujiNet Tests - SmartPort packet coding
+ *
+ * The group of 7 coding, checksum and SPI sample expansion against the bit
+ * by bit versions they replaced, and how long each takes. Also built for the
+ * host.
+ */
+
+#ifndef TEST_SPCODEC_H
+#define TEST_SPCODEC_H
+
+#include <unity.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_spcodec();
+
+    /**
+     * Data of every length up to a block packet encodes as before, checksum too
+     */
+    void tests_spcodec_encode_data();
+
+    /**
+     * Packet bodies decode as before, whatever the high bits on the wire
+     */
+    void tests_spcodec_decode_data();
+
+    /**
+     * Packet bytes expand to the same SPI samples as before
+     */
+    void tests_spcodec_encode_spi();
+
+    /**
+     * Benchmark: a block packet encoded, expanded and decoded, against before
+     */
+    void tests_spcodec_speed();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_SPCODEC_H */
@@ -0,0 +1,18 @@
+/**
+ * #FujiNet Tests - Unity additions
+ *
+ * The Unity vendored with cJSON for the host tests predates TEST_MESSAGE,
+ * so benchmarks there print their results with puts instead.
+ */
+
+#ifndef TEST_UNITY_H
+#define TEST_UNITY_H
+
+#include <stdio.h>
+#include <unity.h>
+
+#ifndef TEST_MESSAGE
+#define TEST_MESSAGE(message) puts(message)
+#endif
+
+#endif /* TEST_UNITY_H */
@@ -0,0 +1,370 @@
+/*
+ * DriveWire Becker port benchmark
+ *
+ * Stands in for a CoCo emulator (XRoar, MAME) on the host: it connects to
+ * the BeckerPort the PC build uses, over loopback TCP, and reads or writes
+ * every sector of an image the way the CoCo's DriveWire driver does. The
+ * #FujiNet end answers from its bus loop through MediaCache, the way
+ * systemBus::service() and drivewireDisk do.
+ *
+ * BeckerPort, MediaCache and the read ahead (MediaPrefetch run by taskMgr)
+ * are the real code. op_readex() and op_write() below are cut-down copies of
+ * the systemBus ones, without the device table or MediaType, so the numbers
+ * are for the transport and the cache, and the copies have to be kept in
+ * step with the real handlers by hand. Reports sectors a second for:
+ *
+ *   write   OP_WRITE, a sector and its checksum, then the status
+ *   read    OP_READEX, the sector, its checksum back, then the status
+ *   ahead   OP_READEX, with the sectors after a sequential read loaded one
+ *           per loop pass, as drivewireDisk does
+ *   piped   OP_READEX, with the next request sent along with the checksum
+ *           instead of after the status, so the port gets them together
+ *
+ *   drivewire-becker-bench [-s sectors] [-r runs] [-p port]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "dwbecker.h"
+#include "mediaCache.h"
+#include "mediaPrefetch.h"
+#include "fnTaskManager.h"
+
+#define BENCH_SECTOR 256         // MEDIA_BLOCK_SIZE
+#define BENCH_PREFETCH_SECTORS 16 // DW_PREFETCH_SECTORS
+#define OP_READEX ('R' + 128)
+#define OP_WRITE 'W'
+
+// the port resolves its host through fnDNS
+in_addr_t get_ip4_addr_by_name(const char *hostname)
+{
+    return inet_addr(hostname);
+}
+
+static uint8_t pattern(uint32_t lsn, int i, uint8_t pass)
+{
+    return (uint8_t)(lsn * 7 + i + pass);
+}
+
+static uint16_t checksum(const uint8_t *buf, int len)
+{
+    uint16_t chk = 0;
+    for (int i = 0; i < len; i++)
+        chk += buf[i];
+    return chk;
+}
+
+/*
+ * The #FujiNet end
+ */
+struct bench_fujinet
+{
+    BeckerPort port;
+    MediaCache cache;
+    FILE *image = nullptr;
+    std::atomic<bool> prefetch{false};
+    std::atomic<bool> stop{false};
+    // set by the emulator end between runs, done by the bus loop so it doesn't race it
+    std::atomic<bool> restart{false};
+    uint8_t sector[BENCH_SECTOR];
+
+    // drivewireDisk's
+    MediaPrefetch read_ahead{BENCH_PREFETCH_SECTORS, [this](uint32_t lsn) {
+        cache.prefetch(lsn * BENCH_SECTOR, BENCH_SECTOR);
+    }};
+
+    // DwCom::read()
+    int read()
+    {
+        uint8_t b;
+        return port.read(&b, 1) == 1 ? b : -1;
+    }
+
+    // systemBus::op_readex()
+    void op_readex()
+    {
+        read(); // drive
+        uint32_t lsn = read() << 16;
+        lsn |= read() << 8;
+        lsn |= read();
+
+        uint8_t rc = 0;
+        if (cache.read(lsn * BENCH_SECTOR, sector, BENCH_SECTOR))
+        {
+            memset(sector, 0, sizeof(sector));
+            rc = 0xF4;
+        }
+        port.write(sector, BENCH_SECTOR);
+
+        uint16_t c1 = read() << 8;
+        c1 |= read();
+        if (rc == 0 && c1 != checksum(sector, BENCH_SECTOR))
+            rc = 243;
+
+        port.write(&rc, 1);
+        port.flush();
+
+        if (rc == 0 && prefetch)
+            read_ahead.read_done(lsn);
+    }
+
+    // systemBus::op_write()
+    void op_write()
+    {
+        read(); // drive
+        uint32_t lsn = read() << 16;
+        lsn |= read() << 8;
+        lsn |= read();
+
+        if (port.read(sector, BENCH_SECTOR) != BENCH_SECTOR)
+        {
+            port.flush_input();
+            return;
+        }
+        read(); // checksum, not checked by op_write()
+        read();
+
+        uint8_t rc = 0;
+        if (cache.write(lsn * BENCH_SECTOR, sector, BENCH_SECTOR) || cache.flush())
+            rc = 0xF5;
+        port.write(&rc, 1);
+    }
+
+    // systemBus::service(), then taskMgr.service()
+    void run()
+    {
+        while (!stop)
+        {
+            if (port.available())
+            {
+                switch (read())
+                {
+                case OP_READEX:
+                    op_readex();
+                    break;
+                case OP_WRITE:
+                    op_write();
+                    break;
+                default:
+                    port.flush_input();
+                    break;
+                }
+            }
+            if (restart)
+            {
+                read_ahead.reset();
+                cache.flush();
+                cache.invalidate();
+                restart = false;
+            }
+            taskMgr.service();
+            if (!read_ahead.busy())
+                port.poll(1);
+        }
+    }
+};
+
+/*
+ * The emulator end
+ */
+static int coco = -1;
+
+static bool send_all(const uint8_t *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = send(coco, buf, len, 0);
+        if (n <= 0)
+            return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool recv_all(uint8_t *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = recv(coco, buf, len, 0);
+        if (n <= 0)
+            return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static size_t put_request(uint8_t *p, uint8_t op, uint32_t lsn)
+{
+    p[0] = op;
+    p[1] = 0; // drive
+    p[2] = lsn >> 16;
+    p[3] = lsn >> 8;
+    p[4] = lsn;
+    return 5;
+}
+
+// Returns true if every sector came back as written
+static bool read_image(uint32_t sectors, uint8_t pass, bool piped)
+{
+    uint8_t out[7];
+    uint8_t data[BENCH_SECTOR];
+    uint8_t rc;
+
+    if (!send_all(out, put_request(out, OP_READEX, 0)))
+        return false;
+    for (uint32_t lsn = 0; lsn < sectors; lsn++)
+    {
+        if (!recv_all(data, sizeof(data)))
+            return false;
+        for (int i = 0; i < BENCH_SECTOR; i++)
+            if (data[i] != pattern(lsn, i, pass))
+                return false;
+
+        uint16_t chk = checksum(data, sizeof(data));
+        out[0] = chk >> 8;
+        out[1] = chk;
+        bool next = lsn + 1 < sectors;
+        if (piped && next)
+        {
+            if (!send_all(out, 2 + put_request(out + 2, OP_READEX, lsn + 1)))
+                return false;
+            if (!recv_all(&rc, 1) || rc != 0)
+                return false;
+        }
+        else
+        {
+            if (!send_all(out, 2) || !recv_all(&rc, 1) || rc != 0)
+                return false;
+            if (next && !send_all(out, put_request(out, OP_READEX, lsn + 1)))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool write_image(uint32_t sectors, uint8_t pass)
+{
+    uint8_t out[5 + BENCH_SECTOR + 2];
+    uint8_t rc;
+
+    for (uint32_t lsn = 0; lsn < sectors; lsn++)
+    {
+        put_request(out, OP_WRITE, lsn);
+        for (int i = 0; i < BENCH_SECTOR; i++)
+            out[5 + i] = pattern(lsn, i, pass);
+        uint16_t chk = checksum(out + 5, BENCH_SECTOR);
+        out[5 + BENCH_SECTOR] = chk >> 8;
+        out[5 + BENCH_SECTOR + 1] = chk;
+        if (!send_all(out, sizeof(out)) || !recv_all(&rc, 1) || rc != 0)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t sectors = 4096;
+    int runs = 3;
+    int port = 65510;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:r:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            sectors = atol(optarg);
+            break;
+        case 'r':
+            runs = atoi(optarg);
+            break;
+        case 'p':
+            port = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: drivewire-becker-bench [-s sectors] [-r runs] [-p port]\n");
+            return 2;
+        }
+    }
+    if (sectors < 1 || sectors > 0x1000000 || runs < 1)
+    {
+        fprintf(stderr, "sectors must be 1 to 16M (24 bit LSN), runs 1 or more\n");
+        return 2;
+    }
+
+    // the image, filled in by the first write pass
+    bench_fujinet fujinet;
+    fujinet.image = tmpfile();
+    if (fujinet.image == nullptr || fujinet.cache.attach(fujinet.image))
+    {
+        perror("image");
+        return 1;
+    }
+
+    // #FujiNet listens, the emulator connects as XRoar and MAME do
+    fujinet.port.set_host("127.0.0.1", port);
+    fujinet.port.begin(0);
+    coco = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(coco, (sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        perror("connect");
+        return 1;
+    }
+    int one = 1;
+    setsockopt(coco, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    std::thread fujinet_thread(&bench_fujinet::run, &fujinet);
+
+    const char *names[] = {"write", "read", "ahead", "piped"};
+    uint8_t pass = 0;
+    bool ok = true;
+    for (int test = 0; test < 4 && ok; test++)
+    {
+        fujinet.prefetch = (test == 2);
+        double best = 0;
+        for (int run = 0; run < runs && ok; run++)
+        {
+            // start each read run cold, so the image is read through the cache
+            fujinet.restart = true;
+            while (fujinet.restart)
+                std::this_thread::yield();
+
+            auto start = std::chrono::steady_clock::now();
+            if (test == 0)
+                ok = write_image(sectors, ++pass);
+            else
+                ok = read_image(sectors, pass, test == 3);
+            double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (sectors / s > best)
+                best = sectors / s;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "%s failed\n", names[test]);
+            break;
+        }
+        printf("%-6s %8u sectors %10.0f sectors/s %8.0f KB/s\n", names[test], sectors, best,
+               best * BENCH_SECTOR / 1024);
+    }
+
+    close(coco);
+    fujinet.stop = true;
+    fujinet_thread.join();
+    fujinet.port.end();
+    return ok ? 0 : 1;
+}
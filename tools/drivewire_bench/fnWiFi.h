@@ -0,0 +1,13 @@
+// The bench runs over loopback, which is always up
+#ifndef FNWIFI_H
+#define FNWIFI_H
+
+class WiFiManager
+{
+public:
+    bool connected() { return true; }
+};
+
+inline WiFiManager fnWiFi;
+
+#endif // FNWIFI_H
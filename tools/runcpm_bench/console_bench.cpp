@@ -0,0 +1,141 @@
+/*
+ * RunCPM console benchmark
+ *
+ * Drives the console layer the #FujiNet abstractions share (console_buffer.h)
+ * over a pipe standing in for the link, on the host:
+ *
+ *   output  writes text the way a CP/M program does, one character at a
+ *           time, and reports link writes and characters a second, first a
+ *           write per character as before, then through the buffer
+ *   idle    polls console status with nothing typed for a second, as a
+ *           program waiting for a key does, and reports the CPU time used,
+ *           spinning on the link as before, then through the buffer
+ *
+ *   runcpm-console-bench [-n chars]
+ */
+
+#include <chrono>
+#include <thread>
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "globals.h"
+
+static uint64_t bench_millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+#define CONBUF_MILLIS() bench_millis()
+
+static int link_out[2]; // CP/M output, drained by a reader thread
+static int link_in[2];  // keyboard, nothing is ever typed
+static uint64_t link_writes = 0;
+
+void _con_send(uint8 *buf, uint16 len)
+{
+    link_writes++;
+    if (write(link_out[1], buf, len) != len)
+        exit(1);
+}
+
+int _con_receive(uint32 ms)
+{
+    struct pollfd pfd = {link_in[0], POLLIN, 0};
+    if (poll(&pfd, 1, ms) == 1)
+    {
+        uint8 ch;
+        if (read(link_in[0], &ch, 1) == 1)
+            return ch;
+    }
+    return -1;
+}
+
+#include "console_buffer.h"
+
+// The link as the abstraction used it before the buffer
+static void unbuffered_putch(uint8 ch)
+{
+    _con_send(&ch, 1);
+}
+
+static int unbuffered_kbhit()
+{
+    struct pollfd pfd = {link_in[0], POLLIN, 0};
+    return poll(&pfd, 1, 0) == 1;
+}
+
+// A line of a directory listing, as the CCP's DIR prints
+static const char line[] = "A: SIEVE    COM : CRC      COM : MOVE     COM : ZEXDOC   COM\r\n";
+
+static void output(const char *name, void (*put)(uint8), long chars)
+{
+    link_writes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < chars; i++)
+        put(line[i % (sizeof(line) - 1)]);
+    _conbuf_flush();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("output %-10s %10ld chars %10llu writes %12.0f chars/s\n", name, chars,
+           (unsigned long long)link_writes, chars / s);
+}
+
+static double cpu_seconds()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static void idle(const char *name, int (*hit)())
+{
+    long polls = 0;
+    double cpu = cpu_seconds();
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        hit();
+        polls++;
+    }
+    printf("idle   %-10s %10ld polls %9.0f%% CPU\n", name, polls, (cpu_seconds() - cpu) * 100);
+}
+
+int main(int argc, char **argv)
+{
+    long chars = 1000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        if (opt != 'n')
+        {
+            fprintf(stderr, "usage: runcpm-console-bench [-n chars]\n");
+            return 2;
+        }
+        chars = atol(optarg);
+    }
+
+    if (pipe(link_out) != 0 || pipe(link_in) != 0)
+    {
+        perror("pipe");
+        return 1;
+    }
+    std::thread reader([] {
+        uint8 buf[4096];
+        while (read(link_out[0], buf, sizeof(buf)) > 0)
+            ;
+    });
+
+    output("unbuffered", unbuffered_putch, chars);
+    output("buffered", _putch, chars);
+    idle("unbuffered", unbuffered_kbhit);
+    idle("buffered", _kbhit);
+
+    close(link_out[1]);
+    reader.join();
+    return 0;
+}
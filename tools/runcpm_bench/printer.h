@@ -0,0 +1 @@
+// cpm.h includes printer.h for the device builds; the bench prints nowhere
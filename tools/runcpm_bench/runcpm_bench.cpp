@@ -0,0 +1,648 @@
+/*
+ * RunCPM Z80 benchmark
+ *
+ * Runs CP/M programs through the same RunCPM headers the CP/M devices use,
+ * on the host with the posix abstraction, and reports how long they took and
+ * how many Z80 instructions they ran.
+ *
+ *   runcpm-bench [-r runs] [-q]                 built-in workloads
+ *   runcpm-bench [-r runs] [-q] -d dir cmd...   commands on an A/0/... disk tree
+ *
+ * Each cmd is a CCP command line, '|' separating lines typed after it, e.g.
+ *   runcpm-bench -d ~/cpm "ZEXDOC" "TURBO|Y|R"
+ * ZEXDOC/ZEXALL, Turbo Pascal and the like aren't shipped, copy them into the
+ * disk tree. With -r the best of the runs is kept; -q throws away what the
+ * program prints.
+ *
+ * Build with the runcpm-bench target (computed goto dispatch) or
+ * runcpm-bench-switch (Z80_SWITCH) to compare them.
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "globals.h"
+#include "abstraction_posix.h"
+#include "ram.h"
+#include "console.h"
+#include "cpu.h"
+#include "disk.h"
+#include "host.h"
+#include "cpm.h"
+#include "ccp.h"
+
+#ifndef Z80_COUNT
+#error Build the bench with Z80_COUNT defined
+#endif
+
+/*
+ * Built-in workloads. Each prints its result in hex and returns to the CCP.
+ *
+ * SIEVE: the BYTE sieve of 8191 flags at FLAGS (8000h), SIEVE_RUNS (100) times,
+ *        prints the count of primes: 076B
+ * CRC:   CRC-16/ARC of DATALEN (4000h) bytes at DATA (8000h), CRC_RUNS (40)
+ *        times, a bit at a time, prints 160B
+ * MOVE:  LDIR, LDDR and CPIR over DATALEN (2000h) bytes at DATA (8000h) and
+ *        COPY (A000h), MOVE_RUNS (200) times, prints 00A6
+ * FILES: writes RECORDS (512) records to TEST.DAT, reads them back summing
+ *        the bytes and deletes it, FILE_RUNS (8) times, prints the sum: 8000
+ * DIRS:  makes NFILES (32) empty files F01.TMP..F20.TMP, counts the whole
+ *        drive with search first/next SEARCH_RUNS (100) times and deletes
+ *        them, prints the count with the five .COM files: 0E74
+ */
+static const uint8 sieve_com[] = {
+	0x06, 0x64,             // 0100         ld b,SIEVE_RUNS
+	0xc5,                   // 0102 loop:   push bc
+	0x21, 0x00, 0x80,       // 0103         ld hl,FLAGS
+	0x36, 0x01,             // 0106         ld (hl),1
+	0x11, 0x01, 0x80,       // 0108         ld de,FLAGS+1
+	0x01, 0xfe, 0x1f,       // 010B         ld bc,8190
+	0xed, 0xb0,             // 010E         ldir
+	0xdd, 0x21, 0x00, 0x80, // 0110         ld ix,FLAGS
+	0x21, 0x00, 0x00,       // 0114         ld hl,0
+	0x22, 0x8c, 0x01,       // 0117         ld (count),hl
+	0x11, 0x00, 0x00,       // 011A         ld de,0
+	0xdd, 0x7e, 0x00,       // 011D sl:     ld a,(ix+0)
+	0xb7,                   // 0120         or a
+	0x28, 0x25,             // 0121         jr z,next
+	0xd5,                   // 0123         push de
+	0x62,                   // 0124         ld h,d
+	0x6b,                   // 0125         ld l,e
+	0x29,                   // 0126         add hl,hl
+	0x23,                   // 0127         inc hl
+	0x23,                   // 0128         inc hl
+	0x23,                   // 0129         inc hl
+	0x44,                   // 012A         ld b,h
+	0x4d,                   // 012B         ld c,l
+	0x19,                   // 012C         add hl,de
+	0xe5,                   // 012D km:     push hl
+	0x11, 0x01, 0xe0,       // 012E         ld de,0e001h
+	0x19,                   // 0131         add hl,de
+	0xe1,                   // 0132         pop hl
+	0x38, 0x0b,             // 0133         jr c,kdone
+	0xe5,                   // 0135         push hl
+	0x11, 0x00, 0x80,       // 0136         ld de,FLAGS
+	0x19,                   // 0139         add hl,de
+	0x36, 0x00,             // 013A         ld (hl),0
+	0xe1,                   // 013C         pop hl
+	0x09,                   // 013D         add hl,bc
+	0x18, 0xed,             // 013E         jr km
+	0x2a, 0x8c, 0x01,       // 0140 kdone:  ld hl,(count)
+	0x23,                   // 0143         inc hl
+	0x22, 0x8c, 0x01,       // 0144         ld (count),hl
+	0xd1,                   // 0147         pop de
+	0xdd, 0x23,             // 0148 next:   inc ix
+	0x13,                   // 014A         inc de
+	0x7a,                   // 014B         ld a,d
+	0xfe, 0x1f,             // 014C         cp 1fh
+	0x20, 0xcd,             // 014E         jr nz,sl
+	0x7b,                   // 0150         ld a,e
+	0xfe, 0xff,             // 0151         cp 0ffh
+	0x20, 0xc8,             // 0153         jr nz,sl
+	0xc1,                   // 0155         pop bc
+	0x10, 0xaa,             // 0156         djnz loop
+	0x2a, 0x8c, 0x01,       // 0158         ld hl,(count)
+	0xcd, 0x61, 0x01,       // 015B         call phl
+	0xc3, 0x00, 0x00,       // 015E         jp 0
+	0x7c,                   // 0161 phl:    ld a,h
+	0xcd, 0x78, 0x01,       // 0162         call phex
+	0x7d,                   // 0165         ld a,l
+	0xcd, 0x78, 0x01,       // 0166         call phex
+	0x1e, 0x0d,             // 0169         ld e,13
+	0xcd, 0x70, 0x01,       // 016B         call pchar
+	0x1e, 0x0a,             // 016E         ld e,10
+	0x0e, 0x02,             // 0170 pchar:  ld c,2
+	0xe5,                   // 0172         push hl
+	0xcd, 0x05, 0x00,       // 0173         call 5
+	0xe1,                   // 0176         pop hl
+	0xc9,                   // 0177         ret
+	0xf5,                   // 0178 phex:   push af
+	0x0f,                   // 0179         rrca
+	0x0f,                   // 017A         rrca
+	0x0f,                   // 017B         rrca
+	0x0f,                   // 017C         rrca
+	0xcd, 0x81, 0x01,       // 017D         call pnib
+	0xf1,                   // 0180         pop af
+	0xe6, 0x0f,             // 0181 pnib:   and 0fh
+	0xc6, 0x90,             // 0183         add a,90h
+	0x27,                   // 0185         daa
+	0xce, 0x40,             // 0186         adc a,40h
+	0x27,                   // 0188         daa
+	0x5f,                   // 0189         ld e,a
+	0x18, 0xe4,             // 018A         jr pchar
+	0x00, 0x00,             // 018C count:  db 0,0
+};
+static const uint8 crc_com[] = {
+	0x21, 0x00, 0x80,       // 0100         ld hl,DATA
+	0x7d,                   // 0103 fill:   ld a,l
+	0xac,                   // 0104         xor h
+	0x77,                   // 0105         ld (hl),a
+	0x23,                   // 0106         inc hl
+	0x7c,                   // 0107         ld a,h
+	0xfe, 0xc0,             // 0108         cp DATAEND
+	0x20, 0xf7,             // 010A         jr nz,fill
+	0x06, 0x28,             // 010C         ld b,CRC_RUNS
+	0xc5,                   // 010E cl:     push bc
+	0x21, 0x00, 0x00,       // 010F         ld hl,0
+	0x11, 0x00, 0x80,       // 0112         ld de,DATA
+	0x01, 0x00, 0x40,       // 0115         ld bc,DATALEN
+	0x1a,                   // 0118 byte:   ld a,(de)
+	0xad,                   // 0119         xor l
+	0x6f,                   // 011A         ld l,a
+	0xc5,                   // 011B         push bc
+	0x06, 0x08,             // 011C         ld b,8
+	0xcb, 0x3c,             // 011E bit:    srl h
+	0xcb, 0x1d,             // 0120         rr l
+	0x30, 0x08,             // 0122         jr nc,nox
+	0x7c,                   // 0124         ld a,h
+	0xee, 0xa0,             // 0125         xor 0a0h
+	0x67,                   // 0127         ld h,a
+	0x7d,                   // 0128         ld a,l
+	0xee, 0x01,             // 0129         xor 1
+	0x6f,                   // 012B         ld l,a
+	0x10, 0xf0,             // 012C nox:    djnz bit
+	0xc1,                   // 012E         pop bc
+	0x13,                   // 012F         inc de
+	0x0b,                   // 0130         dec bc
+	0x78,                   // 0131         ld a,b
+	0xb1,                   // 0132         or c
+	0x20, 0xe3,             // 0133         jr nz,byte
+	0xc1,                   // 0135         pop bc
+	0x10, 0xd6,             // 0136         djnz cl
+	0xcd, 0x3e, 0x01,       // 0138         call phl
+	0xc3, 0x00, 0x00,       // 013B         jp 0
+	0x7c,                   // 013E phl:    ld a,h
+	0xcd, 0x55, 0x01,       // 013F         call phex
+	0x7d,                   // 0142         ld a,l
+	0xcd, 0x55, 0x01,       // 0143         call phex
+	0x1e, 0x0d,             // 0146         ld e,13
+	0xcd, 0x4d, 0x01,       // 0148         call pchar
+	0x1e, 0x0a,             // 014B         ld e,10
+	0x0e, 0x02,             // 014D pchar:  ld c,2
+	0xe5,                   // 014F         push hl
+	0xcd, 0x05, 0x00,       // 0150         call 5
+	0xe1,                   // 0153         pop hl
+	0xc9,                   // 0154         ret
+	0xf5,                   // 0155 phex:   push af
+	0x0f,                   // 0156         rrca
+	0x0f,                   // 0157         rrca
+	0x0f,                   // 0158         rrca
+	0x0f,                   // 0159         rrca
+	0xcd, 0x5e, 0x01,       // 015A         call pnib
+	0xf1,                   // 015D         pop af
+	0xe6, 0x0f,             // 015E pnib:   and 0fh
+	0xc6, 0x90,             // 0160         add a,90h
+	0x27,                   // 0162         daa
+	0xce, 0x40,             // 0163         adc a,40h
+	0x27,                   // 0165         daa
+	0x5f,                   // 0166         ld e,a
+	0x18, 0xe4,             // 0167         jr pchar
+};
+static const uint8 move_com[] = {
+	0x21, 0x00, 0x80,       // 0100         ld hl,DATA
+	0x7d,                   // 0103 fill:   ld a,l
+	0xac,                   // 0104         xor h
+	0x77,                   // 0105         ld (hl),a
+	0x23,                   // 0106         inc hl
+	0x7c,                   // 0107         ld a,h
+	0xfe, 0xa0,             // 0108         cp DATAEND
+	0x20, 0xf7,             // 010A         jr nz,fill
+	0x06, 0xc8,             // 010C         ld b,MOVE_RUNS
+	0xc5,                   // 010E ml:     push bc
+	0x21, 0x00, 0x80,       // 010F         ld hl,DATA
+	0x11, 0x00, 0xa0,       // 0112         ld de,COPY
+	0x01, 0x00, 0x20,       // 0115         ld bc,DATALEN
+	0xed, 0xb0,             // 0118         ldir
+	0x21, 0xff, 0xbf,       // 011A         ld hl,COPY+DATALEN-1
+	0x11, 0xff, 0x9f,       // 011D         ld de,DATA+DATALEN-1
+	0x01, 0x00, 0x20,       // 0120         ld bc,DATALEN
+	0xed, 0xb8,             // 0123         lddr
+	0x21, 0x00, 0x80,       // 0125         ld hl,DATA
+	0x01, 0x00, 0x20,       // 0128         ld bc,DATALEN
+	0x3e, 0xff,             // 012B         ld a,0ffh
+	0xed, 0xb1,             // 012D         cpir
+	0xc1,                   // 012F         pop bc
+	0x10, 0xdc,             // 0130         djnz ml
+	0x3a, 0x34, 0xb2,       // 0132         ld a,(COPY+1234h)
+	0x6f,                   // 0135         ld l,a
+	0x26, 0x00,             // 0136         ld h,0
+	0xcd, 0x3e, 0x01,       // 0138         call phl
+	0xc3, 0x00, 0x00,       // 013B         jp 0
+	0x7c,                   // 013E phl:    ld a,h
+	0xcd, 0x55, 0x01,       // 013F         call phex
+	0x7d,                   // 0142         ld a,l
+	0xcd, 0x55, 0x01,       // 0143         call phex
+	0x1e, 0x0d,             // 0146         ld e,13
+	0xcd, 0x4d, 0x01,       // 0148         call pchar
+	0x1e, 0x0a,             // 014B         ld e,10
+	0x0e, 0x02,             // 014D pchar:  ld c,2
+	0xe5,                   // 014F         push hl
+	0xcd, 0x05, 0x00,       // 0150         call 5
+	0xe1,                   // 0153         pop hl
+	0xc9,                   // 0154         ret
+	0xf5,                   // 0155 phex:   push af
+	0x0f,                   // 0156         rrca
+	0x0f,                   // 0157         rrca
+	0x0f,                   // 0158         rrca
+	0x0f,                   // 0159         rrca
+	0xcd, 0x5e, 0x01,       // 015A         call pnib
+	0xf1,                   // 015D         pop af
+	0xe6, 0x0f,             // 015E pnib:   and 0fh
+	0xc6, 0x90,             // 0160         add a,90h
+	0x27,                   // 0162         daa
+	0xce, 0x40,             // 0163         adc a,40h
+	0x27,                   // 0165         daa
+	0x5f,                   // 0166         ld e,a
+	0x18, 0xe4,             // 0167         jr pchar
+};
+
+static const uint8 files_com[] = {
+	0x06, 0x08,             // 0100         ld b,FILE_RUNS
+	0xc5,                   // 0102 run:    push bc
+	0xcd, 0x8a, 0x01,       // 0103         call clrfcb
+	0x0e, 0x16,             // 0106         ld c,22
+	0x11, 0xc2, 0x01,       // 0108         ld de,fcb
+	0xcd, 0x05, 0x00,       // 010B         call 5
+	0x0e, 0x1a,             // 010E         ld c,26
+	0x11, 0x00, 0x80,       // 0110         ld de,DMA
+	0xcd, 0x05, 0x00,       // 0113         call 5
+	0x21, 0x00, 0x02,       // 0116         ld hl,RECORDS
+	0xe5,                   // 0119 wl:     push hl
+	0x7d,                   // 011A         ld a,l
+	0x21, 0x00, 0x80,       // 011B         ld hl,DMA
+	0x06, 0x80,             // 011E         ld b,128
+	0x77,                   // 0120 fl:     ld (hl),a
+	0x23,                   // 0121         inc hl
+	0x3c,                   // 0122         inc a
+	0x10, 0xfb,             // 0123         djnz fl
+	0x0e, 0x15,             // 0125         ld c,21
+	0x11, 0xc2, 0x01,       // 0127         ld de,fcb
+	0xcd, 0x05, 0x00,       // 012A         call 5
+	0xe1,                   // 012D         pop hl
+	0x2b,                   // 012E         dec hl
+	0x7c,                   // 012F         ld a,h
+	0xb5,                   // 0130         or l
+	0x20, 0xe6,             // 0131         jr nz,wl
+	0x0e, 0x10,             // 0133         ld c,16
+	0x11, 0xc2, 0x01,       // 0135         ld de,fcb
+	0xcd, 0x05, 0x00,       // 0138         call 5
+	0xcd, 0x8a, 0x01,       // 013B         call clrfcb
+	0x0e, 0x0f,             // 013E         ld c,15
+	0x11, 0xc2, 0x01,       // 0140         ld de,fcb
+	0xcd, 0x05, 0x00,       // 0143         call 5
+	0x21, 0x00, 0x00,       // 0146         ld hl,0
+	0x22, 0xc0, 0x01,       // 0149         ld (sum),hl
+	0x0e, 0x14,             // 014C rl:     ld c,20
+	0x11, 0xc2, 0x01,       // 014E         ld de,fcb
+	0xcd, 0x05, 0x00,       // 0151         call 5
+	0xb7,                   // 0154         or a
+	0x20, 0x17,             // 0155         jr nz,rdone
+	0x2a, 0xc0, 0x01,       // 0157         ld hl,(sum)
+	0x11, 0x00, 0x80,       // 015A         ld de,DMA
+	0x06, 0x80,             // 015D         ld b,128
+	0x1a,                   // 015F sl:     ld a,(de)
+	0x85,                   // 0160         add a,l
+	0x6f,                   // 0161         ld l,a
+	0x7c,                   // 0162         ld a,h
+	0xce, 0x00,             // 0163         adc a,0
+	0x67,                   // 0165         ld h,a
+	0x13,                   // 0166         inc de
+	0x10, 0xf6,             // 0167         djnz sl
+	0x22, 0xc0, 0x01,       // 0169         ld (sum),hl
+	0x18, 0xde,             // 016C         jr rl
+	0x0e, 0x10,             // 016E rdone:  ld c,16
+	0x11, 0xc2, 0x01,       // 0170         ld de,fcb
+	0xcd, 0x05, 0x00,       // 0173         call 5
+	0x0e, 0x13,             // 0176         ld c,19
+	0x11, 0xc2, 0x01,       // 0178         ld de,fcb
+	0xcd, 0x05, 0x00,       // 017B         call 5
+	0xc1,                   // 017E         pop bc
+	0x10, 0x81,             // 017F         djnz run
+	0x2a, 0xc0, 0x01,       // 0181         ld hl,(sum)
+	0xcd, 0x95, 0x01,       // 0184         call phl
+	0xc3, 0x00, 0x00,       // 0187         jp 0
+	0x21, 0xce, 0x01,       // 018A clrfcb: ld hl,fcb+12
+	0x06, 0x18,             // 018D         ld b,24
+	0x36, 0x00,             // 018F cz:     ld (hl),0
+	0x23,                   // 0191         inc hl
+	0x10, 0xfb,             // 0192         djnz cz
+	0xc9,                   // 0194         ret
+	0x7c,                   // 0195 phl:    ld a,h
+	0xcd, 0xac, 0x01,       // 0196         call phex
+	0x7d,                   // 0199         ld a,l
+	0xcd, 0xac, 0x01,       // 019A         call phex
+	0x1e, 0x0d,             // 019D         ld e,13
+	0xcd, 0xa4, 0x01,       // 019F         call pchar
+	0x1e, 0x0a,             // 01A2         ld e,10
+	0x0e, 0x02,             // 01A4 pchar:  ld c,2
+	0xe5,                   // 01A6         push hl
+	0xcd, 0x05, 0x00,       // 01A7         call 5
+	0xe1,                   // 01AA         pop hl
+	0xc9,                   // 01AB         ret
+	0xf5,                   // 01AC phex:   push af
+	0x0f,                   // 01AD         rrca
+	0x0f,                   // 01AE         rrca
+	0x0f,                   // 01AF         rrca
+	0x0f,                   // 01B0         rrca
+	0xcd, 0xb5, 0x01,       // 01B1         call pnib
+	0xf1,                   // 01B4         pop af
+	0xe6, 0x0f,             // 01B5 pnib:   and 0fh
+	0xc6, 0x90,             // 01B7         add a,90h
+	0x27,                   // 01B9         daa
+	0xce, 0x40,             // 01BA         adc a,40h
+	0x27,                   // 01BC         daa
+	0x5f,                   // 01BD         ld e,a
+	0x18, 0xe4,             // 01BE         jr pchar
+	0x00, 0x00,             // 01C0 sum:    db 0,0
+	0x00, 0x54, 0x45, 0x53, 0x54, 0x20, 0x20, 0x20, 0x20, 0x44, 0x41, 0x54,// 01C2 fcb:    db 0,84,69,83,84,32,32,32,32,68,65,84
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,// 01CE         db 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+static const uint8 dirs_com[] = {
+	0x06, 0x20,             // 0100         ld b,NFILES
+	0xc5,                   // 0102 mk:     push bc
+	0x78,                   // 0103         ld a,b
+	0xcd, 0x58, 0x01,       // 0104         call setnam
+	0x21, 0xad, 0x01,       // 0107         ld hl,fcb+12
+	0x06, 0x18,             // 010A         ld b,24
+	0x36, 0x00,             // 010C cz:     ld (hl),0
+	0x23,                   // 010E         inc hl
+	0x10, 0xfb,             // 010F         djnz cz
+	0x0e, 0x16,             // 0111         ld c,22
+	0x11, 0xa1, 0x01,       // 0113         ld de,fcb
+	0xcd, 0x05, 0x00,       // 0116         call 5
+	0x0e, 0x10,             // 0119         ld c,16
+	0x11, 0xa1, 0x01,       // 011B         ld de,fcb
+	0xcd, 0x05, 0x00,       // 011E         call 5
+	0xc1,                   // 0121         pop bc
+	0x10, 0xde,             // 0122         djnz mk
+	0x06, 0x64,             // 0124         ld b,SEARCH_RUNS
+	0xc5,                   // 0126 sr:     push bc
+	0x0e, 0x11,             // 0127         ld c,17
+	0x11, 0xc5, 0x01,       // 0129         ld de,wild
+	0xcd, 0x05, 0x00,       // 012C         call 5
+	0xfe, 0xff,             // 012F sn:     cp 0ffh
+	0x28, 0x11,             // 0131         jr z,sdone
+	0x2a, 0x9f, 0x01,       // 0133         ld hl,(count)
+	0x23,                   // 0136         inc hl
+	0x22, 0x9f, 0x01,       // 0137         ld (count),hl
+	0x0e, 0x12,             // 013A         ld c,18
+	0x11, 0xc5, 0x01,       // 013C         ld de,wild
+	0xcd, 0x05, 0x00,       // 013F         call 5
+	0x18, 0xeb,             // 0142         jr sn
+	0xc1,                   // 0144 sdone:  pop bc
+	0x10, 0xdf,             // 0145         djnz sr
+	0x0e, 0x13,             // 0147         ld c,19
+	0x11, 0xe9, 0x01,       // 0149         ld de,delfcb
+	0xcd, 0x05, 0x00,       // 014C         call 5
+	0x2a, 0x9f, 0x01,       // 014F         ld hl,(count)
+	0xcd, 0x74, 0x01,       // 0152         call phl
+	0xc3, 0x00, 0x00,       // 0155         jp 0
+	0xf5,                   // 0158 setnam: push af
+	0x0f,                   // 0159         rrca
+	0x0f,                   // 015A         rrca
+	0x0f,                   // 015B         rrca
+	0x0f,                   // 015C         rrca
+	0xcd, 0x6b, 0x01,       // 015D         call hexc
+	0x32, 0xa3, 0x01,       // 0160         ld (fcb+2),a
+	0xf1,                   // 0163         pop af
+	0xcd, 0x6b, 0x01,       // 0164         call hexc
+	0x32, 0xa4, 0x01,       // 0167         ld (fcb+3),a
+	0xc9,                   // 016A         ret
+	0xe6, 0x0f,             // 016B hexc:   and 0fh
+	0xc6, 0x90,             // 016D         add a,90h
+	0x27,                   // 016F         daa
+	0xce, 0x40,             // 0170         adc a,40h
+	0x27,                   // 0172         daa
+	0xc9,                   // 0173         ret
+	0x7c,                   // 0174 phl:    ld a,h
+	0xcd, 0x8b, 0x01,       // 0175         call phex
+	0x7d,                   // 0178         ld a,l
+	0xcd, 0x8b, 0x01,       // 0179         call phex
+	0x1e, 0x0d,             // 017C         ld e,13
+	0xcd, 0x83, 0x01,       // 017E         call pchar
+	0x1e, 0x0a,             // 0181         ld e,10
+	0x0e, 0x02,             // 0183 pchar:  ld c,2
+	0xe5,                   // 0185         push hl
+	0xcd, 0x05, 0x00,       // 0186         call 5
+	0xe1,                   // 0189         pop hl
+	0xc9,                   // 018A         ret
+	0xf5,                   // 018B phex:   push af
+	0x0f,                   // 018C         rrca
+	0x0f,                   // 018D         rrca
+	0x0f,                   // 018E         rrca
+	0x0f,                   // 018F         rrca
+	0xcd, 0x94, 0x01,       // 0190         call pnib
+	0xf1,                   // 0193         pop af
+	0xe6, 0x0f,             // 0194 pnib:   and 0fh
+	0xc6, 0x90,             // 0196         add a,90h
+	0x27,                   // 0198         daa
+	0xce, 0x40,             // 0199         adc a,40h
+	0x27,                   // 019B         daa
+	0x5f,                   // 019C         ld e,a
+	0x18, 0xe4,             // 019D         jr pchar
+	0x00, 0x00,             // 019F count:  db 0,0
+	0x00, 0x46, 0x30, 0x30, 0x20, 0x20, 0x20, 0x20, 0x20, 0x54, 0x4d, 0x50,// 01A1 fcb:    db 0,70,48,48,32,32,32,32,32,84,77,80
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,// 01AD         db 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+	0x00, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,// 01C5 wild:   db 0,63,63,63,63,63,63,63,63,63,63,63
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,// 01D1         db 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+	0x00, 0x46, 0x3f, 0x3f, 0x20, 0x20, 0x20, 0x20, 0x20, 0x54, 0x4d, 0x50,// 01E9 delfcb: db 0,70,63,63,32,32,32,32,32,84,77,80
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,// 01F5         db 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+
+struct workload
+{
+    const char *name;
+    const uint8 *code;
+    size_t size;
+};
+
+static const workload builtin[] = {
+    {"SIEVE", sieve_com, sizeof(sieve_com)},
+    {"CRC", crc_com, sizeof(crc_com)},
+    {"MOVE", move_com, sizeof(move_com)},
+    {"FILES", files_com, sizeof(files_com)},
+    {"DIRS", dirs_com, sizeof(dirs_com)},
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: runcpm-bench [-r runs] [-q] [-d dir cmd...]\n");
+    exit(2);
+}
+
+// Types the command, then EXIT so the CCP hands back once it's done
+static bool feed_console(const std::string &cmd)
+{
+    char path[] = "/tmp/runcpm-bench-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return true;
+    std::string script;
+    for (char c : cmd)
+        script += (c == '|') ? '\r' : c;
+    script += "\rEXIT\r";
+    bool err = write(fd, script.data(), script.size()) != (ssize_t)script.size();
+    close(fd);
+    err = err || freopen(path, "r", stdin) == nullptr;
+    unlink(path);
+    return err;
+}
+
+// Returns TRUE if an error condition occurred
+static bool run_command(const std::string &cmd, double &ms, uint64_t &count)
+{
+    if (feed_console(cmd))
+        return true;
+
+    uint64_t start_count = Z80instructions;
+    auto start = std::chrono::steady_clock::now();
+
+    Status = 0;
+    while (Status != 1)
+    {
+        _puts(CCPHEAD);
+        _PatchCPM();
+        Status = 0;
+        _ccp();
+    }
+
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    count = Z80instructions - start_count;
+    return false;
+}
+
+static std::string make_scratch_disk()
+{
+    char dir[] = "/tmp/runcpm-bench-disk-XXXXXX";
+    if (mkdtemp(dir) == nullptr)
+        return "";
+    std::string path = std::string(dir) + "/A";
+    mkdir(path.c_str(), 0755);
+    path += "/0";
+    mkdir(path.c_str(), 0755);
+    for (const workload &w : builtin)
+    {
+        FILE *f = fopen((path + "/" + w.name + ".COM").c_str(), "wb");
+        if (f == nullptr)
+            return "";
+        fwrite(w.code, 1, w.size, f);
+        fclose(f);
+    }
+    return dir;
+}
+
+static void remove_scratch_disk(const std::string &dir)
+{
+    for (const workload &w : builtin)
+        unlink((dir + "/A/0/" + w.name + ".COM").c_str());
+    rmdir((dir + "/A/0").c_str());
+    rmdir((dir + "/A").c_str());
+    rmdir(dir.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 1;
+    bool quiet = false;
+    const char *dir = nullptr;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:qd:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            runs = atoi(optarg);
+            break;
+        case 'q':
+            quiet = true;
+            break;
+        case 'd':
+            dir = optarg;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (runs < 1 || (dir == nullptr) != (optind == argc))
+        usage();
+
+    std::vector<std::string> commands;
+    std::string scratch;
+    if (dir == nullptr)
+    {
+        scratch = make_scratch_disk();
+        if (scratch.empty())
+        {
+            perror("scratch disk");
+            return 1;
+        }
+        dir = scratch.c_str();
+        for (const workload &w : builtin)
+            commands.push_back(w.name);
+    }
+    else
+    {
+        for (int i = optind; i < argc; i++)
+            commands.push_back(argv[i]);
+    }
+
+    if (chdir(dir) != 0)
+    {
+        perror(dir);
+        return 1;
+    }
+    if (quiet && freopen("/dev/null", "w", stdout) == nullptr)
+        return 1;
+
+    // as the CP/M devices set up RunCPM
+    RAM = (uint8 *)malloc(MEMSIZE);
+    memset(RAM, 0, MEMSIZE);
+    memset(filename, 0, sizeof(filename));
+    memset(newname, 0, sizeof(newname));
+    memset(fcbname, 0, sizeof(fcbname));
+    memset(pattern, 0, sizeof(pattern));
+
+#ifdef Z80_THREADED
+    fprintf(stderr, "dispatch: threaded\n");
+#else
+    fprintf(stderr, "dispatch: switch\n");
+#endif
+
+    int result = 0;
+    double total_ms = 0;
+    uint64_t total_count = 0;
+    for (const std::string &cmd : commands)
+    {
+        double best_ms = 0;
+        uint64_t best_count = 0;
+        for (int run = 0; run < runs; run++)
+        {
+            double ms;
+            uint64_t count;
+            if (run_command(cmd, ms, count))
+            {
+                fprintf(stderr, "%s: couldn't feed the console\n", cmd.c_str());
+                result = 1;
+                break;
+            }
+            if (run == 0 || ms < best_ms)
+            {
+                best_ms = ms;
+                best_count = count;
+            }
+        }
+        fflush(stdout);
+        fprintf(stderr, "%-12s %10.1f ms %14llu instructions %8.2f MIPS\n", cmd.c_str(), best_ms,
+                (unsigned long long)best_count, best_ms > 0 ? best_count / best_ms / 1000.0 : 0.0);
+        total_ms += best_ms;
+        total_count += best_count;
+    }
+    fprintf(stderr, "%-12s %10.1f ms %14llu instructions %8.2f MIPS\n", "total", total_ms,
+            (unsigned long long)total_count, total_ms > 0 ? total_count / total_ms / 1000.0 : 0.0);
+
+    free(RAM);
+    if (!scratch.empty())
+        remove_scratch_disk(scratch);
+    return result;
+}
@@ -0,0 +1,22 @@
+// What mediaCache.cpp and fnTaskManager.cpp ask of fnSystem; the bench is a board with PSRAM
+#ifndef FNSYSTEM_H
+#define FNSYSTEM_H
+
+#include <chrono>
+#include <cstdint>
+
+class SystemManager
+{
+public:
+    uint64_t millis()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+    uint32_t get_psram_size() { return 4 * 1024 * 1024; }
+};
+
+inline SystemManager fnSystem;
+
+#endif // FNSYSTEM_H
@@ -0,0 +1,431 @@
+/*
+ * SmartPort over SLIP block benchmark
+ *
+ * Runs both ends of the SLIP link on the host, over loopback TCP, with the
+ * devrelay code the PC build uses. The emulator end reads and writes every
+ * block of an image; the #FujiNet end answers from the image through
+ * MediaCache the way iwmDisk does. Reports blocks a second for:
+ *
+ *   read    ReadBlock, a block a request, as before
+ *   ahead   ReadBlock, with the blocks after a sequential read prefetched
+ *           once it has been answered, a block each pass of the bus loop
+ *   reads   ReadBlocks, -c blocks a request
+ *   writes  WriteBlocks, -c blocks a request
+ *   write   WriteBlock, a block a request
+ *
+ * and for -n ReadBlocks of one block, so the time is the link's and not the
+ * image's, requests a second and the 50th and 99th percentile round trip.
+ *
+ * The #FujiNet end polls for requests from its bus loop as iwm_slip does,
+ * taking them from the connection's ring, or with -q as iwm_slip used to,
+ * from a locked queue a thread fills from Connection::wait_for_request().
+ *
+ *   smartport-slip-bench [-b blocks] [-c count] [-r runs] [-n requests] [-q]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Requestor.h"
+#include "TCPConnection.h"
+#include "ReadBlock.h"
+#include "ReadBlocks.h"
+#include "WriteBlock.h"
+#include "WriteBlocks.h"
+#include "mediaCache.h"
+#include "mediaPrefetch.h"
+#include "fnTaskManager.h"
+
+#define BENCH_BLOCK 512
+#define BENCH_PREFETCH_BLOCKS 8 // IWM_PREFETCH_BLOCKS
+#define BENCH_ERR_IOERROR 0x27  // SP_ERR_IOERROR
+
+static uint8_t pattern(uint32_t block, int i, uint8_t pass)
+{
+    return (uint8_t)(block * 7 + i + pass);
+}
+
+/*
+ * The #FujiNet end
+ */
+struct bench_device
+{
+    std::shared_ptr<TCPConnection> connection;
+    MediaCache cache;
+    FILE *image = nullptr;
+    bool prefetch = false;
+    // set by the emulator end between runs, done by the bus loop so it doesn't race it
+    std::atomic<bool> restart{false};
+    std::vector<uint8_t> buffer;
+
+    // iwmDisk's, through the same task and taskMgr
+    MediaPrefetch read_ahead{BENCH_PREFETCH_BLOCKS, [this](uint32_t block) {
+        cache.prefetch(block * BENCH_BLOCK, BENCH_BLOCK);
+    }};
+
+    void serve(const std::vector<uint8_t> &packet)
+    {
+        auto request = Request::from_packet(packet);
+        uint8_t cmd[9]; // iwm_decoded_cmd_t
+        request->create_command(cmd);
+        uint32_t block_num = cmd[4] | (cmd[5] << 8) | (cmd[6] << 16);
+        uint16_t count = 1;
+        if (cmd[0] == CMD_READ_BLOCKS || cmd[0] == CMD_WRITE_BLOCKS)
+            count = cmd[2] | (cmd[3] << 8);
+        uint8_t status = 0;
+
+        buffer.resize(count * BENCH_BLOCK);
+        switch (cmd[0])
+        {
+        case CMD_READ_BLOCK:
+        case CMD_READ_BLOCKS:
+            for (uint16_t i = 0; i < count && status == 0; i++)
+                if (cache.read((block_num + i) * BENCH_BLOCK, &buffer[i * BENCH_BLOCK], BENCH_BLOCK))
+                    status = BENCH_ERR_IOERROR;
+            connection->send_data(request->create_response(1, status, buffer.data(), status ? 0 : buffer.size())->serialize());
+            if (status == 0 && prefetch)
+                read_ahead.read_done(block_num, count);
+            break;
+        case CMD_WRITE_BLOCK:
+        case CMD_WRITE_BLOCKS:
+            if (request->payload_size() != buffer.size())
+                status = BENCH_ERR_IOERROR;
+            else
+            {
+                request->copy_payload(buffer.data());
+                if (cache.write(block_num * BENCH_BLOCK, buffer.data(), buffer.size()) || cache.flush())
+                    status = BENCH_ERR_IOERROR;
+            }
+            connection->send_data(request->create_response(1, status, nullptr, 0)->serialize());
+            break;
+        }
+    }
+
+    // iwm_slip before: a thread moves each request to a locked queue, which the bus polls
+    bool queued = false;
+    std::queue<std::vector<uint8_t>> queue;
+    std::mutex queue_mutex;
+
+    void relay()
+    {
+        while (connection->is_connected())
+        {
+            auto packet = connection->wait_for_request();
+            if (!packet.empty())
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                queue.push(packet);
+            }
+        }
+    }
+
+    // The bus loop, polling for requests as iwmBus::service() does through iwm_slip::iwm_phase_vector()
+    void run()
+    {
+        std::thread relay_thread;
+        if (queued)
+            relay_thread = std::thread(&bench_device::relay, this);
+        while (connection->is_connected())
+        {
+            if (queued)
+            {
+                std::vector<uint8_t> packet;
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex);
+                    if (!queue.empty())
+                    {
+                        packet = queue.front();
+                        queue.pop();
+                    }
+                }
+                if (packet.empty())
+                    std::this_thread::yield();
+                else
+                    serve(packet);
+            }
+            else
+            {
+                const std::vector<uint8_t> *packet = connection->peek_request();
+                if (packet == nullptr)
+                    std::this_thread::yield();
+                else
+                {
+                    serve(*packet);
+                    connection->pop_request();
+                }
+            }
+            if (restart)
+            {
+                read_ahead.reset();
+                cache.flush();
+                cache.invalidate();
+                restart = false;
+            }
+            taskMgr.service();
+        }
+        if (relay_thread.joinable())
+            relay_thread.join();
+    }
+};
+
+/*
+ * The emulator end
+ */
+static std::shared_ptr<TCPConnection> emulator;
+
+// Returns true if every block came back as written
+static bool read_image(uint32_t blocks, uint16_t count, uint8_t pass)
+{
+    for (uint32_t block = 0; block < blocks; block += count)
+    {
+        uint16_t n = blocks - block < count ? blocks - block : count;
+        std::unique_ptr<Response> response;
+        const uint8_t *data;
+        if (count == 1)
+        {
+            ReadBlockRequest request(Requestor::next_request_number(), 1, BENCH_BLOCK);
+            request.set_block_number_from_bytes(block & 0xFF, (block >> 8) & 0xFF, (block >> 16) & 0xFF);
+            response = Requestor::send_request(request, emulator.get());
+            if (response == nullptr || response->get_status() != 0)
+                return false;
+            data = static_cast<ReadBlockResponse *>(response.get())->get_block_data().data();
+        }
+        else
+        {
+            ReadBlocksRequest request(Requestor::next_request_number(), 1, n);
+            request.set_block_number_from_bytes(block & 0xFF, (block >> 8) & 0xFF, (block >> 16) & 0xFF);
+            response = Requestor::send_request(request, emulator.get());
+            if (response == nullptr || response->get_status() != 0)
+                return false;
+            data = static_cast<ReadBlocksResponse *>(response.get())->get_block_data().data();
+        }
+        for (uint16_t b = 0; b < n; b++)
+            for (int i = 0; i < BENCH_BLOCK; i++)
+                if (data[b * BENCH_BLOCK + i] != pattern(block + b, i, pass))
+                    return false;
+    }
+    return true;
+}
+
+static bool write_image(uint32_t blocks, uint16_t count, uint8_t pass)
+{
+    std::vector<uint8_t> data(count * BENCH_BLOCK);
+    for (uint32_t block = 0; block < blocks; block += count)
+    {
+        uint16_t n = blocks - block < count ? blocks - block : count;
+        for (uint16_t b = 0; b < n; b++)
+            for (int i = 0; i < BENCH_BLOCK; i++)
+                data[b * BENCH_BLOCK + i] = pattern(block + b, i, pass);
+
+        std::unique_ptr<Response> response;
+        if (count == 1)
+        {
+            WriteBlockRequest request(Requestor::next_request_number(), 1, BENCH_BLOCK);
+            request.set_block_number_from_bytes(block & 0xFF, (block >> 8) & 0xFF, (block >> 16) & 0xFF);
+            // the header is all the request takes from the pointer's first 8 bytes
+            std::vector<uint8_t> packet(8);
+            packet.insert(packet.end(), data.begin(), data.begin() + BENCH_BLOCK);
+            request.set_block_data_from_ptr(packet.data(), 8);
+            response = Requestor::send_request(request, emulator.get());
+        }
+        else
+        {
+            WriteBlocksRequest request(Requestor::next_request_number(), 1, n);
+            request.set_block_number_from_bytes(block & 0xFF, (block >> 8) & 0xFF, (block >> 16) & 0xFF);
+            request.set_block_data_from_ptr(data.data(), 0, n * BENCH_BLOCK);
+            response = Requestor::send_request(request, emulator.get());
+        }
+        if (response == nullptr || response->get_status() != 0)
+            return false;
+    }
+    return true;
+}
+
+// Round trips of n requests in microseconds, empty if one failed
+static std::vector<double> time_requests(long n)
+{
+    std::vector<double> us;
+    us.reserve(n);
+    for (long i = 0; i < n; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ReadBlockRequest request(Requestor::next_request_number(), 1, BENCH_BLOCK);
+        request.set_block_number_from_bytes(0, 0, 0);
+        auto response = Requestor::send_request(request, emulator.get());
+        if (response == nullptr || response->get_status() != 0)
+            return std::vector<double>();
+        us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    return us;
+}
+
+static std::shared_ptr<TCPConnection> open_connection(int sock)
+{
+    auto connection = std::make_shared<TCPConnection>(sock);
+    connection->set_is_connected(true);
+    connection->create_read_channel();
+    return connection;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t blocks = 4096;
+    uint16_t count = 16;
+    int runs = 3;
+    long requests = 20000;
+    bool queued = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:c:r:n:q")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            blocks = atol(optarg);
+            break;
+        case 'c':
+            count = atoi(optarg);
+            break;
+        case 'r':
+            runs = atoi(optarg);
+            break;
+        case 'n':
+            requests = atol(optarg);
+            break;
+        case 'q':
+            queued = true;
+            break;
+        default:
+            fprintf(stderr, "usage: smartport-slip-bench [-b blocks] [-c count] [-r runs] [-n requests] [-q]\n");
+            return 2;
+        }
+    }
+    if (blocks < 1 || count < 2 || count > 16 || runs < 1 || requests < 1)
+    {
+        fprintf(stderr, "blocks must be 1 or more, count 2 to 16 (SP_MAX_BLOCKS), runs and requests 1 or more\n");
+        return 2;
+    }
+    // TCPConnection chatters on stdout
+    setvbuf(stdout, nullptr, _IOFBF, 1 << 16);
+
+    // the image, filled in by the first write pass
+    bench_device device;
+    device.queued = queued;
+    device.image = tmpfile();
+    if (device.image == nullptr || device.cache.attach(device.image))
+    {
+        perror("image");
+        return 1;
+    }
+
+    // the emulator listens, #FujiNet connects as connector_net does
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    if (bind(server, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, 1) != 0 ||
+        getsockname(server, (sockaddr *)&addr, &len) != 0 || connect(client, (sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        perror("loopback");
+        return 1;
+    }
+    emulator = open_connection(accept(server, nullptr, nullptr));
+    device.connection = open_connection(client);
+    std::thread device_thread(&bench_device::run, &device);
+
+    struct
+    {
+        const char *name;
+        bool write;
+        uint16_t count;
+        bool prefetch;
+    } tests[] = {
+        {"writes", true, count, false},
+        {"write", true, 1, false},
+        {"read", false, 1, false},
+        {"ahead", false, 1, true},
+        {"reads", false, count, true},
+    };
+
+    std::vector<std::pair<const char *, double>> results;
+    uint8_t pass = 0;
+    for (auto &t : tests)
+    {
+        double best = 0;
+        for (int r = 0; r < runs; r++)
+        {
+            // each write pass leaves a new pattern for the reads to check
+            if (t.write)
+                pass++;
+            device.prefetch = t.prefetch;
+            device.restart = true;
+            while (device.restart)
+                std::this_thread::yield();
+            auto start = std::chrono::steady_clock::now();
+            bool ok = t.write ? write_image(blocks, t.count, pass) : read_image(blocks, t.count, pass);
+            double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!ok)
+            {
+                fflush(stdout);
+                fprintf(stderr, "%s: wrong or failed\n", t.name);
+                return 1;
+            }
+            if (best == 0 || s < best)
+                best = s;
+        }
+        results.push_back({t.name, best});
+    }
+
+    // the best run by requests a second
+    std::vector<double> latency;
+    double latency_s = 0;
+    for (int r = 0; r < runs; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto us = time_requests(requests);
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (us.empty())
+        {
+            fflush(stdout);
+            fprintf(stderr, "latency: failed\n");
+            return 1;
+        }
+        if (latency_s == 0 || s < latency_s)
+        {
+            latency_s = s;
+            latency = us;
+        }
+    }
+    std::sort(latency.begin(), latency.end());
+
+    emulator->set_is_connected(false);
+    device.connection->set_is_connected(false);
+    device_thread.join();
+    emulator->close_connection();
+    device.connection->close_connection();
+    device.cache.detach();
+    fclose(device.image);
+
+    // only the results after the connection chatter
+    fflush(stdout);
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    for (auto &r : results)
+        printf("%-8s %8u blocks %9.1f ms %10.0f blocks/s %8.2f MB/s\n", r.first, blocks, r.second * 1000,
+               blocks / r.second, blocks * BENCH_BLOCK / r.second / (1024 * 1024));
+    printf("%-8s %8ld reqs   %9.1f ms %10.0f reqs/s %8.1f us p50 %8.1f us p99\n", "latency", requests,
+           latency_s * 1000, requests / latency_s, latency[latency.size() / 2], latency[latency.size() * 99 / 100]);
+    return 0;
+}